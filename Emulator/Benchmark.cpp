@@ -0,0 +1,391 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "Benchmark.h"
+#include "C64.h"
+#include "C64Headless.h"
+#include <iomanip>
+
+// Number of frames emulated between two calls to feed()
+static const u64 batchFrames = 10;
+
+// Location of the machine code programs
+static const u16 codeAddr = 0xC000;
+
+// Appends an INC instruction (absolute addressing)
+static void
+inc(std::vector<u8> &code, u16 addr)
+{
+    code.insert(code.end(), { 0xEE, LO_BYTE(addr), HI_BYTE(addr) });
+}
+
+// Appends an LDA instruction (absolute addressing)
+static void
+lda(std::vector<u8> &code, u16 addr)
+{
+    code.insert(code.end(), { 0xAD, LO_BYTE(addr), HI_BYTE(addr) });
+}
+
+// Appends an LDA / STA pair writing a constant into a register
+static void
+store(std::vector<u8> &code, u16 addr, u8 value)
+{
+    code.insert(code.end(), { 0xA9, value, 0x8D, LO_BYTE(addr), HI_BYTE(addr) });
+}
+
+/* Installs a program which executes an initialization fragment once and a
+ * loop fragment once per frame. The loop fragment is executed when the beam
+ * reaches the lower border. Registers are written by the program and not
+ * from the outside to keep the chips in sync with the CPU.
+ */
+static void
+installFrameLoop(C64 &c64, const std::vector<u8> &init, const std::vector<u8> &body)
+{
+    std::vector<u8> code = init;
+    u16 loop = (u16)(codeAddr + code.size());
+    
+    code.insert(code.end(), {
+        0xAD, 0x12, 0xD0,   // wait: LDA $D012
+        0xC9, 0xF8,         //       CMP #$F8
+        0xD0, 0xF9 });      //       BNE wait
+
+    code.insert(code.end(), body.begin(), body.end());
+    code.insert(code.end(), {
+        0xAD, 0x12, 0xD0,   // skip: LDA $D012
+        0xC9, 0xF8,         //       CMP #$F8
+        0xF0, 0xF9,         //       BEQ skip
+        0x4C, LO_BYTE(loop), HI_BYTE(loop) });
+
+    for (usize i = 0; i < code.size(); i++) c64.mem.poke(codeAddr + i, code[i]);
+}
+
+// Puts a command into the Kernal's keyboard buffer (10 characters max)
+static void
+type(C64 &c64, const char *text)
+{
+    u8 len = 0;
+    for (; text[len] && len < 10; len++) c64.mem.poke(0x277 + len, text[len]);
+    c64.mem.poke(0xC6, len);
+}
+
+// Synthesizes a tape with random pulses of varying length
+static TAPFile *
+makeTape()
+{
+    const usize numPulses = 400000;
+    std::vector<u8> tap(0x14);
+
+    memcpy(tap.data(), "C64-TAPE-RAW", 12);
+    tap[0x0C] = 1;
+
+    u32 seed = 0x1541;
+    for (usize i = 0; i < numPulses; i++) {
+        seed = seed * 1103515245 + 12345;
+        tap.push_back(0x30 + (seed >> 16) % 0x30);
+    }
+    u32 len = (u32)(tap.size() - 0x14);
+    for (isize i = 0; i < 4; i++) tap[0x10 + i] = (u8)(len >> (8 * i));
+
+    return AnyFile::make <TAPFile> (tap.data(), tap.size());
+}
+
+// Synthesizes an EasyFlash cartridge running a bank switching loop
+static CRTFile *
+makeEasyFlash()
+{
+    const u8 code[] = {
+        0x78,               //       SEI
+        0xA2, 0x00,         //       LDX #$00
+        0xE8,               // loop: INX
+        0x8A,               //       TXA
+        0x29, 0x07,         //       AND #$07
+        0x8D, 0x00, 0xDE,   //       STA $DE00
+        0xBD, 0x00, 0x80,   //       LDA $8000,X
+        0x9D, 0x00, 0xDF,   //       STA $DF00,X
+        0x4C, 0x03, 0xE0 }; //       JMP loop
+
+    std::vector<u8> crt(0x40);
+    memcpy(crt.data(), "C64 CARTRIDGE   ", 16);
+    W32BE(crt.data() + 0x10, 0x40);
+    W16BE(crt.data() + 0x14, 0x0100);
+    W16BE(crt.data() + 0x16, CRT_EASYFLASH);
+    crt[0x18] = 1;
+    crt[0x19] = 0;
+    memcpy(crt.data() + 0x20, "BENCHMARK", 9);
+
+    for (u16 bank = 0; bank < 8; bank++) {
+        for (u16 addr : { 0x8000, 0xA000 }) {
+
+            usize offset = crt.size();
+            crt.resize(offset + 0x2010);
+
+            u8 *chip = crt.data() + offset;
+            memcpy(chip, "CHIP", 4);
+            W32BE(chip + 0x4, 0x2010);
+            W16BE(chip + 0x8, 2);
+            W16BE(chip + 0xA, bank);
+            W16BE(chip + 0xC, addr);
+            W16BE(chip + 0xE, 0x2000);
+
+            u8 *data = chip + 0x10;
+            for (isize i = 0; i < 0x2000; i++) data[i] = (u8)(bank + i);
+
+            // Each upper bank contains the program and the CPU vectors
+            if (addr == 0xA000) {
+
+                memcpy(data, code, sizeof(code));
+                for (isize i = 0x1FFA; i < 0x2000; i += 2) {
+                    data[i] = 0x00;
+                    data[i + 1] = 0xE0;
+                }
+            }
+        }
+    }
+
+    return AnyFile::make <CRTFile> (crt.data(), crt.size());
+}
+
+Benchmark::~Benchmark()
+{
+    for (auto rom : roms) delete rom;
+}
+
+void
+Benchmark::loadRom(const string &path)
+{
+    roms.push_back(AnyFile::make <RomFile> (path));
+}
+
+void
+Benchmark::run(u64 frames)
+{
+    results.clear();
+
+    for (isize i = 0; i < BENCHMARK_COUNT; i++) {
+        results.push_back(run((BenchmarkWorkload)i, frames));
+    }
+}
+
+Benchmark::Result
+Benchmark::run(BenchmarkWorkload workload, u64 frames)
+{
+    assert_enum(BenchmarkWorkload, workload);
+
+    Result result;
+    result.workload = workload;
+
+    std::unique_ptr<C64> c64(vc64_new());
+    for (auto rom : roms) c64->installRom(rom);
+
+    ErrorCode err;
+    if (!c64->isReady(&err)) {
+
+        result.problem = string("ERROR_") + ErrorCodeEnum::key(err);
+        return result;
+    }
+
+    result.problem = setup(*c64, workload);
+    if (!result.problem.empty()) return result;
+
+    c64->powerOn();
+    vc64_run_frames(c64.get(), bootFrames);
+    start(*c64, workload);
+    vc64_run_frames(c64.get(), warmupFrames);
+
+    u64 frame = c64->frame;
+    u64 cycle = c64->cpu.cycle;
+    u64 t0 = Oscillator::nanos();
+
+    for (u64 done = 0; done < frames; done += batchFrames) {
+
+        feed(*c64, workload);
+        vc64_run_frames(c64.get(), MIN(frames - done, batchFrames));
+    }
+
+    result.seconds = (Oscillator::nanos() - t0) / 1000000000.0;
+    result.frames = c64->frame - frame;
+    result.cycles = c64->cpu.cycle - cycle;
+
+    // Break down the host time by component
+    c64->configure(OPT_PROFILER, profileInterval);
+    for (u64 done = 0; done < profileFrames; done += batchFrames) {
+
+        feed(*c64, workload);
+        vc64_run_frames(c64.get(), MIN(profileFrames - done, batchFrames));
+    }
+
+    auto stats = c64->profiler.getStats();
+    for (isize i = 0; i < PROFILE_COUNT; i++) result.share[i] = stats.share[i];
+
+    return result;
+}
+
+string
+Benchmark::setup(C64 &c64, BenchmarkWorkload workload)
+{
+    switch (workload) {
+
+        case BENCHMARK_SID:
+
+            c64.configure(OPT_SID_ENGINE, SIDENGINE_RESID);
+            c64.configure(OPT_SID_SAMPLING, SAMPLING_RESAMPLE);
+            for (long id = 1; id < 4; id++) {
+                c64.configure(OPT_SID_ADDRESS, id, 0xD400 + id * 0x20);
+                c64.configure(OPT_SID_ENABLE, id, true);
+            }
+            return "";
+
+        case BENCHMARK_DRIVES:
+
+            if (!c64.hasRom(ROM_TYPE_VC1541)) return "No VC1541 Rom";
+
+            for (long id : { DRIVE8, DRIVE9 }) {
+
+                Drive &drive = id == DRIVE8 ? c64.drive8 : c64.drive9;
+                c64.configure(OPT_DRIVE_CONNECT, id, true);
+                drive.insertNewDisk(DOS_TYPE_CBM);
+            }
+            return "";
+
+        case BENCHMARK_EASYFLASH:
+        {
+            std::unique_ptr<CRTFile> crt(makeEasyFlash());
+            if (!crt || !c64.expansionport.attachCartridge(crt.get(), false)) {
+                return "Can't attach the cartridge";
+            }
+            return "";
+        }
+        default:
+            return "";
+    }
+}
+
+void
+Benchmark::start(C64 &c64, BenchmarkWorkload workload)
+{
+    std::vector<u8> init, body;
+
+    switch (workload) {
+
+        case BENCHMARK_SPRITES:
+        {
+            // Enable all sprites in expanded multicolor mode
+            store(init, 0xD015, 0xFF);
+            store(init, 0xD017, 0xFF);
+            store(init, 0xD01B, 0xAA);
+            store(init, 0xD01C, 0xFF);
+            store(init, 0xD01D, 0xFF);
+            store(init, 0xD025, 0x02);
+            store(init, 0xD026, 0x07);
+
+            for (u16 i = 0; i < 8; i++) {
+
+                store(init, 0xD000 + 2 * i, (u8)(24 + 32 * i));
+                store(init, 0xD001 + 2 * i, (u8)(60 + 20 * i));
+                store(init, 0xD027 + i, (u8)(i + 1));
+                c64.mem.poke(0x07F8 + i, 0x0D);
+            }
+            for (u16 i = 0; i < 63; i++) {
+                c64.mem.poke(0x0340 + i, i % 3 == 0 ? 0xFF : i % 3 == 1 ? 0x55 : 0xAA);
+            }
+
+            // Move the sprites and read the collision registers once per frame
+            for (u16 i = 0; i < 8; i++) inc(body, 0xD000 + 2 * i);
+            for (u16 i = 0; i < 8; i += 2) inc(body, 0xD001 + 2 * i);
+            lda(body, 0xD01E);
+            lda(body, 0xD01F);
+
+            installFrameLoop(c64, init, body);
+            type(c64, "SYS49152\r");
+            break;
+        }
+        case BENCHMARK_SID:
+        {
+            // Play a pulse wave on all voices of all SIDs
+            for (u16 base = 0xD400; base < 0xD480; base += 0x20) {
+
+                for (u16 voice = 0; voice < 21; voice += 7) {
+
+                    store(init, base + voice + 1, (u8)(0x10 + voice));
+                    store(init, base + voice + 3, 0x08);
+                    store(init, base + voice + 5, 0x09);
+                    store(init, base + voice + 6, 0xF0);
+                    store(init, base + voice + 4, 0x41);
+                }
+                store(init, base + 0x16, 0x80);
+                store(init, base + 0x17, 0xF7);
+                store(init, base + 0x18, 0x1F);
+            }
+
+            // Sweep all frequencies and the filter cutoff once per frame
+            for (u16 base = 0xD400; base < 0xD480; base += 0x20) {
+
+                for (u16 voice = 0; voice < 21; voice += 7) inc(body, base + voice + 1);
+                inc(body, base + 0x16);
+            }
+
+            installFrameLoop(c64, init, body);
+            type(c64, "SYS49152\r");
+            break;
+        }
+        case BENCHMARK_TAPE:
+        {
+            std::unique_ptr<TAPFile> tap(makeTape());
+            c64.datasette.insertTape(tap.get());
+            c64.datasette.pressPlay();
+            type(c64, "LOAD\r");
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void
+Benchmark::feed(C64 &c64, BenchmarkWorkload workload)
+{
+    if (workload != BENCHMARK_DRIVES) return;
+
+    /* Issue a new read job as soon as the previous one has been completed.
+     * The jobs are placed in the DOS job queue (buffer 0) and iterate over
+     * all tracks and sectors.
+     */
+    for (Drive *drive : { &c64.drive8, &c64.drive9 }) {
+
+        u8 *ram = drive->mem.ram;
+        if (ram[0x00] & 0x80) continue;
+
+        ram[0x06] = ram[0x06] >= 1 && ram[0x06] < 35 ? ram[0x06] + 1 : 1;
+        ram[0x07] = (ram[0x07] + 1) % 17;
+        ram[0x00] = 0x80;
+    }
+}
+
+void
+Benchmark::writeToFile(const string &path) const
+{
+    std::ofstream out(path);
+    if (!out.is_open()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+
+    out << std::fixed;
+
+    for (auto &result : results) {
+
+        out << BenchmarkWorkloadEnum::key(result.workload) << '\t';
+        out << result.frames << '\t';
+        out << result.cycles << '\t';
+        out << std::setprecision(3) << result.seconds << '\t';
+        out << std::setprecision(3) << result.mhz() << '\t';
+        out << std::setprecision(1) << result.fps() << '\t';
+        for (isize i = 0; i < PROFILE_COUNT; i++) out << result.share[i] << '\t';
+        out << result.problem << '\n';
+    }
+
+    if (!out.good()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+}
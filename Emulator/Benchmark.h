@@ -0,0 +1,137 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Object.h"
+#include "C64Types.h"
+
+/* Measures the emulation speed with a set of reproducible workloads. Each
+ * workload runs on a fresh headless instance. The instance boots into the
+ * Basic prompt, the workload is set up, and after a warm-up phase, a fixed
+ * number of frames is emulated and timed. The workloads don't depend on any
+ * media files. Disks, tapes, and cartridges are synthesized and programs are
+ * poked into memory. Only the Roms need to be provided.
+ *
+ *   IDLE       The Basic prompt with a blinking cursor
+ *   SPRITES    Eight expanded multicolor sprites moving across the text
+ *   SID        Four SIDs playing a sweep with reSID in resample mode
+ *   DRIVES     Two drives reading sectors from a disk (requires a VC1541 Rom)
+ *   TAPE       The Kernal searching for a header on a noisy tape
+ *   EASYFLASH  An EasyFlash cartridge switching banks in a tight loop
+ *
+ * After the measurement, the workload is emulated for a few more frames with
+ * the profiler enabled to break down the host time by component (see
+ * Profiler). The profiled frames are not part of the measurement.
+ *
+ * The report is stored as a text file. Each workload is described by a line
+ * of tab separated values (workload, frames, cycles, host time in seconds,
+ * emulated MHz, frames per second, the share of each profiled component in
+ * percent, problem). Skipped workloads have a problem description and no
+ * measurements.
+ */
+class Benchmark : C64Object {
+
+public:
+
+    struct Result {
+
+        BenchmarkWorkload workload = BENCHMARK_IDLE;
+
+        // Measurements
+        u64 frames = 0;
+        u64 cycles = 0;
+        double seconds = 0.0;
+
+        // Share of each component in the host time in percent
+        double share[PROFILE_COUNT] = { };
+
+        // Reason for skipping the workload (empty if it has been measured)
+        string problem;
+
+        double mhz() const { return seconds > 0 ? cycles / seconds / 1000000.0 : 0; }
+        double fps() const { return seconds > 0 ? frames / seconds : 0; }
+    };
+
+private:
+
+    // Number of frames emulated before the workload is set up
+    static const u64 bootFrames = 150;
+
+    // Number of frames emulated before the measurement starts
+    static const u64 warmupFrames = 50;
+
+    // Number of frames emulated with the profiler enabled
+    static const u64 profileFrames = 100;
+
+    // Distance between two rasterlines measured by the profiler
+    static const isize profileInterval = 16;
+
+    // Roms installed in each instance
+    std::vector<class RomFile *> roms;
+
+    // Results of the most recent run
+    std::vector<Result> results;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    ~Benchmark();
+    const char *getDescription() const override { return "Benchmark"; }
+
+    // Loads a Rom which is installed in each instance
+    void loadRom(const string &path) throws;
+
+
+    //
+    // Running
+    //
+
+public:
+
+    // Runs all workloads
+    void run(u64 frames);
+
+    // Runs a single workload
+    Result run(BenchmarkWorkload workload, u64 frames);
+
+private:
+
+    // Prepares an instance before it is powered on
+    string setup(class C64 &c64, BenchmarkWorkload workload);
+
+    // Starts the workload on an instance sitting at the Basic prompt
+    void start(class C64 &c64, BenchmarkWorkload workload);
+
+    // Keeps the workload busy (called between measured batches)
+    void feed(class C64 &c64, BenchmarkWorkload workload);
+
+
+    //
+    // Querying
+    //
+
+public:
+
+    usize count() const { return results.size(); }
+    const Result &operator[](usize nr) const { return results[nr]; }
+
+
+    //
+    // Saving
+    //
+
+public:
+
+    void writeToFile(const string &path) const throws;
+};
@@ -13,36 +13,17 @@
 // Emulator thread
 //
 
-void 
-threadTerminated(void* thisC64)
-{
-    assert(thisC64 != nullptr);
-    
-    // Inform the C64 that the thread has been canceled
-    C64 *c64 = (C64 *)thisC64;
-    c64->threadDidTerminate();
-}
-
-void 
+void
 *threadMain(void *thisC64) {
     
     assert(thisC64 != nullptr);
     
-    // Inform the C64 that the thread is about to start
     C64 *c64 = (C64 *)thisC64;
     c64->threadWillStart();
+    c64->threadLoop();
+    c64->threadDidTerminate();
     
-    // Configure thread properties...
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, nullptr);
-    pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, nullptr);
-    pthread_cleanup_push(threadTerminated, thisC64);
-    
-    // Enter the run loop
-    c64->runLoop();
-    
-    // Clean up and exit
-    pthread_cleanup_pop(1);
-    pthread_exit(nullptr);
+    return nullptr;
 }
 
 
@@ -68,6 +49,8 @@ C64::C64()
         &iec,
         &drive8,
         &drive9,
+        &drive10,
+        &drive11,
         &datasette,
         &oscillator
     };
@@ -78,18 +61,47 @@ C64::C64()
         
     // Initialize mutexes
     pthread_mutex_init(&threadLock, nullptr);
+    pthread_cond_init(&threadCond, nullptr);
     pthread_mutex_init(&stateChangeLock, nullptr);
 }
 
 C64::~C64()
 {
     trace(RUN_DEBUG, "Destroying C64[%p]\n", this);
+    
+    // Stop the loader while all components are alive
+    loader.cancel();
     powerOff();
     
+    // Terminate the emulator thread (if it has been launched)
+    if (p != (pthread_t)0) {
+        
+        pthread_mutex_lock(&threadLock);
+        threadQuit = true;
+        pthread_cond_broadcast(&threadCond);
+        pthread_mutex_unlock(&threadLock);
+        pthread_join(p, nullptr);
+    }
+    
     pthread_mutex_destroy(&threadLock);
+    pthread_cond_destroy(&threadCond);
     pthread_mutex_destroy(&stateChangeLock);
 }
 
+C64 *
+C64::makeOnCores(u64 cores)
+{
+    C64 *result = nullptr;
+    
+    ThreadPolicy policy;
+    policy.affinity = cores;
+    runWithPolicy(policy, [&result]() { result = new C64(); });
+    
+    result->configure(OPT_THREAD_AFFINITY, THREAD_ROLE_EMULATOR, (long)cores);
+    result->configure(OPT_THREAD_AFFINITY, THREAD_ROLE_HELPER, (long)cores);
+    return result;
+}
+
 void
 C64::prefix() const
 {
@@ -126,6 +138,9 @@ C64::_reset()
     runLoopCtrl = 0;
 
     rasterCycle = 1;
+    drivesLag = 0;
+    rescheduleEvents();
+    journal.clear();
 }
 
 InspectionTarget
@@ -174,6 +189,7 @@ C64::getConfigItem(Option option) const
             
         case OPT_VIC_REVISION:
         case OPT_PALETTE:
+        case OPT_PAL_BLENDING:
         case OPT_GRAY_DOT_BUG:
         case OPT_GLUE_LOGIC:
         case OPT_HIDE_SPRITES:
@@ -196,6 +212,9 @@ C64::getConfigItem(Option option) const
         case OPT_CUT_OPACITY:
         case OPT_SS_COLLISIONS:
         case OPT_SB_COLLISIONS:
+        case OPT_INDEXED_TEXTURE:
+        case OPT_FRAME_SKIP:
+        case OPT_RENDER_PIPELINE:
             return vic.getConfigItem(option);
                         
         case OPT_CIA_REVISION:
@@ -207,6 +226,8 @@ C64::getConfigItem(Option option) const
         case OPT_SID_FILTER:
         case OPT_SID_ENGINE:
         case OPT_SID_SAMPLING:
+        case OPT_SID_PARALLEL:
+        case OPT_AUDIO_LAYOUT:
         case OPT_AUDVOLL:
         case OPT_AUDVOLR:
             return sid.getConfigItem(option);
@@ -215,6 +236,39 @@ C64::getConfigItem(Option option) const
         case OPT_DEBUGCART:
             return mem.getConfigItem(option);
 
+        case OPT_SPIN_WINDOW:
+        case OPT_AUDIO_PACING:
+        case OPT_EMULATION_SPEED:
+        case OPT_POWER_SAVING:
+            return oscillator.getConfigItem(option);
+
+        case OPT_IEC_TURBO:
+            return iec.getConfigItem(option);
+            
+        case OPT_DATASETTE_TURBO:
+            return datasette.getConfigItem(option);
+            
+        case OPT_HEADLESS:
+            return headless;
+            
+        case OPT_PROFILER:
+            return profiler.getInterval();
+            
+        case OPT_PERF_INTERVAL:
+            return perfMonitor.getInterval();
+            
+        case OPT_DRIVE_SPECULATION:
+            return speculator.isEnabled();
+            
+        case OPT_BOOT_CACHE:
+            return (long)bootFrames;
+            
+        case OPT_DEBUG_PORT:
+            return debugPort.isEnabled();
+            
+        case OPT_UNDO_JOURNAL:
+            return journal.getCapacity();
+
         default:
             assert(false);
             return 0;
@@ -237,11 +291,28 @@ C64::getConfigItem(Option option, long id) const
         case OPT_DRIVE_TYPE:
         case OPT_DRIVE_CONNECT:
         case OPT_DRIVE_POWER_SWITCH:
+        case OPT_DRIVE_IDLE_SLEEP:
+        case OPT_DRIVE_FAST_LOAD:
         {
             assert(isDriveID(id));
-            const Drive &drive = id == DRIVE8 ? drive8 : drive9;
+            const Drive &drive = *drives[id - DRIVE8];
             return drive.getConfigItem(option);
         }
+        case OPT_THREAD_AFFINITY:
+        case OPT_THREAD_PRIORITY:
+        case OPT_THREAD_ROUND_ROBIN:
+        case OPT_THREAD_QOS:
+        {
+            assert_enum(ThreadRole, id);
+            const ThreadPolicy &policy = threadPolicy[id];
+            
+            switch (option) {
+                case OPT_THREAD_AFFINITY:     return (long)policy.affinity;
+                case OPT_THREAD_PRIORITY:     return policy.priority;
+                case OPT_THREAD_ROUND_ROBIN:  return policy.roundRobin;
+                default:                      return policy.qos;
+            }
+        }
         default:
             assert(false);
             return 0;
@@ -282,21 +353,150 @@ C64::configure(Option option, long id, long value)
     return changed;
 }
 
+ErrorCode
+C64::configure(const ConfigItem *items, usize count)
+{
+    assert(items || count == 0);
+    
+    trace(CNF_DEBUG, "configure(%zu items)\n", count);
+
+    // Check all items before anything is changed
+    for (usize i = 0; i < count; i++) {
+        
+        if (!isValidConfigItem(items[i])) {
+            
+            warn("Invalid configuration item: %s (id: %ld, value: %ld)\n",
+                 OptionEnum::isValid(items[i].option) ?
+                 OptionEnum::key(items[i].option) : "???",
+                 items[i].id, items[i].value);
+            return ERROR_OPT_INV_ARG;
+        }
+    }
+    
+    suspend();
+    
+    // Apply all items and postpone the expensive rebuilds
+    bool changed = false;
+    batching = true;
+    
+    for (usize i = 0; i < count; i++) {
+        
+        const ConfigItem &item = items[i];
+        
+        if (item.id < 0) {
+            changed |= HardwareComponent::configure(item.option, item.value);
+        } else {
+            changed |= HardwareComponent::configure(item.option, item.id, item.value);
+        }
+    }
+    
+    batching = false;
+    
+    // Carry out the postponed rebuilds
+    if (vicFunctionTableDirty) updateVicFunctionTable();
+    sid.updateSamplingParameters();
+    
+    resume();
+    
+    // Inform the GUI if the configuration has changed
+    if (changed) messageQueue.put(MSG_CONFIG);
+    
+    // Dump the current configuration in debugging mode
+    if (changed && CNF_DEBUG) dumpConfig();
+
+    return ERROR_OK;
+}
+
+bool
+C64::isValidConfigItem(const ConfigItem &item) const
+{
+    long id = item.id;
+    long value = item.value;
+    
+    if (!OptionEnum::isValid(item.option)) return false;
+    
+    switch (item.option) {
+            
+        case OPT_SID_ENABLE:
+            
+            if (id == 0 && !value) return false;
+            return id >= 0 && id <= 3;
+
+        case OPT_SID_ADDRESS:
+        case OPT_AUDPAN:
+        case OPT_AUDVOL:
+            
+            return id >= 0 && id <= 3;
+            
+        case OPT_DRIVE_TYPE:
+            
+            return isDriveID(id) && DriveTypeEnum::isValid(value);
+
+        case OPT_DRIVE_CONNECT:
+        case OPT_DRIVE_POWER_SWITCH:
+        case OPT_DRIVE_IDLE_SLEEP:
+        case OPT_DRIVE_FAST_LOAD:
+            
+            return isDriveID(id);
+
+        case OPT_THREAD_AFFINITY:
+        case OPT_THREAD_PRIORITY:
+        case OPT_THREAD_ROUND_ROBIN:
+        case OPT_THREAD_QOS:
+            
+            return ThreadRoleEnum::isValid(id);
+            
+        default:
+            break;
+    }
+    
+    // The remaining options don't take an id
+    if (id >= 0) return false;
+    
+    switch (item.option) {
+            
+        case OPT_VIC_REVISION:      return VICRevisionEnum::isValid(value);
+        case OPT_PALETTE:           return PaletteEnum::isValid(value);
+        case OPT_GLUE_LOGIC:        return GlueLogicEnum::isValid(value);
+        case OPT_CIA_REVISION:      return CIARevisionEnum::isValid(value);
+        case OPT_SID_REVISION:      return SIDRevisionEnum::isValid(value);
+        case OPT_SID_ENGINE:        return SIDEngineEnum::isValid(value);
+        case OPT_SID_SAMPLING:      return SamplingMethodEnum::isValid(value);
+        case OPT_AUDIO_LAYOUT:      return AudioLayoutEnum::isValid(value);
+        case OPT_RAM_PATTERN:       return RamPatternEnum::isValid(value);
+        case OPT_FRAME_SKIP:        return value >= FRAME_SKIP_ON_DEMAND;
+        case OPT_AUDIO_PACING:      return value >= 0 && value <= 200;
+        case OPT_EMULATION_SPEED:   return value >= 25 && value <= 800;
+        case OPT_POWER_SAVING:      return value >= 0 && value <= 8;
+            
+        case OPT_SPIN_WINDOW:
+        case OPT_PROFILER:
+        case OPT_PERF_INTERVAL:
+        case OPT_BOOT_CACHE:        return value >= 0;
+        case OPT_UNDO_JOURNAL:      return value >= 0 && value <= UndoJournal::maxCapacity;
+            
+        default:                    return true;
+    }
+}
+
 void
 C64::configure(C64Model model)
 {
     if (model != C64_MODEL_CUSTOM) {
         
-        suspend();
-        configure(OPT_VIC_REVISION, configurations[model].vic);
-        configure(OPT_GRAY_DOT_BUG, configurations[model].grayDotBug);
-        configure(OPT_GLUE_LOGIC,   configurations[model].glue);
-        configure(OPT_CIA_REVISION, configurations[model].cia);
-        configure(OPT_TIMER_B_BUG,  configurations[model].timerBBug);
-        configure(OPT_SID_REVISION, configurations[model].sid);
-        configure(OPT_SID_FILTER,   configurations[model].sidFilter);
-        configure(OPT_RAM_PATTERN,  configurations[model].pattern);
-        resume();
+        const ConfigItem items[] = {
+            
+            { OPT_VIC_REVISION, -1, configurations[model].vic },
+            { OPT_GRAY_DOT_BUG, -1, configurations[model].grayDotBug },
+            { OPT_GLUE_LOGIC,   -1, configurations[model].glue },
+            { OPT_CIA_REVISION, -1, configurations[model].cia },
+            { OPT_TIMER_B_BUG,  -1, configurations[model].timerBBug },
+            { OPT_SID_REVISION, -1, configurations[model].sid },
+            { OPT_SID_FILTER,   -1, configurations[model].sidFilter },
+            { OPT_RAM_PATTERN,  -1, configurations[model].pattern }
+        };
+        
+        configure(items, sizeof(items) / sizeof(items[0]));
     }
 }
 
@@ -318,6 +518,131 @@ C64::setConfigItem(Option option, long value)
             durationOfOneCycle = 10000000000 / newFrequency;
             return true;
         }
+        case OPT_HEADLESS:
+        {
+            if (headless == (bool)value) return false;
+            
+            suspend();
+            headless = value;
+            resume();
+            return true;
+        }
+        case OPT_PROFILER:
+        {
+            if (value < 0) {
+                warn("Invalid profiling interval: %ld\n", value);
+                return false;
+            }
+            if (profiler.getInterval() == value) return false;
+            
+            suspend();
+            profiler.configure(value);
+            resume();
+            return true;
+        }
+        case OPT_PERF_INTERVAL:
+        {
+            if (value < 0) {
+                warn("Invalid sampling interval: %ld\n", value);
+                return false;
+            }
+            if (perfMonitor.getInterval() == value) return false;
+            
+            suspend();
+            perfMonitor.configure(*this, value);
+            resume();
+            return true;
+        }
+        case OPT_DRIVE_SPECULATION:
+        {
+            if (speculator.isEnabled() == (bool)value) return false;
+            
+            suspend();
+            speculator.configure(value);
+            resume();
+            return true;
+        }
+        case OPT_BOOT_CACHE:
+        {
+            if (value < 0) {
+                warn("Invalid number of boot frames: %ld\n", value);
+                return false;
+            }
+            if (bootFrames == (u64)value) return false;
+            
+            bootFrames = (u64)value;
+            return true;
+        }
+        case OPT_DEBUG_PORT:
+        {
+            if (debugPort.isEnabled() == (bool)value) return false;
+            
+            suspend();
+            debugPort.setEnabled(value);
+            mem.updateIOTables();
+            resume();
+            return true;
+        }
+        case OPT_UNDO_JOURNAL:
+        {
+            if (value < 0 || value > UndoJournal::maxCapacity) {
+                warn("Invalid journal capacity: %ld\n", value);
+                return false;
+            }
+            if (journal.getCapacity() == value) return false;
+            
+            suspend();
+            journal.configure(*this, value);
+            resume();
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+bool
+C64::setConfigItem(Option option, long id, long value)
+{
+    switch (option) {
+            
+        case OPT_THREAD_AFFINITY:
+        case OPT_THREAD_PRIORITY:
+        case OPT_THREAD_ROUND_ROBIN:
+        case OPT_THREAD_QOS:
+        {
+            if (!ThreadRoleEnum::isValid(id)) {
+                warn("Invalid thread role: %ld\n", id);
+                return false;
+            }
+            
+            ThreadPolicy policy = threadPolicy[id];
+            
+            switch (option) {
+                case OPT_THREAD_AFFINITY:     policy.affinity = (u64)value; break;
+                case OPT_THREAD_PRIORITY:     policy.priority = value; break;
+                case OPT_THREAD_ROUND_ROBIN:  policy.roundRobin = value; break;
+                default:                      policy.qos = value; break;
+            }
+            
+            if (id == THREAD_ROLE_EMULATOR) {
+                
+                // The new policy is applied when the run loop is entered again
+                suspend();
+                threadPolicy[id] = policy;
+                threadPolicyChanged = true;
+                resume();
+                
+            } else {
+                
+                threadPolicy[id] = policy;
+                sid.setThreadPolicy(policy);
+                vic.setThreadPolicy(policy);
+                snapshotWriter.setPolicy(policy);
+                speculator.setThreadPolicy(policy);
+            }
+            return true;
+        }
         default:
             return false;
     }
@@ -354,35 +679,49 @@ C64::getModel() const
 void
 C64::updateVicFunctionTable()
 {
+    // Postpone the update if a batch of configuration items is being applied
+    if (batching) { vicFunctionTableDirty = true; return; }
+    vicFunctionTableDirty = false;
+    
     bool dmaDebug = vic.getConfig().dmaDebug;
+    bool is856x = vic.is856x();
     
-    trace(VIC_DEBUG, "updateVicFunctionTable (dmaDebug: %d)\n", dmaDebug);
+    trace(VIC_DEBUG, "updateVicFunctionTable (dmaDebug: %d, 856x: %d)\n", dmaDebug, is856x);
     
-    // Assign model independent execution functions
-    vicfunc[0] = nullptr;
-    if (dmaDebug) {
-        vicfunc[12] = &VICII::cycle12<PAL_DEBUG_CYCLE>;
-        vicfunc[13] = &VICII::cycle13<PAL_DEBUG_CYCLE>;
-        vicfunc[14] = &VICII::cycle14<PAL_DEBUG_CYCLE>;
-        vicfunc[15] = &VICII::cycle15<PAL_DEBUG_CYCLE>;
-        vicfunc[16] = &VICII::cycle16<PAL_DEBUG_CYCLE>;
-        vicfunc[17] = &VICII::cycle17<PAL_DEBUG_CYCLE>;
-        vicfunc[18] = &VICII::cycle18<PAL_DEBUG_CYCLE>;
-        for (unsigned cycle = 19; cycle <= 54; cycle++)
-            vicfunc[cycle] = &VICII::cycle19to54<PAL_DEBUG_CYCLE>;
-        vicfunc[56] = &VICII::cycle56<PAL_DEBUG_CYCLE>;
+    // Select the instantiation set matching the current configuration
+    if (is856x) {
+        if (dmaDebug) {
+            assignVicFunctions<(VICIIMode)(DEBUG_CYCLE | VIC856X_CYCLE)>();
+        } else {
+            assignVicFunctions<VIC856X_CYCLE>();
+        }
     } else {
-        vicfunc[12] = &VICII::cycle12<PAL_CYCLE>;
-        vicfunc[13] = &VICII::cycle13<PAL_CYCLE>;
-        vicfunc[14] = &VICII::cycle14<PAL_CYCLE>;
-        vicfunc[15] = &VICII::cycle15<PAL_CYCLE>;
-        vicfunc[16] = &VICII::cycle16<PAL_CYCLE>;
-        vicfunc[17] = &VICII::cycle17<PAL_CYCLE>;
-        vicfunc[18] = &VICII::cycle18<PAL_CYCLE>;
-        for (unsigned cycle = 19; cycle <= 54; cycle++)
-            vicfunc[cycle] = &VICII::cycle19to54<PAL_CYCLE>;
-        vicfunc[56] = &VICII::cycle56<PAL_CYCLE>;
+        if (dmaDebug) {
+            assignVicFunctions<DEBUG_CYCLE>();
+        } else {
+            assignVicFunctions<PAL_CYCLE>();
+        }
     }
+}
+
+template <VICIIMode flags> void
+C64::assignVicFunctions()
+{
+    const VICIIMode pal = flags;
+    const VICIIMode ntsc = (VICIIMode)(flags | NTSC_CYCLE);
+    
+    // Assign model independent execution functions
+    vicfunc[0] = nullptr;
+    vicfunc[12] = &VICII::cycle12<pal>;
+    vicfunc[13] = &VICII::cycle13<pal>;
+    vicfunc[14] = &VICII::cycle14<pal>;
+    vicfunc[15] = &VICII::cycle15<pal>;
+    vicfunc[16] = &VICII::cycle16<pal>;
+    vicfunc[17] = &VICII::cycle17<pal>;
+    vicfunc[18] = &VICII::cycle18<pal>;
+    for (unsigned cycle = 19; cycle <= 54; cycle++)
+        vicfunc[cycle] = &VICII::cycle19to54<pal>;
+    vicfunc[56] = &VICII::cycle56<pal>;
     
     // Assign model specific execution functions
     switch (vic.getRevision()) {
@@ -391,147 +730,78 @@ C64::updateVicFunctionTable()
         case VICREV_PAL_6569_R3:
         case VICREV_PAL_8565:
             
-            if (dmaDebug) {
-                vicfunc[1] = &VICII::cycle1<PAL_DEBUG_CYCLE>;
-                vicfunc[2] = &VICII::cycle2<PAL_DEBUG_CYCLE>;
-                vicfunc[3] = &VICII::cycle3<PAL_DEBUG_CYCLE>;
-                vicfunc[4] = &VICII::cycle4<PAL_DEBUG_CYCLE>;
-                vicfunc[5] = &VICII::cycle5<PAL_DEBUG_CYCLE>;
-                vicfunc[6] = &VICII::cycle6<PAL_DEBUG_CYCLE>;
-                vicfunc[7] = &VICII::cycle7<PAL_DEBUG_CYCLE>;
-                vicfunc[8] = &VICII::cycle8<PAL_DEBUG_CYCLE>;
-                vicfunc[9] = &VICII::cycle9<PAL_DEBUG_CYCLE>;
-                vicfunc[10] = &VICII::cycle10<PAL_DEBUG_CYCLE>;
-                vicfunc[11] = &VICII::cycle11<PAL_DEBUG_CYCLE>;
-                vicfunc[55] = &VICII::cycle55<PAL_DEBUG_CYCLE>;
-                vicfunc[57] = &VICII::cycle57<PAL_DEBUG_CYCLE>;
-                vicfunc[58] = &VICII::cycle58<PAL_DEBUG_CYCLE>;
-                vicfunc[59] = &VICII::cycle59<PAL_DEBUG_CYCLE>;
-                vicfunc[60] = &VICII::cycle60<PAL_DEBUG_CYCLE>;
-                vicfunc[61] = &VICII::cycle61<PAL_DEBUG_CYCLE>;
-                vicfunc[62] = &VICII::cycle62<PAL_DEBUG_CYCLE>;
-                vicfunc[63] = &VICII::cycle63<PAL_DEBUG_CYCLE>;
-            } else {
-                vicfunc[1] = &VICII::cycle1<PAL_CYCLE>;
-                vicfunc[2] = &VICII::cycle2<PAL_CYCLE>;
-                vicfunc[3] = &VICII::cycle3<PAL_CYCLE>;
-                vicfunc[4] = &VICII::cycle4<PAL_CYCLE>;
-                vicfunc[5] = &VICII::cycle5<PAL_CYCLE>;
-                vicfunc[6] = &VICII::cycle6<PAL_CYCLE>;
-                vicfunc[7] = &VICII::cycle7<PAL_CYCLE>;
-                vicfunc[8] = &VICII::cycle8<PAL_CYCLE>;
-                vicfunc[9] = &VICII::cycle9<PAL_CYCLE>;
-                vicfunc[10] = &VICII::cycle10<PAL_CYCLE>;
-                vicfunc[11] = &VICII::cycle11<PAL_CYCLE>;
-                vicfunc[55] = &VICII::cycle55<PAL_CYCLE>;
-                vicfunc[57] = &VICII::cycle57<PAL_CYCLE>;
-                vicfunc[58] = &VICII::cycle58<PAL_CYCLE>;
-                vicfunc[59] = &VICII::cycle59<PAL_CYCLE>;
-                vicfunc[60] = &VICII::cycle60<PAL_CYCLE>;
-                vicfunc[61] = &VICII::cycle61<PAL_CYCLE>;
-                vicfunc[62] = &VICII::cycle62<PAL_CYCLE>;
-                vicfunc[63] = &VICII::cycle63<PAL_CYCLE>;
-            }
+            vicfunc[1] = &VICII::cycle1<pal>;
+            vicfunc[2] = &VICII::cycle2<pal>;
+            vicfunc[3] = &VICII::cycle3<pal>;
+            vicfunc[4] = &VICII::cycle4<pal>;
+            vicfunc[5] = &VICII::cycle5<pal>;
+            vicfunc[6] = &VICII::cycle6<pal>;
+            vicfunc[7] = &VICII::cycle7<pal>;
+            vicfunc[8] = &VICII::cycle8<pal>;
+            vicfunc[9] = &VICII::cycle9<pal>;
+            vicfunc[10] = &VICII::cycle10<pal>;
+            vicfunc[11] = &VICII::cycle11<pal>;
+            vicfunc[55] = &VICII::cycle55<pal>;
+            vicfunc[57] = &VICII::cycle57<pal>;
+            vicfunc[58] = &VICII::cycle58<pal>;
+            vicfunc[59] = &VICII::cycle59<pal>;
+            vicfunc[60] = &VICII::cycle60<pal>;
+            vicfunc[61] = &VICII::cycle61<pal>;
+            vicfunc[62] = &VICII::cycle62<pal>;
+            vicfunc[63] = &VICII::cycle63<pal>;
             vicfunc[64] = nullptr;
             vicfunc[65] = nullptr;
             break;
             
         case VICREV_NTSC_6567_R56A:
             
-            if (dmaDebug) {
-                vicfunc[1] = &VICII::cycle1<PAL_DEBUG_CYCLE>;
-                vicfunc[2] = &VICII::cycle2<PAL_DEBUG_CYCLE>;
-                vicfunc[3] = &VICII::cycle3<PAL_DEBUG_CYCLE>;
-                vicfunc[4] = &VICII::cycle4<PAL_DEBUG_CYCLE>;
-                vicfunc[5] = &VICII::cycle5<PAL_DEBUG_CYCLE>;
-                vicfunc[6] = &VICII::cycle6<PAL_DEBUG_CYCLE>;
-                vicfunc[7] = &VICII::cycle7<PAL_DEBUG_CYCLE>;
-                vicfunc[8] = &VICII::cycle8<PAL_DEBUG_CYCLE>;
-                vicfunc[9] = &VICII::cycle9<PAL_DEBUG_CYCLE>;
-                vicfunc[10] = &VICII::cycle10<PAL_DEBUG_CYCLE>;
-                vicfunc[11] = &VICII::cycle11<PAL_DEBUG_CYCLE>;
-                vicfunc[55] = &VICII::cycle55<NTSC_DEBUG_CYCLE>;
-                vicfunc[57] = &VICII::cycle57<NTSC_DEBUG_CYCLE>;
-                vicfunc[58] = &VICII::cycle58<NTSC_DEBUG_CYCLE>;
-                vicfunc[59] = &VICII::cycle59<NTSC_DEBUG_CYCLE>;
-                vicfunc[60] = &VICII::cycle60<NTSC_DEBUG_CYCLE>;
-                vicfunc[61] = &VICII::cycle61<NTSC_DEBUG_CYCLE>;
-                vicfunc[62] = &VICII::cycle62<NTSC_DEBUG_CYCLE>;
-                vicfunc[63] = &VICII::cycle63<NTSC_DEBUG_CYCLE>;
-                vicfunc[64] = &VICII::cycle64<NTSC_DEBUG_CYCLE>;
-            } else {
-                vicfunc[1] = &VICII::cycle1<PAL_CYCLE>;
-                vicfunc[2] = &VICII::cycle2<PAL_CYCLE>;
-                vicfunc[3] = &VICII::cycle3<PAL_CYCLE>;
-                vicfunc[4] = &VICII::cycle4<PAL_CYCLE>;
-                vicfunc[5] = &VICII::cycle5<PAL_CYCLE>;
-                vicfunc[6] = &VICII::cycle6<PAL_CYCLE>;
-                vicfunc[7] = &VICII::cycle7<PAL_CYCLE>;
-                vicfunc[8] = &VICII::cycle8<PAL_CYCLE>;
-                vicfunc[9] = &VICII::cycle9<PAL_CYCLE>;
-                vicfunc[10] = &VICII::cycle10<PAL_CYCLE>;
-                vicfunc[11] = &VICII::cycle11<PAL_CYCLE>;
-                vicfunc[55] = &VICII::cycle55<NTSC_CYCLE>;
-                vicfunc[57] = &VICII::cycle57<NTSC_CYCLE>;
-                vicfunc[58] = &VICII::cycle58<NTSC_CYCLE>;
-                vicfunc[59] = &VICII::cycle59<NTSC_CYCLE>;
-                vicfunc[60] = &VICII::cycle60<NTSC_CYCLE>;
-                vicfunc[61] = &VICII::cycle61<NTSC_CYCLE>;
-                vicfunc[62] = &VICII::cycle62<NTSC_CYCLE>;
-                vicfunc[63] = &VICII::cycle63<NTSC_CYCLE>;
-                vicfunc[64] = &VICII::cycle64<NTSC_CYCLE>;
-            }
+            vicfunc[1] = &VICII::cycle1<pal>;
+            vicfunc[2] = &VICII::cycle2<pal>;
+            vicfunc[3] = &VICII::cycle3<pal>;
+            vicfunc[4] = &VICII::cycle4<pal>;
+            vicfunc[5] = &VICII::cycle5<pal>;
+            vicfunc[6] = &VICII::cycle6<pal>;
+            vicfunc[7] = &VICII::cycle7<pal>;
+            vicfunc[8] = &VICII::cycle8<pal>;
+            vicfunc[9] = &VICII::cycle9<pal>;
+            vicfunc[10] = &VICII::cycle10<pal>;
+            vicfunc[11] = &VICII::cycle11<pal>;
+            vicfunc[55] = &VICII::cycle55<ntsc>;
+            vicfunc[57] = &VICII::cycle57<ntsc>;
+            vicfunc[58] = &VICII::cycle58<ntsc>;
+            vicfunc[59] = &VICII::cycle59<ntsc>;
+            vicfunc[60] = &VICII::cycle60<ntsc>;
+            vicfunc[61] = &VICII::cycle61<ntsc>;
+            vicfunc[62] = &VICII::cycle62<ntsc>;
+            vicfunc[63] = &VICII::cycle63<ntsc>;
+            vicfunc[64] = &VICII::cycle64<ntsc>;
             vicfunc[65] = nullptr;
             break;
             
         case VICREV_NTSC_6567:
         case VICREV_NTSC_8562:
             
-            if (dmaDebug) {
-                vicfunc[1] = &VICII::cycle1<NTSC_DEBUG_CYCLE>;
-                vicfunc[2] = &VICII::cycle2<NTSC_DEBUG_CYCLE>;
-                vicfunc[3] = &VICII::cycle3<NTSC_DEBUG_CYCLE>;
-                vicfunc[4] = &VICII::cycle4<NTSC_DEBUG_CYCLE>;
-                vicfunc[5] = &VICII::cycle5<NTSC_DEBUG_CYCLE>;
-                vicfunc[6] = &VICII::cycle6<NTSC_DEBUG_CYCLE>;
-                vicfunc[7] = &VICII::cycle7<NTSC_DEBUG_CYCLE>;
-                vicfunc[8] = &VICII::cycle8<NTSC_DEBUG_CYCLE>;
-                vicfunc[9] = &VICII::cycle9<NTSC_DEBUG_CYCLE>;
-                vicfunc[10] = &VICII::cycle10<NTSC_DEBUG_CYCLE>;
-                vicfunc[11] = &VICII::cycle11<NTSC_DEBUG_CYCLE>;
-                vicfunc[55] = &VICII::cycle55<NTSC_DEBUG_CYCLE>;
-                vicfunc[57] = &VICII::cycle57<NTSC_DEBUG_CYCLE>;
-                vicfunc[58] = &VICII::cycle58<NTSC_DEBUG_CYCLE>;
-                vicfunc[59] = &VICII::cycle59<NTSC_DEBUG_CYCLE>;
-                vicfunc[60] = &VICII::cycle60<NTSC_DEBUG_CYCLE>;
-                vicfunc[61] = &VICII::cycle61<NTSC_DEBUG_CYCLE>;
-                vicfunc[62] = &VICII::cycle62<NTSC_DEBUG_CYCLE>;
-                vicfunc[63] = &VICII::cycle63<NTSC_DEBUG_CYCLE>;
-                vicfunc[64] = &VICII::cycle64<NTSC_DEBUG_CYCLE>;
-                vicfunc[65] = &VICII::cycle65<NTSC_DEBUG_CYCLE>;
-            } else {
-                vicfunc[1] = &VICII::cycle1<NTSC_CYCLE>;
-                vicfunc[2] = &VICII::cycle2<NTSC_CYCLE>;
-                vicfunc[3] = &VICII::cycle3<NTSC_CYCLE>;
-                vicfunc[4] = &VICII::cycle4<NTSC_CYCLE>;
-                vicfunc[5] = &VICII::cycle5<NTSC_CYCLE>;
-                vicfunc[6] = &VICII::cycle6<NTSC_CYCLE>;
-                vicfunc[7] = &VICII::cycle7<NTSC_CYCLE>;
-                vicfunc[8] = &VICII::cycle8<NTSC_CYCLE>;
-                vicfunc[9] = &VICII::cycle9<NTSC_CYCLE>;
-                vicfunc[10] = &VICII::cycle10<NTSC_CYCLE>;
-                vicfunc[11] = &VICII::cycle11<NTSC_CYCLE>;
-                vicfunc[55] = &VICII::cycle55<NTSC_CYCLE>;
-                vicfunc[57] = &VICII::cycle57<NTSC_CYCLE>;
-                vicfunc[58] = &VICII::cycle58<NTSC_CYCLE>;
-                vicfunc[59] = &VICII::cycle59<NTSC_CYCLE>;
-                vicfunc[60] = &VICII::cycle60<NTSC_CYCLE>;
-                vicfunc[61] = &VICII::cycle61<NTSC_CYCLE>;
-                vicfunc[62] = &VICII::cycle62<NTSC_CYCLE>;
-                vicfunc[63] = &VICII::cycle63<NTSC_CYCLE>;
-                vicfunc[64] = &VICII::cycle64<NTSC_CYCLE>;
-                vicfunc[65] = &VICII::cycle65<NTSC_CYCLE>;
-            }
+            vicfunc[1] = &VICII::cycle1<ntsc>;
+            vicfunc[2] = &VICII::cycle2<ntsc>;
+            vicfunc[3] = &VICII::cycle3<ntsc>;
+            vicfunc[4] = &VICII::cycle4<ntsc>;
+            vicfunc[5] = &VICII::cycle5<ntsc>;
+            vicfunc[6] = &VICII::cycle6<ntsc>;
+            vicfunc[7] = &VICII::cycle7<ntsc>;
+            vicfunc[8] = &VICII::cycle8<ntsc>;
+            vicfunc[9] = &VICII::cycle9<ntsc>;
+            vicfunc[10] = &VICII::cycle10<ntsc>;
+            vicfunc[11] = &VICII::cycle11<ntsc>;
+            vicfunc[55] = &VICII::cycle55<ntsc>;
+            vicfunc[57] = &VICII::cycle57<ntsc>;
+            vicfunc[58] = &VICII::cycle58<ntsc>;
+            vicfunc[59] = &VICII::cycle59<ntsc>;
+            vicfunc[60] = &VICII::cycle60<ntsc>;
+            vicfunc[61] = &VICII::cycle61<ntsc>;
+            vicfunc[62] = &VICII::cycle62<ntsc>;
+            vicfunc[63] = &VICII::cycle63<ntsc>;
+            vicfunc[64] = &VICII::cycle64<ntsc>;
+            vicfunc[65] = &VICII::cycle65<ntsc>;
             break;
             
         default:
@@ -542,9 +812,27 @@ C64::updateVicFunctionTable()
 void
 C64::setWarp(bool enable)
 {
-    // suspend();
-    HardwareComponent::setWarp(enable);
-    // resume();
+    // Record the change with the cycle it takes effect in
+    if (inputLog.isRecording() && enable != warpMode) {
+        inputLog.record(INPUT_EVENT_WARP, enable, (Cycle)cpu.cycle);
+    }
+
+    setWarpNow(enable);
+}
+
+bool
+C64::queuesHostInput() const
+{
+    return
+    state == EMULATOR_STATE_RUNNING ||
+    inputLog.isRecording() ||
+    runAhead.isActive(*this);
+}
+
+bool
+C64::dropsHostInput() const
+{
+    return inputLog.isReplaying();
 }
 
 void
@@ -566,6 +854,7 @@ C64::powerOn()
         
         acquireThreadLock();
         HardwareComponent::powerOn();
+        if (bootFrames) boot();
     }
     
     pthread_mutex_unlock(&stateChangeLock);
@@ -624,8 +913,22 @@ C64::_run()
 {
     trace(RUN_DEBUG, "_run()\n");
     
-    // Start the emulator thread
-    pthread_create(&p, nullptr, threadMain, (void *)this);
+    // Launch the emulator thread when the emulator runs for the first time
+    if (p == (pthread_t)0) pthread_create(&p, nullptr, threadMain, (void *)this);
+    
+    // Discard stop requests that have been issued in the meantime
+    stopFlag = false;
+    clearActionFlags(ACTION_FLAG_STOP);
+    
+    // Let the emulator thread execute all commands from now on
+    commands.open();
+    loader.flush();
+    
+    // Wake up the emulator thread
+    pthread_mutex_lock(&threadLock);
+    threadActive = true;
+    pthread_cond_broadcast(&threadCond);
+    pthread_mutex_unlock(&threadLock);
     
     // Inform the GUI
     putMessage(MSG_RUN);
@@ -650,6 +953,8 @@ C64::pause()
 void
 C64::inspect()
 {
+    if (isRunning() && !isEmulatorThread()) return;
+    
     switch(inspectionTarget) {
             
         case INSPECTION_TARGET_CPU: cpu.inspect(); break;
@@ -661,21 +966,71 @@ C64::inspect()
     }
 }
 
+void
+C64::publishStatus()
+{
+    C64Status info;
+    
+    info.version = ++statusVersion;
+    info.frame = frame;
+    info.cycle = cpu.cycle;
+    info.warp = warpMode;
+    info.jammed = cpu.isJammed();
+    
+    for (isize i = 0; i < DRIVE_COUNT; i++) {
+        
+        DriveStatus &d = info.drive[i];
+        DriveConfig config = drives[i]->getConfig();
+        
+        d.connected = config.connected;
+        d.switchedOn = config.switchedOn;
+        d.redLED = drives[i]->getRedLED();
+        d.spinning = drives[i]->isRotating();
+        d.writing = drives[i]->writeMode();
+        d.hasDisk = drives[i]->hasDisk();
+        d.halftrack = drives[i]->getHalftrack();
+    }
+    info.transferring = iec.isTransferring();
+    
+    info.hasTape = datasette.hasTape();
+    info.tapeMotor = datasette.getMotor();
+    info.playKey = datasette.getPlayKey();
+    info.tapeCounter = datasette.getHeadInSeconds();
+    
+    info.hasCartridge = expansionport.getCartridgeAttached();
+    info.hasCartridgeLED = expansionport.hasLED();
+    info.cartridgeLED = info.hasCartridgeLED && expansionport.getLED();
+    info.cartridgeSwitch = info.hasCartridge ? expansionport.getSwitch() : 0;
+    
+    status.publish(info);
+}
+
 void
 C64::_pause()
 {
     trace(RUN_DEBUG, "_pause()\n");
     
-    // When we reach this line, the emulator thread is already gone
-    assert(p == (pthread_t)0);
-    
+    // When we reach this line, the emulator thread has left the run loop
     // Update the recorded debug information
     inspect();
+    publishStatus();
+    
+    // Release the helper thread of the drive speculator
+    speculator.stop();
     
     // Inform the GUI
     putMessage(MSG_PAUSE);
 }
 
+void
+C64::_memoryUsage(MemoryUsage &usage)
+{
+    usage.heapBytes += rewindBuffer.memoryUsage();
+    usage.heapBytes += inputLog.memoryUsage();
+    if (autoSnapshot) usage.heapBytes += autoSnapshot->size;
+    if (userSnapshot) usage.heapBytes += userSnapshot->size;
+}
+
 void
 C64::_dump() const
 {
@@ -720,13 +1075,16 @@ C64::_setDebug(bool enable)
 void
 C64::suspend()
 {
+    if (isEmulatorThread()) return;
+    
     pthread_mutex_lock(&stateChangeLock);
     
     trace(RUN_DEBUG, "Suspending (%d)...\n", suspendCounter);
     
     if (suspendCounter || isRunning()) {
         
-        acquireThreadLock();
+        // Stop at the end of the current rasterline
+        acquireThreadLock(false);
         assert(!isRunning()); // At this point, the emulator is already paused
         
         suspendCounter++;
@@ -738,6 +1096,8 @@ C64::suspend()
 void
 C64::resume()
 {
+    if (isEmulatorThread()) return;
+    
     pthread_mutex_lock(&stateChangeLock);
     
     trace(RUN_DEBUG, "Resuming (%d)...\n", suspendCounter);
@@ -752,28 +1112,38 @@ C64::resume()
 }
 
 void
-C64::acquireThreadLock()
+C64::issue(const Cmd &cmd)
 {
-    // Free the lock
-    if (state == EMULATOR_STATE_RUNNING) {
-        
-        // Assure the emulator thread exists
-        assert(p != (pthread_t)0);
+    if (!enqueue(cmd)) {
         
-        // Free the lock by terminating the thread
-        requestStop();
-        
-    } else {
-        
-        // There must be no emulator thread
-        assert(p == (pthread_t)0);
-        
-        // It's save to free the lock immediately
-        pthread_mutex_unlock(&threadLock);
+        suspend();
+        commands.perform(cmd);
+        resume();
     }
+}
+
+bool
+C64::enqueue(const Cmd &cmd)
+{
+    if (!commands.put(cmd)) return false;
     
-    // Acquire the lock
+    // Let the emulator thread execute the command
+    setActionFlags(ACTION_FLAG_COMMAND);
+    return true;
+}
+
+void
+C64::acquireThreadLock(bool frameEnd)
+{
+    // Ask the emulator thread to leave the run loop
+    if (state == EMULATOR_STATE_RUNNING) {
+        frameEnd ? requestStop() : signalStop();
+    }
+    
+    // Wait until the emulator thread is parked
     pthread_mutex_lock(&threadLock);
+    while (threadActive) pthread_cond_wait(&threadCond, &threadLock);
+    pthread_mutex_unlock(&threadLock);
 }
 
 bool
@@ -813,17 +1183,49 @@ void
 C64::threadDidTerminate()
 {
     trace(RUN_DEBUG, "Emulator thread terminated\n");
+}
+
+void
+C64::threadLoop()
+{
+    pthread_mutex_lock(&threadLock);
     
-    // Trash the thread pointer
-    p = (pthread_t)0;
-    
-    // Pause all components
-    HardwareComponent::pause();
-    
-    // Finish the current instruction to reach a clean state
-    finishInstruction();
+    while (!threadQuit) {
+        
+        // Park the thread until the emulator is requested to run
+        if (!threadActive) {
+            pthread_cond_wait(&threadCond, &threadLock);
+            continue;
+        }
+        pthread_mutex_unlock(&threadLock);
+        
+        // Apply the most recently configured scheduling parameters
+        if (threadPolicyChanged) {
+            
+            if (!threadPolicy[THREAD_ROLE_EMULATOR].apply()) {
+                warn("Failed to apply the emulator thread policy\n");
+            }
+            threadPolicyChanged = false;
+        }
+        
+        runLoop();
+        
+        // Execute all commands that have been issued in the meantime
+        commands.close();
+        commands.execute();
+        
+        // Pause all components
+        HardwareComponent::pause();
+        
+        // Finish the current instruction to reach a clean state
+        finishInstruction();
+        
+        // Hand over the emulator to the thread waiting in acquireThreadLock()
+        pthread_mutex_lock(&threadLock);
+        threadActive = false;
+        pthread_cond_broadcast(&threadCond);
+    }
     
-    // Release the thread lock
     pthread_mutex_unlock(&threadLock);
 }
 
@@ -835,12 +1237,26 @@ C64::runLoop()
     // Prepare to run
     oscillator.restart();
     // restartTimer();
+
+    // Record all changes the host has applied while the emulator was paused
+    if (inputLog.isRecording()) inputLog.sync(*this);
     
     // Enter the loop
     while (1) {
         
         // Run the emulator
-        while (runLoopCtrl == 0) { executeOneFrame(); }
+        while (runLoopCtrl == 0) {
+            
+            executeOneFrame();
+            
+            // Exchange the inputs with the remote peer at the end of each frame
+            if (netplay.isActive() && rasterLine == 0 && rasterCycle == 1) {
+                netplay.advance(*this);
+            }
+            
+            // Emulate the next frames ahead of time if requested
+            if (runLoopCtrl == 0 && runAhead.isActive(*this)) executeFramesAhead();
+        }
         
         // Check if special action needs to be taken
         if (runLoopCtrl) {
@@ -858,6 +1274,21 @@ C64::runLoop()
                 putMessage(MSG_USER_SNAPSHOT_TAKEN);
                 clearActionFlags(ACTION_FLAG_USER_SNAPSHOT);
             }
+            if (runLoopCtrl & ACTION_FLAG_AUTO_SAVE) {
+                trace(RUN_DEBUG, "RL_AUTO_SAVE\n");
+                snapshotWriter.save(*this);
+                clearActionFlags(ACTION_FLAG_AUTO_SAVE);
+            }
+            if (runLoopCtrl & ACTION_FLAG_INPUT_SYNC) {
+                trace(RUN_DEBUG, "RL_INPUT_SYNC\n");
+                inputLog.performSync(*this);
+                clearActionFlags(ACTION_FLAG_INPUT_SYNC);
+            }
+            if (runLoopCtrl & ACTION_FLAG_COMMAND) {
+                trace(RUN_DEBUG, "RL_COMMAND\n");
+                clearActionFlags(ACTION_FLAG_COMMAND);
+                commands.execute();
+            }
             
             // Are we requested to update the debugger info structs?
             if (runLoopCtrl & ACTION_FLAG_INSPECT) {
@@ -889,85 +1320,265 @@ C64::runLoop()
                 break;
             }
             
-            // Are we requested to pull the NMI line down?
-            if (runLoopCtrl & ACTION_FLAG_EXTERNAL_NMI) {
-                cpu.pullDownNmiLine(INTSRC_EXP);
-                trace(RUN_DEBUG, "EXTERNAL_NMI\n");
-                clearActionFlags(ACTION_FLAG_EXTERNAL_NMI);
-            }
+            // Are we requested to pull the NMI line down?
+            if (runLoopCtrl & ACTION_FLAG_EXTERNAL_NMI) {
+                cpu.pullDownNmiLine(INTSRC_EXP);
+                trace(RUN_DEBUG, "EXTERNAL_NMI\n");
+                clearActionFlags(ACTION_FLAG_EXTERNAL_NMI);
+            }
+            
+            // Is the CPU jammed due the execution of an illegal instruction?
+            if (runLoopCtrl & ACTION_FLAG_CPU_JAMMED) {
+                putMessage(MSG_CPU_JAMMED);
+                trace(RUN_DEBUG, "CPU_JAMMED\n");
+                clearActionFlags(ACTION_FLAG_CPU_JAMMED);
+                break;
+            }
+            
+            // Did the guest write to the exit register of the debug port?
+            if (runLoopCtrl & ACTION_FLAG_GUEST_EXIT) {
+                putMessage(MSG_GUEST_EXIT, debugPort.getExitCode());
+                trace(RUN_DEBUG, "GUEST_EXIT\n");
+                clearActionFlags(ACTION_FLAG_GUEST_EXIT);
+                break;
+            }
+        }
+    }
+}
+
+void
+C64::stopAndGo()
+{
+    isRunning() ? pause() : run();
+}
+
+void
+C64::stepInto()
+{
+    if (isRunning()) return;
+    
+    // Execute the next instruction
+    executeOneCycle();
+    finishInstruction();
+    
+    // Trigger a GUI refresh
+    putMessage(MSG_BREAKPOINT_REACHED);
+}
+
+void
+C64::stepOver()
+{
+    if (isRunning()) return;
+    
+    // If the next instruction is a JSR instruction (0x20), we set a breakpoint
+    // at the next memory location. Otherwise, stepOver behaves like stepInto.
+    if (mem.spypeek(cpu.getPC0()) == 0x20) {
+        cpu.debugger.setSoftStopAtNextInstr();
+        run();
+    } else {
+        stepInto();
+    }
+}
+
+bool
+C64::stepBack(isize count)
+{
+    if (isRunning()) return false;
+    
+    // Undo the requested number of instructions
+    if (!journal.stepBack(*this, count)) return false;
+    
+    // Trigger a GUI refresh
+    putMessage(MSG_BREAKPOINT_REACHED);
+    return true;
+}
+
+void
+C64::executeOneFrame()
+{
+    SIGNPOST(FRAME);
+    do { executeOneLine(); } while (rasterLine != 0 && runLoopCtrl.load(std::memory_order_relaxed) == 0);
+}
+
+void
+C64::executeFramesAhead()
+{
+    runAhead.save(*this);
+    
+    // Stop early if the run loop needs to take action
+    for (isize i = 0; i < runAhead.getFrames() && runLoopCtrl == 0; i++) {
+        executeOneFrame();
+    }
+    
+    runAhead.restore(*this);
+    
+    // A jam that has occurred ahead of time will occur again
+    clearActionFlags(ACTION_FLAG_CPU_JAMMED);
+}
+
+HeadlessExit
+C64::runHeadless(const HeadlessBudget &budget)
+{
+    assert(!isRunning());
+    
+    // Refuse to run forever
+    if (!budget.frames && !budget.cycles && !budget.patternLength &&
+        !budget.exitAtPC && !budget.predicate) {
+        return HEADLESS_EXIT_INVALID;
+    }
+    
+    // Let the CPU watch out for the exit address
+    cpu.exitAddr = budget.exitAtPC ? budget.pc : UINT32_MAX;
+    auto result = executeHeadless(budget);
+    cpu.exitAddr = UINT32_MAX;
+    
+    return result;
+}
+
+HeadlessExit
+C64::executeHeadless(const HeadlessBudget &budget)
+{
+    u64 frameLimit = budget.frames ? frame + budget.frames : UINT64_MAX;
+    u64 cycleLimit = budget.cycles ? cpu.cycle + budget.cycles : UINT64_MAX;
+    
+    while (1) {
+        
+        executeOneLine();
+        
+        // Exchange the inputs with the remote peer at the end of each frame
+        if (netplay.isActive() && rasterLine == 0 && rasterCycle == 1) {
+            netplay.advance(*this);
+        }
+        
+        // Check if special action needs to be taken
+        if (runLoopCtrl) {
+            
+            HeadlessExit exit;
+            if (serviceHeadlessFlags(exit)) return exit;
+        }
+        
+        if (cpu.cycle >= cycleLimit) return HEADLESS_EXIT_CYCLE_LIMIT;
+        
+        // Check the remaining conditions at the end of each frame or line
+        if (rasterCycle == 1 && (rasterLine == 0 || budget.checkEachLine)) {
             
-            // Is the CPU jammed due the execution of an illegal instruction?
-            if (runLoopCtrl & ACTION_FLAG_CPU_JAMMED) {
-                putMessage(MSG_CPU_JAMMED);
-                trace(RUN_DEBUG, "CPU_JAMMED\n");
-                clearActionFlags(ACTION_FLAG_CPU_JAMMED);
-                break;
+            if (matchesPattern(budget)) return HEADLESS_EXIT_PATTERN;
+            if (budget.predicate && budget.predicate(budget.context)) {
+                return HEADLESS_EXIT_PREDICATE;
             }
-            
-            assert(runLoopCtrl == 0);
+            if (frame >= frameLimit) return HEADLESS_EXIT_FRAME_LIMIT;
         }
     }
 }
 
-void
-C64::stopAndGo()
+bool
+C64::serviceHeadlessFlags(HeadlessExit &exit)
 {
-    isRunning() ? pause() : run();
+    if (runLoopCtrl & ACTION_FLAG_CPU_JAMMED) {
+        clearActionFlags(ACTION_FLAG_CPU_JAMMED);
+        exit = HEADLESS_EXIT_JAMMED;
+        return true;
+    }
+    if (runLoopCtrl & (ACTION_FLAG_BREAKPOINT | ACTION_FLAG_WATCHPOINT)) {
+        clearActionFlags(ACTION_FLAG_BREAKPOINT | ACTION_FLAG_WATCHPOINT);
+        exit = HEADLESS_EXIT_BREAKPOINT;
+        return true;
+    }
+    if (runLoopCtrl & ACTION_FLAG_EXIT_ADDR) {
+        clearActionFlags(ACTION_FLAG_EXIT_ADDR);
+        exit = HEADLESS_EXIT_PC;
+        return true;
+    }
+    if (runLoopCtrl & ACTION_FLAG_GUEST_EXIT) {
+        clearActionFlags(ACTION_FLAG_GUEST_EXIT);
+        exit = HEADLESS_EXIT_GUEST;
+        return true;
+    }
+    if (runLoopCtrl & ACTION_FLAG_EXTERNAL_NMI) {
+        cpu.pullDownNmiLine(INTSRC_EXP);
+        clearActionFlags(ACTION_FLAG_EXTERNAL_NMI);
+    }
+    if (runLoopCtrl & ACTION_FLAG_INPUT_SYNC) {
+        inputLog.performSync(*this);
+        clearActionFlags(ACTION_FLAG_INPUT_SYNC);
+    }
+    if (runLoopCtrl & ACTION_FLAG_STOP) {
+        clearActionFlags(ACTION_FLAG_STOP);
+        exit = HEADLESS_EXIT_STOP;
+        return true;
+    }
+    
+    // Snapshot and inspection requests are meaningless here
+    clearActionFlags(ACTION_FLAG_AUTO_SNAPSHOT |
+                     ACTION_FLAG_USER_SNAPSHOT |
+                     ACTION_FLAG_AUTO_SAVE |
+                     ACTION_FLAG_INSPECT);
+    
+    return false;
 }
 
-void
-C64::stepInto()
+bool
+C64::executeLinkedCycle(HeadlessExit &exit)
 {
-    if (isRunning()) return;
-    
-    // Execute the next instruction
     executeOneCycle();
-    finishInstruction();
-    
-    // Trigger a GUI refresh
-    putMessage(MSG_BREAKPOINT_REACHED);
+    return runLoopCtrl && serviceHeadlessFlags(exit);
 }
 
-void
-C64::stepOver()
+bool
+C64::matchesPattern(const HeadlessBudget &budget) const
 {
-    if (isRunning()) return;
+    assert(budget.patternLength <= sizeof(budget.pattern));
     
-    // If the next instruction is a JSR instruction (0x20), we set a breakpoint
-    // at the next memory location. Otherwise, stepOver behaves like stepInto.
-    if (mem.spypeek(cpu.getPC0()) == 0x20) {
-        cpu.debugger.setSoftStopAtNextInstr();
-        run();
-    } else {
-        stepInto();
+    if (budget.patternLength == 0) return false;
+    
+    for (usize i = 0; i < budget.patternLength; i++) {
+        u8 value = mem.spypeek((u16)(budget.patternAddr + i));
+        if ((value ^ budget.pattern[i]) & ~budget.patternIgnore[i]) return false;
     }
+    return true;
 }
 
 void
-C64::executeOneFrame()
+C64::executeOneLine()
 {
-    do { executeOneLine(); } while (rasterLine != 0 && runLoopCtrl == 0);
+    if (unlikely(profiler.isEnabled()) && profiler.sampleLine()) {
+        _executeOneLine<true>();
+    } else {
+        _executeOneLine<false>();
+    }
 }
 
-void
-C64::executeOneLine()
+template <bool profile> void
+C64::_executeOneLine()
 {
+    if constexpr (profile) profiler.begin();
+    
     // Emulate the beginning of a rasterline
-    if (rasterCycle == 1) beginRasterLine();
+    if (rasterCycle == 1) {
+        
+        beginRasterLine();
+        if constexpr (profile) profiler.charge(PROFILE_VICII);
+        
+        // Let the helper thread execute the drive up to the end of the line
+        speculator.speculate(*this, vic.getCyclesPerLine() * durationOfOneCycle);
+        if constexpr (profile) profiler.charge(PROFILE_DRIVE);
+    }
     
     // Emulate the middle of a rasterline
     unsigned lastCycle = vic.getCyclesPerLine();
     for (unsigned i = rasterCycle; i <= lastCycle; i++) {
         
-        _executeOneCycle();
-        if (runLoopCtrl != 0) {
-            if (i == lastCycle) endRasterLine();
+        _executeOneCycle<profile>();
+        if (runLoopCtrl.load(std::memory_order_relaxed) & cycleFlags) {
+            synchronizeDrives();
+            if constexpr (profile) profiler.charge(PROFILE_DRIVE);
+            if (i == lastCycle) endRasterLine<profile>();
             return;
         }
     }
     
     // Emulate the end of a rasterline
-    endRasterLine();
+    endRasterLine<profile>();
 }
 
 void
@@ -978,10 +1589,11 @@ C64::executeOneCycle()
     
     if (isFirstCycle) beginRasterLine();
     _executeOneCycle();
+    synchronizeDrives();
     if (isLastCycle) endRasterLine();
 }
 
-void
+template <bool profile> void
 C64::_executeOneCycle()
 {
     Cycle cycle = ++cpu.cycle;
@@ -1006,19 +1618,96 @@ C64::_executeOneCycle()
     
     // First clock phase (o2 low)
     (vic.*vicfunc[rasterCycle])();
-    if (cycle >= cia1.wakeUpCycle) cia1.executeOneCycle();
-    if (cycle >= cia2.wakeUpCycle) cia2.executeOneCycle();
-    if (iec.isDirtyC64Side) iec.updateIecLinesC64Side();
+    if constexpr (profile) profiler.charge(PROFILE_VICII);
+    if (cycle >= nextEvent) {
+        if (cycle >= inputs.next()) inputs.execute(cycle);
+        if (cycle >= inputLog.nextCycle()) inputLog.execute(*this, cycle);
+        if constexpr (profile) profiler.charge(PROFILE_OTHER);
+        if (cycle >= cia1.wakeUpCycle) cia1.executeOneCycle();
+        if (cycle >= cia2.wakeUpCycle) cia2.executeOneCycle();
+        if constexpr (profile) profiler.charge(PROFILE_CIA);
+        if (iec.isDirtyC64Side) {
+            synchronizeDrives();
+            if constexpr (profile) profiler.charge(PROFILE_DRIVE);
+            iec.updateIecLinesC64Side();
+            if constexpr (profile) profiler.charge(PROFILE_OTHER);
+        }
+    }
     
     // Second clock phase (o2 high)
-    cpu.executeOneCycle();
-    if (drive8.isActive()) drive8.execute(durationOfOneCycle);
-    if (drive9.isActive()) drive9.execute(durationOfOneCycle);
-    datasette.execute();
+    if (likely(!dma)) {
+        if (!cpu.frozen) cpu.executeOneCycle();
+    } else {
+        dma->executeOneCycle();
+    }
+    if constexpr (profile) profiler.charge(PROFILE_CPU);
+    drivesLag += durationOfOneCycle;
+    if (cycle >= nextEvent) {
+        if (activeDrives & (activeDrives - 1)) synchronizeDrives();
+        if constexpr (profile) profiler.charge(PROFILE_DRIVE);
+        datasette.execute();
+        if constexpr (profile) profiler.charge(PROFILE_DATASETTE);
+        scheduleNextEvent(cycle);
+        if constexpr (profile) profiler.charge(PROFILE_OTHER);
+    }
     
     rasterCycle++;
 }
 
+void
+C64::scheduleNextEvent(Cycle cycle)
+{
+    // Sleeping CIAs need to be serviced when their wake-up cycle is reached
+    nextEvent = MIN(cia1.wakeUpCycle, cia2.wakeUpCycle);
+    
+    // Injected and replayed input events need to be performed in their target cycle
+    nextEvent = MIN(nextEvent, inputs.next());
+    nextEvent = MIN(nextEvent, inputLog.nextCycle());
+    
+    // A moving tape needs to be serviced when the next edge is due
+    nextEvent = MIN(nextEvent, datasette.nextEdge());
+    
+    /* All other components need to be serviced in the next cycle if busy. A
+     * single active drive is caught up lazily. Multiple active drives talk to
+     * each other over the IEC bus and are executed in lockstep with the C64.
+     */
+    if (iec.isDirtyC64Side || (activeDrives & (activeDrives - 1))) {
+        nextEvent = cycle + 1;
+    }
+}
+
+void
+C64::synchronizeDrives()
+{
+    if (drivesLag == 0) return;
+    
+    SIGNPOST(DRIVE);
+    if (speculator.isSpeculating()) {
+        speculator.settle(drivesLag);
+    } else {
+        for (isize i = 0; i < DRIVE_COUNT; i++) {
+            if (GET_BIT(activeDrives, i)) drives[i]->execute(drivesLag);
+        }
+    }
+    drivesLag = 0;
+}
+
+void
+C64::updateActiveDrives()
+{
+    activeDrives = 0;
+    for (isize i = 0; i < DRIVE_COUNT; i++) {
+        if (drives[i]->isActive()) SET_BIT(activeDrives, i);
+    }
+}
+
+void
+C64::observeDrives()
+{
+    if (speculator.isSpeculating() && speculator.observe(drivesLag)) return;
+    synchronizeDrives();
+}
+
 void
 C64::finishInstruction()
 {
@@ -1035,10 +1724,18 @@ C64::beginRasterLine()
     vic.beginRasterline(rasterLine);
 }
 
-void
+template <bool profile> void
 C64::endRasterLine()
 {
+    synchronizeDrives();
+    if constexpr (profile) profiler.charge(PROFILE_DRIVE);
+    if (dma) dma->flush();
+    if constexpr (profile) profiler.charge(PROFILE_OTHER);
     vic.endRasterline();
+    if constexpr (profile) profiler.charge(PROFILE_VICII);
+    
+    // Pick up input events that have been submitted in the meantime
+    nextEvent = MIN(nextEvent, inputs.next());
     rasterCycle = 1;
     rasterLine++;
     
@@ -1051,6 +1748,9 @@ C64::endRasterLine()
 void
 C64::endFrame()
 {
+    bool profile = profiler.isEnabled();
+    if (profile) profiler.begin();
+    
     frame++;
     
     /*
@@ -1058,26 +1758,67 @@ C64::endFrame()
     */
     
     vic.endFrame();
+    if (profile) profiler.chargeFrame(PROFILE_VICII);
     
-    // Increment time of day clocks every tenth of a second
-    cia1.incrementTOD();
-    cia2.incrementTOD();
+    // Service the time of day clocks (only required if an alarm is due)
+    cia1.serviceTOD();
+    cia2.serviceTOD();
+    if (profile) profiler.chargeFrame(PROFILE_CIA);
     
     // Execute remaining SID cycles
     sid.executeUntil(cpu.cycle);
+    if (profile) profiler.chargeFrame(PROFILE_SID);
     
     // Execute other components
     iec.execute();
     expansionport.execute();
     port1.execute();
     port2.execute();
+    if (profile) profiler.chargeFrame(PROFILE_OTHER);
+    
+    // The remaining tasks are skipped in frames emulated ahead of time or again
+    if (runAhead.isRunningAhead() || netplay.isResimulating()) {
+        if (profile) profiler.endFrame();
+        return;
+    }
+    
     keyboard.vsyncHandler();
-    drive8.vsyncHandler();
-    drive9.vsyncHandler();
+    if (profile) profiler.chargeFrame(PROFILE_OTHER);
+    for (auto drive : drives) drive->vsyncHandler();
+    iec.vsyncHandler();
+    if (profile) profiler.chargeFrame(PROFILE_DRIVE);
+    datasette.vsyncHandler();
+    if (profile) profiler.chargeFrame(PROFILE_DATASETTE);
+    
+    // Collect the RAM pages written during this frame
+    mem.endFrame();
+    
+    // Transmit the audio samples of this frame
+    if (streamer.isEnabled()) streamer.addAudio(*this);
+    
+    // Update the inspector panels and the status information
+    if (inspectionTarget != INSPECTION_TARGET_NONE) inspect();
+    publishStatus();
+    
+    // Record the current state if requested
+    if (rewindBuffer.isDue(frame)) rewindBuffer.record(*this);
+    if (journal.isRecording()) journal.recordKeyframe(*this);
+    
+    // Record a checkpoint or feed the input queue
+    inputLog.endFrame(*this);
     
     // Check if the run loop is requested to stop
     if (stopFlag) { stopFlag = false; signalStop(); }
     
+    // Update the statistics (the host synchronization isn't profiled)
+    if (profile) {
+        profiler.chargeFrame(PROFILE_OTHER);
+        profiler.endFrame();
+    }
+    
+    // Sample the performance counters
+    perfMonitor.endFrame(*this);
+    
     // Count some sheep (zzzzzz) ...
     oscillator.synchronize();
 }
@@ -1085,13 +1826,13 @@ C64::endFrame()
 void
 C64::setActionFlags(u32 flags)
 {
-    synchronized { runLoopCtrl |= flags; }
+    runLoopCtrl.fetch_or(flags);
 }
 
 void
 C64::clearActionFlags(u32 flags)
 {
-    synchronized { runLoopCtrl &= ~flags; }
+    runLoopCtrl.fetch_and(~flags);
 }
 
 void
@@ -1126,6 +1867,21 @@ C64::requestUserSnapshot()
     }
 }
 
+void
+C64::requestAutoSave()
+{
+    if (!isRunning()) {
+        
+        // Save the snapshot immediately
+        snapshotWriter.save(*this);
+        
+    } else {
+        
+        // Schedule the snapshot to be saved
+        signalAutoSave();
+    }
+}
+
 Snapshot *
 C64::latestAutoSnapshot()
 {
@@ -1161,9 +1917,14 @@ C64::loadFromSnapshot(Snapshot *snapshot)
     
     // Restore the saved state
     load(snapshot->getData());
+    drivesLag = 0;
+    rescheduleEvents();
+    journal.clear();
     
-    // Clear the keyboard matrix to avoid constantly pressed keys
-    keyboard.releaseAll();
+    // Clear the keyboard matrix and the joysticks to avoid constantly pressed keys
+    keyboard._releaseAll();
+    port1.joystick._releaseAll();
+    port2.joystick._releaseAll();
     
     // Inform the GUI
     messageQueue.put(MSG_SNAPSHOT_RESTORED);
@@ -1172,6 +1933,241 @@ C64::loadFromSnapshot(Snapshot *snapshot)
     return true;
 }
 
+bool
+C64::loadFromRewindBuffer(isize nr)
+{
+    bool result;
+    
+    suspend();
+    result = rewindBuffer.restore(*this, nr);
+    resume();
+    
+    return result;
+}
+
+void
+C64::startInputRecording(isize checkpointInterval)
+{
+    suspend();
+    inputLog.startRecording(*this, checkpointInterval);
+    resume();
+}
+
+void
+C64::stopInputRecording()
+{
+    suspend();
+    inputLog.stopRecording(*this);
+    resume();
+}
+
+void
+C64::startInputReplay()
+{
+    suspend();
+    inputLog.startReplay(*this);
+    resume();
+}
+
+void
+C64::seekInputReplay(u64 frame)
+{
+    suspend();
+    inputLog.seek(*this, frame);
+    resume();
+}
+
+void
+C64::stopInputReplay()
+{
+    suspend();
+    inputLog.stopReplay();
+    resume();
+}
+
+C64 *
+C64::fork()
+{
+    assert(!isRunning());
+    
+    C64 *child = new C64();
+    
+    // Adopt the hardware configuration
+    for (auto opt : { OPT_VIC_REVISION, OPT_GRAY_DOT_BUG, OPT_GLUE_LOGIC,
+        OPT_CIA_REVISION, OPT_TIMER_B_BUG, OPT_SID_REVISION, OPT_SID_FILTER,
+        OPT_SID_ENGINE, OPT_SID_SAMPLING, OPT_RAM_PATTERN, OPT_DEBUGCART,
+        OPT_IEC_TURBO, OPT_DATASETTE_TURBO, OPT_HEADLESS, OPT_BOOT_CACHE,
+        OPT_DEBUG_PORT }) {
+        child->configure(opt, getConfigItem(opt));
+    }
+    for (long id = 1; id < 4; id++) {
+        for (auto opt : { OPT_SID_ENABLE, OPT_SID_ADDRESS }) {
+            child->configure(opt, id, getConfigItem(opt, id));
+        }
+    }
+    for (long id = DRIVE8; id <= DRIVE11; id++) {
+        for (auto opt : { OPT_DRIVE_TYPE, OPT_DRIVE_CONNECT,
+            OPT_DRIVE_POWER_SWITCH, OPT_DRIVE_IDLE_SLEEP, OPT_DRIVE_FAST_LOAD }) {
+            child->configure(opt, id, getConfigItem(opt, id));
+        }
+    }
+
+    // Keep the disk data out of the state transfer
+    DiskData disks[DRIVE_COUNT];
+    for (isize i = 0; i < DRIVE_COUNT; i++) {
+        disks[i] = drives[i]->disk.data;
+        drives[i]->disk.data = DiskData();
+    }
+    
+    // Transfer the state (the drive lag isn't part of it)
+    synchronizeDrives();
+    usize size = this->size();
+    u8 *buffer = new u8[size];
+    save(buffer);
+    child->load(buffer);
+    delete[] buffer;
+    
+    // Share the disk data with the new instance
+    for (isize i = 0; i < DRIVE_COUNT; i++) {
+        drives[i]->disk.data = disks[i];
+        child->drives[i]->disk.data = disks[i];
+    }
+    
+    child->rescheduleEvents();
+    
+    return child;
+}
+
+u64
+C64::bootKey() const
+{
+    // Cartridges and custom start-up code take over the boot sequence
+    if (expansionport.getCartridgeAttached()) return 0;
+    
+    u64 key = fnv_1a_it64(fnv_1a_init64(), bootFrames);
+    
+    for (auto type : { ROM_TYPE_BASIC, ROM_TYPE_CHAR, ROM_TYPE_KERNAL, ROM_TYPE_VC1541 }) {
+        key = fnv_1a_it64(key, romFNV64(type));
+    }
+    for (auto opt : { OPT_VIC_REVISION, OPT_GRAY_DOT_BUG, OPT_GLUE_LOGIC,
+        OPT_CIA_REVISION, OPT_TIMER_B_BUG, OPT_SID_REVISION, OPT_SID_FILTER,
+        OPT_SID_ENGINE, OPT_SID_SAMPLING, OPT_RAM_PATTERN, OPT_DEBUGCART }) {
+        key = fnv_1a_it64(key, (u64)getConfigItem(opt));
+    }
+    for (long id = 1; id < 4; id++) {
+        for (auto opt : { OPT_SID_ENABLE, OPT_SID_ADDRESS }) {
+            key = fnv_1a_it64(key, (u64)getConfigItem(opt, id));
+        }
+    }
+    for (long id = DRIVE8; id <= DRIVE11; id++) {
+        for (auto opt : { OPT_DRIVE_TYPE, OPT_DRIVE_CONNECT,
+            OPT_DRIVE_POWER_SWITCH, OPT_DRIVE_IDLE_SLEEP, OPT_DRIVE_FAST_LOAD }) {
+            key = fnv_1a_it64(key, (u64)getConfigItem(opt, id));
+        }
+    }
+    for (const Drive *drive : drives) {
+        
+        // Disk changes take several frames to complete
+        if (drive->hasPartiallyRemovedDisk()) return 0;
+        
+        key = fnv_1a_it64(key, drive->hasDisk());
+        key = fnv_1a_it64(key, drive->hasWriteProtectedDisk());
+    }
+    
+    return key;
+}
+
+void
+C64::boot()
+{
+    assert(!isRunning());
+    
+    u64 key = bootKey();
+    
+    if (key) {
+        
+        if (auto entry = BootCache::lookup(key)) {
+            
+            trace(RUN_DEBUG, "Restoring booted state %llx\n", key);
+            
+            // Keep the inserted disks out of the state transfer
+            std::unique_ptr<Disk> disks[DRIVE_COUNT];
+            for (isize i = 0; i < DRIVE_COUNT; i++) {
+                disks[i] = std::make_unique<Disk>(*this);
+                disks[i]->share(drives[i]->disk);
+            }
+            
+            load((u8 *)entry->state.data());
+            for (isize i = 0; i < DRIVE_COUNT; i++) drives[i]->disk.share(*disks[i]);
+            
+            drivesLag = 0;
+            rescheduleEvents();
+            return;
+        }
+    }
+    
+    // Run the boot sequence
+    HeadlessBudget budget = { };
+    budget.frames = bootFrames;
+    runHeadless(budget);
+    
+    if (key) {
+        
+        // The drive lag isn't part of the state
+        synchronizeDrives();
+        
+        // Keep the disk data out of the cache entry
+        DiskData disks[DRIVE_COUNT];
+        for (isize i = 0; i < DRIVE_COUNT; i++) {
+            disks[i] = drives[i]->disk.data;
+            drives[i]->disk.data = DiskData();
+        }
+        
+        std::vector<u8> state(size());
+        save(state.data());
+        
+        for (isize i = 0; i < DRIVE_COUNT; i++) drives[i]->disk.data = disks[i];
+        
+        BootCache::insert(key, std::move(state));
+    }
+}
+
+void
+C64::startRecording(const char *path)
+{
+    suspend();
+    
+    try {
+        
+        isize height = vic.isPAL() ? Recorder::palHeight : Recorder::ntscHeight;
+        recorder.start(path, height, vic.getFrequency(), vic.getCyclesPerFrame(),
+                       sid.getInternalRate());
+        
+    } catch (VC64Error &exception) { resume(); throw exception; }
+    
+    resume();
+}
+
+void
+C64::startRecording(const char *path, ErrorCode *ec)
+{
+    *ec = ERROR_OK;
+    
+    try { startRecording(path); }
+    catch (VC64Error &exception) { *ec = exception.errorCode; }
+}
+
+void
+C64::stopRecording()
+{
+    suspend();
+    recorder.stop();
+    resume();
+    
+    debug(REC_DEBUG, "Recorder: %llu frames recorded, %llu dropped\n",
+          (unsigned long long)recorder.recorded(), (unsigned long long)recorder.lost());
+}
+
 u32
 C64::romCRC32(RomType type) const
 {
@@ -1351,8 +2347,6 @@ C64::hasRom(RomType type) const
         }
         case ROM_TYPE_VC1541:
         {
-            assert(drive8.mem.rom[0] == drive9.mem.rom[0]);
-            assert(drive8.mem.rom[1] == drive9.mem.rom[1]);
             return (drive8.mem.rom[0] | drive8.mem.rom[1]) != 0x00;
         }
         default: assert(false);
@@ -1420,7 +2414,8 @@ C64::installRom(RomFile *file)
             
         case FILETYPE_BASIC_ROM:
             
-            file->flash(mem.rom, 0xA000);
+            file->flash(mem.modifyRom(), 0xA000);
+            mem.commitRom();
             debug(MEM_DEBUG, "Basic Rom flashed\n");
             debug(MEM_DEBUG, "hasMega65Rom() = %d\n", hasMega65Rom(ROM_TYPE_BASIC));
             debug(MEM_DEBUG, "mega65BasicRev() = %s\n", mega65BasicRev());
@@ -1428,13 +2423,15 @@ C64::installRom(RomFile *file)
             
         case FILETYPE_CHAR_ROM:
             
-            file->flash(mem.rom, 0xD000);
+            file->flash(mem.modifyRom(), 0xD000);
+            mem.commitRom();
             debug(MEM_DEBUG, "Character Rom flashed\n");
             break;
             
         case FILETYPE_KERNAL_ROM:
             
-            file->flash(mem.rom, 0xE000);
+            file->flash(mem.modifyRom(), 0xE000);
+            mem.commitRom();
             debug(MEM_DEBUG, "Kernal Rom flashed\n");
             debug(MEM_DEBUG, "hasMega65Rom() = %d\n", hasMega65Rom(ROM_TYPE_KERNAL));
             debug(MEM_DEBUG, "mega65KernalRev() = %s\n", mega65KernalRev());
@@ -1442,8 +2439,10 @@ C64::installRom(RomFile *file)
             
         case FILETYPE_VC1541_ROM:
             
-            file->flash(drive8.mem.rom);
-            file->flash(drive9.mem.rom);
+            for (auto drive : drives) {
+                file->flash(drive->mem.modifyRom());
+                drive->mem.commitRom();
+            }
             debug(MEM_DEBUG, "VC1541 Rom flashed\n");
             break;
             
@@ -1459,23 +2458,28 @@ C64::deleteRom(RomType type)
             
         case ROM_TYPE_BASIC:
         {
-            memset(mem.rom + 0xA000, 0, 0x2000);
+            memset(mem.modifyRom() + 0xA000, 0, 0x2000);
+            mem.commitRom();
             break;
         }
         case ROM_TYPE_CHAR:
         {
-            memset(mem.rom + 0xD000, 0, 0x1000);
+            memset(mem.modifyRom() + 0xD000, 0, 0x1000);
+            mem.commitRom();
             break;
         }
         case ROM_TYPE_KERNAL:
         {
-            memset(mem.rom + 0xE000, 0, 0x2000);
+            memset(mem.modifyRom() + 0xE000, 0, 0x2000);
+            mem.commitRom();
             break;
         }
         case ROM_TYPE_VC1541:
         {
-            memset(drive8.mem.rom, 0, 0x4000);
-            memset(drive9.mem.rom, 0, 0x4000);
+            for (auto drive : drives) {
+                memset(drive->mem.modifyRom(), 0, 0x4000);
+                drive->mem.commitRom();
+            }
             break;
         }
         default: assert(false);
@@ -1549,20 +2553,25 @@ C64::flash(AnyFile *file)
     switch (file->type()) {
             
         case FILETYPE_BASIC_ROM:
-            file->flash(mem.rom, 0xA000);
+            file->flash(mem.modifyRom(), 0xA000);
+            mem.commitRom();
             break;
             
         case FILETYPE_CHAR_ROM:
-            file->flash(mem.rom, 0xD000);
+            file->flash(mem.modifyRom(), 0xD000);
+            mem.commitRom();
             break;
             
         case FILETYPE_KERNAL_ROM:
-            file->flash(mem.rom, 0xE000);
+            file->flash(mem.modifyRom(), 0xE000);
+            mem.commitRom();
             break;
             
         case FILETYPE_VC1541_ROM:
-            file->flash(drive8.mem.rom);
-            file->flash(drive9.mem.rom);
+            for (auto drive : drives) {
+                file->flash(drive->mem.modifyRom());
+                drive->mem.commitRom();
+            }
             break;
             
         case FILETYPE_V64:
@@ -1598,6 +2607,7 @@ C64::flash(AnyCollection *file, unsigned nr)
             
             size = MIN(size - 2, 0x10000 - addr);
             file->copyItem(nr, mem.ram + addr, size, 2);
+            mem.markDirty(addr, size);
             break;
             
         default:
@@ -1610,6 +2620,96 @@ C64::flash(AnyCollection *file, unsigned nr)
     return result;
 }
 
+bool
+C64::trapLoad()
+{
+    // Only intercept the original Kernal routine (STA $93)
+    if (mem.getPeekSource(0xF4A5) != M_KERNAL) return false;
+    if (mem.rom[0xF4A5] != 0x85 || mem.rom[0xF4A6] != 0x93) return false;
+    
+    // Check if the addressed drive serves files directly
+    u8 device = mem.ram[0xBA];
+    if (!isDriveID(device)) return false;
+    Drive &drive = *drives[device - DRIVE8];
+    if (!drive.getConfigItem(OPT_DRIVE_FAST_LOAD)) return false;
+    if (!drive.isActive() || !drive.hasDisk()) return false;
+
+    // Leave verify operations to the drive
+    if (cpu.reg.a != 0) return false;
+    
+    // Read the file name (the directory is left to the drive, too)
+    u8 name[256];
+    u8 length = mem.ram[0xB7];
+    u16 ptr = LO_HI(mem.ram[0xBB], mem.ram[0xBC]);
+    for (usize i = 0; i < length; i++) name[i] = mem.spypeek((u16)(ptr + i));
+    if (length == 0 || name[0] == '$') return false;
+    
+    // Strip off the drive prefix
+    u8 *pattern = name;
+    for (usize i = 0; i < length && i < 3; i++) {
+        if (name[i] == ':') { pattern = name + i + 1; length -= i + 1; break; }
+    }
+    
+    // Decode the disk
+    ErrorCode err;
+    FSDevice *fs = FSDevice::makeWithDisk(drive.disk, &err);
+    if (!fs) return false;
+    
+    // Search the file
+    usize nr = 0;
+    for (; nr < fs->numFiles(); nr++) {
+        if (fs->fileType(nr) == FS_FILETYPE_PRG &&
+            fs->fileName(nr).matches(pattern, length)) break;
+    }
+    if (nr == fs->numFiles() || fs->fileSize(nr) <= 2) {
+        
+        // Let the drive report the error
+        delete fs;
+        return false;
+    }
+    
+    // Determine the load address (secondary address 0 means relocation)
+    u16 addr = mem.ram[0xB9] ? fs->loadAddr(nr) : LO_HI(mem.ram[0xC3], mem.ram[0xC4]);
+    u64 size = MIN(fs->fileSize(nr) - 2, 0x10000 - addr);
+    u16 end = (u16)(addr + size);
+    
+    trace(DRV_DEBUG, "Fast loading %s to %04X - %04X\n",
+          fs->fileName(nr).c_str(), addr, end);
+    
+    std::vector<u8> buffer(size);
+    fs->copyFile(nr, buffer.data(), size, 2);
+    delete fs;
+    
+    /* Store the file as the serial load routine does (STA ($AE),Y), i.e.,
+     * with the current memory configuration. Bytes falling into the I/O
+     * space reach the chips, and writes to $00 and $01 take effect.
+     */
+    for (usize i = 0; i < size; i++) mem.poke((u16)(addr + i), buffer[i]);
+    
+    // Update the Kernal variables as the serial load routine does
+    mem.ram[0x90] = 0x40;
+    mem.ram[0x93] = 0x00;
+    mem.ram[0xC3] = LO_BYTE(addr);
+    mem.ram[0xC4] = HI_BYTE(addr);
+    mem.ram[0xAE] = LO_BYTE(end);
+    mem.ram[0xAF] = HI_BYTE(end);
+    mem.markDirty(0x0000, 0x100);
+    
+    // Return to the caller with the end address in X and Y (RTS)
+    cpu.reg.x = LO_BYTE(end);
+    cpu.reg.y = HI_BYTE(end);
+    cpu.reg.sr.c = false;
+    u8 lo = mem.ram[0x100 + (u8)(cpu.reg.sp + 1)];
+    u8 hi = mem.ram[0x100 + (u8)(cpu.reg.sp + 2)];
+    cpu.reg.sp += 2;
+    cpu.reg.pc = cpu.reg.pc0 = (u16)(LO_HI(lo, hi) + 1);
+    
+    // The RAM has been modified behind the back of the undo journal
+    if (journal.isRecording()) journal.recordIO();
+    
+    return true;
+}
+
 bool
 C64::flash(const FSDevice &fs, usize nr)
 {
@@ -1623,6 +2723,7 @@ C64::flash(const FSDevice &fs, usize nr)
                 
     size = MIN(size - 2, 0x10000 - addr);
     fs.copyFile(nr, mem.ram + addr, size, 2);
+    mem.markDirty(addr, size);
 
     resume();
     
@@ -12,7 +12,22 @@
 // General
 #include "C64Component.h"
 #include "Serialization.h"
+#include "Arena.h"
 #include "MsgQueue.h"
+#include "Recorder.h"
+#include "InputLog.h"
+#include "RewindBuffer.h"
+#include "SnapshotWriter.h"
+#include "FrameWriter.h"
+#include "Streamer.h"
+#include "BootCache.h"
+#include "RunAhead.h"
+#include "Netplay.h"
+#include "Fuzzer.h"
+#include "UndoJournal.h"
+#include "Profiler.h"
+#include "PerfMonitor.h"
+#include "Signposts.h"
 
 // Configuration items
 #include "C64Config.h"
@@ -35,9 +50,14 @@
 
 // Sub components
 #include "ExpansionPort.h"
+#include "DebugPort.h"
+#include "Reu.h"
 #include "IEC.h"
 #include "Keyboard.h"
 #include "ControlPort.h"
+#include "InputQueue.h"
+#include "CmdQueue.h"
+#include "MediaLoader.h"
 #include "C64Memory.h"
 #include "DriveMemory.h"
 #include "FlashRom.h"
@@ -54,6 +74,7 @@
 
 // Peripherals
 #include "Drive.h"
+#include "DriveSpeculator.h"
 #include "Datasette.h"
 #include "Mouse.h"
 
@@ -67,8 +88,17 @@
  */
 class C64 : public HardwareComponent {
         
-    // The currently set inspection target (only evaluated in debug mode)
+    /* The currently set inspection target. While the emulator is running, the
+     * target is inspected at the end of each frame and the results are
+     * published to the GUI (see InfoRecord).
+     */
     InspectionTarget inspectionTarget;
+    
+    /* Status information read by the GUI in each frame. The status is
+     * published at the end of each frame and whenever the emulator pauses.
+     */
+    InfoRecord<C64Status> status;
+    u64 statusVersion = 0;
 
     
     //
@@ -96,12 +126,26 @@ public:
     ControlPort port2 = ControlPort(*this, PORT_TWO);
     ExpansionPort expansionport = ExpansionPort(*this);
     
+    // Timeline of injected input events
+    InputQueue inputs = InputQueue(*this);
+    
+    // State changes requested by the host
+    CmdQueue commands = CmdQueue(*this);
+    
+    // Loads Roms, disks, and cartridges in the background
+    MediaLoader loader = MediaLoader(*this);
+    
     // Bus connecting the VC1541 floppy drives
     IEC iec = IEC(*this);
     
     // Floppy drives
     Drive drive8 = Drive(DRIVE8, *this);
     Drive drive9 = Drive(DRIVE9, *this);
+    Drive drive10 = Drive(DRIVE10, *this);
+    Drive drive11 = Drive(DRIVE11, *this);
+    
+    // All floppy drives (indexed by the device number minus 8)
+    Drive *const drives[DRIVE_COUNT] = { &drive8, &drive9, &drive10, &drive11 };
     
     // Datasette
     Datasette datasette = Datasette(*this);
@@ -111,6 +155,48 @@ public:
      */
     MsgQueue messageQueue;
 
+    // Video recorder
+    Recorder recorder;
+
+    // History of recent emulator states
+    RewindBuffer rewindBuffer;
+
+    // Background writer for autosaved snapshots
+    SnapshotWriter snapshotWriter;
+
+    // Background writer for dumped frames
+    FrameWriter frameWriter;
+
+    // Encoder for remote sessions
+    Streamer streamer;
+
+    // Recorder and player for input sessions
+    InputLog inputLog;
+    
+    // Channel for reporting test results to the host
+    DebugPort debugPort;
+    
+    // Emulates frames ahead of time to reduce the input latency
+    RunAhead runAhead;
+    
+    // Lockstep session with a remote emulator
+    Netplay netplay;
+    
+    // Harness for coverage-guided fuzzing
+    Fuzzer fuzzer;
+    
+    // Lets the debugger step backwards
+    UndoJournal journal;
+    
+    // Attributes the host time to the emulated components
+    Profiler profiler;
+    
+    // Samples the host-side performance counters
+    PerfMonitor perfMonitor;
+
+    // Executes a single active drive ahead of time on a helper thread
+    DriveSpeculator speculator;
+    
     
     //
     // Frame, rasterline, and rasterline cycle information
@@ -130,11 +216,11 @@ public:
      */
     u8 rasterCycle;
     
-    // Clock frequency
-    u32 frequency;
+    // Clock frequency (a PAL machine is assumed until a model is configured)
+    u32 frequency = PAL_CLOCK_FREQUENCY;
     
     // Duration of a CPU cycle in 1/10 nano seconds
-    u64 durationOfOneCycle;
+    u64 durationOfOneCycle = 10000000000 / PAL_CLOCK_FREQUENCY;
     
     /* The VICII function table. Each entry in this table is a pointer to a
      * VICII method executed in a certain rasterline cycle. vicfunc[0] is a
@@ -142,6 +228,33 @@ public:
      */
     void (VICII::*vicfunc[66])(void);
     
+    /* The cycle of the next pending event. The VICII and the CPU are executed
+     * in every cycle. All other components (CIAs, IEC bus, drives, datasette)
+     * are only serviced once the CPU cycle has reached this value. The value
+     * is the minimum of the next-event cycles of all these components and
+     * recomputed in each serviced cycle. Components reset it to 0 by calling
+     * rescheduleEvents() whenever they leave an idle state.
+     */
+    Cycle nextEvent = 0;
+    
+    /* Time that has passed since the drives have been executed the last time.
+     * If only a single drive is active, the drive lags behind the C64 and is
+     * caught up lazily whenever the C64 interacts with the IEC bus and at the
+     * end of each rasterline. The lag isn't part of the emulator state. Code
+     * that takes a state catches up the drives first.
+     */
+    u64 drivesLag = 0;
+    
+    /* Bit mask of the active drives (bit n = device 8 + n). Only these drives
+     * are executed. Idle slots therefore cost nothing.
+     */
+    u8 activeDrives = 0;
+    
+    /* The cartridge that currently performs a DMA transfer. If set, it is
+     * executed instead of the CPU in the second clock phase.
+     */
+    REU *dma = nullptr;
+    
     
     //
     // Emulator thread
@@ -153,9 +266,24 @@ private:
      * iteration. Most of the time, the variable is 0 which causes the runloop
      * to repeat. A value greater than 0 means that one or more runloop control
      * flags are set. These flags are flags processed and the loop either
-     * repeats or terminates depending on the provided flags.
+     * repeats or terminates depending on the provided flags. The variable is
+     * read without synchronization inside the run loop and updated with
+     * atomic read-modify-write operations from any thread.
      */
-    u32 runLoopCtrl = 0;
+    std::atomic<u32> runLoopCtrl { 0 };
+    
+    /* Flags that are handled in the cycle they are raised in. All of them are
+     * raised by the emulator thread itself. All other flags are requested by
+     * the host and handled at the end of the current rasterline.
+     */
+    static constexpr u32 cycleFlags =
+    ACTION_FLAG_CPU_JAMMED |
+    ACTION_FLAG_EXTERNAL_NMI |
+    ACTION_FLAG_BREAKPOINT |
+    ACTION_FLAG_WATCHPOINT |
+    ACTION_FLAG_INPUT_SYNC |
+    ACTION_FLAG_EXIT_ADDR |
+    ACTION_FLAG_GUEST_EXIT;
     
     /* Stop request. This variable is used to signal a stop request coming from
      * the GUI. The variable is checked after each frame.
@@ -165,11 +293,22 @@ private:
     // The invocation counter for implementing suspend() / resume()
     unsigned suspendCounter = 0;
     
-    // The emulator thread
+    /* The emulator thread. The thread is launched when the emulator runs for
+     * the first time and lives as long as the emulator. Whenever the emulator
+     * is paused or suspended, the thread leaves the run loop and waits for the
+     * next run request.
+     */
     pthread_t p = (pthread_t)0;
     
-    // Mutex to coordinate the order of execution
+    // Indicates if the emulator thread executes the run loop
+    bool threadActive = false;
+    
+    // Indicates if the emulator thread is requested to terminate
+    bool threadQuit = false;
+    
+    // Mutex and condition variable to hand over the emulator between threads
     pthread_mutex_t threadLock;
+    pthread_cond_t threadCond;
     
     /* Mutex to synchronize the access to all state changing methods such as
      * run(), pause(), etc.
@@ -188,6 +327,35 @@ private:
      */
     bool ultimax;
     
+    /* Indicates whether the emulator runs headless. In headless mode, SIDBridge
+     * skips audio mixing, VICII keeps drawing into the same texture, and the
+     * oscillator doesn't synchronize with the host clock. The mode is meant
+     * for batch runs initiated via runHeadless().
+     */
+    bool headless = false;
+    
+    /* Number of frames emulated by powerOn() to boot the machine (0 = off).
+     * If set, the booted state is taken from the boot cache or stored there
+     * after the frames have been emulated (see BootCache).
+     */
+    u64 bootFrames = 0;
+    
+    /* Scheduling parameters of the emulator thread and the helper threads
+     * (SID workers and the snapshot writer). The emulator thread applies its
+     * policy when it enters the run loop. Helper threads apply their policy
+     * before they process the next job.
+     */
+    ThreadPolicy threadPolicy[THREAD_ROLE_COUNT];
+    bool threadPolicyChanged = false;
+    
+    /* Indicates whether a batch of configuration items is being applied. In
+     * this case, the components postpone expensive rebuilds (the VICII
+     * function table and the SID sampling parameters) until all items have
+     * been applied.
+     */
+    bool batching = false;
+    bool vicFunctionTableDirty = false;
+    
     
     //
     // Snapshot storage
@@ -207,6 +375,18 @@ public:
     C64();
     ~C64();
     const char *getDescription() const override { return "C64"; }
+
+    // Instances are taken from the arena pool (see Arena)
+    static void *operator new(size_t size) { return Arena::allocate(size); }
+    static void operator delete(void *ptr) { Arena::deallocate(ptr); }
+
+    /* Creates an instance on a certain set of cores. The instance is
+     * constructed on a temporary thread bound to these cores. Hence, on NUMA
+     * systems, all memory touched during construction is placed on the node
+     * of these cores. The emulator thread and the helper threads are bound to
+     * the same cores.
+     */
+    static C64 *makeOnCores(u64 cores);
     void prefix() const override;
 
     void reset();
@@ -233,6 +413,19 @@ public:
     bool configure(Option option, long value);
     bool configure(Option option, long id, long value);
 
+    /* Sets multiple configuration items at once. All items are checked first.
+     * If one of them is invalid, the configuration stays untouched. Otherwise,
+     * the items are applied in a single suspension and each expensive rebuild
+     * is carried out at most once.
+     */
+    ErrorCode configure(const ConfigItem *items, usize count);
+    
+    // Checks if a configuration item can be applied
+    bool isValidConfigItem(const ConfigItem &item) const;
+    
+    // Indicates if a batch of configuration items is being applied
+    bool isBatching() const { return batching; }
+
     // Configures the C64 to match a specific C64 model
     void configure(C64Model model);
 
@@ -244,7 +437,11 @@ public:
 
 private:
 
+    // Installs the cycle functions of a certain VICII variant
+    template <VICIIMode flags> void assignVicFunctions();
+
     bool setConfigItem(Option option, long value) override;
+    bool setConfigItem(Option option, long id, long value) override;
 
     
     //
@@ -253,13 +450,23 @@ private:
     
 public:
        
+    /* Inspects the current inspection target. While the emulator is running,
+     * calls from outside the emulator thread are ignored, because the target
+     * is inspected at the end of each frame anyway.
+     */
     void inspect();
     InspectionTarget getInspectionTarget() const;
     void setInspectionTarget(InspectionTarget target);
     void clearInspectionTarget() { setInspectionTarget(INSPECTION_TARGET_NONE); }
     
+    // Returns the most recently published status (callable from any thread)
+    C64Status getStatus() const { return status.read(); }
+    
 private:
     
+    // Collects the status information and publishes it to the GUI
+    void publishStatus();
+    
     void _dump() const override;
 
     
@@ -292,8 +499,11 @@ private:
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
+    void _memoryUsage(MemoryUsage &usage) override;
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
     
     
     //
@@ -307,12 +517,34 @@ public:
     void run();
     void pause();
     
+    /* Switches warp mode on or off (emulator thread). While an input log is
+     * recorded, the change is recorded, too. setWarpNow() switches without
+     * recording and is called when a recorded change is replayed.
+     */
     void setWarp(bool enable);
+    void setWarpNow(bool enable) { HardwareComponent::setWarp(enable); }
     bool inWarpMode() const { return warpMode; }
 
     void setDebug(bool enable);
     bool inDebugMode() const { return debugMode; }
     
+    bool isHeadless() const { return headless; }
+    
+    /* Indicates if the host's keyboard, joystick, and mouse events are handed
+     * over to the input queue instead of being applied immediately. This is
+     * the case while the emulator thread is running, while an input log is
+     * recorded, or while frames are emulated ahead of time. The queue is
+     * lock-free and checked at the end of each rasterline. Hence, the host
+     * never waits for the emulator thread and vice versa.
+     */
+    bool queuesHostInput() const;
+    
+    /* Indicates if the host's keyboard, joystick, and mouse events are
+     * discarded. This is the case while an input log is replayed, because
+     * the recorded events must not be mixed with new ones.
+     */
+    bool dropsHostInput() const;
+    
 private:
 
     void _powerOn() override;
@@ -329,12 +561,14 @@ private:
 
 public:
     
-    /* Requests the emulator thread to stop and locks the threadLock.
-     * The function is called in all state changing methods to obtain ownership
-     * of the emulator thread. After returning, the emulator is either powered
-     * off (if it was powered off before) or paused (if it was running before).
+    /* Requests the emulator thread to leave the run loop and waits until it
+     * is parked. The function is called in all state changing methods to
+     * obtain ownership of the emulator. After returning, the emulator is
+     * either powered off (if it was powered off before) or paused (if it was
+     * running before). The thread stops at the end of the current frame or,
+     * if frameEnd is false, at the end of the current rasterline.
      */
-    void acquireThreadLock();
+    void acquireThreadLock(bool frameEnd = true);
     
     /* Returns true if a call to powerOn() will be successful.
      * It returns false, e.g., if no Rom is installed.
@@ -364,6 +598,32 @@ public:
     // Feeds a notification message into message queue
     void putMessage(MsgType msg, u64 data = 0) { messageQueue.put(msg, data); }
     
+    /* Selects how messages are propagated to the listeners. In asynchronous
+     * mode, listener callbacks never run on the emulator thread.
+     */
+    void setMessageDelivery(MsgQueue::Delivery mode) { messageQueue.setDelivery(mode); }
+    
+    // Propagates all pending messages (poll mode)
+    isize dispatchMessages() { return messageQueue.dispatch(); }
+    
+    
+    //
+    // Issuing commands
+    //
+    
+    /* Requests a state change. While the emulator is running, the command is
+     * executed by the emulator thread at the end of the current rasterline.
+     * Otherwise, it is executed right away.
+     */
+    void issue(const Cmd &cmd);
+    void issue(CmdType type, long value = 0) { issue(Cmd { type, 0, 0, value, nullptr }); }
+    
+    /* Hands a command over to the emulator thread (any thread). Unlike
+     * issue(), the function never executes the command on the calling thread.
+     * It returns false if the emulator isn't running.
+     */
+    bool enqueue(const Cmd &cmd);
+    
     
  
     
@@ -378,6 +638,12 @@ public:
      * accessible by the emulator thread.
      */
     void threadDidTerminate();
+    
+    /* The thread's main loop. The thread waits until the emulator is requested
+     * to run, executes the run loop, and parks again once the run loop has
+     * been left.
+     */
+    void threadLoop();
         
     /* The C64 run loop.
      * This function is one of the most prominent ones. It implements the
@@ -405,6 +671,12 @@ public:
      */
     void stepOver();
     
+    /* Undoes the specified number of instructions (see UndoJournal). This
+     * function is used for stepping backwards inside the debugger. It
+     * returns false if the undo journal doesn't reach back far enough.
+     */
+    bool stepBack(isize count);
+    
     /* Emulates the C64 until the end of the current frame. Under certain
      * circumstances the function may terminate earlier, in the middle of a
      * frame. This happens, e.g., if the CPU jams or a breakpoint is reached.
@@ -413,15 +685,55 @@ public:
      */
     void executeOneFrame();
     
+    /* Emulates the configured number of frames ahead of time and restores the
+     * current state afterwards (see RunAhead). The function is called by the
+     * run loop after a frame has been completed.
+     */
+    void executeFramesAhead();
+    
     /* Emulates the C64 until the end of the current rasterline. This function
-     * is called inside executeOneFrame().
+     * is called inside executeOneFrame(). It returns early if one of the
+     * cycle flags (see cycleFlags) has been raised. If the profiler is
+     * enabled, the rasterlines picked by the profiler are emulated by the
+     * profiling variant of the run loop.
      */
     void executeOneLine();
+    template <bool profile> void _executeOneLine();
     
     // Executes a single clock cycle
     void executeOneCycle();
-    void _executeOneCycle();
+    template <bool profile = false> void _executeOneCycle();
+
+    // Forces the components outside the VICII and the CPU to be serviced
+    void rescheduleEvents() { nextEvent = 0; }
 
+    // Catches up the drives with the C64
+    void synchronizeDrives();
+    
+    // Recomputes the bit mask of active drives (called by the drives)
+    void updateActiveDrives();
+    
+    /* Prepares the IEC bus for being read by the C64. A drive executed ahead
+     * of time is only caught up if it has changed the bus in the meantime.
+     */
+    void observeDrives();
+
+    /* Emulates the C64 on the calling thread until a termination condition
+     * is met. The function is meant for batch runs. It doesn't require an
+     * emulator thread and must only be called on a paused emulator. The run
+     * terminates when the frame or cycle budget is exhausted, the memory
+     * pattern stored in the budget shows up, the CPU reaches the exit
+     * address, the predicate is met, the CPU jams, or a breakpoint is hit.
+     */
+    HeadlessExit runHeadless(const HeadlessBudget &budget);
+    
+    /* Emulates a single cycle on the calling thread. The function is used to
+     * run multiple instances in lockstep (see C64Link) and must only be called
+     * on a paused emulator. It returns true if the run needs to terminate and
+     * stores the reason in 'exit'.
+     */
+    bool executeLinkedCycle(HeadlessExit &exit);
+    
     /* Finishes the current instruction. This function is called when the
      * emulator threads terminates in order to reach a clean state. It emulates
      * the CPU until the next fetch cycle is reached.
@@ -434,11 +746,25 @@ private:
     void beginRasterLine();
     
     // Invoked after executing the last cycle of a rasterline
-    void endRasterLine();
+    template <bool profile = false> void endRasterLine();
+    
+    // Computes the cycle in which the next component needs to be serviced
+    void scheduleNextEvent(Cycle cycle);
     
     // Invoked after executing the last rasterline of a frame
     void endFrame();
     
+    // Work horse for runHeadless()
+    HeadlessExit executeHeadless(const HeadlessBudget &budget);
+    
+    /* Processes the run loop control flags of a headless run. The function
+     * returns true if the run needs to terminate.
+     */
+    bool serviceHeadlessFlags(HeadlessExit &exit);
+    
+    // Checks if the memory pattern of a headless budget is present
+    bool matchesPattern(const HeadlessBudget &budget) const;
+    
     
     //
     // Managing the emulator thread
@@ -461,11 +787,16 @@ public:
      *           do something with the internal state;
      *           resume();
      *
-     * It it safe to nest multiple suspend() / resume() blocks.
+     * It it safe to nest multiple suspend() / resume() blocks. Both functions
+     * have no effect when called by the emulator thread, which is the case
+     * when a command is executed (see CmdQueue).
      */
     void suspend();
     void resume();
     
+    // Checks if the calling thread is the emulator thread
+    bool isEmulatorThread() const { return pthread_equal(pthread_self(), p); }
+    
     /* Sets or clears a run loop control flag. The functions are thread-safe
      * and can be called from inside or outside the emulator thread.
      */
@@ -475,11 +806,15 @@ public:
     // Convenience wrappers for controlling the run loop
     void signalAutoSnapshot() { setActionFlags(ACTION_FLAG_AUTO_SNAPSHOT); }
     void signalUserSnapshot() { setActionFlags(ACTION_FLAG_USER_SNAPSHOT); }
+    void signalAutoSave() { setActionFlags(ACTION_FLAG_AUTO_SAVE); }
+    void signalInputSync() { setActionFlags(ACTION_FLAG_INPUT_SYNC); }
     void signalBreakpoint() { setActionFlags(ACTION_FLAG_BREAKPOINT); }
     void signalWatchpoint() { setActionFlags(ACTION_FLAG_WATCHPOINT); }
     void signalInspect() { setActionFlags(ACTION_FLAG_INSPECT); }
     void signalJammed() { setActionFlags(ACTION_FLAG_CPU_JAMMED); }
     void signalStop() { setActionFlags(ACTION_FLAG_STOP); }
+    void signalExitAddr() { setActionFlags(ACTION_FLAG_EXIT_ADDR); }
+    void signalGuestExit() { setActionFlags(ACTION_FLAG_GUEST_EXIT); }
     void signalExpPortNmi() { setActionFlags(ACTION_FLAG_EXTERNAL_NMI); }
 
     //
@@ -500,10 +835,71 @@ public:
     Snapshot *latestAutoSnapshot();
     Snapshot *latestUserSnapshot();
     
+    /* Requests a snapshot to be saved to the file specified in the snapshot
+     * writer. The snapshot is compressed and written in the background.
+     */
+    void requestAutoSave();
+    
     /* Loads the current state from a snapshot file. This function is not
      * thread-safe and must not be called on a running emulator.
      */
     bool loadFromSnapshot(Snapshot *snapshot);
+
+    /* Rewinds the emulator to a state recorded by the rewind buffer. All
+     * newer states in the buffer are discarded.
+     */
+    bool loadFromRewindBuffer(isize nr);
+
+    /* Starts or stops recording an input log (see InputLog). The recording
+     * starts with the current emulator state.
+     */
+    void startInputRecording(isize checkpointInterval = 250);
+    void stopInputRecording();
+
+    /* Replays the input log from the beginning or from the specified frame.
+     * Seeking emulates all frames between the nearest recorded state and the
+     * target frame before returning.
+     */
+    void startInputReplay();
+    void seekInputReplay(u64 frame);
+    void stopInputReplay();
+    
+    /* Creates a new emulator instance in the same state as this one. The
+     * state is transferred directly without creating a snapshot. Inserted
+     * disks are not copied. Their halftracks are shared with the new instance
+     * and copied on the first write. The new instance adopts the hardware
+     * configuration of this instance. This function must not be called on a
+     * running emulator.
+     */
+    C64 *fork();
+    
+private:
+    
+    /* Computes the boot cache key. It covers the Roms, the hardware
+     * configuration, the drive setup, and the number of boot frames. The
+     * function returns 0 if the boot sequence can't be cached, e.g., because
+     * a cartridge is attached.
+     */
+    u64 bootKey() const;
+    
+    /* Boots the machine by emulating the configured number of frames or by
+     * restoring the result from the boot cache. Inserted disks are kept.
+     */
+    void boot();
+    
+public:
+    
+    
+    //
+    // Recording videos
+    //
+    
+public:
+    
+    // Starts or stops recording a video
+    void startRecording(const char *path) throws;
+    void startRecording(const char *path, ErrorCode *ec);
+    void stopRecording();
     
     
     //
@@ -561,6 +957,15 @@ public:
     bool flash(AnyCollection *file, unsigned item);
     bool flash(const FSDevice &fs, usize item);
     
+    /* Intercepts the Kernal's LOAD routine. The function is called when the
+     * CPU is about to execute the instruction at $F4A5, which is reached via
+     * the LOAD vector. If fast loading is enabled for the addressed drive and
+     * the file is found on the inserted disk, it is copied into memory and
+     * the routine is left as if the Kernal had loaded it over the serial bus.
+     * Otherwise, false is returned and the Kernal proceeds as usual.
+     */
+    bool trapLoad();
+    
     //
     // Set and query ultimax mode
     //
@@ -16,12 +16,15 @@
 // Snapshot version number
 #define V_MAJOR 4
 #define V_MINOR 0
-#define V_SUBMINOR 3
+#define V_SUBMINOR 4
 
 // Uncomment these settings in a release build
 #define RELEASEBUILD
 // #define NDEBUG
 
+// Uncomment to make the debug channels switchable at runtime
+// #define RUNTIME_TRACING
+
 //
 // Configuration overrides
 //
@@ -29,55 +32,85 @@
 // Uncomment to override a configuration setting
 // EMPTY LIST SO FAR
 
+//
+// Performance settings
+//
+
+// Comment out to dispatch CPU micro-instructions with a switch statement. Both
+// variants can be compared with the IDLE and TAPE workloads of vc64_benchmark().
+#define CPU_THREADED_DISPATCH
+
+// Uncomment to execute quiet drive CPU instructions in one step (see Drive.cpp)
+// #define DRIVE_FAST_PATH
+
+// Comment out to remove the signposts for external profilers (see Signposts.h)
+#define SIGNPOSTS
+
 //
 // Debug settings
 //
 
+/* By default, all debug channels are compile-time constants. Channels set to 0
+ * remove the associated debug() and trace() calls from the binary, and
+ * defining NDEBUG removes all of them. If RUNTIME_TRACING is defined, each
+ * channel is a variable initialized with the value given below. It can be
+ * changed while the emulator runs by calling setDebugChannel().
+ */
+#if defined(RUNTIME_TRACING) && defined(DEBUG_CHANNEL_DEFINITION)
+#define DEBUG_CHANNEL(name, value) DEBUG_CHANNEL_DEFINITION(name, value)
+#elif defined(RUNTIME_TRACING)
+#define DEBUG_CHANNEL(name, value) extern int name
+#else
+#define DEBUG_CHANNEL(name, value) static const int name = value
+#endif
+
 // General
-static const int CNF_DEBUG       = 0; // Configuration
-static const int XFILES          = 0; // Report paranormal activity
+DEBUG_CHANNEL(CNF_DEBUG, 0);            // Configuration
+DEBUG_CHANNEL(XFILES, 0);               // Report paranormal activity
 
 // Runloop
-static const int RUN_DEBUG       = 0; // Run loop, component states, timing
-static const int QUEUE_DEBUG     = 0; // Message queue
-static const int TIM_DEBUG       = 0; // Timing (thread synchronization)
-static const int SNP_DEBUG       = 0; // Serializing (snapshots)
+DEBUG_CHANNEL(RUN_DEBUG, 0);            // Run loop, component states, timing
+DEBUG_CHANNEL(QUEUE_DEBUG, 0);          // Message queue
+DEBUG_CHANNEL(TIM_DEBUG, 0);            // Timing (thread synchronization)
+DEBUG_CHANNEL(SNP_DEBUG, 0);            // Serializing (snapshots)
 
 // CPU
-static const int CPU_DEBUG       = 0; // CPU
-static const int IRQ_DEBUG       = 0; // Interrupts
+DEBUG_CHANNEL(CPU_DEBUG, 0);            // CPU
+DEBUG_CHANNEL(IRQ_DEBUG, 0);            // Interrupts
 
 // Memory
-static const int MEM_DEBUG       = 0; // RAM, ROM
+DEBUG_CHANNEL(MEM_DEBUG, 0);            // RAM, ROM
 
 // CIAs
-static const int CIA_DEBUG       = 0; // Complex Interface Adapter
-static const int CIA_ON_STEROIDS = 0; // Keep the CIAs awake all the time
+DEBUG_CHANNEL(CIA_DEBUG, 0);            // Complex Interface Adapter
+static const int CIA_ON_STEROIDS = 0;    // Keep the CIAs awake all the time
 
 // Custom chips
-static const int VIA_DEBUG       = 0; // Versatile Interface Adapter
-static const int VIC_DEBUG       = 0; // Video Interface Controller
-static const int SID_DEBUG       = 0; // Sound Interface Device
-static const int SID_EXEC        = 0; // Sound Interface Device (execution)
-static const int IEC_DEBUG       = 0; // IEC bus
+DEBUG_CHANNEL(VIA_DEBUG, 0);            // Versatile Interface Adapter
+DEBUG_CHANNEL(VIC_DEBUG, 0);            // Video Interface Controller
+DEBUG_CHANNEL(SID_DEBUG, 0);            // Sound Interface Device
+DEBUG_CHANNEL(SID_EXEC, 0);             // Sound Interface Device (execution)
+DEBUG_CHANNEL(IEC_DEBUG, 0);            // IEC bus
 
 // Drive
-static const int DSK_DEBUG       = 0; // Disk controller execution
-static const int DSKCHG_DEBUG    = 0; // Disk changing procedure
-static const int GCR_DEBUG       = 0; // Disk encoding / decoding
-static const int FS_DEBUG        = 0; // File System Classes
+DEBUG_CHANNEL(DSK_DEBUG, 0);            // Disk controller execution
+DEBUG_CHANNEL(DSKCHG_DEBUG, 0);         // Disk changing procedure
+DEBUG_CHANNEL(GCR_DEBUG, 0);            // Disk encoding / decoding
+DEBUG_CHANNEL(FS_DEBUG, 0);             // File System Classes
 
 // Media
-static const int CRT_DEBUG       = 0; // Cartridges
-static const int FILE_DEBUG      = 0; // Media files (D64,T64,...)
+DEBUG_CHANNEL(CRT_DEBUG, 0);            // Cartridges
+DEBUG_CHANNEL(FILE_DEBUG, 0);           // Media files (D64,T64,...)
+DEBUG_CHANNEL(REC_DEBUG, 0);            // Video recorder
 
 // Peripherals
-static const int JOY_DEBUG       = 0; // Joystick
-static const int DRV_DEBUG       = 0; // Floppy drive
-static const int TAP_DEBUG       = 0; // Datasette
-static const int KBD_DEBUG       = 0; // Keyboard
-static const int PORT_DEBUG      = 0; // Control ports and connected devices
-static const int EXP_DEBUG       = 0; // Expansion port
+DEBUG_CHANNEL(JOY_DEBUG, 0);            // Joystick
+DEBUG_CHANNEL(DRV_DEBUG, 0);            // Floppy drive
+static const int DRV_LOCKSTEP = 0;       // Verify the fast path of the drive CPU
+DEBUG_CHANNEL(TAP_DEBUG, 0);            // Datasette
+DEBUG_CHANNEL(KBD_DEBUG, 0);            // Keyboard
+DEBUG_CHANNEL(PORT_DEBUG, 0);           // Control ports and connected devices
+DEBUG_CHANNEL(EXP_DEBUG, 0);            // Expansion port
 
 
 //
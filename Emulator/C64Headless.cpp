@@ -0,0 +1,961 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64Headless.h"
+#include "C64.h"
+#include "BatchCPU.h"
+#include "C64Link.h"
+#include "MediaIndex.h"
+#include "CRTValidator.h"
+#include "Benchmark.h"
+#include "CoreBenchmark.h"
+#include "CPUDiff.h"
+#include "JobRunner.h"
+
+/* reSID sets up some of its lookup tables when the first instance is created.
+ * Because this is not thread-safe, emulator construction is serialized.
+ */
+static Mutex constructionLock;
+
+C64 *
+vc64_new()
+{
+    AutoMutex lock(constructionLock);
+    
+    C64 *c64 = new C64();
+    c64->configure(OPT_HEADLESS, true);
+    
+    return c64;
+}
+
+C64 *
+vc64_new_on_cores(unsigned long long cores)
+{
+    AutoMutex lock(constructionLock);
+    
+    C64 *c64 = C64::makeOnCores(cores);
+    c64->configure(OPT_HEADLESS, true);
+    
+    return c64;
+}
+
+C64 *
+vc64_fork(C64 *c64)
+{
+    AutoMutex lock(constructionLock);
+    
+    return c64->fork();
+}
+
+void
+vc64_delete(C64 *c64)
+{
+    delete c64;
+}
+
+ErrorCode
+vc64_configure(C64 *c64, const ConfigItem *items, long count)
+{
+    if (count < 0) return ERROR_OPT_INV_ARG;
+    
+    return c64->configure(items, (usize)count);
+}
+
+ErrorCode
+vc64_load_rom(C64 *c64, const char *path)
+{
+    ErrorCode err;
+    
+    RomFile *file = AnyFile::make <RomFile> (string(path), &err);
+    if (!file) return err;
+    
+    c64->installRom(file);
+    delete file;
+    
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_insert_disk(C64 *c64, long nr, const char *path)
+{
+    if (!isDriveID(nr)) return ERROR_OPT_INV_ARG;
+    
+    ErrorCode err;
+    Drive &drive = *c64->drives[nr - DRIVE8];
+    
+    if (G64File::isCompatibleName(path)) {
+        
+        G64File *g64 = AnyFile::map <G64File> (string(path), &err);
+        if (!g64) return err;
+        
+        drive.insertG64(g64);
+        delete g64;
+        
+    } else {
+        
+        D64File *d64 = AnyFile::map <D64File> (string(path), &err);
+        if (!d64) return err;
+        
+        Disk *disk = Disk::makeWithD64(*c64, *d64, &err);
+        delete d64;
+        if (!disk) return err;
+        
+        drive.insertDisk(disk);
+    }
+    
+    c64->configure(OPT_DRIVE_CONNECT, nr, true);
+    return ERROR_OK;
+}
+
+void
+vc64_load_rom_async(C64 *c64, const char *path)
+{
+    c64->loader.loadRom(string(path));
+}
+
+ErrorCode
+vc64_insert_disk_async(C64 *c64, long nr, const char *path)
+{
+    if (!isDriveID(nr)) return ERROR_OPT_INV_ARG;
+    
+    c64->loader.insertDisk(string(path), nr);
+    c64->configure(OPT_DRIVE_CONNECT, nr, true);
+    return ERROR_OK;
+}
+
+void
+vc64_attach_cartridge_async(C64 *c64, const char *path, int reset)
+{
+    c64->loader.attachCartridge(string(path), reset != 0);
+}
+
+long
+vc64_wait_media(C64 *c64)
+{
+    return (long)c64->loader.wait();
+}
+
+ErrorCode
+vc64_set_fast_load(C64 *c64, long nr, int enable)
+{
+    if (!isDriveID(nr)) return ERROR_OPT_INV_ARG;
+    
+    c64->configure(OPT_DRIVE_FAST_LOAD, nr, enable != 0);
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_insert_tape(C64 *c64, const char *path)
+{
+    ErrorCode err;
+    
+    TAPFile *tap = AnyFile::make <TAPFile> (string(path), &err);
+    if (!tap) return err;
+    
+    c64->datasette.insertTape(tap);
+    c64->datasette.pressPlay();
+    delete tap;
+    
+    return ERROR_OK;
+}
+
+void
+vc64_set_drive_turbo(C64 *c64, int enable)
+{
+    c64->configure(OPT_IEC_TURBO, enable != 0);
+}
+
+void
+vc64_set_tape_turbo(C64 *c64, int enable)
+{
+    c64->configure(OPT_DATASETTE_TURBO, enable != 0);
+}
+
+ErrorCode
+vc64_flash_file(C64 *c64, const char *path)
+{
+    ErrorCode err = ERROR_FILE_TYPE_MISMATCH;
+    AnyCollection *file = nullptr;
+    
+    if (PRGFile::isCompatibleName(path)) {
+        file = AnyFile::make <PRGFile> (string(path), &err);
+    } else if (P00File::isCompatibleName(path)) {
+        file = AnyFile::make <P00File> (string(path), &err);
+    } else if (T64File::isCompatibleName(path)) {
+        file = AnyFile::make <T64File> (string(path), &err);
+    }
+    if (!file) return err;
+    
+    c64->flash(file, 0);
+    delete file;
+    
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_power_on(C64 *c64)
+{
+    ErrorCode err;
+    
+    if (!c64->isReady(&err)) return err;
+    
+    c64->powerOn();
+    return ERROR_OK;
+}
+
+void
+vc64_set_boot_cache(C64 *c64, long frames)
+{
+    c64->configure(OPT_BOOT_CACHE, frames);
+}
+
+ErrorCode
+vc64_load_snapshot(C64 *c64, const char *path)
+{
+    ErrorCode err;
+    
+    Snapshot *snapshot = Snapshot::makeWithMappedFile(string(path), &err);
+    if (!snapshot) return err;
+    
+    if (snapshot->isTooOld()) err = ERROR_SNP_TOO_OLD;
+    else if (snapshot->isTooNew()) err = ERROR_SNP_TOO_NEW;
+    else c64->loadFromSnapshot(snapshot);
+    
+    delete snapshot;
+    return err;
+}
+
+HeadlessExit
+vc64_run(C64 *c64, const HeadlessBudget *budget)
+{
+    if (!budget) return HEADLESS_EXIT_INVALID;
+    return c64->runHeadless(*budget);
+}
+
+HeadlessExit
+vc64_run_frames(C64 *c64, u64 frames)
+{
+    HeadlessBudget budget = { };
+    budget.frames = frames;
+    
+    return c64->runHeadless(budget);
+}
+
+HeadlessExit
+vc64_run_until_pc(C64 *c64, u16 pc, u64 frames)
+{
+    HeadlessBudget budget = { };
+    budget.frames = frames;
+    budget.exitAtPC = true;
+    budget.pc = pc;
+    
+    return c64->runHeadless(budget);
+}
+
+HeadlessExit
+vc64_run_until(C64 *c64, bool (*predicate)(void *), void *context, u64 frames)
+{
+    if (!predicate) return HEADLESS_EXIT_INVALID;
+    
+    HeadlessBudget budget = { };
+    budget.frames = frames;
+    budget.predicate = predicate;
+    budget.context = context;
+    budget.checkEachLine = true;
+    
+    return c64->runHeadless(budget);
+}
+
+ErrorCode
+vc64_set_sid_profile(C64 *c64, long nr, const SIDProfile *profile)
+{
+    if (!profile || nr < -1 || nr > 3) return ERROR_OPT_INV_ARG;
+    
+    if (nr == -1) {
+        c64->sid.setProfile(*profile);
+    } else {
+        c64->sid.setProfile(nr, *profile);
+    }
+    return ERROR_OK;
+}
+
+double
+vc64_sid_throughput(C64 *c64, const SIDProfile *profile)
+{
+    if (!profile) return 0;
+    
+    return c64->sid.measureThroughput(*profile);
+}
+
+ErrorCode
+vc64_start_sid_trace(C64 *c64, const char *path, int synthesize)
+{
+    if (!path) return ERROR_OPT_INV_ARG;
+    
+    return c64->sid.startTrace(path, synthesize != 0);
+}
+
+void
+vc64_stop_sid_trace(C64 *c64)
+{
+    c64->sid.stopTrace();
+}
+
+ErrorCode
+vc64_start_frame_dump(C64 *c64, const FrameDump *dump)
+{
+    if (!dump) return ERROR_OPT_INV_ARG;
+    
+    c64->suspend();
+    ErrorCode result = c64->frameWriter.start(*dump);
+    c64->resume();
+    
+    return result;
+}
+
+void
+vc64_stop_frame_dump(C64 *c64)
+{
+    c64->suspend();
+    c64->frameWriter.stop();
+    c64->resume();
+}
+
+void
+vc64_frame_dump_stats(C64 *c64, u64 *written, u64 *dropped)
+{
+    c64->frameWriter.flush();
+    if (written) *written = c64->frameWriter.written();
+    if (dropped) *dropped = c64->frameWriter.dropped();
+}
+
+ErrorCode
+vc64_start_stream(C64 *c64, const StreamConfig *config)
+{
+    if (!config) return ERROR_OPT_INV_ARG;
+    
+    c64->suspend();
+    ErrorCode result = c64->streamer.start(*c64, *config);
+    c64->resume();
+    
+    return result;
+}
+
+void
+vc64_stop_stream(C64 *c64)
+{
+    c64->suspend();
+    c64->streamer.stop(*c64);
+    c64->resume();
+}
+
+ErrorCode
+vc64_stream_input(C64 *c64, const u8 *packet, long size)
+{
+    if (!packet || size < 0) return ERROR_OPT_INV_ARG;
+    
+    return c64->streamer.receive(*c64, packet, (usize)size);
+}
+
+void
+vc64_request_key_frame(C64 *c64)
+{
+    c64->streamer.requestKeyFrame();
+}
+
+StreamStats
+vc64_stream_stats(C64 *c64)
+{
+    return c64->streamer.getStats();
+}
+
+ErrorCode
+vc64_netplay_start(C64 *c64, const NetplayConfig *config)
+{
+    if (!config) return ERROR_OPT_INV_ARG;
+    
+    c64->suspend();
+    ErrorCode result = c64->netplay.start(*config);
+    c64->resume();
+    
+    return result;
+}
+
+void
+vc64_netplay_stop(C64 *c64)
+{
+    c64->suspend();
+    c64->netplay.stop();
+    c64->resume();
+}
+
+ErrorCode
+vc64_netplay_submit(C64 *c64, const InputEvent *events, long count)
+{
+    if (count < 0 || (!events && count)) return ERROR_OPT_INV_ARG;
+    
+    c64->netplay.submit(events, (usize)count);
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_netplay_receive(C64 *c64, u64 frame, const InputEvent *events, long count)
+{
+    if (count < 0 || (!events && count)) return ERROR_OPT_INV_ARG;
+    
+    return c64->netplay.receive(frame, events, (usize)count);
+}
+
+NetplayStats
+vc64_netplay_stats(C64 *c64)
+{
+    return c64->netplay.getStats();
+}
+
+void
+vc64_set_debug_port(C64 *c64, bool enable)
+{
+    c64->configure(OPT_DEBUG_PORT, enable);
+}
+
+long
+vc64_debug_output(C64 *c64, u8 *buffer, long count)
+{
+    if (!buffer || count < 0) return 0;
+    
+    return (long)c64->debugPort.read(buffer, count);
+}
+
+u64
+vc64_debug_counter(C64 *c64, long nr)
+{
+    if (nr < 0 || nr >= DebugPort::numCounters) return 0;
+    
+    return c64->debugPort.counter(nr);
+}
+
+long
+vc64_debug_exit_code(C64 *c64)
+{
+    return c64->debugPort.getExitCode();
+}
+
+void
+vc64_clear_debug_port(C64 *c64)
+{
+    c64->debugPort.clear();
+}
+
+ErrorCode
+vc64_fuzz_start(C64 *c64, const FuzzConfig *config)
+{
+    if (!config) return ERROR_OPT_INV_ARG;
+    
+    return c64->fuzzer.start(*c64, *config);
+}
+
+void
+vc64_fuzz_stop(C64 *c64)
+{
+    c64->fuzzer.stop(*c64);
+}
+
+FuzzResult
+vc64_fuzz_run(C64 *c64, const u8 *input, long length)
+{
+    if (length < 0 || (!input && length)) {
+        
+        FuzzResult result = { };
+        result.exit = HEADLESS_EXIT_INVALID;
+        result.exitCode = -1;
+        return result;
+    }
+    
+    return c64->fuzzer.run(*c64, input, (usize)length);
+}
+
+const u8 *
+vc64_fuzz_coverage(C64 *c64)
+{
+    return c64->fuzzer.getCoverage();
+}
+
+FuzzStats
+vc64_fuzz_stats(C64 *c64)
+{
+    return c64->fuzzer.getStats();
+}
+
+void
+vc64_set_undo_journal(C64 *c64, long capacity)
+{
+    c64->configure(OPT_UNDO_JOURNAL, capacity);
+}
+
+bool
+vc64_step_back(C64 *c64, long count)
+{
+    return c64->stepBack(count);
+}
+
+long
+vc64_submit_input(C64 *c64, const InputEvent *events, long count)
+{
+    if (count < 0 || (!events && count)) return 0;
+    
+    return (long)c64->inputs.submit(events, (usize)count);
+}
+
+ErrorCode
+vc64_type(C64 *c64, const char *petscii, int matrix)
+{
+    if (!petscii) return ERROR_OPT_INV_ARG;
+    
+    c64->keyboard.type(petscii, matrix != 0);
+    return ERROR_OK;
+}
+
+void
+vc64_start_input_recording(C64 *c64, long checkpointInterval)
+{
+    c64->startInputRecording(checkpointInterval);
+}
+
+void
+vc64_stop_input_recording(C64 *c64)
+{
+    c64->stopInputRecording();
+}
+
+void
+vc64_sync_input_log(C64 *c64)
+{
+    c64->inputLog.sync(*c64);
+}
+
+void
+vc64_start_input_replay(C64 *c64)
+{
+    c64->startInputReplay();
+}
+
+void
+vc64_seek_input_replay(C64 *c64, u64 frame)
+{
+    c64->seekInputReplay(frame);
+}
+
+ErrorCode
+vc64_save_input_log(C64 *c64, const char *path)
+{
+    if (!path) return ERROR_OPT_INV_ARG;
+    
+    try { c64->inputLog.writeToFile(path); }
+    catch (VC64Error &exception) { return exception.errorCode; }
+    
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_load_input_log(C64 *c64, const char *path)
+{
+    if (!path) return ERROR_OPT_INV_ARG;
+    
+    try { c64->inputLog.readFromFile(*c64, path); }
+    catch (VC64Error &exception) { return exception.errorCode; }
+    
+    return ERROR_OK;
+}
+
+u64
+vc64_state_hash(C64 *c64)
+{
+    c64->prepareSave();
+    return c64->hash();
+}
+
+const char *
+vc64_diverging_component(C64 *c64, C64 *other)
+{
+    std::vector<ComponentHash> hashes1, hashes2;
+    c64->prepareSave();
+    other->prepareSave();
+    c64->hash(hashes1);
+    other->hash(hashes2);
+    
+    isize nr = HardwareComponent::diverges(hashes1, hashes2);
+    if (nr < 0) return nullptr;
+    
+    return nr < (isize)hashes1.size() ? hashes1[nr].component : hashes2[nr].component;
+}
+
+long
+vc64_memory_usage(C64 *c64, MemoryUsage *buffer, long count)
+{
+    std::vector<MemoryUsage> usage;
+    c64->memoryUsage(usage);
+    
+    for (long i = 0; i < count && i < (long)usage.size(); i++) buffer[i] = usage[i];
+    return (long)usage.size();
+}
+
+void
+vc64_set_profiler(C64 *c64, long interval)
+{
+    c64->configure(OPT_PROFILER, interval);
+}
+
+ProfilerStats
+vc64_profiler_stats(C64 *c64)
+{
+    return c64->profiler.getStats();
+}
+
+void
+vc64_clear_profiler(C64 *c64)
+{
+    c64->suspend();
+    c64->profiler.clear();
+    c64->resume();
+}
+
+ErrorCode
+vc64_save_profile(C64 *c64, const char *path)
+{
+    if (!path) return ERROR_OPT_INV_ARG;
+    
+    try { c64->profiler.writeToFile(path); }
+    catch (VC64Error &exception) { return exception.errorCode; }
+    
+    return ERROR_OK;
+}
+
+void
+vc64_set_perf_interval(C64 *c64, long interval)
+{
+    c64->configure(OPT_PERF_INTERVAL, interval);
+}
+
+PerfCounters
+vc64_perf_counters(C64 *c64)
+{
+    return c64->perfMonitor.getCounters();
+}
+
+PacingStats
+vc64_pacing_stats(C64 *c64)
+{
+    return c64->oscillator.getPacingStats();
+}
+
+long
+vc64_frame_timings(C64 *c64, FrameTiming *buffer, long count)
+{
+    if (count < 0 || (!buffer && count)) return 0;
+    
+    return (long)c64->oscillator.getFrameTimings(buffer, count);
+}
+
+ErrorCode
+vc64_index_media(const char *dir, const char *index, long threads)
+{
+    MediaIndex mediaIndex;
+    
+    try {
+        mediaIndex.scan(string(dir), threads);
+        mediaIndex.writeToFile(string(index));
+    } catch (VC64Error &exception) {
+        return exception.errorCode;
+    }
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_check_cartridges(const char *dir, const char *report, long threads)
+{
+    CRTValidator validator;
+    
+    try {
+        validator.scan(string(dir), threads);
+        validator.writeToFile(string(report));
+    } catch (VC64Error &exception) {
+        return exception.errorCode;
+    }
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_benchmark(const char **roms, long count, long frames, const char *report)
+{
+    Benchmark benchmark;
+    
+    try {
+        for (long i = 0; i < count; i++) benchmark.loadRom(string(roms[i]));
+        benchmark.run(frames);
+        benchmark.writeToFile(string(report));
+    } catch (VC64Error &exception) {
+        return exception.errorCode;
+    }
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_core_benchmark(const char **roms, long count, u64 cycles,
+                    const char *trace, const char *baseline, const char *report)
+{
+    CoreBenchmark benchmark;
+    
+    try {
+        for (long i = 0; i < count; i++) benchmark.loadRom(string(roms[i]));
+        if (trace) benchmark.loadTrace(string(trace));
+        if (baseline) benchmark.loadBaseline(string(baseline));
+        benchmark.run(cycles);
+        benchmark.writeToFile(string(report));
+    } catch (VC64Error &exception) {
+        return exception.errorCode;
+    }
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_cpu_diff(const char **programs, long count, u64 instructions, const char *report)
+{
+    CPUDiff diff;
+
+    try {
+        diff.runDecimal();
+        for (long i = 0; i < count; i++) diff.run(string(programs[i]), instructions);
+        diff.writeToFile(string(report));
+    } catch (VC64Error &exception) {
+        return exception.errorCode;
+    }
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_run_jobs(const char **roms, long count, const char *manifest,
+              long shard, long shards, long threads,
+              const char *snapshots, const char *report)
+{
+    if (shards < 1 || shard < 0 || shard >= shards) return ERROR_OPT_INV_ARG;
+    
+    JobRunner runner;
+    
+    try {
+        for (long i = 0; i < count; i++) runner.loadRom(string(roms[i]));
+        runner.loadManifest(string(manifest));
+        runner.run(shard, shards, threads, snapshots ? string(snapshots) : "");
+        runner.writeToFile(string(report));
+    } catch (VC64Error &exception) {
+        return exception.errorCode;
+    }
+    return ERROR_OK;
+}
+
+u64
+vc64_frame(C64 *c64)
+{
+    return c64->frame;
+}
+
+u64
+vc64_cycle(C64 *c64)
+{
+    return c64->cpu.cycle;
+}
+
+u8
+vc64_peek(C64 *c64, u16 addr)
+{
+    return c64->mem.spypeek(addr);
+}
+
+ErrorCode
+vc64_read_ram(C64 *c64, u8 *dst, u16 addr, long count)
+{
+    if (!dst || count < 0 || addr + count > 0x10000) return ERROR_OPT_INV_ARG;
+    
+    memcpy(dst, c64->mem.ram + addr, count);
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_read_memory(C64 *c64, u8 *dst, u16 addr, long count, MemoryType source)
+{
+    if (!dst || count < 0 || addr + count > 0x10000) return ERROR_OPT_INV_ARG;
+    if (!MemoryTypeEnum::isValid(source)) return ERROR_OPT_INV_ARG;
+    
+    c64->mem.spypeek(dst, addr, count, source);
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_dirty_pages(C64 *c64, u64 *bitmap, int frame)
+{
+    if (!bitmap) return ERROR_OPT_INV_ARG;
+    
+    if (frame) {
+        c64->mem.getFrameDirtyPages(bitmap);
+    } else {
+        c64->mem.takeDirtyPages(bitmap);
+    }
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_screen_text(C64 *c64, ScreenText *text)
+{
+    if (!text) return ERROR_OPT_INV_ARG;
+    
+    c64->vic.getScreenText(*text);
+    return ERROR_OK;
+}
+
+bool
+vc64_preview(C64 *c64, u32 *dst, long width, long height)
+{
+    if (!dst || width <= 0 || height <= 0) return false;
+    
+    return c64->vic.getPreview(dst, width, height);
+}
+
+BatchCPU *
+vc64_batch_new(long lanes)
+{
+    if (lanes <= 0) return nullptr;
+    
+    return new BatchCPU((usize)lanes);
+}
+
+void
+vc64_batch_delete(BatchCPU *batch)
+{
+    delete batch;
+}
+
+static bool
+isLane(BatchCPU *batch, long lane)
+{
+    return lane >= 0 && (usize)lane < batch->count();
+}
+
+ErrorCode
+vc64_batch_import(BatchCPU *batch, long lane, C64 *c64)
+{
+    if (!isLane(batch, lane) || !c64) return ERROR_OPT_INV_ARG;
+    
+    batch->importLane((usize)lane, *c64);
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_batch_export(BatchCPU *batch, long lane, C64 *c64)
+{
+    if (!isLane(batch, lane) || !c64) return ERROR_OPT_INV_ARG;
+    
+    batch->exportLane((usize)lane, *c64);
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_batch_read(BatchCPU *batch, long lane, u8 *dst, u16 addr, long count)
+{
+    if (!isLane(batch, lane)) return ERROR_OPT_INV_ARG;
+    if (!dst || count < 0 || addr + count > 0x10000) return ERROR_OPT_INV_ARG;
+    
+    batch->read((usize)lane, dst, addr, (usize)count);
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_batch_write(BatchCPU *batch, long lane, const u8 *src, u16 addr, long count)
+{
+    if (!isLane(batch, lane)) return ERROR_OPT_INV_ARG;
+    if (!src || count < 0 || addr + count > 0x10000) return ERROR_OPT_INV_ARG;
+    
+    batch->write((usize)lane, src, addr, (usize)count);
+    return ERROR_OK;
+}
+
+ErrorCode
+vc64_batch_jump(BatchCPU *batch, long lane, u16 addr)
+{
+    if (!isLane(batch, lane)) return ERROR_OPT_INV_ARG;
+    
+    batch->jump((usize)lane, addr);
+    return ERROR_OK;
+}
+
+void
+vc64_batch_set_exit(BatchCPU *batch, unsigned long addr)
+{
+    batch->setExitAddr(addr > 0xFFFF ? UINT32_MAX : (u32)addr);
+}
+
+long
+vc64_batch_run(BatchCPU *batch, u64 steps)
+{
+    return (long)batch->run(steps);
+}
+
+LaneState
+vc64_batch_state(BatchCPU *batch, long lane)
+{
+    return batch->getState((usize)lane);
+}
+
+u64
+vc64_batch_cycles(BatchCPU *batch, long lane)
+{
+    return batch->getCycles((usize)lane);
+}
+
+BatchStats
+vc64_batch_stats(BatchCPU *batch)
+{
+    return batch->getStats();
+}
+
+C64Link *
+vc64_link_new(void)
+{
+    return new C64Link();
+}
+
+void
+vc64_link_delete(C64Link *link)
+{
+    delete link;
+}
+
+long
+vc64_link_add(C64Link *link, C64 *c64)
+{
+    return (long)link->add(*c64);
+}
+
+ErrorCode
+vc64_link_connect(C64Link *link, long a, long b)
+{
+    if (a < 0 || b < 0) return ERROR_OPT_INV_ARG;
+    
+    try { link->connect((usize)a, (usize)b); }
+    catch (VC64Error &exception) { return exception.errorCode; }
+    
+    return ERROR_OK;
+}
+
+HeadlessExit
+vc64_link_run(C64Link *link, u64 cycles, long *instance)
+{
+    auto result = link->run(cycles);
+    if (instance) *instance = (long)link->getStopper();
+    
+    return result;
+}
@@ -0,0 +1,470 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+// THIS FILE MUST CONFORM TO ANSI-C TO BE COMPATIBLE WITH C CLIENTS
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64PublicTypes.h"
+
+#include <stdbool.h>
+
+/* This file provides a plain C interface for running the emulator in batch
+ * mode. It is independent of the proxy layer and allows test frameworks to
+ * create emulator instances, feed them with Roms and media files, and run
+ * them headless on the calling thread:
+ *
+ *     C64 *c64 = vc64_new();
+ *     vc64_load_rom(c64, "kernal.rom"); ...
+ *     vc64_insert_disk(c64, DRIVE8, "test.d64");
+ *     vc64_power_on(c64);
+ *
+ *     HeadlessBudget budget = { .frames = 50 * 60 };
+ *     HeadlessExit reason = vc64_run(c64, &budget);
+ *
+ *     vc64_delete(c64);
+ *
+ * Instances created by vc64_new() don't own an emulator thread. Hence, a host
+ * can create as many instances as it likes and distribute the calls to
+ * vc64_run() or vc64_run_frames() over a thread pool. Each call may be issued
+ * from a different thread, as long as a single instance is never stepped by
+ * two threads at the same time.
+ *
+ * Invalid arguments such as unknown drive numbers or null pointers are
+ * reported as ERROR_OPT_INV_ARG. Functions without an error code return an
+ * empty result instead (0, false, NULL, or HEADLESS_EXIT_INVALID).
+ */
+
+#ifdef __cplusplus
+class C64;
+class BatchCPU;
+class C64Link;
+extern "C" {
+#else
+typedef struct C64 C64;
+typedef struct BatchCPU BatchCPU;
+typedef struct C64Link C64Link;
+#endif
+
+// Creates or destroys an emulator instance (headless mode is preselected)
+C64 *vc64_new(void);
+void vc64_delete(C64 *c64);
+
+/* Creates an emulator instance whose memory is placed on the NUMA node of
+ * the given cores (bit mask). For best results, the instance should be run
+ * by a thread bound to the same cores.
+ */
+C64 *vc64_new_on_cores(unsigned long long cores);
+
+/* Creates an emulator instance in the same state as an existing one. Disks
+ * are shared with the existing instance and copied on write.
+ */
+C64 *vc64_fork(C64 *c64);
+
+/* Applies multiple configuration items at once (use id -1 for options
+ * without an id). If an item is invalid, nothing is changed. This is much
+ * faster than configuring the items one by one, because the expensive
+ * rebuilds are carried out only once.
+ */
+ErrorCode vc64_configure(C64 *c64, const ConfigItem *items, long count);
+
+// Installs a Basic, Character, Kernal, or VC1541 Rom from a file
+ErrorCode vc64_load_rom(C64 *c64, const char *path);
+
+/* Inserts a D64 or G64 file into a drive and connects the drive. An invalid
+ * drive id is reported as ERROR_OPT_INV_ARG.
+ */
+ErrorCode vc64_insert_disk(C64 *c64, long drive, const char *path);
+
+/* Loads a Rom, a disk (D64 or G64 file or a directory), or a CRT file on a
+ * background thread and returns immediately (see MediaLoader). While the
+ * emulator is halted, the loaded objects are kept until vc64_wait_media() is
+ * called, which waits for all pending requests and installs the objects. It
+ * returns the number of failed requests.
+ */
+void vc64_load_rom_async(C64 *c64, const char *path);
+ErrorCode vc64_insert_disk_async(C64 *c64, long drive, const char *path);
+void vc64_attach_cartridge_async(C64 *c64, const char *path, int reset);
+long vc64_wait_media(C64 *c64);
+
+/* Lets a drive serve Kernal LOAD requests directly from the inserted disk,
+ * bypassing the drive CPU and the serial bus (copy protected titles may
+ * require the cycle-exact drive which is the default)
+ */
+ErrorCode vc64_set_fast_load(C64 *c64, long drive, int enable);
+
+// Inserts a TAP file into the datasette and presses the play key
+ErrorCode vc64_insert_tape(C64 *c64, const char *path);
+
+/* Lets the emulator run in warp mode while data is transferred over the IEC
+ * bus with a drive motor running (the drives are emulated as in normal mode)
+ */
+void vc64_set_drive_turbo(C64 *c64, int enable);
+
+/* Lets the emulator run in warp mode while the datasette motor is running
+ * (the tape signal is processed exactly as in normal mode)
+ */
+void vc64_set_tape_turbo(C64 *c64, int enable);
+
+// Copies the first item of a PRG, P00, or T64 file into memory
+ErrorCode vc64_flash_file(C64 *c64, const char *path);
+
+// Powers the emulator on
+ErrorCode vc64_power_on(C64 *c64);
+
+/* Lets vc64_power_on() emulate the specified number of frames to boot the
+ * machine (0 = off). The booted state is stored in a process-wide cache and
+ * restored by all instances with the same Roms and hardware configuration
+ * (see BootCache). Inserted disks are kept.
+ */
+void vc64_set_boot_cache(C64 *c64, long frames);
+
+// Restores a snapshot file (mapped into memory instead of being read)
+ErrorCode vc64_load_snapshot(C64 *c64, const char *path);
+
+/* Runs the emulator until the budget is exhausted or a condition is met. A
+ * missing budget or a budget without any limit or exit condition is rejected
+ * with HEADLESS_EXIT_INVALID.
+ */
+HeadlessExit vc64_run(C64 *c64, const HeadlessBudget *budget);
+
+// Runs the emulator for a certain number of frames (one pool work item)
+HeadlessExit vc64_run_frames(C64 *c64, u64 frames);
+
+/* Runs the emulator until the CPU is about to execute the instruction at the
+ * specified address or the frame budget is exhausted (0 = no limit)
+ */
+HeadlessExit vc64_run_until_pc(C64 *c64, u16 pc, u64 frames);
+
+/* Runs the emulator until the predicate returns true or the frame budget is
+ * exhausted (0 = no limit). The predicate is checked at the end of each
+ * rasterline.
+ */
+HeadlessExit vc64_run_until(C64 *c64, bool (*predicate)(void *), void *context,
+                            u64 frames);
+
+/* Dumps selected frames into a directory or hands them over to a callback
+ * (see FrameDump). The frames are encoded and written by a background thread.
+ * Stopping waits until all queued frames have been written.
+ */
+ErrorCode vc64_start_frame_dump(C64 *c64, const FrameDump *dump);
+void vc64_stop_frame_dump(C64 *c64);
+
+/* Waits until all queued frames have been written and returns the number of
+ * written and dropped frames of the current frame dump
+ */
+void vc64_frame_dump_stats(C64 *c64, u64 *written, u64 *dropped);
+
+/* Streams the emulator output to a remote client (see Streamer). Each frame
+ * produces a delta-encoded video packet and, if a sample rate is given, a
+ * compressed audio packet. The packets are handed over to the sink callback
+ * which is responsible for transmitting them.
+ */
+ErrorCode vc64_start_stream(C64 *c64, const StreamConfig *config);
+void vc64_stop_stream(C64 *c64);
+
+/* Processes an input packet sent by the client. The function must be called
+ * on the thread that submits all other input events.
+ */
+ErrorCode vc64_stream_input(C64 *c64, const u8 *packet, long size);
+
+// Lets the next video packet contain all lines, e.g., for a new client
+void vc64_request_key_frame(C64 *c64);
+
+// Returns the number of sent frames and bytes and received input events
+StreamStats vc64_stream_stats(C64 *c64);
+
+/* Starts a two-player session in lockstep with a remote emulator (see
+ * Netplay). Both emulators must be in the same state. Local inputs are handed
+ * over to the sink callback once per frame. Remote inputs that arrive late
+ * are corrected by rolling back and emulating the missed frames again.
+ */
+ErrorCode vc64_netplay_start(C64 *c64, const NetplayConfig *config);
+void vc64_netplay_stop(C64 *c64);
+
+// Submits local input events (applied at the beginning of a later frame)
+ErrorCode vc64_netplay_submit(C64 *c64, const InputEvent *events, long count);
+
+/* Passes in the remote inputs of a frame as received from the remote sink.
+ * Packets must be passed in in the order in which they have been sent.
+ */
+ErrorCode vc64_netplay_receive(C64 *c64, u64 frame, const InputEvent *events, long count);
+
+// Returns the number of exchanged packets, rollbacks, and stalls
+NetplayStats vc64_netplay_stats(C64 *c64);
+
+/* Maps the debug port into the upper 16 bytes of the I/O 2 area (see
+ * DebugPort). Guest code can use it to send output, to update counters, and
+ * to terminate the run with an exit code (HEADLESS_EXIT_GUEST).
+ */
+void vc64_set_debug_port(C64 *c64, bool enable);
+
+// Moves up to count bytes of guest output into a buffer
+long vc64_debug_output(C64 *c64, u8 *buffer, long count);
+
+// Returns a debug port counter (0 - 7)
+u64 vc64_debug_counter(C64 *c64, long nr);
+
+// Returns the exit code written by the guest (-1 if none has been written)
+long vc64_debug_exit_code(C64 *c64);
+
+// Clears the guest output, the counters, and the exit code
+void vc64_clear_debug_port(C64 *c64);
+
+/* Prepares a fuzzing session (see Fuzzer). The current state becomes the base
+ * state which is restored before each input is run. While the session is
+ * active, the CPU records an AFL style edge coverage map.
+ */
+ErrorCode vc64_fuzz_start(C64 *c64, const FuzzConfig *config);
+void vc64_fuzz_stop(C64 *c64);
+
+// Restores the base state, injects an input, and runs it
+FuzzResult vc64_fuzz_run(C64 *c64, const u8 *input, long length);
+
+// Returns the 64 KB coverage map of the latest run
+const u8 *vc64_fuzz_coverage(C64 *c64);
+
+// Returns the number of executed inputs, execs per second, and total edges
+FuzzStats vc64_fuzz_stats(C64 *c64);
+
+/* Records the specified number of recent instructions in the undo journal
+ * (0 = off) and lets the debugger step backwards (see UndoJournal). The
+ * function returns false if the journal doesn't reach back far enough.
+ */
+void vc64_set_undo_journal(C64 *c64, long capacity);
+bool vc64_step_back(C64 *c64, long count);
+
+/* Applies a reSID quality profile to a single SID (0 - 3) or all SIDs (-1).
+ * An invalid SID number is reported as ERROR_OPT_INV_ARG.
+ */
+ErrorCode vc64_set_sid_profile(C64 *c64, long nr, const SIDProfile *profile);
+
+// Measures the throughput of a reSID quality profile in samples per second
+double vc64_sid_throughput(C64 *c64, const SIDProfile *profile);
+
+/* Streams all SID register writes into a file. If synthesize is 0, the SID
+ * engines are not run while the trace is active.
+ */
+ErrorCode vc64_start_sid_trace(C64 *c64, const char *path, int synthesize);
+void vc64_stop_sid_trace(C64 *c64);
+
+/* Submits a batch of keyboard, joystick, or mouse events, each of which takes
+ * effect in the CPU cycle it is tagged with. Returns the number of leading
+ * events taken from the batch, which is less than count if the input queue is
+ * full. Events may be submitted while the emulator runs, but only from one
+ * thread.
+ */
+long vc64_submit_input(C64 *c64, const InputEvent *events, long count);
+
+/* Types a PETSCII string (see Keyboard::type()). The characters are written
+ * into the Kernal's keyboard buffer whenever it has been drained. If matrix
+ * is set, the keys are pressed and released instead.
+ */
+ErrorCode vc64_type(C64 *c64, const char *petscii, int matrix);
+
+/* Records all inputs into an input log, starting with the current state. Call
+ * vc64_sync_input_log() after changing the emulator state by other means.
+ */
+void vc64_start_input_recording(C64 *c64, long checkpointInterval);
+void vc64_stop_input_recording(C64 *c64);
+void vc64_sync_input_log(C64 *c64);
+
+// Replays the input log from the beginning or from the specified frame
+void vc64_start_input_replay(C64 *c64);
+void vc64_seek_input_replay(C64 *c64, u64 frame);
+
+// Saves or loads an input log
+ErrorCode vc64_save_input_log(C64 *c64, const char *path);
+ErrorCode vc64_load_input_log(C64 *c64, const char *path);
+
+/* Computes a checksum over the emulator state without creating a snapshot.
+ * The function is cheap enough to be called once per frame.
+ */
+u64 vc64_state_hash(C64 *c64);
+
+/* Compares the states of two emulator instances and returns the name of the
+ * first component whose state differs (nullptr if both states are equal).
+ */
+const char *vc64_diverging_component(C64 *c64, C64 *other);
+
+/* Reports the memory footprint of each component. Up to count entries are
+ * copied into the buffer. The function returns the number of components.
+ * Memory shared with other instances (copy-on-write disk tracks, pooled Roms)
+ * is reported separately and must be counted only once per process.
+ */
+long vc64_memory_usage(C64 *c64, MemoryUsage *buffer, long count);
+
+/* Enables the profiler which measures every n-th rasterline in detail and
+ * attributes the host time to the emulated components (see Profiler). An
+ * interval of 0 disables the profiler.
+ */
+void vc64_set_profiler(C64 *c64, long interval);
+ProfilerStats vc64_profiler_stats(C64 *c64);
+void vc64_clear_profiler(C64 *c64);
+
+// Saves the profiler statistics
+ErrorCode vc64_save_profile(C64 *c64, const char *path);
+
+/* Samples the host-side performance counters every n-th frame (see
+ * PerfMonitor). Each sample is announced by a MSG_PERF message. An interval
+ * of 0 disables sampling.
+ */
+void vc64_set_perf_interval(C64 *c64, long interval);
+PerfCounters vc64_perf_counters(C64 *c64);
+
+/* Returns the pacing telemetry, i.e., histograms of the emulation and sleep
+ * time per frame, the audio buffer fill level, and the number of buffer
+ * underflows and overflows (see Oscillator).
+ */
+PacingStats vc64_pacing_stats(C64 *c64);
+
+/* Copies the timings of up to count recent frames into a buffer, the oldest
+ * frame first, and returns the number of copied frames.
+ */
+long vc64_frame_timings(C64 *c64, FrameTiming *buffer, long count);
+
+/* Indexes all media files inside a directory tree and saves the index (see
+ * MediaIndex). The files are processed by the specified number of threads.
+ * No emulator instance is needed.
+ */
+ErrorCode vc64_index_media(const char *dir, const char *index, long threads);
+
+/* Checks all CRT files inside a directory tree and saves a report listing
+ * the cartridge type, the emulating class, and all problems found in the
+ * chip packets of each file (see CRTValidator). No emulator instance is
+ * needed.
+ */
+ErrorCode vc64_check_cartridges(const char *dir, const char *report, long threads);
+
+/* Runs the built-in benchmark workloads for the specified number of frames
+ * and saves a report with the emulated MHz and frames per second of each
+ * workload (see Benchmark). The Rom files are installed in each instance.
+ */
+ErrorCode vc64_benchmark(const char **roms, long count, long frames, const char *report);
+
+/* Measures each chip core in isolation for the specified number of cycles
+ * and saves a report with the emulated MHz of each core (see CoreBenchmark).
+ * If a baseline report is given, each core is compared against it. If a SID
+ * trace is given, it is replayed by the SID cores. Both arguments may be
+ * nullptr.
+ */
+ErrorCode vc64_core_benchmark(const char **roms, long count, u64 cycles,
+                              const char *trace, const char *baseline,
+                              const char *report);
+
+/* Runs the micro-op CPU and the batch engine in lockstep on each program and
+ * compares both cores after every instruction (see CPUDiff). A program is
+ * stopped after the specified number of instructions or when it reaches one
+ * of the exit traps of the Lorenz test suite. The report lists the status,
+ * the first mismatch, and the speed of both cores for each program. It starts
+ * with an exhaustive check of decimal mode ADC and SBC.
+ */
+ErrorCode vc64_cpu_diff(const char **programs, long count, u64 instructions,
+                        const char *report);
+
+/* Runs the jobs of a regression suite and saves a report with the status and
+ * the final state hash of each job (see JobRunner). Shard k of n runs every
+ * n-th job starting with job k. The jobs of a shard are distributed over the
+ * specified number of threads. If a snapshot directory is given, the final
+ * states are saved there in compressed form (may be nullptr). The Rom files
+ * are installed in each instance.
+ */
+ErrorCode vc64_run_jobs(const char **roms, long count, const char *manifest,
+                        long shard, long shards, long threads,
+                        const char *snapshots, const char *report);
+
+// Inspects the emulator state
+u64 vc64_frame(C64 *c64);
+u64 vc64_cycle(C64 *c64);
+u8 vc64_peek(C64 *c64, u16 addr);
+
+/* Reads RAM directly, bypassing the memory mapping. Together with the dirty
+ * page bitmap, clients can mirror the RAM by copying the modified pages only.
+ * Bit n of the bitmap (bitmap[n / 64], bit n % 64) stands for page n. If frame
+ * is nonzero, the pages written during the previous frame are returned.
+ * Otherwise, all pages written since the last call are returned.
+ */
+ErrorCode vc64_read_ram(C64 *c64, u8 *dst, u16 addr, long count);
+ErrorCode vc64_dirty_pages(C64 *c64, u64 *bitmap, int frame);
+
+/* Reads a memory range as seen by the specified memory source without side
+ * effects (see C64Memory::spypeek())
+ */
+ErrorCode vc64_read_memory(C64 *c64, u8 *dst, u16 addr, long count, MemoryType source);
+
+/* Reads the text screen directly from the video matrix and color RAM without
+ * rendering anything (see VICII::getScreenText())
+ */
+ErrorCode vc64_screen_text(C64 *c64, ScreenText *text);
+
+/* Scales the visible screen area down to the specified size (see
+ * VICII::getPreview()). The function can be called from any thread and
+ * returns false if no frame has been drawn since the first request.
+ */
+bool vc64_preview(C64 *c64, u32 *dst, long width, long height);
+
+/* Creates or destroys a batch of CPUs with plain RAM which are executed in
+ * lockstep (see BatchCPU). Batches emulate no ROMs, I/O chips, or interrupts.
+ */
+BatchCPU *vc64_batch_new(long lanes);
+void vc64_batch_delete(BatchCPU *batch);
+
+/* Copies the RAM and the CPU registers between a lane and an emulator
+ * instance. Lanes stopped in the LANE_DIVERGED state are continued by
+ * exporting them into an instance and running it.
+ */
+ErrorCode vc64_batch_import(BatchCPU *batch, long lane, C64 *c64);
+ErrorCode vc64_batch_export(BatchCPU *batch, long lane, C64 *c64);
+
+// Accesses the RAM of a lane
+ErrorCode vc64_batch_read(BatchCPU *batch, long lane, u8 *dst, u16 addr, long count);
+ErrorCode vc64_batch_write(BatchCPU *batch, long lane, const u8 *src, u16 addr, long count);
+
+// Lets a lane continue at the specified address
+ErrorCode vc64_batch_jump(BatchCPU *batch, long lane, u16 addr);
+
+// Stops each lane reaching the specified address (values > 0xFFFF = none)
+void vc64_batch_set_exit(BatchCPU *batch, unsigned long addr);
+
+/* Lets each running lane execute up to the specified number of instructions
+ * and returns the number of lanes still running
+ */
+long vc64_batch_run(BatchCPU *batch, u64 steps);
+
+// Returns the state and the number of elapsed cycles of a lane
+LaneState vc64_batch_state(BatchCPU *batch, long lane);
+u64 vc64_batch_cycles(BatchCPU *batch, long lane);
+
+// Returns the number of executed steps, instructions, and opcode groups
+BatchStats vc64_batch_stats(BatchCPU *batch);
+
+/* Creates or destroys a link which runs multiple instances in lockstep on the
+ * calling thread (see C64Link). The linked instances are not owned by the
+ * link and must be deleted separately.
+ */
+C64Link *vc64_link_new(void);
+void vc64_link_delete(C64Link *link);
+
+// Adds an instance to a link and returns its number
+long vc64_link_add(C64Link *link, C64 *c64);
+
+/* Connects the user ports of two linked instances by a transfer cable. PB0 -
+ * PB7 are connected and PC2 of each side is wired to FLAG2 of the other side.
+ */
+ErrorCode vc64_link_connect(C64Link *link, long a, long b);
+
+/* Runs all linked instances for the specified number of cycles. If an
+ * instance needs to stop earlier, its number is stored in 'instance' (-1 if
+ * the cycle budget is exhausted). The pointer may be nullptr.
+ */
+HeadlessExit vc64_link_run(C64Link *link, u64 cycles, long *instance);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,82 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64Link.h"
+#include "C64.h"
+
+usize
+C64Link::add(C64 &c64)
+{
+    instances.push_back(&c64);
+    return instances.size() - 1;
+}
+
+void
+C64Link::connect(usize a, usize b)
+{
+    if (a == b || a >= instances.size() || b >= instances.size()) {
+        throw VC64Error(ERROR_OPT_INV_ARG);
+    }
+
+    // Each instance has a single user port
+    for (auto &cable : cables) {
+        if (cable.a == a || cable.b == a || cable.a == b || cable.b == b) {
+            throw VC64Error(ERROR_OPT_INV_ARG);
+        }
+    }
+
+    cables.push_back(Cable { a, b });
+    exchange();
+}
+
+HeadlessExit
+C64Link::run(u64 cycles)
+{
+    HeadlessExit result = HEADLESS_EXIT_CYCLE_LIMIT;
+    stopper = -1;
+
+    for (auto c64 : instances) assert(!c64->isRunning());
+
+    for (u64 i = 0; i < cycles && stopper < 0; i++) {
+
+        for (usize j = 0; j < instances.size(); j++) {
+
+            HeadlessExit exit;
+            if (instances[j]->executeLinkedCycle(exit) && stopper < 0) {
+
+                result = exit;
+                stopper = (isize)j;
+            }
+        }
+
+        exchange();
+        clock++;
+    }
+
+    return result;
+}
+
+void
+C64Link::exchange()
+{
+    for (auto &cable : cables) {
+
+        C64 &a = *instances[cable.a];
+        C64 &b = *instances[cable.b];
+
+        // A line is low if one of the sides pulls it low
+        u8 lines = a.cia2.getUserPortOutput() & b.cia2.getUserPortOutput();
+        a.cia2.setUserPort(lines);
+        b.cia2.setUserPort(lines);
+
+        // PC2 of each side is wired to FLAG2 of the other side
+        if (a.cia2.getPCCycle() == (Cycle)a.cpu.cycle) b.cia2.triggerFallingEdgeOnFlagPin();
+        if (b.cia2.getPCCycle() == (Cycle)b.cpu.cycle) a.cia2.triggerFallingEdgeOnFlagPin();
+    }
+}
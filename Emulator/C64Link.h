@@ -0,0 +1,94 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Object.h"
+#include "C64Types.h"
+
+/* Runs multiple emulator instances on the calling thread with a common clock.
+ * All instances execute the same cycle before any of them proceeds with the
+ * next one. Hence, the port lines connecting two instances can be exchanged
+ * after each cycle without any synchronization.
+ *
+ * Instances are connected by user port transfer cables. A cable connects
+ * PB0 - PB7 of both sides. An output pin pulled low by either side pulls the
+ * line low. The PC2 pin of each side is wired to the FLAG2 pin of the other
+ * side, i.e., each access to port B triggers a FLAG interrupt on the other
+ * side. The values driven in a cycle are seen by the other side in the next
+ * cycle. Thus, the outcome doesn't depend on the order of the instances.
+ *
+ * The instances are not owned by the link and must not run on their own
+ * emulator thread while being linked.
+ */
+class C64Link : C64Object {
+
+    struct Cable {
+
+        usize a;
+        usize b;
+    };
+
+    // Linked instances
+    std::vector<class C64 *> instances;
+
+    // User port cables
+    std::vector<Cable> cables;
+
+    // Number of cycles executed in lockstep
+    u64 clock = 0;
+
+    // Instance that has terminated the latest run (-1 = none)
+    isize stopper = -1;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    const char *getDescription() const override { return "C64Link"; }
+
+    // Adds an instance and returns its number
+    usize add(class C64 &c64);
+
+    // Connects the user ports of two instances by a transfer cable
+    void connect(usize a, usize b) throws;
+
+
+    //
+    // Running
+    //
+
+public:
+
+    /* Runs all instances for the specified number of cycles. The run
+     * terminates early if one of the instances needs to stop (e.g., because
+     * its CPU has jammed or a breakpoint has been reached). In this case, the
+     * other instances complete the current cycle to keep the clock common.
+     */
+    HeadlessExit run(u64 cycles);
+
+private:
+
+    // Exchanges the port lines at the end of a cycle
+    void exchange();
+
+
+    //
+    // Querying
+    //
+
+public:
+
+    usize count() const { return instances.size(); }
+    u64 getClock() const { return clock; }
+    isize getStopper() const { return stopper; }
+};
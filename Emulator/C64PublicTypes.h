@@ -21,7 +21,9 @@
 
 #include "CartridgePublicTypes.h"
 #include "CIAPublicTypes.h"
+#include "CmdQueuePublicTypes.h"
 #include "CPUPublicTypes.h"
+#include "DatasettePublicTypes.h"
 #include "DiskPublicTypes.h"
 #include "DrivePublicTypes.h"
 #include "FilePublicTypes.h"
@@ -29,7 +31,10 @@
 #include "MemoryPublicTypes.h"
 #include "MsgQueuePublicTypes.h"
 #include "MousePublicTypes.h"
+#include "OscillatorPublicTypes.h"
 #include "PortPublicTypes.h"
+#include "PerfMonitorPublicTypes.h"
+#include "ProfilerPublicTypes.h"
 #include "SIDPublicTypes.h"
 #include "VICIIPublicTypes.h"
 
@@ -42,6 +47,7 @@ enum_long(OPT)
     // VICII
     OPT_VIC_REVISION,
     OPT_PALETTE,
+    OPT_PAL_BLENDING,
     OPT_GRAY_DOT_BUG,
     OPT_HIDE_SPRITES,
     OPT_DMA_DEBUG,
@@ -63,9 +69,16 @@ enum_long(OPT)
     OPT_CUT_OPACITY,
     OPT_SS_COLLISIONS,
     OPT_SB_COLLISIONS,
+    OPT_INDEXED_TEXTURE,
+    OPT_FRAME_SKIP,
+    OPT_RENDER_PIPELINE,
 
     // Logic board
     OPT_GLUE_LOGIC,
+    OPT_SPIN_WINDOW,
+    OPT_AUDIO_PACING,
+    OPT_EMULATION_SPEED,
+    OPT_POWER_SAVING,
 
     // CIA
     OPT_CIA_REVISION,
@@ -84,6 +97,8 @@ enum_long(OPT)
     // Sound synthesis
     OPT_SID_ENGINE,
     OPT_SID_SAMPLING,
+    OPT_SID_PARALLEL,
+    OPT_AUDIO_LAYOUT,
     
     // Memory
     OPT_RAM_PATTERN,
@@ -92,9 +107,30 @@ enum_long(OPT)
     OPT_DRIVE_TYPE,
     OPT_DRIVE_CONNECT,
     OPT_DRIVE_POWER_SWITCH,
+    OPT_DRIVE_IDLE_SLEEP,
+    OPT_DRIVE_FAST_LOAD,
+    OPT_IEC_TURBO,
+    
+    // Datasette
+    OPT_DATASETTE_TURBO,
     
     // Debugging
     OPT_DEBUGCART,
+    OPT_DEBUG_PORT,
+    OPT_UNDO_JOURNAL,
+    
+    // Emulation
+    OPT_HEADLESS,
+    OPT_PROFILER,
+    OPT_PERF_INTERVAL,
+    OPT_DRIVE_SPECULATION,
+    OPT_BOOT_CACHE,
+    
+    // Threads
+    OPT_THREAD_AFFINITY,
+    OPT_THREAD_PRIORITY,
+    OPT_THREAD_ROUND_ROBIN,
+    OPT_THREAD_QOS,
     
     OPT_COUNT
 };
@@ -144,6 +180,69 @@ enum_long(INSPECTION_TARGET)
 };
 typedef INSPECTION_TARGET InspectionTarget;
 
+enum_long(HEADLESS_EXIT)
+{
+    HEADLESS_EXIT_FRAME_LIMIT,
+    HEADLESS_EXIT_CYCLE_LIMIT,
+    HEADLESS_EXIT_PATTERN,
+    HEADLESS_EXIT_PC,
+    HEADLESS_EXIT_PREDICATE,
+    HEADLESS_EXIT_JAMMED,
+    HEADLESS_EXIT_BREAKPOINT,
+    HEADLESS_EXIT_STOP,
+    HEADLESS_EXIT_GUEST,
+    HEADLESS_EXIT_INVALID,
+    HEADLESS_EXIT_COUNT
+};
+typedef HEADLESS_EXIT HeadlessExit;
+
+enum_long(THREAD_ROLE)
+{
+    THREAD_ROLE_EMULATOR,
+    THREAD_ROLE_HELPER,
+    THREAD_ROLE_COUNT
+};
+typedef THREAD_ROLE ThreadRole;
+
+enum_long(BENCHMARK)
+{
+    BENCHMARK_IDLE,
+    BENCHMARK_SPRITES,
+    BENCHMARK_SID,
+    BENCHMARK_DRIVES,
+    BENCHMARK_TAPE,
+    BENCHMARK_EASYFLASH,
+    BENCHMARK_COUNT
+};
+typedef BENCHMARK BenchmarkWorkload;
+
+enum_long(CORE)
+{
+    CORE_CPU,
+    CORE_VICII,
+    CORE_RESID,
+    CORE_FASTSID,
+    CORE_DRIVE,
+    CORE_COUNT
+};
+typedef CORE ChipCore;
+
+enum_long(FRAME_FORMAT)
+{
+    FRAME_FORMAT_PNG,
+    FRAME_FORMAT_RAW,
+    FRAME_FORMAT_COUNT
+};
+typedef FRAME_FORMAT FrameFormat;
+
+enum_long(FUZZ_TARGET)
+{
+    FUZZ_TARGET_RAM,
+    FUZZ_TARGET_DISK,
+    FUZZ_TARGET_COUNT
+};
+typedef FUZZ_TARGET FuzzTarget;
+
 enum_long(ERROR_CODE)
 {
     ERROR_OK,
@@ -185,6 +284,15 @@ enum_long(ERROR_CODE)
     ERROR_FS_EXPECTED_MIN,
     ERROR_FS_EXPECTED_MAX,
     
+    // Debugger
+    ERROR_GUARD_SYNTAX,
+    
+    // Recorder
+    ERROR_REC_LAUNCH,
+    
+    // Configuration
+    ERROR_OPT_INV_ARG,
+    
     ERROR_COUNT
 };
 typedef ERROR_CODE ErrorCode;
@@ -204,6 +312,275 @@ typedef struct
 }
 C64Configuration;
 
+typedef struct
+{
+    Option option;
+
+    // SID number, drive, or thread role (-1 for options without an id)
+    long id;
+    long value;
+}
+ConfigItem;
+
+typedef struct
+{
+    const char *component;
+    
+    /* Size of the component object (not counting embedded subcomponents),
+     * memory allocated by the component, and allocated memory which is
+     * shared with other instances (copy-on-write disk tracks and pooled Roms)
+     */
+    u64 objectBytes;
+    u64 heapBytes;
+    u64 sharedBytes;
+}
+MemoryUsage;
+
+typedef struct
+{
+    /* Maximum number of frames or cycles to emulate (0 = no limit). The cycle
+     * budget is checked at the end of each rasterline. A budget without any
+     * limit or exit condition is rejected with HEADLESS_EXIT_INVALID.
+     */
+    u64 frames;
+    u64 cycles;
+    
+    /* Memory pattern terminating the run. If a pattern is set (patternLength
+     * > 0), it is compared against the memory contents starting at
+     * patternAddr. Bits set in patternIgnore are excluded from the
+     * comparison.
+     */
+    u16 patternAddr;
+    u8 pattern[16];
+    u8 patternIgnore[16];
+    u8 patternLength;
+    
+    /* Program counter terminating the run. If exitAtPC is set, the run stops
+     * right before the CPU executes the instruction at this address.
+     */
+    bool exitAtPC;
+    u16 pc;
+    
+    /* Callback terminating the run. If set, it is invoked with the provided
+     * context and stops the run by returning true.
+     */
+    bool (*predicate)(void *context);
+    void *context;
+    
+    /* Granularity of the pattern and predicate checks. If set, they are
+     * checked at the end of each rasterline instead of each frame.
+     */
+    bool checkEachLine;
+}
+HeadlessBudget;
+
+typedef struct
+{
+    /* Frames to dump. The first frame and every interval-th frame after it
+     * are handed over to the frame writer (interval 0 = off).
+     */
+    u64 first;
+    u64 interval;
+    
+    /* Target directory and file format. Each frame is written into a file
+     * named frame_<number>.png or frame_<number>.raw. Raw files contain the
+     * RGBA pixels of the visible area without a header.
+     */
+    const char *dir;
+    FrameFormat format;
+    
+    /* Callback replacing the file output. If set, it is invoked on the
+     * writer thread with the RGBA pixels of each dumped frame.
+     */
+    void (*sink)(void *context, u64 frame, const u32 *pixels, long width, long height);
+    void *context;
+    
+    /* Number of frame buffers (0 = default) and the behaviour if all of them
+     * are in use. If block is set, the emulator waits for the writer thread.
+     * Otherwise, the frame is dropped.
+     */
+    long buffers;
+    bool block;
+}
+FrameDump;
+
+typedef struct
+{
+    /* Location of the input. FUZZ_TARGET_RAM copies the input to addr. If
+     * lengthAddr is non-zero, the input length is stored there as a 16 bit
+     * value. FUZZ_TARGET_DISK adds the input as a PRG file with the specified
+     * name to the disk in the specified drive. The name must not be in use on
+     * the disk.
+     */
+    FuzzTarget target;
+    u16 addr;
+    u16 lengthAddr;
+    long drive;
+    const char *name;
+    
+    // Limits the emulation of each input
+    HeadlessBudget budget;
+}
+FuzzConfig;
+
+typedef struct
+{
+    // Reason for terminating the run
+    HeadlessExit exit;
+    
+    // Exit code written to the debug port (-1 = none)
+    long exitCode;
+    
+    // Number of distinct edges hit and the number of edges never seen before
+    u64 edges;
+    u64 newEdges;
+    
+    // Indicates if the run has hit an edge or hit count bucket never seen before
+    bool newCoverage;
+}
+FuzzResult;
+
+typedef struct
+{
+    // Number of executed inputs and the host time spent on them
+    u64 execs;
+    u64 nanos;
+    double execsPerSecond;
+    
+    // Average time spent on restoring the base state in nanoseconds
+    u64 restoreNanos;
+    
+    // Number of distinct edges hit by all inputs
+    u64 totalEdges;
+}
+FuzzStats;
+
+typedef struct
+{
+    /* Receives the encoded packets (see Streamer). The callback is invoked on
+     * the emulator thread. The packet is only valid during the call.
+     */
+    void (*sink)(void *context, const u8 *packet, long size);
+    void *context;
+    
+    // Sample rate of the audio stream in Hz (0 = no audio)
+    long sampleRate;
+    
+    // Number of frames between two key frames (0 = only the first frame)
+    long keyInterval;
+}
+StreamConfig;
+
+typedef struct
+{
+    bool connected;
+    bool switchedOn;
+    bool redLED;
+    bool spinning;
+    bool writing;
+    bool hasDisk;
+    Halftrack halftrack;
+}
+DriveStatus;
+
+typedef struct
+{
+    // Incremented with each published status
+    u64 version;
+    
+    // Emulated frames and CPU cycles
+    u64 frame;
+    u64 cycle;
+    
+    bool warp;
+    bool jammed;
+    
+    // Drives and the serial bus
+    DriveStatus drive[DRIVE_COUNT];
+    bool transferring;
+    
+    // Datasette (the counter is measured in seconds)
+    bool hasTape;
+    bool tapeMotor;
+    bool playKey;
+    u32 tapeCounter;
+    
+    // Expansion port
+    bool hasCartridge;
+    bool hasCartridgeLED;
+    bool cartridgeLED;
+    i8 cartridgeSwitch;
+}
+C64Status;
+
+typedef struct
+{
+    // Number of sent frames and the number of sent key frames
+    u64 frames;
+    u64 keyFrames;
+    
+    // Number of frames that couldn't be sent, because they weren't indexed
+    u64 skippedFrames;
+    
+    // Number of transmitted bytes
+    u64 videoBytes;
+    u64 audioBytes;
+    
+    // Number of received input events and rejected input packets
+    u64 inputEvents;
+    u64 rejectedPackets;
+}
+StreamStats;
+
+typedef struct
+{
+    // Player number (0 or 1). Inputs are applied in the order of the players.
+    long player;
+    
+    // Number of frames local inputs are delayed by
+    long inputDelay;
+    
+    // Maximum number of frames the remote inputs may lag behind
+    long maxRollback;
+    
+    /* Maximum time in milliseconds the emulator waits for remote inputs if
+     * they lag behind too far (0 = don't wait)
+     */
+    long timeout;
+    
+    /* Receives the local inputs of a frame (see Netplay). The callback is
+     * invoked on the emulator thread once per frame, even if there are no
+     * inputs. The events are only valid during the call.
+     */
+    void (*sink)(void *context, u64 frame, const InputEvent *events, long count);
+    void *context;
+}
+NetplayConfig;
+
+typedef struct
+{
+    // Number of sent and received input packets
+    u64 sentPackets;
+    u64 receivedPackets;
+    
+    // Number of rollbacks and the number of frames emulated again
+    u64 rollbacks;
+    u64 resimulatedFrames;
+    
+    // Largest number of frames emulated again in a single rollback
+    u64 maxDepth;
+    
+    // Number of frames the emulator had to wait for remote inputs
+    u64 stalls;
+    
+    // Number of mispredictions that couldn't be corrected anymore
+    u64 desyncs;
+    
+    // Number of rejected remote packets
+    u64 rejectedPackets;
+}
+NetplayStats;
+
 typedef struct
 {
     VICRevision vic;
@@ -18,6 +18,7 @@
 
 #include "CartridgeTypes.h"
 #include "CIATypes.h"
+#include "CmdQueueTypes.h"
 #include "CPUTypes.h"
 #include "DriveTypes.h"
 #include "DiskTypes.h"
@@ -27,6 +28,7 @@
 #include "MsgQueueTypes.h"
 #include "MouseTypes.h"
 #include "PortTypes.h"
+#include "ProfilerTypes.h"
 #include "SIDTypes.h"
 #include "VICIITypes.h"
 
@@ -48,6 +50,7 @@ struct OptionEnum : Reflection<OptionEnum, Option> {
                 
             case OPT_VIC_REVISION:        return "VIC_REVISION";
             case OPT_PALETTE:             return "PALETTE";
+            case OPT_PAL_BLENDING:        return "PAL_BLENDING";
             case OPT_GRAY_DOT_BUG:        return "GRAY_DOT_BUG";
             case OPT_HIDE_SPRITES:        return "HIDE_SPRITES";
             case OPT_DMA_DEBUG:           return "DMA_DEBUG";
@@ -69,8 +72,15 @@ struct OptionEnum : Reflection<OptionEnum, Option> {
             case OPT_CUT_OPACITY:         return "CUT_OPACITY";
             case OPT_SS_COLLISIONS:       return "SS_COLLISIONS";
             case OPT_SB_COLLISIONS:       return "SB_COLLISIONS";
+            case OPT_INDEXED_TEXTURE:     return "INDEXED_TEXTURE";
+            case OPT_FRAME_SKIP:          return "FRAME_SKIP";
+            case OPT_RENDER_PIPELINE:     return "RENDER_PIPELINE";
                 
             case OPT_GLUE_LOGIC:          return "GLUE_LOGIC";
+            case OPT_SPIN_WINDOW:         return "SPIN_WINDOW";
+            case OPT_AUDIO_PACING:        return "AUDIO_PACING";
+            case OPT_EMULATION_SPEED:     return "EMULATION_SPEED";
+            case OPT_POWER_SAVING:        return "POWER_SAVING";
                 
             case OPT_CIA_REVISION:        return "CIA_REVISION";
             case OPT_TIMER_B_BUG:         return "TIMER_B_BUG";
@@ -86,14 +96,34 @@ struct OptionEnum : Reflection<OptionEnum, Option> {
                 
             case OPT_SID_ENGINE:          return "SID_ENGINE";
             case OPT_SID_SAMPLING:        return "SID_SAMPLING";
+            case OPT_SID_PARALLEL:        return "SID_PARALLEL";
+            case OPT_AUDIO_LAYOUT:        return "AUDIO_LAYOUT";
                 
             case OPT_RAM_PATTERN:         return "RAM_PATTERN";
                 
             case OPT_DRIVE_TYPE:          return "DRIVE_TYPE";
             case OPT_DRIVE_CONNECT:       return "DRIVE_CONNECT";
             case OPT_DRIVE_POWER_SWITCH:  return "DRIVE_POWER_SWITCH";
+            case OPT_DRIVE_IDLE_SLEEP:    return "DRIVE_IDLE_SLEEP";
+            case OPT_DRIVE_FAST_LOAD:     return "DRIVE_FAST_LOAD";
+            case OPT_IEC_TURBO:           return "IEC_TURBO";
+                
+            case OPT_DATASETTE_TURBO:     return "DATASETTE_TURBO";
                 
             case OPT_DEBUGCART:           return "DEBUGCART";
+            case OPT_DEBUG_PORT:          return "DEBUG_PORT";
+            case OPT_UNDO_JOURNAL:        return "UNDO_JOURNAL";
+                
+            case OPT_HEADLESS:            return "HEADLESS";
+            case OPT_PROFILER:            return "PROFILER";
+            case OPT_PERF_INTERVAL:       return "PERF_INTERVAL";
+            case OPT_DRIVE_SPECULATION:   return "DRIVE_SPECULATION";
+            case OPT_BOOT_CACHE:          return "BOOT_CACHE";
+                
+            case OPT_THREAD_AFFINITY:     return "THREAD_AFFINITY";
+            case OPT_THREAD_PRIORITY:     return "THREAD_PRIORITY";
+            case OPT_THREAD_ROUND_ROBIN:  return "THREAD_ROUND_ROBIN";
+            case OPT_THREAD_QOS:          return "THREAD_QOS";
 
             case OPT_COUNT:               return "???";
         }
@@ -193,6 +223,141 @@ struct InspectionTargetEnum : Reflection<InspectionTargetEnum, InspectionTarget>
     }
 };
 
+struct HeadlessExitEnum : Reflection<HeadlessExitEnum, HeadlessExit> {
+    
+    static bool isValid(long value)
+    {
+        return (unsigned long)value < HEADLESS_EXIT_COUNT;
+    }
+    
+    static const char *prefix() { return "HEADLESS_EXIT"; }
+    static const char *key(HeadlessExit value)
+    {
+        switch (value) {
+                
+            case HEADLESS_EXIT_FRAME_LIMIT:  return "FRAME_LIMIT";
+            case HEADLESS_EXIT_CYCLE_LIMIT:  return "CYCLE_LIMIT";
+            case HEADLESS_EXIT_PATTERN:      return "PATTERN";
+            case HEADLESS_EXIT_PC:           return "PC";
+            case HEADLESS_EXIT_PREDICATE:    return "PREDICATE";
+            case HEADLESS_EXIT_JAMMED:       return "JAMMED";
+            case HEADLESS_EXIT_BREAKPOINT:   return "BREAKPOINT";
+            case HEADLESS_EXIT_STOP:         return "STOP";
+            case HEADLESS_EXIT_GUEST:        return "GUEST";
+            case HEADLESS_EXIT_INVALID:      return "INVALID";
+            case HEADLESS_EXIT_COUNT:        return "???";
+        }
+        return "???";
+    }
+};
+
+struct ThreadRoleEnum : Reflection<ThreadRoleEnum, ThreadRole> {
+    
+    static bool isValid(long value)
+    {
+        return (unsigned long)value < THREAD_ROLE_COUNT;
+    }
+    
+    static const char *prefix() { return "THREAD_ROLE"; }
+    static const char *key(ThreadRole value)
+    {
+        switch (value) {
+                
+            case THREAD_ROLE_EMULATOR:  return "EMULATOR";
+            case THREAD_ROLE_HELPER:    return "HELPER";
+            case THREAD_ROLE_COUNT:     return "???";
+        }
+        return "???";
+    }
+};
+
+struct BenchmarkWorkloadEnum : Reflection<BenchmarkWorkloadEnum, BenchmarkWorkload> {
+    
+    static bool isValid(long value)
+    {
+        return (unsigned long)value < BENCHMARK_COUNT;
+    }
+    
+    static const char *prefix() { return "BENCHMARK"; }
+    static const char *key(BenchmarkWorkload value)
+    {
+        switch (value) {
+                
+            case BENCHMARK_IDLE:       return "IDLE";
+            case BENCHMARK_SPRITES:    return "SPRITES";
+            case BENCHMARK_SID:        return "SID";
+            case BENCHMARK_DRIVES:     return "DRIVES";
+            case BENCHMARK_TAPE:       return "TAPE";
+            case BENCHMARK_EASYFLASH:  return "EASYFLASH";
+            case BENCHMARK_COUNT:      return "???";
+        }
+        return "???";
+    }
+};
+
+struct ChipCoreEnum : Reflection<ChipCoreEnum, ChipCore> {
+    
+    static bool isValid(long value)
+    {
+        return (unsigned long)value < CORE_COUNT;
+    }
+    
+    static const char *prefix() { return "CORE"; }
+    static const char *key(ChipCore value)
+    {
+        switch (value) {
+                
+            case CORE_CPU:      return "CPU";
+            case CORE_VICII:    return "VICII";
+            case CORE_RESID:    return "RESID";
+            case CORE_FASTSID:  return "FASTSID";
+            case CORE_DRIVE:    return "DRIVE";
+            case CORE_COUNT:    return "???";
+        }
+        return "???";
+    }
+};
+
+struct FrameFormatEnum : Reflection<FrameFormatEnum, FrameFormat> {
+    
+    static bool isValid(long value)
+    {
+        return (unsigned long)value < FRAME_FORMAT_COUNT;
+    }
+    
+    static const char *prefix() { return "FRAME_FORMAT"; }
+    static const char *key(FrameFormat value)
+    {
+        switch (value) {
+                
+            case FRAME_FORMAT_PNG:    return "PNG";
+            case FRAME_FORMAT_RAW:    return "RAW";
+            case FRAME_FORMAT_COUNT:  return "???";
+        }
+        return "???";
+    }
+};
+
+struct FuzzTargetEnum : Reflection<FuzzTargetEnum, FuzzTarget> {
+    
+    static bool isValid(long value)
+    {
+        return (unsigned long)value < FUZZ_TARGET_COUNT;
+    }
+    
+    static const char *prefix() { return "FUZZ_TARGET"; }
+    static const char *key(FuzzTarget value)
+    {
+        switch (value) {
+                
+            case FUZZ_TARGET_RAM:    return "RAM";
+            case FUZZ_TARGET_DISK:   return "DISK";
+            case FUZZ_TARGET_COUNT:  return "???";
+        }
+        return "???";
+    }
+};
+
 struct ErrorCodeEnum : Reflection<ErrorCodeEnum, ErrorCode> {
     
     static bool isValid(long value)
@@ -237,6 +402,12 @@ struct ErrorCodeEnum : Reflection<ErrorCodeEnum, ErrorCode> {
             case ERROR_FS_EXPECTED_VAL:     return "FS_EXPECTED_VAL";
             case ERROR_FS_EXPECTED_MIN:     return "FS_EXPECTED_MIN";
             case ERROR_FS_EXPECTED_MAX:     return "FS_EXPECTED_MAX";
+                
+            case ERROR_GUARD_SYNTAX:        return "GUARD_SYNTAX";
+                
+            case ERROR_REC_LAUNCH:          return "REC_LAUNCH";
+                
+            case ERROR_OPT_INV_ARG:         return "OPT_INV_ARG";
 
             case ERROR_COUNT:               return "???";
         }
@@ -258,6 +429,11 @@ enum_int(ACTION_FLAG)
     ACTION_FLAG_BREAKPOINT    = 0b00010000,
     ACTION_FLAG_WATCHPOINT    = 0b00100000,
     ACTION_FLAG_AUTO_SNAPSHOT = 0b01000000,
-    ACTION_FLAG_USER_SNAPSHOT = 0b10000000
+    ACTION_FLAG_USER_SNAPSHOT = 0b10000000,
+    ACTION_FLAG_AUTO_SAVE     = 0b100000000,
+    ACTION_FLAG_INPUT_SYNC    = 0b1000000000,
+    ACTION_FLAG_COMMAND       = 0b10000000000,
+    ACTION_FLAG_EXIT_ADDR     = 0b100000000000,
+    ACTION_FLAG_GUEST_EXIT    = 0b1000000000000
 };
 typedef ACTION_FLAG ActionFlag;
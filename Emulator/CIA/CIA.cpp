@@ -110,13 +110,14 @@ CIA::_inspect()
         info.idleTotal = idleTotal();
         info.idlePercentage =  cpu.cycle ? (double)idleCycles / (double)cpu.cycle : 100.0;
     }
+    
+    latestInfo.publish(info);
 }
 
 void
 CIA::_dump() const
 {
     msg("                Sleeping : %s\n", sleeping ? "yes" : "no");
-    msg("               Tiredness : %d\n", tiredness);
     msg(" Most recent sleep cycle : %lld\n", sleepCycle);
     msg("Most recent wakeup cycle : %lld\n", wakeUpCycle);
     msg("\n");
@@ -207,6 +208,7 @@ CIA::triggerSerialIrq()
 void
 CIA::todInterrupt()
 {
+    wakeUp();
     delay |= CIATODInt0;
 }
 
@@ -522,18 +524,12 @@ CIA::executeOneCycle()
     // Move delay flags left and feed in new bits
     delay = ((delay << 1) & DelayMask) | feed;
     
-    // Get tired if nothing has happened in this cycle
-    if (oldDelay == delay && oldFeed == feed) tiredness++; else tiredness = 0;
-    
-    // Sleep if threshold is reached
-    if (tiredness > 8 && !CIA_ON_STEROIDS) sleep();
-}
-
-void
-CIA::incrementTOD()
-{
-    wakeUp();
-    tod.increment();
+    /* Sleep if the pipeline has reached a fixed point. From now on, only the
+     * counters change until the next timer underflow, which is predicted in
+     * sleep(). All other events (register accesses, TOD alarms) wake the chip
+     * up explicitly.
+     */
+    if (oldDelay == delay && oldFeed == feed && !CIA_ON_STEROIDS) sleep();
 }
 
 void
@@ -554,7 +550,6 @@ CIA::sleep()
     // ZZzzz
     sleepCycle = cpu.cycle;
     wakeUpCycle = sleep;
-    tiredness = 0;
     sleeping = true;
 }
 
@@ -591,6 +586,7 @@ CIA::wakeUp(Cycle targetCycle)
     }
 
     sleeping = false;
+    c64.rescheduleEvents();
 }
 
 Cycle
@@ -815,8 +811,16 @@ CIA2::portBinternal() const
 u8
 CIA2::portBexternal() const
 {
-    // User port is not implemented. All pins are high if nothing is connected.
-    return 0xFF;
+    return userPort;
+}
+
+void
+CIA2::setUserPort(u8 value)
+{
+    if (userPort == value) return;
+    
+    userPort = value;
+    updatePB();
 }
 
 void
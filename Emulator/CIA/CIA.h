@@ -62,8 +62,9 @@ class CIA : public C64Component {
     // Current configuration
     CIAConfig config;
     
-    // Result of the latest inspection
+    // Result of the latest inspection (the published copy is read by the GUI)
     CIAInfo info;
+    InfoRecord<CIAInfo> latestInfo;
     
     
     //
@@ -194,17 +195,16 @@ private:
     bool CNT;
 	bool INT;
 
+    /* Cycle in which the PC pin has been pulled low. The pin goes low for one
+     * cycle after each access to data port B (handshake output).
+     */
+    Cycle pcCycle;
+
     
     //
     // Speeding up emulation (sleep logic)
     //
     
-    /* Idle counter. When the CIA's state does not change during execution,
-     * this variable is increased by one. If it exceeds a certain threshhold,
-     * the chip is put into idle state via sleep().
-     */
-    u8 tiredness;
-
     // Total number of skipped cycles (used by the debugger, only)
     Cycle idleCycles;
         
@@ -257,7 +257,7 @@ public:
 
 public:
     
-    CIAInfo getInfo() { return HardwareComponent::getInfo(info); }
+    CIAInfo getInfo() { return HardwareComponent::getInfo(latestInfo); }
     
 protected:
     
@@ -310,7 +310,7 @@ private:
         & serCounter
         & CNT
         & INT
-        & tiredness
+        & pcCycle
         & idleCycles
         & sleeping
         & sleepCycle
@@ -318,8 +318,10 @@ private:
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
     
         
     //
@@ -390,6 +392,9 @@ public:
     void triggerRisingEdgeOnFlagPin();
     void triggerFallingEdgeOnFlagPin();
     
+    // Returns the cycle in which the PC pin has been pulled low
+    Cycle getPCCycle() const { return pcCycle; }
+    
     
     //
     // Handling interrupts
@@ -427,8 +432,8 @@ public:
 	// Executes the CIA for one cycle
 	void executeOneCycle();
     
-	// Increments the TOD clock by one tenth of a second
-	void incrementTOD();
+    // Services the TOD clock at the end of a frame (see TOD)
+    void serviceTOD() { tod.serviceAlarm(); }
 
  
     //
@@ -493,6 +498,12 @@ private:
 
 class CIA2 : public CIA {
 
+    /* Value driven into port B from the user port. All pins are high if
+     * nothing is connected. The value belongs to the connected cable (see
+     * C64Link) and is therefore not part of the snapshot.
+     */
+    u8 userPort = 0xFF;
+    
 public:
 
     CIA2(C64 &ref) : CIA(ref) { };
@@ -514,6 +525,12 @@ public:
     
     void updatePA() override;
     
+    // Returns the value driven onto the user port (input pins are high)
+    u8 getUserPortOutput() const { return portBinternal() | ~DDRB; }
+    
+    // Drives the user port pins from the outside
+    void setUserPort(u8 value);
+    
 private:
     
     u8 portBinternal() const override;
@@ -27,6 +27,7 @@ CIA::peek(u16 addr)
 
         case 0x01: // CIA_DATA_PORT_B
         {
+            pcCycle = cpu.cycle;
             updatePB();
             return PB;
         }
@@ -219,6 +220,7 @@ CIA::poke(u16 addr, u8 value)
         case 0x01: // CIA_DATA_PORT_B
             
             PRB = value;
+            pcCycle = cpu.cycle;
             updatePB();
             return;
             
@@ -9,6 +9,46 @@
 
 #include "C64.h"
 
+// Number of tenths of a second per day
+static constexpr i64 tenthsPerDay = 24 * 60 * 60 * 10;
+
+/* Returns the position of a time in the daily cycle of the clock in tenths of
+ * a second or -1 if the time contains digits the clock never runs through.
+ */
+static i64 position(TimeOfDay time)
+{
+    auto bcd = [](u8 value, u8 max) -> i64 {
+        if ((value & 0xF) > 9 || value > max) return -1;
+        return (value >> 4) * 10 + (value & 0xF);
+    };
+    
+    i64 hr = bcd(time.hour & 0x1F, 0x12);
+    i64 min = bcd(time.min, 0x59);
+    i64 sec = bcd(time.sec, 0x59);
+    i64 tenth = bcd(time.tenth, 0x09);
+    
+    if (hr < 1 || min < 0 || sec < 0 || tenth < 0) return -1;
+    
+    // The clock counts 12 AM, 1 AM, ..., 11 AM, 12 PM, 1 PM, ..., 11 PM
+    hr = (hr == 12 ? 0 : hr) + ((time.hour & 0x80) ? 12 : 0);
+    return ((hr * 60 + min) * 60 + sec) * 10 + tenth;
+}
+
+// Inverse of position()
+static TimeOfDay timeAt(i64 pos)
+{
+    auto bcd = [](i64 value) { return (u8)((value / 10) << 4 | (value % 10)); };
+    
+    TimeOfDay result;
+    result.tenth = bcd(pos % 10);
+    result.sec = bcd(pos / 10 % 60);
+    result.min = bcd(pos / 600 % 60);
+    
+    i64 hr = pos / 36000;
+    result.hour = bcd(hr % 12 == 0 ? 12 : hr % 12) | (hr >= 12 ? 0x80 : 0);
+    return result;
+}
+
 TOD::TOD(C64 &ref, CIA &ciaref) : C64Component(ref), cia(ciaref)
 {
 }
@@ -24,10 +64,12 @@ TOD::_inspect()
 {
     synchronized {
         
-        info.time = tod;
+        info.time = current();
         info.latch = latch;
         info.alarm = alarm;
     }
+    
+    latestInfo.publish(info);
 }
 
 void
@@ -38,11 +80,15 @@ TOD::_reset()
     tod.hour = 1;
     stopped = true;
     hz = 60;
+    syncFrame = c64.frame;
+    alarmFrame = UINT64_MAX;
 }
 
 void 
 TOD::_dump() const
 {
+    TimeOfDay tod = current();
+    
 	msg("            Time of day : %02X:%02X:%02X:%02X\n",
         tod.hour, tod.min, tod.sec, tod.tenth);
 	msg("                  Alarm : %02X:%02X:%02X:%02X\n",
@@ -55,14 +101,21 @@ TOD::_dump() const
 }
 
 void
-TOD::increment()
+TOD::setHz(u8 value)
 {
-    if (stopped)
-        return;
-    
-    if (++frequencyCounter % hz != 0)
-        return;
+    assert(value == 5 || value == 6);
     
+    if (hz != value) {
+        
+        update();
+        hz = value;
+        scheduleAlarm();
+    }
+}
+
+void
+TOD::increment(TimeOfDay &tod)
+{
     // 1/10 seconds
     if (tod.tenth != 0x09) {
         tod.tenth = incBCD(tod.tenth);
@@ -102,9 +155,92 @@ TOD::increment()
             }
         }
     }
+}
 
-    checkIrq(); 
-    return;
+TimeOfDay
+TOD::current() const
+{
+    TimeOfDay result = tod;
+    
+    if (!stopped && c64.frame > syncFrame) {
+        
+        // Apply all increments that have happened since the last update
+        u64 counter = frequencyCounter + (c64.frame - syncFrame);
+        u64 ticks = counter / hz - frequencyCounter / hz;
+        
+        if (i64 pos = position(result); pos >= 0) {
+            result = timeAt((pos + (i64)(ticks % tenthsPerDay)) % tenthsPerDay);
+        } else {
+            // Invalid digits are serviced on each increment (see scheduleAlarm())
+            while (ticks--) increment(result);
+        }
+    }
+    return result;
+}
+
+void
+TOD::update()
+{
+    // The frame counter restarts on reset
+    if (c64.frame < syncFrame) syncFrame = c64.frame;
+    
+    u64 frames = c64.frame - syncFrame;
+    syncFrame = c64.frame;
+    
+    if (stopped) return;
+    
+    // Apply all increments one by one to detect alarm matches
+    while (frames) {
+        
+        u64 step = hz - frequencyCounter % hz;
+        
+        if (step > frames) {
+            frequencyCounter += frames;
+            break;
+        }
+        frequencyCounter += step;
+        frames -= step;
+        
+        increment(tod);
+        checkIrq();
+    }
+    
+    scheduleAlarm();
+}
+
+void
+TOD::serviceAlarm()
+{
+    if (c64.frame >= alarmFrame) update();
+}
+
+void
+TOD::scheduleAlarm()
+{
+    if (stopped) {
+        alarmFrame = UINT64_MAX;
+        return;
+    }
+    
+    // Number of frames until the next increment
+    u64 next = hz - frequencyCounter % hz;
+    
+    i64 t = position(tod);
+    i64 a = position(alarm);
+    
+    if (t < 0 || a < 0) {
+        
+        // Fall back to servicing each increment
+        alarmFrame = syncFrame + next;
+        
+    } else {
+        
+        // Number of increments until the alarm time is reached
+        i64 distance = (a - t + tenthsPerDay) % tenthsPerDay;
+        if (distance == 0) distance = tenthsPerDay;
+        
+        alarmFrame = syncFrame + next + (u64)(distance - 1) * hz;
+    }
 }
 
 void
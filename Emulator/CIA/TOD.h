@@ -22,6 +22,10 @@ inline u8 incBCD(u8 x)
  * hours, minutes, seconds and tenths of a second. Furthermore, every TOD clock
  * features an alarm mechanism. When the alarm time is reached, an interrupt
  * is triggered.
+ *
+ * The clock is evaluated lazily. It is advanced to the current frame when it
+ * is written to or when the alarm time is reached. Reading the clock computes
+ * the current time arithmetically without modifying the state.
  */
 class TOD : public C64Component {
     
@@ -29,8 +33,9 @@ class TOD : public C64Component {
     
 private:
     
-    // Result of the latest inspection
+    // Result of the latest inspection (the published copy is read by the GUI)
     TODInfo info;
+    InfoRecord<TODInfo> latestInfo;
     
     // Reference to the connected CIA
     CIA &cia;
@@ -76,6 +81,12 @@ private:
      */
     u64 frequencyCounter;
     
+    // The frame the clock has been advanced to (see update())
+    u64 syncFrame;
+    
+    // The frame in which the alarm time is reached next (see scheduleAlarm())
+    u64 alarmFrame;
+    
     
     //
     // Initializing
@@ -98,10 +109,10 @@ private:
 public:
     
     // Returns the result of the most recent call to inspect()
-    TODInfo getInfo() { return HardwareComponent::getInfo(info); }
+    TODInfo getInfo() { return HardwareComponent::getInfo(latestInfo); }
     
     // Sets the frequency of the driving clock
-    void setHz(u8 value) { assert(value == 5 || value == 6); hz = value; }
+    void setHz(u8 value);
 
     
     //
@@ -137,12 +148,16 @@ private:
         & stopped
         & matching
         & hz
-        & frequencyCounter;
+        & frequencyCounter
+        & syncFrame
+        & alarmFrame;
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
     
     
     //
@@ -150,52 +165,52 @@ private:
     //
 
     // Returns the hours digits of the time of day clock
-     u8 getTodHours() const { return (frozen ? latch.hour : tod.hour) & 0x9F; }
-
-     // Returns the minutes digits of the time of day clock
-     u8 getTodMinutes() const { return (frozen ? latch.min : tod.min) & 0x7F; }
-
-     // Returns the seconds digits of the time of day clock
-     u8 getTodSeconds() const { return (frozen ? latch.sec : tod.sec) & 0x7F; }
-
-     // Returns the tenth-of-a-second digits of the time of day clock
-     u8 getTodTenth() const { return (frozen ? latch.tenth : tod.tenth) & 0x0F; }
-
-     // Returns the hours digits of the alarm time
-     u8 getAlarmHours() const { return alarm.hour & 0x9F; }
-
-     // Returns the minutes digits of the alarm time
-     u8 getAlarmMinutes() const { return alarm.min & 0x7F; }
-
-     // Returns the seconds digits of the alarm time
-     u8 getAlarmSeconds() const { return alarm.sec & 0x7F; }
-
-     // Returns the tenth-of-a-second digits of the alarm time
-     u8 getAlarmTenth() const { return alarm.tenth & 0x0F; }
-     
-     // Sets the hours digits of the time of day clock
-     void setTodHours(u8 value) { tod.hour = value & 0x9F; checkIrq(); }
-     
-     // Sets the minutes digits of the time of day clock
-     void setTodMinutes(u8 value) { tod.min = value & 0x7F; checkIrq(); }
-     
-     // Sets the seconds digits of the time of day clock
-     void setTodSeconds(u8 value) { tod.sec = value & 0x7F; checkIrq(); }
-     
-     // Sets the tenth-of-a-second digits of the time of day clock
-     void setTodTenth(u8 value) { tod.tenth = value & 0x0F; checkIrq(); }
-     
-     // Sets the hours digits of the alarm time
-     void setAlarmHours(u8 value) { alarm.hour = value & 0x9F; checkIrq(); }
-     
-     // Sets the minutes digits of the alarm time
-     void setAlarmMinutes(u8 value) { alarm.min = value & 0x7F; checkIrq(); }
-     
-     // Sets the seconds digits of the alarm time
-     void setAlarmSeconds(u8 value) { alarm.sec = value & 0x7F; checkIrq(); }
-     
-     // Sets the tenth-of-a-second digits of the time of day clock
-     void setAlarmTenth(u8 value) { alarm.tenth = value & 0x0F; checkIrq(); }
+    u8 getTodHours() const { return (frozen ? latch : current()).hour & 0x9F; }
+
+    // Returns the minutes digits of the time of day clock
+    u8 getTodMinutes() const { return (frozen ? latch : current()).min & 0x7F; }
+
+    // Returns the seconds digits of the time of day clock
+    u8 getTodSeconds() const { return (frozen ? latch : current()).sec & 0x7F; }
+
+    // Returns the tenth-of-a-second digits of the time of day clock
+    u8 getTodTenth() const { return (frozen ? latch : current()).tenth & 0x0F; }
+
+    // Returns the hours digits of the alarm time
+    u8 getAlarmHours() const { return alarm.hour & 0x9F; }
+
+    // Returns the minutes digits of the alarm time
+    u8 getAlarmMinutes() const { return alarm.min & 0x7F; }
+
+    // Returns the seconds digits of the alarm time
+    u8 getAlarmSeconds() const { return alarm.sec & 0x7F; }
+
+    // Returns the tenth-of-a-second digits of the alarm time
+    u8 getAlarmTenth() const { return alarm.tenth & 0x0F; }
+    
+    // Sets the hours digits of the time of day clock
+    void setTodHours(u8 value) { update(); tod.hour = value & 0x9F; checkIrq(); scheduleAlarm(); }
+    
+    // Sets the minutes digits of the time of day clock
+    void setTodMinutes(u8 value) { update(); tod.min = value & 0x7F; checkIrq(); scheduleAlarm(); }
+    
+    // Sets the seconds digits of the time of day clock
+    void setTodSeconds(u8 value) { update(); tod.sec = value & 0x7F; checkIrq(); scheduleAlarm(); }
+    
+    // Sets the tenth-of-a-second digits of the time of day clock
+    void setTodTenth(u8 value) { update(); tod.tenth = value & 0x0F; checkIrq(); scheduleAlarm(); }
+    
+    // Sets the hours digits of the alarm time
+    void setAlarmHours(u8 value) { update(); alarm.hour = value & 0x9F; checkIrq(); scheduleAlarm(); }
+    
+    // Sets the minutes digits of the alarm time
+    void setAlarmMinutes(u8 value) { update(); alarm.min = value & 0x7F; checkIrq(); scheduleAlarm(); }
+    
+    // Sets the seconds digits of the alarm time
+    void setAlarmSeconds(u8 value) { update(); alarm.sec = value & 0x7F; checkIrq(); scheduleAlarm(); }
+    
+    // Sets the tenth-of-a-second digits of the time of day clock
+    void setAlarmTenth(u8 value) { update(); alarm.tenth = value & 0x0F; checkIrq(); scheduleAlarm(); }
 
     
     //
@@ -205,20 +220,34 @@ private:
 private:
     
     // Freezes the time of day clock
-    void freeze() { if (!frozen) { latch.value = tod.value; frozen = true; } }
+    void freeze() { if (!frozen) { latch.value = current().value; frozen = true; } }
     
     // Unfreezes the time of day clock
     void defreeze() { frozen = false; }
     
     // Stops the time of day clock
-    void stop() { frequencyCounter = 0; stopped = true; }
+    void stop() { update(); frequencyCounter = 0; stopped = true; scheduleAlarm(); }
     
     // Starts the time of day clock
-    void cont() { stopped = false; }
+    void cont() { update(); stopped = false; scheduleAlarm(); }
  	
-	// Increments the TOD clock by one tenth of a second
-	void increment();
+	// Increments a time by one tenth of a second
+	static void increment(TimeOfDay &time);
 
+    // Returns the time of day clock as it appears in the current frame
+    TimeOfDay current() const;
+    
+    // Advances the time of day clock to the current frame
+    void update();
+    
     // Updates variable 'matching'. A positive edge triggers an interrupt.
     void checkIrq();
+    
+    // Computes the frame in which the alarm time is reached next
+    void scheduleAlarm();
+    
+public:
+    
+    // Advances the clock if the alarm time is reached in the current frame
+    void serviceAlarm();
 };
@@ -0,0 +1,509 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+#include "BatchCPU.h"
+
+BatchCPU::Handler BatchCPU::handlers[256] = { };
+u8 BatchCPU::cycleTable[256] = { };
+
+BatchCPU::BatchCPU(usize lanes) : lanes(lanes)
+{
+    assert(lanes > 0 && lanes <= UINT32_MAX);
+
+    // The tables are shared by all instances
+    static const bool registered = (registerInstructions(), true);
+    (void)registered;
+
+    pc.assign(lanes, 0);
+    a.assign(lanes, 0);
+    x.assign(lanes, 0);
+    y.assign(lanes, 0);
+    sp.assign(lanes, 0xFF);
+    p.assign(lanes, 0x20 | I_FLAG);
+    cycles.assign(lanes, 0);
+    state.assign(lanes, LANE_EXIT);
+    ram.assign(lanes * 0x10000, 0);
+
+    active.reserve(lanes);
+    order.resize(lanes);
+    opcodes.resize(lanes);
+}
+
+template <AddressingMode M, BatchCPU::Operation O> void
+BatchCPU::registerInstruction(u8 opcode, u8 cycles)
+{
+    handlers[opcode] = &BatchCPU::execute<M, O>;
+    cycleTable[opcode] = cycles;
+}
+
+void
+BatchCPU::registerInstructions()
+{
+    // Instructions sharing the addressing modes of the ALU group
+    #define ALU(base, op) \
+    registerInstruction<ADDR_INDIRECT_X, op>(base + 0x01, 6); \
+    registerInstruction<ADDR_ZERO_PAGE, op>(base + 0x05, 3); \
+    registerInstruction<ADDR_IMMEDIATE, op>(base + 0x09, 2); \
+    registerInstruction<ADDR_ABSOLUTE, op>(base + 0x0D, 4); \
+    registerInstruction<ADDR_INDIRECT_Y, op>(base + 0x11, 5); \
+    registerInstruction<ADDR_ZERO_PAGE_X, op>(base + 0x15, 4); \
+    registerInstruction<ADDR_ABSOLUTE_Y, op>(base + 0x19, 4); \
+    registerInstruction<ADDR_ABSOLUTE_X, op>(base + 0x1D, 4);
+
+    // Read-modify-write instructions
+    #define RMW(base, op) \
+    registerInstruction<ADDR_ZERO_PAGE, op>(base + 0x06, 5); \
+    registerInstruction<ADDR_ABSOLUTE, op>(base + 0x0E, 6); \
+    registerInstruction<ADDR_ZERO_PAGE_X, op>(base + 0x16, 6); \
+    registerInstruction<ADDR_ABSOLUTE_X, op>(base + 0x1E, 7);
+
+    ALU(0x00, OP_ORA);
+    ALU(0x20, OP_AND);
+    ALU(0x40, OP_EOR);
+    ALU(0x60, OP_ADC);
+    ALU(0xA0, OP_LDA);
+    ALU(0xC0, OP_CMP);
+    ALU(0xE0, OP_SBC);
+
+    registerInstruction<ADDR_INDIRECT_X, OP_STA>(0x81, 6);
+    registerInstruction<ADDR_ZERO_PAGE, OP_STA>(0x85, 3);
+    registerInstruction<ADDR_ABSOLUTE, OP_STA>(0x8D, 4);
+    registerInstruction<ADDR_INDIRECT_Y, OP_STA>(0x91, 6);
+    registerInstruction<ADDR_ZERO_PAGE_X, OP_STA>(0x95, 4);
+    registerInstruction<ADDR_ABSOLUTE_Y, OP_STA>(0x99, 5);
+    registerInstruction<ADDR_ABSOLUTE_X, OP_STA>(0x9D, 5);
+
+    RMW(0x00, OP_ASL);
+    RMW(0x20, OP_ROL);
+    RMW(0x40, OP_LSR);
+    RMW(0x60, OP_ROR);
+    RMW(0xC0, OP_DEC);
+    RMW(0xE0, OP_INC);
+
+    registerInstruction<ADDR_ACCUMULATOR, OP_ASL>(0x0A, 2);
+    registerInstruction<ADDR_ACCUMULATOR, OP_ROL>(0x2A, 2);
+    registerInstruction<ADDR_ACCUMULATOR, OP_LSR>(0x4A, 2);
+    registerInstruction<ADDR_ACCUMULATOR, OP_ROR>(0x6A, 2);
+
+    registerInstruction<ADDR_IMMEDIATE, OP_LDX>(0xA2, 2);
+    registerInstruction<ADDR_ZERO_PAGE, OP_LDX>(0xA6, 3);
+    registerInstruction<ADDR_ABSOLUTE, OP_LDX>(0xAE, 4);
+    registerInstruction<ADDR_ZERO_PAGE_Y, OP_LDX>(0xB6, 4);
+    registerInstruction<ADDR_ABSOLUTE_Y, OP_LDX>(0xBE, 4);
+
+    registerInstruction<ADDR_IMMEDIATE, OP_LDY>(0xA0, 2);
+    registerInstruction<ADDR_ZERO_PAGE, OP_LDY>(0xA4, 3);
+    registerInstruction<ADDR_ABSOLUTE, OP_LDY>(0xAC, 4);
+    registerInstruction<ADDR_ZERO_PAGE_X, OP_LDY>(0xB4, 4);
+    registerInstruction<ADDR_ABSOLUTE_X, OP_LDY>(0xBC, 4);
+
+    registerInstruction<ADDR_ZERO_PAGE, OP_STX>(0x86, 3);
+    registerInstruction<ADDR_ABSOLUTE, OP_STX>(0x8E, 4);
+    registerInstruction<ADDR_ZERO_PAGE_Y, OP_STX>(0x96, 4);
+
+    registerInstruction<ADDR_ZERO_PAGE, OP_STY>(0x84, 3);
+    registerInstruction<ADDR_ABSOLUTE, OP_STY>(0x8C, 4);
+    registerInstruction<ADDR_ZERO_PAGE_X, OP_STY>(0x94, 4);
+
+    registerInstruction<ADDR_IMMEDIATE, OP_CPX>(0xE0, 2);
+    registerInstruction<ADDR_ZERO_PAGE, OP_CPX>(0xE4, 3);
+    registerInstruction<ADDR_ABSOLUTE, OP_CPX>(0xEC, 4);
+
+    registerInstruction<ADDR_IMMEDIATE, OP_CPY>(0xC0, 2);
+    registerInstruction<ADDR_ZERO_PAGE, OP_CPY>(0xC4, 3);
+    registerInstruction<ADDR_ABSOLUTE, OP_CPY>(0xCC, 4);
+
+    registerInstruction<ADDR_ZERO_PAGE, OP_BIT>(0x24, 3);
+    registerInstruction<ADDR_ABSOLUTE, OP_BIT>(0x2C, 4);
+
+    registerInstruction<ADDR_RELATIVE, OP_BPL>(0x10, 2);
+    registerInstruction<ADDR_RELATIVE, OP_BMI>(0x30, 2);
+    registerInstruction<ADDR_RELATIVE, OP_BVC>(0x50, 2);
+    registerInstruction<ADDR_RELATIVE, OP_BVS>(0x70, 2);
+    registerInstruction<ADDR_RELATIVE, OP_BCC>(0x90, 2);
+    registerInstruction<ADDR_RELATIVE, OP_BCS>(0xB0, 2);
+    registerInstruction<ADDR_RELATIVE, OP_BNE>(0xD0, 2);
+    registerInstruction<ADDR_RELATIVE, OP_BEQ>(0xF0, 2);
+
+    registerInstruction<ADDR_IMPLIED, OP_BRK>(0x00, 7);
+    registerInstruction<ADDR_DIRECT, OP_JSR>(0x20, 6);
+    registerInstruction<ADDR_IMPLIED, OP_RTI>(0x40, 6);
+    registerInstruction<ADDR_IMPLIED, OP_RTS>(0x60, 6);
+    registerInstruction<ADDR_DIRECT, OP_JMP>(0x4C, 3);
+    registerInstruction<ADDR_INDIRECT, OP_JMP>(0x6C, 5);
+
+    registerInstruction<ADDR_IMPLIED, OP_PHP>(0x08, 3);
+    registerInstruction<ADDR_IMPLIED, OP_PLP>(0x28, 4);
+    registerInstruction<ADDR_IMPLIED, OP_PHA>(0x48, 3);
+    registerInstruction<ADDR_IMPLIED, OP_PLA>(0x68, 4);
+
+    registerInstruction<ADDR_IMPLIED, OP_CLC>(0x18, 2);
+    registerInstruction<ADDR_IMPLIED, OP_SEC>(0x38, 2);
+    registerInstruction<ADDR_IMPLIED, OP_CLI>(0x58, 2);
+    registerInstruction<ADDR_IMPLIED, OP_SEI>(0x78, 2);
+    registerInstruction<ADDR_IMPLIED, OP_CLV>(0xB8, 2);
+    registerInstruction<ADDR_IMPLIED, OP_CLD>(0xD8, 2);
+    registerInstruction<ADDR_IMPLIED, OP_SED>(0xF8, 2);
+
+    registerInstruction<ADDR_IMPLIED, OP_DEY>(0x88, 2);
+    registerInstruction<ADDR_IMPLIED, OP_TXA>(0x8A, 2);
+    registerInstruction<ADDR_IMPLIED, OP_TYA>(0x98, 2);
+    registerInstruction<ADDR_IMPLIED, OP_TXS>(0x9A, 2);
+    registerInstruction<ADDR_IMPLIED, OP_TAY>(0xA8, 2);
+    registerInstruction<ADDR_IMPLIED, OP_TAX>(0xAA, 2);
+    registerInstruction<ADDR_IMPLIED, OP_TSX>(0xBA, 2);
+    registerInstruction<ADDR_IMPLIED, OP_INY>(0xC8, 2);
+    registerInstruction<ADDR_IMPLIED, OP_DEX>(0xCA, 2);
+    registerInstruction<ADDR_IMPLIED, OP_INX>(0xE8, 2);
+    registerInstruction<ADDR_IMPLIED, OP_NOP>(0xEA, 2);
+
+    #undef ALU
+    #undef RMW
+}
+
+void
+BatchCPU::importLane(usize lane, const C64 &c64)
+{
+    assert(lane < lanes);
+    assert(c64.cpu.inFetchPhase());
+
+    for (isize addr = 0; addr < 0x10000; addr++) mem((u32)lane, (u16)addr) = c64.mem.ram[addr];
+
+    importRegisters(lane, c64);
+    cycles[lane] = 0;
+}
+
+void
+BatchCPU::exportLane(usize lane, C64 &c64) const
+{
+    assert(lane < lanes);
+
+    for (isize addr = 0; addr < 0x10000; addr++) c64.mem.ram[addr] = mem((u32)lane, (u16)addr);
+    c64.mem.markAllDirty();
+
+    c64.cpu.reg.a = a[lane];
+    c64.cpu.reg.x = x[lane];
+    c64.cpu.reg.y = y[lane];
+    c64.cpu.reg.sp = sp[lane];
+    c64.cpu.setPWithoutB(p[lane]);
+    c64.cpu.jumpToAddress(pc[lane]);
+}
+
+void
+BatchCPU::importRegisters(usize lane, const C64 &c64)
+{
+    assert(lane < lanes);
+    assert(c64.cpu.inFetchPhase());
+
+    pc[lane] = c64.cpu.reg.pc;
+    a[lane] = c64.cpu.reg.a;
+    x[lane] = c64.cpu.reg.x;
+    y[lane] = c64.cpu.reg.y;
+    sp[lane] = c64.cpu.reg.sp;
+    p[lane] = c64.cpu.getPWithClearedB() | 0x20;
+    state[lane] = LANE_RUNNING;
+}
+
+void
+BatchCPU::read(usize lane, u8 *dst, u16 addr, usize count) const
+{
+    assert(lane < lanes && addr + count <= 0x10000);
+
+    for (usize i = 0; i < count; i++) dst[i] = mem((u32)lane, (u16)(addr + i));
+}
+
+void
+BatchCPU::write(usize lane, const u8 *src, u16 addr, usize count)
+{
+    assert(lane < lanes && addr + count <= 0x10000);
+
+    for (usize i = 0; i < count; i++) mem((u32)lane, (u16)(addr + i)) = src[i];
+}
+
+void
+BatchCPU::jump(usize lane, u16 addr)
+{
+    assert(lane < lanes);
+
+    pc[lane] = addr;
+    state[lane] = LANE_RUNNING;
+}
+
+usize
+BatchCPU::run(u64 steps)
+{
+    u32 count[256];
+    u32 start[256];
+
+    active.clear();
+    for (u32 l = 0; l < lanes; l++) if (state[l] == LANE_RUNNING) active.push_back(l);
+
+    for (u64 s = 0; s < steps && !active.empty(); s++) {
+
+        // Fetch the opcodes and count the lanes executing each of them
+        memset(count, 0, sizeof(count));
+        usize n = 0;
+        for (u32 l : active) {
+
+            if (pc[l] == exitAddr) { state[l] = LANE_EXIT; continue; }
+
+            u8 opcode = mem(l, pc[l]);
+            opcodes[l] = opcode;
+            count[opcode]++;
+            active[n++] = l;
+        }
+        active.resize(n);
+        if (n == 0) break;
+
+        // Group the lanes by opcode (the lanes of a group stay in order)
+        const u32 *lanesByOpcode = active.data();
+        if (count[opcodes[active[0]]] != n) {
+
+            u32 pos = 0;
+            for (isize i = 0; i < 256; i++) { start[i] = pos; pos += count[i]; }
+            for (u32 l : active) order[start[opcodes[l]]++] = l;
+            lanesByOpcode = order.data();
+        }
+
+        // Execute all groups
+        for (usize i = 0, pos = 0; i < 256; i++) {
+
+            if (count[i] == 0) continue;
+
+            const u32 *group = lanesByOpcode + pos;
+            pos += count[i];
+
+            if (Handler handler = handlers[i]) {
+                (this->*handler)((u8)i, group, count[i]);
+            } else {
+                for (u32 j = 0; j < count[i]; j++) state[group[j]] = LANE_DIVERGED;
+            }
+            stats.groups++;
+        }
+        stats.steps++;
+
+        // Keep the lanes that are still running
+        n = 0;
+        for (u32 l : active) if (state[l] == LANE_RUNNING) active[n++] = l;
+        active.resize(n);
+    }
+
+    return active.size();
+}
+
+template <AddressingMode M, BatchCPU::Operation O> void
+BatchCPU::execute(u8 opcode, const u32 *group, usize count)
+{
+    u8 base = cycleTable[opcode];
+    u64 executed = 0;
+
+    for (usize i = 0; i < count; i++) {
+
+        u32 l = group[i];
+        isize extra = step<M, O>(l);
+
+        if (extra < 0) {
+
+            state[l] = LANE_DIVERGED;
+            continue;
+        }
+        cycles[l] += base + extra;
+        executed++;
+    }
+    stats.instructions += executed;
+}
+
+template <AddressingMode M, BatchCPU::Operation O> isize
+BatchCPU::step(u32 l)
+{
+    constexpr bool oneByte = M == ADDR_IMPLIED || M == ADDR_ACCUMULATOR;
+    constexpr bool threeBytes =
+    M == ADDR_ABSOLUTE || M == ADDR_ABSOLUTE_X || M == ADDR_ABSOLUTE_Y ||
+    M == ADDR_DIRECT || M == ADDR_INDIRECT;
+
+    // Decimal mode arithmetic is left to the scalar CPU
+    if constexpr (O == OP_ADC || O == OP_SBC) {
+        if (p[l] & D_FLAG) return -1;
+    }
+
+    u16 pc0 = pc[l];
+    u16 next = (u16)(pc0 + (oneByte ? 1 : threeBytes ? 3 : 2));
+    u8 lo = oneByte ? 0 : mem(l, (u16)(pc0 + 1));
+    u8 hi = threeBytes ? mem(l, (u16)(pc0 + 2)) : 0;
+    u16 addr = 0;
+    isize extra = 0;
+
+    // Compute the effective address
+    u16 base = 0;
+    if constexpr (M == ADDR_ZERO_PAGE) addr = lo;
+    if constexpr (M == ADDR_ZERO_PAGE_X) addr = (u8)(lo + x[l]);
+    if constexpr (M == ADDR_ZERO_PAGE_Y) addr = (u8)(lo + y[l]);
+    if constexpr (M == ADDR_ABSOLUTE || M == ADDR_DIRECT) addr = HI_LO(hi, lo);
+    if constexpr (M == ADDR_ABSOLUTE_X) { base = HI_LO(hi, lo); addr = (u16)(base + x[l]); }
+    if constexpr (M == ADDR_ABSOLUTE_Y) { base = HI_LO(hi, lo); addr = (u16)(base + y[l]); }
+    if constexpr (M == ADDR_INDIRECT_X) {
+        u8 ptr = (u8)(lo + x[l]);
+        addr = HI_LO(mem(l, (u8)(ptr + 1)), mem(l, ptr));
+    }
+    if constexpr (M == ADDR_INDIRECT_Y) {
+        base = HI_LO(mem(l, (u8)(lo + 1)), mem(l, lo));
+        addr = (u16)(base + y[l]);
+    }
+    if constexpr (M == ADDR_INDIRECT) {
+        // The high byte is fetched without crossing the page boundary
+        addr = HI_LO(mem(l, HI_LO(hi, (u8)(lo + 1))), mem(l, HI_LO(hi, lo)));
+    }
+
+    // Read accesses take an extra cycle if the page boundary is crossed
+    constexpr bool pagePenalty =
+    (M == ADDR_ABSOLUTE_X || M == ADDR_ABSOLUTE_Y || M == ADDR_INDIRECT_Y) &&
+    (O == OP_ADC || O == OP_AND || O == OP_CMP || O == OP_EOR || O == OP_LDA ||
+     O == OP_LDX || O == OP_LDY || O == OP_ORA || O == OP_SBC);
+    if constexpr (pagePenalty) extra = (base ^ addr) & 0xFF00 ? 1 : 0;
+
+    // Fetch the operand of instructions reading from memory
+    auto operand = [&]() { return M == ADDR_IMMEDIATE ? lo : mem(l, addr); };
+
+    // Branches
+    if constexpr (M == ADDR_RELATIVE) {
+
+        bool taken =
+        O == OP_BPL ? !(p[l] & N_FLAG) :
+        O == OP_BMI ? (p[l] & N_FLAG) :
+        O == OP_BVC ? !(p[l] & V_FLAG) :
+        O == OP_BVS ? (p[l] & V_FLAG) :
+        O == OP_BCC ? !(p[l] & C_FLAG) :
+        O == OP_BCS ? (p[l] & C_FLAG) :
+        O == OP_BNE ? !(p[l] & Z_FLAG) : (p[l] & Z_FLAG);
+
+        if (taken) {
+
+            u16 target = (u16)(next + (i8)lo);
+            extra = (target ^ next) & 0xFF00 ? 2 : 1;
+            next = target;
+        }
+    }
+
+    // Read-modify-write instructions
+    if constexpr (O == OP_ASL || O == OP_LSR || O == OP_ROL || O == OP_ROR ||
+                  O == OP_INC || O == OP_DEC) {
+
+        u8 value = M == ADDR_ACCUMULATOR ? a[l] : mem(l, addr);
+        bool carry = p[l] & C_FLAG;
+
+        if constexpr (O == OP_ASL) { setFlag(l, C_FLAG, value & 0x80); value <<= 1; }
+        if constexpr (O == OP_LSR) { setFlag(l, C_FLAG, value & 0x01); value >>= 1; }
+        if constexpr (O == OP_ROL) {
+            setFlag(l, C_FLAG, value & 0x80); value = (u8)(value << 1 | (carry ? 1 : 0));
+        }
+        if constexpr (O == OP_ROR) {
+            setFlag(l, C_FLAG, value & 0x01); value = (u8)(value >> 1 | (carry ? 0x80 : 0));
+        }
+        if constexpr (O == OP_INC) value++;
+        if constexpr (O == OP_DEC) value--;
+
+        setNZ(l, value);
+        if constexpr (M == ADDR_ACCUMULATOR) a[l] = value; else mem(l, addr) = value;
+    }
+
+    // Loads, stores, and arithmetic
+    if constexpr (O == OP_LDA) { a[l] = operand(); setNZ(l, a[l]); }
+    if constexpr (O == OP_LDX) { x[l] = operand(); setNZ(l, x[l]); }
+    if constexpr (O == OP_LDY) { y[l] = operand(); setNZ(l, y[l]); }
+    if constexpr (O == OP_STA) mem(l, addr) = a[l];
+    if constexpr (O == OP_STX) mem(l, addr) = x[l];
+    if constexpr (O == OP_STY) mem(l, addr) = y[l];
+    if constexpr (O == OP_ORA) { a[l] |= operand(); setNZ(l, a[l]); }
+    if constexpr (O == OP_AND) { a[l] &= operand(); setNZ(l, a[l]); }
+    if constexpr (O == OP_EOR) { a[l] ^= operand(); setNZ(l, a[l]); }
+    if constexpr (O == OP_ADC) adc(l, operand());
+    if constexpr (O == OP_SBC) adc(l, (u8)~operand());
+    if constexpr (O == OP_CMP) cmp(l, a[l], operand());
+    if constexpr (O == OP_CPX) cmp(l, x[l], operand());
+    if constexpr (O == OP_CPY) cmp(l, y[l], operand());
+    if constexpr (O == OP_BIT) {
+        u8 value = operand();
+        setFlag(l, Z_FLAG, (a[l] & value) == 0);
+        setFlag(l, N_FLAG, value & 0x80);
+        setFlag(l, V_FLAG, value & 0x40);
+    }
+
+    // Register transfers and flag manipulation
+    if constexpr (O == OP_TAX) { x[l] = a[l]; setNZ(l, x[l]); }
+    if constexpr (O == OP_TAY) { y[l] = a[l]; setNZ(l, y[l]); }
+    if constexpr (O == OP_TXA) { a[l] = x[l]; setNZ(l, a[l]); }
+    if constexpr (O == OP_TYA) { a[l] = y[l]; setNZ(l, a[l]); }
+    if constexpr (O == OP_TSX) { x[l] = sp[l]; setNZ(l, x[l]); }
+    if constexpr (O == OP_TXS) sp[l] = x[l];
+    if constexpr (O == OP_INX) setNZ(l, ++x[l]);
+    if constexpr (O == OP_INY) setNZ(l, ++y[l]);
+    if constexpr (O == OP_DEX) setNZ(l, --x[l]);
+    if constexpr (O == OP_DEY) setNZ(l, --y[l]);
+    if constexpr (O == OP_CLC) p[l] &= ~C_FLAG;
+    if constexpr (O == OP_SEC) p[l] |= C_FLAG;
+    if constexpr (O == OP_CLI) p[l] &= ~I_FLAG;
+    if constexpr (O == OP_SEI) p[l] |= I_FLAG;
+    if constexpr (O == OP_CLV) p[l] &= ~V_FLAG;
+    if constexpr (O == OP_CLD) p[l] &= ~D_FLAG;
+    if constexpr (O == OP_SED) p[l] |= D_FLAG;
+
+    // Stack operations
+    if constexpr (O == OP_PHA) push(l, a[l]);
+    if constexpr (O == OP_PHP) push(l, p[l] | B_FLAG | 0x20);
+    if constexpr (O == OP_PLA) { a[l] = pull(l); setNZ(l, a[l]); }
+    if constexpr (O == OP_PLP) p[l] = (pull(l) & ~B_FLAG) | 0x20;
+
+    // Jumps and subroutines
+    if constexpr (O == OP_JMP) next = addr;
+    if constexpr (O == OP_JSR) {
+        u16 ret = (u16)(pc0 + 2);
+        push(l, HI_BYTE(ret));
+        push(l, LO_BYTE(ret));
+        next = addr;
+    }
+    if constexpr (O == OP_RTS) {
+        u8 pcl = pull(l);
+        next = (u16)(HI_LO(pull(l), pcl) + 1);
+    }
+    if constexpr (O == OP_BRK) {
+        u16 ret = (u16)(pc0 + 2);
+        push(l, HI_BYTE(ret));
+        push(l, LO_BYTE(ret));
+        push(l, p[l] | B_FLAG | 0x20);
+        p[l] |= I_FLAG;
+        next = HI_LO(mem(l, 0xFFFF), mem(l, 0xFFFE));
+    }
+    if constexpr (O == OP_RTI) {
+        p[l] = (pull(l) & ~B_FLAG) | 0x20;
+        u8 pcl = pull(l);
+        next = HI_LO(pull(l), pcl);
+    }
+
+    pc[l] = next;
+    return extra;
+}
+
+void
+BatchCPU::adc(u32 l, u8 value)
+{
+    u16 sum = a[l] + value + (p[l] & C_FLAG ? 1 : 0);
+
+    setFlag(l, C_FLAG, sum > 0xFF);
+    setFlag(l, V_FLAG, !((a[l] ^ value) & 0x80) && ((a[l] ^ sum) & 0x80));
+    a[l] = (u8)sum;
+    setNZ(l, a[l]);
+}
+
+void
+BatchCPU::cmp(u32 l, u8 reg, u8 value)
+{
+    setFlag(l, C_FLAG, reg >= value);
+    setNZ(l, (u8)(reg - value));
+}
@@ -0,0 +1,184 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "CPUTypes.h"
+#include <vector>
+
+/* Executes many independent 6510 processors with 64 KB of RAM each in
+ * lockstep. The emulation is restricted to the CPU and plain RAM. There are
+ * no ROMs, no I/O chips, and no interrupts. It is meant for fuzzing and
+ * search workloads which need to run the same code on many inputs.
+ *
+ * All instances (lanes) are stored in structure-of-arrays layout. Each
+ * register is kept in a separate array and the RAM is interleaved, i.e., the
+ * bytes of all lanes at the same address are stored side by side. In each
+ * step, the running lanes are grouped by the opcode they are about to
+ * execute. Each group is executed by a handler that is specialized for the
+ * opcode. Lanes running the same code therefore access adjacent memory cells
+ * and take the same branches inside the handler.
+ *
+ * Instructions are executed as a whole. Lanes reaching an instruction the
+ * batch engine doesn't implement (illegal opcodes and decimal mode
+ * arithmetic) are stopped before the instruction is executed. These lanes
+ * are continued by the scalar CPU after exporting them into an emulator
+ * instance.
+ */
+class BatchCPU {
+
+    // Operations performed by the instructions
+    enum Operation {
+
+        OP_ADC, OP_AND, OP_ASL, OP_BCC, OP_BCS, OP_BEQ, OP_BIT, OP_BMI,
+        OP_BNE, OP_BPL, OP_BRK, OP_BVC, OP_BVS, OP_CLC, OP_CLD, OP_CLI,
+        OP_CLV, OP_CMP, OP_CPX, OP_CPY, OP_DEC, OP_DEX, OP_DEY, OP_EOR,
+        OP_INC, OP_INX, OP_INY, OP_JMP, OP_JSR, OP_LDA, OP_LDX, OP_LDY,
+        OP_LSR, OP_NOP, OP_ORA, OP_PHA, OP_PHP, OP_PLA, OP_PLP, OP_ROL,
+        OP_ROR, OP_RTI, OP_RTS, OP_SBC, OP_SEC, OP_SED, OP_SEI, OP_STA,
+        OP_STX, OP_STY, OP_TAX, OP_TAY, OP_TSX, OP_TXA, OP_TXS, OP_TYA
+    };
+
+    // Executes an opcode group
+    typedef void (BatchCPU::*Handler)(u8 opcode, const u32 *group, usize count);
+
+    // Handlers and base cycle counts of all opcodes (nullptr = unsupported)
+    static Handler handlers[256];
+    static u8 cycleTable[256];
+
+    // Number of lanes
+    usize lanes;
+
+    // Register files
+    std::vector<u16> pc;
+    std::vector<u8> a;
+    std::vector<u8> x;
+    std::vector<u8> y;
+    std::vector<u8> sp;
+    std::vector<u8> p;
+
+    // Elapsed cycles and execution state of each lane
+    std::vector<u64> cycles;
+    std::vector<LaneState> state;
+
+    // RAM of all lanes (address-major, 64 KB per lane)
+    std::vector<u8> ram;
+
+    // Address terminating the execution of a lane (values > 0xFFFF = none)
+    u32 exitAddr = UINT32_MAX;
+
+    // Running lanes and scratch space for grouping them by opcode
+    std::vector<u32> active;
+    std::vector<u32> order;
+    std::vector<u8> opcodes;
+
+    // Statistics
+    BatchStats stats = { };
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    // Creates the lanes (they start running after a lane has been set up)
+    BatchCPU(usize lanes);
+
+    usize count() const { return lanes; }
+
+private:
+
+    // Sets up the handler tables
+    static void registerInstructions();
+    template <AddressingMode M, Operation O> static void registerInstruction(u8 opcode, u8 cycles);
+
+
+    //
+    // Accessing lanes
+    //
+
+public:
+
+    /* Copies the RAM and the CPU registers of an emulator instance into a
+     * lane. The CPU of the instance must be in the fetch phase.
+     */
+    void importLane(usize lane, const class C64 &c64);
+
+    /* Copies a lane into an emulator instance. The instance must be paused.
+     * Afterwards, the scalar CPU continues where the lane has stopped.
+     */
+    void exportLane(usize lane, class C64 &c64) const;
+
+    /* Copies the CPU registers of an emulator instance into a lane and lets
+     * the lane run again. The RAM and the cycle counter are left untouched.
+     */
+    void importRegisters(usize lane, const class C64 &c64);
+
+    // Reads or writes the RAM of a lane
+    void read(usize lane, u8 *dst, u16 addr, usize count) const;
+    void write(usize lane, const u8 *src, u16 addr, usize count);
+
+    // Sets the program counter of a lane and lets it run again
+    void jump(usize lane, u16 addr);
+
+    // Sets the address terminating the execution of all lanes
+    void setExitAddr(u32 addr) { exitAddr = addr; }
+
+    LaneState getState(usize lane) const { return state[lane]; }
+    u64 getCycles(usize lane) const { return cycles[lane]; }
+    u16 getPC(usize lane) const { return pc[lane]; }
+    u8 getA(usize lane) const { return a[lane]; }
+    u8 getX(usize lane) const { return x[lane]; }
+    u8 getY(usize lane) const { return y[lane]; }
+    u8 getSP(usize lane) const { return sp[lane]; }
+    u8 getP(usize lane) const { return p[lane]; }
+
+
+    //
+    // Executing
+    //
+
+public:
+
+    /* Executes up to the specified number of steps. In each step, each running
+     * lane executes a single instruction. The function returns the number of
+     * lanes still running.
+     */
+    usize run(u64 steps);
+
+    BatchStats getStats() const { return stats; }
+
+private:
+
+    // Accesses the RAM of a lane
+    u8 &mem(u32 lane, u16 addr) { return ram[(usize)addr * lanes + lane]; }
+    u8 mem(u32 lane, u16 addr) const { return ram[(usize)addr * lanes + lane]; }
+
+    // Executes an opcode group
+    template <AddressingMode M, Operation O> void execute(u8 opcode, const u32 *group, usize count);
+
+    /* Executes a single instruction and returns the number of extra cycles
+     * (-1 if the instruction is left to the scalar CPU)
+     */
+    template <AddressingMode M, Operation O> isize step(u32 lane);
+
+    // Performs the arithmetic operations
+    void adc(u32 lane, u8 value);
+    void cmp(u32 lane, u8 reg, u8 value);
+
+    void setNZ(u32 lane, u8 value) {
+        p[lane] = (u8)((p[lane] & ~(N_FLAG | Z_FLAG)) | (value & N_FLAG) | (value ? 0 : Z_FLAG));
+    }
+    void setFlag(u32 lane, u8 flag, bool value) {
+        p[lane] = value ? (p[lane] | flag) : (p[lane] & ~flag);
+    }
+    void push(u32 lane, u8 value) { mem(lane, 0x100 | sp[lane]--) = value; }
+    u8 pull(u32 lane) { return mem(lane, 0x100 | ++sp[lane]); }
+};
@@ -25,11 +25,21 @@ CPU<M>::CPU(C64& ref, M& memref) : C64Component(ref), mem(memref)
 template<> CPURevision CPU<C64Memory>::model() const { return MOS_6510; }
 template<> CPURevision CPU<DriveMemory>::model() const { return MOS_6502; }
 
-template<> bool CPU<C64Memory>::isC64CPU() const { return true; }
-template<> bool CPU<DriveMemory>::isC64CPU() const { return false; }
-
-template<> bool CPU<C64Memory>::isDriveCPU() const { return false; }
-template<> bool CPU<DriveMemory>::isDriveCPU() const { return true; }
+#ifdef DRIVE_FAST_PATH
+template<> bool CPU<C64Memory>::isSideEffectFree(u16 addr) const
+{
+    switch (mem.peekSrc[addr >> 12]) {
+            
+        case M_RAM: case M_BASIC: case M_CHAR: case M_KERNAL: return true;
+        case M_PP: return addr >= 0x02;
+        default: return false;
+    }
+}
+template<> bool CPU<DriveMemory>::isSideEffectFree(u16 addr) const
+{
+    return addr >= 0x8000 || (addr & 0x1FFF) < 0x0800;
+}
+#endif
 
 template <typename M> void
 CPU<M>::_reset()
@@ -38,6 +48,7 @@ CPU<M>::_reset()
     
     setB(1);
 	rdyLine = true;
+	frozen = false;
 	next = fetch;
     
     // This should not be necessary. Delete it.
@@ -61,13 +72,15 @@ CPU<M>::_inspect()
         info.processorPort = pport.read();
         info.processorPortDir = pport.readDirection();
     }
+    
+    latestInfo.publish(info);
 }
 
 template <typename M> void
 CPU<M>::_setDebug(bool enable)
 {
     // We only allow the C64 CPU to run in debug mode
-    if (isC64CPU()) { debugMode = enable; }
+    if constexpr (isC64CPU()) { debugMode = enable || debugger.isTracing(); }
 }
 
 template <typename M> void
@@ -178,7 +191,7 @@ CPU<M>::setRDY(bool value)
     else
     {
         rdyLine = value;
-        if (rdyLine) rdyLineUp = cycle;
+        if (rdyLine) { rdyLineUp = cycle; frozen = false; }
     }
 }
 
@@ -16,17 +16,21 @@
 #include "ProcessorPort.h"
 #include "TimeDelayed.h"
 
+#include <type_traits>
+
 class Memory;
 
 template <typename MEMTYPE>
 class CPU : public C64Component {
         
     friend class CPUDebugger;
+    friend class Guards;
     friend class Breakpoints;
     friend class Watchpoints;
             
-    // Result of the latest inspection
+    // Result of the latest inspection (the published copy is read by the GUI)
     CPUInfo info;
+    InfoRecord<CPUInfo> latestInfo;
         
     
     //
@@ -54,8 +58,10 @@ public:
 public:
     
     CPURevision model() const;
-    bool isC64CPU() const;
-    bool isDriveCPU() const;
+    
+    // The CPU type is known at compile time which allows "if constexpr" checks
+    static constexpr bool isC64CPU() { return std::is_same<MEMTYPE, C64Memory>::value; }
+    static constexpr bool isDriveCPU() { return std::is_same<MEMTYPE, DriveMemory>::value; }
 
     
     //
@@ -69,6 +75,17 @@ protected:
      * phase.
      */
     MicroInstruction actionFunc[256];
+    
+#ifdef DRIVE_FAST_PATH
+    /* Decode cache for ROM-resident code. The drive CPU spends most of its
+     * time in the DOS routines between $C000 and $FFFF. For each of these
+     * addresses, the cache keeps the instruction bytes together with the
+     * address independent part of the isolation check. An entry is valid as
+     * long as the ROM still contains the same bytes which makes explicit
+     * invalidation unnecessary. The storage is provided by the drive CPU.
+     */
+    DecodedInstruction *decodeCache = nullptr;
+#endif
                 
     
     //
@@ -85,11 +102,18 @@ public:
     
     // Elapsed clock cycles since power up
     u64 cycle;
+    
+    /* Address terminating a headless run (see C64::runHeadless()). The C64
+     * CPU signals when it is about to execute the instruction at this
+     * address. Values beyond the address space disable the check.
+     */
+    u32 exitAddr = UINT32_MAX;
                         
 private:
 
     // The next microinstruction to be executed
     MicroInstruction next;
+    
         
     
     //
@@ -114,6 +138,13 @@ public:
      */
     bool rdyLine;
     
+    /* Indicates if the CPU is frozen on a read access. The flag is set when
+     * a read access is blocked by the RDY line. As long as RDY stays low, the
+     * CPU would attempt the same access in each cycle without changing its
+     * state. Hence, the scheduler skips the CPU until RDY goes high again.
+     */
+    bool frozen = false;
+    
 private:
     
     // Cycle of the most recent rising edge of the RDY line
@@ -219,7 +250,7 @@ public:
 public:
     
     // Returns the result of the latest inspection
-    CPUInfo getInfo() { return HardwareComponent::getInfo(info); }
+    CPUInfo getInfo() { return HardwareComponent::getInfo(latestInfo); }
     
 private:
     
@@ -275,8 +306,11 @@ private:
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
+    usize didLoadFromBuffer(u8 *buffer) override { frozen = false; return 0; }
 
     
     //
@@ -304,7 +338,7 @@ public:
      */
     u16 getPC0() const { return reg.pc0; }
     
-    void jumpToAddress(u16 addr) { reg.pc0 = reg.pc = addr; next = fetch; }
+    void jumpToAddress(u16 addr) { reg.pc0 = reg.pc = addr; next = fetch; frozen = false; }
     void setPCL(u8 lo) { reg.pc = (reg.pc & 0xff00) | lo; }
     void setPCH(u8 hi) { reg.pc = (reg.pc & 0x00ff) | ((u16)hi << 8); }
     void incPC(u8 offset = 1) { reg.pc += offset; }
@@ -383,6 +417,33 @@ public:
     // Executes the next micro instruction
     void executeOneCycle();
 
+#ifdef DRIVE_FAST_PATH
+    /* Executes all cycles of the next instruction in a row. The function must
+     * be called in the fetch phase. It advances the cycle counter on its own
+     * and returns the number of elapsed cycles.
+     */
+    isize executeInstruction();
+
+    /* Checks if the next instruction can be executed in a row. This is the
+     * case if it only touches memory without side effects and if no interrupt
+     * is pending. The caller needs to make sure that no other component
+     * interferes while the instruction is executed, e.g., by changing the RDY
+     * line or by triggering an interrupt.
+     */
+    bool nextInstructionIsIsolated() const;
+    
+private:
+    
+    // Performs the static part of the isolation check
+    Isolation classify(u16 pc, u8 opcode, u8 lo, u8 hi) const;
+    
+    // Performs the register dependent part of the isolation check
+    bool isIsolated(u8 opcode, u8 lo, u8 hi) const;
+    
+    // Checks if a read access to the specified address has no side effects
+    bool isSideEffectFree(u16 addr) const;
+#endif
+    
 private:
 
     // Called after the last microcycle has been completed
@@ -408,9 +469,18 @@ public:
 //
 
 class DriveCPU : public CPU<DriveMemory> {
-        
+    
+#ifdef DRIVE_FAST_PATH
+    // Storage of the decode cache
+    DecodedInstruction decodedRom[0x4000] = { };
+#endif
+    
 public:
     
-    DriveCPU(C64& ref, DriveMemory &memref) : CPU(ref, memref) { }
+    DriveCPU(C64& ref, DriveMemory &memref) : CPU(ref, memref) {
+#ifdef DRIVE_FAST_PATH
+        decodeCache = decodedRom;
+#endif
+    }
     const char *getDescription() const override { return "DriveCPU"; }    
 };
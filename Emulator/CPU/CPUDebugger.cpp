@@ -8,15 +8,16 @@
 // -----------------------------------------------------------------------------
 
 #include "C64.h"
+#include <algorithm>
 
 //
 // Guard
 //
 
 bool
-Guard::eval(u32 addr)
+Guard::eval(u32 addr, const Registers &reg, u8 p, const C64Memory &mem)
 {
-    if (this->addr == addr && this->enabled) {
+    if (this->addr == addr && this->enabled && condition.eval(reg, p, mem)) {
         if (++hits > skip) {
             return true;
         }
@@ -73,7 +74,7 @@ Guards::isSetAndConditionalAt(u32 addr) const
 {
     Guard *guard = guardAtAddr(addr);
 
-    return guard != nullptr && guard->skip != 0;
+    return guard != nullptr && (guard->skip != 0 || !guard->condition.isEmpty());
 }
 
 void
@@ -94,7 +95,9 @@ Guards::addAt(u32 addr, long skip)
     guards[count].enabled = true;
     guards[count].hits = 0;
     guards[count].skip = skip;
+    guards[count].condition.clear();
     count++;
+    updateBitmap();
     setNeedsCheck(true);
 }
 
@@ -116,6 +119,7 @@ Guards::removeAt(u32 addr)
             break;
         }
     }
+    updateBitmap();
     setNeedsCheck(count != 0);
 }
 
@@ -126,6 +130,7 @@ Guards::replace(long nr, u32 addr)
     
     guards[nr].addr = addr;
     guards[nr].hits = 0;
+    updateBitmap();
 }
 
 bool
@@ -137,29 +142,72 @@ Guards::isEnabled(long nr) const
 void
 Guards::setEnable(long nr, bool val)
 {
-    if (nr < count) guards[nr].enabled = val;
+    if (nr < count) {
+        guards[nr].enabled = val;
+        updateBitmap();
+    }
 }
 
 void
 Guards::setEnableAt(u32 addr, bool value)
 {
     Guard *guard = guardAtAddr(addr);
-    if (guard) guard->enabled = value;
+    if (guard) {
+        guard->enabled = value;
+        updateBitmap();
+    }
+}
+
+string
+Guards::condition(long nr) const
+{
+    return nr < count ? guards[nr].condition.getSource() : "";
+}
+
+void
+Guards::setCondition(long nr, const string &expr)
+{
+    if (nr < count) guards[nr].condition.compile(expr);
+}
+
+void
+Guards::setCondition(long nr, const string &expr, ErrorCode *err)
+{
+    *err = ERROR_OK;
+    try { setCondition(nr, expr); }
+    catch (VC64Error &exception) { *err = exception.errorCode; }
 }
 
 bool
 Guards::eval(u32 addr)
 {
+    if (!isMarked(addr)) return false;
+    
+    u8 p = cpu.getP();
     for (int i = 0; i < count; i++)
-        if (guards[i].eval(addr)) return true;
+        if (guards[i].eval(addr, cpu.reg, p, cpu.mem)) return true;
 
     return false;
 }
 
+void
+Guards::updateBitmap()
+{
+    memset(marked, 0, sizeof(marked));
+    
+    for (int i = 0; i < count; i++) {
+        
+        if (guards[i].enabled) {
+            u32 addr = guards[i].addr & 0xFFFF;
+            marked[addr >> 6] |= 1ULL << (addr & 63);
+        }
+    }
+}
+
 void
 Breakpoints::setNeedsCheck(bool value)
 {
-    if (value || cpu.c64.inDebugMode()) {
+    if (value || cpu.c64.inDebugMode() || cpu.debugger.isTracing()) {
         cpu.debugMode = true;
     } else {
         cpu.debugMode = false;
@@ -169,7 +217,7 @@ Breakpoints::setNeedsCheck(bool value)
 void
 Watchpoints::setNeedsCheck(bool value)
 {
-    cpu.c64.mem.checkWatchpoints = value;
+    cpu.c64.mem.setCheckWatchpoints(value);
 }
 
 //
@@ -181,6 +229,32 @@ CPUDebugger::registerInstruction(u8 opcode, const char *mnemonic, AddressingMode
 {
     this->mnemonic[opcode] = mnemonic;
     this->addressingMode[opcode] = mode;
+    
+    switch (mode) {
+            
+        case ADDR_IMPLIED:
+        case ADDR_ACCUMULATOR:
+            length[opcode] = 1;
+            break;
+        case ADDR_IMMEDIATE:
+        case ADDR_ZERO_PAGE:
+        case ADDR_ZERO_PAGE_X:
+        case ADDR_ZERO_PAGE_Y:
+        case ADDR_INDIRECT_X:
+        case ADDR_INDIRECT_Y:
+        case ADDR_RELATIVE:
+            length[opcode] = 2;
+            break;
+        case ADDR_ABSOLUTE:
+        case ADDR_ABSOLUTE_X:
+        case ADDR_ABSOLUTE_Y:
+        case ADDR_DIRECT:
+        case ADDR_INDIRECT:
+            length[opcode] = 3;
+            break;
+        default:
+            length[opcode] = 1;
+    }
 }
 
 void
@@ -201,6 +275,14 @@ CPUDebugger::_reset()
     clearLog();
 }
 
+void
+CPUDebugger::_memoryUsage(MemoryUsage &usage)
+{
+    usage.heapBytes += breakpoints.capacity * sizeof(Guard);
+    usage.heapBytes += watchpoints.capacity * sizeof(Guard);
+    if (addrCycles) usage.heapBytes += 0x10000 * sizeof(u64);
+}
+
 void
 CPUDebugger::setSoftStop(u64 addr)
 {
@@ -230,6 +312,89 @@ CPUDebugger::watchpointMatches(u32 addr)
     return watchpoints.eval(addr);
 }
 
+void
+CPUDebugger::startProfiling()
+{
+    suspend();
+    if (!addrCycles) addrCycles = new u64[0x10000]();
+    profiledCycle = 0;
+    profiling = true;
+    resume();
+}
+
+void
+CPUDebugger::clearProfile()
+{
+    suspend();
+    if (addrCycles) memset(addrCycles, 0, 0x10000 * sizeof(u64));
+    memset(opcodeCycles, 0, sizeof(opcodeCycles));
+    memset(opcodeCount, 0, sizeof(opcodeCount));
+    profiledCycle = 0;
+    resume();
+}
+
+void
+CPUDebugger::profileInstruction(u16 pc, u8 opcode)
+{
+    // Charge the elapsed cycles to the previous instruction
+    if (profiledCycle) {
+        
+        u64 elapsed = cpu.cycle - profiledCycle;
+        addrCycles[profiledPC] += elapsed;
+        opcodeCycles[profiledOpcode] += elapsed;
+        opcodeCount[profiledOpcode]++;
+    }
+    
+    profiledPC = pc;
+    profiledOpcode = opcode;
+    profiledCycle = cpu.cycle;
+}
+
+void
+CPUDebugger::dumpProfile(std::ostream &os, isize entries) const
+{
+    char line[128];
+    std::vector<u32> order;
+    u64 total = 0;
+    
+    for (isize i = 0; i < 256; i++) total += opcodeCycles[i];
+    if (total == 0) { os << "No profile data recorded\n"; return; }
+    
+    // Opcodes
+    for (u32 i = 0; i < 256; i++) if (opcodeCount[i]) order.push_back(i);
+    std::sort(order.begin(), order.end(), [this](u32 a, u32 b) {
+        return opcodeCycles[a] > opcodeCycles[b]; });
+    
+    os << "Opcode  Mnemonic     Executions        Cycles      %\n";
+    for (isize i = 0; i < (isize)order.size() && i < entries; i++) {
+        
+        u32 op = order[i];
+        snprintf(line, sizeof(line), "  %02X    %s    %12llu  %12llu  %5.1f\n",
+                 op, mnemonic[op],
+                 (unsigned long long)opcodeCount[op],
+                 (unsigned long long)opcodeCycles[op],
+                 100.0 * opcodeCycles[op] / total);
+        os << line;
+    }
+    
+    // Addresses
+    order.clear();
+    for (u32 i = 0; i < 0x10000; i++) if (addrCycles[i]) order.push_back(i);
+    std::sort(order.begin(), order.end(), [this](u32 a, u32 b) {
+        return addrCycles[a] > addrCycles[b]; });
+    
+    os << "\nAddress  Instruction          Cycles      %\n";
+    for (isize i = 0; i < (isize)order.size() && i < entries; i++) {
+        
+        u32 addr = order[i];
+        snprintf(line, sizeof(line), " %04X    %-12s  %12llu  %5.1f\n",
+                 addr, disassembleInstr((u16)addr, nullptr),
+                 (unsigned long long)addrCycles[addr],
+                 100.0 * addrCycles[addr] / total);
+        os << line;
+    }
+}
+
 usize
 CPUDebugger::loggedInstructions() const
 {
@@ -255,6 +420,68 @@ CPUDebugger::logInstruction()
     logBuffer[i].x = cpu.reg.x;
     logBuffer[i].y = cpu.reg.y;
     logBuffer[i].flags = cpu.getP();
+    
+    if (tracer.isActive()) tracer.record(logBuffer[i], length);
+}
+
+void
+CPUDebugger::startTrace(const char *path)
+{
+    suspend();
+    try { tracer.start(path); }
+    catch (VC64Error &exception) { resume(); throw exception; }
+    breakpoints.setNeedsCheck(breakpoints.elements() != 0);
+    resume();
+}
+
+void
+CPUDebugger::startTrace(const char *path, ErrorCode *err)
+{
+    *err = ERROR_OK;
+    try { startTrace(path); }
+    catch (VC64Error &exception) { *err = exception.errorCode; }
+}
+
+void
+CPUDebugger::stopTrace()
+{
+    suspend();
+    tracer.stop();
+    breakpoints.setNeedsCheck(breakpoints.elements() != 0);
+    resume();
+    
+    debug(CPU_DEBUG, "Trace: %llu instructions recorded, %llu dropped\n",
+          (unsigned long long)tracer.recorded(), (unsigned long long)tracer.lost());
+}
+
+void
+CPUDebugger::decodeTrace(std::istream &in, std::ostream &out) const
+{
+    TraceReader reader(in);
+    RecordedInstruction instr;
+    u64 dropped;
+    char line[128];
+    
+    while (reader.read(instr, dropped)) {
+        
+        if (dropped) {
+            snprintf(line, sizeof(line), "*** %llu instructions dropped ***\n",
+                     (unsigned long long)dropped);
+            out << line;
+        }
+        
+        snprintf(line, sizeof(line), "%12llu  %s  ",
+                 (unsigned long long)instr.cycle, disassembleAddr(instr.pc));
+        out << line;
+        snprintf(line, sizeof(line), "%-10s", disassembleBytes(instr));
+        out << line;
+        snprintf(line, sizeof(line), "%-12s", disassembleInstr(instr, nullptr));
+        out << line;
+        snprintf(line, sizeof(line), "A=%02X X=%02X Y=%02X SP=%02X  %s\n",
+                 instr.a, instr.x, instr.y, instr.sp,
+                 disassembleRecordedFlags(instr));
+        out << line;
+    }
 }
 
 const RecordedInstruction &
@@ -288,26 +515,7 @@ CPUDebugger::loggedPC0Abs(usize n) const
 usize
 CPUDebugger::getLengthOfInstruction(u8 opcode) const
 {
-    switch(addressingMode[opcode]) {
-        case ADDR_IMPLIED:
-        case ADDR_ACCUMULATOR:
-            return 1;
-        case ADDR_IMMEDIATE:
-        case ADDR_ZERO_PAGE:
-        case ADDR_ZERO_PAGE_X:
-        case ADDR_ZERO_PAGE_Y:
-        case ADDR_INDIRECT_X:
-        case ADDR_INDIRECT_Y:
-        case ADDR_RELATIVE:
-            return 2;
-        case ADDR_ABSOLUTE:
-        case ADDR_ABSOLUTE_X:
-        case ADDR_ABSOLUTE_Y:
-        case ADDR_DIRECT:
-        case ADDR_INDIRECT:
-            return 3;
-    }
-    return 1;
+    return length[opcode];
 }
 
 usize
@@ -369,12 +577,13 @@ const char *
 CPUDebugger::disassembleBytes(u16 addr) const
 {
     RecordedInstruction instr;
-     
-     instr.byte1 = cpu.mem.spypeek(addr);
-     instr.byte2 = cpu.mem.spypeek(addr + 1);
-     instr.byte3 = cpu.mem.spypeek(addr + 2);
-     
-     return disassembleBytes(instr);
+    
+    instr.pc = addr;
+    instr.byte1 = cpu.mem.spypeek(addr);
+    instr.byte2 = cpu.mem.spypeek(addr + 1);
+    instr.byte3 = cpu.mem.spypeek(addr + 2);
+    
+    return disassembleBytes(instr);
 }
 
 const char *
@@ -407,10 +616,46 @@ CPUDebugger::disassemblePC() const
 const char *
 CPUDebugger::disassembleInstr(const RecordedInstruction &instr, long *len) const
 {
-    static char result[16];
+    if (len) *len = getLengthOfInstruction(instr.byte1);
+    return disassemble(instr).instr;
+}
+
+const char *
+CPUDebugger::disassembleBytes(const RecordedInstruction &instr) const
+{
+    return disassemble(instr).data;
+}
+
+const DisassembledInstr &
+CPUDebugger::disassemble(const RecordedInstruction &instr) const
+{
+    DisassembledInstr &entry = disassembled[instr.pc % disassemblyCacheSize];
+    
+    if (!entry.valid ||
+        entry.pc != instr.pc ||
+        entry.hex != hex ||
+        entry.bytes[0] != instr.byte1 ||
+        entry.bytes[1] != instr.byte2 ||
+        entry.bytes[2] != instr.byte3) {
         
+        entry.pc = instr.pc;
+        entry.hex = hex;
+        entry.bytes[0] = instr.byte1;
+        entry.bytes[1] = instr.byte2;
+        entry.bytes[2] = instr.byte3;
+        entry.valid = true;
+        
+        formatInstr(instr, entry.instr);
+        formatBytes(instr, entry.data);
+    }
+    
+    return entry;
+}
+
+void
+CPUDebugger::formatInstr(const RecordedInstruction &instr, char *result) const
+{
     u8 opcode = instr.byte1;
-    if (len) *len = getLengthOfInstruction(opcode);
         
     // Convert command
     char operand[6];
@@ -501,13 +746,12 @@ CPUDebugger::disassembleInstr(const RecordedInstruction &instr, long *len) const
     
     // Copy mnemonic
     strncpy(result, mnemonic[opcode], 3);
-    return result;
 }
 
-const char *
-CPUDebugger::disassembleBytes(const RecordedInstruction &instr) const
+void
+CPUDebugger::formatBytes(const RecordedInstruction &instr, char *result) const
 {
-    static char result[13]; char *ptr = result;
+    char *ptr = result;
     
     usize len = getLengthOfInstruction(instr.byte1);
     
@@ -521,8 +765,6 @@ CPUDebugger::disassembleBytes(const RecordedInstruction &instr) const
         if (len >= 3) { sprint8d(ptr, instr.byte3); ptr[3] = ' '; ptr += 4; }
     }
     ptr[0] = 0;
-    
-    return result;
 }
 
 const char *
@@ -10,6 +10,8 @@
 #pragma once
 
 #include "C64Component.h"
+#include "CPUTrace.h"
+#include "GuardCondition.h"
 
 // Base structure for a single breakpoint or watchpoint
 struct Guard {
@@ -26,10 +28,13 @@ struct Guard {
     // Number of skipped hits before a match is signalled
     long skip;
     
+    // Optional condition that needs to hold for a hit to be counted
+    GuardCondition condition;
+    
 public:
     
     // Returns true if the guard hits
-    bool eval(u32 addr);
+    bool eval(u32 addr, const Registers &reg, u8 p, const C64Memory &mem);
 };
 
 // Base class for a collection of guards
@@ -55,6 +60,12 @@ protected:
     // Number of currently stored guards
     long count = 0;
 
+    /* Bitmap of all addresses with an enabled guard. The bitmap speeds up
+     * eval() which is called on every instruction or memory access. A guard
+     * list has to be searched only if the bit of the address is set.
+     */
+    u64 marked[0x10000 / 64] = { };
+
     // Indicates if guard checking is necessary
     virtual void setNeedsCheck(bool value) = 0;
     
@@ -91,7 +102,7 @@ public:
     void removeAt(u32 addr);
     
     void remove(long nr);
-    void removeAll() { count = 0; setNeedsCheck(false); }
+    void removeAll() { count = 0; updateBitmap(); setNeedsCheck(false); }
     
     void replace(long nr, u32 addr);
     
@@ -110,13 +121,29 @@ public:
     void enableAt(u32 addr) { setEnableAt(addr, true); }
     void disableAt(u32 addr) { setEnableAt(addr, false); }
     
+    //
+    // Managing conditions
+    //
+    
+    // Returns the condition of a guard as entered by the user
+    string condition(long nr) const;
+    
+    // Attaches a condition to a guard (an empty string removes it)
+    void setCondition(long nr, const string &expr) throws;
+    void setCondition(long nr, const string &expr, ErrorCode *err);
+    
     //
     // Checking a guard
     //
     
 private:
     
+    bool isMarked(u32 addr) const {
+        return marked[(addr & 0xFFFF) >> 6] & (1ULL << (addr & 63)); }
     bool eval(u32 addr);
+    
+    // Recomputes the bitmap of enabled guards
+    void updateBitmap();
 };
 
 class Breakpoints : public Guards {
@@ -135,9 +162,24 @@ public:
     void setNeedsCheck(bool value) override;
 };
 
+// Formatted output of the disassembler for a single instruction
+struct DisassembledInstr {
+
+    // Cache key
+    u16 pc;
+    u8 bytes[3];
+    bool hex;
+    bool valid;
+
+    // Formatted instruction and data bytes
+    char instr[16];
+    char data[13];
+};
+
 class CPUDebugger : public C64Component {
     
     friend class CPU<C64Memory>;
+    friend class CPU<DriveMemory>;
     
     // Textual representation for each opcode (used by the disassembler)
     const char *mnemonic[256];
@@ -145,6 +187,18 @@ class CPUDebugger : public C64Component {
     // Adressing mode of each opcode (used by the disassembler)
      AddressingMode addressingMode[256];
     
+    // Length of each opcode in bytes (derived from the addressing mode)
+    u8 length[256];
+    
+    /* Recently disassembled instructions (direct mapped by address). An entry
+     * is only reused if the program counter, the instruction bytes, and the
+     * number format match. Because the bytes are part of the key, entries
+     * become stale automatically when the memory contents or the memory
+     * configuration change.
+     */
+    static constexpr usize disassemblyCacheSize = 512;
+    mutable DisassembledInstr disassembled[disassemblyCacheSize] = { };
+    
 public:
     
     // Log buffer
@@ -165,6 +219,28 @@ private:
      */
     usize logCnt = 0;
 
+    // Streams all executed instructions to disk
+    TraceWriter tracer;
+
+    // Cycles spent per instruction address and per opcode
+    u64 *addrCycles = nullptr;
+    u64 opcodeCycles[256] = { };
+    u64 opcodeCount[256] = { };
+    
+    // Indicates if the profiler is running
+    bool profiling = false;
+    
+    // Address, opcode, and fetch cycle of the previously profiled instruction
+    u16 profiledPC = 0;
+    u8 profiledOpcode = 0;
+    u64 profiledCycle = 0;
+
+    /* Edge coverage map (AFL style). Each transition between two fetched
+     * instructions increments a hit counter in this 64 KB map.
+     */
+    u8 *coverage = nullptr;
+    u16 prevLocation = 0;
+
     /* Soft breakpoint for implementing single-stepping.
      * In contrast to a standard (hard) breakpoint, a soft breakpoint is
      * deleted when reached. The CPU halts if softStop matches the CPU's
@@ -188,6 +264,7 @@ public:
 public:
     
     CPUDebugger(C64 &ref) : C64Component(ref) { };
+    ~CPUDebugger() { delete [] addrCycles; }
 
     const char *getDescription() const override { return "CPUDebugger"; }
 
@@ -216,8 +293,11 @@ private:
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
+    void _memoryUsage(MemoryUsage &usage) override;
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
     
     
     //
@@ -269,6 +349,60 @@ public:
     // Clears the log buffer
     void clearLog() { logCnt = 0; }
     
+    //
+    // Working with instruction traces
+    //
+    
+    // Starts or stops writing all executed instructions to a trace file
+    void startTrace(const char *path) throws;
+    void startTrace(const char *path, ErrorCode *err);
+    void stopTrace();
+    
+    // Returns true if a trace file is being written
+    bool isTracing() const { return tracer.isActive(); }
+    
+    // Converts a trace file into a human-readable listing
+    void decodeTrace(std::istream &in, std::ostream &out) const throws;
+    
+    //
+    // Profiling
+    //
+    
+    // Starts, stops, or resets the execution profiler
+    void startProfiling();
+    void stopProfiling() { profiling = false; }
+    void clearProfile();
+    bool isProfiling() const { return profiling; }
+    
+    // Called by the CPU in the fetch phase if the profiler is running
+    void profileInstruction(u16 pc, u8 opcode);
+    
+    // Returns the elapsed cycles at an address or in an opcode
+    u64 profiledCycles(u16 addr) const { return addrCycles ? addrCycles[addr] : 0; }
+    u64 profiledOpcodeCycles(u8 opcode) const { return opcodeCycles[opcode]; }
+    
+    // Returns how often an opcode has been executed
+    u64 profiledOpcodeCount(u8 opcode) const { return opcodeCount[opcode]; }
+    
+    // Prints the opcodes and addresses with the most elapsed cycles
+    void dumpProfile(std::ostream &os, isize entries = 32) const;
+    
+    //
+    // Recording coverage
+    //
+    
+    // Installs or removes (nullptr) the edge coverage map
+    void setCoverageMap(u8 *map) { coverage = map; prevLocation = 0; }
+    bool isRecordingCoverage() const { return coverage != nullptr; }
+    
+    // Called by the CPU in the fetch phase if a coverage map is installed
+    void recordEdge(u16 pc) {
+        u16 location = (u16)((pc >> 4) ^ (pc << 8));
+        u8 &hits = coverage[location ^ prevLocation];
+        if (hits != 0xFF) hits++;
+        prevLocation = location >> 1;
+    }
+    
     //
     // Examining instructions
     //
@@ -306,4 +440,11 @@ private:
     const char *disassembleInstr(const RecordedInstruction &instr, long *len) const;
     const char *disassembleBytes(const RecordedInstruction &instr) const;
     const char *disassembleRecordedFlags(const RecordedInstruction &instr) const;
+
+    // Looks up an instruction in the cache and formats it on a miss
+    const DisassembledInstr &disassemble(const RecordedInstruction &instr) const;
+    
+    // Formats an instruction or its data bytes
+    void formatInstr(const RecordedInstruction &instr, char *result) const;
+    void formatBytes(const RecordedInstruction &instr, char *result) const;
 };
@@ -9,6 +9,33 @@
 
 #include "C64.h"
 
+/* Lookup tables for decimal mode arithmetic. The tables map the raw sum or
+ * difference of two BCD digits (including the incoming carry or borrow) to
+ * the corrected digit (bits 0 - 3) and the outgoing carry or borrow (bit 4).
+ * Differences are indexed by their lower five bits. If the raw value
+ * exceeds the valid range, the pseudo-tetrade 0110 (=6) is added or
+ * subtracted, respectively.
+ */
+struct DecimalTables {
+    
+    u8 add[32];
+    u8 sub[32];
+    
+    constexpr DecimalTables() : add(), sub() {
+        
+        for (int i = 0; i < 32; i++) {
+            
+            int sum = i > 9 ? i + 6 : i;
+            add[i] = (u8)((sum & 0x0F) | (sum > 0x0F ? 0x10 : 0));
+            
+            int diff = (i & 0x10) ? i - 6 : i;
+            sub[i] = (u8)((diff & 0x0F) | (i & 0x10));
+        }
+    }
+};
+
+static constexpr DecimalTables decimal;
+
 template <typename M> void
 CPU<M>::adc(u8 op)
 {
@@ -31,34 +58,22 @@ CPU<M>::adc_binary(u8 op)
 template <typename M> void
 CPU<M>::adc_bcd(u8 op)
 {
-    u16 sum       = reg.a + op + (getC() ? 1 : 0);
-    u8  highDigit = (reg.a >> 4) + (op >> 4);
-    u8  lowDigit  = (reg.a & 0x0F) + (op & 0x0F) + (getC() ? 1 : 0);
+    u16 sum = reg.a + op + (getC() ? 1 : 0);
     
-    // Check for overflow conditions
-    // If an overflow occurs on a BCD digit, it needs to be fixed by adding the pseudo-tetrade 0110 (=6)
-    if (lowDigit > 9) {
-        lowDigit = lowDigit + 6;
-    }
-    if (lowDigit > 0x0F) {
-        highDigit++;
-    }
+    // Add the lower digits and convert the result back to BCD
+    u8 lo = decimal.add[(reg.a & 0x0F) + (op & 0x0F) + (getC() ? 1 : 0)];
+    
+    // Add the upper digits including the decimal carry
+    u8 highDigit = (reg.a >> 4) + (op >> 4) + (lo >> 4);
     
     setZ((sum & 0xFF) == 0);
     setN(highDigit & 0x08);
     setV((((highDigit << 4) ^ reg.a) & 0x80) && !((reg.a ^ op) & 0x80));
     
-    if (highDigit > 9) {
-        highDigit = (highDigit + 6);
-    }
-    if (highDigit > 0x0F) {
-        setC(1);
-    } else {
-        setC(0);
-    }
+    u8 hi = decimal.add[highDigit];
+    setC(hi >> 4);
     
-    lowDigit &= 0x0F;
-    reg.a = (u8)((highDigit << 4) | lowDigit);
+    reg.a = (u8)((hi << 4) | (lo & 0x0F));
 }
 
 template <typename M> void
@@ -93,26 +108,20 @@ CPU<M>::sbc_binary(u8 op)
 template <typename M> void
 CPU<M>::sbc_bcd(u8 op)
 {
-    u16 sum       = reg.a - op - (getC() ? 0 : 1);
-    u8  highDigit = (reg.a >> 4) - (op >> 4);
-    u8  lowDigit  = (reg.a & 0x0F) - (op & 0x0F) - (getC() ? 0 : 1);
+    u16 sum = reg.a - op - (getC() ? 0 : 1);
     
-    // Check for underflow conditions
-    // If an overflow occurs on a BCD digit, it needs to be fixed by subtracting the pseudo-tetrade 0110 (=6)
-    if (lowDigit & 0x10) {
-        lowDigit = lowDigit - 6;
-        highDigit--;
-    }
-    if (highDigit & 0x10) {
-        highDigit = highDigit - 6;
-    }
+    // Subtract the lower digits and convert the result back to BCD
+    u8 lo = decimal.sub[(u8)((reg.a & 0x0F) - (op & 0x0F) - (getC() ? 0 : 1)) & 0x1F];
+    
+    // Subtract the upper digits including the decimal borrow
+    u8 hi = decimal.sub[(u8)((reg.a >> 4) - (op >> 4) - (lo >> 4)) & 0x1F];
     
     setC(sum < 0x100);
     setV(((reg.a ^ sum) & 0x80) && ((reg.a ^ op) & 0x80));
     setZ((sum & 0xFF) == 0);
     setN(sum & 0x80);
     
-    reg.a = (u8)((highDigit << 4) | (lowDigit & 0x0f));
+    reg.a = (u8)((hi << 4) | (lo & 0x0F));
 }
 
 template <typename M> void
@@ -444,15 +453,16 @@ CPU<M>::executeOneCycle()
 {
     u8 instr;
     
-    switch (next) {
+    DISPATCH(next) {
             
-        case fetch:
+        CASE(fetch)
                         
             // Check interrupt lines
             if (unlikely(doNmi)) {
                 
-                if (isC64CPU()) {
+                if constexpr (isC64CPU()) {
                     expansionport.nmiWillTrigger();
+                    if (unlikely(c64.journal.isRecording())) c64.journal.recordIO();
                 }
                 
                 trace(IRQ_DEBUG, "NMI (source = %02X)\n", nmiLine);
@@ -466,14 +476,33 @@ CPU<M>::executeOneCycle()
             } else if (unlikely(doIrq)) {
                 
                 trace(IRQ_DEBUG, "IRQ (source = %02X)\n", irqLine);
+                if constexpr (isC64CPU()) {
+                    if (unlikely(c64.journal.isRecording())) c64.journal.recordIO();
+                }
                 IDLE_FETCH
                 next = irq_2;
                 doIrq = false;
                 return;
             }
             
+            // Intercept the Kernal's LOAD routine if requested
+            if constexpr (isC64CPU()) {
+                if (unlikely(reg.pc == 0xF4A5)) c64.trapLoad();
+            }
+            
             // Execute the Fetch phase
             FETCH_OPCODE
+            if constexpr (isC64CPU()) {
+                if (unlikely(debugger.isProfiling())) {
+                    debugger.profileInstruction(reg.pc0, instr);
+                }
+                if (unlikely(debugger.isRecordingCoverage())) {
+                    debugger.recordEdge(reg.pc0);
+                }
+                if (unlikely(c64.journal.isRecording())) {
+                    c64.journal.recordInstruction(c64);
+                }
+            }
             next = actionFunc[instr];
             return;
             
@@ -481,12 +510,12 @@ CPU<M>::executeOneCycle()
         // Illegal instructions
         //
             
-        case JAM:
+        CASE(JAM)
             
             c64.signalJammed();
             CONTINUE
 
-        case JAM_2:
+        CASE(JAM_2)
             POLL_INT
             DONE
 
@@ -494,17 +523,17 @@ CPU<M>::executeOneCycle()
         // IRQ handling
         //
             
-        case irq_2:
+        CASE(irq_2)
             
             IDLE_READ_IMPLIED
             CONTINUE
             
-        case irq_3:
+        CASE(irq_3)
             
             PUSH_PCH
             CONTINUE
             
-        case irq_4:
+        CASE(irq_4)
             
             PUSH_PCL
             // Check for interrupt hijacking
@@ -518,19 +547,19 @@ CPU<M>::executeOneCycle()
             }
             CONTINUE
             
-        case irq_5:
+        CASE(irq_5)
             
             mem.poke(0x100+(reg.sp--), getPWithClearedB());
             CONTINUE
             
-        case irq_6:
+        CASE(irq_6)
             
             READ_FROM(0xFFFE)
             setPCL(reg.d);
             setI(1);
             CONTINUE
             
-        case irq_7:
+        CASE(irq_7)
             
             READ_FROM(0xFFFF)
             setPCH(reg.d);
@@ -540,39 +569,39 @@ CPU<M>::executeOneCycle()
         // NMI handling
         // 
         
-        case nmi_2:
+        CASE(nmi_2)
 
             IDLE_READ_IMPLIED
             CONTINUE
             
-        case nmi_3:
+        CASE(nmi_3)
             
             PUSH_PCH
             CONTINUE
             
-        case nmi_4:
+        CASE(nmi_4)
             
             PUSH_PCL
             CONTINUE
             
-        case nmi_5:
+        CASE(nmi_5)
             
             mem.poke(0x100+(reg.sp--), getPWithClearedB());
             CONTINUE
             
-        case nmi_6:
+        CASE(nmi_6)
             
             READ_FROM(0xFFFA)
             setPCL(reg.d);
             setI(1);
             CONTINUE
             
-        case nmi_7:
+        CASE(nmi_7)
 
             READ_FROM(0xFFFB)
             setPCH(reg.d);
             
-            if (isC64CPU()) {
+            if constexpr (isC64CPU()) {
                 expansionport.nmiDidTrigger();
             }
             DONE
@@ -581,7 +610,7 @@ CPU<M>::executeOneCycle()
         // Adressing mode: Immediate (shared behavior)
         //
 
-        case BRK: case RTI: case RTS:
+        CASE(BRK) CASE(RTI) CASE(RTS)
             
             IDLE_READ_IMMEDIATE
             CONTINUE
@@ -590,7 +619,7 @@ CPU<M>::executeOneCycle()
         // Adressing mode: Implied (shared behavior)
         //
 
-        case PHA: case PHP: case PLA: case PLP:
+        CASE(PHA) CASE(PHP) CASE(PLA) CASE(PLP)
             
             IDLE_READ_IMPLIED
             CONTINUE
@@ -599,21 +628,21 @@ CPU<M>::executeOneCycle()
         // Adressing mode: Zero-Page  (shared behavior)
         //
         
-        case ADC_zpg: case AND_zpg: case ASL_zpg: case BIT_zpg:
-        case CMP_zpg: case CPX_zpg: case CPY_zpg: case DEC_zpg:
-        case EOR_zpg: case INC_zpg: case LDA_zpg: case LDX_zpg:
-        case LDY_zpg: case LSR_zpg: case NOP_zpg: case ORA_zpg:
-        case ROL_zpg: case ROR_zpg: case SBC_zpg: case STA_zpg:
-        case STX_zpg: case STY_zpg: case DCP_zpg: case ISC_zpg:
-        case LAX_zpg: case RLA_zpg: case RRA_zpg: case SAX_zpg:
-        case SLO_zpg: case SRE_zpg:
+        CASE(ADC_zpg) CASE(AND_zpg) CASE(ASL_zpg) CASE(BIT_zpg)
+        CASE(CMP_zpg) CASE(CPX_zpg) CASE(CPY_zpg) CASE(DEC_zpg)
+        CASE(EOR_zpg) CASE(INC_zpg) CASE(LDA_zpg) CASE(LDX_zpg)
+        CASE(LDY_zpg) CASE(LSR_zpg) CASE(NOP_zpg) CASE(ORA_zpg)
+        CASE(ROL_zpg) CASE(ROR_zpg) CASE(SBC_zpg) CASE(STA_zpg)
+        CASE(STX_zpg) CASE(STY_zpg) CASE(DCP_zpg) CASE(ISC_zpg)
+        CASE(LAX_zpg) CASE(RLA_zpg) CASE(RRA_zpg) CASE(SAX_zpg)
+        CASE(SLO_zpg) CASE(SRE_zpg)
             
             FETCH_ADDR_LO
             CONTINUE
             
-        case ASL_zpg_2: case DEC_zpg_2: case INC_zpg_2: case LSR_zpg_2:
-        case ROL_zpg_2: case ROR_zpg_2: case DCP_zpg_2: case ISC_zpg_2:
-        case RLA_zpg_2: case RRA_zpg_2: case SLO_zpg_2: case SRE_zpg_2:
+        CASE(ASL_zpg_2) CASE(DEC_zpg_2) CASE(INC_zpg_2) CASE(LSR_zpg_2)
+        CASE(ROL_zpg_2) CASE(ROR_zpg_2) CASE(DCP_zpg_2) CASE(ISC_zpg_2)
+        CASE(RLA_zpg_2) CASE(RRA_zpg_2) CASE(SLO_zpg_2) CASE(SRE_zpg_2)
             
             READ_FROM_ZERO_PAGE
             CONTINUE
@@ -622,38 +651,38 @@ CPU<M>::executeOneCycle()
         // Adressing mode: Zero-Page Indexed (shared behavior)
         //
             
-        case ADC_zpg_x: case AND_zpg_x: case ASL_zpg_x: case CMP_zpg_x:
-        case DEC_zpg_x: case EOR_zpg_x: case INC_zpg_x: case LDA_zpg_x:
-        case LDY_zpg_x: case LSR_zpg_x: case NOP_zpg_x: case ORA_zpg_x:
-        case ROL_zpg_x: case ROR_zpg_x: case SBC_zpg_x: case STA_zpg_x:
-        case STY_zpg_x: case DCP_zpg_x: case ISC_zpg_x: case RLA_zpg_x:
-        case RRA_zpg_x: case SLO_zpg_x: case SRE_zpg_x:
+        CASE(ADC_zpg_x) CASE(AND_zpg_x) CASE(ASL_zpg_x) CASE(CMP_zpg_x)
+        CASE(DEC_zpg_x) CASE(EOR_zpg_x) CASE(INC_zpg_x) CASE(LDA_zpg_x)
+        CASE(LDY_zpg_x) CASE(LSR_zpg_x) CASE(NOP_zpg_x) CASE(ORA_zpg_x)
+        CASE(ROL_zpg_x) CASE(ROR_zpg_x) CASE(SBC_zpg_x) CASE(STA_zpg_x)
+        CASE(STY_zpg_x) CASE(DCP_zpg_x) CASE(ISC_zpg_x) CASE(RLA_zpg_x)
+        CASE(RRA_zpg_x) CASE(SLO_zpg_x) CASE(SRE_zpg_x)
           
-        case LDX_zpg_y: case STX_zpg_y: case LAX_zpg_y: case SAX_zpg_y:
+        CASE(LDX_zpg_y) CASE(STX_zpg_y) CASE(LAX_zpg_y) CASE(SAX_zpg_y)
             
             FETCH_ADDR_LO
             CONTINUE
            
-        case ADC_zpg_x_2: case AND_zpg_x_2: case ASL_zpg_x_2: case CMP_zpg_x_2:
-        case DEC_zpg_x_2: case EOR_zpg_x_2: case INC_zpg_x_2: case LDA_zpg_x_2:
-        case LDY_zpg_x_2: case LSR_zpg_x_2: case NOP_zpg_x_2: case ORA_zpg_x_2:
-        case ROL_zpg_x_2: case ROR_zpg_x_2: case SBC_zpg_x_2: case DCP_zpg_x_2:
-        case ISC_zpg_x_2: case RLA_zpg_x_2: case RRA_zpg_x_2: case SLO_zpg_x_2:
-        case SRE_zpg_x_2: case STA_zpg_x_2: case STY_zpg_x_2:
+        CASE(ADC_zpg_x_2) CASE(AND_zpg_x_2) CASE(ASL_zpg_x_2) CASE(CMP_zpg_x_2)
+        CASE(DEC_zpg_x_2) CASE(EOR_zpg_x_2) CASE(INC_zpg_x_2) CASE(LDA_zpg_x_2)
+        CASE(LDY_zpg_x_2) CASE(LSR_zpg_x_2) CASE(NOP_zpg_x_2) CASE(ORA_zpg_x_2)
+        CASE(ROL_zpg_x_2) CASE(ROR_zpg_x_2) CASE(SBC_zpg_x_2) CASE(DCP_zpg_x_2)
+        CASE(ISC_zpg_x_2) CASE(RLA_zpg_x_2) CASE(RRA_zpg_x_2) CASE(SLO_zpg_x_2)
+        CASE(SRE_zpg_x_2) CASE(STA_zpg_x_2) CASE(STY_zpg_x_2)
             
             READ_FROM_ZERO_PAGE
             ADD_INDEX_X
             CONTINUE
         
-        case LDX_zpg_y_2: case LAX_zpg_y_2: case STX_zpg_y_2: case SAX_zpg_y_2:
+        CASE(LDX_zpg_y_2) CASE(LAX_zpg_y_2) CASE(STX_zpg_y_2) CASE(SAX_zpg_y_2)
             
             READ_FROM_ZERO_PAGE
             ADD_INDEX_Y
             CONTINUE
            
-        case ASL_zpg_x_3: case DEC_zpg_x_3: case INC_zpg_x_3: case LSR_zpg_x_3:
-        case ROL_zpg_x_3: case ROR_zpg_x_3: case DCP_zpg_x_3: case ISC_zpg_x_3:
-        case RLA_zpg_x_3: case RRA_zpg_x_3: case SLO_zpg_x_3: case SRE_zpg_x_3:
+        CASE(ASL_zpg_x_3) CASE(DEC_zpg_x_3) CASE(INC_zpg_x_3) CASE(LSR_zpg_x_3)
+        CASE(ROL_zpg_x_3) CASE(ROR_zpg_x_3) CASE(DCP_zpg_x_3) CASE(ISC_zpg_x_3)
+        CASE(RLA_zpg_x_3) CASE(RRA_zpg_x_3) CASE(SLO_zpg_x_3) CASE(SRE_zpg_x_3)
             
             READ_FROM_ZERO_PAGE
             CONTINUE
@@ -663,33 +692,33 @@ CPU<M>::executeOneCycle()
         // Adressing mode: Absolute (shared behavior)
         //
             
-        case ADC_abs: case AND_abs: case ASL_abs: case BIT_abs:
-        case CMP_abs: case CPX_abs: case CPY_abs: case DEC_abs:
-        case EOR_abs: case INC_abs: case LDA_abs: case LDX_abs:
-        case LDY_abs: case LSR_abs: case NOP_abs: case ORA_abs:
-        case ROL_abs: case ROR_abs: case SBC_abs: case STA_abs:
-        case STX_abs: case STY_abs: case DCP_abs: case ISC_abs:
-        case LAX_abs: case RLA_abs: case RRA_abs: case SAX_abs:
-        case SLO_abs: case SRE_abs:
+        CASE(ADC_abs) CASE(AND_abs) CASE(ASL_abs) CASE(BIT_abs)
+        CASE(CMP_abs) CASE(CPX_abs) CASE(CPY_abs) CASE(DEC_abs)
+        CASE(EOR_abs) CASE(INC_abs) CASE(LDA_abs) CASE(LDX_abs)
+        CASE(LDY_abs) CASE(LSR_abs) CASE(NOP_abs) CASE(ORA_abs)
+        CASE(ROL_abs) CASE(ROR_abs) CASE(SBC_abs) CASE(STA_abs)
+        CASE(STX_abs) CASE(STY_abs) CASE(DCP_abs) CASE(ISC_abs)
+        CASE(LAX_abs) CASE(RLA_abs) CASE(RRA_abs) CASE(SAX_abs)
+        CASE(SLO_abs) CASE(SRE_abs)
             
             FETCH_ADDR_LO
             CONTINUE
            
-        case ADC_abs_2: case AND_abs_2: case ASL_abs_2: case BIT_abs_2:
-        case CMP_abs_2: case CPX_abs_2: case CPY_abs_2: case DEC_abs_2:
-        case EOR_abs_2: case INC_abs_2: case LDA_abs_2: case LDX_abs_2:
-        case LDY_abs_2: case LSR_abs_2: case NOP_abs_2: case ORA_abs_2:
-        case ROL_abs_2: case ROR_abs_2: case SBC_abs_2: case STA_abs_2:
-        case STX_abs_2: case STY_abs_2: case DCP_abs_2: case ISC_abs_2:
-        case LAX_abs_2: case RLA_abs_2: case RRA_abs_2: case SAX_abs_2:
-        case SLO_abs_2: case SRE_abs_2:
+        CASE(ADC_abs_2) CASE(AND_abs_2) CASE(ASL_abs_2) CASE(BIT_abs_2)
+        CASE(CMP_abs_2) CASE(CPX_abs_2) CASE(CPY_abs_2) CASE(DEC_abs_2)
+        CASE(EOR_abs_2) CASE(INC_abs_2) CASE(LDA_abs_2) CASE(LDX_abs_2)
+        CASE(LDY_abs_2) CASE(LSR_abs_2) CASE(NOP_abs_2) CASE(ORA_abs_2)
+        CASE(ROL_abs_2) CASE(ROR_abs_2) CASE(SBC_abs_2) CASE(STA_abs_2)
+        CASE(STX_abs_2) CASE(STY_abs_2) CASE(DCP_abs_2) CASE(ISC_abs_2)
+        CASE(LAX_abs_2) CASE(RLA_abs_2) CASE(RRA_abs_2) CASE(SAX_abs_2)
+        CASE(SLO_abs_2) CASE(SRE_abs_2)
             
             FETCH_ADDR_HI
             CONTINUE
             
-        case ASL_abs_3: case DEC_abs_3: case INC_abs_3: case LSR_abs_3:
-        case ROL_abs_3: case ROR_abs_3: case DCP_abs_3: case ISC_abs_3:
-        case RLA_abs_3: case RRA_abs_3: case SLO_abs_3: case SRE_abs_3:
+        CASE(ASL_abs_3) CASE(DEC_abs_3) CASE(INC_abs_3) CASE(LSR_abs_3)
+        CASE(ROL_abs_3) CASE(ROR_abs_3) CASE(DCP_abs_3) CASE(ISC_abs_3)
+        CASE(RLA_abs_3) CASE(RRA_abs_3) CASE(SLO_abs_3) CASE(SRE_abs_3)
             
             READ_FROM_ADDRESS
             CONTINUE
@@ -698,63 +727,63 @@ CPU<M>::executeOneCycle()
         // Adressing mode: Absolute Indexed (shared behavior)
         //
             
-        case ADC_abs_x: case AND_abs_x: case ASL_abs_x: case CMP_abs_x:
-        case DEC_abs_x: case EOR_abs_x: case INC_abs_x: case LDA_abs_x:
-        case LDY_abs_x: case LSR_abs_x: case NOP_abs_x: case ORA_abs_x:
-        case ROL_abs_x: case ROR_abs_x: case SBC_abs_x: case STA_abs_x:
-        case DCP_abs_x: case ISC_abs_x: case RLA_abs_x: case RRA_abs_x:
-        case SHY_abs_x: case SLO_abs_x: case SRE_abs_x:
+        CASE(ADC_abs_x) CASE(AND_abs_x) CASE(ASL_abs_x) CASE(CMP_abs_x)
+        CASE(DEC_abs_x) CASE(EOR_abs_x) CASE(INC_abs_x) CASE(LDA_abs_x)
+        CASE(LDY_abs_x) CASE(LSR_abs_x) CASE(NOP_abs_x) CASE(ORA_abs_x)
+        CASE(ROL_abs_x) CASE(ROR_abs_x) CASE(SBC_abs_x) CASE(STA_abs_x)
+        CASE(DCP_abs_x) CASE(ISC_abs_x) CASE(RLA_abs_x) CASE(RRA_abs_x)
+        CASE(SHY_abs_x) CASE(SLO_abs_x) CASE(SRE_abs_x)
             
-        case ADC_abs_y: case AND_abs_y: case CMP_abs_y: case EOR_abs_y:
-        case LDA_abs_y: case LDX_abs_y: case LSR_abs_y: case ORA_abs_y:
-        case SBC_abs_y: case STA_abs_y: case DCP_abs_y: case ISC_abs_y:
-        case LAS_abs_y: case LAX_abs_y: case RLA_abs_y: case RRA_abs_y:
-        case SHA_abs_y: case SHX_abs_y: case SLO_abs_y: case SRE_abs_y:
-        case TAS_abs_y:
+        CASE(ADC_abs_y) CASE(AND_abs_y) CASE(CMP_abs_y) CASE(EOR_abs_y)
+        CASE(LDA_abs_y) CASE(LDX_abs_y) CASE(LSR_abs_y) CASE(ORA_abs_y)
+        CASE(SBC_abs_y) CASE(STA_abs_y) CASE(DCP_abs_y) CASE(ISC_abs_y)
+        CASE(LAS_abs_y) CASE(LAX_abs_y) CASE(RLA_abs_y) CASE(RRA_abs_y)
+        CASE(SHA_abs_y) CASE(SHX_abs_y) CASE(SLO_abs_y) CASE(SRE_abs_y)
+        CASE(TAS_abs_y)
             
             FETCH_ADDR_LO
             CONTINUE
             
-        case ADC_abs_x_2: case AND_abs_x_2: case ASL_abs_x_2: case CMP_abs_x_2:
-        case DEC_abs_x_2: case EOR_abs_x_2: case INC_abs_x_2: case LDA_abs_x_2:
-        case LDY_abs_x_2: case LSR_abs_x_2: case NOP_abs_x_2: case ORA_abs_x_2:
-        case ROL_abs_x_2: case ROR_abs_x_2: case SBC_abs_x_2: case STA_abs_x_2:
-        case DCP_abs_x_2: case ISC_abs_x_2: case RLA_abs_x_2: case RRA_abs_x_2:
-        case SHY_abs_x_2: case SLO_abs_x_2: case SRE_abs_x_2:
+        CASE(ADC_abs_x_2) CASE(AND_abs_x_2) CASE(ASL_abs_x_2) CASE(CMP_abs_x_2)
+        CASE(DEC_abs_x_2) CASE(EOR_abs_x_2) CASE(INC_abs_x_2) CASE(LDA_abs_x_2)
+        CASE(LDY_abs_x_2) CASE(LSR_abs_x_2) CASE(NOP_abs_x_2) CASE(ORA_abs_x_2)
+        CASE(ROL_abs_x_2) CASE(ROR_abs_x_2) CASE(SBC_abs_x_2) CASE(STA_abs_x_2)
+        CASE(DCP_abs_x_2) CASE(ISC_abs_x_2) CASE(RLA_abs_x_2) CASE(RRA_abs_x_2)
+        CASE(SHY_abs_x_2) CASE(SLO_abs_x_2) CASE(SRE_abs_x_2)
             
             FETCH_ADDR_HI
             ADD_INDEX_X
             CONTINUE
             
-        case ADC_abs_y_2: case AND_abs_y_2: case CMP_abs_y_2: case EOR_abs_y_2:
-        case LDA_abs_y_2: case LDX_abs_y_2: case LSR_abs_y_2: case ORA_abs_y_2:
-        case SBC_abs_y_2: case STA_abs_y_2: case DCP_abs_y_2: case ISC_abs_y_2:
-        case LAS_abs_y_2: case LAX_abs_y_2: case RLA_abs_y_2: case RRA_abs_y_2:
-        case SHA_abs_y_2: case SHX_abs_y_2: case SLO_abs_y_2: case SRE_abs_y_2:
-        case TAS_abs_y_2:
+        CASE(ADC_abs_y_2) CASE(AND_abs_y_2) CASE(CMP_abs_y_2) CASE(EOR_abs_y_2)
+        CASE(LDA_abs_y_2) CASE(LDX_abs_y_2) CASE(LSR_abs_y_2) CASE(ORA_abs_y_2)
+        CASE(SBC_abs_y_2) CASE(STA_abs_y_2) CASE(DCP_abs_y_2) CASE(ISC_abs_y_2)
+        CASE(LAS_abs_y_2) CASE(LAX_abs_y_2) CASE(RLA_abs_y_2) CASE(RRA_abs_y_2)
+        CASE(SHA_abs_y_2) CASE(SHX_abs_y_2) CASE(SLO_abs_y_2) CASE(SRE_abs_y_2)
+        CASE(TAS_abs_y_2)
             
             FETCH_ADDR_HI
             ADD_INDEX_Y
             CONTINUE
             
-        case ASL_abs_x_3: case DEC_abs_x_3: case INC_abs_x_3: case LSR_abs_x_3:
-        case ROL_abs_x_3: case ROR_abs_x_3: case DCP_abs_x_3: case ISC_abs_x_3:
-        case RLA_abs_x_3: case RRA_abs_x_3: case STA_abs_x_3: case SLO_abs_x_3:
-        case SRE_abs_x_3:
+        CASE(ASL_abs_x_3) CASE(DEC_abs_x_3) CASE(INC_abs_x_3) CASE(LSR_abs_x_3)
+        CASE(ROL_abs_x_3) CASE(ROR_abs_x_3) CASE(DCP_abs_x_3) CASE(ISC_abs_x_3)
+        CASE(RLA_abs_x_3) CASE(RRA_abs_x_3) CASE(STA_abs_x_3) CASE(SLO_abs_x_3)
+        CASE(SRE_abs_x_3)
         
-        case LSR_abs_y_3: case STA_abs_y_3: case DCP_abs_y_3: case ISC_abs_y_3:
-        case RLA_abs_y_3: case RRA_abs_y_3: case SLO_abs_y_3: case SRE_abs_y_3:
+        CASE(LSR_abs_y_3) CASE(STA_abs_y_3) CASE(DCP_abs_y_3) CASE(ISC_abs_y_3)
+        CASE(RLA_abs_y_3) CASE(RRA_abs_y_3) CASE(SLO_abs_y_3) CASE(SRE_abs_y_3)
             
             READ_FROM_ADDRESS
             if (PAGE_BOUNDARY_CROSSED) { FIX_ADDR_HI }
             CONTINUE
             
-        case ASL_abs_x_4: case DEC_abs_x_4: case INC_abs_x_4: case LSR_abs_x_4:
-        case ROL_abs_x_4: case ROR_abs_x_4: case DCP_abs_x_4: case ISC_abs_x_4:
-        case RLA_abs_x_4: case RRA_abs_x_4: case SLO_abs_x_4: case SRE_abs_x_4:
+        CASE(ASL_abs_x_4) CASE(DEC_abs_x_4) CASE(INC_abs_x_4) CASE(LSR_abs_x_4)
+        CASE(ROL_abs_x_4) CASE(ROR_abs_x_4) CASE(DCP_abs_x_4) CASE(ISC_abs_x_4)
+        CASE(RLA_abs_x_4) CASE(RRA_abs_x_4) CASE(SLO_abs_x_4) CASE(SRE_abs_x_4)
             
-        case DCP_abs_y_4: case LSR_abs_y_4: case ISC_abs_y_4: case RLA_abs_y_4:
-        case RRA_abs_y_4: case SLO_abs_y_4: case SRE_abs_y_4:
+        CASE(DCP_abs_y_4) CASE(LSR_abs_y_4) CASE(ISC_abs_y_4) CASE(RLA_abs_y_4)
+        CASE(RRA_abs_y_4) CASE(SLO_abs_y_4) CASE(SRE_abs_y_4)
             
             READ_FROM_ADDRESS
             CONTINUE
@@ -763,50 +792,50 @@ CPU<M>::executeOneCycle()
         // Adressing mode: Indexed Indirect (shared behavior)
         //
     
-        case ADC_ind_x: case AND_ind_x: case ASL_ind_x: case CMP_ind_x:
-        case DEC_ind_x: case EOR_ind_x: case INC_ind_x: case LDA_ind_x:
-        case LDX_ind_x: case LDY_ind_x: case LSR_ind_x: case ORA_ind_x:
-        case ROL_ind_x: case ROR_ind_x: case SBC_ind_x: case STA_ind_x:
-        case DCP_ind_x: case ISC_ind_x: case LAX_ind_x: case RLA_ind_x:
-        case RRA_ind_x: case SAX_ind_x: case SLO_ind_x: case SRE_ind_x:
+        CASE(ADC_ind_x) CASE(AND_ind_x) CASE(ASL_ind_x) CASE(CMP_ind_x)
+        CASE(DEC_ind_x) CASE(EOR_ind_x) CASE(INC_ind_x) CASE(LDA_ind_x)
+        CASE(LDX_ind_x) CASE(LDY_ind_x) CASE(LSR_ind_x) CASE(ORA_ind_x)
+        CASE(ROL_ind_x) CASE(ROR_ind_x) CASE(SBC_ind_x) CASE(STA_ind_x)
+        CASE(DCP_ind_x) CASE(ISC_ind_x) CASE(LAX_ind_x) CASE(RLA_ind_x)
+        CASE(RRA_ind_x) CASE(SAX_ind_x) CASE(SLO_ind_x) CASE(SRE_ind_x)
             
             FETCH_POINTER_ADDR
             CONTINUE
             
-        case ADC_ind_x_2: case AND_ind_x_2: case ASL_ind_x_2: case CMP_ind_x_2:
-        case DEC_ind_x_2: case EOR_ind_x_2: case INC_ind_x_2: case LDA_ind_x_2:
-        case LDX_ind_x_2: case LDY_ind_x_2: case LSR_ind_x_2: case ORA_ind_x_2:
-        case ROL_ind_x_2: case ROR_ind_x_2: case SBC_ind_x_2: case STA_ind_x_2:
-        case DCP_ind_x_2: case ISC_ind_x_2: case LAX_ind_x_2: case RLA_ind_x_2:
-        case RRA_ind_x_2: case SAX_ind_x_2: case SLO_ind_x_2: case SRE_ind_x_2:
+        CASE(ADC_ind_x_2) CASE(AND_ind_x_2) CASE(ASL_ind_x_2) CASE(CMP_ind_x_2)
+        CASE(DEC_ind_x_2) CASE(EOR_ind_x_2) CASE(INC_ind_x_2) CASE(LDA_ind_x_2)
+        CASE(LDX_ind_x_2) CASE(LDY_ind_x_2) CASE(LSR_ind_x_2) CASE(ORA_ind_x_2)
+        CASE(ROL_ind_x_2) CASE(ROR_ind_x_2) CASE(SBC_ind_x_2) CASE(STA_ind_x_2)
+        CASE(DCP_ind_x_2) CASE(ISC_ind_x_2) CASE(LAX_ind_x_2) CASE(RLA_ind_x_2)
+        CASE(RRA_ind_x_2) CASE(SAX_ind_x_2) CASE(SLO_ind_x_2) CASE(SRE_ind_x_2)
             
             IDLE_READ_FROM_ADDRESS_INDIRECT
             ADD_INDEX_X_INDIRECT
             CONTINUE
             
-        case ADC_ind_x_3: case AND_ind_x_3: case ASL_ind_x_3: case CMP_ind_x_3:
-        case DEC_ind_x_3: case EOR_ind_x_3: case INC_ind_x_3: case LDA_ind_x_3:
-        case LDX_ind_x_3: case LDY_ind_x_3: case LSR_ind_x_3: case ORA_ind_x_3:
-        case ROL_ind_x_3: case ROR_ind_x_3: case SBC_ind_x_3: case STA_ind_x_3:
-        case DCP_ind_x_3: case ISC_ind_x_3: case LAX_ind_x_3: case RLA_ind_x_3:
-        case RRA_ind_x_3: case SAX_ind_x_3: case SLO_ind_x_3: case SRE_ind_x_3:
+        CASE(ADC_ind_x_3) CASE(AND_ind_x_3) CASE(ASL_ind_x_3) CASE(CMP_ind_x_3)
+        CASE(DEC_ind_x_3) CASE(EOR_ind_x_3) CASE(INC_ind_x_3) CASE(LDA_ind_x_3)
+        CASE(LDX_ind_x_3) CASE(LDY_ind_x_3) CASE(LSR_ind_x_3) CASE(ORA_ind_x_3)
+        CASE(ROL_ind_x_3) CASE(ROR_ind_x_3) CASE(SBC_ind_x_3) CASE(STA_ind_x_3)
+        CASE(DCP_ind_x_3) CASE(ISC_ind_x_3) CASE(LAX_ind_x_3) CASE(RLA_ind_x_3)
+        CASE(RRA_ind_x_3) CASE(SAX_ind_x_3) CASE(SLO_ind_x_3) CASE(SRE_ind_x_3)
             
             FETCH_ADDR_LO_INDIRECT
             CONTINUE
             
-        case ADC_ind_x_4: case AND_ind_x_4: case ASL_ind_x_4: case CMP_ind_x_4:
-        case DEC_ind_x_4: case EOR_ind_x_4: case INC_ind_x_4: case LDA_ind_x_4:
-        case LDX_ind_x_4: case LDY_ind_x_4: case LSR_ind_x_4: case ORA_ind_x_4:
-        case ROL_ind_x_4: case ROR_ind_x_4: case SBC_ind_x_4: case STA_ind_x_4:
-        case DCP_ind_x_4: case ISC_ind_x_4: case LAX_ind_x_4: case RLA_ind_x_4:
-        case RRA_ind_x_4: case SAX_ind_x_4: case SLO_ind_x_4: case SRE_ind_x_4:
+        CASE(ADC_ind_x_4) CASE(AND_ind_x_4) CASE(ASL_ind_x_4) CASE(CMP_ind_x_4)
+        CASE(DEC_ind_x_4) CASE(EOR_ind_x_4) CASE(INC_ind_x_4) CASE(LDA_ind_x_4)
+        CASE(LDX_ind_x_4) CASE(LDY_ind_x_4) CASE(LSR_ind_x_4) CASE(ORA_ind_x_4)
+        CASE(ROL_ind_x_4) CASE(ROR_ind_x_4) CASE(SBC_ind_x_4) CASE(STA_ind_x_4)
+        CASE(DCP_ind_x_4) CASE(ISC_ind_x_4) CASE(LAX_ind_x_4) CASE(RLA_ind_x_4)
+        CASE(RRA_ind_x_4) CASE(SAX_ind_x_4) CASE(SLO_ind_x_4) CASE(SRE_ind_x_4)
             
             FETCH_ADDR_HI_INDIRECT
             CONTINUE
             
-        case ASL_ind_x_5: case DEC_ind_x_5: case INC_ind_x_5: case LSR_ind_x_5:
-        case ROL_ind_x_5: case ROR_ind_x_5: case DCP_ind_x_5: case ISC_ind_x_5:
-        case RLA_ind_x_5: case RRA_ind_x_5: case SLO_ind_x_5: case SRE_ind_x_5:
+        CASE(ASL_ind_x_5) CASE(DEC_ind_x_5) CASE(INC_ind_x_5) CASE(LSR_ind_x_5)
+        CASE(ROL_ind_x_5) CASE(ROR_ind_x_5) CASE(DCP_ind_x_5) CASE(ISC_ind_x_5)
+        CASE(RLA_ind_x_5) CASE(RRA_ind_x_5) CASE(SLO_ind_x_5) CASE(SRE_ind_x_5)
             
             READ_FROM_ADDRESS
             CONTINUE
@@ -815,43 +844,43 @@ CPU<M>::executeOneCycle()
         // Adressing mode: Indirect Indexed (shared behavior)
         //
             
-        case ADC_ind_y: case AND_ind_y: case CMP_ind_y: case EOR_ind_y:
-        case LDA_ind_y: case LDX_ind_y: case LDY_ind_y: case LSR_ind_y:
-        case ORA_ind_y: case SBC_ind_y: case STA_ind_y: case DCP_ind_y:
-        case ISC_ind_y: case LAX_ind_y: case RLA_ind_y: case RRA_ind_y:
-        case SHA_ind_y: case SLO_ind_y: case SRE_ind_y:
+        CASE(ADC_ind_y) CASE(AND_ind_y) CASE(CMP_ind_y) CASE(EOR_ind_y)
+        CASE(LDA_ind_y) CASE(LDX_ind_y) CASE(LDY_ind_y) CASE(LSR_ind_y)
+        CASE(ORA_ind_y) CASE(SBC_ind_y) CASE(STA_ind_y) CASE(DCP_ind_y)
+        CASE(ISC_ind_y) CASE(LAX_ind_y) CASE(RLA_ind_y) CASE(RRA_ind_y)
+        CASE(SHA_ind_y) CASE(SLO_ind_y) CASE(SRE_ind_y)
             
             FETCH_POINTER_ADDR
             CONTINUE
            
-        case ADC_ind_y_2: case AND_ind_y_2: case CMP_ind_y_2: case EOR_ind_y_2:
-        case LDA_ind_y_2: case LDX_ind_y_2: case LDY_ind_y_2: case LSR_ind_y_2:
-        case ORA_ind_y_2: case SBC_ind_y_2: case STA_ind_y_2: case DCP_ind_y_2:
-        case ISC_ind_y_2: case LAX_ind_y_2: case RLA_ind_y_2: case RRA_ind_y_2:
-        case SHA_ind_y_2: case SLO_ind_y_2: case SRE_ind_y_2:
+        CASE(ADC_ind_y_2) CASE(AND_ind_y_2) CASE(CMP_ind_y_2) CASE(EOR_ind_y_2)
+        CASE(LDA_ind_y_2) CASE(LDX_ind_y_2) CASE(LDY_ind_y_2) CASE(LSR_ind_y_2)
+        CASE(ORA_ind_y_2) CASE(SBC_ind_y_2) CASE(STA_ind_y_2) CASE(DCP_ind_y_2)
+        CASE(ISC_ind_y_2) CASE(LAX_ind_y_2) CASE(RLA_ind_y_2) CASE(RRA_ind_y_2)
+        CASE(SHA_ind_y_2) CASE(SLO_ind_y_2) CASE(SRE_ind_y_2)
             
             FETCH_ADDR_LO_INDIRECT
             CONTINUE
             
-        case ADC_ind_y_3: case AND_ind_y_3: case CMP_ind_y_3: case EOR_ind_y_3:
-        case LDA_ind_y_3: case LDX_ind_y_3: case LDY_ind_y_3: case LSR_ind_y_3:
-        case ORA_ind_y_3: case SBC_ind_y_3: case STA_ind_y_3: case DCP_ind_y_3:
-        case ISC_ind_y_3: case LAX_ind_y_3: case RLA_ind_y_3: case RRA_ind_y_3:
-        case SHA_ind_y_3: case SLO_ind_y_3: case SRE_ind_y_3:
+        CASE(ADC_ind_y_3) CASE(AND_ind_y_3) CASE(CMP_ind_y_3) CASE(EOR_ind_y_3)
+        CASE(LDA_ind_y_3) CASE(LDX_ind_y_3) CASE(LDY_ind_y_3) CASE(LSR_ind_y_3)
+        CASE(ORA_ind_y_3) CASE(SBC_ind_y_3) CASE(STA_ind_y_3) CASE(DCP_ind_y_3)
+        CASE(ISC_ind_y_3) CASE(LAX_ind_y_3) CASE(RLA_ind_y_3) CASE(RRA_ind_y_3)
+        CASE(SHA_ind_y_3) CASE(SLO_ind_y_3) CASE(SRE_ind_y_3)
             
             FETCH_ADDR_HI_INDIRECT
             ADD_INDEX_Y
             CONTINUE
         
-        case LSR_ind_y_4: case STA_ind_y_4: case DCP_ind_y_4: case ISC_ind_y_4:
-        case RLA_ind_y_4: case RRA_ind_y_4: case SLO_ind_y_4: case SRE_ind_y_4:
+        CASE(LSR_ind_y_4) CASE(STA_ind_y_4) CASE(DCP_ind_y_4) CASE(ISC_ind_y_4)
+        CASE(RLA_ind_y_4) CASE(RRA_ind_y_4) CASE(SLO_ind_y_4) CASE(SRE_ind_y_4)
             
             READ_FROM_ADDRESS
             if (PAGE_BOUNDARY_CROSSED) { FIX_ADDR_HI }
             CONTINUE
             
-        case LSR_ind_y_5: case DCP_ind_y_5: case ISC_ind_y_5: case RLA_ind_y_5:
-        case RRA_ind_y_5: case SLO_ind_y_5: case SRE_ind_y_5:
+        CASE(LSR_ind_y_5) CASE(DCP_ind_y_5) CASE(ISC_ind_y_5) CASE(RLA_ind_y_5)
+        CASE(RRA_ind_y_5) CASE(SLO_ind_y_5) CASE(SRE_ind_y_5)
             
             READ_FROM_ADDRESS
             CONTINUE
@@ -860,8 +889,8 @@ CPU<M>::executeOneCycle()
         // Adressing mode: Relative (shared behavior)
         //
             
-        case BCC_rel_2: case BCS_rel_2: case BEQ_rel_2: case BMI_rel_2:
-        case BNE_rel_2: case BPL_rel_2: case BVC_rel_2: case BVS_rel_2:
+        CASE(BCC_rel_2) CASE(BCS_rel_2) CASE(BEQ_rel_2) CASE(BMI_rel_2)
+        CASE(BNE_rel_2) CASE(BPL_rel_2) CASE(BVC_rel_2) CASE(BVS_rel_2)
         {
             IDLE_READ_IMPLIED
             u8 pc_hi = HI_BYTE(reg.pc);
@@ -874,13 +903,13 @@ CPU<M>::executeOneCycle()
             DONE
         }
             
-        case branch_3_underflow:
+        CASE(branch_3_underflow)
             
             IDLE_READ_FROM(reg.pc + 0x100)
             POLL_INT_AGAIN
             DONE
             
-        case branch_3_overflow:
+        CASE(branch_3_overflow)
             
             IDLE_READ_FROM(reg.pc - 0x100)
             POLL_INT_AGAIN
@@ -894,24 +923,24 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / / - - /
 
-        case ADC_imm:
+        CASE(ADC_imm)
 
             READ_IMMEDIATE
             adc(reg.d);
             POLL_INT
             DONE
 
-        case ADC_zpg_2:
-        case ADC_zpg_x_3:
+        CASE(ADC_zpg_2)
+        CASE(ADC_zpg_x_3)
             
             READ_FROM_ZERO_PAGE
             adc(reg.d);
             POLL_INT
             DONE
 
-        case ADC_abs_x_3:
-        case ADC_abs_y_3:
-        case ADC_ind_y_4:
+        CASE(ADC_abs_x_3)
+        CASE(ADC_abs_y_3)
+        CASE(ADC_ind_y_4)
             
             READ_FROM_ADDRESS
             if (PAGE_BOUNDARY_CROSSED) {
@@ -923,11 +952,11 @@ CPU<M>::executeOneCycle()
                 DONE
             }
             
-        case ADC_abs_3:
-        case ADC_abs_x_4:
-        case ADC_abs_y_4:
-        case ADC_ind_x_5:
-        case ADC_ind_y_5:
+        CASE(ADC_abs_3)
+        CASE(ADC_abs_x_4)
+        CASE(ADC_abs_y_4)
+        CASE(ADC_ind_x_5)
+        CASE(ADC_ind_y_5)
             
             READ_FROM_ADDRESS
             adc(reg.d);
@@ -942,24 +971,24 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
 
-        case AND_imm:
+        CASE(AND_imm)
             
             READ_IMMEDIATE
             loadA(reg.a & reg.d);
             POLL_INT
             DONE
 
-        case AND_zpg_2:
-        case AND_zpg_x_3:
+        CASE(AND_zpg_2)
+        CASE(AND_zpg_x_3)
             
             READ_FROM_ZERO_PAGE
             loadA(reg.a & reg.d);
             POLL_INT
             DONE
             
-        case AND_abs_x_3:
-        case AND_abs_y_3:
-        case AND_ind_y_4:
+        CASE(AND_abs_x_3)
+        CASE(AND_abs_y_3)
+        CASE(AND_ind_y_4)
             
             READ_FROM_ADDRESS
             if (PAGE_BOUNDARY_CROSSED) {
@@ -971,11 +1000,11 @@ CPU<M>::executeOneCycle()
                 DONE
             }
             
-        case AND_abs_3:
-        case AND_abs_x_4:
-        case AND_abs_y_4:
-        case AND_ind_x_5:
-        case AND_ind_y_5:
+        CASE(AND_abs_3)
+        CASE(AND_abs_x_4)
+        CASE(AND_abs_y_4)
+        CASE(AND_ind_x_5)
+        CASE(AND_ind_y_5)
             
             READ_FROM_ADDRESS
             loadA(reg.a & reg.d);
@@ -993,38 +1022,38 @@ CPU<M>::executeOneCycle()
         #define DO_ASL_ACC setC(reg.a & 0x80); loadA(reg.a << 1);
         #define DO_ASL setC(reg.d & 0x80); reg.d = reg.d << 1;
 
-        case ASL_acc:
+        CASE(ASL_acc)
             
             IDLE_READ_IMPLIED
             DO_ASL_ACC
             POLL_INT
             DONE
             
-        case ASL_zpg_3:
-        case ASL_zpg_x_4:
+        CASE(ASL_zpg_3)
+        CASE(ASL_zpg_x_4)
             
             WRITE_TO_ZERO_PAGE
             DO_ASL
             CONTINUE
            
-        case ASL_abs_4:
-        case ASL_abs_x_5:
-        case ASL_ind_x_6:
+        CASE(ASL_abs_4)
+        CASE(ASL_abs_x_5)
+        CASE(ASL_ind_x_6)
             
             WRITE_TO_ADDRESS
             DO_ASL
             CONTINUE
             
-        case ASL_zpg_4:
-        case ASL_zpg_x_5:
+        CASE(ASL_zpg_4)
+        CASE(ASL_zpg_x_5)
             
             WRITE_TO_ZERO_PAGE_AND_SET_FLAGS
             POLL_INT
             DONE
             
-        case ASL_abs_5:
-        case ASL_abs_x_6:
-        case ASL_ind_x_7:
+        CASE(ASL_abs_5)
+        CASE(ASL_abs_x_6)
+        CASE(ASL_ind_x_7)
             
             WRITE_TO_ADDRESS_AND_SET_FLAGS
             POLL_INT
@@ -1038,7 +1067,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
     
-        case BCC_rel:
+        CASE(BCC_rel)
             
             READ_IMMEDIATE
             POLL_INT
@@ -1057,7 +1086,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
 
-        case BCS_rel:
+        CASE(BCS_rel)
             
             READ_IMMEDIATE
             POLL_INT
@@ -1076,7 +1105,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
             
-        case BEQ_rel:
+        CASE(BEQ_rel)
             
             READ_IMMEDIATE
             POLL_INT
@@ -1095,7 +1124,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - /
             
-        case BIT_zpg_2:
+        CASE(BIT_zpg_2)
             
             READ_FROM_ZERO_PAGE
             setN(reg.d & 128);
@@ -1104,7 +1133,7 @@ CPU<M>::executeOneCycle()
             POLL_INT
             DONE
 
-        case BIT_abs_3:
+        CASE(BIT_abs_3)
             
             READ_FROM_ADDRESS
             setN(reg.d & 128);
@@ -1121,7 +1150,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
 
-        case BMI_rel:
+        CASE(BMI_rel)
             
             READ_IMMEDIATE
             POLL_INT
@@ -1140,7 +1169,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
             
-        case BNE_rel:
+        CASE(BNE_rel)
             
             READ_IMMEDIATE
             POLL_INT
@@ -1159,7 +1188,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
 
-        case BPL_rel:
+        CASE(BPL_rel)
             
             READ_IMMEDIATE
             POLL_INT
@@ -1178,13 +1207,13 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V    B
         //              - - - 1 - -    1
             
-        case BRK_2:
+        CASE(BRK_2)
             
             setB(1);
             PUSH_PCH
             CONTINUE
             
-        case BRK_3:
+        CASE(BRK_3)
         
             PUSH_PCL
             
@@ -1201,19 +1230,19 @@ CPU<M>::executeOneCycle()
                 CONTINUE
             }
             
-        case BRK_4:
+        CASE(BRK_4)
             
             PUSH_P
             CONTINUE
             
-        case BRK_5:
+        CASE(BRK_5)
             
             READ_FROM(0xFFFE);
             setPCL(reg.d);
             setI(1);
             CONTINUE
             
-        case BRK_6:
+        CASE(BRK_6)
             
             READ_FROM(0xFFFF);
             setPCH(reg.d);
@@ -1223,19 +1252,19 @@ CPU<M>::executeOneCycle()
                            // after a BRK command, but not NMIs.
             DONE
             
-        case BRK_nmi_4:
+        CASE(BRK_nmi_4)
             
             PUSH_P
             CONTINUE
             
-        case BRK_nmi_5:
+        CASE(BRK_nmi_5)
             
             READ_FROM(0xFFFA);
             setPCL(reg.d);
             setI(1);
             CONTINUE
             
-        case BRK_nmi_6:
+        CASE(BRK_nmi_6)
             
             READ_FROM(0xFFFB);
             setPCH(reg.d);
@@ -1250,7 +1279,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
 
-        case BVC_rel:
+        CASE(BVC_rel)
             
             READ_IMMEDIATE
             POLL_INT
@@ -1269,7 +1298,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
 
-        case BVS_rel:
+        CASE(BVS_rel)
             
             READ_IMMEDIATE
             POLL_INT
@@ -1288,7 +1317,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - 0 - - -
 
-        case CLC:
+        CASE(CLC)
             
             IDLE_READ_IMPLIED
             setC(0);
@@ -1303,7 +1332,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - 0 -
 
-        case CLD:
+        CASE(CLD)
             
             IDLE_READ_IMPLIED
             setD(0);
@@ -1318,7 +1347,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - 0 - -
 
-        case CLI:
+        CASE(CLI)
             
             POLL_INT
             setI(0);
@@ -1333,7 +1362,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - 0
 
-        case CLV:
+        CASE(CLV)
             
             IDLE_READ_IMPLIED
             setV(0);
@@ -1348,24 +1377,24 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / / - - -
 
-        case CMP_imm:
+        CASE(CMP_imm)
             
             READ_IMMEDIATE
             cmp(reg.a, reg.d);
             POLL_INT
             DONE
 
-        case CMP_zpg_2:
-        case CMP_zpg_x_3:
+        CASE(CMP_zpg_2)
+        CASE(CMP_zpg_x_3)
             
             READ_FROM_ZERO_PAGE
             cmp(reg.a, reg.d);
             POLL_INT
             DONE
 
-        case CMP_abs_x_3:
-        case CMP_abs_y_3:
-        case CMP_ind_y_4:
+        CASE(CMP_abs_x_3)
+        CASE(CMP_abs_y_3)
+        CASE(CMP_ind_y_4)
             
             READ_FROM_ADDRESS
             if (PAGE_BOUNDARY_CROSSED) {
@@ -1377,11 +1406,11 @@ CPU<M>::executeOneCycle()
                 DONE
             }
             
-        case CMP_abs_3:
-        case CMP_abs_x_4:
-        case CMP_abs_y_4:
-        case CMP_ind_x_5:
-        case CMP_ind_y_5:
+        CASE(CMP_abs_3)
+        CASE(CMP_abs_x_4)
+        CASE(CMP_abs_y_4)
+        CASE(CMP_ind_x_5)
+        CASE(CMP_ind_y_5)
             
             READ_FROM_ADDRESS
             cmp(reg.a, reg.d);
@@ -1396,21 +1425,21 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / / - - -
 
-        case CPX_imm:
+        CASE(CPX_imm)
             
             READ_IMMEDIATE
             cmp(reg.x, reg.d);
             POLL_INT
             DONE
             
-        case CPX_zpg_2:
+        CASE(CPX_zpg_2)
             
             READ_FROM_ZERO_PAGE
             cmp(reg.x, reg.d);
             POLL_INT
             DONE
             
-        case CPX_abs_3:
+        CASE(CPX_abs_3)
             
             READ_FROM_ADDRESS
             cmp(reg.x, reg.d);
@@ -1425,21 +1454,21 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / / - - -
 
-        case CPY_imm:
+        CASE(CPY_imm)
             
             READ_IMMEDIATE
             cmp(reg.y, reg.d);
             POLL_INT
             DONE
 
-        case CPY_zpg_2:
+        CASE(CPY_zpg_2)
             
             READ_FROM_ZERO_PAGE
             cmp(reg.y, reg.d);
             POLL_INT
             DONE
 
-        case CPY_abs_3:
+        CASE(CPY_abs_3)
             
             READ_FROM_ADDRESS
             cmp(reg.y, reg.d);
@@ -1456,31 +1485,31 @@ CPU<M>::executeOneCycle()
             
         #define DO_DEC reg.d--;
             
-        case DEC_zpg_3:
-        case DEC_zpg_x_4:
+        CASE(DEC_zpg_3)
+        CASE(DEC_zpg_x_4)
             
             WRITE_TO_ZERO_PAGE
             DO_DEC
             CONTINUE
             
-        case DEC_zpg_4:
-        case DEC_zpg_x_5:
+        CASE(DEC_zpg_4)
+        CASE(DEC_zpg_x_5)
             
             WRITE_TO_ZERO_PAGE_AND_SET_FLAGS
             POLL_INT
             DONE
             
-        case DEC_abs_4:
-        case DEC_abs_x_5:
-        case DEC_ind_x_6:
+        CASE(DEC_abs_4)
+        CASE(DEC_abs_x_5)
+        CASE(DEC_ind_x_6)
             
             WRITE_TO_ADDRESS
             DO_DEC
             CONTINUE
             
-        case DEC_abs_5:
-        case DEC_abs_x_6:
-        case DEC_ind_x_7:
+        CASE(DEC_abs_5)
+        CASE(DEC_abs_x_6)
+        CASE(DEC_ind_x_7)
             
             WRITE_TO_ADDRESS_AND_SET_FLAGS
             POLL_INT
@@ -1494,7 +1523,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
 
-        case DEX:
+        CASE(DEX)
             
             IDLE_READ_IMPLIED
             loadX(reg.x - 1);
@@ -1509,7 +1538,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
 
-        case DEY:
+        CASE(DEY)
             
             IDLE_READ_IMPLIED
             loadY(reg.y - 1);
@@ -1526,24 +1555,24 @@ CPU<M>::executeOneCycle()
 
         #define DO_EOR loadA(reg.a ^ reg.d);
             
-        case EOR_imm:
+        CASE(EOR_imm)
             
             READ_IMMEDIATE
             DO_EOR
             POLL_INT
             DONE
             
-        case EOR_zpg_2:
-        case EOR_zpg_x_3:
+        CASE(EOR_zpg_2)
+        CASE(EOR_zpg_x_3)
             
             READ_FROM_ZERO_PAGE
             DO_EOR
             POLL_INT
             DONE
             
-        case EOR_abs_x_3:
-        case EOR_abs_y_3:
-        case EOR_ind_y_4:
+        CASE(EOR_abs_x_3)
+        CASE(EOR_abs_y_3)
+        CASE(EOR_ind_y_4)
             
             READ_FROM_ADDRESS
             if (PAGE_BOUNDARY_CROSSED) {
@@ -1555,11 +1584,11 @@ CPU<M>::executeOneCycle()
                 DONE
             }
 
-        case EOR_abs_3:
-        case EOR_abs_x_4:
-        case EOR_abs_y_4:
-        case EOR_ind_x_5:
-        case EOR_ind_y_5:
+        CASE(EOR_abs_3)
+        CASE(EOR_abs_x_4)
+        CASE(EOR_abs_y_4)
+        CASE(EOR_ind_x_5)
+        CASE(EOR_ind_y_5)
             
             READ_FROM_ADDRESS
             DO_EOR
@@ -1576,31 +1605,31 @@ CPU<M>::executeOneCycle()
             
         #define DO_INC reg.d++;
             
-        case INC_zpg_3:
-        case INC_zpg_x_4:
+        CASE(INC_zpg_3)
+        CASE(INC_zpg_x_4)
             
             WRITE_TO_ZERO_PAGE
             DO_INC
             CONTINUE
             
-        case INC_zpg_4:
-        case INC_zpg_x_5:
+        CASE(INC_zpg_4)
+        CASE(INC_zpg_x_5)
             
             WRITE_TO_ZERO_PAGE_AND_SET_FLAGS
             POLL_INT
             DONE
           
-        case INC_abs_4:
-        case INC_abs_x_5:
-        case INC_ind_x_6:
+        CASE(INC_abs_4)
+        CASE(INC_abs_x_5)
+        CASE(INC_ind_x_6)
             
             WRITE_TO_ADDRESS
             DO_INC
             CONTINUE
             
-        case INC_abs_5:
-        case INC_abs_x_6:
-        case INC_ind_x_7:
+        CASE(INC_abs_5)
+        CASE(INC_abs_x_6)
+        CASE(INC_ind_x_7)
             
             WRITE_TO_ADDRESS_AND_SET_FLAGS
             POLL_INT
@@ -1614,7 +1643,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
 
-        case INX:
+        CASE(INX)
             
             IDLE_READ_IMPLIED
             loadX(reg.x + 1);
@@ -1629,7 +1658,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
 
-        case INY:
+        CASE(INY)
             
             IDLE_READ_IMPLIED
             loadY(reg.y + 1);
@@ -1644,36 +1673,36 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
           
-        case JMP_abs:
+        CASE(JMP_abs)
             
             FETCH_ADDR_LO
             CONTINUE
             
-        case JMP_abs_2:
+        CASE(JMP_abs_2)
             
             FETCH_ADDR_HI
             reg.pc = LO_HI(reg.adl, reg.adh);
             POLL_INT
             DONE
 
-        case JMP_abs_ind:
+        CASE(JMP_abs_ind)
             
             FETCH_ADDR_LO
             CONTINUE
             
-        case JMP_abs_ind_2:
+        CASE(JMP_abs_ind_2)
             
             FETCH_ADDR_HI
             CONTINUE
             
-        case JMP_abs_ind_3:
+        CASE(JMP_abs_ind_3)
             
             READ_FROM_ADDRESS
             setPCL(reg.d);
             reg.adl++;
             CONTINUE
             
-        case JMP_abs_ind_4:
+        CASE(JMP_abs_ind_4)
             
             READ_FROM_ADDRESS
             setPCH(reg.d);
@@ -1688,27 +1717,27 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
             
-        case JSR:
+        CASE(JSR)
             
             FETCH_ADDR_LO
             CONTINUE
             
-        case JSR_2:
+        CASE(JSR_2)
             
             IDLE_PULL
             CONTINUE
             
-        case JSR_3:
+        CASE(JSR_3)
             
             PUSH_PCH
             CONTINUE
             
-        case JSR_4:
+        CASE(JSR_4)
             
             PUSH_PCL
             CONTINUE
             
-        case JSR_5:
+        CASE(JSR_5)
             
             FETCH_ADDR_HI
             reg.pc = LO_HI(reg.adl, reg.adh);
@@ -1723,24 +1752,24 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
 
-        case LDA_imm:
+        CASE(LDA_imm)
             
             READ_IMMEDIATE
             loadA(reg.d);
             POLL_INT
             DONE
 
-        case LDA_zpg_2:
-        case LDA_zpg_x_3:
+        CASE(LDA_zpg_2)
+        CASE(LDA_zpg_x_3)
             
             READ_FROM_ZERO_PAGE
             loadA(reg.d);
             POLL_INT
             DONE
           
-        case LDA_abs_x_3:
-        case LDA_abs_y_3:
-        case LDA_ind_y_4:
+        CASE(LDA_abs_x_3)
+        CASE(LDA_abs_y_3)
+        CASE(LDA_ind_y_4)
             
             READ_FROM_ADDRESS
             if (PAGE_BOUNDARY_CROSSED) {
@@ -1752,11 +1781,11 @@ CPU<M>::executeOneCycle()
                 DONE
             }
             
-        case LDA_abs_3:
-        case LDA_abs_x_4:
-        case LDA_abs_y_4:
-        case LDA_ind_x_5:
-        case LDA_ind_y_5:
+        CASE(LDA_abs_3)
+        CASE(LDA_abs_x_4)
+        CASE(LDA_abs_y_4)
+        CASE(LDA_ind_x_5)
+        CASE(LDA_ind_y_5)
             
             READ_FROM_ADDRESS
             loadA(reg.d);
@@ -1771,23 +1800,23 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
 
-        case LDX_imm:
+        CASE(LDX_imm)
             
             READ_IMMEDIATE
             loadX(reg.d);
             POLL_INT
             DONE
 
-        case LDX_zpg_2:
-        case LDX_zpg_y_3:
+        CASE(LDX_zpg_2)
+        CASE(LDX_zpg_y_3)
             
             READ_FROM_ZERO_PAGE
             loadX(reg.d);
             POLL_INT
             DONE
 
-        case LDX_abs_y_3:
-        case LDX_ind_y_4:
+        CASE(LDX_abs_y_3)
+        CASE(LDX_ind_y_4)
             
             READ_FROM_ADDRESS
             if (PAGE_BOUNDARY_CROSSED) {
@@ -1799,10 +1828,10 @@ CPU<M>::executeOneCycle()
                 DONE
             }
             
-        case LDX_abs_3:
-        case LDX_abs_y_4:
-        case LDX_ind_x_5:
-        case LDX_ind_y_5:
+        CASE(LDX_abs_3)
+        CASE(LDX_abs_y_4)
+        CASE(LDX_ind_x_5)
+        CASE(LDX_ind_y_5)
             
             READ_FROM_ADDRESS
             loadX(reg.d);
@@ -1817,23 +1846,23 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
  
-        case LDY_imm:
+        CASE(LDY_imm)
             
             READ_IMMEDIATE
             loadY(reg.d);
             POLL_INT
             DONE
             
-        case LDY_zpg_2:
-        case LDY_zpg_x_3:
+        CASE(LDY_zpg_2)
+        CASE(LDY_zpg_x_3)
             
             READ_FROM_ZERO_PAGE
             loadY(reg.d);
             POLL_INT
             DONE
 
-        case LDY_abs_x_3:
-        case LDY_ind_y_4:
+        CASE(LDY_abs_x_3)
+        CASE(LDY_ind_y_4)
             
             READ_FROM_ADDRESS
             if (PAGE_BOUNDARY_CROSSED) {
@@ -1845,10 +1874,10 @@ CPU<M>::executeOneCycle()
                 DONE
             }
 
-        case LDY_abs_3:
-        case LDY_abs_x_4:
-        case LDY_ind_x_5:
-        case LDY_ind_y_5:
+        CASE(LDY_abs_3)
+        CASE(LDY_abs_x_4)
+        CASE(LDY_ind_x_5)
+        CASE(LDY_ind_y_5)
             
             READ_FROM_ADDRESS
             loadY(reg.d);
@@ -1863,42 +1892,42 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              0 / / - - -
 
-        case LSR_acc:
+        CASE(LSR_acc)
             
             IDLE_READ_IMPLIED
             setC(reg.a & 1); loadA(reg.a >> 1);
             POLL_INT
             DONE
 
-        case LSR_zpg_3:
-        case LSR_zpg_x_4:
+        CASE(LSR_zpg_3)
+        CASE(LSR_zpg_x_4)
             
             WRITE_TO_ZERO_PAGE
             setC(reg.d & 1); reg.d = reg.d >> 1;
             CONTINUE
             
-        case LSR_zpg_4:
-        case LSR_zpg_x_5:
+        CASE(LSR_zpg_4)
+        CASE(LSR_zpg_x_5)
             
             WRITE_TO_ZERO_PAGE_AND_SET_FLAGS
             POLL_INT
             DONE
             
-        case LSR_abs_4:
-        case LSR_abs_x_5:
-        case LSR_abs_y_5:
-        case LSR_ind_x_6:
-        case LSR_ind_y_6:
+        CASE(LSR_abs_4)
+        CASE(LSR_abs_x_5)
+        CASE(LSR_abs_y_5)
+        CASE(LSR_ind_x_6)
+        CASE(LSR_ind_y_6)
             
             WRITE_TO_ADDRESS
             setC(reg.d & 1); reg.d = reg.d >> 1;
             CONTINUE
             
-        case LSR_abs_5:
-        case LSR_abs_x_6:
-        case LSR_abs_y_6:
-        case LSR_ind_x_7:
-        case LSR_ind_y_7:
+        CASE(LSR_abs_5)
+        CASE(LSR_abs_x_6)
+        CASE(LSR_abs_y_6)
+        CASE(LSR_ind_x_7)
+        CASE(LSR_ind_y_7)
             
             WRITE_TO_ADDRESS_AND_SET_FLAGS
             POLL_INT
@@ -1912,26 +1941,26 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
 
-        case NOP:
+        CASE(NOP)
             
             IDLE_READ_IMPLIED
             POLL_INT
             DONE
 
-        case NOP_imm:
+        CASE(NOP_imm)
             
             IDLE_READ_IMMEDIATE
             POLL_INT
             DONE
 
-        case NOP_zpg_2:
-        case NOP_zpg_x_3:
+        CASE(NOP_zpg_2)
+        CASE(NOP_zpg_x_3)
             
             IDLE_READ_FROM_ZERO_PAGE
             POLL_INT
             DONE
             
-        case NOP_abs_x_3:
+        CASE(NOP_abs_x_3)
             
             IDLE_READ_FROM_ADDRESS
             if (PAGE_BOUNDARY_CROSSED) {
@@ -1942,8 +1971,8 @@ CPU<M>::executeOneCycle()
                 DONE
             }
             
-        case NOP_abs_3:
-        case NOP_abs_x_4:
+        CASE(NOP_abs_3)
+        CASE(NOP_abs_x_4)
             
             IDLE_READ_FROM_ADDRESS
             POLL_INT
@@ -1957,24 +1986,24 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
 
-        case ORA_imm:
+        CASE(ORA_imm)
             
             READ_IMMEDIATE
             loadA(reg.a | reg.d);
             POLL_INT
             DONE
             
-        case ORA_zpg_2:
-        case ORA_zpg_x_3:
+        CASE(ORA_zpg_2)
+        CASE(ORA_zpg_x_3)
             
             READ_FROM_ZERO_PAGE
             loadA(reg.a | reg.d);
             POLL_INT
             DONE
 
-        case ORA_abs_x_3:
-        case ORA_abs_y_3:
-        case ORA_ind_y_4:
+        CASE(ORA_abs_x_3)
+        CASE(ORA_abs_y_3)
+        CASE(ORA_ind_y_4)
             
             READ_FROM_ADDRESS
             if (PAGE_BOUNDARY_CROSSED) {
@@ -1986,11 +2015,11 @@ CPU<M>::executeOneCycle()
                 DONE
             }
             
-        case ORA_abs_3:
-        case ORA_abs_x_4:
-        case ORA_abs_y_4:
-        case ORA_ind_x_5:
-        case ORA_ind_y_5:
+        CASE(ORA_abs_3)
+        CASE(ORA_abs_x_4)
+        CASE(ORA_abs_y_4)
+        CASE(ORA_ind_x_5)
+        CASE(ORA_ind_y_5)
             
             READ_FROM_ADDRESS
             loadA(reg.a | reg.d);
@@ -2005,7 +2034,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
             
-        case PHA_2:
+        CASE(PHA_2)
             
             PUSH_A
             POLL_INT
@@ -2019,7 +2048,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
             
-        case PHP_2:
+        CASE(PHP_2)
             
             PUSH_P
             POLL_INT
@@ -2033,12 +2062,12 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
             
-        case PLA_2:
+        CASE(PLA_2)
             
             reg.sp++;
             CONTINUE
             
-        case PLA_3:
+        CASE(PLA_3)
             
             PULL_A
             POLL_INT
@@ -2052,13 +2081,13 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / / / / /
             
-        case PLP_2:
+        CASE(PLP_2)
 
             IDLE_PULL
             reg.sp++;
             CONTINUE
             
-        case PLP_3:
+        CASE(PLP_3)
 
             POLL_INT // Interrupts are polled before P is pulled
             PULL_P
@@ -2077,38 +2106,38 @@ CPU<M>::executeOneCycle()
         #define DO_ROL_ACC { int c = !!getC(); setC(reg.a & 0x80); loadA((reg.a << 1) | c); }
         #define DO_ROL { int c = !!getC(); setC(reg.d & 0x80); reg.d = (reg.d << 1) | c; }
 
-        case ROL_acc:
+        CASE(ROL_acc)
             
             IDLE_READ_IMPLIED
             DO_ROL_ACC
             POLL_INT
             DONE
             
-        case ROL_zpg_3:
-        case ROL_zpg_x_4:
+        CASE(ROL_zpg_3)
+        CASE(ROL_zpg_x_4)
             
             WRITE_TO_ZERO_PAGE
             DO_ROL
             CONTINUE
             
-        case ROL_zpg_4:
-        case ROL_zpg_x_5:
+        CASE(ROL_zpg_4)
+        CASE(ROL_zpg_x_5)
             
             WRITE_TO_ZERO_PAGE_AND_SET_FLAGS
             POLL_INT
             DONE
             
-        case ROL_abs_4:
-        case ROL_abs_x_5:
-        case ROL_ind_x_6:
+        CASE(ROL_abs_4)
+        CASE(ROL_abs_x_5)
+        CASE(ROL_ind_x_6)
             
             WRITE_TO_ADDRESS
             DO_ROL
             CONTINUE
             
-        case ROL_abs_5:
-        case ROL_abs_x_6:
-        case ROL_ind_x_7:
+        CASE(ROL_abs_5)
+        CASE(ROL_abs_x_6)
+        CASE(ROL_ind_x_7)
             
             WRITE_TO_ADDRESS_AND_SET_FLAGS
             POLL_INT
@@ -2127,38 +2156,38 @@ CPU<M>::executeOneCycle()
         #define DO_ROR_ACC { int c = !!getC(); setC(reg.a & 0x1); loadA((reg.a >> 1) | (c << 7)); }
         #define DO_ROR { int c = !!getC(); setC(reg.d & 0x1); reg.d = (reg.d >> 1) | (c << 7); }
             
-        case ROR_acc:
+        CASE(ROR_acc)
             
             IDLE_READ_IMPLIED
             DO_ROR_ACC
             POLL_INT
             DONE
             
-        case ROR_zpg_3:
-        case ROR_zpg_x_4:
+        CASE(ROR_zpg_3)
+        CASE(ROR_zpg_x_4)
             
             WRITE_TO_ZERO_PAGE
             DO_ROR
             CONTINUE
             
-        case ROR_zpg_4:
-        case ROR_zpg_x_5:
+        CASE(ROR_zpg_4)
+        CASE(ROR_zpg_x_5)
             
             WRITE_TO_ZERO_PAGE_AND_SET_FLAGS
             POLL_INT
             DONE
             
-        case ROR_abs_4:
-        case ROR_abs_x_5:
-        case ROR_ind_x_6:
+        CASE(ROR_abs_4)
+        CASE(ROR_abs_x_5)
+        CASE(ROR_ind_x_6)
             
             WRITE_TO_ADDRESS
             DO_ROR
             CONTINUE
             
-        case ROR_abs_5:
-        case ROR_abs_x_6:
-        case ROR_ind_x_7:
+        CASE(ROR_abs_5)
+        CASE(ROR_abs_x_6)
+        CASE(ROR_ind_x_7)
             
             WRITE_TO_ADDRESS_AND_SET_FLAGS
             POLL_INT
@@ -2172,25 +2201,25 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / / / / /
             
-        case RTI_2:
+        CASE(RTI_2)
             
             IDLE_PULL
             reg.sp++;
             CONTINUE
             
-        case RTI_3:
+        CASE(RTI_3)
             
             PULL_P
             reg.sp++;
             CONTINUE
             
-        case RTI_4:
+        CASE(RTI_4)
             
             PULL_PCL
             reg.sp++;
             CONTINUE
             
-        case RTI_5:
+        CASE(RTI_5)
             
             PULL_PCH
             POLL_INT
@@ -2204,24 +2233,24 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
             
-        case RTS_2:
+        CASE(RTS_2)
             
             IDLE_PULL
             reg.sp++;
             CONTINUE
             
-        case RTS_3:
+        CASE(RTS_3)
             
             PULL_PCL
             reg.sp++;
             CONTINUE
             
-        case RTS_4:
+        CASE(RTS_4)
             
             PULL_PCH
             CONTINUE
             
-        case RTS_5:
+        CASE(RTS_5)
             
             IDLE_READ_IMMEDIATE
             POLL_INT
@@ -2235,24 +2264,24 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / / - - /
   
-        case SBC_imm:
+        CASE(SBC_imm)
             
             READ_IMMEDIATE
             sbc(reg.d);
             POLL_INT
             DONE
             
-        case SBC_zpg_2:
-        case SBC_zpg_x_3:
+        CASE(SBC_zpg_2)
+        CASE(SBC_zpg_x_3)
             
             READ_FROM_ZERO_PAGE
             sbc(reg.d);
             POLL_INT
             DONE
             
-        case SBC_abs_x_3:
-        case SBC_abs_y_3:
-        case SBC_ind_y_4:
+        CASE(SBC_abs_x_3)
+        CASE(SBC_abs_y_3)
+        CASE(SBC_ind_y_4)
             
             READ_FROM_ADDRESS
             if (PAGE_BOUNDARY_CROSSED) {
@@ -2264,11 +2293,11 @@ CPU<M>::executeOneCycle()
                 DONE
             }
             
-        case SBC_abs_3:
-        case SBC_abs_x_4:
-        case SBC_abs_y_4:
-        case SBC_ind_x_5:
-        case SBC_ind_y_5:
+        CASE(SBC_abs_3)
+        CASE(SBC_abs_x_4)
+        CASE(SBC_abs_y_4)
+        CASE(SBC_ind_x_5)
+        CASE(SBC_ind_y_5)
             
             READ_FROM_ADDRESS
             sbc(reg.d);
@@ -2283,7 +2312,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - 1 - - -
 
-        case SEC:
+        CASE(SEC)
             
             IDLE_READ_IMPLIED
             setC(1);
@@ -2298,7 +2327,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - 1 -
 
-        case SED:
+        CASE(SED)
             
             IDLE_READ_IMPLIED
             setD(1);
@@ -2313,13 +2342,13 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - 1 - -
 
-        case SEI:
+        CASE(SEI)
             
             POLL_IRQ
             setI(1);
-            [[fallthrough]];
+            FALLTHROUGH
             
-        case SEI_cont:
+        CASE(SEI_cont)
             
             next = SEI_cont;
             IDLE_READ_IMPLIED
@@ -2334,25 +2363,25 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
             
-        case STA_zpg_2:
-        case STA_zpg_x_3:
+        CASE(STA_zpg_2)
+        CASE(STA_zpg_x_3)
             
             reg.d = reg.a;
             WRITE_TO_ZERO_PAGE
             POLL_INT
             DONE
             
-        case STA_abs_3:
-        case STA_abs_x_4:
+        CASE(STA_abs_3)
+        CASE(STA_abs_x_4)
             
             reg.d = reg.a;
             WRITE_TO_ADDRESS
             POLL_INT
             DONE
             
-        case STA_abs_y_4:
-        case STA_ind_x_5:
-        case STA_ind_y_5:
+        CASE(STA_abs_y_4)
+        CASE(STA_ind_x_5)
+        CASE(STA_ind_y_5)
             
             reg.d = reg.a;
             WRITE_TO_ADDRESS
@@ -2367,15 +2396,15 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
             
-        case STX_zpg_2:
-        case STX_zpg_y_3:
+        CASE(STX_zpg_2)
+        CASE(STX_zpg_y_3)
             
             reg.d = reg.x;
             WRITE_TO_ZERO_PAGE
             POLL_INT
             DONE
             
-        case STX_abs_3:
+        CASE(STX_abs_3)
             
             reg.d = reg.x;
             WRITE_TO_ADDRESS
@@ -2390,15 +2419,15 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
             
-        case STY_zpg_2:
-        case STY_zpg_x_3:
+        CASE(STY_zpg_2)
+        CASE(STY_zpg_x_3)
             
             reg.d = reg.y;
             WRITE_TO_ZERO_PAGE
             POLL_INT
             DONE
             
-        case STY_abs_3:
+        CASE(STY_abs_3)
             
             reg.d = reg.y;
             WRITE_TO_ADDRESS
@@ -2413,7 +2442,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
 
-        case TAX:
+        CASE(TAX)
             
             IDLE_READ_IMPLIED
             loadX(reg.a);
@@ -2428,7 +2457,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
 
-        case TAY:
+        CASE(TAY)
             
             IDLE_READ_IMPLIED
             loadY(reg.a);
@@ -2443,7 +2472,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
 
-        case TSX:
+        CASE(TSX)
             
             IDLE_READ_IMPLIED
             loadX(reg.sp);
@@ -2458,7 +2487,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
 
-        case TXA:
+        CASE(TXA)
             
             IDLE_READ_IMPLIED
             loadA(reg.x);
@@ -2473,7 +2502,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
 
-        case TXS:
+        CASE(TXS)
             
             IDLE_READ_IMPLIED
             reg.sp = reg.x;
@@ -2488,7 +2517,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
 
-        case TYA:
+        CASE(TYA)
             
             IDLE_READ_IMPLIED
             loadA(reg.y);
@@ -2508,7 +2537,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / / - - -
 
-        case ALR_imm:
+        CASE(ALR_imm)
             
             READ_IMMEDIATE
             reg.a = reg.a & reg.d;
@@ -2525,7 +2554,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / / - - -
 
-        case ANC_imm:
+        CASE(ANC_imm)
             
             READ_IMMEDIATE
             loadA(reg.a & reg.d);
@@ -2541,7 +2570,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / / - - /
 
-        case ARR_imm:
+        CASE(ARR_imm)
         {
             READ_IMMEDIATE
             
@@ -2582,7 +2611,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / / - - -
 
-        case AXS_imm:
+        CASE(AXS_imm)
         {
             READ_IMMEDIATE
             
@@ -2603,36 +2632,36 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / / - - -
             
-        case DCP_zpg_3:
-        case DCP_zpg_x_4:
+        CASE(DCP_zpg_3)
+        CASE(DCP_zpg_x_4)
             
             WRITE_TO_ZERO_PAGE
             reg.d--;
             CONTINUE
             
-        case DCP_zpg_4:
-        case DCP_zpg_x_5:
+        CASE(DCP_zpg_4)
+        CASE(DCP_zpg_x_5)
             
             WRITE_TO_ZERO_PAGE_AND_SET_FLAGS
             cmp(reg.a, reg.d);
             POLL_INT
             DONE
             
-        case DCP_abs_4:
-        case DCP_abs_x_5:
-        case DCP_abs_y_5:
-        case DCP_ind_x_6:
-        case DCP_ind_y_6:
+        CASE(DCP_abs_4)
+        CASE(DCP_abs_x_5)
+        CASE(DCP_abs_y_5)
+        CASE(DCP_ind_x_6)
+        CASE(DCP_ind_y_6)
             
             WRITE_TO_ADDRESS
             reg.d--;
             CONTINUE
             
-        case DCP_abs_5:
-        case DCP_abs_x_6:
-        case DCP_abs_y_6:
-        case DCP_ind_x_7:
-        case DCP_ind_y_7:
+        CASE(DCP_abs_5)
+        CASE(DCP_abs_x_6)
+        CASE(DCP_abs_y_6)
+        CASE(DCP_ind_x_7)
+        CASE(DCP_ind_y_7)
             
             WRITE_TO_ADDRESS_AND_SET_FLAGS
             cmp(reg.a, reg.d);
@@ -2647,36 +2676,36 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / / - - /
             
-        case ISC_zpg_3:
-        case ISC_zpg_x_4:
+        CASE(ISC_zpg_3)
+        CASE(ISC_zpg_x_4)
             
             WRITE_TO_ZERO_PAGE
             reg.d++;
             CONTINUE
             
-        case ISC_zpg_4:
-        case ISC_zpg_x_5:
+        CASE(ISC_zpg_4)
+        CASE(ISC_zpg_x_5)
             
             WRITE_TO_ZERO_PAGE_AND_SET_FLAGS
             sbc(reg.d);
             POLL_INT
             DONE
 
-        case ISC_abs_4:
-        case ISC_abs_x_5:
-        case ISC_abs_y_5:
-        case ISC_ind_x_6:
-        case ISC_ind_y_6:
+        CASE(ISC_abs_4)
+        CASE(ISC_abs_x_5)
+        CASE(ISC_abs_y_5)
+        CASE(ISC_ind_x_6)
+        CASE(ISC_ind_y_6)
             
             WRITE_TO_ADDRESS
             reg.d++;
             CONTINUE
             
-        case ISC_abs_5:
-        case ISC_abs_x_6:
-        case ISC_abs_y_6:
-        case ISC_ind_x_7:
-        case ISC_ind_y_7:
+        CASE(ISC_abs_5)
+        CASE(ISC_abs_x_6)
+        CASE(ISC_abs_y_6)
+        CASE(ISC_ind_x_7)
+        CASE(ISC_ind_y_7)
             
             WRITE_TO_ADDRESS_AND_SET_FLAGS
             sbc(reg.d);
@@ -2691,7 +2720,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
             
-        case LAS_abs_y_3:
+        CASE(LAS_abs_y_3)
             
             READ_FROM_ADDRESS
             if (PAGE_BOUNDARY_CROSSED) {
@@ -2706,7 +2735,7 @@ CPU<M>::executeOneCycle()
                 DONE
             }
             
-        case LAS_abs_y_4:
+        CASE(LAS_abs_y_4)
             
             READ_FROM_ADDRESS
             reg.d &= reg.sp;
@@ -2724,8 +2753,8 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
             
-        case LAX_zpg_2:
-        case LAX_zpg_y_3:
+        CASE(LAX_zpg_2)
+        CASE(LAX_zpg_y_3)
             
             READ_FROM_ZERO_PAGE
             loadA(reg.d);
@@ -2733,8 +2762,8 @@ CPU<M>::executeOneCycle()
             POLL_INT
             DONE
             
-        case LAX_abs_y_3:
-        case LAX_ind_y_4:
+        CASE(LAX_abs_y_3)
+        CASE(LAX_ind_y_4)
             
             READ_FROM_ADDRESS
             if (PAGE_BOUNDARY_CROSSED) {
@@ -2747,10 +2776,10 @@ CPU<M>::executeOneCycle()
                 DONE
             }
             
-        case LAX_abs_3:
-        case LAX_abs_y_4:
-        case LAX_ind_x_5:
-        case LAX_ind_y_5:
+        CASE(LAX_abs_3)
+        CASE(LAX_abs_y_4)
+        CASE(LAX_ind_x_5)
+        CASE(LAX_ind_y_5)
             
             READ_FROM_ADDRESS;
             loadA(reg.d);
@@ -2766,36 +2795,36 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / / - - -
             
-        case RLA_zpg_3:
-        case RLA_zpg_x_4:
+        CASE(RLA_zpg_3)
+        CASE(RLA_zpg_x_4)
             
             WRITE_TO_ZERO_PAGE
             DO_ROL
             CONTINUE
             
-        case RLA_zpg_4:
-        case RLA_zpg_x_5:
+        CASE(RLA_zpg_4)
+        CASE(RLA_zpg_x_5)
             
             WRITE_TO_ZERO_PAGE
             loadA(reg.a & reg.d);
             POLL_INT
             DONE
             
-        case RLA_abs_4:
-        case RLA_abs_x_5:
-        case RLA_abs_y_5:
-        case RLA_ind_x_6:
-        case RLA_ind_y_6:
+        CASE(RLA_abs_4)
+        CASE(RLA_abs_x_5)
+        CASE(RLA_abs_y_5)
+        CASE(RLA_ind_x_6)
+        CASE(RLA_ind_y_6)
             
             WRITE_TO_ADDRESS
             DO_ROL
             CONTINUE
             
-        case RLA_abs_5:
-        case RLA_abs_x_6:
-        case RLA_abs_y_6:
-        case RLA_ind_x_7:
-        case RLA_ind_y_7:
+        CASE(RLA_abs_5)
+        CASE(RLA_abs_x_6)
+        CASE(RLA_abs_y_6)
+        CASE(RLA_ind_x_7)
+        CASE(RLA_ind_y_7)
             
             WRITE_TO_ADDRESS
             loadA(reg.a & reg.d);
@@ -2809,36 +2838,36 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / / - - /
             
-        case RRA_zpg_3:
-        case RRA_zpg_x_4:
+        CASE(RRA_zpg_3)
+        CASE(RRA_zpg_x_4)
             
             WRITE_TO_ZERO_PAGE
             DO_ROR
             CONTINUE
             
-        case RRA_zpg_4:
-        case RRA_zpg_x_5:
+        CASE(RRA_zpg_4)
+        CASE(RRA_zpg_x_5)
             
             WRITE_TO_ZERO_PAGE
             adc(reg.d);
             POLL_INT
             DONE
 
-        case RRA_abs_4:
-        case RRA_abs_x_5:
-        case RRA_abs_y_5:
-        case RRA_ind_x_6:
-        case RRA_ind_y_6:
+        CASE(RRA_abs_4)
+        CASE(RRA_abs_x_5)
+        CASE(RRA_abs_y_5)
+        CASE(RRA_ind_x_6)
+        CASE(RRA_ind_y_6)
             
             WRITE_TO_ADDRESS
             DO_ROR
             CONTINUE
             
-        case RRA_abs_5:
-        case RRA_abs_x_6:
-        case RRA_abs_y_6:
-        case RRA_ind_x_7:
-        case RRA_ind_y_7:
+        CASE(RRA_abs_5)
+        CASE(RRA_abs_x_6)
+        CASE(RRA_abs_y_6)
+        CASE(RRA_ind_x_7)
+        CASE(RRA_ind_y_7)
             
             WRITE_TO_ADDRESS
             adc(reg.d);
@@ -2853,16 +2882,16 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
             
-        case SAX_zpg_2:
-        case SAX_zpg_y_3:
+        CASE(SAX_zpg_2)
+        CASE(SAX_zpg_y_3)
             
             reg.d = reg.a & reg.x;
             WRITE_TO_ZERO_PAGE
             POLL_INT
             DONE
 
-        case SAX_abs_3:
-        case SAX_ind_x_5:
+        CASE(SAX_abs_3)
+        CASE(SAX_ind_x_5)
             
             reg.d = reg.a & reg.x;
             WRITE_TO_ADDRESS
@@ -2877,7 +2906,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
             
-        case SHA_abs_y_3:
+        CASE(SHA_abs_y_3)
             
             IDLE_READ_FROM_ADDRESS
             
@@ -2900,13 +2929,13 @@ CPU<M>::executeOneCycle()
             
             CONTINUE
             
-        case SHA_abs_y_4:
+        CASE(SHA_abs_y_4)
             
             WRITE_TO_ADDRESS
             POLL_INT
             DONE
             
-        case SHA_ind_y_4:
+        CASE(SHA_ind_y_4)
             
             IDLE_READ_FROM_ADDRESS
             
@@ -2929,7 +2958,7 @@ CPU<M>::executeOneCycle()
 
             CONTINUE
             
-        case SHA_ind_y_5:
+        CASE(SHA_ind_y_5)
             
             WRITE_TO_ADDRESS
             POLL_INT
@@ -2943,7 +2972,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
        
-        case SHX_abs_y_3:
+        CASE(SHX_abs_y_3)
             
             IDLE_READ_FROM_ADDRESS
             
@@ -2966,7 +2995,7 @@ CPU<M>::executeOneCycle()
             
             CONTINUE
            
-        case SHX_abs_y_4:
+        CASE(SHX_abs_y_4)
             
             WRITE_TO_ADDRESS
             POLL_INT
@@ -2980,7 +3009,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
             
-        case SHY_abs_x_3:
+        CASE(SHY_abs_x_3)
             
             IDLE_READ_FROM_ADDRESS
             
@@ -3003,7 +3032,7 @@ CPU<M>::executeOneCycle()
 
             CONTINUE
             
-        case SHY_abs_x_4:
+        CASE(SHY_abs_x_4)
             
             WRITE_TO_ADDRESS
             POLL_INT
@@ -3019,36 +3048,36 @@ CPU<M>::executeOneCycle()
 
         #define DO_SLO setC(reg.d & 128); reg.d <<= 1;
 
-        case SLO_zpg_3:
-        case SLO_zpg_x_4:
+        CASE(SLO_zpg_3)
+        CASE(SLO_zpg_x_4)
             
             WRITE_TO_ZERO_PAGE
             DO_SLO
             CONTINUE
             
-        case SLO_zpg_4:
-        case SLO_zpg_x_5:
+        CASE(SLO_zpg_4)
+        CASE(SLO_zpg_x_5)
             
             WRITE_TO_ZERO_PAGE
             loadA(reg.a | reg.d);
             POLL_INT
             DONE
             
-        case SLO_abs_4:
-        case SLO_abs_x_5:
-        case SLO_abs_y_5:
-        case SLO_ind_x_6:
-        case SLO_ind_y_6:
+        CASE(SLO_abs_4)
+        CASE(SLO_abs_x_5)
+        CASE(SLO_abs_y_5)
+        CASE(SLO_ind_x_6)
+        CASE(SLO_ind_y_6)
             
             WRITE_TO_ADDRESS
             DO_SLO
             CONTINUE
             
-        case SLO_abs_5:
-        case SLO_abs_x_6:
-        case SLO_abs_y_6:
-        case SLO_ind_x_7:
-        case SLO_ind_y_7:
+        CASE(SLO_abs_5)
+        CASE(SLO_abs_x_6)
+        CASE(SLO_abs_y_6)
+        CASE(SLO_ind_x_7)
+        CASE(SLO_ind_y_7)
             
             WRITE_TO_ADDRESS
             loadA(reg.a | reg.d);
@@ -3065,36 +3094,36 @@ CPU<M>::executeOneCycle()
 
         #define DO_SRE setC(reg.d & 1); reg.d >>= 1;
 
-        case SRE_zpg_3:
-        case SRE_zpg_x_4:
+        CASE(SRE_zpg_3)
+        CASE(SRE_zpg_x_4)
             
             WRITE_TO_ZERO_PAGE
             DO_SRE
             CONTINUE
             
-        case SRE_zpg_4:
-        case SRE_zpg_x_5:
+        CASE(SRE_zpg_4)
+        CASE(SRE_zpg_x_5)
             
             WRITE_TO_ZERO_PAGE
             loadA(reg.a ^ reg.d);
             POLL_INT
             DONE
             
-        case SRE_abs_4:
-        case SRE_abs_x_5:
-        case SRE_abs_y_5:
-        case SRE_ind_x_6:
-        case SRE_ind_y_6:
+        CASE(SRE_abs_4)
+        CASE(SRE_abs_x_5)
+        CASE(SRE_abs_y_5)
+        CASE(SRE_ind_x_6)
+        CASE(SRE_ind_y_6)
             
             WRITE_TO_ADDRESS
             DO_SRE
             CONTINUE
             
-        case SRE_abs_5:
-        case SRE_abs_x_6:
-        case SRE_abs_y_6:
-        case SRE_ind_x_7:
-        case SRE_ind_y_7:
+        CASE(SRE_abs_5)
+        CASE(SRE_abs_x_6)
+        CASE(SRE_abs_y_6)
+        CASE(SRE_ind_x_7)
+        CASE(SRE_ind_y_7)
             
             WRITE_TO_ADDRESS
             loadA(reg.a ^ reg.d);
@@ -3109,7 +3138,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              - - - - - -
             
-        case TAS_abs_y_3:
+        CASE(TAS_abs_y_3)
             
             IDLE_READ_FROM_ADDRESS
             
@@ -3134,7 +3163,7 @@ CPU<M>::executeOneCycle()
 
             CONTINUE
             
-        case TAS_abs_y_4:
+        CASE(TAS_abs_y_4)
             
             WRITE_TO_ADDRESS
             POLL_INT
@@ -3147,7 +3176,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
 
-        case ANE_imm:
+        CASE(ANE_imm)
             
             READ_IMMEDIATE
             loadA(reg.x & reg.d & (reg.a | 0xEE));
@@ -3162,7 +3191,7 @@ CPU<M>::executeOneCycle()
         // Flags:       N Z C I D V
         //              / / - - - -
 
-        case LXA_imm:
+        CASE(LXA_imm)
             
             READ_IMMEDIATE
             reg.x = reg.d & (reg.a | 0xEE);
@@ -3170,13 +3199,220 @@ CPU<M>::executeOneCycle()
             POLL_INT
             DONE
             
-        default:
+        DEFAULT_CASE
             
             warn("UNIMPLEMENTED OPCODE: %ld (%02lX)\n", (long)next, (long)next);
             assert(false);
     }
 }
 
+#ifdef DRIVE_FAST_PATH
+template <typename M> isize
+CPU<M>::executeInstruction()
+{
+    assert(inFetchPhase());
+    
+    isize cycles = 0;
+    do {
+        cycle++;
+        executeOneCycle();
+        cycles++;
+    } while (next != fetch);
+    
+    return cycles;
+}
+
+template <typename M> bool
+CPU<M>::nextInstructionIsIsolated() const
+{
+    if (next != fetch || doNmi || doIrq) return false;
+    
+    u16 pc = reg.pc;
+    
+    // ROM code of the drive is classified once
+    if constexpr (isDriveCPU()) {
+        
+        if (pc >= 0xC000 && pc <= 0xFFFD) {
+            
+            u8 opcode = mem.rom[pc & 0x3FFF];
+            u8 lo = mem.rom[(pc + 1) & 0x3FFF];
+            u8 hi = mem.rom[(pc + 2) & 0x3FFF];
+            u32 bytes = 1 << 24 | hi << 16 | lo << 8 | opcode;
+            
+            DecodedInstruction &entry = decodeCache[pc & 0x3FFF];
+            if (entry.bytes != bytes) {
+                entry.bytes = bytes;
+                entry.isolation = classify(pc, opcode, lo, hi);
+            }
+            
+            switch (entry.isolation) {
+                    
+                case ISOLATION_ALWAYS: return true;
+                case ISOLATION_DYNAMIC: return isIsolated(opcode, lo, hi);
+                default: return false;
+            }
+        }
+    }
+    
+    // The opcode and the operand bytes must be located in inert memory
+    if (!isSideEffectFree(pc) ||
+        !isSideEffectFree(pc + 1) ||
+        !isSideEffectFree(pc + 2)) return false;
+    
+    u8 opcode = mem.spypeek(pc);
+    u8 lo = mem.spypeek(pc + 1);
+    u8 hi = mem.spypeek(pc + 2);
+    
+    switch (classify(pc, opcode, lo, hi)) {
+            
+        case ISOLATION_ALWAYS: return true;
+        case ISOLATION_DYNAMIC: return isIsolated(opcode, lo, hi);
+        default: return false;
+    }
+}
+
+template <typename M> Isolation
+CPU<M>::classify(u16 pc, u8 opcode, u8 lo, u8 hi) const
+{
+    u16 abs = (u16)(hi << 8 | lo);
+    u16 addr;
+    
+    switch (opcode) {
+            
+        case 0x93: case 0x9B: case 0x9C: case 0x9E: case 0x9F:
+            
+            // SHA, TAS, SHY, SHX may write to a garbled address
+            return ISOLATION_NEVER;
+            
+        case 0x00:
+            
+            // BRK reads the IRQ vector
+            return
+            isSideEffectFree(0xFFFE) &&
+            isSideEffectFree(0xFFFF) ? ISOLATION_ALWAYS : ISOLATION_NEVER;
+            
+        case 0x60:
+            
+            // RTS reads from the return address
+            return ISOLATION_DYNAMIC;
+    }
+    
+    if (actionFunc[opcode] == JAM) return ISOLATION_NEVER;
+    
+    // Check the memory locations that are accessed in the execute phase
+    switch (debugger.addressingMode[opcode]) {
+            
+        case ADDR_IMPLIED:
+        case ADDR_ACCUMULATOR:
+        case ADDR_IMMEDIATE:
+        case ADDR_DIRECT:
+            
+            return ISOLATION_ALWAYS;
+            
+        case ADDR_ZERO_PAGE:
+            
+            return isSideEffectFree(lo) ? ISOLATION_ALWAYS : ISOLATION_NEVER;
+            
+        case ADDR_ZERO_PAGE_X:
+        case ADDR_ZERO_PAGE_Y:
+        case ADDR_INDIRECT_X:
+            
+            return isSideEffectFree(lo) ? ISOLATION_DYNAMIC : ISOLATION_NEVER;
+
+        case ADDR_INDIRECT_Y:
+            
+            return
+            isSideEffectFree(lo) &&
+            isSideEffectFree((u8)(lo + 1)) ? ISOLATION_DYNAMIC : ISOLATION_NEVER;
+            
+        case ADDR_ABSOLUTE:
+            
+            return isSideEffectFree(abs) ? ISOLATION_ALWAYS : ISOLATION_NEVER;
+            
+        case ADDR_ABSOLUTE_X:
+        case ADDR_ABSOLUTE_Y:
+            
+            return ISOLATION_DYNAMIC;
+
+        case ADDR_RELATIVE:
+            
+            addr = pc + 2 + (i8)lo;
+            return
+            isSideEffectFree(((pc + 2) & 0xFF00) | (addr & 0xFF)) &&
+            isSideEffectFree(addr) ? ISOLATION_ALWAYS : ISOLATION_NEVER;
+            
+        case ADDR_INDIRECT:
+            
+            return
+            isSideEffectFree(abs) &&
+            isSideEffectFree((abs & 0xFF00) | ((abs + 1) & 0xFF)) ?
+            ISOLATION_ALWAYS : ISOLATION_NEVER;
+            
+        default:
+            
+            return ISOLATION_NEVER;
+    }
+}
+
+template <typename M> bool
+CPU<M>::isIsolated(u8 opcode, u8 lo, u8 hi) const
+{
+    u16 abs = (u16)(hi << 8 | lo);
+    u16 addr;
+    
+    if (opcode == 0x60) {
+        
+        addr = (u16)(mem.spypeek(0x100 | (u8)(reg.sp + 2)) << 8 |
+                     mem.spypeek(0x100 | (u8)(reg.sp + 1)));
+        return isSideEffectFree(addr);
+    }
+    
+    switch (debugger.addressingMode[opcode]) {
+            
+        case ADDR_ZERO_PAGE_X:
+            
+            return isSideEffectFree((u8)(lo + reg.x));
+            
+        case ADDR_ZERO_PAGE_Y:
+            
+            return isSideEffectFree((u8)(lo + reg.y));
+            
+        case ADDR_ABSOLUTE_X:
+            
+            addr = abs + reg.x;
+            return isSideEffectFree((abs & 0xFF00) | (addr & 0xFF)) &&
+            isSideEffectFree(addr);
+
+        case ADDR_ABSOLUTE_Y:
+            
+            addr = abs + reg.y;
+            return isSideEffectFree((abs & 0xFF00) | (addr & 0xFF)) &&
+            isSideEffectFree(addr);
+
+        case ADDR_INDIRECT_X:
+        {
+            u8 ptr = lo + reg.x;
+            if (!isSideEffectFree(ptr) ||
+                !isSideEffectFree((u8)(ptr + 1))) return false;
+            
+            addr = (u16)(mem.spypeek((u8)(ptr + 1)) << 8 | mem.spypeek(ptr));
+            return isSideEffectFree(addr);
+        }
+        case ADDR_INDIRECT_Y:
+        {
+            u16 base = (u16)(mem.spypeek((u8)(lo + 1)) << 8 | mem.spypeek(lo));
+            addr = base + reg.y;
+            return isSideEffectFree((base & 0xFF00) | (addr & 0xFF)) &&
+            isSideEffectFree(addr);
+        }
+        default:
+            
+            assert(false);
+            return false;
+    }
+}
+#endif
+
 template <> void CPU<C64Memory>::done() {
 
     if (debugMode) {
@@ -3188,6 +3424,9 @@ template <> void CPU<C64Memory>::done() {
         if (debugger.breakpointMatches(reg.pc)) c64.signalBreakpoint();
     }
     
+    // Check if a headless run has reached its exit address
+    if (unlikely(reg.pc == exitAddr)) c64.signalExitAddr();
+    
     reg.pc0 = reg.pc;
     next = fetch;
 }
@@ -3205,3 +3444,10 @@ template void CPU<C64Memory>::registerInstructions();
 template void CPU<C64Memory>::executeOneCycle();
 template void CPU<DriveMemory>::registerInstructions();
 template void CPU<DriveMemory>::executeOneCycle();
+
+#ifdef DRIVE_FAST_PATH
+template isize CPU<C64Memory>::executeInstruction();
+template bool CPU<C64Memory>::nextInstructionIsIsolated() const;
+template isize CPU<DriveMemory>::executeInstruction();
+template bool CPU<DriveMemory>::nextInstructionIsIsolated() const;
+#endif
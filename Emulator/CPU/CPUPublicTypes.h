@@ -46,6 +46,15 @@ enum_long(BPTYPE)
 };
 typedef BPTYPE BreakpointType;
 
+enum_long(LANE)
+{
+    LANE_RUNNING,   // Executes instructions
+    LANE_EXIT,      // Has reached the exit address
+    LANE_DIVERGED,  // Needs to be continued by the scalar CPU
+    LANE_COUNT
+};
+typedef LANE LaneState;
+
 //
 // Structures
 //
@@ -101,6 +110,17 @@ typedef struct
 }
 RecordedInstruction;
 
+typedef struct
+{
+    // Number of batch steps and the number of executed instructions
+    u64 steps;
+    u64 instructions;
+    
+    // Number of opcode groups executed (one per distinct opcode and step)
+    u64 groups;
+}
+BatchStats;
+
 typedef struct
 {
     u64 cycle;
@@ -0,0 +1,292 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "CPUTrace.h"
+#include "Errors.h"
+#include "Utils.h"
+
+//
+// TraceWriter
+//
+
+TraceWriter::TraceWriter()
+{
+    pthread_mutex_init(&mutex, nullptr);
+    pthread_cond_init(&cond, nullptr);
+}
+
+TraceWriter::~TraceWriter()
+{
+    stop();
+
+    delete current;
+    for (usize i = 0; i < pooled; i++) delete pool[i];
+
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mutex);
+}
+
+void
+TraceWriter::start(const char *path)
+{
+    assert(path);
+
+    stop();
+
+    if (!(file = fopen(path, "wb"))) {
+        throw VC64Error(ERROR_FILE_CANT_WRITE);
+    }
+    fwrite(TRACE_SIGNATURE, 1, 8, file);
+
+    // Allocate the chunks on first use
+    if (current == nullptr) {
+
+        current = new Chunk();
+        while (pooled < chunkCount - 1) pool[pooled++] = new Chunk();
+    }
+    rewind();
+
+    dropped = 0;
+    totalRecords = 0;
+    totalDropped = 0;
+    quit = false;
+
+    pthread_create(&thread, nullptr, main, (void *)this);
+}
+
+void
+TraceWriter::stop()
+{
+    if (!isActive()) return;
+
+    pthread_mutex_lock(&mutex);
+
+    // Hand over the last chunk (we may wait here, because tracing stops)
+    if (current->records || dropped) {
+
+        while (pooled == 0) pthread_cond_wait(&cond, &mutex);
+        current->dropped = dropped;
+        queue[(head + queued++) % chunkCount] = current;
+        current = pool[--pooled];
+        dropped = 0;
+    }
+
+    // Let the writer thread drain the queue and terminate
+    quit = true;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&mutex);
+    pthread_join(thread, nullptr);
+
+    fclose(file);
+    file = nullptr;
+}
+
+void
+TraceWriter::record(const RecordedInstruction &instr, usize length)
+{
+    assert(isActive());
+    assert(length >= 1 && length <= 3);
+
+    if (current->size + TRACE_MAX_RECORD_SIZE > chunkSize) flush();
+
+    u8 *start = current->data + current->size, *p = start + 1;
+    bool full = current->records == 0;
+    u8 tag = (u8)length;
+
+    if (full || instr.pc != nextPC) {
+        tag |= TRACE_TAG_PC;
+        *p++ = LO_BYTE(instr.pc);
+        *p++ = HI_BYTE(instr.pc);
+    }
+    *p++ = instr.byte1;
+    if (length > 1) *p++ = instr.byte2;
+    if (length > 2) *p++ = instr.byte3;
+
+    if (full || instr.a != prev.a) { tag |= TRACE_TAG_A; *p++ = instr.a; }
+    if (full || instr.x != prev.x) { tag |= TRACE_TAG_X; *p++ = instr.x; }
+    if (full || instr.y != prev.y) { tag |= TRACE_TAG_Y; *p++ = instr.y; }
+    if (full || instr.sp != prev.sp) { tag |= TRACE_TAG_SP; *p++ = instr.sp; }
+    if (full || instr.flags != prev.flags) { tag |= TRACE_TAG_FLAGS; *p++ = instr.flags; }
+
+    // Write the cycle delta as a variable length integer
+    u64 delta = full ? instr.cycle : instr.cycle - prev.cycle;
+    while (delta >= 0x80) { *p++ = (u8)(delta | 0x80); delta >>= 7; }
+    *p++ = (u8)delta;
+
+    *start = tag;
+    current->size = p - current->data;
+    current->records++;
+    totalRecords++;
+
+    prev = instr;
+    nextPC = (u16)(instr.pc + length);
+}
+
+void
+TraceWriter::flush()
+{
+    pthread_mutex_lock(&mutex);
+
+    if (pooled == 0) {
+
+        // The writer thread is behind. Drop the chunk instead of waiting
+        dropped += current->records;
+        totalDropped += current->records;
+
+    } else {
+
+        current->dropped = dropped;
+        queue[(head + queued++) % chunkCount] = current;
+        current = pool[--pooled];
+        dropped = 0;
+        pthread_cond_broadcast(&cond);
+    }
+
+    pthread_mutex_unlock(&mutex);
+    rewind();
+}
+
+void
+TraceWriter::rewind()
+{
+    current->size = 0;
+    current->records = 0;
+    current->dropped = 0;
+}
+
+void *
+TraceWriter::main(void *ptr)
+{
+    TraceWriter *writer = (TraceWriter *)ptr;
+
+    pthread_mutex_lock(&writer->mutex);
+
+    while (true) {
+
+        while (writer->queued == 0 && !writer->quit) {
+            pthread_cond_wait(&writer->cond, &writer->mutex);
+        }
+        if (writer->queued == 0) break;
+
+        Chunk *chunk = writer->queue[writer->head];
+        writer->head = (writer->head + 1) % chunkCount;
+        writer->queued--;
+
+        // Write the chunk without holding the lock
+        pthread_mutex_unlock(&writer->mutex);
+
+        u8 header[16];
+        for (isize i = 0; i < 4; i++) header[i] = (u8)(chunk->size >> (8 * i));
+        for (isize i = 0; i < 4; i++) header[4 + i] = (u8)(chunk->records >> (8 * i));
+        for (isize i = 0; i < 8; i++) header[8 + i] = (u8)(chunk->dropped >> (8 * i));
+        fwrite(header, 1, sizeof(header), writer->file);
+        fwrite(chunk->data, 1, chunk->size, writer->file);
+
+        pthread_mutex_lock(&writer->mutex);
+        writer->pool[writer->pooled++] = chunk;
+        pthread_cond_broadcast(&writer->cond);
+    }
+
+    pthread_mutex_unlock(&writer->mutex);
+    return nullptr;
+}
+
+
+//
+// TraceReader
+//
+
+TraceReader::TraceReader(std::istream &ref) : stream(ref)
+{
+    char signature[8];
+
+    if (!stream.read(signature, 8) || memcmp(signature, TRACE_SIGNATURE, 8)) {
+        throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+    }
+}
+
+TraceReader::~TraceReader()
+{
+    delete [] data;
+}
+
+bool
+TraceReader::read(RecordedInstruction &instr, u64 &dropped)
+{
+    dropped = 0;
+    while (pos >= size) if (!readChunk(dropped)) return false;
+
+    u8 tag = next();
+    usize length = tag & TRACE_TAG_LEN;
+
+    if (tag & TRACE_TAG_PC) {
+        u8 lo = next();
+        u8 hi = next();
+        prev.pc = LO_HI(lo, hi);
+    } else {
+        prev.pc = nextPC;
+    }
+    prev.byte1 = next();
+    prev.byte2 = length > 1 ? next() : 0;
+    prev.byte3 = length > 2 ? next() : 0;
+
+    if (tag & TRACE_TAG_A) prev.a = next();
+    if (tag & TRACE_TAG_X) prev.x = next();
+    if (tag & TRACE_TAG_Y) prev.y = next();
+    if (tag & TRACE_TAG_SP) prev.sp = next();
+    if (tag & TRACE_TAG_FLAGS) prev.flags = next();
+
+    u64 delta = 0;
+    for (isize shift = 0;; shift += 7) {
+        u8 byte = next();
+        delta |= (u64)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+    }
+    prev.cycle = first ? delta : prev.cycle + delta;
+    first = false;
+
+    nextPC = (u16)(prev.pc + length);
+    instr = prev;
+    return true;
+}
+
+u8
+TraceReader::next()
+{
+    if (pos >= size) throw VC64Error(ERROR_FILE_CANT_READ);
+    return data[pos++];
+}
+
+bool
+TraceReader::readChunk(u64 &dropped)
+{
+    u8 header[16];
+
+    stream.read((char *)header, sizeof(header));
+    if (stream.gcount() == 0) return false;
+    if (stream.gcount() != sizeof(header)) throw VC64Error(ERROR_FILE_CANT_READ);
+
+    u32 newSize = 0;
+    u64 newDropped = 0;
+    for (isize i = 0; i < 4; i++) newSize |= (u32)header[i] << (8 * i);
+    for (isize i = 0; i < 8; i++) newDropped |= (u64)header[8 + i] << (8 * i);
+
+    if (newSize > capacity) {
+        delete [] data;
+        data = new u8[newSize];
+        capacity = newSize;
+    }
+    if (!stream.read((char *)data, newSize)) throw VC64Error(ERROR_FILE_CANT_READ);
+
+    size = newSize;
+    pos = 0;
+    first = true;
+    dropped += newDropped;
+    return true;
+}
@@ -0,0 +1,182 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "CPUPublicTypes.h"
+#include <pthread.h>
+#include <cstdio>
+#include <istream>
+
+/* Instruction traces
+ *
+ * A trace file starts with an 8 byte signature, followed by a sequence of
+ * chunks. Each chunk is self-contained and starts with a 16 byte header:
+ *
+ *     u32 : Size of the payload in bytes
+ *     u32 : Number of records in this chunk
+ *     u64 : Number of records that have been dropped before this chunk
+ *
+ * The payload is a sequence of delta-encoded records. Each record starts
+ * with a tag byte that specifies which items follow:
+ *
+ *     Bit 0 - 1 : Length of the instruction (1 - 3 opcode bytes)
+ *     Bit 2     : PC (2 bytes), omitted if the PC is the address of the
+ *                 instruction following the previous one
+ *     Bit 3 - 7 : A, X, Y, SP, flags (one byte each), omitted if unchanged
+ *
+ * The tag is followed by the PC, the opcode bytes, the register values, and
+ * the distance to the cycle of the previous record (LEB128 encoded). The
+ * first record of a chunk contains all items and an absolute cycle count.
+ */
+
+#define TRACE_SIGNATURE "VC64TRC1"
+
+#define TRACE_TAG_LEN   0x03
+#define TRACE_TAG_PC    0x04
+#define TRACE_TAG_A     0x08
+#define TRACE_TAG_X     0x10
+#define TRACE_TAG_Y     0x20
+#define TRACE_TAG_SP    0x40
+#define TRACE_TAG_FLAGS 0x80
+
+// Maximum size of an encoded record in bytes
+#define TRACE_MAX_RECORD_SIZE (1 + 2 + 3 + 5 + 10)
+
+/* Writes instruction traces to disk. Records are collected in chunks which
+ * are handed over to a background thread. The number of chunks is limited.
+ * If the writer thread falls behind, chunks are dropped instead of blocking
+ * the emulator thread.
+ */
+class TraceWriter {
+
+    // Size and number of chunks
+    static const usize chunkSize = 64 * 1024;
+    static const usize chunkCount = 16;
+
+    struct Chunk {
+
+        u8 data[chunkSize];
+        usize size;
+        u32 records;
+        u64 dropped;
+    };
+
+    // The output file (nullptr if tracing is inactive)
+    FILE *file = nullptr;
+
+    // The chunk that is currently filled by the emulator thread
+    Chunk *current = nullptr;
+
+    // Chunks waiting to be written and chunks ready for reuse
+    Chunk *queue[chunkCount];
+    Chunk *pool[chunkCount];
+    usize head = 0;
+    usize queued = 0;
+    usize pooled = 0;
+
+    // The previously recorded instruction and the address of its successor
+    RecordedInstruction prev = { };
+    u16 nextPC = 0;
+
+    // Number of records that have been dropped since the last chunk was queued
+    u64 dropped = 0;
+
+    // Statistics
+    u64 totalRecords = 0;
+    u64 totalDropped = 0;
+
+    // The writer thread
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool quit = false;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    TraceWriter();
+    ~TraceWriter();
+
+
+    //
+    // Controlling
+    //
+
+public:
+
+    // Starts or stops tracing
+    void start(const char *path) throws;
+    void stop();
+
+    // Returns true if a trace is being recorded
+    bool isActive() const { return file != nullptr; }
+
+    // Returns the number of recorded or dropped instructions
+    u64 recorded() const { return totalRecords; }
+    u64 lost() const { return totalDropped; }
+
+
+    //
+    // Recording
+    //
+
+public:
+
+    // Adds an instruction to the trace
+    void record(const RecordedInstruction &instr, usize length);
+
+private:
+
+    // Hands the current chunk over to the writer thread
+    void flush();
+
+    // Resets the current chunk
+    void rewind();
+
+    // The thread's main function
+    static void *main(void *writer);
+};
+
+// Reads instruction traces from disk
+class TraceReader {
+
+    std::istream &stream;
+
+    // The current chunk
+    u8 *data = nullptr;
+    usize capacity = 0;
+    usize size = 0;
+    usize pos = 0;
+
+    // The previously decoded instruction and the address of its successor
+    RecordedInstruction prev = { };
+    u16 nextPC = 0;
+    bool first = true;
+
+public:
+
+    TraceReader(std::istream &stream) throws;
+    ~TraceReader();
+
+    /* Decodes the next record. If records have been dropped in front of it,
+     * their number is written into 'dropped'. Returns false at the end of
+     * the trace.
+     */
+    bool read(RecordedInstruction &instr, u64 &dropped) throws;
+
+private:
+
+    u8 next() throws;
+    bool readChunk(u64 &dropped) throws;
+};
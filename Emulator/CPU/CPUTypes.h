@@ -100,6 +100,27 @@ struct BreakpointTypeEnum : Reflection<BreakpointTypeEnum, BreakpointType> {
     }
 };
 
+struct LaneStateEnum : Reflection<LaneStateEnum, LaneState> {
+    
+    static bool isValid(long value)
+    {
+        return (unsigned long)value < LANE_COUNT;
+    }
+    
+    static const char *prefix() { return "LANE"; }
+    static const char *key(LaneState value)
+    {
+        switch (value) {
+                
+            case LANE_RUNNING:   return "RUNNING";
+            case LANE_EXIT:      return "EXIT";
+            case LANE_DIVERGED:  return "DIVERGED";
+            case LANE_COUNT:     return "???";
+        }
+        return "???";
+    }
+};
+
 //
 // Private types
 //
@@ -122,3 +143,23 @@ typedef enum
     ADDR_INDIRECT
 }
 AddressingMode;
+
+// Outcome of the address independent part of the isolation check
+typedef enum : u8
+{
+    ISOLATION_NEVER,
+    ISOLATION_ALWAYS,
+    ISOLATION_DYNAMIC
+}
+Isolation;
+
+// An entry in the decode cache of the drive CPU
+typedef struct
+{
+    // Opcode and operand bytes (bit 24 is set in all valid entries)
+    u32 bytes;
+    
+    // The result of the static isolation check
+    Isolation isolation;
+}
+DecodedInstruction;
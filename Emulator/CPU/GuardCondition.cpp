@@ -0,0 +1,364 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+#include <ctype.h>
+#include <algorithm>
+
+// Instructions of the stack machine
+enum GCOp : u8
+{
+    GC_PUSH,        // Pushes the 16 bit operand
+    GC_A,           // Pushes a register
+    GC_X,
+    GC_Y,
+    GC_SP,
+    GC_PC,
+    GC_P,
+    GC_FLAG,        // Pushes the flag selected by the 8 bit operand
+    GC_PEEK,        // Replaces an address by the memory contents
+
+    GC_NOT,         // Unary operators
+    GC_NEG,
+    GC_CPL,
+
+    GC_ADD,         // Binary operators
+    GC_SUB,
+    GC_AND,
+    GC_OR,
+    GC_XOR,
+    GC_EQ,
+    GC_NE,
+    GC_LT,
+    GC_LE,
+    GC_GT,
+    GC_GE,
+    GC_LAND,
+    GC_LOR
+};
+
+/* Translates an expression into bytecode by recursive descent. Each parse
+ * function emits the code for one precedence level.
+ */
+class GuardCompiler {
+
+    const char *p;
+    std::vector<u8> &code;
+
+    // Current and maximum number of values on the evaluation stack
+    isize depth = 0;
+    isize maxDepth = 0;
+
+    // Nesting level of unary operators and brackets (limits the recursion)
+    static constexpr isize maxNesting = 64;
+    isize nesting = 0;
+
+public:
+
+    GuardCompiler(const string &expr, std::vector<u8> &out) :
+    p(expr.c_str()), code(out) { }
+
+    void compile()
+    {
+        parseLogicalOr();
+
+        skipSpaces();
+        if (*p != 0) throw VC64Error(ERROR_GUARD_SYNTAX);
+        assert(depth == 1);
+    }
+
+private:
+
+    void skipSpaces() { while (isspace(*p)) p++; }
+
+    // Consumes the specified token if it comes next
+    bool accept(const char *token)
+    {
+        skipSpaces();
+
+        usize len = strlen(token);
+        if (strncmp(p, token, len)) return false;
+
+        // Don't split up composite operators
+        if (len == 1 && strchr("=&|<>", token[0]) && p[1] == token[0]) return false;
+        if (len == 1 && strchr("<>!", token[0]) && p[1] == '=') return false;
+
+        p += len;
+        return true;
+    }
+
+    void expect(const char *token)
+    {
+        if (!accept(token)) throw VC64Error(ERROR_GUARD_SYNTAX);
+    }
+
+    // Enters or leaves a nested subexpression
+    void enter() { if (++nesting > maxNesting) throw VC64Error(ERROR_GUARD_SYNTAX); }
+    void leave() { nesting--; }
+
+    void emit(GCOp op, isize stackDelta)
+    {
+        code.push_back(op);
+
+        depth += stackDelta;
+        maxDepth = std::max(maxDepth, depth);
+        if (maxDepth > GuardCondition::stackSize) throw VC64Error(ERROR_GUARD_SYNTAX);
+    }
+
+    void parseLogicalOr()
+    {
+        parseLogicalAnd();
+        while (accept("||")) { parseLogicalAnd(); emit(GC_LOR, -1); }
+    }
+
+    void parseLogicalAnd()
+    {
+        parseBitwiseOr();
+        while (accept("&&")) { parseBitwiseOr(); emit(GC_LAND, -1); }
+    }
+
+    void parseBitwiseOr()
+    {
+        parseBitwiseXor();
+        while (accept("|")) { parseBitwiseXor(); emit(GC_OR, -1); }
+    }
+
+    void parseBitwiseXor()
+    {
+        parseBitwiseAnd();
+        while (accept("^")) { parseBitwiseAnd(); emit(GC_XOR, -1); }
+    }
+
+    void parseBitwiseAnd()
+    {
+        parseEquality();
+        while (accept("&")) { parseEquality(); emit(GC_AND, -1); }
+    }
+
+    void parseEquality()
+    {
+        parseRelation();
+        while (true) {
+
+            if (accept("==") || accept("=")) {
+                parseRelation(); emit(GC_EQ, -1);
+            } else if (accept("!=")) {
+                parseRelation(); emit(GC_NE, -1);
+            } else {
+                break;
+            }
+        }
+    }
+
+    void parseRelation()
+    {
+        parseSum();
+        while (true) {
+
+            if (accept("<=")) {
+                parseSum(); emit(GC_LE, -1);
+            } else if (accept(">=")) {
+                parseSum(); emit(GC_GE, -1);
+            } else if (accept("<")) {
+                parseSum(); emit(GC_LT, -1);
+            } else if (accept(">")) {
+                parseSum(); emit(GC_GT, -1);
+            } else {
+                break;
+            }
+        }
+    }
+
+    void parseSum()
+    {
+        parseUnary();
+        while (true) {
+
+            if (accept("+")) {
+                parseUnary(); emit(GC_ADD, -1);
+            } else if (accept("-")) {
+                parseUnary(); emit(GC_SUB, -1);
+            } else {
+                break;
+            }
+        }
+    }
+
+    void parseUnary()
+    {
+        GCOp op;
+
+        if (accept("!")) {
+            op = GC_NOT;
+        } else if (accept("-")) {
+            op = GC_NEG;
+        } else if (accept("~")) {
+            op = GC_CPL;
+        } else {
+            parsePrimary();
+            return;
+        }
+
+        enter();
+        parseUnary();
+        emit(op, 0);
+        leave();
+    }
+
+    void parsePrimary()
+    {
+        if (accept("(")) {
+
+            enter();
+            parseLogicalOr();
+            expect(")");
+            leave();
+            return;
+        }
+        if (accept("[")) {
+
+            enter();
+            parseLogicalOr();
+            expect("]");
+            emit(GC_PEEK, 0);
+            leave();
+            return;
+        }
+        if (*p == '$' || *p == '%' || isdigit(*p)) {
+
+            parseNumber();
+            return;
+        }
+        if (isalpha(*p)) {
+
+            parseIdentifier();
+            return;
+        }
+        throw VC64Error(ERROR_GUARD_SYNTAX);
+    }
+
+    void parseNumber()
+    {
+        int base = *p == '$' ? 16 : *p == '%' ? 2 : 10;
+        if (base != 10) p++;
+
+        char *end;
+        unsigned long value = strtoul(p, &end, base);
+        if (end == p || isalnum(*end) || value > 0xFFFF) {
+            throw VC64Error(ERROR_GUARD_SYNTAX);
+        }
+        p = end;
+
+        emit(GC_PUSH, 1);
+        code.push_back(LO_BYTE(value));
+        code.push_back(HI_BYTE(value));
+    }
+
+    void parseIdentifier()
+    {
+        char name[4];
+        isize len = 0;
+
+        for (; isalnum(*p); p++) {
+            if (len == 3) throw VC64Error(ERROR_GUARD_SYNTAX);
+            name[len++] = (char)toupper(*p);
+        }
+        name[len] = 0;
+
+        static const struct { const char *name; GCOp op; u8 flag; } symbols[] = {
+
+            { "A", GC_A, 0 }, { "X", GC_X, 0 }, { "Y", GC_Y, 0 },
+            { "SP", GC_SP, 0 }, { "PC", GC_PC, 0 }, { "P", GC_P, 0 },
+            { "N", GC_FLAG, N_FLAG }, { "V", GC_FLAG, V_FLAG },
+            { "B", GC_FLAG, B_FLAG }, { "D", GC_FLAG, D_FLAG },
+            { "I", GC_FLAG, I_FLAG }, { "Z", GC_FLAG, Z_FLAG },
+            { "C", GC_FLAG, C_FLAG }
+        };
+
+        for (auto &symbol : symbols) {
+
+            if (strcmp(name, symbol.name) == 0) {
+
+                emit(symbol.op, 1);
+                if (symbol.op == GC_FLAG) code.push_back(symbol.flag);
+                return;
+            }
+        }
+        throw VC64Error(ERROR_GUARD_SYNTAX);
+    }
+};
+
+void
+GuardCondition::compile(const string &expr)
+{
+    std::vector<u8> newCode;
+
+    // Check if the expression is empty
+    const char *p = expr.c_str();
+    while (isspace(*p)) p++;
+
+    if (*p != 0) {
+        GuardCompiler compiler = GuardCompiler(expr, newCode);
+        compiler.compile();
+    }
+
+    source = expr;
+    code = newCode;
+}
+
+bool
+GuardCondition::eval(const Registers &reg, u8 p, const C64Memory &mem) const
+{
+    if (code.empty()) return true;
+
+    i32 stack[stackSize];
+    isize sp = -1;
+
+    const u8 *ip = code.data(), *end = ip + code.size();
+
+    while (ip < end) {
+
+        switch (*ip++) {
+
+            case GC_PUSH:   stack[++sp] = LO_HI(ip[0], ip[1]); ip += 2; break;
+            case GC_A:      stack[++sp] = reg.a; break;
+            case GC_X:      stack[++sp] = reg.x; break;
+            case GC_Y:      stack[++sp] = reg.y; break;
+            case GC_SP:     stack[++sp] = reg.sp; break;
+            case GC_PC:     stack[++sp] = reg.pc; break;
+            case GC_P:      stack[++sp] = p; break;
+            case GC_FLAG:   stack[++sp] = (p & *ip++) ? 1 : 0; break;
+            case GC_PEEK:   stack[sp] = mem.spypeek((u16)stack[sp]); break;
+
+            case GC_NOT:    stack[sp] = !stack[sp]; break;
+            case GC_NEG:    stack[sp] = -stack[sp]; break;
+            case GC_CPL:    stack[sp] = ~stack[sp]; break;
+
+            case GC_ADD:    sp--; stack[sp] = stack[sp] + stack[sp + 1]; break;
+            case GC_SUB:    sp--; stack[sp] = stack[sp] - stack[sp + 1]; break;
+            case GC_AND:    sp--; stack[sp] = stack[sp] & stack[sp + 1]; break;
+            case GC_OR:     sp--; stack[sp] = stack[sp] | stack[sp + 1]; break;
+            case GC_XOR:    sp--; stack[sp] = stack[sp] ^ stack[sp + 1]; break;
+            case GC_EQ:     sp--; stack[sp] = stack[sp] == stack[sp + 1]; break;
+            case GC_NE:     sp--; stack[sp] = stack[sp] != stack[sp + 1]; break;
+            case GC_LT:     sp--; stack[sp] = stack[sp] < stack[sp + 1]; break;
+            case GC_LE:     sp--; stack[sp] = stack[sp] <= stack[sp + 1]; break;
+            case GC_GT:     sp--; stack[sp] = stack[sp] > stack[sp + 1]; break;
+            case GC_GE:     sp--; stack[sp] = stack[sp] >= stack[sp + 1]; break;
+            case GC_LAND:   sp--; stack[sp] = stack[sp] && stack[sp + 1]; break;
+            case GC_LOR:    sp--; stack[sp] = stack[sp] || stack[sp + 1]; break;
+
+            default:
+                assert(false);
+        }
+    }
+
+    assert(sp == 0);
+    return stack[0] != 0;
+}
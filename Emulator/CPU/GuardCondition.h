@@ -0,0 +1,66 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "CPUPublicTypes.h"
+#include "Utils.h"
+#include <vector>
+
+class C64Memory;
+
+/* Condition of a breakpoint or watchpoint
+ *
+ * A condition is an expression over the CPU registers and the memory
+ * contents, e.g.,
+ *
+ *     A == $20 && [$D012] > $80
+ *
+ * Square brackets read a memory cell. Besides the registers A, X, Y, SP, PC,
+ * and P, flags can be referred to by their names N, V, B, D, I, Z, and C.
+ * Numbers are written in decimal, hexadecimal ($), or binary (%) notation.
+ * The operators and their precedences are taken from C.
+ *
+ * Conditions are compiled once into a compact bytecode for a small stack
+ * machine. Hence, no parsing takes place when a guard is hit.
+ */
+class GuardCondition {
+
+public:
+
+    // Maximum number of values on the evaluation stack
+    static const isize stackSize = 16;
+
+private:
+
+    // The original expression
+    string source;
+
+    // The compiled expression (empty if the guard is unconditional)
+    std::vector<u8> code;
+
+public:
+
+    /* Compiles an expression. An empty expression removes the condition. On
+     * a syntax error, an exception is thrown and the old condition is kept.
+     */
+    void compile(const string &expr) throws;
+
+    // Removes the condition
+    void clear() { source.clear(); code.clear(); }
+
+    // Returns true if no condition has been set
+    bool isEmpty() const { return code.empty(); }
+
+    // Returns the expression the condition has been compiled from
+    const string &getSource() const { return source; }
+
+    // Evaluates the condition for the provided CPU state
+    bool eval(const Registers &reg, u8 p, const C64Memory &mem) const;
+};
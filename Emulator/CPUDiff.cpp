@@ -0,0 +1,441 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "CPUDiff.h"
+#include "C64.h"
+#include "C64Headless.h"
+#include "BatchCPU.h"
+#include <iomanip>
+
+// Number of instructions between two comparisons of the whole RAM
+static const u64 fullCompareInterval = 0x10000;
+
+// Dirty page bitmap covering the whole RAM
+static const u64 allPages[4] = { UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX };
+
+// Returns the status of a program ending at the specified address
+static const char *
+trap(u16 addr)
+{
+    switch (addr) {
+
+        case 0xE16F: return "PASS";
+        case 0x8000:
+        case 0xA474: return "FAIL";
+
+        default: return nullptr;
+    }
+}
+
+// Appends a PETSCII character to the output of a program
+static void
+print(string &output, u8 c)
+{
+    if (c == 0x0D) output += '\n';
+    else if (c >= 0x20 && c <= 0x5F) output += (char)c;
+    else if (c >= 0xC1 && c <= 0xDA) output += (char)(c - 0x80);
+}
+
+static string
+hex(u32 value, int digits)
+{
+    std::stringstream ss;
+    ss << '$' << std::hex << std::uppercase << std::setw(digits) << std::setfill('0') << value;
+    return ss.str();
+}
+
+/* Executes a single instruction on the micro-op CPU and returns the number of
+ * elapsed cycles (0 if the CPU has jammed)
+ */
+static u64
+step(C64 &c64)
+{
+    u64 start = c64.cpu.cycle;
+
+    do {
+
+        c64.cpu.cycle++;
+        c64.cpu.executeOneCycle();
+        if (c64.cpu.isJammed()) return 0;
+
+    } while (!c64.cpu.inFetchPhase());
+
+    return c64.cpu.cycle - start;
+}
+
+/* Reference implementation of decimal mode ADC and SBC. It computes the BCD
+ * digits with the per-digit branches the micro-op CPU used before switching
+ * to lookup tables. The result is returned in A and the flags in P.
+ */
+static void
+adcDecimal(u8 &a, u8 op, u8 &p)
+{
+    bool c = p & C_FLAG;
+    u16 sum = a + op + (c ? 1 : 0);
+    u8 highDigit = (a >> 4) + (op >> 4);
+    u8 lowDigit = (a & 0x0F) + (op & 0x0F) + (c ? 1 : 0);
+
+    if (lowDigit > 9) lowDigit = lowDigit + 6;
+    if (lowDigit > 0x0F) highDigit++;
+
+    p &= ~(N_FLAG | V_FLAG | Z_FLAG | C_FLAG);
+    if ((sum & 0xFF) == 0) p |= Z_FLAG;
+    if (highDigit & 0x08) p |= N_FLAG;
+    if (((u8)(highDigit << 4) ^ a) & 0x80 && !((a ^ op) & 0x80)) p |= V_FLAG;
+
+    if (highDigit > 9) highDigit = highDigit + 6;
+    if (highDigit > 0x0F) p |= C_FLAG;
+
+    a = (u8)((highDigit << 4) | (lowDigit & 0x0F));
+}
+
+static void
+sbcDecimal(u8 &a, u8 op, u8 &p)
+{
+    bool c = p & C_FLAG;
+    u16 sum = (u16)(a - op - (c ? 0 : 1));
+    u8 highDigit = (u8)((a >> 4) - (op >> 4));
+    u8 lowDigit = (u8)((a & 0x0F) - (op & 0x0F) - (c ? 0 : 1));
+
+    if (lowDigit & 0x10) { lowDigit = lowDigit - 6; highDigit--; }
+    if (highDigit & 0x10) highDigit = highDigit - 6;
+
+    p &= ~(N_FLAG | V_FLAG | Z_FLAG | C_FLAG);
+    if (sum < 0x100) p |= C_FLAG;
+    if (((a ^ sum) & 0x80) && ((a ^ op) & 0x80)) p |= V_FLAG;
+    if ((sum & 0xFF) == 0) p |= Z_FLAG;
+    if (sum & 0x80) p |= N_FLAG;
+
+    a = (u8)((highDigit << 4) | (lowDigit & 0x0F));
+}
+
+// Continues a lane at the point where the micro-op CPU has stopped
+static void
+sync(BatchCPU &batch, C64 &c64, const u64 *dirty)
+{
+    for (isize page = 0; page < 256; page++) {
+
+        if (dirty[page >> 6] >> (page & 63) & 1) {
+            batch.write(0, c64.mem.ram + 256 * page, (u16)(256 * page), 256);
+        }
+    }
+    batch.importRegisters(0, c64);
+}
+
+void
+CPUDiff::run(const string &path, u64 instructions)
+{
+    Result result;
+    result.name = extractFileName(path);
+
+    try {
+
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) throw VC64Error(ERROR_FILE_NOT_FOUND);
+
+        std::vector<u8> prg(streamLength(in));
+        if (!in.read((char *)prg.data(), prg.size())) throw VC64Error(ERROR_FILE_CANT_READ);
+
+        std::unique_ptr<C64> c64(vc64_new());
+        setup(*c64, prg);
+        compare(*c64, instructions, result);
+        measure(prg, result);
+
+    } catch (VC64Error &exception) {
+
+        result.status = string("ERROR_") + ErrorCodeEnum::key(exception.errorCode);
+    }
+
+    results.push_back(result);
+}
+
+void
+CPUDiff::runDecimal()
+{
+    Result result;
+    result.name = "DECIMAL";
+    result.status = "PASS";
+
+    std::unique_ptr<C64> c64(vc64_new());
+    std::vector<u8> prg = { 0x00, 0x10, 0x00, 0x00 };
+    setup(*c64, prg);
+
+    u64 t0 = Oscillator::nanos();
+
+    for (isize i = 0; i < 2 * 256 * 256 * 2 && result.mismatch.empty(); i++) {
+
+        u8 opcode = (i & 1) ? 0xE9 : 0x69;
+        u8 a = (u8)(i >> 1);
+        u8 op = (u8)(i >> 9);
+        u8 p = D_FLAG | ((i >> 17) ? C_FLAG : 0);
+
+        // Execute ADC #op or SBC #op
+        c64->mem.ram[0x1000] = opcode;
+        c64->mem.ram[0x1001] = op;
+        c64->cpu.reg.a = a;
+        c64->cpu.setPWithoutB(p);
+        c64->cpu.jumpToAddress(0x1000);
+        step(*c64);
+        result.instructions++;
+
+        // Compute the expected values
+        u8 a2 = a, p2 = p;
+        (i & 1) ? sbcDecimal(a2, op, p2) : adcDecimal(a2, op, p2);
+
+        u8 p1 = c64->cpu.getPWithClearedB() & 0xCF;
+        if (c64->cpu.reg.a != a2 || p1 != p2) {
+
+            result.status = "MISMATCH";
+            result.mismatch = string((i & 1) ? "SBC " : "ADC ") + hex(op, 2) +
+            " with A=" + hex(a, 2) + " C=" + std::to_string((p & C_FLAG) ? 1 : 0) +
+            ": A=" + hex(c64->cpu.reg.a, 2) + " P=" + hex(p1, 2) + " (micro-op) vs " +
+            "A=" + hex(a2, 2) + " P=" + hex(p2, 2) + " (reference)";
+        }
+    }
+
+    double seconds = (Oscillator::nanos() - t0) / 1000000000.0;
+    result.scalarSpeed = seconds > 0 ? result.instructions / seconds : 0;
+
+    results.push_back(result);
+}
+
+void
+CPUDiff::setup(C64 &c64, const std::vector<u8> &prg)
+{
+    // Interrupt handler calling the IRQ or BRK vector of the Kernal
+    const u8 irq[] = {
+        0x48,               // PHA
+        0x8A,               // TXA
+        0x48,               // PHA
+        0x98,               // TYA
+        0x48,               // PHA
+        0xBA,               // TSX
+        0xBD, 0x04, 0x01,   // LDA $0104,X
+        0x29, 0x10,         // AND #$10
+        0xF0, 0x03,         // BEQ irq
+        0x6C, 0x16, 0x03,   // JMP ($0316)
+        0x6C, 0x14, 0x03 }; // irq: JMP ($0314)
+
+    const u8 getin[] = {
+        0xA9, 0x03,         // LDA #$03
+        0x60 };             // RTS
+
+    if (prg.size() < 3) throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+
+    u16 load = LO_HI(prg[0], prg[1]);
+    usize size = MIN(prg.size() - 2, (usize)(0x10000 - load));
+
+    // Map RAM into the whole address space and copy the program
+    memset(c64.mem.ram, 0, sizeof(c64.mem.ram));
+    c64.mem.poke(0x0001, 0x34);
+    memcpy(c64.mem.ram + load, prg.data() + 2, size);
+
+    // Take the start address from the SYS statement of the Basic stub
+    u16 start = load;
+    for (usize i = 2; i < MIN(prg.size(), (usize)32); i++) {
+
+        if (prg[i] != 0x9E) continue;
+
+        u32 addr = 0;
+        usize j = i + 1;
+        while (j < prg.size() && prg[j] == ' ') j++;
+        while (j < prg.size() && isdigit(prg[j]) && addr <= 0xFFFF) addr = 10 * addr + prg[j++] - '0';
+        if (addr <= 0xFFFF && j > i + 1) start = (u16)addr;
+        break;
+    }
+
+    // Set up the environment expected by the Lorenz test suite
+    c64.mem.ram[0x0002] = 0x00;
+    c64.mem.ram[0xA002] = 0x00;
+    c64.mem.ram[0xA003] = 0x80;
+    c64.mem.ram[0x01FE] = 0xFF;
+    c64.mem.ram[0x01FF] = 0x7F;
+    c64.mem.ram[0xFFFE] = 0x48;
+    c64.mem.ram[0xFFFF] = 0xFF;
+    c64.mem.ram[0xFFD2] = 0x60;
+    memcpy(c64.mem.ram + 0xFF48, irq, sizeof(irq));
+    memcpy(c64.mem.ram + 0xFFE4, getin, sizeof(getin));
+
+    u64 dirty[4];
+    c64.mem.takeDirtyPages(dirty);
+
+    // Release the RDY line and start the program
+    c64.cpu.reset();
+    c64.cpu.reg.a = 0;
+    c64.cpu.reg.x = 0;
+    c64.cpu.reg.y = 0;
+    c64.cpu.reg.sp = 0xFD;
+    c64.cpu.setPWithoutB(0x04);
+    c64.cpu.jumpToAddress(start);
+}
+
+void
+CPUDiff::compare(C64 &c64, u64 instructions, Result &result)
+{
+    BatchCPU batch(1);
+    batch.importLane(0, c64);
+
+    std::vector<u8> lane(0x10000);
+    u64 dirty[4];
+
+    // Compares the marked pages of both cores
+    auto comparePages = [&](u16 pc, const u64 *pages) {
+
+        for (isize page = 0; page < 256; page++) {
+
+            if (!(pages[page >> 6] >> (page & 63) & 1)) continue;
+
+            batch.read(0, lane.data() + 256 * page, (u16)(256 * page), 256);
+            for (isize addr = MAX(256 * page, (isize)2); addr < 256 * (page + 1); addr++) {
+
+                if (c64.mem.ram[addr] == lane[addr]) continue;
+
+                result.mismatch = hex(pc, 4) + ": RAM " + hex((u32)addr, 4) + " = " +
+                hex(c64.mem.ram[addr], 2) + " (micro-op) vs " + hex(lane[addr], 2) + " (batch)";
+                return false;
+            }
+        }
+        return true;
+    };
+
+    result.status = "TIMEOUT";
+
+    while (true) {
+
+        u16 pc = c64.cpu.getPC0();
+
+        if (const char *status = trap(pc)) { result.status = status; break; }
+        if (result.instructions == instructions) break;
+        if (pc == 0xFFD2) print(result.output, c64.cpu.reg.a);
+
+        u64 cycles = step(c64);
+        if (!cycles) { result.status = "JAM"; break; }
+        result.instructions++;
+
+        u64 batchCycles = batch.getCycles(0);
+        batch.run(1);
+        batchCycles = batch.getCycles(0) - batchCycles;
+        c64.mem.takeDirtyPages(dirty);
+
+        if (batch.getState(0) == LANE_DIVERGED) {
+
+            sync(batch, c64, dirty);
+            result.delegated++;
+            continue;
+        }
+
+        // Compare the registers (B and the unused bit are not stored in P)
+        u8 p1 = c64.cpu.getPWithClearedB() & 0xCF;
+        u8 p2 = batch.getP(0) & 0xCF;
+
+        if (c64.cpu.getPC0() != batch.getPC(0) ||
+            c64.cpu.reg.a != batch.getA(0) ||
+            c64.cpu.reg.x != batch.getX(0) ||
+            c64.cpu.reg.y != batch.getY(0) ||
+            c64.cpu.reg.sp != batch.getSP(0) || p1 != p2) {
+
+            auto registers = [](u16 pc, u8 a, u8 x, u8 y, u8 sp, u8 p) {
+                return "PC=" + hex(pc, 4) + " A=" + hex(a, 2) + " X=" + hex(x, 2) +
+                " Y=" + hex(y, 2) + " SP=" + hex(sp, 2) + " P=" + hex(p, 2);
+            };
+            result.mismatch = hex(pc, 4) + ": " +
+            registers(c64.cpu.getPC0(), c64.cpu.reg.a, c64.cpu.reg.x,
+                      c64.cpu.reg.y, c64.cpu.reg.sp, p1) + " (micro-op) vs " +
+            registers(batch.getPC(0), batch.getA(0), batch.getX(0),
+                      batch.getY(0), batch.getSP(0), p2) + " (batch)";
+            break;
+        }
+
+        // Compare the cycle counts
+        if (cycles != batchCycles) {
+
+            result.mismatch = hex(pc, 4) + ": " + std::to_string(cycles) +
+            " cycles (micro-op) vs " + std::to_string(batchCycles) + " cycles (batch)";
+            break;
+        }
+
+        // Compare the written pages and, from time to time, the whole RAM
+        if (!comparePages(pc, dirty)) break;
+        if (result.instructions % fullCompareInterval == 0 && !comparePages(pc, allPages)) break;
+    }
+
+    if (result.mismatch.empty()) comparePages(c64.cpu.getPC0(), allPages);
+    if (!result.mismatch.empty()) result.status = "MISMATCH";
+}
+
+void
+CPUDiff::measure(const std::vector<u8> &prg, Result &result)
+{
+    u64 instructions = result.instructions;
+    if (instructions == 0) return;
+
+    std::unique_ptr<C64> c64(vc64_new());
+    u64 dirty[4];
+
+    // Run the micro-op CPU
+    setup(*c64, prg);
+    u64 t0 = Oscillator::nanos();
+
+    for (u64 i = 0; i < instructions; i++) if (!step(*c64)) break;
+
+    double seconds = (Oscillator::nanos() - t0) / 1000000000.0;
+    result.scalarSpeed = seconds > 0 ? instructions / seconds : 0;
+
+    // Run the batch engine (diverging instructions are left to the micro-op CPU)
+    setup(*c64, prg);
+    BatchCPU batch(1);
+    batch.importLane(0, *c64);
+    t0 = Oscillator::nanos();
+
+    for (u64 i = 0; i < instructions;) {
+
+        u64 steps = batch.getStats().steps;
+        batch.run(instructions - i);
+        i += batch.getStats().steps - steps;
+
+        if (batch.getState(0) == LANE_DIVERGED) {
+
+            batch.exportLane(0, *c64);
+            c64->mem.takeDirtyPages(dirty);
+            if (!step(*c64)) break;
+            c64->mem.takeDirtyPages(dirty);
+            sync(batch, *c64, dirty);
+        }
+    }
+
+    seconds = (Oscillator::nanos() - t0) / 1000000000.0;
+    result.batchSpeed = seconds > 0 ? instructions / seconds : 0;
+}
+
+void
+CPUDiff::writeToFile(const string &path) const
+{
+    std::ofstream out(path);
+    if (!out.is_open()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+
+    out << std::fixed;
+
+    for (auto &result : results) {
+
+        // Put the output on a single line
+        string output = result.output;
+        for (auto &c : output) if (c == '\n' || c == '\t') c = ' ';
+
+        out << result.name << '\t';
+        out << result.status << '\t';
+        out << result.instructions << '\t';
+        out << result.delegated << '\t';
+        out << std::setprecision(0) << result.scalarSpeed << '\t';
+        out << std::setprecision(0) << result.batchSpeed << '\t';
+        out << result.mismatch << '\t';
+        out << output << '\n';
+    }
+
+    if (!out.good()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+}
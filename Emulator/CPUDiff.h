@@ -0,0 +1,134 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Object.h"
+#include "C64Types.h"
+
+/* Runs the micro-op CPU and the batch engine (see BatchCPU) in lockstep on
+ * the same memory image and compares both cores after every instruction. A
+ * mismatch is reported if the registers or the number of elapsed cycles
+ * differ, or if a page written by the micro-op CPU holds different values in
+ * the batch engine. All other pages are compared periodically and when the
+ * program has ended. The processor port ($00 and $01) is excluded, because
+ * the batch engine treats it as plain RAM.
+ *
+ * The batch engine leaves illegal opcodes and decimal mode arithmetic to the
+ * scalar CPU. These instructions are executed by the micro-op CPU alone and
+ * the lane is synchronized afterwards.
+ *
+ * Programs are loaded from PRG files and run in a flat RAM image. The start
+ * address is taken from the SYS statement of the Basic stub (the load address
+ * is used if there is none). The Kernal is replaced by the traps used to run
+ * the test suites of Wolfgang Lorenz:
+ *
+ *   $FFD2         CHROUT. The character in A is appended to the output.
+ *   $FFE4         GETIN. Returns 3 (RUN/STOP) in A.
+ *   $E16F         LOAD. The program has passed.
+ *   $8000, $A474  The program has failed.
+ *
+ * In addition, the decimal mode of ADC and SBC is checked exhaustively. The
+ * micro-op CPU computes the BCD digits with lookup tables. For each
+ * combination of accumulator, operand, and carry, its result and flags are
+ * compared with a reference implementation of the original per-digit
+ * algorithm. The check is reported as a program named DECIMAL.
+ *
+ * After the comparison, each core runs the program on its own for the same
+ * number of instructions to measure its speed. The report is stored as a
+ * text file. Each program is described by a line of tab separated values
+ * (program, status, instructions, instructions left to the micro-op CPU,
+ * micro-op instructions per second, batch instructions per second, first
+ * mismatch, output).
+ */
+class CPUDiff : C64Object {
+
+public:
+
+    struct Result {
+
+        string name;
+
+        // PASS, FAIL, MISMATCH, JAM, TIMEOUT, or an error description
+        string status;
+
+        // Instructions executed in lockstep
+        u64 instructions = 0;
+
+        // Instructions the batch engine has left to the micro-op CPU
+        u64 delegated = 0;
+
+        // Measured speeds in instructions per second
+        double scalarSpeed = 0.0;
+        double batchSpeed = 0.0;
+
+        // Description of the first mismatch (empty if there is none)
+        string mismatch;
+
+        // Text printed by the program
+        string output;
+    };
+
+private:
+
+    // Results of the most recent runs
+    std::vector<Result> results;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    const char *getDescription() const override { return "CPUDiff"; }
+
+
+    //
+    // Running
+    //
+
+public:
+
+    // Compares both cores on a program and appends the result
+    void run(const string &path, u64 instructions);
+
+    // Checks decimal mode arithmetic and appends the result
+    void runDecimal();
+
+private:
+
+    // Reads a PRG file and sets up a flat RAM image in the specified instance
+    void setup(class C64 &c64, const std::vector<u8> &prg) throws;
+
+    // Runs both cores in lockstep
+    void compare(class C64 &c64, u64 instructions, Result &result);
+
+    // Runs each core on its own
+    void measure(const std::vector<u8> &prg, Result &result);
+
+
+    //
+    // Querying
+    //
+
+public:
+
+    usize count() const { return results.size(); }
+    const Result &operator[](usize nr) const { return results[nr]; }
+
+
+    //
+    // Saving
+    //
+
+public:
+
+    void writeToFile(const string &path) const throws;
+};
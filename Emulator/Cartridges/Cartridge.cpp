@@ -8,6 +8,10 @@
 // -----------------------------------------------------------------------------
 
 #include "C64.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 bool
 Cartridge::isSupportedType(CartridgeType type)
@@ -54,6 +58,7 @@ Cartridge::isSupportedType(CartridgeType type)
         case CRT_PAGEFOX:
         case CRT_KINGSOFT:
             
+        case CRT_REU:
         case CRT_ISEPIC:
         case CRT_GEO_RAM:
             return true;
@@ -77,6 +82,48 @@ Cartridge::isROMHaddr (u16 addr)
     return (addr >= 0xA000 && addr <= 0xBFFF) || (addr >= 0xE000 && addr <= 0xFFFF);
 }
 
+const char *
+Cartridge::className(CartridgeType type)
+{
+    switch (type) {
+            
+        case CRT_NORMAL:           return "Cartridge";
+        case CRT_ACTION_REPLAY:    return "ActionReplay";
+        case CRT_KCS_POWER:        return "KcsPower";
+        case CRT_FINAL_III:        return "FinalIII";
+        case CRT_SIMONS_BASIC:     return "SimonsBasic";
+        case CRT_OCEAN:            return "Ocean";
+        case CRT_EXPERT:           return "Expert";
+        case CRT_FUNPLAY:          return "Funplay";
+        case CRT_SUPER_GAMES:      return "SuperGames";
+        case CRT_ATOMIC_POWER:     return "AtomicPower";
+        case CRT_EPYX_FASTLOAD:    return "Epyx";
+        case CRT_WESTERMANN:       return "Westermann";
+        case CRT_REX:              return "Rex";
+        case CRT_WARPSPEED:        return "WarpSpeed";
+        case CRT_DINAMIC:          return "Dinamic";
+        case CRT_ZAXXON:           return "Zaxxon";
+        case CRT_MAGIC_DESK:       return "MagicDesk";
+        case CRT_COMAL80:          return "Comal80";
+        case CRT_STRUCTURED_BASIC: return "StructuredBasic";
+        case CRT_MIKRO_ASS:        return "MikroAss";
+        case CRT_STARDOS:          return "StarDos";
+        case CRT_EASYFLASH:        return "EasyFlash";
+        case CRT_ACTION_REPLAY3:   return "ActionReplay3";
+        case CRT_GAME_KILLER:      return "GameKiller";
+        case CRT_FREEZE_FRAME:     return "FreezeFrame";
+        case CRT_MACH5:            return "Mach5";
+        case CRT_PAGEFOX:          return "PageFox";
+        case CRT_KINGSOFT:         return "Kingsoft";
+        case CRT_REU:              return "REU";
+        case CRT_ISEPIC:           return "Isepic";
+        case CRT_GEO_RAM:          return "GeoRAM";
+            
+        default:
+            return nullptr;
+    }
+}
+
 Cartridge *
 Cartridge::makeWithType(C64 &c64, CartridgeType type)
 {
@@ -110,6 +157,7 @@ Cartridge::makeWithType(C64 &c64, CartridgeType type)
         case CRT_MACH5:            return new Mach5(c64);
         case CRT_PAGEFOX:          return new PageFox(c64);
         case CRT_KINGSOFT:         return new Kingsoft(c64);
+        case CRT_REU:              return new REU(c64);
         case CRT_ISEPIC:           return new Isepic(c64);
         case CRT_GEO_RAM:          return new GeoRAM(c64);
             
@@ -149,6 +197,7 @@ Cartridge::Cartridge(C64 &ref) : C64Component(ref)
 Cartridge::~Cartridge()
 {
     trace(CRT_DEBUG, "Releasing cartridge...\n");
+    unmapRam();
     dealloc();
 }
 
@@ -161,7 +210,8 @@ Cartridge::dealloc()
         packet[i] = nullptr;
     }
     
-    if (externalRam) {
+    // A mapped file is kept (see takeRamFile())
+    if (externalRam && !isRamMapped()) {
         assert(ramCapacity > 0);
         delete [] externalRam;
         externalRam = nullptr;
@@ -203,6 +253,34 @@ Cartridge::resetWithoutDeletingRam()
     memcpy(mem.ram, ram, 0x10000);
 }
 
+void
+Cartridge::_memoryUsage(MemoryUsage &usage)
+{
+    for (isize i = 0; i < numPackets; i++) {
+        
+        usage.heapBytes += sizeof(CartridgeRom);
+        
+        // Roms with the same contents are shared by all instances (see RomPool)
+        if (packet[i]->data.use_count() > 1) {
+            usage.sharedBytes += packet[i]->size;
+        } else {
+            usage.heapBytes += packet[i]->size;
+        }
+    }
+    
+    // Unmodified pages of a file-backed RAM are shared with the page cache
+    if (isRamMapped()) {
+        
+        usize dirty = std::count(ramDirty.begin(), ramDirty.end(), 1);
+        usage.heapBytes += dirty * ramPageSize;
+        usage.sharedBytes += ramCapacity - dirty * ramPageSize;
+        
+    } else {
+        
+        usage.heapBytes += ramCapacity;
+    }
+}
+
 void
 Cartridge::_dump() const
 {
@@ -236,7 +314,7 @@ Cartridge::_size()
         packetSize += packet[i]->_size();
     }
     
-    return ramCapacity + packetSize + counter.count;
+    return ramSize() + packetSize + counter.count;
 }
 
 usize
@@ -260,11 +338,7 @@ Cartridge::_load(u8 *buffer)
     }
 
     // Load on-board RAM
-    if (ramCapacity) {
-        assert(externalRam == nullptr);
-        externalRam = new u8[ramCapacity];
-        for (unsigned i = 0; i < ramCapacity; i++) externalRam[i] = read8(reader.ptr);
-    }
+    loadRam(reader);
 
     trace(SNP_DEBUG, "Recreated from %ld bytes\n", reader.ptr - buffer);
     return reader.ptr - buffer;
@@ -288,15 +362,131 @@ Cartridge::_save(u8 *buffer)
     }
     
     // Save on-board RAM
-    if (ramCapacity) {
-        assert(externalRam != nullptr);
-        for (unsigned i = 0; i < ramCapacity; i++) write8(writer.ptr, externalRam[i]);
-    }
+    saveRam(writer);
     
     trace(SNP_DEBUG, "Serialized %ld bytes\n", writer.ptr - buffer);
     return writer.ptr - buffer;
 }
 
+u64
+Cartridge::_hash()
+{
+    SerHasher hasher;
+    applyToPersistentItems(hasher);
+    applyToResetItems(hasher);
+    
+    // Hash ROM packets
+    for (unsigned i = 0; i < numPackets; i++) {
+        assert(packet[i] != nullptr);
+        hasher.hash = fnv_1a_it64(hasher.hash, packet[i]->_hash());
+    }
+    
+    // Hash on-board RAM
+    hashRam(hasher);
+    
+    return hasher.hash;
+}
+
+usize
+Cartridge::ramSize() const
+{
+    if (ramBase == 0) return ramCapacity;
+    
+    // Path of the backing file, dirty page flags, and dirty pages
+    usize dirty = std::count(ramDirty.begin(), ramDirty.end(), 1);
+    return 2 + ramPath.size() + ramDirty.size() + dirty * ramPageSize;
+}
+
+void
+Cartridge::loadRam(SerReader &reader)
+{
+    // Check if the snapshot contains the full RAM
+    if (ramBase == 0) {
+        
+        unmapRam();
+        if (ramCapacity) {
+            
+            externalRam = new u8[ramCapacity];
+            reader.copy(externalRam, ramCapacity);
+        }
+        return;
+    }
+    
+    u64 base = ramBase;
+    u16 length;
+    reader & length;
+    string path(length, ' ');
+    reader.copy(path.data(), length);
+    
+    // Make sure the RAM is mapped from the file the snapshot refers to
+    if (!isRamMapped() || mappedBase != base || mappedSize() != ramCapacity) {
+        
+        unmapRam();
+        try { mapRam(path, ramCapacity); } catch (VC64Error &) { }
+        
+        if (!isRamMapped()) {
+            
+            warn("Can't map %s. RAM contents are incomplete\n", path.c_str());
+            externalRam = new u8[ramCapacity];
+            memset(externalRam, 0xFF, ramCapacity);
+            ramDirty.assign(ramCapacity / ramPageSize, 0);
+            
+        } else if (mappedBase != base) {
+            
+            warn("%s has been modified. RAM contents are incomplete\n", path.c_str());
+        }
+    }
+    
+    // Revert the pages modified after the snapshot has been taken
+    for (usize i = 0; isRamMapped() && i < ramDirty.size(); i++) {
+        if (ramDirty[i]) revertPage(i);
+    }
+    
+    // Restore the pages modified before the snapshot has been taken
+    reader.copy(ramDirty.data(), ramDirty.size());
+    for (usize i = 0; i < ramDirty.size(); i++) {
+        if (ramDirty[i]) reader.copy(externalRam + i * ramPageSize, ramPageSize);
+    }
+    
+    // From now on, the RAM refers to the mapped file (if any)
+    ramBase = mappedBase;
+    if (!isRamMapped()) ramDirty.clear();
+}
+
+void
+Cartridge::saveRam(SerWriter &writer)
+{
+    if (ramBase == 0) {
+        
+        if (ramCapacity) writer.copy(externalRam, ramCapacity);
+        return;
+    }
+    
+    u16 length = (u16)ramPath.size();
+    writer & length;
+    writer.copy(ramPath.data(), length);
+    
+    writer.copy(ramDirty.data(), ramDirty.size());
+    for (usize i = 0; i < ramDirty.size(); i++) {
+        if (ramDirty[i]) writer.copy(externalRam + i * ramPageSize, ramPageSize);
+    }
+}
+
+void
+Cartridge::hashRam(SerHasher &hasher)
+{
+    if (ramBase == 0) {
+        
+        if (ramCapacity) hasher.copy(externalRam, ramCapacity);
+        return;
+    }
+    
+    hasher.copy(ramDirty.data(), ramDirty.size());
+    for (usize i = 0; i < ramDirty.size(); i++) {
+        if (ramDirty[i]) hasher.copy(externalRam + i * ramPageSize, ramPageSize);
+    }
+}
+
 u8
 Cartridge::peek(u16 addr)
 {
@@ -312,6 +502,36 @@ Cartridge::peek(u16 addr)
     }
 }
 
+const u8 *
+Cartridge::mappedPage(u8 page) const
+{
+    u16 addr = page << 8;
+    u16 relAddr = addr & 0x1FFF;
+    u8 chip;
+    u16 mapped, offset;
+
+    if (!hasPlainRom()) return nullptr;
+
+    if (isROMLaddr(addr)) {
+        chip = chipL; mapped = mappedBytesL; offset = offsetL;
+    } else if (isROMHaddr(addr)) {
+        chip = chipH; mapped = mappedBytesH; offset = offsetH;
+    } else {
+        return nullptr;
+    }
+
+    // RAM shines through if no ROM is mapped in
+    if (relAddr >= mapped) return mem.ram + addr;
+
+    // Partially mapped pages are accessed via peek()
+    if (relAddr + 0x100 > mapped) return nullptr;
+
+    if (chip >= numPackets || packet[chip] == nullptr) return nullptr;
+    if (offset + relAddr + 0x100 > packet[chip]->size) return nullptr;
+
+    return packet[chip]->rom + offset + relAddr;
+}
+
 u8
 Cartridge::peekRomL(u16 addr)
 {
@@ -398,11 +618,16 @@ void
 Cartridge::setRamCapacity(usize size)
 {
     // Free
+    if (isRamMapped()) {
+        unmapRam();
+        ramCapacity = 0;
+    }
     if (getRamCapacity() > 0) {
         delete [] externalRam;
         ramCapacity = 0;
         externalRam = nullptr;
     }
+    ramBase = 0;
     
     // Allocate
     if (size > 0) {
@@ -410,20 +635,23 @@ Cartridge::setRamCapacity(usize size)
         ramCapacity = (u64)size;
         memset(externalRam, 0xFF, size);
     }
+    markDirty();
 }
 
 u8
-Cartridge::peekRAM(u16 addr) const
+Cartridge::peekRAM(u32 addr) const
 {
     assert(addr < ramCapacity);
     return externalRam[addr];
 }
 
 void
-Cartridge::pokeRAM(u16 addr, u8 value)
+Cartridge::pokeRAM(u32 addr, u8 value)
 {
     assert(addr < ramCapacity);
     externalRam[addr] = value;
+    if (isRamMapped()) ramDirty[addr / ramPageSize] = 1;
+    markDirty();
 }
 
 void
@@ -431,6 +659,109 @@ Cartridge::eraseRAM(u8 value)
 {
     assert(externalRam != nullptr);
     memset(externalRam, value, ramCapacity);
+    if (isRamMapped()) ramDirty.assign(ramDirty.size(), 1);
+    markDirty();
+}
+
+void
+Cartridge::mapRam(const string &path, usize size)
+{
+    assert(size > 0 && size % ramPageSize == 0);
+    
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) throw VC64Error(ERROR_FILE_CANT_CREATE);
+    
+    // Extend the file if it is too small
+    struct stat info;
+    if (fstat(fd, &info) != 0 ||
+        ((usize)info.st_size < size && ftruncate(fd, (off_t)size) != 0)) {
+        
+        close(fd);
+        throw VC64Error(ERROR_FILE_CANT_WRITE);
+    }
+    
+    // Writing to a private mapping copies the affected pages
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        
+        close(fd);
+        throw VC64Error(ERROR_FILE_CANT_READ);
+    }
+    
+    setRamCapacity(0);
+    externalRam = (u8 *)mapping;
+    ramCapacity = (u64)size;
+    ramFile = fd;
+    ramPath = path;
+    ramDirty.assign(size / ramPageSize, 0);
+    
+    // The fingerprint is never 0 which stands for a fully serialized RAM
+    mappedBase = ramBase = fnv_1a_64(externalRam, size) | 1;
+    battery = true;
+    markDirty();
+    
+    debug(CRT_DEBUG, "Mapped %zu KB from %s\n", size / 1024, path.c_str());
+}
+
+void
+Cartridge::unmapRam()
+{
+    if (!isRamMapped()) return;
+    
+    // Write the modified pages back
+    for (usize i = 0; i < ramDirty.size(); i++) {
+        
+        if (!ramDirty[i]) continue;
+        
+        off_t offset = (off_t)(i * ramPageSize);
+        if (pwrite(ramFile, externalRam + offset, ramPageSize, offset) != (ssize_t)ramPageSize) {
+            warn("Failed to write back page %zu of %s\n", i, ramPath.c_str());
+        }
+    }
+    
+    munmap(externalRam, mappedSize());
+    close(ramFile);
+    
+    externalRam = nullptr;
+    ramFile = -1;
+    ramPath.clear();
+    ramDirty.clear();
+    mappedBase = 0;
+}
+
+void
+Cartridge::revertPage(usize nr)
+{
+    assert(isRamMapped() && nr < ramDirty.size());
+    
+    off_t offset = (off_t)(nr * ramPageSize);
+    if (pread(ramFile, externalRam + offset, ramPageSize, offset) != (ssize_t)ramPageSize) {
+        warn("Failed to restore page %zu of %s\n", nr, ramPath.c_str());
+    }
+    ramDirty[nr] = 0;
+}
+
+void
+Cartridge::takeRamFile(Cartridge &other)
+{
+    if (!other.isRamMapped()) return;
+    assert(!isRamMapped() && externalRam == nullptr);
+    
+    externalRam = other.externalRam;
+    ramCapacity = other.ramCapacity;
+    ramFile = other.ramFile;
+    ramPath = std::move(other.ramPath);
+    mappedBase = other.mappedBase;
+    ramBase = other.ramBase;
+    ramDirty = std::move(other.ramDirty);
+    
+    other.externalRam = nullptr;
+    other.ramCapacity = 0;
+    other.ramFile = -1;
+    other.ramPath.clear();
+    other.ramDirty.clear();
+    other.mappedBase = 0;
+    other.ramBase = 0;
 }
 
 void
@@ -487,6 +818,9 @@ Cartridge::bankInROML(unsigned nr, u16 size, u16 offset)
     chipL = nr;
     mappedBytesL = size;
     offsetL = offset;
+
+    expansionport.countBankSwitch();
+    mem.updatePageTables();
 }
 
 void
@@ -495,6 +829,9 @@ Cartridge::bankInROMH(unsigned nr, u16 size, u16 offset)
     chipH = nr;
     mappedBytesH = size;
     offsetH = offset;
+
+    expansionport.countBankSwitch();
+    mem.updatePageTables();
 }
 
 void
@@ -546,11 +883,14 @@ Cartridge::bankOut(unsigned nr)
         mappedBytesH = 0;
         offsetH = 0;
     }
+    expansionport.countBankSwitch();
+    mem.updatePageTables();
 }
 
 void
 Cartridge::setSwitch(i8 pos)
 {
     switchPos = pos;
+    markDirty();
     c64.putMessage(MSG_CART_SWITCH);
 }
@@ -81,6 +81,26 @@ private:
     
     // Indicates whether RAM data is preserved during a reset
     bool battery = false;
+    
+    /* Backing file of the on-board RAM (-1 = none). The file is mapped
+     * privately. Hence, it keeps its contents while the cartridge is in use.
+     * The modified pages are written back when the file is released.
+     */
+    int ramFile = -1;
+    string ramPath;
+    
+    // Fingerprint of the file contents the RAM has been mapped from
+    u64 mappedBase = 0;
+    
+    /* Fingerprint of the file contents the RAM refers to. If this value is 0,
+     * the RAM is serialized completely. Otherwise, snapshots only contain the
+     * pages that differ from the backing file.
+     */
+    u64 ramBase = 0;
+    
+    // Pages of a file-backed RAM that differ from the backing file
+    static constexpr usize ramPageSize = 4096;
+    std::vector<u8> ramDirty;
 
     
     //
@@ -123,6 +143,12 @@ public:
     static bool isROMLaddr(u16 addr);
     static bool isROMHaddr(u16 addr);
 
+    /* Returns the name of the class emulating a cartridge type (nullptr if
+     * the type is unsupported). The name matches the type of the object
+     * created by makeWithType().
+     */
+    static const char *className(CartridgeType type);
+
     // Factory methods
     static Cartridge *makeWithType(C64 &c64, CartridgeType type) throws;
     static Cartridge *makeWithCRTFile(C64 &c64, CRTFile &file) throws;
@@ -184,6 +210,7 @@ private:
         & numPackets
         & ramCapacity
         & battery
+        & ramBase
         & control
         & switchPos;
     }
@@ -205,8 +232,19 @@ private:
 protected:
     
     usize _size() override;
+    usize _objectSize() const override { return sizeof(*this); }
+    void _memoryUsage(MemoryUsage &usage) override;
     usize _load(u8 *buffer) override;
     usize _save(u8 *buffer) override;
+    u64 _hash() override;
+    
+private:
+    
+    // Serializes the on-board RAM
+    usize ramSize() const;
+    void loadRam(SerReader &reader);
+    void saveRam(SerWriter &writer);
+    void hashRam(SerHasher &hasher);
         
         
     //
@@ -227,6 +265,15 @@ public:
     // Reads in a chip packet from a CRT file
     virtual void loadChip(unsigned nr, const CRTFile &c);
     
+    /* Writes modified chip packets back into the CRT file the cartridge has
+     * been created from. Only the packets containing modified data are
+     * updated. If the CRT file has been read from disk, these packets are
+     * overwritten in place in the file on disk, too. Cartridges without
+     * writable chips leave the file untouched. Returns the number of updated
+     * packets.
+     */
+    virtual isize writeBack(CRTFile &crt) throws { return 0; }
+    
     // Banks in a rom chip into the ROML or the ROMH space
     void bankInROML(unsigned nr, u16 size, u16 offset);
     void bankInROMH(unsigned nr, u16 size, u16 offset);
@@ -257,6 +304,18 @@ public:
     virtual u8 spypeekRomL(u16 addr) const;
     virtual u8 spypeekRomH(u16 addr) const;
 
+    /* Indicates whether ROM reads are free of side effects and can bypass
+     * peek(). Cartridges overriding peek(), peekRomL(), or peekRomH() must
+     * return false.
+     */
+    virtual bool hasPlainRom() const { return getCartridgeType() == CRT_NORMAL; }
+
+    /* Returns a pointer to the 256 bytes that are currently visible in the
+     * specified ROML or ROMH page. nullptr is returned if the page needs to
+     * be accessed via peek().
+     */
+    const u8 *mappedPage(u8 page) const;
+
     virtual void poke(u16 addr, u8 value);
     virtual void pokeRomL(u16 addr, u8 value) { return; }
     virtual void pokeRomH(u16 addr, u8 value) { return; }
@@ -289,12 +348,46 @@ public:
     bool getBattery() const { return battery; }
 
     // Enables or disables persistent RAM
-    void setBattery(bool value) { battery = value; }
+    void setBattery(bool value) { battery = value; markDirty(); }
 
     // Reads or write RAM cells
-    u8 peekRAM(u16 addr) const;
-    void pokeRAM(u16 addr, u8 value);
+    u8 peekRAM(u32 addr) const;
+    void pokeRAM(u32 addr, u8 value);
     void eraseRAM(u8 value);
+    
+    /* Maps the on-board RAM from a file. The file is created or extended if
+     * it is smaller than the requested size. The RAM contents are preserved
+     * during a reset and written back when the file is released.
+     */
+    void mapRam(const string &path, usize size) throws;
+    
+    // Returns true if the on-board RAM is backed by a file
+    bool isRamMapped() const { return ramFile >= 0; }
+    
+    /* Takes over the backing file of another cartridge. This function is
+     * called before a snapshot is restored to keep the file base stable.
+     */
+    void takeRamFile(Cartridge &other);
+    
+private:
+    
+    // Returns the size of the mapped file region in bytes
+    usize mappedSize() const { return ramDirty.size() * ramPageSize; }
+    
+    // Writes the modified pages back and releases the backing file
+    void unmapRam();
+    
+    // Restores a page of a file-backed RAM from the backing file
+    void revertPage(usize nr);
+    
+protected:
+    
+    /* Provides direct access to the on-board RAM (used for block transfers).
+     * Writes through this pointer are not tracked for file-backed RAM.
+     */
+    u8 *getRam() { return externalRam; }
+
+public:
 
     
     //
@@ -351,7 +444,7 @@ public:
     virtual bool getLED() const { return led; }
     
     // Switches the LED on or off
-    virtual void setLED(bool value) { led = value; }
+    virtual void setLED(bool value) { led = value; markDirty(); }
     
     
     //
@@ -371,4 +464,7 @@ public:
     
     // Called after the C64 CPU has processed the NMI instruction
     virtual void nmiDidTrigger() { }
+    
+    // Called after the C64 CPU has written to $FF00 (if trapped by C64Memory)
+    virtual void didPokeFF00() { }
 };
@@ -73,6 +73,7 @@ enum_long(CRT_TYPE)
     CRT_EASYCALC = 59,
     CRT_GMOD2 = 60,
     
+    CRT_REU = 252,
     CRT_ISEPIC = 253,
     CRT_GEO_RAM = 254,
     CRT_NONE = 255
@@ -97,3 +98,28 @@ enum_long(FLASH_STATE)
     FLASH_COUNT
 };
 typedef FLASH_STATE FlashState;
+
+//
+// Structures
+//
+
+typedef struct
+{
+    // Number of times a chip has been banked in or out
+    u64 bankSwitches;
+    
+    // Accesses to the I/O areas
+    u64 io1Reads;
+    u64 io1Writes;
+    u64 io2Reads;
+    u64 io2Writes;
+    
+    // ROM reads dispatched to the cartridge (reads from mapped pages excluded)
+    u64 romlReads;
+    u64 romhReads;
+
+    // Virtual peek and poke calls
+    u64 peeks;
+    u64 pokes;
+}
+CartridgeStats;
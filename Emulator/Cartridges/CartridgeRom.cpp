@@ -17,16 +17,8 @@ CartridgeRom::CartridgeRom(C64 &ref, u16 size, u16 loadAddress, const u8 *buffer
 {
     this->size = size;
     this->loadAddress = loadAddress;
-    rom = new u8[size];
-    if (buffer) {
-        memcpy(rom, buffer, size);
-    }
-}
-
-CartridgeRom::~CartridgeRom()
-{
-    assert(rom);
-    delete[] rom;
+    data = buffer ? RomPool::share(buffer, size) : RomPool::share((u8)0, size);
+    rom = data.get();
 }
 
 void
@@ -52,12 +44,10 @@ CartridgeRom::_load(u8 *buffer)
     applyToPersistentItems(reader);
     applyToResetItems(reader);
     
-    // Delete the old packet and create a new one with the proper size
-    if (rom) delete[] rom;
-    rom = new u8[size];
-    
     // Read packet data
-    for (int i = 0; i < size; i++) rom[i] = read8(reader.ptr);
+    data = RomPool::share(reader.ptr, size);
+    rom = data.get();
+    reader.ptr += size;
 
     trace(SNP_DEBUG, "Recreated from %ld bytes\n", reader.ptr - buffer);
     return reader.ptr - buffer;
@@ -71,12 +61,23 @@ CartridgeRom::_save(u8 *buffer)
     applyToResetItems(writer);
 
     // Write packet data
-    for (int i = 0; i < size; i++) write8(writer.ptr, rom[i]);
+    writer.copy(rom, size);
 
     trace(SNP_DEBUG, "Serialized to %ld bytes\n", writer.ptr - buffer);
     return writer.ptr - buffer;
 }
 
+u64
+CartridgeRom::_hash()
+{
+    SerHasher hasher;
+    applyToPersistentItems(hasher);
+    applyToResetItems(hasher);
+    hasher.copy(rom, size);
+    
+    return hasher.hash;
+}
+
 bool
 CartridgeRom::mapsToL() const {
     assert(rom);
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "C64Component.h"
+#include "RomPool.h"
 
 class CartridgeRom : public C64Component {
     
@@ -17,8 +18,11 @@ class CartridgeRom : public C64Component {
     
 protected:
     
-    // Rom data
-    u8 *rom = nullptr;
+    /* Rom data. The data is immutable and shared with all other Roms of the
+     * same contents (see RomPool).
+     */
+    std::shared_ptr<const u8[]> data;
+    const u8 *rom = nullptr;
     
 public:
     
@@ -41,7 +45,6 @@ public:
     
     CartridgeRom(C64 &ref);
     CartridgeRom(C64 &ref, u16 _size, u16 _loadAddress, const u8 *buffer = nullptr);
-    ~CartridgeRom();
     const char *getDescription() const override { return "CartridgeRom"; }
 
 private:
@@ -70,8 +73,10 @@ private:
     }
     
     usize _size() override;
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buffer) override;
     usize _save(u8 *buffer) override;
+    u64 _hash() override;
 
     
     //
@@ -18,6 +18,7 @@ public:
     Comal80(C64 &ref) : Cartridge(ref) { };
     const char *getDescription() const override { return "Comal80"; }
     CartridgeType getCartridgeType() const override { return CRT_COMAL80; }
+    bool hasPlainRom() const override { return true; }
     
     void _reset() override;
 
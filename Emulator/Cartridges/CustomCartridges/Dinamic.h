@@ -18,6 +18,7 @@ public:
     Dinamic(C64 &ref) : Cartridge(ref) { };
     const char *getDescription() const override { return "Dinamic"; }
     CartridgeType getCartridgeType() const override { return CRT_DINAMIC; }
+    bool hasPlainRom() const override { return true; }
 
 private:
     
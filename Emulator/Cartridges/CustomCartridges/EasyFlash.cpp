@@ -91,6 +91,57 @@ EasyFlash::loadChip(unsigned nr, const CRTFile &crt)
     }
 }
 
+isize
+EasyFlash::writeBack(CRTFile &crt)
+{
+    std::fstream file;
+    if (!crt.path.empty()) {
+        
+        file.open(crt.path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!file.is_open()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+    }
+    
+    isize count = 0;
+    u64 savedL = 0, savedH = 0;
+    
+    for (unsigned nr = 0; nr < crt.chipCount(); nr++) {
+        
+        u16 chipBank = crt.chipBank(nr);
+        u16 chipAddr = crt.chipAddr(nr);
+        
+        if (crt.chipSize(nr) != 0x2000 || !FlashRom::isBankNumber(chipBank)) continue;
+        
+        FlashRom *rom;
+        u64 *saved;
+        if (isROMLaddr(chipAddr)) {
+            rom = &flashRomL; saved = &savedL;
+        } else if (isROMHaddr(chipAddr)) {
+            rom = &flashRomH; saved = &savedH;
+        } else {
+            continue;
+        }
+        if (!rom->isModified(chipBank)) continue;
+        
+        trace(CRT_DEBUG, "Writing back bank %d%c\n", chipBank, rom == &flashRomL ? 'L' : 'H');
+        rom->saveBank(chipBank, crt.chipData(nr));
+        
+        if (file.is_open()) {
+            
+            file.seekp(crt.chipData(nr) - crt.data);
+            file.write((char *)crt.chipData(nr), 0x2000);
+            if (!file.good()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+        }
+        
+        *saved |= 1ULL << chipBank;
+        count++;
+    }
+    
+    flashRomL.markAsSaved(savedL);
+    flashRomH.markAsSaved(savedH);
+    
+    return count;
+}
+
 u8
 EasyFlash::peek(u16 addr)
 {
@@ -179,6 +230,8 @@ EasyFlash::pokeBankReg(u8 value)
 {
     bankReg = value;
     bank = value & 0x3F;
+    markDirty();
+    expansionport.countBankSwitch();
     debug(CRT_DEBUG, "Switching to bank %d\n", bank);
 }
 
@@ -186,6 +239,7 @@ void
 EasyFlash::pokeModeReg(u8 value)
 {
     modeReg = value;
+    markDirty();
     // c64.signalBreakpoint();
     
     setLED((value & 0x80) != 0);
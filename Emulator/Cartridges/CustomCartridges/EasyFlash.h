@@ -40,6 +40,9 @@ public:
     CartridgeType getCartridgeType() const override { return CRT_EASYFLASH; }
     
     void resetCartConfig() override;
+    
+    // All state changes are reported via markDirty()
+    bool tracksChanges() const override { return true; }
 
 private:
     
@@ -80,9 +83,12 @@ private:
     }
     
     usize __size() { COMPUTE_SNAPSHOT_SIZE }
+    u64 __hash() { HASH_SNAPSHOT_ITEMS }
     usize _size() override { return Cartridge::_size() + __size(); }
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buffer) override { return Cartridge::_load(buffer); }
     usize _save(u8 *buffer) override { return Cartridge::_save(buffer); }
+    u64 _hash() override { return fnv_1a_it64(Cartridge::_hash(), __hash()); }
     usize didLoadFromBuffer(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize didSaveToBuffer(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
 
@@ -92,6 +98,11 @@ private:
     //
     
     void loadChip(unsigned nr, const CRTFile &crt) override;
+    
+    /* Modified banks without a chip packet in the CRT file can't be written
+     * back. They remain marked as modified.
+     */
+    isize writeBack(CRTFile &crt) override throws;
 
     
     //
@@ -63,10 +63,13 @@ private:
     usize __size() { COMPUTE_SNAPSHOT_SIZE }
     usize __load(u8 *buffer) { LOAD_SNAPSHOT_ITEMS }
     usize __save(u8 *buffer) { SAVE_SNAPSHOT_ITEMS }
+    u64 __hash() { HASH_SNAPSHOT_ITEMS }
     
     usize _size() override { return Cartridge::_size() + __size(); }
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buf) override { return Cartridge::_load(buf) + __load(buf); }
     usize _save(u8 *buf) override { return Cartridge::_save(buf) + __save(buf); }
+    u64 _hash() override { return fnv_1a_it64(Cartridge::_hash(), __hash()); }
 
  
     //
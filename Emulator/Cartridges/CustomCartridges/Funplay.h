@@ -18,6 +18,7 @@ public:
     Funplay(C64 &ref) : Cartridge(ref) { };
     const char *getDescription() const override { return "Funplay"; }
     CartridgeType getCartridgeType() const override { return CRT_FUNPLAY; }
+    bool hasPlainRom() const override { return true; }
     
     
     //
@@ -18,6 +18,7 @@ public:
     MagicDesk(C64 &ref) : Cartridge(ref) { };
     const char *getDescription() const override { return "MagicDesk"; }
     CartridgeType getCartridgeType() const override { return CRT_MAGIC_DESK; }
+    bool hasPlainRom() const override { return true; }
     void resetCartConfig() override;
     
     //
@@ -18,6 +18,7 @@ public:
     Ocean(C64 &ref) : Cartridge(ref) { };
     const char *getDescription() const override { return "Ocean"; }
     CartridgeType getCartridgeType() const override { return CRT_OCEAN; }
+    bool hasPlainRom() const override { return true; }
 
     
     //
@@ -0,0 +1,464 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+
+// Transfer types (command register, bits 0 and 1)
+enum { REU_STASH, REU_FETCH, REU_SWAP, REU_VERIFY };
+
+REU::REU(C64 &ref) : Cartridge(ref)
+{
+    setRamCapacity(128 * 1024);
+}
+
+REU::~REU()
+{
+    if (c64.dma == this) c64.dma = nullptr;
+
+    // Don't refresh the page tables here (the expansion port may be dying)
+    if (armed) mem.trapFF00 = false;
+}
+
+void
+REU::_reset()
+{
+    if (c64.dma == this) c64.dma = nullptr;
+    setArmed(false);
+
+    Cartridge::_reset();
+    RESET_SNAPSHOT_ITEMS
+
+    command = 0x10;
+    length = lengthShadow = 0xFFFF;
+}
+
+void
+REU::_dump() const
+{
+    Cartridge::_dump();
+
+    msg("REU\n");
+    msg("---\n\n");
+
+    msg("    Capacity : %zu KB\n", getRamCapacity() / 1024);
+    msg("      Status : %02X\n", status);
+    msg("     Command : %02X\n", command);
+    msg("    C64 base : %04X (%04X)\n", c64Base, c64Shadow);
+    msg("    REU base : %06X (%06X)\n", reuBase, reuShadow);
+    msg("      Length : %04X (%04X)\n", length, lengthShadow);
+    msg("    IRQ mask : %02X\n", irqMask);
+    msg("Addr control : %02X\n", addrCtrl);
+    msg("       Armed : %s\n", armed ? "yes" : "no");
+    msg("      Active : %s\n", active ? "yes" : "no");
+}
+
+usize
+REU::didLoadFromBuffer(u8 *buffer)
+{
+    // Reconnect to the C64 (the block state is derived from the registers)
+    c64.dma = active ? this : nullptr;
+    mem.setTrapFF00(armed);
+    if (active) startBlock();
+
+    return 0;
+}
+
+u8
+REU::peekIO2(u16 addr)
+{
+    u8 result = spypeekIO2(addr);
+
+    // Reading the status register clears the interrupt and error bits
+    if ((addr & 0x1F) == 0) {
+
+        status &= 0x1F;
+        cpu.releaseIrqLine(INTSRC_EXP);
+    }
+    return result;
+}
+
+u8
+REU::spypeekIO2(u16 addr) const
+{
+    bool large = getRamCapacity() > 128 * 1024;
+    bool small = getRamCapacity() <= 512 * 1024;
+
+    switch (addr & 0x1F) {
+
+        case 0x00: return status | (large ? 0x10 : 0x00);
+        case 0x01: return command;
+        case 0x02: return LO_BYTE(c64Base);
+        case 0x03: return HI_BYTE(c64Base);
+        case 0x04: return LO_BYTE(reuBase);
+        case 0x05: return HI_BYTE(reuBase);
+        case 0x06: return (u8)(reuBase >> 16) | (small ? 0xF8 : 0x00);
+        case 0x07: return LO_BYTE(length);
+        case 0x08: return HI_BYTE(length);
+        case 0x09: return irqMask | 0x1F;
+        case 0x0A: return addrCtrl | 0x3F;
+
+        default:
+            return 0xFF;
+    }
+}
+
+void
+REU::pokeIO2(u16 addr, u8 value)
+{
+    debug(CRT_DEBUG, "pokeIO2(%x, %x)\n", addr, value);
+
+    switch (addr & 0x1F) {
+
+        case 0x01:
+
+            command = value;
+            if ((value & 0x90) == 0x90) {
+                startTransfer();
+            } else {
+                setArmed(value & 0x80);
+            }
+            break;
+
+        case 0x02:
+
+            c64Base = c64Shadow = (u16)((c64Shadow & 0xFF00) | value);
+            break;
+
+        case 0x03:
+
+            c64Base = c64Shadow = (u16)((c64Shadow & 0x00FF) | value << 8);
+            break;
+
+        case 0x04:
+
+            reuBase = reuShadow = (reuShadow & 0xFFFF00) | value;
+            break;
+
+        case 0x05:
+
+            reuBase = reuShadow = (reuShadow & 0xFF00FF) | value << 8;
+            break;
+
+        case 0x06:
+
+            reuBase = reuShadow = (reuShadow & 0x00FFFF) | value << 16;
+            break;
+
+        case 0x07:
+
+            length = lengthShadow = (u16)((lengthShadow & 0xFF00) | value);
+            break;
+
+        case 0x08:
+
+            length = lengthShadow = (u16)((lengthShadow & 0x00FF) | value << 8);
+            break;
+
+        case 0x09:
+
+            irqMask = value;
+            updateIrq();
+            break;
+
+        case 0x0A:
+
+            addrCtrl = value;
+            break;
+    }
+}
+
+void
+REU::didPokeFF00()
+{
+    if (armed) startTransfer();
+}
+
+void
+REU::executeOneCycle()
+{
+    // The REU has to pause while the VICII occupies the bus
+    if (vic.BApulledDown()) return;
+
+    if (++owed == blockCycles) finishBlock();
+}
+
+void
+REU::flush()
+{
+    if (!active || byteMode) return;
+
+    u32 cyclesPerByte = blockCycles / blockBytes;
+    u32 count = owed / cyclesPerByte;
+
+    if (count) {
+
+        transfer(count);
+        owed -= count * cyclesPerByte;
+        startBlock();
+    }
+}
+
+void
+REU::setArmed(bool value)
+{
+    armed = value;
+    mem.setTrapFF00(value);
+}
+
+void
+REU::startTransfer()
+{
+    debug(CRT_DEBUG, "%s: %04X <-> %06X (%d bytes)\n",
+          (command & 3) == REU_STASH ? "Stash" :
+          (command & 3) == REU_FETCH ? "Fetch" :
+          (command & 3) == REU_SWAP ? "Swap" : "Verify",
+          c64Base, reuBase, remaining());
+
+    setArmed(false);
+
+    active = true;
+    owed = 0;
+    startBlock();
+
+    // From now on, the REU is executed instead of the CPU
+    c64.dma = this;
+}
+
+void
+REU::endTransfer()
+{
+    bool done = length == 0;
+
+    active = false;
+    c64.dma = nullptr;
+
+    if (done) status |= 0x40;
+    if (blockFault) status |= 0x20;
+
+    if (command & 0x20) {
+
+        // Autoload
+        c64Base = c64Shadow;
+        reuBase = reuShadow;
+        length = lengthShadow;
+
+    } else if (done) {
+
+        length = 1;
+    }
+
+    command = (command & 0x7F) | 0x10;
+    blockFault = false;
+    updateIrq();
+}
+
+void
+REU::startBlock()
+{
+    u8 type = command & 3;
+    bool fixC64 = addrCtrl & 0x80;
+
+    // Checks if a page can be accessed directly
+    auto direct = [&](u8 page) {
+        switch (type) {
+            case REU_FETCH: return mem.pokePage[page] != nullptr;
+            case REU_SWAP: return mem.peekPage[page] && mem.pokePage[page];
+            default: return mem.peekPage[page] != nullptr;
+        }
+    };
+
+    // Checks if a write to a page is seen by the VICII
+    bool writes = type == REU_FETCH || type == REU_SWAP;
+    u16 bank = vic.getBankAddr();
+    auto visible = [&](u8 page) {
+        return writes && (u16)((page << 8) - bank) < 0x4000;
+    };
+
+    u32 count = 0;
+
+    if (direct(HI_BYTE(c64Base)) && !visible(HI_BYTE(c64Base))) {
+
+        if (fixC64) {
+            count = remaining();
+        } else {
+
+            // Collect all consecutive pages up to the end of the address space
+            u32 page = HI_BYTE(c64Base);
+            while (page < 0x100 && direct((u8)page) && !visible((u8)page)) page++;
+            count = MIN(remaining(), page * 0x100 - c64Base);
+        }
+    }
+
+    byteMode = count == 0;
+    blockFault = false;
+
+    if (byteMode) {
+
+        count = 1;
+
+    } else if (type == REU_VERIFY) {
+
+        // Let the block end at the first mismatch
+        u8 *ram = getRam();
+        u32 mask = (u32)getRamCapacity() - 1;
+        bool fixReu = addrCtrl & 0x40;
+
+        for (u32 i = 0; i < count; i++) {
+
+            u16 c = (u16)(c64Base + (fixC64 ? 0 : i));
+            u32 r = (reuBase + (fixReu ? 0 : i)) & mask;
+
+            if (mem.peekPage[HI_BYTE(c)][LO_BYTE(c)] != ram[r]) {
+                count = i + 1;
+                blockFault = true;
+                break;
+            }
+        }
+    }
+
+    blockBytes = count;
+    blockCycles = count * (type == REU_SWAP ? 2 : 1);
+}
+
+void
+REU::finishBlock()
+{
+    if (byteMode) transferByte(); else transfer(blockBytes);
+    owed = 0;
+
+    if (length == 0 || blockFault) {
+        endTransfer();
+    } else {
+        startBlock();
+    }
+}
+
+void
+REU::transfer(u32 count)
+{
+    assert(count <= blockBytes);
+
+    u8 *ram = getRam();
+    u32 capacity = (u32)getRamCapacity();
+    bool fixC64 = addrCtrl & 0x80;
+    bool fixReu = addrCtrl & 0x40;
+
+    while (count) {
+
+        // Split the block at page boundaries and at the end of REU memory
+        u32 chunk = count;
+        if (!fixC64) chunk = MIN(chunk, 0x100 - LO_BYTE(c64Base));
+        if (!fixReu) chunk = MIN(chunk, capacity - (reuBase & (capacity - 1)));
+
+        u8 page = HI_BYTE(c64Base);
+        u8 offset = LO_BYTE(c64Base);
+        u8 *r = ram + (reuBase & (capacity - 1));
+
+        switch (command & 3) {
+
+            case REU_STASH:
+            {
+                const u8 *c = mem.peekPage[page] + offset;
+                if (fixReu) {
+                    *r = fixC64 ? *c : c[chunk - 1];
+                } else if (fixC64) {
+                    memset(r, *c, chunk);
+                } else {
+                    memcpy(r, c, chunk);
+                }
+                break;
+            }
+            case REU_FETCH:
+            {
+                u8 *c = mem.pokePage[page] + offset;
+                if (fixC64) {
+                    *c = fixReu ? *r : r[chunk - 1];
+                } else if (fixReu) {
+                    memset(c, *r, chunk);
+                } else {
+                    memcpy(c, r, chunk);
+                }
+                break;
+            }
+            case REU_SWAP:
+            {
+                const u8 *src = mem.peekPage[page] + offset;
+                u8 *dst = mem.pokePage[page] + offset;
+
+                for (u32 i = 0; i < chunk; i++) {
+
+                    u32 ci = fixC64 ? 0 : i;
+                    u32 ri = fixReu ? 0 : i;
+                    u8 value = src[ci];
+                    dst[ci] = r[ri];
+                    r[ri] = value;
+                }
+                break;
+            }
+            default:
+
+                // Verify errors have been detected in startBlock()
+                break;
+        }
+
+        advance(chunk);
+        count -= chunk;
+    }
+}
+
+void
+REU::transferByte()
+{
+    u8 *r = getRam() + (reuBase & (getRamCapacity() - 1));
+
+    switch (command & 3) {
+
+        case REU_STASH:
+
+            *r = mem.peek(c64Base);
+            break;
+
+        case REU_FETCH:
+
+            mem.poke(c64Base, *r);
+            break;
+
+        case REU_SWAP:
+        {
+            u8 value = mem.peek(c64Base);
+            mem.poke(c64Base, *r);
+            *r = value;
+            break;
+        }
+        default:
+
+            if (mem.peek(c64Base) != *r) blockFault = true;
+            break;
+    }
+
+    advance(1);
+}
+
+void
+REU::advance(u32 count)
+{
+    if (!(addrCtrl & 0x80)) c64Base = (u16)(c64Base + count);
+    if (!(addrCtrl & 0x40)) reuBase = (reuBase + count) & 0xFFFFFF;
+    length = (u16)(remaining() - count);
+}
+
+void
+REU::updateIrq()
+{
+    if ((irqMask & 0x80) && (status & irqMask & 0x60)) {
+
+        status |= 0x80;
+        cpu.pullDownIrqLine(INTSRC_EXP);
+    }
+}
@@ -0,0 +1,200 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "Cartridge.h"
+
+/* A RAM Expansion Unit (Commodore 1700, 1764, 1750 and larger clones). The
+ * REU is programmed via a register file in the IO2 space and moves data
+ * between C64 memory and its on-board RAM by DMA. While a transfer is running,
+ * the C64 executes the REU instead of the CPU in the second clock phase (see
+ * C64::dma).
+ *
+ * Transfers are emulated in blocks. A block is the longest run of bytes that
+ * can be accessed via the page tables of C64Memory. The REU counts the cycles
+ * consumed by the block and copies it in one go once the last cycle has
+ * elapsed. Bytes outside directly accessible memory (zero page, I/O space)
+ * form blocks of their own and are accessed via the slow path. The same
+ * applies to bytes written into the memory bank seen by the VICII. They are
+ * transferred in the cycle they are due, so the VICII never reads stale data.
+ */
+class REU : public Cartridge {
+
+    // Status register
+    u8 status = 0;
+
+    // Command register
+    u8 command = 0;
+
+    // Address and length registers
+    u16 c64Base = 0;
+    u32 reuBase = 0;
+    u16 length = 0;
+
+    // Values restored by the autoload feature
+    u16 c64Shadow = 0;
+    u32 reuShadow = 0;
+    u16 lengthShadow = 0;
+
+    // Interrupt mask register
+    u8 irqMask = 0;
+
+    // Address control register
+    u8 addrCtrl = 0;
+
+    // Indicates if a transfer is waiting for a write to $FF00
+    bool armed = false;
+
+    // Indicates if a transfer is in progress
+    bool active = false;
+
+    // Number of cycles spent on the current block
+    u32 owed = 0;
+
+    // Size of the current block in bytes and cycles
+    u32 blockBytes = 0;
+    u32 blockCycles = 0;
+
+    // Indicates if the current block is accessed via the slow path
+    bool byteMode = false;
+
+    // Indicates if the current block ends with a verify error
+    bool blockFault = false;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    REU(C64 &ref);
+    ~REU();
+    const char *getDescription() const override { return "REU"; }
+    CartridgeType getCartridgeType() const override { return CRT_REU; }
+
+private:
+
+    void _reset() override;
+
+
+    //
+    // Analyzing
+    //
+
+private:
+
+    void _dump() const override;
+
+
+    //
+    // Serializing
+    //
+
+private:
+
+    template <class T>
+    void applyToPersistentItems(T& worker)
+    {
+    }
+
+    template <class T>
+    void applyToResetItems(T& worker)
+    {
+        worker
+
+        & status
+        & command
+        & c64Base
+        & reuBase
+        & length
+        & c64Shadow
+        & reuShadow
+        & lengthShadow
+        & irqMask
+        & addrCtrl
+        & armed
+        & active
+        & owed;
+    }
+
+    usize __size() { COMPUTE_SNAPSHOT_SIZE }
+    usize __load(u8 *buffer) { LOAD_SNAPSHOT_ITEMS }
+    usize __save(u8 *buffer) { SAVE_SNAPSHOT_ITEMS }
+    u64 __hash() { HASH_SNAPSHOT_ITEMS }
+
+    // The REU's items are stored behind the items of the base class
+    usize _size() override { return Cartridge::_size() + __size(); }
+    usize _objectSize() const override { return sizeof(*this); }
+    usize _load(u8 *buf) override { usize n = Cartridge::_load(buf); return n + __load(buf + n); }
+    usize _save(u8 *buf) override { usize n = Cartridge::_save(buf); return n + __save(buf + n); }
+    u64 _hash() override { return fnv_1a_it64(Cartridge::_hash(), __hash()); }
+
+    usize didLoadFromBuffer(u8 *buffer) override;
+
+
+    //
+    // Accessing cartridge memory
+    //
+
+public:
+
+    u8 peekIO2(u16 addr) override;
+    u8 spypeekIO2(u16 addr) const override;
+    void pokeIO2(u16 addr, u8 value) override;
+
+
+    //
+    // Handling delegation calls
+    //
+
+public:
+
+    void didPokeFF00() override;
+
+
+    //
+    // Performing DMA
+    //
+
+public:
+
+    // Executes a single DMA cycle (called by the C64 instead of the CPU)
+    void executeOneCycle();
+
+    // Copies all bytes of the current block that are due by now
+    void flush();
+
+private:
+
+    // Returns the number of bytes that have not been transferred yet
+    u32 remaining() const { return length ? length : 0x10000; }
+
+    // Arms or disarms the $FF00 trigger
+    void setArmed(bool value);
+
+    // Launches or terminates a transfer
+    void startTransfer();
+    void endTransfer();
+
+    // Sets up the next block or completes the current one
+    void startBlock();
+    void finishBlock();
+
+    // Transfers bytes of the current block
+    void transfer(u32 count);
+    void transferByte();
+
+    // Advances the address and length registers
+    void advance(u32 count);
+
+    // Triggers an interrupt if requested
+    void updateIrq();
+};
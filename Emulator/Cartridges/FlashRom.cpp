@@ -36,20 +36,54 @@ FlashRom::FlashRom(C64 &ref) : C64Component(ref)
     state = FLASH_READ;
     baseState = FLASH_READ;
     
-    rom = new u8[romSize];
-    memset(rom, 0xFF, romSize);
+    for (unsigned i = 0; i < numBanks; i++) eraseBank(i);
 }
 
-FlashRom::~FlashRom()
+void
+FlashRom::loadBank(unsigned bank, u8 *data)
 {
-    delete [] rom;
+    assert(data);
+    assert(isBankNumber(bank));
+    
+    storage[bank] = RomPool::share(data, 0x2000);
+    banks[bank] = storage[bank].get();
+    ownedBanks &= ~(1ULL << bank);
+    markDirty();
 }
 
 void
-FlashRom::loadBank(unsigned bank, u8 *data)
+FlashRom::saveBank(unsigned bank, u8 *data) const
 {
     assert(data);
-    memcpy(rom + bank * 0x2000, data, 0x2000);
+    assert(isBankNumber(bank));
+    
+    memcpy(data, banks[bank], 0x2000);
+}
+
+u8 *
+FlashRom::writableBank(unsigned nr)
+{
+    assert(isBankNumber(nr));
+    
+    if (!(ownedBanks & (1ULL << nr))) {
+        
+        u8 *copy = new u8[0x2000];
+        memcpy(copy, banks[nr], 0x2000);
+        storage[nr] = std::shared_ptr<const u8[]>(copy);
+        banks[nr] = copy;
+        ownedBanks |= 1ULL << nr;
+    }
+    return const_cast<u8 *>(banks[nr]);
+}
+
+void
+FlashRom::eraseBank(unsigned nr)
+{
+    assert(isBankNumber(nr));
+    
+    storage[nr] = RomPool::share((u8)0xFF, 0x2000);
+    banks[nr] = storage[nr].get();
+    ownedBanks &= ~(1ULL << nr);
 }
 
 void
@@ -73,14 +107,18 @@ FlashRom::_dump() const
     msg(" baseState: %ld\n", (long)baseState);
     msg("numSectors: %zu\n", numSectors);
     msg("sectorSize: %zu\n", sectorSize);
-    msg("       rom: %p\n\n", rom);
+    msg("ownedBanks: %llx\n\n", ownedBanks);
 }
 
 usize
 FlashRom::didLoadFromBuffer(u8 *buffer)
 {
-    SerReader reader(buffer);
-    reader.copy(rom, romSize);
+    for (unsigned i = 0; i < numBanks; i++) {
+        
+        storage[i] = RomPool::share(buffer + i * 0x2000, 0x2000);
+        banks[i] = storage[i].get();
+    }
+    ownedBanks = 0;
 
     return romSize;
 }
@@ -89,11 +127,33 @@ usize
 FlashRom::didSaveToBuffer(u8 *buffer)
 {
     SerWriter writer(buffer);
-    writer.copy(rom, romSize);
+    for (unsigned i = 0; i < numBanks; i++) writer.copy(banks[i], 0x2000);
 
     return romSize;
 }
 
+u64
+FlashRom::_hash()
+{
+    SerHasher hasher;
+    applyToPersistentItems(hasher);
+    applyToResetItems(hasher);
+    for (unsigned i = 0; i < numBanks; i++) hasher.copy(banks[i], 0x2000);
+
+    return hasher.hash;
+}
+
+void
+FlashRom::markAsModified(u32 addr, u32 len)
+{
+    assert(len > 0 && addr + len <= romSize);
+    
+    for (u32 bank = addr / 0x2000; bank <= (addr + len - 1) / 0x2000; bank++) {
+        modifiedBanks |= 1ULL << bank;
+    }
+    markDirty();
+}
+
 u8
 FlashRom::peek(u32 addr)
 {
@@ -105,6 +165,7 @@ FlashRom::spypeek(u32 addr) const
 {
     assert(addr < romSize);
     
+    u8 data = banks[addr / 0x2000][addr % 0x2000];
     u8 result;
     
     switch (state) {
@@ -122,42 +183,42 @@ FlashRom::spypeek(u32 addr) const
                 case 2:
                     return 0;
             }
-            return rom[addr];
+            return data;
             
         case FLASH_BYTE_PROGRAM_ERROR:
             
             // TODO
-            result = rom[addr];
+            result = data;
             break;
             
         case FLASH_SECTOR_ERASE_SUSPEND:
             
             // TODO
-            result = rom[addr];
+            result = data;
             break;
             
         case FLASH_CHIP_ERASE:
             
             // TODO
-            result = rom[addr];
+            result = data;
             break;
             
         case FLASH_SECTOR_ERASE:
             
             // TODO
-            result = rom[addr];
+            result = data;
             break;
             
         case FLASH_SECTOR_ERASE_TIMEOUT:
             
             // TODO
-            result = rom[addr];
+            result = data;
             break;
             
         default:
             
             // TODO
-            result = rom[addr];
+            result = data;
             break;
     }
     
@@ -166,6 +227,17 @@ FlashRom::spypeek(u32 addr) const
 
 void
 FlashRom::poke(u32 addr, u8 value)
+{
+    FlashState oldState = state;
+    FlashState oldBaseState = baseState;
+    
+    _poke(addr, value);
+    
+    if (state != oldState || baseState != oldBaseState) markDirty();
+}
+
+void
+FlashRom::_poke(u32 addr, u8 value)
 {
     assert(addr < romSize);
     
@@ -304,15 +376,23 @@ FlashRom::doByteProgram(u32 addr, u8 value)
 {
     assert(addr < romSize);
     
-    rom[addr] &= value;
-    return rom[addr] == value;
+    unsigned nr = addr / 0x2000;
+    u16 offset = addr % 0x2000;
+    
+    if ((banks[nr][offset] & value) != banks[nr][offset]) {
+        
+        writableBank(nr)[offset] &= value;
+        markAsModified(addr, 1);
+    }
+    return banks[nr][offset] == value;
 }
 
 void
 FlashRom::doChipErase() {
     
     trace(CRT_DEBUG, "Erasing chip ...\n");
-    memset(rom, 0xFF, romSize);
+    for (unsigned i = 0; i < numBanks; i++) eraseBank(i);
+    markAsModified(0, romSize);
 }
 
 void
@@ -320,6 +400,11 @@ FlashRom::doSectorErase(u32 addr)
 {
     assert(addr < romSize);
     
-    trace(CRT_DEBUG, "Erasing sector %d\n", addr >> 4);
-    memset(rom + (addr & 0x0000), 0xFF, sectorSize);
+    u32 sector = (u32)(addr / sectorSize);
+    
+    trace(CRT_DEBUG, "Erasing sector %d\n", sector);
+    for (unsigned i = 0; i < sectorSize / 0x2000; i++) {
+        eraseBank((unsigned)(sector * sectorSize / 0x2000 + i));
+    }
+    markAsModified((u32)(sector * sectorSize), sectorSize);
 }
@@ -11,6 +11,7 @@
 
 #include "C64Component.h"
 #include "CartridgePublicTypes.h"
+#include "RomPool.h"
 
 /* This class implements a Flash Rom module of type Am29F040B. Flash Roms
  * of this type are used, e.g., by the EasyFlash cartridge. The implementation
@@ -29,6 +30,9 @@ class FlashRom : public C64Component {
     
     // Total size of the Flash Rom in bytes (512 KB)
     static const usize romSize = 0x80000;
+    
+    // Number of 8 KB banks in this Flash Rom
+    static const usize numBanks = 64;
 
     // Current Flash Rom state
     FlashState state;
@@ -36,8 +40,21 @@ class FlashRom : public C64Component {
     // State taken after an operations has been completed
     FlashState baseState;
     
-    // Flash Rom data
-    u8 *rom = nullptr;
+    // Read-only view of all banks
+    const u8 *banks[numBanks];
+    
+    /* Storage of all banks. Banks are shared with other Flash Roms of the same
+     * contents (see RomPool) and copied on the first write access.
+     */
+    std::shared_ptr<const u8[]> storage[numBanks];
+    
+    // Banks that have been copied on write (bit n refers to bank n)
+    u64 ownedBanks = 0;
+    
+    /* Banks that have been programmed or erased since the contents were
+     * loaded or written back (bit n refers to the 8 KB bank n)
+     */
+    u64 modifiedBanks = 0;
     
     
     //
@@ -60,7 +77,6 @@ public:
 public:
     
     FlashRom(C64 &ref);
-    ~FlashRom();
     const char *getDescription() const override { return "FlashRom"; }
 
     /* Loads an 8 KB chunk of Rom data from a buffer. This method is used when
@@ -68,6 +84,9 @@ public:
      */
     void loadBank(unsigned bank, u8 *data);
     
+    // Copies an 8 KB chunk of Rom data into a buffer
+    void saveBank(unsigned bank, u8 *data) const;
+    
 private:
     
     void _reset() override;
@@ -94,7 +113,8 @@ private:
         worker
         
         & state
-        & baseState;
+        & baseState
+        & modifiedBanks;
     }
     
     template <class T>
@@ -104,12 +124,49 @@ private:
     
     usize __size() { COMPUTE_SNAPSHOT_SIZE }
     usize _size() override { return __size() + romSize; }
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override;
     usize didLoadFromBuffer(u8 *buffer) override;
     usize didSaveToBuffer(u8 *buffer) override;
 
     
+    //
+    // Tracking changes
+    //
+    
+public:
+    
+    /* The Rom contents only change when a flash operation is performed. Since
+     * this rarely happens, the expansion port usually keeps its state stamp
+     * and incremental states share the serialized cartridge (see
+     * ExpansionPort::stateStamp()).
+     */
+    bool tracksChanges() const override { return true; }
+    
+    // Checks if a bank has been modified since it was loaded or written back
+    bool isModified(unsigned bank) const {
+        assert(isBankNumber(bank)); return modifiedBanks & (1ULL << bank); }
+    
+    // Returns the modified banks as a bit mask
+    u64 getModifiedBanks() const { return modifiedBanks; }
+    
+    // Marks some banks as unmodified (called after writing them back)
+    void markAsSaved(u64 banks) { modifiedBanks &= ~banks; markDirty(); }
+    
+private:
+    
+    // Marks the banks inside an address range as modified
+    void markAsModified(u32 addr, u32 len);
+    
+    // Returns a writable pointer to a bank (copying the bank if needed)
+    u8 *writableBank(unsigned nr);
+    
+    // Replaces a bank by a shared bank with all bytes erased
+    void eraseBank(unsigned nr);
+
+    
     //
     // Accessing memory
     //
@@ -128,11 +185,17 @@ public:
     void poke(unsigned bank, u16 addr, u8 value) {
         assert(isBankNumber(bank)); poke(bank * 0x2000 + addr, value); }
     
+private:
+    
+    void _poke(u32 addr, u8 value);
+    
     
     //
     // Performing flash operations
     //
     
+public:
+    
     // Checks if addr serves as the first command address
     bool firstCommandAddr(u32 addr) { return (addr & 0x7FF) == 0x555; }
 
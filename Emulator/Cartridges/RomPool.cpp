@@ -0,0 +1,72 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "RomPool.h"
+#include "Utils.h"
+
+std::mutex RomPool::mutex;
+std::unordered_multimap<u64, RomPool::Entry> RomPool::entries;
+usize RomPool::sweepLimit = 64;
+
+std::shared_ptr<const u8[]>
+RomPool::share(const u8 *buf, usize size)
+{
+    assert(buf);
+    
+    u64 fnv = fnv_1a_64(buf, size);
+
+    std::lock_guard<std::mutex> guard(mutex);
+
+    // Look for a buffer with the same contents
+    auto range = entries.equal_range(fnv);
+    for (auto it = range.first; it != range.second; it++) {
+        
+        if (it->second.size != size) continue;
+        
+        auto data = it->second.data.lock();
+        if (data && memcmp(data.get(), buf, size) == 0) return data;
+    }
+    
+    // Create a new buffer
+    u8 *copy = new u8[size];
+    memcpy(copy, buf, size);
+    std::shared_ptr<const u8[]> data(copy);
+    
+    entries.emplace(fnv, Entry { size, data });
+    if (entries.size() >= sweepLimit) sweep();
+    
+    return data;
+}
+
+std::shared_ptr<const u8[]>
+RomPool::share(u8 value, usize size)
+{
+    std::unique_ptr<u8[]> buf(new u8[size]);
+    memset(buf.get(), value, size);
+    
+    return share(buf.get(), size);
+}
+
+usize
+RomPool::count()
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    
+    sweep();
+    return entries.size();
+}
+
+void
+RomPool::sweep()
+{
+    for (auto it = entries.begin(); it != entries.end();) {
+        it = it->second.data.expired() ? entries.erase(it) : std::next(it);
+    }
+    sweepLimit = std::max((usize)64, 2 * entries.size());
+}
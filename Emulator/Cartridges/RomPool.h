@@ -0,0 +1,63 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/* Process-wide pool of immutable Rom data. Cartridge Roms and the banks of a
+ * Flash Rom don't store their data themselves. Instead, they reference a
+ * buffer from this pool. Buffers with equal contents are only stored once,
+ * no matter if they are created from a CRT file or restored from a snapshot.
+ * Hence, all emulator instances running the same cartridge share its Rom.
+ *
+ * The pool doesn't keep buffers alive. A buffer is freed once the last Rom
+ * referencing it is deleted. Buffers handed out by the pool must never be
+ * modified. Writable chips copy a buffer before modifying it (see FlashRom).
+ */
+class RomPool {
+
+    struct Entry {
+
+        usize size;
+        std::weak_ptr<const u8[]> data;
+    };
+
+    static std::mutex mutex;
+
+    // All buffers, indexed by the FNV-64 fingerprint of their contents
+    static std::unordered_multimap<u64, Entry> entries;
+
+    // Number of entries triggering the next removal of expired entries
+    static usize sweepLimit;
+
+
+    //
+    // Accessing
+    //
+
+public:
+
+    // Returns a buffer with the provided contents
+    static std::shared_ptr<const u8[]> share(const u8 *buf, usize size);
+
+    // Returns a buffer of the provided size with all bytes set to a value
+    static std::shared_ptr<const u8[]> share(u8 value, usize size);
+
+    // Returns the number of buffers that are currently in use
+    static usize count();
+
+private:
+
+    // Removes all entries whose buffers have been freed
+    static void sweep();
+};
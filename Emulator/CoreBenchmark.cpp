@@ -0,0 +1,364 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "CoreBenchmark.h"
+#include "C64.h"
+#include "C64Headless.h"
+#include <iomanip>
+
+// Number of register writes in the synthesized register stream
+static const usize numRegWrites = 20000;
+
+// Maximum number of SID cycles executed in a single call
+static const u32 maxSIDCycles = 10000;
+
+// Number of frames the drive is given to boot up
+static const isize driveBootFrames = 100;
+
+CoreBenchmark::CoreBenchmark()
+{
+    u32 seed = 0x6581;
+    auto random = [&seed]() { seed = seed * 1103515245 + 12345; return seed >> 16; };
+
+    // Start all voices with different waveforms and route them through the filter
+    const u8 init[] = {
+        0x00, 0x11, 0x00, 0x08, 0x41, 0x09, 0xF0,
+        0x00, 0x16, 0x00, 0x00, 0x21, 0x09, 0xF0,
+        0x00, 0x1A, 0x00, 0x00, 0x81, 0x09, 0xF0,
+        0x00, 0x40, 0xF7, 0x1F
+    };
+    for (u8 i = 0; i < sizeof(init); i++) regWrites.push_back(RegWrite { 1, i, init[i] });
+
+    // Modify random registers in random intervals (the test bit is never set)
+    while (regWrites.size() < numRegWrites) {
+
+        u8 reg = (u8)(random() % 0x19);
+        u8 value = (u8)random();
+        if (reg == 0x04 || reg == 0x0B || reg == 0x12) value &= 0xF7;
+
+        regWrites.push_back(RegWrite { 100 + random() % 2000, reg, value });
+    }
+}
+
+CoreBenchmark::~CoreBenchmark()
+{
+    for (auto rom : roms) delete rom;
+}
+
+void
+CoreBenchmark::loadRom(const string &path)
+{
+    roms.push_back(AnyFile::make <RomFile> (path));
+}
+
+void
+CoreBenchmark::loadTrace(const string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) throw VC64Error(ERROR_FILE_NOT_FOUND);
+
+    std::vector<u8> buf(streamLength(in));
+    if (!in.read((char *)buf.data(), buf.size())) throw VC64Error(ERROR_FILE_CANT_READ);
+
+    // Skip the header (magic bytes, version, CPU clock)
+    if (buf.size() < 13 || memcmp(buf.data(), "VC64SIDT", 8) != 0) {
+        throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+    }
+
+    std::vector<RegWrite> result;
+    for (usize i = 13; i < buf.size();) {
+
+        // Decode the cycle delta (LEB128)
+        u64 delta = 0;
+        for (isize shift = 0; i < buf.size() && shift < 64; shift += 7) {
+
+            u8 byte = buf[i++];
+            delta |= (u64)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        if (i + 2 > buf.size()) break;
+
+        result.push_back(RegWrite { (u32)MIN(delta, (u64)UINT32_MAX), (u8)(buf[i] & 0x1F), buf[i + 1] });
+        i += 2;
+    }
+
+    if (result.empty()) throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+    regWrites = std::move(result);
+}
+
+void
+CoreBenchmark::loadBaseline(const string &path)
+{
+    std::ifstream in(path);
+    if (!in.is_open()) throw VC64Error(ERROR_FILE_NOT_FOUND);
+
+    for (string line; std::getline(in, line);) {
+
+        std::stringstream fields(line);
+        string key, cycles, seconds, mhz;
+
+        std::getline(fields, key, '\t');
+        std::getline(fields, cycles, '\t');
+        std::getline(fields, seconds, '\t');
+        std::getline(fields, mhz, '\t');
+
+        for (isize i = 0; i < CORE_COUNT; i++) {
+
+            if (key != ChipCoreEnum::key((ChipCore)i)) continue;
+
+            try { baselines[i] = std::stod(mhz); }
+            catch (...) { throw VC64Error(ERROR_FILE_TYPE_MISMATCH); }
+        }
+    }
+}
+
+void
+CoreBenchmark::run(u64 cycles)
+{
+    results.clear();
+
+    for (isize i = 0; i < CORE_COUNT; i++) {
+        results.push_back(run((ChipCore)i, cycles));
+    }
+}
+
+CoreBenchmark::Result
+CoreBenchmark::run(ChipCore core, u64 cycles)
+{
+    assert_enum(ChipCore, core);
+
+    Result result;
+    result.core = core;
+    result.baseline = baselines[core];
+
+    std::unique_ptr<C64> c64(vc64_new());
+    for (auto rom : roms) c64->installRom(rom);
+    c64->reset();
+
+    switch (core) {
+
+        case CORE_CPU:      measureCPU(*c64, cycles, result); break;
+        case CORE_VICII:    measureVICII(*c64, cycles, result); break;
+        case CORE_RESID:
+        case CORE_FASTSID:  measureSID(*c64, cycles, result); break;
+        case CORE_DRIVE:    measureDrive(*c64, cycles, result); break;
+
+        default:
+            assert(false);
+    }
+
+    return result;
+}
+
+void
+CoreBenchmark::measureCPU(C64 &c64, u64 cycles, Result &result)
+{
+    const u8 code[] = {
+        0xA2, 0x00,         //       LDX #$00
+        0xBD, 0x00, 0x20,   // loop: LDA $2000,X
+        0x69, 0x11,         //       ADC #$11
+        0x9D, 0x00, 0x30,   //       STA $3000,X
+        0x0A,               //       ASL
+        0x51, 0xFB,         //       EOR ($FB),Y
+        0x66, 0x40,         //       ROR $40
+        0xFE, 0x00, 0x40,   //       INC $4000,X
+        0x20, 0x1C, 0x10,   //       JSR sub
+        0xE8,               //       INX
+        0xD0, 0xEA,         //       BNE loop
+        0xC8,               //       INY
+        0x4C, 0x02, 0x10,   //       JMP loop
+        0x48,               // sub:  PHA
+        0x68,               //       PLA
+        0xC1, 0xFB,         //       CMP ($FB,X)
+        0x60 };             //       RTS
+
+    // Map RAM into the whole address space
+    for (isize i = 0; i < 0x10000; i++) c64.mem.ram[i] = (u8)(i ^ (i >> 8));
+    c64.mem.poke(0x0001, 0x34);
+    c64.mem.ram[0xFB] = 0x00;
+    c64.mem.ram[0xFC] = 0x50;
+    memcpy(c64.mem.ram + 0x1000, code, sizeof(code));
+
+    // Release the RDY line (the instance hasn't been reset yet)
+    c64.cpu.reset();
+    c64.cpu.jumpToAddress(0x1000);
+
+    u64 t0 = Oscillator::nanos();
+
+    for (u64 i = 0; i < cycles; i++) {
+
+        c64.cpu.cycle++;
+        c64.cpu.executeOneCycle();
+    }
+
+    result.seconds = (Oscillator::nanos() - t0) / 1000000000.0;
+    result.cycles = cycles;
+}
+
+void
+CoreBenchmark::measureVICII(C64 &c64, u64 cycles, Result &result)
+{
+    VICII &vic = c64.vic;
+
+    // Display modes (values of $D011 and $D016) cycled frame by frame
+    const u8 modes[][2] = {
+        { 0x1B, 0x08 }, { 0x1B, 0x18 }, { 0x3B, 0x08 }, { 0x3B, 0x18 }, { 0x5B, 0x08 } };
+
+    // Draw every frame
+    c64.configure(OPT_HEADLESS, false);
+
+    // Fill the memory with a pattern and enable all sprites (via the I/O space)
+    for (isize i = 0; i < 0x10000; i++) c64.mem.ram[i] = (u8)(i * 7 + (i >> 8));
+    for (isize i = 0; i < 0x400; i++) c64.mem.colorRam[i] = (u8)i & 0xF;
+    for (u16 i = 0; i < 8; i++) {
+
+        c64.mem.pokeIO(0xD000 + 2 * i, (u8)(24 + 32 * i));
+        c64.mem.pokeIO(0xD001 + 2 * i, (u8)(60 + 20 * i));
+        c64.mem.pokeIO(0xD027 + i, (u8)(i + 1));
+    }
+    c64.mem.pokeIO(0xD015, 0xFF);
+    c64.mem.pokeIO(0xD017, 0xFF);
+    c64.mem.pokeIO(0xD01C, 0xAA);
+    c64.mem.pokeIO(0xD01D, 0xFF);
+
+    u16 lines = (u16)vic.getRasterlinesPerFrame();
+    u8 cyclesPerLine = (u8)vic.getCyclesPerLine();
+    u64 executed = 0;
+
+    u64 t0 = Oscillator::nanos();
+
+    for (isize frame = 0; executed < cycles; frame++) {
+
+        c64.mem.pokeIO(0xD011, modes[frame % 5][0]);
+        c64.mem.pokeIO(0xD016, modes[frame % 5][1]);
+
+        for (u16 line = 0; line < lines; line++) {
+
+            c64.rasterLine = line;
+            if (line == 0) vic.beginFrame();
+            vic.beginRasterline(line);
+
+            for (u8 cycle = 1; cycle <= cyclesPerLine; cycle++) {
+
+                c64.rasterCycle = cycle;
+                c64.cpu.cycle++;
+                (vic.*c64.vicfunc[cycle])();
+            }
+            vic.endRasterline();
+        }
+
+        c64.rasterLine = 0;
+        c64.rasterCycle = 1;
+        vic.endFrame();
+        executed += lines * cyclesPerLine;
+    }
+
+    result.seconds = (Oscillator::nanos() - t0) / 1000000000.0;
+    result.cycles = executed;
+}
+
+void
+CoreBenchmark::measureSID(C64 &c64, u64 cycles, Result &result)
+{
+    auto replay = [&](auto &sid) {
+
+        SampleStream samples;
+        u64 executed = 0;
+
+        u64 t0 = Oscillator::nanos();
+
+        for (usize i = 0; executed < cycles; i = (i + 1) % regWrites.size()) {
+
+            auto &write = regWrites[i];
+
+            // Long pauses are executed in chunks to keep the sample buffer small
+            for (u32 delta = write.delta; delta;) {
+
+                u32 chunk = MIN(delta, maxSIDCycles);
+                sid.executeCycles(chunk, samples);
+                samples.clear();
+                delta -= chunk;
+            }
+            sid.poke(write.reg, write.value);
+            executed += write.delta;
+        }
+
+        result.seconds = (Oscillator::nanos() - t0) / 1000000000.0;
+        result.cycles = executed;
+    };
+
+    if (result.core == CORE_RESID) {
+        replay(c64.sid.resid[0]);
+    } else {
+        replay(c64.sid.fastsid[0]);
+    }
+}
+
+void
+CoreBenchmark::measureDrive(C64 &c64, u64 cycles, Result &result)
+{
+    if (!c64.hasRom(ROM_TYPE_VC1541)) {
+
+        result.problem = "No VC1541 Rom";
+        return;
+    }
+
+    Drive &drive = c64.drive8;
+    c64.configure(OPT_DRIVE_CONNECT, DRIVE8, true);
+    c64.configure(OPT_DRIVE_IDLE_SLEEP, DRIVE8, false);
+    drive.insertNewDisk(DOS_TYPE_CBM);
+
+    // The drive is executed in slices of a rasterline as in the run loop
+    u64 slice = c64.vic.getCyclesPerLine() * c64.durationOfOneCycle;
+    isize lines = c64.vic.getRasterlinesPerFrame();
+
+    for (isize i = 0; i < driveBootFrames * lines; i++) drive.execute(slice);
+
+    u64 start = drive.cpu.cycle;
+    u64 t0 = Oscillator::nanos();
+
+    while (drive.cpu.cycle - start < cycles) {
+
+        // Issue a new read job as soon as the previous one has been completed
+        u8 *ram = drive.mem.ram;
+        if (!(ram[0x00] & 0x80)) {
+
+            ram[0x06] = ram[0x06] >= 1 && ram[0x06] < 35 ? ram[0x06] + 1 : 1;
+            ram[0x07] = (ram[0x07] + 1) % 17;
+            ram[0x00] = 0x80;
+        }
+
+        for (isize i = 0; i < lines; i++) drive.execute(slice);
+    }
+
+    result.seconds = (Oscillator::nanos() - t0) / 1000000000.0;
+    result.cycles = drive.cpu.cycle - start;
+}
+
+void
+CoreBenchmark::writeToFile(const string &path) const
+{
+    std::ofstream out(path);
+    if (!out.is_open()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+
+    out << std::fixed;
+
+    for (auto &result : results) {
+
+        out << ChipCoreEnum::key(result.core) << '\t';
+        out << result.cycles << '\t';
+        out << std::setprecision(3) << result.seconds << '\t';
+        out << std::setprecision(3) << result.mhz() << '\t';
+        out << std::setprecision(3) << result.baseline << '\t';
+        out << std::setprecision(3) << result.speedup() << '\t';
+        out << result.problem << '\n';
+    }
+
+    if (!out.good()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+}
@@ -0,0 +1,141 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Object.h"
+#include "C64Types.h"
+
+/* Measures the speed of the chip cores in isolation. Other than Benchmark,
+ * which emulates the whole machine, each measurement drives a single core
+ * of a fresh headless instance directly and leaves all other components
+ * untouched.
+ *
+ *   CPU      The CPU executing a synthetic program from a flat RAM image
+ *   VICII    The VICII cycle functions drawing all display modes with all
+ *            sprites enabled (no CPU, no CIAs)
+ *   RESID    A reSID instance fed with a SID register stream
+ *   FASTSID  A FastSID instance fed with the same register stream
+ *   DRIVE    A VC1541 reading sectors from a blank disk (requires a VC1541
+ *            Rom)
+ *
+ * The register stream is synthesized unless a SID trace (see SIDTracer) has
+ * been loaded. All records of the trace are replayed on a single chip.
+ *
+ * The report is stored as a text file. Each core is described by a line of
+ * tab separated values (core, cycles, host time in seconds, emulated MHz,
+ * baseline MHz, speed relative to the baseline, problem). The report of a
+ * previous run can be loaded as a baseline. Cores without a baseline have a
+ * baseline value of 0.
+ */
+class CoreBenchmark : C64Object {
+
+public:
+
+    struct Result {
+
+        ChipCore core = CORE_CPU;
+
+        // Measurements
+        u64 cycles = 0;
+        double seconds = 0.0;
+
+        // Emulated MHz of a previous run (0 if unknown)
+        double baseline = 0.0;
+
+        // Reason for skipping the core (empty if it has been measured)
+        string problem;
+
+        double mhz() const { return seconds > 0 ? cycles / seconds / 1000000.0 : 0; }
+        double speedup() const { return baseline > 0 ? mhz() / baseline : 0; }
+    };
+
+private:
+
+    // A single SID register write
+    struct RegWrite {
+
+        // Cycles since the previous write
+        u32 delta;
+
+        u8 reg;
+        u8 value;
+    };
+
+    // Roms installed in each instance
+    std::vector<class RomFile *> roms;
+
+    // The register stream replayed by the SID cores
+    std::vector<RegWrite> regWrites;
+
+    // Emulated MHz of a previous run
+    double baselines[CORE_COUNT] = { };
+
+    // Results of the most recent run
+    std::vector<Result> results;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    CoreBenchmark();
+    ~CoreBenchmark();
+    const char *getDescription() const override { return "CoreBenchmark"; }
+
+    // Loads a Rom which is installed in each instance
+    void loadRom(const string &path) throws;
+
+    // Replaces the synthesized register stream by a recorded SID trace
+    void loadTrace(const string &path) throws;
+
+    // Loads the report of a previous run as baseline
+    void loadBaseline(const string &path) throws;
+
+
+    //
+    // Running
+    //
+
+public:
+
+    // Measures all cores
+    void run(u64 cycles);
+
+    // Measures a single core
+    Result run(ChipCore core, u64 cycles);
+
+private:
+
+    void measureCPU(class C64 &c64, u64 cycles, Result &result);
+    void measureVICII(class C64 &c64, u64 cycles, Result &result);
+    void measureSID(class C64 &c64, u64 cycles, Result &result);
+    void measureDrive(class C64 &c64, u64 cycles, Result &result);
+
+
+    //
+    // Querying
+    //
+
+public:
+
+    usize count() const { return results.size(); }
+    const Result &operator[](usize nr) const { return results[nr]; }
+
+
+    //
+    // Saving
+    //
+
+public:
+
+    void writeToFile(const string &path) const throws;
+};
@@ -9,9 +9,9 @@
 
 #include "C64.h"
 
-Datasette::~Datasette()
+Datasette::Datasette(C64 &ref) : C64Component(ref)
 {
-    if (data) delete[] data;
+    config.turbo = false;
 }
 
 void
@@ -22,15 +22,64 @@ Datasette::_reset()
     rewind();
 }
 
+void
+Datasette::_memoryUsage(MemoryUsage &usage)
+{
+    usage.heapBytes += pulses.capacity() * sizeof(u32);
+    usage.heapBytes += index.capacity() * sizeof(u64);
+}
+
+long
+Datasette::getConfigItem(Option option) const
+{
+    switch (option) {
+            
+        case OPT_DATASETTE_TURBO:  return config.turbo;
+            
+        default:
+            assert(false);
+            return 0;
+    }
+}
+
+bool
+Datasette::setConfigItem(Option option, long value)
+{
+    switch (option) {
+            
+        case OPT_DATASETTE_TURBO:
+            
+            if (config.turbo == value) return false;
+            
+            config.turbo = value;
+            return true;
+            
+        default:
+            return false;
+    }
+}
+
 void
 Datasette::setHeadInCycles(u64 value)
 {
-    printf("Fast forwarding to cycle %lld (duration %lld)\n", value, durationInCycles);
+    trace(TAP_DEBUG, "Fast forwarding to cycle %llu (duration %llu)\n", value, durationInCycles);
 
     rewind();
+    
+    // Jump to the last indexed position in front of the target
+    auto it = std::upper_bound(index.begin(), index.end(), value);
+    if (it != index.begin()) {
+        
+        --it;
+        head = (it - index.begin()) * indexSpacing;
+        headInCycles = *it;
+        headInSeconds = (u32)(headInCycles / c64.frequency);
+    }
+    
+    // Cover the remaining distance pulse by pulse
     while (headInCycles <= value && head < size) advanceHead(true);
 
-    printf("Head is %llu (max %llu)\n", head, size);
+    trace(TAP_DEBUG, "Head is %llu (max %llu)\n", head, size);
 }
 
 bool
@@ -38,18 +87,21 @@ Datasette::insertTape(TAPFile *a)
 {
     suspend();
     
-    size = a->getDataSize();
+    // Decode the pulses
+    pulses = a->decodePulses();
+    size = pulses.size();
     type = a->version();
     
-    trace(TAP_DEBUG, "Inserting tape (size = %llu, type = %d)...\n", size, type);
-    
-    // Copy data
-    data = (u8 *)malloc(size);
-    memcpy(data, a->getData(), size);
+    trace(TAP_DEBUG, "Inserting tape (%llu pulses, type = %d)...\n", size, type);
 
-    // Determine tape length (by fast forwarding)
+    // Determine tape length and build the index (by fast forwarding)
     rewind();
-    while (head < size) advanceHead(true /* Don't send progress messages */);
+    index.clear();
+    while (head < size) {
+        
+        if (head % indexSpacing == 0) index.push_back(headInCycles);
+        advanceHead(true /* Don't send progress messages */);
+    }
 
     durationInCycles = headInCycles;
     rewind();
@@ -72,12 +124,12 @@ Datasette::ejectTape()
     
     pressStop();
     
-    assert(data);
-    free(data);
-    data = nullptr;
+    pulses.clear();
+    pulses.shrink_to_fit();
     size = 0;
     type = 0;
     durationInCycles = 0;
+    index.clear();
     head = -1;
 
     c64.putMessage(MSG_VC1530_NO_TAPE);
@@ -90,10 +142,7 @@ Datasette::advanceHead(bool silent)
     assert(head < size);
     
     // Update head and headInCycles
-    int length, skip;
-    length = pulseLength(&skip);
-    head += skip;
-    headInCycles += length;
+    headInCycles += pulses[head++];
     
     // Send message if the tapeCounter (in seconds) changes
     u32 newHeadInSeconds = (u32)(headInCycles / c64.frequency);
@@ -104,34 +153,6 @@ Datasette::advanceHead(bool silent)
     headInSeconds = newHeadInSeconds;
 }
 
-int
-Datasette::pulseLength(int *skip) const
-{
-    assert(head < size);
-
-    if (data[head] != 0) {
-        // Pulse lengths between 1 * 8 and 255 * 8
-        if (skip) *skip = 1;
-        return 8 * data[head];
-    }
-    
-    if (type == 0) {
-        // Pulse lengths greater than 8 * 255 (TAP V0 files)
-        if (skip) *skip = 1;
-        return 8 * 256;
-    } else {
-        // Pulse lengths greater than 8 * 255 (TAP V1 files)
-        if (skip) *skip = 4;
-        if (head + 3 < size) {
-            return  LO_LO_HI_HI(data[head+1], data[head+2], data[head+3], 0);
-        } else {
-            warn("TAP file ended unexpectedly (%llu, %llu)\n", size, head + 3);
-            assert(false);
-            return 8 * 256;
-        }
-    }
-}
-
 void
 Datasette::pressPlay()
 {
@@ -139,21 +160,91 @@ Datasette::pressPlay()
         return;
     
     trace(TAP_DEBUG, "pressPlay\n");
+    bool wasRunning = isRunning();
     playKey = true;
 
     // Schedule first pulse
+    Cycle cycle = (Cycle)cpu.cycle;
     usize length = pulseLength();
-    nextRisingEdge = length / 2;
-    nextFallingEdge = length;
+    nextRisingEdge = cycle + length / 2;
+    nextFallingEdge = cycle + length;
+    stopCycle = cycle;
     advanceHead();
+    
+    updateRunning(wasRunning);
 }
 
 void
 Datasette::pressStop()
 {
     trace(TAP_DEBUG, "pressStop\n");
+    bool wasRunning = isRunning();
     motor = false;
     playKey = false;
+    
+    updateRunning(wasRunning);
+}
+
+void
+Datasette::setMotor(bool value)
+{
+    if (motor == value) return;
+    
+    bool wasRunning = isRunning();
+    motor = value;
+    
+    updateRunning(wasRunning);
+}
+
+void
+Datasette::updateRunning(bool wasRunning)
+{
+    if (isRunning() == wasRunning) return;
+    
+    Cycle cycle = (Cycle)cpu.cycle;
+    
+    if (wasRunning) {
+        
+        // The tape has stopped. Remember when.
+        stopCycle = cycle;
+        
+    } else {
+        
+        // The tape moves again. Delay all pending edges by the stop time.
+        nextRisingEdge += cycle - stopCycle;
+        nextFallingEdge += cycle - stopCycle;
+        c64.rescheduleEvents();
+    }
+}
+
+Cycle
+Datasette::nextEdge() const
+{
+    if (!isRunning()) return INT64_MAX;
+    
+    // The rising edge lies in the past once it has been triggered
+    return nextRisingEdge > (Cycle)cpu.cycle ? nextRisingEdge : nextFallingEdge;
+}
+
+void
+Datasette::vsyncHandler()
+{
+    /* The decision is made once per frame. Hence, loaders that switch the
+     * motor on and off rapidly don't toggle warp mode back and forth. The
+     * tape is processed exactly as in normal mode, i.e., all edges on the
+     * FLAG pin occur in the same cycles. Only the host stops pacing the
+     * emulator and the SID stops producing samples.
+     */
+    bool active = config.turbo && isRunning();
+    if (active == turbo) return;
+    
+    // Don't take over a warp mode which has been switched on by the user
+    if (active && c64.inWarpMode()) return;
+    
+    trace(TAP_DEBUG, "Turbo mode %s\n", active ? "on" : "off");
+    
+    turbo = active;
+    c64.setWarp(active);
 }
 
 void
@@ -161,13 +252,15 @@ Datasette::_execute()
 {
     // Only proceed if the datasette is active
     if (!hasTape() || !playKey || !motor) return;
-        
-    if (--nextRisingEdge == 0) {
+    
+    Cycle cycle = (Cycle)cpu.cycle;
+    
+    if (cycle == nextRisingEdge) {
         
         cia1.triggerRisingEdgeOnFlagPin();
     }
 
-    if (--nextFallingEdge == 0) {
+    if (cycle == nextFallingEdge) {
         
         cia1.triggerFallingEdgeOnFlagPin();
 
@@ -175,8 +268,8 @@ Datasette::_execute()
 
             // Schedule the next pulse
             usize length = pulseLength();
-            nextRisingEdge = length / 2;
-            nextFallingEdge = length;
+            nextRisingEdge = cycle + length / 2;
+            nextFallingEdge = cycle + length;
             advanceHead();
             
         } else {
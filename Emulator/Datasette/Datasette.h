@@ -10,42 +10,55 @@
 #pragma once
 
 #include "C64Component.h"
+#include <vector>
 
 class TAPFile;
 
 class Datasette : public C64Component {
     
+    // Current configuration
+    DatasetteConfig config;
+    
+    /* Indicates if warp mode has been switched on by the turbo mode. If the
+     * turbo mode is enabled, warp mode is switched on while the tape is
+     * moving and switched off again when the motor stops.
+     */
+    bool turbo = false;
+    
     //
     // Tape
     //
     
-    // Data buffer (contains the raw data of the TAP archive)
-    u8 *data = nullptr;
+    /* Pulse lengths in cycles. The TAP archive is decoded once when the tape
+     * is inserted (see TAPFile::decodePulses()).
+     */
+    std::vector<u32> pulses;
     
-    // Size of the attached data buffer
+    // Number of pulses on the tape
     u64 size = 0;
     
-    /* Data format (as specified in the TAP type).
-     *
-     * In TAP format 0, data byte 0 signals a long pulse without stating its
-     * length precisely.
-     *
-     * In TAP format 1, each 0 is followed by three bytes stating the precise
-     * length in LO_LO_HI_00 format.
-     */
+    // Data format (as specified in the TAP type)
     u8 type = 0;
     
     /* Tape length in cycles. The value is set when insertTape() is called. It
-     * is computed by iterating over all pulses in the data buffer.
+     * is computed by summing up all pulse lengths.
      */
     u64 durationInCycles = 0;
     
+    /* Sparse index of head positions. The index is built by insertTape() and
+     * records the position of every 'indexSpacing'-th pulse in cycles. It
+     * enables seeking without summing up all pulses in front of the target
+     * position.
+     */
+    std::vector<u64> index;
+    static constexpr usize indexSpacing = 1024;
+    
     
     //
     // Tape drive
     //
     
-    // The position of the read/write head inside the data buffer (0 ... size)
+    // The position of the read/write head inside the pulse array (0 ... size)
     u64 head = 0;
     
     // Head position measured in cycles
@@ -54,11 +67,15 @@ class Datasette : public C64Component {
     // Head position, measured in seconds
     u32 headInSeconds = 0;
     
-    // Next scheduled rising edge on data line
-    i64 nextRisingEdge = 0;
+    /* Cycles of the next rising and the next falling edge on the data line.
+     * The edges are scheduled in absolute CPU cycles. While the tape stands
+     * still, they are shifted by the time the tape hasn't been moving.
+     */
+    Cycle nextRisingEdge = 0;
+    Cycle nextFallingEdge = 0;
     
-    // Next scheduled falling edge on data line
-    i64 nextFallingEdge = 0;
+    // Cycle in which the tape has stopped moving
+    Cycle stopCycle = 0;
     
     // Indicates whether the play key is pressed
     bool playKey = false;
@@ -73,8 +90,7 @@ class Datasette : public C64Component {
     
 public:
  
-    Datasette(C64 &ref) : C64Component(ref) { };
-    ~Datasette();
+    Datasette(C64 &ref);
     const char *getDescription() const override { return "Datasette"; }
     
 private:
@@ -82,6 +98,18 @@ private:
     void _reset() override;
     
     
+    //
+    // Configuring
+    //
+    
+public:
+    
+    DatasetteConfig getConfig() const { return config; }
+    
+    long getConfigItem(Option option) const;
+    bool setConfigItem(Option option, long value) override;
+    
+    
     //
     // Serializing
     //
@@ -108,13 +136,17 @@ private:
         & headInSeconds
         & nextRisingEdge
         & nextFallingEdge
+        & stopCycle
         & playKey
         & motor;
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
+    void _memoryUsage(MemoryUsage &usage) override;
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
     
 
     //
@@ -164,12 +196,14 @@ public:
     // Returns the head position in seconds
     u32 getHeadInSeconds() const { return headInSeconds; }
     
-    // Sets the current head position in cycles.
+    /* Sets the current head position in cycles. The head is moved to the
+     * first pulse ending after the specified cycle. The closest indexed
+     * position in front of the target is looked up with a binary search.
+     */
     void setHeadInCycles(u64 value);
     
     // Returns the pulse length at the current head position
-    int pulseLength(int *skip) const;
-    int pulseLength() const { return pulseLength(nullptr); }
+    u32 pulseLength() const { assert(head < size); return pulses[head]; }
 
     
     //
@@ -189,13 +223,30 @@ public:
     bool getMotor() const { return motor; }
 
     // Switches the motor on or off
-    void setMotor(bool value) { motor = value; }
+    void setMotor(bool value);
 
+    // Returns true if the tape is moving
+    bool isRunning() const { return playKey && motor; }
+    
+    /* Returns the cycle in which the datasette needs to be serviced next
+     * (INT64_MAX if the tape isn't moving)
+     */
+    Cycle nextEdge() const;
+    
     // Emulates the datasette
-    void execute() { if (playKey && motor) _execute(); }
+    void execute() { if (isRunning()) _execute(); }
+    
+    // Returns true if warp mode has been switched on by the turbo mode
+    bool inTurboMode() const { return turbo; }
+    
+    // Switches the turbo mode on or off (called at the end of each frame)
+    void vsyncHandler();
 
 private:
 
     // Internal execution function
     void _execute();
+    
+    // Shifts the scheduled edges if the tape has stopped or started moving
+    void updateRunning(bool wasRunning);
 };
@@ -8,6 +8,9 @@
 // -----------------------------------------------------------------------------
 
 #include "C64.h"
+#include "Concurrency.h"
+#include "DiskCache.h"
+#include <atomic>
 
 const Disk::TrackDefaults Disk::trackDefaults[43] = {
     
@@ -143,11 +146,51 @@ Disk *
 Disk::makeWithG64(C64 &ref, G64File *g64)
 {
     Disk *disk = new Disk(ref);
+    u64 fnv = g64->fnv();
 
+    if (auto entry = DiskCache::lookup(fnv)) {
+        
+        disk->share(entry->data, entry->length);
+        disk->markClean(g64->path);
+        return disk;
+    }
+    
     disk->encodeG64(g64);
+    disk->markClean(g64->path);
+    DiskCache::insert(fnv, disk->data, disk->length);
     return disk;
 }
 
+Disk *
+Disk::makeWithD64(C64 &ref, D64File &d64)
+{
+    u64 fnv = d64.fnv();
+    
+    if (auto entry = DiskCache::lookup(fnv)) {
+        
+        Disk *disk = new Disk(ref);
+        disk->share(entry->data, entry->length);
+        disk->markClean(d64.path);
+        return disk;
+    }
+    
+    Disk *disk = new Disk(ref);
+    disk->encode(d64);
+    disk->markClean(d64.path);
+    
+    DiskCache::insert(fnv, disk->data, disk->length);
+    return disk;
+}
+
+Disk *
+Disk::makeWithD64(C64 &ref, D64File &d64, ErrorCode *err)
+{
+    *err = ERROR_OK;
+    try { return makeWithD64(ref, d64); }
+    catch (VC64Error &exception) { *err = exception.errorCode; }
+    return nullptr;
+}
+
 Disk *
 Disk::makeWithCollection(C64 &ref, AnyCollection &collection)
 {
@@ -188,6 +231,56 @@ Disk::_reset()
     RESET_SNAPSHOT_ITEMS
 }
 
+usize
+Disk::didLoadFromBuffer(u8 *buffer)
+{
+    // Discard all cached analysis results
+    for (Halftrack ht = 0; ht < 85; ht++) analysis[ht].valid = false;
+    trackInfoHalftrack = 0;
+    
+    // The relation to the source file is unknown
+    markDirty();
+    
+    return 0;
+}
+
+void
+Disk::markClean()
+{
+    for (Halftrack ht = 0; ht < 85; ht++) syncStamp[ht] = data.stamp[ht];
+}
+
+void
+Disk::markDirty()
+{
+    for (Halftrack ht = 0; ht < 85; ht++) syncStamp[ht] = UINT64_MAX;
+}
+
+bool
+Disk::isDirty() const
+{
+    for (Halftrack ht = 1; ht <= highestHalftrack; ht++) {
+        if (isDirty(ht)) return true;
+    }
+    return false;
+}
+
+void
+Disk::_memoryUsage(MemoryUsage &usage)
+{
+    for (isize ht = 0; ht < 85; ht++) {
+        
+        if (!data.isAllocated(ht)) continue;
+        
+        // Halftracks may be shared with a forked instance (copy-on-write)
+        if (data.storage[ht].use_count() > 1) {
+            usage.sharedBytes += maxBytesOnTrack;
+        } else {
+            usage.heapBytes += maxBytesOnTrack;
+        }
+    }
+}
+
 void
 Disk::_dump() const
 {
@@ -201,11 +294,23 @@ Disk::_dump() const
     msg("\n");
 }
 
+u64
+Disk::stateStamp()
+{
+    if (data.stampCounter != trackedStamp) {
+        
+        trackedStamp = data.stampCounter;
+        HardwareComponent::markDirty();
+    }
+    return HardwareComponent::stateStamp();
+}
+
 void
 Disk::setModified(bool b)
 {
     if (b != modified) {
         modified = b;
+        HardwareComponent::markDirty();
         // messageQueue.put(MSG_DISK_PROTECT);
     }
 }
@@ -232,15 +337,60 @@ Disk::encodeGcr(u8 value, Track t, HeadPos offset)
 }
 
 void
-Disk::encodeGcr(u8 *values, usize length, Track t, HeadPos offset)
+Disk::encodeGcr(const u8 *values, usize length, Track t, HeadPos offset)
 {
-    for (usize i = 0; i < length; i++, values++, offset += 10) {
+    assert(isTrackNumber(t));
+    
+    // Encode blocks of four bytes
+    for (; length >= 4; length -= 4, values += 4, offset += 40) {
+        writeBitsToTrack(t, offset, encodeGcr4(values), 40);
+    }
+    
+    // Encode the remaining bytes
+    for (; length > 0; length--, values++, offset += 10) {
         encodeGcr(*values, t, offset);
     }
 }
 
+u64
+Disk::encodeGcr4(const u8 *values)
+{
+    u64 result = 0;
+    
+    for (isize i = 0; i < 4; i++) {
+        result = result << 10 | gcr[values[i] >> 4] << 5 | gcr[values[i] & 0xF];
+    }
+    return result;
+}
+
+void
+Disk::decodeGcr4(u64 gcr, u8 *values)
+{
+    for (isize i = 0; i < 4; i++) {
+        
+        u8 nibble1 = invgcr[(gcr >> (35 - 10 * i)) & 0x1F];
+        u8 nibble2 = invgcr[(gcr >> (30 - 10 * i)) & 0x1F];
+        values[i] = (u8)(nibble1 << 4 | nibble2);
+    }
+}
+
+u64
+Disk::packGcr40(const u8 *gcrBits)
+{
+    u64 result = 0;
+    
+    // Collapse eight bit bytes into a single byte with a multiplication
+    for (isize i = 0; i < 5; i++, gcrBits += 8) {
+        
+        u64 bits;
+        memcpy(&bits, gcrBits, 8);
+        result = result << 8 | (bits * 0x8040201008040201) >> 56;
+    }
+    return result;
+}
+
 u8
-Disk::decodeGcrNibble(u8 *gcr)
+Disk::decodeGcrNibble(const u8 *gcr)
 {
     assert(gcr);
     
@@ -251,7 +401,7 @@ Disk::decodeGcrNibble(u8 *gcr)
 }
 
 u8
-Disk::decodeGcr(u8 *gcr)
+Disk::decodeGcr(const u8 *gcr)
 {
     assert(gcr);
     
@@ -261,6 +411,52 @@ Disk::decodeGcr(u8 *gcr)
     return (nibble1 << 4) | nibble2;
 }
 
+void
+Disk::decodeGcr(const u8 *gcrBits, usize length, u8 *dest)
+{
+    assert(gcrBits && dest);
+    
+    // Decode blocks of four bytes
+    for (; length >= 4; length -= 4, gcrBits += 40, dest += 4) {
+        decodeGcr4(packGcr40(gcrBits), dest);
+    }
+    
+    // Decode the remaining bytes
+    for (; length > 0; length--, gcrBits += 10) {
+        *dest++ = decodeGcr(gcrBits);
+    }
+}
+
+void
+Disk::writeBitsToHalftrack(Halftrack ht, HeadPos pos, u64 bits, isize count)
+{
+    assert(count >= 0 && count <= 64);
+    
+    // Write the bits one by one if the head position wraps over
+    if (pos < 0 || pos + count > length.halftrack[ht]) {
+        
+        for (isize i = count - 1; i >= 0; i--) {
+            writeBitToHalftrack(ht, pos++, (bits >> i) & 1);
+        }
+        return;
+    }
+    
+    u8 *ptr = data.modify(ht);
+    
+    // Merge the bits into the track data byte by byte
+    while (count > 0) {
+        
+        isize shift = pos % 8;
+        isize n = MIN(8 - shift, count);
+        u8 mask = (u8)(((1 << n) - 1) << (8 - shift - n));
+        u8 chunk = (u8)((bits >> (count - n)) << (8 - shift - n));
+        
+        ptr[pos / 8] = (ptr[pos / 8] & ~mask) | (chunk & mask);
+        pos += n;
+        count -= n;
+    }
+}
+
 bool
 Disk::isValidHeadPos(Halftrack ht, HeadPos pos) const
 {
@@ -297,8 +493,8 @@ Disk::_bitDelay(Halftrack ht, HeadPos pos) const {
 void
 Disk::clearHalftrack(Halftrack ht)
 {
-    memset(&data.halftrack[ht], 0x55, sizeof(data.halftrack[ht]));
-    length.halftrack[ht] = sizeof(data.halftrack[ht]) * 8;
+    data.clear(ht);
+    length.halftrack[ht] = maxBitsOnTrack;
 }
 
 void
@@ -311,13 +507,44 @@ Disk::clearDisk()
     }
     writeProtected = false;
     modified = false; 
+    HardwareComponent::markDirty();
+}
+
+void
+Disk::share(const Disk &other)
+{
+    share(other.data, other.length);
+    
+    writeProtected = other.writeProtected;
+    modified = other.modified;
+}
+
+void
+Disk::share(const DiskData &otherData, const DiskLength &otherLength)
+{
+    for (Halftrack ht = 0; ht < 85; ht++) {
+        
+        data.storage[ht] = otherData.storage[ht];
+        data.halftrack[ht] = otherData.halftrack[ht];
+        
+        // Stamps are local to each disk
+        data.stamp[ht] = ++data.stampCounter;
+        analysis[ht].valid = false;
+    }
+    length = otherLength;
+    trackInfoHalftrack = 0;
+    
+    // The relation to the source file is unknown
+    markDirty();
+    HardwareComponent::markDirty();
 }
 
 bool
 Disk::halftrackIsEmpty(Halftrack ht) const
 {
     assert(isHalftrackNumber(ht));
-    for (unsigned i = 0; i < sizeof(data.halftrack[ht]); i++)
+    if (!data.isAllocated(ht)) return true;
+    for (unsigned i = 0; i < maxBytesOnTrack; i++)
         if (data.halftrack[ht][i] != 0x55) return false;
     return true;
 }
@@ -366,23 +593,60 @@ Disk::analyzeHalftrack(Halftrack ht)
 {
     assert(isHalftrackNumber(ht));
     
-    u16 len = length.halftrack[ht];
-
-    errorLog.clear();
-    errorStartIndex.clear();
-    errorEndIndex.clear();
+    TrackAnalysis &cache = analysis[ht];
+    bool cached = isCached(ht);
+    
+    // Check if trackInfo is up to date
+    if (cached && trackInfoHalftrack == ht) return;
     
     // The result of the analysis is stored in variable trackInfo.
-    memset(&trackInfo, 0, sizeof(trackInfo));
-    trackInfo.length = len;
+    expandHalftrack(ht, trackInfo);
+    trackInfoHalftrack = ht;
+    
+    // Reuse the cached analysis result if the halftrack hasn't been modified
+    if (cached) {
+        memcpy(trackInfo.sectorInfo, cache.sectorInfo, sizeof(cache.sectorInfo));
+    } else {
+        analyzeLayout(ht, trackInfo, cache);
+    }
+    
+    errorLog = cache.errorLog;
+    errorStartIndex = cache.errorStartIndex;
+    errorEndIndex = cache.errorEndIndex;
+}
+
+bool
+Disk::isCached(Halftrack ht) const
+{
+    const TrackAnalysis &cache = analysis[ht];
+    return cache.valid && cache.stamp == data.stamp[ht] && cache.length == length.halftrack[ht];
+}
+
+void
+Disk::expandHalftrack(Halftrack ht, TrackInfo &info) const
+{
+    u16 len = length.halftrack[ht];
+
+    memset(&info, 0, sizeof(info));
+    info.length = len;
     
     // Setup working buffer (two copies of the track, each bit represented by one byte).
     for (unsigned i = 0; i < maxBytesOnTrack; i++)
-        trackInfo.byte[i] = bitExpansion[data.halftrack[ht][i]];
-    memcpy(trackInfo.bit + len, trackInfo.bit, len);
+        info.byte[i] = bitExpansion[data.halftrack[ht][i]];
+    memcpy(info.bit + len, info.bit, len);
+}
+
+void
+Disk::analyzeLayout(Halftrack ht, TrackInfo &info, TrackAnalysis &result) const
+{
+    u16 len = length.halftrack[ht];
+    
+    result.errorLog.clear();
+    result.errorStartIndex.clear();
+    result.errorEndIndex.clear();
     
     // Indicates where the sector headers blocks and the sectors data blocks start.
-    u8 sync[sizeof(trackInfo.bit)];
+    u8 sync[sizeof(info.bit)];
     memset(sync, 0, sizeof(sync));
     
     // Scan for SYNC sequences and decode the byte that follows.
@@ -390,23 +654,38 @@ Disk::analyzeHalftrack(Halftrack ht)
     long stop = (long)(2 * len - 10);
     for (long i = 0; i < stop; i++) {
         
-        assert(trackInfo.bit[i] <= 1);
-        if (trackInfo.bit[i] == 0 && noOfOnes >= 10) {
+        // Skip eight bits at once if they can't terminate a SYNC sequence
+        if ((i & 7) == 0 && i + 8 <= stop) {
+            
+            u64 chunk;
+            memcpy(&chunk, info.bit + i, 8);
+            u64 zeros = ~chunk & 0x0101010101010101;
+            
+            if (zeros == 0) {
+                noOfOnes += 8; i += 7; continue;
+            }
+            if (noOfOnes + __builtin_ctzll(zeros) / 8 < 10) {
+                noOfOnes = __builtin_clzll(zeros) / 8; i += 7; continue;
+            }
+        }
+        
+        assert(info.bit[i] <= 1);
+        if (info.bit[i] == 0 && noOfOnes >= 10) {
             
             // <--- SYNC ---><-- sync[i] -->
             // 11111 .... 1110
             //               ^ <- We are at offset i which is here
-            sync[i] = decodeGcr(trackInfo.bit + i);
+            sync[i] = decodeGcr(info.bit + i);
             
             if (sync[i] == 0x08) {
                 trace(GCR_DEBUG, "Sector header block found at offset %ld\n", i);
             } else if (sync[i] == 0x07) {
                 trace(GCR_DEBUG, "Sector data block found at offset %ld\n", i);
             } else {
-                log(i, 10, "Invalid sector ID %02X at index %d. Should be 0x07 or 0x08.", sync[i], i);
+                log(result, i, 10, "Invalid sector ID %02X at index %d. Should be 0x07 or 0x08.", sync[i], i);
             }
         }
-        noOfOnes = trackInfo.bit[i] ? (noOfOnes + 1) : 0;
+        noOfOnes = info.bit[i] ? (noOfOnes + 1) : 0;
     }
     
     // Lookup first sector header block
@@ -417,7 +696,7 @@ Disk::analyzeHalftrack(Halftrack ht)
         }
     }
     if (startOffset == len) {
-        log(0, len, "This track contains no sector header block.");
+        log(result, 0, len, "This track contains no sector header block.");
         return;
     }
     
@@ -427,24 +706,24 @@ Disk::analyzeHalftrack(Halftrack ht)
         
         if (sync[i] == 0x08) {
             
-            sector = decodeGcr(trackInfo.bit + i + 20);
+            sector = decodeGcr(info.bit + i + 20);
             
             if (isSectorNumber(sector)) {
-                if (trackInfo.sectorInfo[sector].headerEnd != 0)
+                if (info.sectorInfo[sector].headerEnd != 0)
                     break; // We've seen this sector already, so we are done.
-                trackInfo.sectorInfo[sector].headerBegin = i;
-                trackInfo.sectorInfo[sector].headerEnd = i + headerBlockSize;
+                info.sectorInfo[sector].headerBegin = i;
+                info.sectorInfo[sector].headerEnd = i + headerBlockSize;
             } else {
-                log(i + 20, 10, "Header block at index %d contains an invalid sector number (%d).", i, sector);
+                log(result, i + 20, 10, "Header block at index %d contains an invalid sector number (%d).", i, sector);
             }
         
         } else if (sync[i] == 0x07) {
             
             if (isSectorNumber(sector)) {
-                trackInfo.sectorInfo[sector].dataBegin = i;
-                trackInfo.sectorInfo[sector].dataEnd = i + dataBlockSize;
+                info.sectorInfo[sector].dataBegin = i;
+                info.sectorInfo[sector].dataEnd = i + dataBlockSize;
             } else {
-                log(i + 20, 10, "Data block at index %d contains an invalid sector number (%d).", i, sector);
+                log(result, i + 20, 10, "Data block at index %d contains an invalid sector number (%d).", i, sector);
             }
         }
     }
@@ -454,27 +733,33 @@ Disk::analyzeHalftrack(Halftrack ht)
     Track t = (ht + 1) / 2;
     for (Sector s = 0; s < trackDefaults[t].sectors; s++) {
         
-        SectorInfo *info = &trackInfo.sectorInfo[s];
-        bool hasHeader = info->headerBegin != info->headerEnd;
-        bool hasData = info->dataBegin != info->dataEnd;
+        SectorInfo *layout = &info.sectorInfo[s];
+        bool hasHeader = layout->headerBegin != layout->headerEnd;
+        bool hasData = layout->dataBegin != layout->dataEnd;
 
         if (!hasHeader && !hasData) {
-            log(0, 0, "Sector %d is missing.\n", s);
+            log(result, 0, 0, "Sector %d is missing.\n", s);
             continue;
         }
         
         if (hasHeader) {
-            analyzeSectorHeaderBlock(info->headerBegin);
+            analyzeSectorHeaderBlock(info, layout->headerBegin, result);
         } else {
-            log(0, 0, "Sector %d has no header block.\n", s);
+            log(result, 0, 0, "Sector %d has no header block.\n", s);
         }
         
         if (hasData) {
-            analyzeSectorDataBlock(info->dataBegin);
+            analyzeSectorDataBlock(info, layout->dataBegin, result);
         } else {
-            log(0, 0, "Sector %d has no data block.\n", s);
+            log(result, 0, 0, "Sector %d has no data block.\n", s);
         }
     }
+    
+    // Record the analyzed halftrack version
+    result.valid = true;
+    result.stamp = data.stamp[ht];
+    result.length = len;
+    memcpy(result.sectorInfo, info.sectorInfo, sizeof(result.sectorInfo));
 }
 
 void
@@ -485,42 +770,46 @@ Disk::analyzeTrack(Track t)
 }
 
 void
-Disk::analyzeSectorHeaderBlock(usize offset)
+Disk::analyzeSectorHeaderBlock(const TrackInfo &info, usize offset, TrackAnalysis &result)
 {
     // The first byte must be 0x08 (indicating a header block)
-    assert(decodeGcr(trackInfo.bit + offset) == 0x08);
+    assert(decodeGcr(info.bit + offset) == 0x08);
     offset += 10;
     
-    u8 s = decodeGcr(trackInfo.bit + offset + 10);
-    u8 t = decodeGcr(trackInfo.bit + offset + 20);
-    u8 id2 = decodeGcr(trackInfo.bit + offset + 30);
-    u8 id1 = decodeGcr(trackInfo.bit + offset + 40);
+    u8 s = decodeGcr(info.bit + offset + 10);
+    u8 t = decodeGcr(info.bit + offset + 20);
+    u8 id2 = decodeGcr(info.bit + offset + 30);
+    u8 id1 = decodeGcr(info.bit + offset + 40);
     u8 checksum = id1 ^ id2 ^ t ^ s;
 
-    if (checksum != decodeGcr(trackInfo.bit + offset)) {
-        log(offset, 10, "Header block at index %d contains an invalid checksum.\n", offset);
+    if (checksum != decodeGcr(info.bit + offset)) {
+        log(result, offset, 10, "Header block at index %d contains an invalid checksum.\n", offset);
     }
 }
 
 void
-Disk::analyzeSectorDataBlock(usize offset)
+Disk::analyzeSectorDataBlock(const TrackInfo &info, usize offset, TrackAnalysis &result)
 {
     // The first byte must be 0x07 (indicating a header block)
-    assert(decodeGcr(trackInfo.bit + offset) == 0x07);
+    assert(decodeGcr(info.bit + offset) == 0x07);
     offset += 10;
     
+    u8 block[257];
+    decodeGcr(info.bit + offset, 257, block);
+    offset += 256 * 10;
+    
     u8 checksum = 0;
-    for (unsigned i = 0; i < 256; i++, offset += 10) {
-        checksum ^= decodeGcr(trackInfo.bit + offset);
+    for (unsigned i = 0; i < 256; i++) {
+        checksum ^= block[i];
     }
     
-    if (checksum != decodeGcr(trackInfo.bit + offset)) {
-        log(offset, 10, "Data block at index %d contains an invalid checksum.\n", offset);
+    if (checksum != block[256]) {
+        log(result, offset, 10, "Data block at index %d contains an invalid checksum.\n", offset);
     }
 }
 
 void
-Disk::log(usize begin, usize length, const char *fmt, ...)
+Disk::log(TrackAnalysis &result, usize begin, usize length, const char *fmt, ...)
 {
     char buf[256];
     
@@ -529,9 +818,73 @@ Disk::log(usize begin, usize length, const char *fmt, ...)
     vsnprintf(buf, sizeof(buf), fmt, ap);
     va_end(ap);
 
-    errorLog.push_back(std::string(buf));
-    errorStartIndex.push_back(begin);
-    errorEndIndex.push_back(begin + length);
+    result.errorLog.push_back(std::string(buf));
+    result.errorStartIndex.push_back(begin);
+    result.errorEndIndex.push_back(begin + length);
+}
+
+usize
+Disk::trackBytes(u8 *dest, usize offset, usize count) const
+{
+    usize bytes = (trackInfo.length + 7) / 8;
+    if (trackInfoHalftrack == 0 || offset >= bytes) return 0;
+    
+    count = std::min(count, bytes - offset);
+    memcpy(dest, data.halftrack[trackInfoHalftrack] + offset, count);
+    return count;
+}
+
+void
+Disk::annotateTrack(u8 *dest, usize offset, usize count) const
+{
+    usize len = trackInfo.length;
+    memset(dest, GCR_MARK_GAP, count);
+    
+    // Marks the intersection with a range of the doubled bit stream
+    auto mark = [&](usize begin, usize end, GcrMark value) {
+        
+        for (usize i = begin; i < end; i++) {
+            
+            usize pos = i % len;
+            if (pos >= offset && pos < offset + count) dest[pos - offset] = (u8)value;
+        }
+    };
+    
+    if (len == 0) return;
+    
+    for (isize s = 0; s < 22; s++) {
+        
+        const SectorInfo &info = trackInfo.sectorInfo[s];
+        mark(info.headerBegin, info.headerEnd, GCR_MARK_HEADER);
+        mark(info.dataBegin, info.dataEnd, GCR_MARK_DATA);
+    }
+    for (usize i = 0; i < errorLog.size(); i++) {
+        mark(errorStartIndex[i], errorEndIndex[i], GCR_MARK_ERROR);
+    }
+}
+
+usize
+Disk::sectorHeaderBytes(Sector nr, u8 *dest) const
+{
+    assert(isSectorNumber(nr));
+    
+    const SectorInfo &info = trackInfo.sectorInfo[nr];
+    if (info.headerBegin == info.headerEnd) return 0;
+    
+    decodeGcr(trackInfo.bit + info.headerBegin, 10, dest);
+    return 10;
+}
+
+usize
+Disk::sectorDataBytes(Sector nr, u8 *dest) const
+{
+    assert(isSectorNumber(nr));
+    
+    const SectorInfo &info = trackInfo.sectorInfo[nr];
+    if (info.dataBegin == info.dataEnd) return 0;
+    
+    decodeGcr(trackInfo.bit + info.dataBegin, 256, dest);
+    return 256;
 }
 
 const char *
@@ -653,21 +1006,102 @@ Disk::decodeDisk(u8 *dest, unsigned numTracks)
 }
 
 usize
-Disk::decodeTrack(Track t, u8 *dest)
+Disk::decodeDiskParallel(u8 *dest, isize numThreads)
 {
-    unsigned numBytes = 0;
-    unsigned numSectors = numberOfSectorsInTrack(t);
+    // Determine highest non-empty track
+    Track t = 42;
+    while (t > 0 && trackIsEmpty(t)) t--;
+    
+    // Determine the tracks to decode
+    unsigned numTracks = t <= 35 ? 35 : t <= 40 ? 40 : 42;
+    for (t = 1; t <= numTracks && !trackIsEmpty(t); t++);
+    numTracks = t - 1;
+    
+    if (numThreads <= 1 || numTracks == 0) return decodeDisk(dest);
+    numThreads = MIN(numThreads, (isize)numTracks);
+    
+    // Decode all tracks into separate buffers
+    static constexpr usize trackSize = 21 * 256;
+    std::unique_ptr<u8[]> buffer(new u8[numTracks * trackSize]);
+    usize numBytes[43] = { };
+    std::atomic<unsigned> next { 1 };
+    
+    auto job = [&]() {
+        
+        std::unique_ptr<TrackInfo> info(new TrackInfo);
+        
+        for (Track t = next++; t <= numTracks; t = next++) {
+            
+            Halftrack ht = 2 * t - 1;
+            
+            // Each job only accesses the cache entry of its own halftracks
+            expandHalftrack(ht, *info);
+            if (isCached(ht)) {
+                memcpy(info->sectorInfo, analysis[ht].sectorInfo, sizeof(info->sectorInfo));
+            } else {
+                analyzeLayout(ht, *info, analysis[ht]);
+            }
+            numBytes[t] = decodeTrack(*info, t, buffer.get() + (t - 1) * trackSize);
+        }
+    };
+    
+    std::unique_ptr<WorkerThread[]> workers(new WorkerThread[numThreads]);
+    for (isize i = 0; i < numThreads; i++) workers[i].run(job);
+    for (isize i = 0; i < numThreads; i++) workers[i].join();
+    
+    // Assemble the result in track order
+    usize total = 0;
+    for (t = 1; t <= numTracks; t++) {
+        
+        if (dest) memcpy(dest + total, buffer.get() + (t - 1) * trackSize, numBytes[t]);
+        total += numBytes[t];
+    }
+    
+    // Leave trackInfo and the error log in the same state as decodeDisk()
+    trackInfoHalftrack = 0;
+    analyzeTrack(numTracks);
+    
+    return total;
+}
 
+bool
+Disk::decodeSector(Track t, Sector s, u8 *dest)
+{
+    assert(isValidTrackSectorPair(t, s));
+    assert(dest);
+    
     // Gather sector information
     analyzeTrack(t);
+    
+    SectorInfo layout = trackInfo.sectorInfo[s];
+    if (layout.dataBegin == layout.dataEnd) return false;
+    
+    decodeSector(trackInfo, layout.dataBegin, dest);
+    return true;
+}
+
+usize
+Disk::decodeTrack(Track t, u8 *dest)
+{
+    // Gather sector information
+    analyzeTrack(t);
+    
+    return decodeTrack(trackInfo, t, dest);
+}
+
+usize
+Disk::decodeTrack(const TrackInfo &info, Track t, u8 *dest) const
+{
+    unsigned numBytes = 0;
+    unsigned numSectors = numberOfSectorsInTrack(t);
 
     // For each sector ...
     for (unsigned s = 0; s < numSectors; s++) {
         
         trace(GCR_DEBUG, "   Decoding sector %d\n", s);
-        SectorInfo info = sectorLayout(s);
-        if (info.dataBegin != info.dataEnd) {
-            numBytes += decodeSector(info.dataBegin, dest + (dest ? numBytes : 0));
+        SectorInfo layout = info.sectorInfo[s];
+        if (layout.dataBegin != layout.dataEnd) {
+            numBytes += decodeSector(info, layout.dataBegin, dest + (dest ? numBytes : 0));
         } else {
 
             // The decoder failed to decode this sector.
@@ -681,18 +1115,13 @@ Disk::decodeTrack(Track t, u8 *dest)
 }
 
 usize
-Disk::decodeSector(usize offset, u8 *dest)
+Disk::decodeSector(const TrackInfo &info, usize offset, u8 *dest)
 {
     // The first byte must be 0x07 (indicating a data block)
-    assert(decodeGcr(trackInfo.bit + offset) == 0x07);
+    assert(decodeGcr(info.bit + offset) == 0x07);
     offset += 10;
     
-    if (dest) {
-        for (unsigned i = 0; i < 256; i++) {
-            dest[i] = decodeGcr(trackInfo.bit + offset);
-            offset += 10;
-        }
-    }
+    if (dest) decodeGcr(info.bit + offset, 256, dest);
     
     return 256;
 }
@@ -728,12 +1157,34 @@ Disk::encodeG64(G64File *a)
         trace(GCR_DEBUG, "  Encoding halftrack %d (%d bytes)\n", ht, size);
         length.halftrack[ht] = 8 * size;
         
-        a->copyHalftrack(ht, data.halftrack[ht]);
+        a->copyHalftrack(ht, data.modify(ht));
     }
+    
+    // The disk now matches its source
+    markClean();
 }
 
 void
 Disk::encode(FSDevice &fs, bool alignTracks)
+{
+    u32 numBlocks = fs.getNumBlocks();
+    
+    // Collect the error codes of all blocks
+    std::vector<u8> errors(numBlocks);
+    for (u32 b = 0; b < numBlocks; b++) errors[b] = fs.getErrorCode(b);
+    
+    // The file system stores all blocks in D64 order
+    encode(fs.blockData(0), errors.data(), fs.getNumTracks(), alignTracks);
+}
+
+void
+Disk::encode(D64File &d64, bool alignTracks)
+{
+    encode(d64.data, d64.errors, d64.numTracks(), alignTracks);
+}
+
+void
+Disk::encode(const u8 *image, const u8 *errors, Track numTracks, bool alignTracks)
 {    
     // 64COPY (fails on VICE test drive/skew)
     /*
@@ -770,7 +1221,9 @@ Disk::encode(FSDevice &fs, bool alignTracks)
     */
     
     usize encodedBits;
-    unsigned numTracks = fs.getNumTracks();
+    
+    // The disk ID is stored in the BAM (track 18, sector 0)
+    const u8 *diskId = image + 357 * 256 + 0xA2;
 
     trace(GCR_DEBUG, "Encoding disk with %d tracks\n", numTracks);
 
@@ -785,25 +1238,33 @@ Disk::encode(FSDevice &fs, bool alignTracks)
     HeadPos start;
     for (Track t = 1; t <= numTracks; t++) {
         
+        Sector numSectors = trackDefaults[t].sectors;
         unsigned zone = speedZoneOfTrack(t);
         if (alignTracks) {
             start = (HeadPos)(length.track[t][0] * trackDefaults[t].stagger);
         } else {
             start = 0;
         }
-        encodedBits = encodeTrack(fs, t, tailGap[zone], start);
+        encodedBits = encodeTrack(image, errors, diskId, t, tailGap[zone], start);
         trace(GCR_DEBUG, "Encoded %zu bits (%lu bytes) for track %d.\n",
               encodedBits, encodedBits / 8, t);
+        
+        image += numSectors * 256;
+        errors += numSectors;
     }
 
     // Do some consistency checking
     for (Halftrack ht = 1; ht <= highestHalftrack; ht++) {
-        assert(length.halftrack[ht] <= sizeof(data.halftrack[ht]) * 8);
+        assert(length.halftrack[ht] <= maxBitsOnTrack);
     }
+    
+    // The disk now matches its source
+    markClean();
 }
 
 usize
-Disk::encodeTrack(FSDevice &fs, Track t, u8 tailGap, HeadPos start)
+Disk::encodeTrack(const u8 *sectors, const u8 *errors, const u8 *diskId,
+                  Track t, u8 tailGap, HeadPos start)
 {
     assert(isTrackNumber(t));
     trace(GCR_DEBUG, "Encoding track %d\n", t);
@@ -813,7 +1274,8 @@ Disk::encodeTrack(FSDevice &fs, Track t, u8 tailGap, HeadPos start)
     // For each sector in this track ...
     for (Sector s = 0; s < trackDefaults[t].sectors; s++) {
         
-        usize encodedBits = encodeSector(fs, t, s, start, tailGap);
+        usize encodedBits = encodeSector(sectors + s * 256, errors[s], diskId,
+                                         t, s, start, tailGap);
         start += (HeadPos)encodedBits;
         totalEncodedBits += encodedBits;
     }
@@ -822,20 +1284,18 @@ Disk::encodeTrack(FSDevice &fs, Track t, u8 tailGap, HeadPos start)
 }
 
 usize
-Disk::encodeSector(FSDevice &fs, Track t, Sector s, HeadPos start, int tailGap)
+Disk::encodeSector(const u8 *data, u8 errorCode, const u8 *diskId,
+                   Track t, Sector s, HeadPos start, int tailGap)
 {
     assert(isValidTrackSectorPair(t, s));
     
-    TSLink ts = TSLink{t,s};
-    
     HeadPos offset = start;
-    u8 errorCode = fs.getErrorCode(ts);
         
     trace(GCR_DEBUG, "  Encoding track/sector %d/%d\n", t, s);
     
     // Get disk id and compute checksum
-    u8 id1 = fs.diskId1();
-    u8 id2 = fs.diskId2();
+    u8 id1 = diskId[0];
+    u8 id2 = diskId[1];
     u8 checksum = id1 ^ id2 ^ t ^ s; // Header checksum byte
     
     // SYNC (0xFF 0xFF 0xFF 0xFF 0xFF)
@@ -846,46 +1306,27 @@ Disk::encodeSector(FSDevice &fs, Track t, Sector s, HeadPos start, int tailGap)
     }
     offset += 40;
     
-    // Header ID
-    if (errorCode == 0x2) {
-        encodeGcr(0x00, t, offset); // HEADER_BLOCK_NOT_FOUND_ERROR
-    } else {
-        encodeGcr(0x08, t, offset);
-    }
-    offset += 10;
- 
-    // Checksum
-    if (errorCode == 0x9) {
-        encodeGcr(checksum ^ 0xFF, t, offset); // HEADER_BLOCK_CHECKSUM_ERROR
-    } else {
-        encodeGcr(checksum, t, offset);
-    }
-    offset += 10;
-    
-    // Sector and track number
-    encodeGcr(s, t, offset);
-    offset += 10;
-    encodeGcr(t, t, offset);
-    offset += 10;
-    
-    // Disk ID (two bytes)
-     if (errorCode == 0xB) {
-         encodeGcr(id2 ^ 0xFF, t, offset); // DISK_ID_MISMATCH_ERROR
-         offset += 10;
-         encodeGcr(id1 ^ 0xFF, t, offset); // DISK_ID_MISMATCH_ERROR
-     } else {
-         encodeGcr(id2, t, offset);
-         offset += 10;
-         encodeGcr(id1, t, offset);
-     }
-    offset += 10;
-    
-    // 0x0F, 0x0F
-    encodeGcr(0x0F, t, offset);
-    offset += 10;
-    encodeGcr(0x0F, t, offset);
-    offset += 10;
-
+    // Header block (encoded in a single batch)
+    u8 header[8] = {
+        
+        // Header ID
+        (u8)(errorCode == 0x2 ? 0x00 : 0x08), // HEADER_BLOCK_NOT_FOUND_ERROR
+        
+        // Checksum
+        (u8)(errorCode == 0x9 ? checksum ^ 0xFF : checksum), // HEADER_BLOCK_CHECKSUM_ERROR
+        
+        // Sector and track number
+        (u8)s, (u8)t,
+        
+        // Disk ID (two bytes)
+        (u8)(errorCode == 0xB ? id2 ^ 0xFF : id2), // DISK_ID_MISMATCH_ERROR
+        (u8)(errorCode == 0xB ? id1 ^ 0xFF : id1), // DISK_ID_MISMATCH_ERROR
+        
+        // 0x0F, 0x0F
+        0x0F, 0x0F
+    };
+    encodeGcr(header, 8, t, offset);
+    offset += 8 * 10;
     
     // 0x55 0x55 0x55 0x55 0x55 0x55 0x55 0x55 0x55
     writeGapToTrack(t, offset, 9);
@@ -913,28 +1354,16 @@ Disk::encodeSector(FSDevice &fs, Track t, Sector s, HeadPos start, int tailGap)
     }
     offset += 10;
     
-    // Data bytes
+    // Data bytes, checksum, 0x00, 0x00 (encoded in a single batch)
+    u8 block[259];
     checksum = 0;
-    for (unsigned i = 0; i < 256; i++, offset += 10) {
-        // u8 byte = (u8)d64->readTrack();
-        u8 byte = fs.readByte(ts, i);
-        checksum ^= byte;
-        encodeGcr(byte, t, offset);
-    }
-    
-    // Checksum
-    if (errorCode == 0x5) {
-        encodeGcr(checksum ^ 0xFF, t, offset); // DATA_BLOCK_CHECKSUM_ERROR
-    } else {
-        encodeGcr(checksum, t, offset);
-    }
-    offset += 10;
-    
-    // 0x00, 0x00
-    encodeGcr(0x00, t, offset);
-    offset += 10;
-    encodeGcr(0x00, t, offset);
-    offset += 10;
+    memcpy(block, data, 256);
+    for (unsigned i = 0; i < 256; i++) checksum ^= data[i];
+    block[256] = errorCode == 0x5 ? checksum ^ 0xFF : checksum; // DATA_BLOCK_CHECKSUM_ERROR
+    block[257] = 0x00;
+    block[258] = 0x00;
+    encodeGcr(block, 259, t, offset);
+    offset += 259 * 10;
     
     // Tail gap (0x55 0x55 ... 0x55)
     writeGapToTrack(t, offset, tailGap);
@@ -125,6 +125,31 @@ private:
     
     // Track layout as determined by analyzeTrack
     TrackInfo trackInfo;
+    
+    // The halftrack stored in trackInfo (0 if none)
+    Halftrack trackInfoHalftrack = 0;
+    
+    // Cached analysis results for each halftrack
+    TrackAnalysis analysis[85];
+    
+    
+    //
+    // Write-back journal
+    //
+    
+    /* Modification stamps of all halftracks at the time the disk was last
+     * synchronized with its source file. A halftrack needs to be written back
+     * if its current stamp differs.
+     */
+    u64 syncStamp[85] = { };
+    
+    /* The file the journal refers to. When writing into any other file, all
+     * halftracks count as modified.
+     */
+    string syncPath;
+    
+    // Value of data.stampCounter when stateStamp() was last called
+    u64 trackedStamp = 0;
 
     // Error log created by analyzeTrack
     std::vector<std::string> errorLog;
@@ -167,6 +192,8 @@ public:
     static Disk *make(C64 &ref, DOSType type, PETName<16> name);
     static Disk *makeWithFileSystem(C64 &ref, class FSDevice &device);
     static Disk *makeWithG64(C64 &ref, G64File *g64);
+    static Disk *makeWithD64(C64 &ref, class D64File &d64) throws;
+    static Disk *makeWithD64(C64 &ref, class D64File &d64, ErrorCode *err);
     static Disk *makeWithCollection(C64 &ref, AnyCollection &archive);
 
 
@@ -216,8 +243,20 @@ private:
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
+    void _memoryUsage(MemoryUsage &usage) override;
+    bool hasFixedSize() const override { return false; }
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
+    usize didLoadFromBuffer(u8 *buffer) override;
+    
+    /* Writes to the disk data are detected via the modification stamps. Note
+     * that markDirty() refers to the halftracks in this class. The change
+     * tracking flag is set via HardwareComponent::markDirty().
+     */
+    bool tracksChanges() const override { return true; }
+    u64 stateStamp() override;
     
     
     //
@@ -227,13 +266,37 @@ private:
 public:
     
     bool isWriteProtected() const { return writeProtected; }
-    void setWriteProtection(bool b) { writeProtected = b; }
-    void toggleWriteProtection() { writeProtected = !writeProtected; }
+    void setWriteProtection(bool b) { writeProtected = b; HardwareComponent::markDirty(); }
+    void toggleWriteProtection() { writeProtected = !writeProtected; HardwareComponent::markDirty(); }
 
     bool isModified() const { return modified; }
     void setModified(bool b);
     
     
+    //
+    // Tracking modifications
+    //
+    
+public:
+    
+    // Checks if a halftrack or any halftrack has changed since the last sync
+    bool isDirty(Halftrack ht) const { return data.stamp[ht] != syncStamp[ht]; }
+    bool isDirty() const;
+    
+    // Marks a single halftrack or all halftracks as synchronized
+    void markClean(Halftrack ht) { syncStamp[ht] = data.stamp[ht]; }
+    void markClean();
+    
+    // Marks all halftracks as synchronized with the specified file
+    void markClean(const string &path) { markClean(); syncPath = path; }
+    
+    // Returns the file the journal refers to
+    const string &getSyncPath() const { return syncPath; }
+    
+    // Marks all halftracks as modified
+    void markDirty();
+    
+    
     //
     // Handling GCR encoded data
     //
@@ -252,18 +315,34 @@ public:
      * byte, 10 bits are written to the specified disk position.
      */
     void encodeGcr(u8 value, Track t, HeadPos offset);
-    void encodeGcr(u8 *values, usize length, Track t, HeadPos offset);
+    void encodeGcr(const u8 *values, usize length, Track t, HeadPos offset);
+    
+    /* Encodes four bytes into 40 GCR bits or vice versa. These functions are
+     * the batch kernels for encoding and decoding whole blocks. The GCR bits
+     * are kept in the lower 40 bits of a 64 bit value (MSB first). Decoding
+     * invalid GCR codewords yields the same results as decodeGcr().
+     */
+    static u64 encodeGcr4(const u8 *values);
+    static void decodeGcr4(u64 gcr, u8 *values);
+    
+    /* Packs 40 bits of an expanded bit stream (one byte per bit) as used by
+     * analyzeTrack() into a 64 bit value (MSB first).
+     */
+    static u64 packGcr40(const u8 *gcrBits);
     
     
     /* Decodes a nibble (4 bit) from a previously encoded GCR bitstream.
      * Returns 0xFF, if no valid GCR sequence is found.
      */
-    u8 decodeGcrNibble(u8 *gcrBits);
+    static u8 decodeGcrNibble(const u8 *gcrBits);
 
     /* Decodes a byte (8 bit) form a previously encoded GCR bitstream. Returns
      * an unpredictable result if invalid GCR sequences are found.
      */
-    u8 decodeGcr(u8 *gcrBits);
+    static u8 decodeGcr(const u8 *gcrBits);
+    
+    // Decodes multiple bytes from a previously encoded GCR bitstream
+    static void decodeGcr(const u8 *gcrBits, usize length, u8 *dest);
 
     
     //
@@ -299,9 +378,9 @@ public:
     void _writeBitToHalftrack(Halftrack ht, HeadPos pos, bool bit) {
         assert(isValidHeadPos(ht, pos));
         if (bit) {
-            data.halftrack[ht][pos / 8] |= (0x0080 >> (pos % 8));
+            data.modify(ht)[pos / 8] |= (0x0080 >> (pos % 8));
         } else {
-            data.halftrack[ht][pos / 8] &= (0xFF7F >> (pos % 8));
+            data.modify(ht)[pos / 8] &= (0xFF7F >> (pos % 8));
         }
     }
     void _writeBitToTrack(Track t, HeadPos pos, bool bit) {
@@ -310,14 +389,24 @@ public:
     void writeBitToHalftrack(Halftrack ht, HeadPos pos, bool bit) {
         _writeBitToHalftrack(ht, wrap(ht, pos), bit);
     }
+    
+    /* Writes up to 64 bits in a row. The bits are taken from the lower count
+     * bits of the provided value (MSB first). The head position is wrapped
+     * over like in writeBitToHalftrack().
+     */
+    void writeBitsToHalftrack(Halftrack ht, HeadPos pos, u64 bits, isize count);
+    void writeBitsToTrack(Track t, HeadPos pos, u64 bits, isize count) {
+        writeBitsToHalftrack(2 * t - 1, pos, bits, count);
+    }
     void writeBitToTrack(Track t, HeadPos pos, bool bit) {
         _writeBitToHalftrack(2 * t - 1, pos, bit);
     }
     
     // Writes a bit multiple times
     void writeBitToHalftrack(Halftrack ht, HeadPos pos, bool bit, usize count) {
-        for (usize i = 0; i < count; i++)
-            writeBitToHalftrack(ht, pos++, bit);
+        for (; count >= 64; count -= 64, pos += 64)
+            writeBitsToHalftrack(ht, pos, bit ? UINT64_MAX : 0, 64);
+        writeBitsToHalftrack(ht, pos, bit ? UINT64_MAX : 0, (isize)count);
     }
     void writeBitToTrack(Track t, HeadPos pos, bool bit, usize count) {
             writeBitToHalftrack(2 * t - 1, pos, bit, count);
@@ -325,8 +414,7 @@ public:
 
     // Writes a single byte
     void writeByteToHalftrack(Halftrack ht, HeadPos pos, u8 byte) {
-        for (u8 mask = 0x80; mask != 0; mask >>= 1)
-            writeBitToHalftrack(ht, pos++, byte & mask);
+        writeBitsToHalftrack(ht, pos, byte, 8);
     }
     void writeByteToTrack(Track t, HeadPos pos, u8 byte) {
         writeByteToHalftrack(2 * t - 1, pos, byte);
@@ -334,8 +422,9 @@ public:
     
     // Writes a certain number of interblock bytes to disk
     void writeGapToHalftrack(Halftrack ht, HeadPos pos, usize length) {
-        for (usize i = 0; i < length; i++, pos += 8)
-            writeByteToHalftrack(ht, pos, 0x55);
+        for (; length >= 8; length -= 8, pos += 64)
+            writeBitsToHalftrack(ht, pos, 0x5555555555555555, 64);
+        writeBitsToHalftrack(ht, pos, 0x5555555555555555, 8 * (isize)length);
     }
     void writeGapToTrack(Track t, HeadPos pos, usize length) {
         writeGapToHalftrack(2 * t - 1, pos, length);
@@ -349,6 +438,12 @@ public:
      */
     void clearDisk();
     
+    /* Replaces the disk contents by the contents of another disk. All
+     * halftracks are shared and copied on the first write access.
+     */
+    void share(const Disk &other);
+    void share(const DiskData &otherData, const DiskLength &otherLength);
+    
     /* Checks whether a track or halftrack is cleared. Avoid calling these
      * methods frequently, because they scan the whole track.
      */
@@ -368,19 +463,34 @@ public:
     u16 lengthOfTrack(Track t) const;
     
     /* Analyzes the sector layout. The functions determines the start and end
-     * offsets of all sectors and writes them into variable trackLayout.
+     * offsets of all sectors and writes them into variable trackLayout. The
+     * results are cached. A halftrack is only reanalyzed if it has been
+     * written to since the last analysis.
      */
     void analyzeHalftrack(Halftrack ht);
     void analyzeTrack(Track t);
     
 private:
     
+    // Checks if the cached analysis result of a halftrack is up to date
+    bool isCached(Halftrack ht) const;
+    
+    // Converts a halftrack into the bit stream representation of TrackInfo
+    void expandHalftrack(Halftrack ht, TrackInfo &info) const;
+    
+    /* Scans the bits of an expanded halftrack and determines the sector
+     * layout. The layout and the error log are written into the provided
+     * analysis result. The function doesn't modify the disk object and can
+     * be called for different halftracks in parallel.
+     */
+    void analyzeLayout(Halftrack ht, TrackInfo &info, TrackAnalysis &result) const;
+    
     // Checks the integrity of a sector header or sector data block
-    void analyzeSectorHeaderBlock(usize offset);
-    void analyzeSectorDataBlock(usize offset);
+    static void analyzeSectorHeaderBlock(const TrackInfo &info, usize offset, TrackAnalysis &result);
+    static void analyzeSectorDataBlock(const TrackInfo &info, usize offset, TrackAnalysis &result);
 
     // Writes an error message into the error log
-    void log(usize begin, usize length, const char *fmt, ...);
+    static void log(TrackAnalysis &result, usize begin, usize length, const char *fmt, ...);
     
 public:
     
@@ -400,6 +510,32 @@ public:
     // Reads the error end index from the error log
     usize lastErroneousBit(unsigned nr) const { return errorEndIndex.at(nr); }
     
+    /* Provides binary access to the data stored in trackInfo. Unlike the
+     * textual representations below, the functions operate on ranges. Hence,
+     * the GUI only needs to convert the part of the track that is visible.
+     */
+    
+    // Returns the length of the analyzed halftrack in bits
+    usize trackLength() const { return trackInfo.length; }
+    
+    /* Copies a range of raw GCR bytes of the analyzed halftrack. The function
+     * returns the number of copied bytes.
+     */
+    usize trackBytes(u8 *dest, usize offset, usize count) const;
+    
+    /* Classifies a range of bits of the analyzed halftrack. Each bit is
+     * represented by a single byte in the destination buffer which holds a
+     * GcrMark value.
+     */
+    void annotateTrack(u8 *dest, usize offset, usize count) const;
+    
+    /* Decodes the header block (10 bytes) or the data block (256 bytes) of a
+     * sector. The function returns the number of bytes written (0 if the
+     * block is missing).
+     */
+    usize sectorHeaderBytes(Sector nr, u8 *dest) const;
+    usize sectorDataBytes(Sector nr, u8 *dest) const;
+    
     // Returns a textual representation of the disk name
     const char *diskNameAsString();
     
@@ -430,12 +566,24 @@ public:
      * determine how many bytes will be written.
      */
     usize decodeDisk(u8 *dest);
+    
+    /* Parallel variant of decodeDisk(). The tracks are analyzed and decoded
+     * on the specified number of worker threads. The result, the analysis
+     * cache, and the error log are identical to the sequential version.
+     */
+    usize decodeDiskParallel(u8 *dest, isize numThreads);
+    
+    /* Decodes a single sector into a 256 byte buffer. The function returns
+     * false if the sector has no data block.
+     */
+    bool decodeSector(Track t, Sector s, u8 *dest);
  
 private:
     
     usize decodeDisk(u8 *dest, unsigned numTracks);
     usize decodeTrack(Track t, u8 *dest);
-    usize decodeSector(usize offset, u8 *dest);
+    usize decodeTrack(const TrackInfo &info, Track t, u8 *dest) const;
+    static usize decodeSector(const TrackInfo &info, usize offset, u8 *dest);
 
 
     //
@@ -453,23 +601,35 @@ public:
      */
     void encode(FSDevice &fs, bool alignTracks = false);
     
+    /* Encodes a D64 file. The sectors are taken straight from the file
+     * without creating a file system first.
+     */
+    void encode(D64File &d64, bool alignTracks = false);
+    
 private:
     
+    /* Encodes a sector image. The image contains all sectors in the order of
+     * a D64 file. 'errors' contains the D64 error code of each sector.
+     */
+    void encode(const u8 *image, const u8 *errors, Track numTracks, bool alignTracks);
+    
     /* Encode a single track. This function translates the logical byte
      * sequence of a single track into the native VC1541 byte representation.
      * The native representation includes sync marks, GCR data etc.
-     * 'tailGapEven' specifies the number of tail bytes follwowing sectors with
-     * even sector numbers. 'tailGapOdd' specifies the number of tail bytes
-     * follwowing sectors with odd sector numbers. The number of written bits
-     * is returned.
+     * 'sectors' and 'errors' point to the first sector of the track and its
+     * error code. 'diskId' points to the two disk ID bytes stored in the BAM.
+     * 'tailGap' specifies the number of tail bytes following each sector.
+     * The number of written bits is returned.
      */
-    usize encodeTrack(FSDevice &fs, Track t, u8 tailGap, HeadPos start);
+    usize encodeTrack(const u8 *sectors, const u8 *errors, const u8 *diskId,
+                      Track t, u8 tailGap, HeadPos start);
     
     /* Encode a single sector. This function translates the logical byte
      * sequence of a single sector into the native VC1541 byte representation.
      * The sector is closed by 'gap' tail gap bytes. The number of written bits
      * is returned.
      */
-    usize encodeSector(FSDevice &fs, Track t, Sector sector, HeadPos start, int gap);
+    usize encodeSector(const u8 *data, u8 errorCode, const u8 *diskId,
+                       Track t, Sector sector, HeadPos start, int gap);
 };
  
@@ -0,0 +1,76 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "DiskCache.h"
+
+std::mutex DiskCache::mutex;
+std::list<std::pair<u64, std::shared_ptr<const DiskCache::Entry>>> DiskCache::entries;
+usize DiskCache::capacity = 32;
+
+usize
+DiskCache::getCapacity()
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    return capacity;
+}
+
+void
+DiskCache::setCapacity(usize value)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    
+    capacity = value;
+    while (entries.size() > capacity) entries.pop_back();
+}
+
+std::shared_ptr<const DiskCache::Entry>
+DiskCache::lookup(u64 fnv)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    
+    for (auto it = entries.begin(); it != entries.end(); it++) {
+        
+        if (it->first != fnv) continue;
+        
+        // Move the entry to the front
+        entries.splice(entries.begin(), entries, it);
+        return entries.front().second;
+    }
+    return nullptr;
+}
+
+void
+DiskCache::insert(u64 fnv, const DiskData &data, const DiskLength &length)
+{
+    auto entry = std::make_shared<Entry>();
+    entry->data = data;
+    entry->length = length;
+    
+    std::lock_guard<std::mutex> guard(mutex);
+    
+    if (capacity == 0) return;
+    
+    entries.remove_if([fnv](auto &item) { return item.first == fnv; });
+    entries.emplace_front(fnv, std::move(entry));
+    while (entries.size() > capacity) entries.pop_back();
+}
+
+usize
+DiskCache::count()
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    return entries.size();
+}
+
+void
+DiskCache::clear()
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    entries.clear();
+}
@@ -0,0 +1,74 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include <list>
+#include <memory>
+#include <mutex>
+
+/* Process-wide cache of encoded disks. Each entry is keyed by the fingerprint
+ * (see AnyFile::fnv()) of the media file the disk has been created from.
+ * Mounting an image for the second time, in the same or in another emulator
+ * instance, skips the conversion into a file system and the GCR encoding.
+ *
+ * Entries are immutable. A disk created from an entry shares all halftracks
+ * with it, which are copied on the first write access (see DiskData). If the
+ * cache is full, the least recently used entry is dropped.
+ */
+class DiskCache {
+
+public:
+
+    struct Entry {
+
+        DiskData data;
+        DiskLength length;
+    };
+
+private:
+
+    static std::mutex mutex;
+
+    // All entries (most recently used first)
+    static std::list<std::pair<u64, std::shared_ptr<const Entry>>> entries;
+
+    // Maximum number of entries
+    static usize capacity;
+
+
+    //
+    // Configuring
+    //
+
+public:
+
+    static usize getCapacity();
+    static void setCapacity(usize value);
+
+
+    //
+    // Accessing
+    //
+
+public:
+
+    // Returns the entry for a fingerprint (or nullptr if there is none)
+    static std::shared_ptr<const Entry> lookup(u64 fnv);
+
+    // Adds an entry sharing the halftracks of the provided disk data
+    static void insert(u64 fnv, const DiskData &data, const DiskLength &length);
+
+    // Returns the number of entries
+    static usize count();
+
+    // Removes all entries
+    static void clear();
+};
@@ -119,6 +119,17 @@ enum_long(CBM_FILE_TYPE)
 };
 typedef CBM_FILE_TYPE CBMFileType;
 
+// Classification of the bits of an analyzed track (see Disk::annotateTrack())
+enum_long(GCR_MARK)
+{
+    GCR_MARK_GAP,      // Gap or SYNC mark
+    GCR_MARK_HEADER,   // Sector header block
+    GCR_MARK_DATA,     // Sector data block
+    GCR_MARK_ERROR,    // Erroneous bit sequence (see error log)
+    GCR_MARK_COUNT
+};
+typedef GCR_MARK GcrMark;
+
 
 //
 // Structures
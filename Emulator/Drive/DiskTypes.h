@@ -11,6 +11,11 @@
 
 #include "DiskPublicTypes.h"
 #include "Reflection.h"
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 //
 // Reflection APIs
@@ -58,36 +63,218 @@ struct CBMFileTypeEnum : Reflection<CBMFileTypeEnum, CBMFileType> {
     }
 };
 
+struct GcrMarkEnum : Reflection<GcrMarkEnum, GcrMark> {
+    
+    static bool isValid(long value)
+    {
+        return (unsigned long)value < GCR_MARK_COUNT;
+    }
+    
+    static const char *prefix() { return "GCR_MARK"; }
+    static const char *key(GcrMark value)
+    {
+        switch (value) {
+                
+            case GCR_MARK_GAP:     return "GAP";
+            case GCR_MARK_HEADER:  return "HEADER";
+            case GCR_MARK_DATA:    return "DATA";
+            case GCR_MARK_ERROR:   return "ERROR";
+            case GCR_MARK_COUNT:   return "???";
+        }
+        return "???";
+    }
+};
+
 //
 // Private types
 //
 
 /* Disk data
  *
- *    - The first valid track and halftrack number is 1
+ *    - The first valid halftrack number is 1
  *    - data.halftack[i] points to the first byte of halftrack i
- *    - data.track[i] points to the first byte of track i
+ *
+ * Storage is allocated when a halftrack is written to for the first time.
+ * Until then, the halftrack refers to a shared, read-only track filled with
+ * the bit pattern of an unformatted disk. Because standard disks only use the
+ * full tracks, most halftracks never get allocated. Only allocated halftracks
+ * are stored in snapshots.
+ *
+ * Each halftrack carries a modification stamp which changes whenever the
+ * halftrack is written to. It allows to cache data that is derived from the
+ * halftrack contents.
+ *
+ * Allocated halftracks can be shared among multiple disks by copying a
+ * DiskData object. Shared halftracks are copied on the first write access.
  */
-union DiskData
+class SerReader;
+
+struct DiskData
 {
-    struct
+    // Read-only view of all halftracks
+    const u8 *halftrack[85];
+    
+    // Storage of all allocated halftracks
+    std::shared_ptr<u8[]> storage[85];
+    
+    // Modification stamps
+    u64 stamp[85] = { };
+    u64 stampCounter = 0;
+    
+    // Returns the contents of an empty halftrack
+    static const u8 *emptyHalftrack()
     {
-        u8 _pad[maxBytesOnTrack];
-        u8 halftrack[85][maxBytesOnTrack];
-    };
+        static const std::unique_ptr<u8[]> empty = [] {
+            std::unique_ptr<u8[]> result(new u8[maxBytesOnTrack]);
+            memset(result.get(), 0x55, maxBytesOnTrack);
+            return result;
+        }();
+        return empty.get();
+    }
+    
+    DiskData() { for (isize ht = 0; ht < 85; ht++) halftrack[ht] = emptyHalftrack(); }
+    
+    // Checks if a halftrack has own storage
+    bool isAllocated(isize ht) const { return storage[ht] != nullptr; }
+    
+    // Returns a writable pointer to a halftrack (allocates storage if needed)
+    u8 *modify(isize ht)
+    {
+        stamp[ht] = ++stampCounter;
+        
+        if (!storage[ht] || storage[ht].use_count() > 1) {
+            
+            u8 *bytes = new u8[maxBytesOnTrack];
+            memcpy(bytes, halftrack[ht], maxBytesOnTrack);
+            storage[ht].reset(bytes);
+            halftrack[ht] = bytes;
+        }
+        return storage[ht].get();
+    }
+    
+    // Turns a halftrack into an empty halftrack
+    void clear(isize ht)
+    {
+        stamp[ht] = ++stampCounter;
+        storage[ht].reset();
+        halftrack[ht] = emptyHalftrack();
+    }
     
-    u8 track[43][2 * maxBytesOnTrack];
-
     template <class T>
     void applyToItems(T& worker)
     {
-        worker
+        for (isize ht = 1; ht < 85; ht++) {
+            
+            bool allocated = isAllocated(ht);
+            worker & allocated;
+            
+            if (allocated) {
+                
+                // Never load into a halftrack that is shared with other disks
+                bool shared = isAllocated(ht) && storage[ht].use_count() > 1;
+                bool loading = std::is_same<T, SerReader>::value;
+                
+                u8 *bytes =
+                isAllocated(ht) && !(shared && loading) ? storage[ht].get() : modify(ht);
+                worker & *(u8 (*)[maxBytesOnTrack])bytes;
+                
+            } else if (isAllocated(ht)) {
+                
+                clear(ht);
+            }
+        }
+    }
+};
+
+
+/* Reads the bits of a halftrack sequentially. The cursor keeps a window of up
+ * to 64 bits which is loaded from the track data in a single step. Bits are
+ * shifted out of the window one by one. The window never extends beyond the
+ * end of the halftrack. Hence, the head position only needs to be checked for
+ * a wrap-around when the window is reloaded.
+ */
+struct BitCursor
+{
+    const u8 *data;
+    HeadPos length;
+    
+    // Head position of the first bit in the window and the number of bits
+    HeadPos base = 0;
+    HeadPos loaded = 0;
+    
+    // Remaining bits (left aligned) and their number
+    u64 window = 0;
+    HeadPos avail = 0;
+    
+    BitCursor(const u8 *data, HeadPos length, HeadPos pos) : data(data), length(length)
+    {
+        load(pos);
+    }
+    
+    // Returns the head position of the next bit
+    HeadPos position() const
+    {
+        HeadPos pos = base + loaded - avail;
+        return pos < length ? pos : 0;
+    }
+    
+    // Fills the window with the bits starting at the specified position
+    void load(HeadPos pos)
+    {
+        assert(pos >= 0 && pos < length);
         
-        & track;
+        HeadPos byte = pos / 8;
+        
+        window = 0;
+        if (byte + 8 <= (HeadPos)maxBytesOnTrack) {
+            for (isize i = 0; i < 8; i++) window = window << 8 | data[byte + i];
+        } else {
+            for (isize i = 0; i < 8; i++) {
+                window = window << 8 | (byte + i < (HeadPos)maxBytesOnTrack ? data[byte + i] : 0);
+            }
+        }
+        window <<= pos % 8;
+        
+        base = pos;
+        loaded = avail = std::min(64 - pos % 8, length - pos);
+    }
+    
+    // Returns the next bit and advances the head position
+    u8 next()
+    {
+        if (avail == 0) load(position());
+        
+        u8 bit = (u8)(window >> 63);
+        window <<= 1;
+        avail--;
+        return bit;
     }
 };
 
 
+/* Result of analyzing a single halftrack. Analysis results are cached per
+ * halftrack and reused as long as the modification stamp of the halftrack
+ * stays the same.
+ */
+struct TrackAnalysis
+{
+    // Indicates if this entry holds an analysis result
+    bool valid = false;
+    
+    // Modification stamp and length of the analyzed halftrack
+    u64 stamp = 0;
+    usize length = 0;
+    
+    // Sector layout
+    SectorInfo sectorInfo[22];
+    
+    // Error log
+    std::vector<std::string> errorLog;
+    std::vector<usize> errorStartIndex;
+    std::vector<usize> errorEndIndex;
+};
+
+
 /* Length of each halftrack in bits
  *
  *     - length.halftack[i] is the length of halftrack i
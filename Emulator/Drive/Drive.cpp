@@ -11,7 +11,7 @@
 
 Drive::Drive(DriveID id, C64 &ref) : C64Component(ref), deviceNr(id)
 {
-    assert(deviceNr == DRIVE8 || deviceNr == DRIVE9);
+    assert(isDriveID(deviceNr));
 	
     subComponents = vector <HardwareComponent *> {
         
@@ -24,6 +24,8 @@ Drive::Drive(DriveID id, C64 &ref) : C64Component(ref), deviceNr(id)
     
     config.connected = false;
     config.switchedOn = true;
+    config.idleSleep = false;
+    config.fastLoad = false;
     config.type = DRIVE_MODEL_VC1541II;
     
     insertionStatus = DISK_FULLY_EJECTED;
@@ -33,8 +35,10 @@ Drive::Drive(DriveID id, C64 &ref) : C64Component(ref), deviceNr(id)
 const char *
 Drive::getDescription() const
 {
-    assert(deviceNr == DRIVE8 || deviceNr == DRIVE9);
-    return deviceNr == DRIVE8 ? "Drive8" : "Drive9";
+    assert(isDriveID(deviceNr));
+    
+    static const char *names[] = { "Drive8", "Drive9", "Drive10", "Drive11" };
+    return names[deviceNr - DRIVE8];
 }
 
 void
@@ -54,6 +58,8 @@ Drive::getConfigItem(Option option) const
         case OPT_DRIVE_TYPE:          return config.type;
         case OPT_DRIVE_CONNECT:       return config.connected;
         case OPT_DRIVE_POWER_SWITCH:  return config.switchedOn;
+        case OPT_DRIVE_IDLE_SLEEP:    return config.idleSleep;
+        case OPT_DRIVE_FAST_LOAD:     return config.fastLoad;
             
         default:
             assert(false);
@@ -111,7 +117,10 @@ Drive::setConfigItem(Option option, long id, long value)
             config.connected = value;
             bool wasActive = active;
             active = config.connected && config.switchedOn;
+            c64.updateActiveDrives();
+            c64.rescheduleEvents();
             reset();
+            iec.updateIecLinesDriveSide(); // Active state affects the bus
             resume();
             messageQueue.put(value ? MSG_DRIVE_CONNECT : MSG_DRIVE_DISCONNECT, deviceNr);
             if (wasActive != active)
@@ -128,13 +137,37 @@ Drive::setConfigItem(Option option, long id, long value)
             config.switchedOn = value;
             bool wasActive = active;
             active = config.connected && config.switchedOn;
+            c64.updateActiveDrives();
+            c64.rescheduleEvents();
             reset();
+            iec.updateIecLinesDriveSide(); // Active state affects the bus
             resume();
             messageQueue.put(value ? MSG_DRIVE_POWER_ON : MSG_DRIVE_POWER_OFF, deviceNr);
             if (wasActive != active)
                 messageQueue.put(active ? MSG_DRIVE_ACTIVE : MSG_DRIVE_INACTIVE, deviceNr);
             return true;
         }
+        case OPT_DRIVE_IDLE_SLEEP:
+        {
+            if (config.idleSleep == value) {
+                return false;
+            }
+            
+            suspend();
+            config.idleSleep = value;
+            wakeUp();
+            resume();
+            return true;
+        }
+        case OPT_DRIVE_FAST_LOAD:
+        {
+            if (config.fastLoad == value) {
+                return false;
+            }
+            
+            config.fastLoad = value;
+            return true;
+        }
         default:
             return false;
     }
@@ -149,6 +182,7 @@ Drive::_dump() const
 	msg("   Head position : Track %d, Bit offset %d\n", halftrack, offset);
 	msg("            SYNC : %d\n", sync);
     msg("       Read mode : %s\n", readMode() ? "YES" : "NO");
+    msg("        Sleeping : %s\n", sleeping ? "YES" : "NO");
 	msg("\n");
 }
 
@@ -163,28 +197,213 @@ void
 Drive::execute(u64 duration)
 {
     elapsedTime += duration;
-    while (nextClock < (i64)elapsedTime || nextCarry < (i64)elapsedTime) {
+    
+    // Let the drive CPU sleep if the drive is idle
+    if (config.idleSleep) {
+        
+        if (!sleeping && isIdle()) {
+            
+            trace(DRV_DEBUG, "Putting the drive CPU to sleep\n");
+            sleeping = true;
+        }
+        if (sleeping) {
+            
+            executeAsleep();
+            if (sleeping) return;
+        }
+    }
+    
+    // Recompute the horizon of the read/write logic in the first cycle
+    uf4Horizon = 0;
+    
+    while (nextClock < (i64)elapsedTime) {
 
-        if (nextClock <= nextCarry) {
+        // A speculating drive stops before it affects the bus or the disk
+        if (unlikely(speculative) && (halted || writeMode())) break;
+        
+        // Execute all carry pulses that might be observed in this cycle
+        if (uf4Horizon < nextClock) executeUF4Until(nextClock);
+        
+#ifdef DRIVE_FAST_PATH
+        // Execute a whole instruction if no other component is involved
+        if (isQuiet()) {
             
-            // Execute CPU and VIAs
-            u64 cycle = ++cpu.cycle;
-            cpu.executeOneCycle();
-            if (cycle >= via1.wakeUpCycle) via1.execute(); else via1.idleCounter++;
-            if (cycle >= via2.wakeUpCycle) via2.execute(); else via2.idleCounter++;
-            updateByteReady();
-            if (iec.isDirtyDriveSide) iec.updateIecLinesDriveSide();
+            if (DRV_LOCKSTEP) {
+                executeLockstep();
+            } else {
+                executeInstruction();
+            }
+            continue;
+        }
+#endif
+        executeCycle();
+    }
+    
+    if (unlikely(speculative) && (halted || writeMode())) {
+        
+        // Stop in the current cycle and leave the carry pulses pending
+        halted = true;
+        elapsedTime = MIN(elapsedTime, (u64)nextClock);
+        return;
+    }
+    
+    // Execute the remaining carry pulses
+    executeUF4Until((i64)elapsedTime);
+    
+    assert(nextClock >= (i64)elapsedTime && nextCarry >= (i64)elapsedTime);
+}
+
+void
+Drive::executeCycle()
+{
+    // Execute CPU and VIAs
+    u64 cycle = ++cpu.cycle;
+    cpu.executeOneCycle();
+    if (cycle >= via1.wakeUpCycle) via1.execute(); else via1.idleCounter++;
+    if (cycle >= via2.wakeUpCycle) via2.execute(); else via2.idleCounter++;
+    updateByteReady();
+    if (iec.isDirtyDriveSide) {
+        if (unlikely(speculative)) halted = true; else iec.updateIecLinesDriveSide();
+    }
+    
+    nextClock += 10000;
+}
+
+#ifdef DRIVE_FAST_PATH
+void
+Drive::executeInstruction()
+{
+    isize cycles = cpu.executeInstruction();
+    via1.idleCounter += cycles;
+    via2.idleCounter += cycles;
+    nextClock += 10000 * cycles;
+}
 
-            nextClock += 10000;
+void
+Drive::executeLockstep()
+{
+    HardwareComponent *items[] = { &cpu, &via1, &via2 };
+    
+    // The state consists of RAM and the snapshot data of the CPU and the VIAs
+    usize size = sizeof(mem.ram);
+    for (auto &item : items) size += item->size();
+    std::vector<u8> initial(size), fast(size), exact(size);
+    
+    auto save = [&](std::vector<u8> &buffer) {
+        u8 *ptr = buffer.data();
+        memcpy(ptr, mem.ram, sizeof(mem.ram)); ptr += sizeof(mem.ram);
+        for (auto &item : items) ptr += item->save(ptr);
+    };
+    auto load = [&](std::vector<u8> &buffer) {
+        u8 *ptr = buffer.data();
+        memcpy(mem.ram, ptr, sizeof(mem.ram)); ptr += sizeof(mem.ram);
+        mem.markDirty();
+        for (auto &item : items) ptr += item->load(ptr);
+    };
+
+    u16 pc = cpu.getPC0();
+    i64 clock = nextClock;
+    save(initial);
+    
+    // Run the instruction in one step
+    executeInstruction();
+    save(fast);
+    
+    // Run the same instruction cycle by cycle
+    load(initial);
+    nextClock = clock;
+    do { executeCycle(); } while (!cpu.inFetchPhase());
+    save(exact);
+    
+    if (fast != exact) {
+        warn("Lockstep mismatch in instruction at %04X\n", pc);
+        assert(false);
+    }
+}
+
+bool
+Drive::isQuiet() const
+{
+    // An instruction takes up to 8 cycles which must fit into the time slice
+    if (nextClock + 7 * 10000 >= (i64)elapsedTime) return false;
+
+    return
+    !spinning &&
+    !iec.isDirtyDriveSide &&
+    via1.wakeUpCycle > cpu.cycle + 8 &&
+    via2.wakeUpCycle > cpu.cycle + 8 &&
+    cpu.nextInstructionIsIsolated();
+}
+#endif
 
-        } else {
+bool
+Drive::isIdle() const
+{
+    return
+    !spinning &&
+    !redLED &&
+    !iec.isDirtyDriveSide &&
+    !cpu.irqLine &&
+    !cpu.getI() &&
+    cpu.inFetchPhase() &&
+    cpu.cycle - lastActivity > idleThreshold;
+}
+
+void
+Drive::executeAsleep()
+{
+    // Carry pulses have no effect while the disk isn't spinning
+    if (nextCarry < (i64)elapsedTime) {
+        
+        i64 delay = delayBetweenTwoCarryPulses[zone];
+        nextCarry += (((i64)elapsedTime - nextCarry + delay - 1) / delay) * delay;
+    }
+    
+    // Run the VIAs
+    u64 start = cpu.cycle;
+    while (nextClock < (i64)elapsedTime) {
+        
+        u64 cycle = cpu.cycle + 1;
+        u64 wakeUpCycle = MIN(via1.wakeUpCycle, via2.wakeUpCycle);
+        
+        // Skip all cycles in which both VIAs are asleep
+        if (cycle < wakeUpCycle) {
+            
+            u64 pending = ((i64)elapsedTime - nextClock + 9999) / 10000;
+            u64 skip = MIN(pending, wakeUpCycle - cycle);
+            cpu.cycle += skip;
+            via1.idleCounter += skip;
+            via2.idleCounter += skip;
+            nextClock += 10000 * skip;
+            continue;
+        }
+        
+        cpu.cycle = cycle;
+        if (cycle >= via1.wakeUpCycle) via1.execute(); else via1.idleCounter++;
+        if (cycle >= via2.wakeUpCycle) via2.execute(); else via2.idleCounter++;
+        updateByteReady();
+        nextClock += 10000;
+        
+        // Let the CPU run the interrupt handler in time
+        if (cpu.irqLine) {
             
-            // Execute read/write logic
-            if (spinning) executeUF4();
-            nextCarry += delayBetweenTwoCarryPulses[zone];
+            trace(DRV_DEBUG, "Waking up the drive CPU to serve an interrupt\n");
+            sleeping = false;
+            break;
         }
     }
-    assert(nextClock >= (i64)elapsedTime && nextCarry >= (i64)elapsedTime);
+    assert(!sleeping || nextClock >= (i64)elapsedTime);
+    assert(nextCarry >= (i64)elapsedTime);
+    asleepCycles += cpu.cycle - start;
+}
+
+void
+Drive::wakeUp()
+{
+    if (sleeping) trace(DRV_DEBUG, "Waking up the drive CPU\n");
+    
+    sleeping = false;
+    lastActivity = cpu.cycle;
 }
 
 void
@@ -281,6 +500,103 @@ Drive::executeUF4()
     }
 }
 
+void
+Drive::executeUF4Read(isize count)
+{
+    assert(readMode() && byteReady);
+    
+    // Shift the bits out of a prefetched window of track data
+    BitCursor head(disk.data.halftrack[halftrack], disk.lengthOfHalftrack(halftrack), offset);
+    
+    // Work on local copies of the read/write logic
+    u8 uf4 = counterUF4;
+    i64 carry = carryCounter;
+    u16 rsr = readShiftreg;
+    u8 wsr = writeShiftreg;
+    u8 brc = byteReadyCounter;
+    bool syn = sync;
+    
+    for (isize i = 0; i < count; i++) {
+        
+        uf4++;
+        
+        // A new bit comes in every fourth pulse. A 1 resets counter UF4
+        if (++carry % 4 == 0) {
+            
+            if (head.next()) uf4 = 0;
+        }
+        
+        syn = (rsr & 0x3FF) != 0x3FF;
+        if (!syn) brc = 0;
+        
+        switch (uf4 & 0x03) {
+                
+            case 0x02:
+                
+                brc = syn ? (brc + 1) % 8 : 0;
+                wsr <<= 1;
+                rsr = (u16)(rsr << 1 | ((uf4 & 0x0C) == 0));
+                break;
+                
+            case 0x03:
+                
+                if (brc == 7) wsr = via2.getPA();
+                break;
+        }
+    }
+    
+    counterUF4 = uf4;
+    carryCounter = carry;
+    offset = head.position();
+    readShiftreg = rsr;
+    writeShiftreg = wsr;
+    byteReadyCounter = brc;
+    sync = syn;
+}
+
+void
+Drive::executeUF4Until(i64 time)
+{
+    i64 delay = delayBetweenTwoCarryPulses[zone];
+    
+    // Carry pulses have no effect while the disk isn't spinning
+    if (!spinning) {
+        
+        if (nextCarry < time) nextCarry += ((time - nextCarry + delay - 1) / delay) * delay;
+        uf4Horizon = INT64_MAX;
+        return;
+    }
+    
+    if (nextCarry < time) {
+        
+        // Execute all pulses that don't affect the Byte Ready line in a row
+        isize pending = (isize)((time - nextCarry + delay - 1) / delay);
+        isize deferrable = MIN(pending, deferrablePulses());
+        
+        if (deferrable) {
+            
+            executeUF4Read(deferrable);
+            nextCarry += deferrable * delay;
+        }
+        
+        // Execute the remaining pulses one by one
+        for (; nextCarry < time; nextCarry += delay) executeUF4();
+    }
+    
+    uf4Horizon = nextCarry + deferrablePulses() * delay;
+}
+
+isize
+Drive::deferrablePulses() const
+{
+    // The fast path is restricted to read mode with manually controlled lines
+    if (!readMode() || !byteReady || byteReadyCounter == 7) return 0;
+    if ((via2.ca2Control() & 0x06) != 0x06) return 0;
+    if ((via2.cb2Control() & 0x06) != 0x06) return 0;
+    
+    return 3 * (7 - byteReadyCounter) - 2;
+}
+
 void
 Drive::updateByteReady()
 {
@@ -330,6 +646,8 @@ Drive::setZone(u8 value)
 void
 Drive::setRedLED(bool b)
 {
+    if (redLED != b) wakeUp();
+    
     if (!redLED && b) {
         redLED = true;
         c64.putMessage(MSG_DRIVE_LED_ON, deviceNr);
@@ -345,6 +663,7 @@ Drive::setRotating(bool b)
     if (spinning == b) return;
     
     spinning = b;
+    wakeUp();
     c64.putMessage(b ? MSG_DRIVE_MOTOR_ON : MSG_DRIVE_MOTOR_OFF, deviceNr);
     iec.updateTransferStatus();
 }
@@ -405,6 +724,11 @@ Drive::insertDisk(Disk *otherDisk)
         // Initiate the disk change procedure
         diskToInsert = otherDisk;
         diskChangeCounter = 1;
+        
+    } else {
+        
+        // Another disk change is in progress
+        delete otherDisk;
     }
     
     resume();
@@ -467,6 +791,12 @@ Drive::vsyncHandler()
     // Only proceed if a disk change state transition is to be performed
     if (--diskChangeCounter) return;
     
+    // Let DOS notice the change of the light barrier
+    wakeUp();
+    
+    // Host changes are recorded as sync points in an input log
+    if (c64.inputLog.isRecording()) c64.inputLog.requestSync();
+    
     switch (insertionStatus) {
             
         case DISK_FULLY_INSERTED:
@@ -518,12 +848,9 @@ Drive::vsyncHandler()
             // Fully insert the disk (unblocks the light barrier)
             insertionStatus = DISK_FULLY_INSERTED;
 
-            // Copy the disk contents
-            usize size = diskToInsert->size();
-            u8 *buffer = new u8[size];
-            diskToInsert->save(buffer);
-            disk.load(buffer);
-            delete[] buffer;
+            // Take over the disk contents
+            disk.share(*diskToInsert);
+            delete diskToInsert;
             diskToInsert = nullptr;
 
             // Inform listeners
@@ -22,6 +22,8 @@
 
 class Drive : public C64Component {
     
+    friend class DriveSpeculator;
+    
     //
     // Constants
     //
@@ -85,6 +87,28 @@ private:
     // Indicates whether the disk is rotating
     bool spinning = false;
     
+    /* Indicates whether the drive CPU is asleep. If OPT_DRIVE_IDLE_SLEEP is
+     * set, the CPU is put to sleep when the drive has been idle for a while,
+     * i.e., when the motor and the LED are off and the IEC bus hasn't changed.
+     * The CPU only falls asleep at an instruction boundary outside of an
+     * interrupt handler with no interrupt pending. While the CPU is asleep,
+     * only the VIAs are emulated which keeps their timers exact. As soon as a
+     * VIA raises an interrupt, the CPU is resumed to run the handler in the
+     * same cycle it would have run in otherwise. It falls asleep again after
+     * the handler has returned. Any IEC line change, motor, LED, or disk
+     * change wakes up the CPU for good and restarts the idle detection.
+     */
+    bool sleeping = false;
+    
+    // Drive cycle of the most recent bus, motor, or LED activity
+    u64 lastActivity = 0;
+    
+    // Number of drive cycles that passed with the CPU asleep
+    u64 asleepCycles = 0;
+    
+    // Number of idle cycles before the CPU is put to sleep (about a second)
+    static constexpr u64 idleThreshold = 1000000;
+    
     // Indicates whether the red LED is on
     bool redLED = false;
     
@@ -99,8 +123,8 @@ private:
     // Elapsed time since power up in 1/10 nano seconds
     u64 elapsedTime = 0;
     
-    // Duration of a single CPU clock cycle in 1/10 nano seconds
-    u64 durationOfOneCpuCycle = 0;
+    // Duration of a single CPU clock cycle in 1/10 nano seconds (PAL default)
+    u64 durationOfOneCpuCycle = 10000000000 / PAL_CLOCK_FREQUENCY;
     
     /* Indicates when the next drive clock cycle occurs. The VC1541 drive is
      * clocked by 16 MHz. The clock signal is fed into a counter which serves
@@ -119,6 +143,19 @@ private:
      */
     i64 nextCarry = 0;
     
+    /* Carry pulses are executed lazily. Each pulse before this point in time
+     * can't be observed by the drive CPU unless it accesses VIA2 which brings
+     * the read/write logic up to date first.
+     */
+    i64 uf4Horizon = 0;
+    
+    /* Indicates if the drive is executed ahead of time (see DriveSpeculator).
+     * A speculating drive must neither drive the IEC bus nor write to disk.
+     * It halts right before and waits until the C64 has caught up.
+     */
+    bool speculative = false;
+    bool halted = false;
+    
 public:
     
     /* Counts the number of carry pulses from UE7. In a perfect setting, a new
@@ -242,6 +279,8 @@ private:
         & durationOfOneCpuCycle
         & config.type
         & config.connected
+        & config.idleSleep
+        & config.fastLoad
         & insertionStatus;
     }
     
@@ -251,6 +290,8 @@ private:
         worker
         
         & spinning
+        & sleeping
+        & lastActivity
         & redLED
         & elapsedTime
         & nextClock
@@ -269,8 +310,10 @@ private:
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
     
 private:
     
@@ -301,6 +344,15 @@ public:
     // Turns the drive engine on or off
     void setRotating(bool b);
     
+    // Checks whether the drive CPU is asleep
+    bool isSleeping() const { return sleeping; }
+    
+    // Returns the number of drive cycles that passed with the CPU asleep
+    u64 getAsleepCycles() const { return asleepCycles; }
+    
+    // Wakes up the drive CPU and restarts the idle detection
+    void wakeUp();
+    
     
     //
     // Handling disks
@@ -339,6 +391,7 @@ public:
      * one after another with a proper time delay. The sequence includes pulling
      * the currently inserted disk halfway out before it is removed completely,
      * and pushing the new disk halfway in before it is inserted completely.
+     * The drive takes over the ownership of the provided disk.
      */
     void insertDisk(Disk *otherDisk);
     void insertNewDisk(DOSType fstype);
@@ -365,7 +418,51 @@ private:
     // Emulates a trigger event on the carry output pin of UE7.
     void executeUF4();
     
+    /* Emulates a certain number of carry pulses in read mode. This is a fast
+     * path for executeUF4() which reads the disk data byte-wise. It requires
+     * the Byte Ready line to stay high while the pulses are emulated.
+     */
+    void executeUF4Read(isize count);
+    
+    // Executes all carry pulses that occur before a certain point in time
+    void executeUF4Until(i64 time);
+    
+    /* Returns the number of upcoming carry pulses that can't change the Byte
+     * Ready line. Pulsing UE3 seven times takes at least 3 * 7 - 2 pulses.
+     */
+    isize deferrablePulses() const;
+
+    // Executes a single cycle or the next instruction in a single step
+    void executeCycle();
+#ifdef DRIVE_FAST_PATH
+    void executeInstruction();
+    
+    /* Executes the next instruction in a single step and cycle by cycle and
+     * compares the results. This is a debug feature for verifying the fast
+     * path (see DRV_LOCKSTEP).
+     */
+    void executeLockstep();
+#endif
+    
+    // Checks if the drive CPU can be put to sleep
+    bool isIdle() const;
+    
+    // Executes all pending cycles with the drive CPU asleep
+    void executeAsleep();
+    
+#ifdef DRIVE_FAST_PATH
+    /* Checks if the next CPU instruction can be executed in a single step.
+     * This is possible if the drive is quiet, i.e., if the disk is not
+     * spinning, both VIAs are asleep, the IEC bus is stable, and the
+     * instruction does not access any I/O register.
+     */
+    bool isQuiet() const;
+#endif
+    
 public:
+    
+    // Executes all carry pulses that occur before the current drive cycle
+    void syncDiskLogic() { if (nextCarry < nextClock) executeUF4Until(nextClock); }
 
     // Returns the current access mode of this drive (read or write)
     bool readMode() const { return via2.getCB2(); }
@@ -16,13 +16,18 @@
 enum_long(DRIVE_ID)
 {
     DRIVE8 = 8,
-    DRIVE9 = 9
+    DRIVE9 = 9,
+    DRIVE10 = 10,
+    DRIVE11 = 11
 };
 typedef DRIVE_ID DriveID;
 
+// Number of drives that can be connected to the IEC bus
+#define DRIVE_COUNT 4
+
 inline bool isDriveID(long value)
 {
-    return (unsigned long)value <= DRIVE9;
+    return value >= DRIVE8 && value <= DRIVE11;
 }
 
 enum_long(DRIVE_MODEL)
@@ -51,5 +56,13 @@ typedef struct
     DriveModel type;
     bool connected;
     bool switchedOn;
+    bool idleSleep;
+    bool fastLoad;
 }
 DriveConfig;
+
+typedef struct
+{
+    bool turbo;
+}
+IECConfig;
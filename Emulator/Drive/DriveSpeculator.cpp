@@ -0,0 +1,208 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+#include <sched.h>
+#include <unistd.h>
+
+DriveSpeculator::~DriveSpeculator()
+{
+    assert(!isSpeculating());
+    stop();
+}
+
+void
+DriveSpeculator::configure(bool enable)
+{
+    assert(!isSpeculating());
+
+    enabled = enable;
+    penalty = 0;
+    holdoff = 1;
+    if (!enabled) stop();
+}
+
+void
+DriveSpeculator::speculate(C64 &c64, u64 duration)
+{
+    assert(!isSpeculating());
+
+    if (!enabled || c64.drivesLag || c64.inDebugMode()) return;
+
+    // Skip some lines if the most recent predictions have failed
+    if (penalty) { penalty--; return; }
+
+    // Only a single drive in read mode can be executed ahead of time
+    u8 active = c64.activeDrives;
+    if (active == 0 || (active & (active - 1))) return;
+    Drive &d = *c64.drives[__builtin_ctz(active)];
+    if (d.writeMode() || c64.iec.isDirtyDriveSide) return;
+
+    if (!launched) {
+
+        limit.store(0);
+        helper.run([this]() { execute(); });
+        launched = true;
+    }
+
+    drive = &d;
+    drive->speculative = true;
+    origin = drive->elapsedTime;
+    stalled.store(false, std::memory_order_relaxed);
+    reached.store(origin, std::memory_order_relaxed);
+    limit.store(origin + duration);
+    lines++;
+}
+
+bool
+DriveSpeculator::observe(u64 lag)
+{
+    assert(isSpeculating());
+
+    u64 time = origin + lag;
+
+    // Wait until the helper thread has reached the current point in time
+    while (reached.load(std::memory_order_acquire) < time) {
+
+        if (stalled.load(std::memory_order_acquire)) return false;
+        sched_yield();
+    }
+
+    // The bus is up to date unless the drive has halted in the meantime
+    return !stalled.load(std::memory_order_acquire);
+}
+
+void
+DriveSpeculator::settle(u64 lag)
+{
+    assert(isSpeculating());
+
+    u64 time = origin + lag;
+
+    // Let the helper thread run up to the current point in time
+    limit.store(time);
+    while (reached.load(std::memory_order_acquire) < time) {
+
+        if (stalled.load(std::memory_order_acquire)) break;
+        sched_yield();
+    }
+    pause();
+
+    if (drive->elapsedTime > time) {
+
+        // The drive has run too far. Roll it back
+        restore();
+        rollbacks++;
+        penalty = holdoff;
+        holdoff = MIN(2 * holdoff, maxHoldoff);
+
+    } else {
+
+        // Apply the bus update the drive has halted on
+        if (drive->halted && drive->iec.isDirtyDriveSide) {
+            drive->iec.updateIecLinesDriveSide();
+        }
+        holdoff = MAX(holdoff / 2, 1);
+    }
+
+    // Catch up serially
+    drive->halted = false;
+    drive->speculative = false;
+    if (drive->elapsedTime < time) drive->execute(time - drive->elapsedTime);
+    drive = nullptr;
+}
+
+void
+DriveSpeculator::stop()
+{
+    assert(!isSpeculating());
+
+    if (!launched) return;
+
+    limit.store(quit);
+    helper.join();
+    launched = false;
+}
+
+void
+DriveSpeculator::pause()
+{
+    /* Other than the emulator thread, the helper thread checks the limit
+     * after announcing that it is busy. Hence, once both threads have
+     * passed this point, at least one of them sees the other one's store.
+     */
+    limit.store(0);
+    while (busy.load()) sched_yield();
+}
+
+void
+DriveSpeculator::save()
+{
+    HardwareComponent *items[] = { &drive->cpu, &drive->via1, &drive->via2 };
+
+    usize size = sizeof(drive->mem.ram) + drive->_size();
+    for (auto &item : items) size += item->size();
+    state.resize(size);
+
+    u8 *ptr = state.data();
+    memcpy(ptr, drive->mem.ram, sizeof(drive->mem.ram));
+    ptr += sizeof(drive->mem.ram);
+    for (auto &item : items) ptr += item->save(ptr);
+    ptr += drive->saveOwnState(ptr);
+}
+
+void
+DriveSpeculator::restore()
+{
+    HardwareComponent *items[] = { &drive->cpu, &drive->via1, &drive->via2 };
+
+    u8 *ptr = state.data();
+    memcpy(drive->mem.ram, ptr, sizeof(drive->mem.ram));
+    drive->mem.markDirty();
+    ptr += sizeof(drive->mem.ram);
+    for (auto &item : items) ptr += item->load(ptr);
+    ptr += drive->loadOwnState(ptr);
+
+    // The drive has been saved with the bus in sync
+    drive->iec.isDirtyDriveSide = false;
+}
+
+void
+DriveSpeculator::execute()
+{
+    isize idle = 0;
+    bool saved = false;
+
+    while (true) {
+
+        busy.store(true);
+        u64 target = limit.load();
+        if (target == quit) break;
+
+        u64 time = reached.load(std::memory_order_relaxed);
+        if (time >= target || stalled.load(std::memory_order_relaxed)) {
+
+            // Take a new snapshot once the emulator thread hands out more time
+            saved = false;
+            busy.store(false);
+            if (++idle < 4096) sched_yield(); else usleep(100);
+            continue;
+        }
+        idle = 0;
+
+        if (!saved) { save(); saved = true; }
+
+        drive->execute(MIN(target - time, slice));
+        if (drive->halted) stalled.store(true, std::memory_order_release);
+        reached.store(drive->elapsedTime, std::memory_order_release);
+        busy.store(false);
+    }
+
+    busy.store(false);
+}
@@ -0,0 +1,165 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include "Concurrency.h"
+#include <atomic>
+#include <vector>
+
+/* Executes a single active drive ahead of time on a helper thread. The drive
+ * interacts with the C64 over the IEC bus only. At the beginning of each
+ * rasterline, the drive is handed over to the helper thread which executes
+ * it up to the end of the line while the emulator thread executes the C64.
+ * Whenever the C64 needs to see the drive in sync, the emulator thread waits
+ * for the helper thread to reach the current point in time:
+ *
+ *   - If the drive has run past this point in time and the C64 changes the
+ *     bus, the prediction has failed. The drive is rolled back to the state
+ *     it had at the beginning of the line and caught up serially.
+ *   - Reading the bus does not require a rollback as long as the drive has
+ *     left the bus lines untouched up to this point in time.
+ *
+ * A speculating drive halts right before it changes the bus or writes to
+ * disk (see Drive::speculative). The emulator thread takes over in this
+ * case and applies the pending change when the C64 has caught up. The rest
+ * of the line is executed serially.
+ *
+ * Rolling back is cheap, because the drive state consists of 2 KB of RAM,
+ * the CPU, the two VIAs, and a couple of drive variables only. The inserted
+ * disk is left untouched, because a speculating drive doesn't write. Frequent
+ * rollbacks let the speculator pause for an increasing number of lines.
+ * Messages posted by the drive (LED, motor, head steps) may show up twice if
+ * the drive has been rolled back.
+ */
+class DriveSpeculator {
+
+    // Upper bound of a time slice executed on the helper thread
+    static constexpr u64 slice = 16 * 10000;
+
+    // Limit signaling the helper thread to terminate
+    static constexpr u64 quit = UINT64_MAX;
+
+    // Maximum number of lines to skip after a rollback
+    static constexpr isize maxHoldoff = 256;
+
+    // Indicates if speculative execution is enabled
+    bool enabled = false;
+
+    // The helper thread
+    WorkerThread helper;
+    bool launched = false;
+
+    // The speculating drive (nullptr if the drive is executed serially)
+    class Drive *drive = nullptr;
+
+    // Drive time the helper thread executes up to
+    std::atomic<u64> limit { 0 };
+
+    // Drive time the helper thread has reached
+    std::atomic<u64> reached { 0 };
+
+    // Indicates if the helper thread is executing a time slice
+    std::atomic<bool> busy { false };
+
+    // Indicates if the drive has halted (see Drive::halted)
+    std::atomic<bool> stalled { false };
+
+    // Drive time matching the beginning of the speculation
+    u64 origin = 0;
+
+    // Drive state at the beginning of the speculation
+    std::vector<u8> state;
+
+    // Number of lines to skip before speculating again
+    isize penalty = 0;
+    isize holdoff = 1;
+
+    // Statistics
+    u64 lines = 0;
+    u64 rollbacks = 0;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    ~DriveSpeculator();
+
+
+    //
+    // Configuring
+    //
+
+public:
+
+    void configure(bool enable);
+    bool isEnabled() const { return enabled; }
+
+    // Changes the scheduling parameters of the helper thread
+    void setThreadPolicy(const ThreadPolicy &policy) { helper.setPolicy(policy); }
+
+
+    //
+    // Querying
+    //
+
+public:
+
+    // Indicates if a drive is currently executed ahead of time
+    bool isSpeculating() const { return drive != nullptr; }
+
+    // Returns the number of speculated rasterlines and failed predictions
+    u64 getLines() const { return lines; }
+    u64 getRollbacks() const { return rollbacks; }
+
+
+    //
+    // Speculating (emulator thread)
+    //
+
+public:
+
+    /* Hands the active drive over to the helper thread which executes it for
+     * the specified amount of time. The drive stays with the emulator thread
+     * if two drives are active, if the drive is in write mode, if a bus
+     * update is pending, or if the emulator runs in debug mode.
+     */
+    void speculate(class C64 &c64, u64 duration);
+
+    /* Prepares the C64 for reading the bus after the specified time has
+     * passed since the beginning of the speculation. The function returns
+     * false if the drive needs to be settled first.
+     */
+    bool observe(u64 lag);
+
+    /* Brings the drive in sync with the C64 after the specified time has
+     * passed since the beginning of the speculation and takes the drive back
+     * from the helper thread.
+     */
+    void settle(u64 lag);
+
+    // Terminates the helper thread
+    void stop();
+
+private:
+
+    // Waits until the helper thread has stopped executing the drive
+    void pause();
+
+    // Saves or restores the drive state
+    void save();
+    void restore();
+
+    // The main function of the helper thread
+    void execute();
+};
@@ -18,19 +18,48 @@ IEC::_reset()
     clockLine = 1;
     dataLine = 1;
     
-    device1Atn = 1;
-    device1Clock = 1;
-    device1Data = 1;
-
-    device2Atn = 1;
-    device2Clock = 1;
-    device2Data = 1;
+    for (isize i = 0; i < DRIVE_COUNT; i++) {
+        
+        deviceAtn[i] = 1;
+        deviceClock[i] = 1;
+        deviceData[i] = 1;
+    }
     
     ciaAtn = 1;
     ciaClock = 1;
     ciaData = 1;
 }
 
+long
+IEC::getConfigItem(Option option) const
+{
+    switch (option) {
+            
+        case OPT_IEC_TURBO:  return config.turbo;
+            
+        default:
+            assert(false);
+            return 0;
+    }
+}
+
+bool
+IEC::setConfigItem(Option option, long value)
+{
+    switch (option) {
+            
+        case OPT_IEC_TURBO:
+            
+            if (config.turbo == value) return false;
+            
+            config.turbo = value;
+            return true;
+            
+        default:
+            return false;
+    }
+}
+
 void 
 IEC::_dump() const
 {
@@ -39,8 +68,9 @@ IEC::_dump() const
 	msg("\n");
 	// dumpTrace();
 	msg("\n");
-    msg("    DDRB (VIA1) : %02X (Drive 1)\n", drive8.via1.getDDRB());
-    msg("    DDRB (VIA1) : %02X (Drive 2)\n", drive9.via1.getDDRB());
+    for (isize i = 0; i < DRIVE_COUNT; i++) {
+        msg("    DDRB (VIA1) : %02X (Drive %ld)\n", drive[i]->via1.getDDRB(), i + 8);
+    }
     msg("   Bus activity : %d\n", busActivity); 
 
     msg("\n");
@@ -52,6 +82,38 @@ IEC::dumpTrace()
     trace(IEC_DEBUG, "ATN: %d CLK: %d DATA: %d\n", atnLine, clockLine, dataLine);
 }
 
+void
+IEC::setNeedsUpdateC64Side()
+{
+    if (isDirtyC64Side) return;
+    
+    // Only changes of the driven values need to be propagated
+    u8 ciaBits = cia2.getPA();
+    if (ciaAtn == !!(ciaBits & 0x08) &&
+        ciaClock == !!(ciaBits & 0x10) &&
+        ciaData == !!(ciaBits & 0x20)) return;
+
+    isDirtyC64Side = true;
+    c64.rescheduleEvents();
+}
+
+void
+IEC::setNeedsUpdateDriveSide(const Drive &drive)
+{
+    if (isDirtyDriveSide) return;
+    
+    // Only changes of the driven values need to be propagated
+    u8 bits = drive.via1.getPB();
+    bool atn = !!(bits & 0x10);
+    bool clock = !!(bits & 0x08);
+    bool data = !!(bits & 0x02);
+    
+    isize i = drive.getDeviceNr() - DRIVE8;
+    if (atn == deviceAtn[i] && clock == deviceClock[i] && data == deviceData[i]) return;
+    
+    isDirtyDriveSide = true;
+}
+
 bool IEC::_updateIecLines()
 {
     // Save current values
@@ -61,8 +123,13 @@ bool IEC::_updateIecLines()
     
     // Compute bus signals (inverted and "wired AND")
     atnLine = !ciaAtn;
-    clockLine = !device1Clock && !device2Clock && !ciaClock;
-    dataLine = !device1Data && !device2Data && !ciaData;
+    clockLine = !ciaClock;
+    dataLine = !ciaData;
+    for (isize i = 0; i < DRIVE_COUNT; i++) {
+        
+        clockLine &= !deviceClock[i];
+        dataLine &= !deviceData[i];
+    }
     
     // Auto-acknowdlege logic
     
@@ -88,8 +155,9 @@ bool IEC::_updateIecLines()
      *    dataLine &= ub1;
      * }
     */
-    dataLine &= !drive8.isActive() || (atnLine ^ device1Atn);
-    dataLine &= !drive9.isActive() || (atnLine ^ device2Atn);
+    for (isize i = 0; i < DRIVE_COUNT; i++) {
+        dataLine &= !drive[i]->isActive() || (atnLine ^ deviceAtn[i]);
+    }
 
     return (oldAtnLine != atnLine ||
             oldClockLine != clockLine ||
@@ -106,11 +174,13 @@ IEC::updateIecLines()
 
     if (signalsChanged) {
         
+        // Bus activity ends the sleep phase of idle drives
+        for (isize i = 0; i < DRIVE_COUNT; i++) drive[i]->wakeUp();
+        
         cia2.updatePA();
         
         // ATN signal is connected to CA1 pin of VIA 1
-        drive8.via1.CA1action(!atnLine);
-        drive9.via1.CA1action(!atnLine);
+        for (isize i = 0; i < DRIVE_COUNT; i++) drive[i]->via1.CA1action(!atnLine);
         
         // dumpTrace();
         
@@ -138,17 +208,14 @@ IEC::updateIecLinesC64Side()
 void
 IEC::updateIecLinesDriveSide()
 {
-    // Get bus signals from drive 1
-    u8 device1Bits = drive8.via1.getPB();
-    device1Atn = !!(device1Bits & 0x10);
-    device1Clock = !!(device1Bits & 0x08);
-    device1Data = !!(device1Bits & 0x02);
-
-    // Get bus signals from drive 2
-    u8 device2Bits = drive9.via1.getPB();
-    device2Atn = !!(device2Bits & 0x10);
-    device2Clock = !!(device2Bits & 0x08);
-    device2Data = !!(device2Bits & 0x02);
+    // Get bus signals from the drives
+    for (isize i = 0; i < DRIVE_COUNT; i++) {
+        
+        u8 bits = drive[i]->via1.getPB();
+        deviceAtn[i] = !!(bits & 0x10);
+        deviceClock[i] = !!(bits & 0x08);
+        deviceData[i] = !!(bits & 0x02);
+    }
     
     updateIecLines();
     isDirtyDriveSide = false;
@@ -165,7 +232,8 @@ IEC::execute()
 void
 IEC::updateTransferStatus()
 {
-    bool rotating = drive8.isRotating() || drive9.isRotating();
+    bool rotating = false;
+    for (isize i = 0; i < DRIVE_COUNT; i++) rotating |= drive[i]->isRotating();
     bool newValue = rotating && busActivity > 0;
     
     if (transferring != newValue) {
@@ -173,3 +241,24 @@ IEC::updateTransferStatus()
         c64.putMessage(newValue ? MSG_IEC_BUS_BUSY : MSG_IEC_BUS_IDLE);
     }
 }
+
+void
+IEC::vsyncHandler()
+{
+    /* The transfer status is only cleared after the bus has been silent for
+     * a while (see busActivity). Hence, the short pauses between two blocks
+     * don't toggle warp mode back and forth. As in the datasette's turbo
+     * mode, the emulation is not altered in any way. Only the host stops
+     * pacing the emulator and the SID ramps the volume down.
+     */
+    bool active = config.turbo && transferring;
+    if (active == turbo) return;
+    
+    // Don't take over a warp mode which has been switched on by someone else
+    if (active && c64.inWarpMode()) return;
+    
+    trace(IEC_DEBUG, "Turbo mode %s\n", active ? "on" : "off");
+    
+    turbo = active;
+    c64.setWarp(active);
+}
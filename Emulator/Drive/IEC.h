@@ -13,6 +13,16 @@
 
 class IEC : public C64Component {
 
+    // Current configuration
+    IECConfig config = { };
+    
+    /* Indicates if warp mode has been switched on by the turbo mode. If the
+     * turbo mode is enabled, warp mode is switched on while data is
+     * transferred from or to a drive and switched off again when the bus
+     * becomes idle.
+     */
+    bool turbo = false;
+    
 public:
     
 	// Current values of the IEC bus lines
@@ -21,26 +31,22 @@ public:
 	bool dataLine;
 	 	
     /* Indicates if the bus lines variables need an undate, because the values
-     * coming from the C64 side have changed.
-     * DEPRECATED
+     * coming from the C64 side have changed. The flag is only set if CIA2
+     * drives a different value on one of the bus lines. The update is then
+     * scheduled as an event for the next cycle.
      */
     bool isDirtyC64Side;
 
     /* Indicates if the bus lines variables need an undate, because the values
-     * coming from the drive side have changed.
-     * DEPRECATED
+     * coming from the drive side have changed. The flag is only set if VIA1
+     * of one of the drives drives a different value on one of the bus lines.
      */
     bool isDirtyDriveSide;
 
-    // Bus driving values from drive 1
-    bool device1Atn;
-    bool device1Clock;
-    bool device1Data;
-    
-    // Bus driving values from drive 2
-    bool device2Atn;
-    bool device2Clock;
-    bool device2Data;
+    // Bus driving values from the drives (indexed by device number minus 8)
+    bool deviceAtn[DRIVE_COUNT];
+    bool deviceClock[DRIVE_COUNT];
+    bool deviceData[DRIVE_COUNT];
     
     // Bus driving values from the CIA
     bool ciaAtn;
@@ -70,6 +76,18 @@ private:
     void _reset() override;
 
     
+    //
+    // Configuring
+    //
+    
+public:
+    
+    IECConfig getConfig() const { return config; }
+    
+    long getConfigItem(Option option) const;
+    bool setConfigItem(Option option, long value) override;
+    
+    
     //
     // Analyzing
     //
@@ -101,12 +119,9 @@ private:
         & dataLine
         & isDirtyC64Side
         & isDirtyDriveSide
-        & device1Atn
-        & device1Clock
-        & device1Data
-        & device2Atn
-        & device2Clock
-        & device2Data
+        & deviceAtn
+        & deviceClock
+        & deviceData
         & ciaAtn
         & ciaClock
         & ciaData
@@ -114,8 +129,10 @@ private:
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
     
     
     //
@@ -124,13 +141,14 @@ private:
     
 public:
     
-    // Requensts an update of the bus lines from the C64 side
-    // DEPRECATED
-    void setNeedsUpdateC64Side() { isDirtyC64Side = true; }
-
-    // Requensts an update of the bus lines from the drive side
-    // DEPRECATED
-    void setNeedsUpdateDriveSide() { isDirtyDriveSide = true; }
+    /* Requests an update of the bus lines from the C64 side or the drive
+     * side. These functions are called whenever the port registers of CIA2 or
+     * VIA1 change. The request is dropped if the driven bus values stay the
+     * same. Hence, port activity unrelated to the bus (e.g., switching the
+     * VICII memory bank) neither synchronizes nor wakes up the drives.
+     */
+    void setNeedsUpdateC64Side();
+    void setNeedsUpdateDriveSide(const class Drive &drive);
 
     /* Updates all three bus lines. The new values are determined by VIA1
      * (drive side) and CIA2 (C64 side).
@@ -150,6 +168,12 @@ public:
     // Updates variable transferring
     void updateTransferStatus();
     
+    // Returns true if warp mode has been switched on by the turbo mode
+    bool inTurboMode() const { return turbo; }
+    
+    // Switches the turbo mode on or off (called at the end of each frame)
+    void vsyncHandler();
+    
 private:
     
     void updateIecLines();
@@ -102,15 +102,10 @@ VIA6522::execute()
     // Move trigger event flags left and feed in new bits
     delay = ((delay << 1) & VIAClearBits) | feed;
     
-    // Go into idle state if possible
-    if (oldDelay == delay && oldFeed == feed) {
-        if (++tiredness > 4) {
-            sleep();
-            tiredness = 0;
-        }
-    } else {
-        tiredness = 0;
-    }
+    /* Go into idle state if the delay pipeline has reached a fixed point. From
+     * now on, all cycles look the same until one of the timers underflows.
+     */
+    if (oldDelay == delay && oldFeed == feed) sleep();
 }
 
 void
@@ -809,8 +804,8 @@ VIA1::portBexternal() const
     
     external |= 0x1A; // All "out" pins are read as 1
     
-    // Assign device address
-    if (drive.getDeviceNr() == DRIVE9) external |= 0x20;
+    // Assign device address (jumpers PB5 and PB6)
+    external |= (u8)((drive.getDeviceNr() - DRIVE8) << 5);
     
     return external;
 }
@@ -819,7 +814,7 @@ void
 VIA1::updatePB()
 {
     VIA6522::updatePB();
-    iec.setNeedsUpdateDriveSide();
+    iec.setNeedsUpdateDriveSide(drive);
 }
 
 //
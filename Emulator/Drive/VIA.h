@@ -196,13 +196,12 @@ class VIA6522 : public C64Component {
     // Speeding up emulation (sleep logic)
     //
     
-    /* Idle counter. When the VIA state does not change during execution, this
-     * variable is increased by one. If it exceeds a certain threshhold, the
-     * chip is put into idle state via sleep().
+    /* Wakeup cycle. If the delay pipeline reaches a fixed point, the VIA is put
+     * into idle state via sleep(). In this state, nothing but the timers can
+     * change. Hence, the next cycle that needs emulation can be computed from
+     * the timer values. It is the cycle right before the first underflow
+     * which triggers an interrupt, toggles PB7, or reloads the counter.
      */
-    u8 tiredness;
-    
-    // Wakeup cycle
     u64 wakeUpCycle;
     
     // Number of skipped executions
@@ -270,14 +269,15 @@ private:
         & sr
         & delay
         & feed
-        & tiredness
         & wakeUpCycle
         & idleCounter;
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
     
 
     
@@ -499,7 +499,7 @@ public:
     // Speeding up emulation
     //
     
-    // Puts the VIA into idle state
+    // Puts the VIA into idle state until the predicted wakeup cycle
     void sleep();
     
     // Emulates all previously skipped cycles
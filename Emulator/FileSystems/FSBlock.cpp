@@ -9,21 +9,14 @@
 
 #include "FSDevice.h"
 
-FSBlock::FSBlock(FSDevice& _device, u32 _nr) : device(_device), nr(_nr)
+FSBlock::FSBlock(FSDevice& _device, u32 _nr, u8 *_data) : device(_device), nr(_nr), data(_data)
 {
-    memset(data, 0, sizeof(data));
 }
 
 FSBlockType
 FSBlock::type() const
 {
-    TSLink ts = device.layout.tsLink(nr);
-  
-    if (ts.t == 18) {
-        return ts.s == 0 ? FS_BLOCKTYPE_BAM : FS_BLOCKTYPE_DIR;
-    } else {
-        return FS_BLOCKTYPE_DATA;
-    }
+    return device.blockType(nr);
 }
 
 void
@@ -231,7 +224,10 @@ FSBlock::check(bool strict) const
     unsigned count = 0;
     u8 expected;
     
-    for (u32 i = 0; i < 256; i++) {
+    // Inside data blocks, only the block link is subject to checking
+    u32 numBytes = type() == FS_BLOCKTYPE_DATA ? 2 : 256;
+    
+    for (u32 i = 0; i < numBytes; i++) {
         
         if ((err = check(i, &expected, strict)) != ERROR_OK) {
             count++;
@@ -21,11 +21,8 @@ public:
     // The number of this block
     Block nr;
         
-    // Outcome of the last integrity check (0 = OK, n = n-th corrupted block)
-    u32 corrupted = 0;
-
-    // The actual block data
-    u8 data[256];
+    // The actual block data (stored in the payload buffer of the device)
+    u8 *data;
     
     // Error code (imported from D64 files, 1 = No error)
     u8 errorCode = 1;
@@ -37,7 +34,7 @@ public:
 
 public:
     
-    FSBlock(FSDevice& _device, u32 _nr);
+    FSBlock(FSDevice& _device, u32 _nr, u8 *_data);
     virtual ~FSBlock() { }
     const char *getDescription() const override { return "FSBlock"; }
 
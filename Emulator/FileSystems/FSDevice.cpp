@@ -9,6 +9,10 @@
 
 #include "FSDevice.h"
 #include "Disk.h"
+#include "Concurrency.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 FSDevice *
 FSDevice::makeWithFormat(FSDeviceDescriptor &layout)
@@ -40,13 +44,16 @@ FSDevice::makeWithD64(D64File &d64)
     // Create the device
     FSDevice *device = makeWithFormat(descriptor);
 
-    // Import file system
-    try { device->importVolume(d64.data, d64.size); }
+    // Import file system (error codes are stored behind the last block)
+    try { device->importVolume(d64.data, device->getNumBlocks() * 256); }
     catch (VC64Error &exception) { delete device; throw exception; }
     
     // Import error codes (if any)
     for (Block b = 0; b < device->blocks.size(); b++) {
-        device->setErrorCode(b, d64.getErrorCode(b));
+        
+        // Only materialize blocks with a non-default error code
+        u8 code = d64.getErrorCode(b);
+        if (code != 1) device->setErrorCode(b, code);
     }
     
     return device;
@@ -64,9 +71,9 @@ FSDevice::makeWithD64(D64File &d64, ErrorCode *err)
 FSDevice *
 FSDevice::makeWithDisk(class Disk &disk)
 {
-    // Translate the GCR stream into a byte stream
+    // Translate the GCR stream into a byte stream (the tracks are decoded in parallel)
     u8 buffer[D64File::D64_802_SECTORS];
-    usize len = disk.decodeDisk(buffer);
+    usize len = disk.decodeDiskParallel(buffer, std::thread::hardware_concurrency());
     
     // Create a suitable device descriptor
     FSDeviceDescriptor descriptor = FSDeviceDescriptor(DISK_TYPE_SS_SD);
@@ -114,14 +121,15 @@ FSDevice::makeWithCollection(AnyCollection &collection)
     u32 numberOfItems = (u32)collection.collectionCount();
     for (u32 i = 0; i < numberOfItems; i++) {
         
-        // Serialize item into a buffer
-        u64 size = collection.itemSize(i);
-        u8 *buffer = new u8[size];
-        collection.copyItem(i, buffer, size);
+        // Stop if the directory is full
+        if (!device->getOrCreateNextFreeDirEntry()) break;
         
-        // Create a file for this item
-        device->makeFile(collection.itemName(i), buffer, size);
-        delete[] buffer;
+        // Copy the item chunk by chunk into the allocated blocks
+        auto source = [&](u8 *dst, usize len, usize offset) {
+            collection.copyItem(i, dst, len, offset);
+            return true;
+        };
+        device->makeFile(collection.itemName(i), (usize)collection.itemSize(i), source);
     }
     
     device->printDirectory();
@@ -169,17 +177,15 @@ FSDevice::FSDevice(u32 capacity)
 {
     debug(FS_DEBUG, "Creating device with %d blocks\n", capacity);
     
-    // Initialize the block storage
-    blocks.reserve(capacity);
-    blocks.assign(capacity, 0);
-    
-    // Create all blocks
-    for (u32 i = 0; i < capacity; i++) blocks[i] = new FSBlock(*this, i);
+    // Initialize the block storage (blocks are created on demand)
+    blocks.assign(capacity, nullptr);
+    arena.reset(new std::aligned_storage_t<sizeof(FSBlock), alignof(FSBlock)>[capacity]);
+    payload.reset(new u8[capacity * 256]());
 }
 
 FSDevice::~FSDevice()
 {
-    for (auto &b : blocks) delete b;
+    // Blocks are released together with the arena (see 'arena')
 }
 
 void
@@ -194,10 +200,12 @@ FSDevice::dump() const
     // Dump all blocks
     for (usize i = 0; i < blocks.size(); i++)  {
         
-        msg("\nBlock %zu (%d):", i, blocks[i]->nr);
-        msg(" %s\n", FSBlockTypeEnum::key(blocks[i]->type()));
+        FSBlock *ptr = blockPtr((Block)i);
         
-        blocks[i]->dump();
+        msg("\nBlock %zu (%d):", i, ptr->nr);
+        msg(" %s\n", FSBlockTypeEnum::key(ptr->type()));
+        
+        ptr->dump();
     }
 }
 
@@ -240,31 +248,60 @@ FSDevice::numUsedBlocks() const
 FSBlockType
 FSDevice::blockType(Block b) const
 {
-    return blockPtr(b) ? blocks[b]->type() : FS_BLOCKTYPE_UNKNOWN;
+    // The block type only depends on the location of the block
+    if ((u64)b >= (u64)blocks.size()) return FS_BLOCKTYPE_UNKNOWN;
+    
+    TSLink ts = layout.tsLink(b);
+  
+    if (ts.t == 18) {
+        return ts.s == 0 ? FS_BLOCKTYPE_BAM : FS_BLOCKTYPE_DIR;
+    } else {
+        return FS_BLOCKTYPE_DATA;
+    }
 }
 
 FSUsage
 FSDevice::usage(Block b, u32 pos) const
 {
-    return blockPtr(b) ? blocks[b]->itemType(pos) : FS_USAGE_UNUSED;
+    FSBlock *ptr = blockPtr(b);
+    return ptr ? ptr->itemType(pos) : FS_USAGE_UNUSED;
 }
 
 u8
 FSDevice::getErrorCode(Block b) const
 {
-    return blockPtr(b) ? blocks[b]->errorCode : 0;
+    if ((u64)b >= (u64)blocks.size()) return 0;
+    
+    // Blocks that haven't been materialized carry the default error code
+    return blocks[b] ? blocks[b]->errorCode : 1;
 }
 
 void
 FSDevice::setErrorCode(Block b, u8 code)
 {
-    if (blockPtr(b)) blocks[b]->errorCode = code;
+    if (FSBlock *ptr = blockPtr(b)) ptr->errorCode = code;
 }
 
 FSBlock *
 FSDevice::blockPtr(Block b) const
 {
-    return (u64)b < (u64)blocks.size() ? blocks[b] : nullptr;
+    if ((u64)b >= (u64)blocks.size()) return nullptr;
+    
+    if (!blocks[b]) {
+        
+        auto device = const_cast<FSDevice *>(this);
+        blocks[b] = new (&arena[b]) FSBlock(*device, b, payload.get() + b * 256);
+    }
+    return blocks[b];
+}
+
+usize
+FSDevice::numMaterializedBlocks() const
+{
+    usize result = 0;
+    for (auto &b : blocks) if (b) result++;
+    
+    return result;
 }
 
 FSBlock *
@@ -324,6 +361,7 @@ FSDevice::setAllocBit(TSLink ts, bool value)
 {
     u32 byte, bit;
     FSBlock *bam = locateAllocBit(ts, &byte, &bit);
+    invalidateDirectory();
 
     if (value && !GET_BIT(bam->data[byte], bit)) {
 
@@ -442,30 +480,7 @@ u64
 FSDevice::fileSize(FSDirEntry *entry) const
 {
     assert(entry);
-    
-    u64 size = 0;
-    std::set<Block> visited;
-
-    // Start at the first data block
-    BlockPtr b = blockPtr(entry->firstBlock());
-
-    // Iterate through the block chain
-    while (b && visited.find(b->nr) == visited.end()) {
-                
-        visited.insert(b->nr);
-        BlockPtr next = nextBlockPtr(b);
-                
-        if (next) {
-            size += 254;
-            b = next;
-        } else {
-            // The number of remaining bytes can be derived from the sector link
-            size += b->data[1] ? b->data[1] - 1 : 0;
-        }
-        b = next;
-    }
-    
-    return size;
+    return getFileInfo(entry).size;
 }
 
 u64
@@ -493,8 +508,40 @@ u16
 FSDevice::loadAddr(FSDirEntry *entry) const
 {
     assert(entry);
-    u8 addr[2]; copyFile(entry, addr, 2);
-    return LO_HI(addr[0], addr[1]);
+    return getFileInfo(entry).loadAddr;
+}
+
+const FSDevice::FileInfo &
+FSDevice::getFileInfo(FSDirEntry *entry) const
+{
+    auto it = fileInfo.find(entry);
+    if (it != fileInfo.end()) return it->second;
+    
+    FileInfo info = { 0, 0 };
+    std::vector<bool> visited(blocks.size());
+    
+    // Start at the first data block
+    BlockPtr b = blockPtr(entry->firstBlock());
+    
+    // The load address is stored in the first two bytes
+    if (b) info.loadAddr = LO_HI(b->data[2], b->data[3]);
+
+    // Iterate through the block chain
+    while (b && !visited[b->nr]) {
+                
+        visited[b->nr] = true;
+        BlockPtr next = nextBlockPtr(b);
+                
+        if (next) {
+            info.size += 254;
+        } else {
+            // The number of remaining bytes can be derived from the sector link
+            info.size += b->data[1] ? b->data[1] - 1 : 0;
+        }
+        b = next;
+    }
+    
+    return fileInfo[entry] = info;
 }
 
 void
@@ -511,22 +558,20 @@ FSDevice::copyFile(FSDirEntry *entry, u8 *buf, u64 len, u64 offset) const
     
     // Start at the first data block
     BlockPtr b = blockPtr(entry->firstBlock());
-    u64 pos = 2;
     
-    // Iterate through the block chain
+    // Skip all blocks in front of the requested data
+    for (; b && offset >= 254; offset -= 254) b = nextBlockPtr(b);
+    
+    // Copy the data block by block
     while (b && len) {
-                
-        if (offset) {
-            --offset;
-        } else {
-            --len;
-            *buf++ = b->data[pos];
-        }
         
-        if (++pos == 256) {
-            b = nextBlockPtr(b);
-            pos = 2;
-        }
+        u64 chunk = MIN(len, 254 - offset);
+        memcpy(buf, b->data + 2 + offset, chunk);
+        
+        buf += chunk;
+        len -= chunk;
+        offset = 0;
+        b = nextBlockPtr(b);
     }
 }
 
@@ -554,6 +599,7 @@ FSDevice::getOrCreateNextFreeDirEntry()
         TSLink ts = layout.nextBlockRef(layout.tsLink(ptr->nr));
         ptr->data[0] = ts.t;
         ptr->data[1] = ts.s;
+        invalidateDirectory();
     }
     
     return nullptr;
@@ -562,8 +608,13 @@ FSDevice::getOrCreateNextFreeDirEntry()
 void
 FSDevice::scanDirectory(bool skipInvisible)
 {
+    // Skip the scan if the directory hasn't changed
+    if (dirValid && dirSkipsInvisible == skipInvisible) return;
+    
     // Start from scratch
     dir.clear();
+    dirValid = true;
+    dirSkipsInvisible = skipInvisible;
     
     // The directory starts on track 18, sector 1
     FSBlock *ptr = blockPtr(TSLink{18,1});
@@ -584,136 +635,213 @@ FSDevice::scanDirectory(bool skipInvisible)
     }
 }
 
+void
+FSDevice::invalidateDirectory()
+{
+    dirValid = false;
+    fileInfo.clear();
+}
+
 bool
 FSDevice::makeFile(PETName<16> name, const u8 *buf, usize cnt)
+{
+    auto source = [buf](u8 *dst, usize len, usize offset) {
+        memcpy(dst, buf + offset, len);
+        return true;
+    };
+    return makeFile(name, cnt, source);
+}
+
+bool
+FSDevice::makeFile(PETName<16> name, usize cnt, const FileSource &source)
 {
     // Search the next free directory slot
     FSDirEntry *dir = getOrCreateNextFreeDirEntry();
 
     // Create the file if we've found a free slot
-    if (dir) return makeFile(name, dir, buf, cnt);
+    if (dir) return makeFile(name, dir, cnt, source);
          
     return false;
 }
 
 bool
-FSDevice::makeFile(PETName<16> name, FSDirEntry *dir, const u8 *buf, usize cnt)
+FSDevice::makeFile(PETName<16> name, FSDirEntry *dir, usize cnt, const FileSource &source)
 {
     // Determine the number of blocks needed for this file
-    u32 numBlocks = (u32)((cnt + 253) / 254);
-    
-    printf("size = %zu (%02x %02x)\n", cnt, buf[0], buf[1]);
+    u32 numBlocks = (u32)MAX((cnt + 253) / 254, 1);
+    if (numBlocks > numFreeBlocks()) return false;
     
     // Allocate data blocks
     auto blockList = allocate(numBlocks);
     if (blockList.empty()) return false;
-        
-    auto it = blockList.begin();
-    FSBlock *ptr = blockPtr(*it);
     
     // Write data
-    usize i, j;
-    for (i = 0, j = 2; i < cnt; i++, j++) {
-
-        if (j == 0x100) {
-            ++it;
-            ptr = blockPtr(*it);
-            j = 2;
+    FSBlock *ptr = nullptr;
+    for (u32 i = 0; i < numBlocks; i++) {
+        
+        usize offset = (usize)i * 254;
+        usize chunk = MIN(cnt - offset, 254);
+        
+        ptr = blockPtr(blockList[i]);
+        if (chunk && !source(ptr->data + 2, chunk, offset)) {
+            
+            // Roll back the allocation
+            for (auto &ts : blockList) markAsFree(ts);
+            return false;
         }
-        ptr->data[j] = buf[i];
     }
- 
-    // Store the size of the last data chunk inside the sector link
+    
+    // Store the position of the last data byte inside the sector link
     assert(ptr->data[0] == 0);
-    ptr->data[1] = (cnt % 254) + 1;
+    ptr->data[1] = cnt ? (u8)((cnt - 1) % 254 + 2) : 1;
     
     // Write directory entry
     dir->init(name, blockList[0], numBlocks);
+    invalidateDirectory();
     
     return true;
 }
 
 FSErrorReport
-FSDevice::check(bool strict)
+FSDevice::check(bool strict, isize numThreads)
 {
-    FSErrorReport result;
-
-    long total = 0, min = LONG_MAX, max = 0;
-    usize numBlocks = blocks.size();
+    FSErrorReport result = { };
+    u32 numBlocks = (u32)blocks.size();
+    
+    // Materialize all blocks up front (workers must not modify the storage)
+    for (u32 i = 0; i < numBlocks; i++) blockPtr(i);
     
-    // Analyze all blocks
+    // Analyze all blocks in parallel
+    std::vector<u8> faulty(numBlocks);
+    std::atomic<u32> next { 0 };
+    
+    auto job = [&]() {
+        
+        for (u32 i = next++; i < numBlocks; i = next++) {
+            faulty[i] = blocks[i]->check(strict) > 0;
+        }
+    };
+    
+    numThreads = MAX(1, MIN(numThreads, (isize)numBlocks));
+    std::unique_ptr<WorkerThread[]> workers(new WorkerThread[numThreads]);
+    for (isize i = 0; i < numThreads; i++) workers[i].run(job);
+    for (isize i = 0; i < numThreads; i++) workers[i].join();
+    
+    // Record the corrupted blocks in ascending order
+    corruptedBlocks.clear();
     for (u32 i = 0; i < numBlocks; i++) {
-
-        if (blocks[i]->check(strict) > 0) {
-            min = MIN(min, i);
-            max = MAX(max, i);
-            blocks[i]->corrupted = (u32)++total;
-        } else {
-            blocks[i]->corrupted = 0;
+        if (faulty[i]) corruptedBlocks.push_back(i);
+    }
+    
+    // Compare the allocation bitmap with the blocks that are actually in use
+    if (layout.dos == DOS_TYPE_CBM && numBlocks > 357) {
+        
+        std::vector<bool> used(numBlocks);
+        collectUsedBlocks(used);
+        
+        const u8 *bam = blockData(357);
+        for (Track t = 1; t <= MIN(layout.numTracks(), 35); t++) {
+            for (Sector s = 0; s < layout.numSectors(t); s++) {
+                
+                bool free = GET_BIT(bam[4 * t + 1 + (s >> 3)], s & 0x07);
+                if (free == used[layout.blockNr(t, s)]) result.bitmapErrors++;
+            }
         }
     }
-
+    
     // Record findings
-    if (total) {
-        result.corruptedBlocks = total;
-        result.firstErrorBlock = min;
-        result.lastErrorBlock = max;
-    } else {
-        result.corruptedBlocks = 0;
-        result.firstErrorBlock = min;
-        result.lastErrorBlock = max;
-    }
+    result.corruptedBlocks = (long)corruptedBlocks.size();
+    result.firstErrorBlock = corruptedBlocks.empty() ? LONG_MAX : corruptedBlocks.front();
+    result.lastErrorBlock = corruptedBlocks.empty() ? 0 : corruptedBlocks.back();
     
     return result;
 }
 
+void
+FSDevice::collectUsedBlocks(std::vector<bool> &used) const
+{
+    u32 numBlocks = (u32)used.size();
+    
+    // Follows a block chain until it ends, leaves the volume, or loops
+    auto walk = [&](TSLink ts, std::vector<Block> *chain = nullptr) {
+        
+        for (Block b = layout.blockNr(ts); b < numBlocks && !used[b];) {
+            
+            used[b] = true;
+            if (chain) chain->push_back(b);
+            
+            const u8 *data = blockData(b);
+            b = layout.blockNr(TSLink{data[0], data[1]});
+        }
+    };
+    
+    // The BAM and the directory
+    std::vector<Block> directory;
+    used[357] = true;
+    walk(TSLink{18,1}, &directory);
+    
+    // All files that haven't been deleted
+    for (Block b : directory) {
+        
+        FSDirEntry *entry = (FSDirEntry *)blockData(b);
+        for (int i = 0; i < 8; i++, entry++) {
+            
+            if (entry->fileType == 0) continue;
+            
+            walk(entry->firstBlock());
+            
+            // Relative files also occupy a chain of side sectors
+            if (entry->getFileType() == FS_FILETYPE_REL) {
+                walk(TSLink{entry->sideSecBlkTrack, entry->sideSrcBlkSector});
+            }
+        }
+    }
+    
+    // The remaining blocks on the directory track are reserved, too
+    for (Sector s = 0; s < layout.numSectors(18); s++) {
+        used[layout.blockNr(18, s)] = true;
+    }
+}
+
 ErrorCode
 FSDevice::check(u32 blockNr, u32 pos, u8 *expected, bool strict)
 {
-    return blocks[blockNr]->check(pos, expected, strict);
+    return blockPtr(blockNr)->check(pos, expected, strict);
 }
 
 u32
 FSDevice::getCorrupted(u32 blockNr) const
 {
-    return blockPtr(blockNr) ? blocks[blockNr]->corrupted : 0;
+    auto it = std::lower_bound(corruptedBlocks.begin(), corruptedBlocks.end(), blockNr);
+    
+    if (it == corruptedBlocks.end() || *it != blockNr) return 0;
+    return (u32)(it - corruptedBlocks.begin()) + 1;
 }
 
 bool
 FSDevice::isCorrupted(u32 blockNr, u32 n) const
 {
-    usize numBlocks = blocks.size();
-    
-    for (u32 i = 0, cnt = 0; i < numBlocks; i++) {
-        
-        if (isCorrupted(i)) {
-            cnt++;
-            if (blockNr == i) return cnt == n;
-        }
-    }
-    return false;
+    return n > 0 && getCorrupted(blockNr) == n;
 }
 
 u32
 FSDevice::nextCorrupted(u32 blockNr) const
 {
-    usize numBlocks = blocks.size();
-    
-    for (u32 i = blockNr + 1; i < numBlocks; i++) {
-        if (isCorrupted(i)) return i;
-    }
-    return blockNr;
+    auto it = std::upper_bound(corruptedBlocks.begin(), corruptedBlocks.end(), blockNr);
+    return it != corruptedBlocks.end() ? *it : blockNr;
 }
 
 u32
 FSDevice::prevCorrupted(u32 blockNr) const
 {
-    usize numBlocks = blocks.size();
-    
-    for (u32 i = blockNr - 1; i < numBlocks; i--) {
-        if (isCorrupted(i)) return i;
-    }
-    return blockNr;
+    auto it = std::lower_bound(corruptedBlocks.begin(), corruptedBlocks.end(), blockNr);
+    return it != corruptedBlocks.begin() ? *(--it) : blockNr;
+}
+
+u32
+FSDevice::seekCorruptedBlock(u32 n) const
+{
+    return n > 0 && n <= corruptedBlocks.size() ? corruptedBlocks[n - 1] : (u32)(-1);
 }
 
 u8
@@ -722,7 +850,7 @@ FSDevice::readByte(u32 block, u32 offset) const
     assert(offset < 256);
     assert(block < blocks.size());
     
-    return blocks[block]->data[offset];
+    return blockData(block)[offset];
 }
 
 void
@@ -748,11 +876,8 @@ FSDevice::importVolume(const u8 *src, usize size, ErrorCode *err)
     }
         
     // Import all blocks
-    for (u32 i = 0; i < blocks.size(); i++) {
-        
-        const u8 *data = src + i * 256;
-        blocks[i]->importBlock(data);
-    }
+    memcpy(payload.get(), src, size);
+    invalidateDirectory();
     
     if (err) *err = ERROR_OK;
 
@@ -810,15 +935,20 @@ FSDevice::importDirectory(const std::string &path, DIR *dir)
         
         if (item->d_type == DT_DIR) continue;
         
-        u8 *buf; long len;
-        if (loadFile(full, &buf, &len)) {
-            
-            PETName<16> pet = PETName<16>(stripSuffix(name));
-            if (!makeFile(pet, buf, len)) {
-                warn("Failed to import file %s\n", name.c_str());
-                result = false;
-            }
-            delete[] buf;
+        // Stop if the directory is full
+        if (!getOrCreateNextFreeDirEntry()) break;
+        
+        // Stream the file into the allocated blocks
+        std::ifstream stream(full, std::ios::binary);
+        if (!stream.is_open()) continue;
+        
+        auto source = [&](u8 *dst, usize len, usize offset) {
+            return (bool)stream.read((char *)dst, len);
+        };
+        PETName<16> pet = PETName<16>(stripSuffix(name));
+        if (!makeFile(pet, streamLength(stream), source)) {
+            warn("Failed to import file %s\n", name.c_str());
+            result = false;
         }
     }
     return result;
@@ -862,14 +992,8 @@ FSDevice::exportBlocks(u32 first, u32 last, u8 *dst, usize size, ErrorCode *err)
         return false;
     }
         
-    // Wipe out the target buffer
-    memset(dst, 0, size);
-    
     // Export all blocks
-    for (u32 i = 0; i < count; i++) {
-        
-        blocks[first + i]->exportBlock(dst + i * 256);
-    }
+    memcpy(dst, blockData(first), size);
 
     debug(FS_DEBUG, "Success\n");
     
@@ -16,13 +16,43 @@
 #include "AnyCollection.h"
 
 #include <dirent.h>
+#include <functional>
+#include <unordered_map>
 
 class FSDevice : C64Object {
     
     friend class FSBlock;
         
-    // The block storage
-    std::vector<BlockPtr> blocks;
+    /* The block storage. Blocks are materialized when they are accessed for
+     * the first time (nullptr = not materialized yet).
+     */
+    mutable std::vector<BlockPtr> blocks;
+    
+    /* Arena holding all block objects. A block is constructed in its slot
+     * when it gets materialized. Because blocks don't own any resources, the
+     * arena is released as a whole without destroying the blocks one by one.
+     */
+    std::unique_ptr<std::aligned_storage_t<sizeof(FSBlock), alignof(FSBlock)>[]> arena;
+    
+    // Contents of all blocks in a single contiguous buffer
+    std::unique_ptr<u8[]> payload;
+
+    // Corrupted blocks found by the latest integrity check in ascending order
+    std::vector<Block> corruptedBlocks;
+
+    // Information about a file that is computed by following its block chain
+    struct FileInfo {
+        
+        u64 size;
+        u16 loadAddr;
+    };
+    
+    // Cached file information (discarded when the file system is modified)
+    mutable std::unordered_map<const FSDirEntry *, FileInfo> fileInfo;
+    
+    // Indicates if 'dir' reflects the current directory
+    bool dirValid = false;
+    bool dirSkipsInvisible = false;
 
 public:
     
@@ -135,10 +165,18 @@ public:
     void setErrorCode(Block b, u8 code);
     void setErrorCode(TSLink ts, u8 code) { setErrorCode(layout.blockNr(ts), code); }
 
-    // Queries a pointer from the block storage (may return nullptr)
+    /* Queries a pointer from the block storage (may return nullptr). The
+     * block is materialized if it hasn't been accessed before.
+     */
     FSBlock *blockPtr(Block b) const;
     FSBlock *blockPtr(TSLink ts) const { return blockPtr(layout.blockNr(ts)); }
-    FSBlock *bamPtr() const { return blocks[357]; }
+    FSBlock *bamPtr() const { return blockPtr(357); }
+
+    // Returns the contents of a block without materializing it
+    const u8 *blockData(Block b) const { return payload.get() + b * 256; }
+    
+    // Returns the number of materialized blocks
+    usize numMaterializedBlocks() const;
     
     // Follows the block chain link of a specific block
     FSBlock *nextBlockPtr(Block b) const;
@@ -209,8 +247,23 @@ public:
     void copyFile(usize nr, u8 *buf, u64 len, u64 offset = 0) const;
     void copyFile(FSDirEntry *entry, u8 *buf, u64 len, u64 offset = 0) const;
 
-    // Scans the directory and stores the result in variable 'dir'
+    /* Scans the directory and stores the result in variable 'dir'. The scan
+     * is skipped if the file system hasn't changed since the last scan.
+     */
     void scanDirectory(bool skipInvisible = true);
+    
+    /* Discards the cached directory and file information. This function is
+     * called by all functions modifying the file system. It needs to be
+     * called manually after modifying the block data directly.
+     */
+    void invalidateDirectory();
+
+private:
+    
+    // Returns the size and the load address of a file
+    const FileInfo &getFileInfo(FSDirEntry *entry) const;
+    
+public:
 
     
     //
@@ -220,12 +273,19 @@ public:
     // Returns the next free directory entry or creates one
     FSDirEntry *getOrCreateNextFreeDirEntry(); 
                     
+    /* Delivers a chunk of a file that is being created. The chunk is copied
+     * straight into the destination block. Chunks are requested in ascending
+     * order. A return value of false aborts the operation.
+     */
+    typedef std::function<bool(u8 *dst, usize len, usize offset)> FileSource;
+
     // Creates a new file
     bool makeFile(PETName<16> name, const u8 *buf, usize cnt);
+    bool makeFile(PETName<16> name, usize cnt, const FileSource &source);
 
 private:
     
-    bool makeFile(PETName<16> name, FSDirEntry *entry, const u8 *buf, usize cnt);
+    bool makeFile(PETName<16> name, FSDirEntry *entry, usize cnt, const FileSource &source);
 
     
     //
@@ -234,8 +294,11 @@ private:
 
 public:
     
-    // Checks all blocks in this volume
-    FSErrorReport check(bool strict);
+    /* Checks all blocks in this volume. The blocks are distributed among
+     * the specified number of threads. In addition, the allocation bitmap is
+     * compared with the blocks occupied by the directory and all files.
+     */
+    FSErrorReport check(bool strict, isize numThreads = 4);
 
     // Checks a single byte in a certain block
     ErrorCode check(u32 blockNr, u32 pos, u8 *expected, bool strict);
@@ -253,9 +316,14 @@ public:
     // Checks if a certain block is the n-th corrupted block
     bool isCorrupted(u32 blockNr, u32 n) const;
 
-    // Returns the number of the the n-th corrupted block
+    // Returns the number of the the n-th corrupted block (-1 if none exists)
     u32 seekCorruptedBlock(u32 n) const;
 
+private:
+
+    // Marks all blocks occupied by the BAM, the directory, and all files
+    void collectUsedBlocks(std::vector<bool> &used) const;
+
     
     //
     // Importing and exporting
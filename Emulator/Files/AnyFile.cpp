@@ -17,6 +17,9 @@
 #include "P00File.h"
 #include "D64File.h"
 #include "G64File.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 AnyFile::AnyFile(usize capacity)
 {
@@ -26,7 +29,11 @@ AnyFile::AnyFile(usize capacity)
 
 AnyFile::~AnyFile()
 {
-    if (data) delete[] data;
+    if (mapped) {
+        munmap(data, size);
+    } else if (data) {
+        delete[] data;
+    }
 }
 
 PETName<16>
@@ -57,6 +64,20 @@ AnyFile::flash(u8 *buffer, usize offset)
 usize
 AnyFile::readFromStream(std::istream &stream)
 {
+    // Take over the buffer of a memory stream if possible
+    auto memory = dynamic_cast<MemoryStream *>(&stream);
+    if (memory && memory->isOwner() && stream.tellg() == 0) {
+
+        assert(data == nullptr);
+        size = memory->getLength();
+        mapped = memory->isMapped();
+        data = memory->release();
+        stream.seekg(0, std::ios::end);
+
+        repair();
+        return size;
+    }
+    
     // Get stream size
     auto fsize = stream.tellg();
     stream.seekg(0, std::ios::end);
@@ -100,13 +121,58 @@ AnyFile::readFromBuffer(const u8 *buf, usize len)
 {
     assert(buf);
 
-    std::istringstream stream(std::string((const char *)buf, len));
+    MemoryStream stream(buf, len);
     
     usize result = readFromStream(stream);
     assert(result == size);
     return size;
 }
 
+void
+AnyFile::replaceData(u8 *buf, usize len)
+{
+    if (mapped) {
+        munmap(data, size);
+    } else {
+        delete [] data;
+    }
+    
+    data = buf;
+    size = len;
+    mapped = false;
+}
+
+void
+AnyFile::makeWritable()
+{
+    if (!mapped) return;
+    
+    u8 *buf = new u8[size];
+    memcpy(buf, data, size);
+    replaceData(buf, size);
+}
+
+u8 *
+AnyFile::mapFile(const string &path, usize *len)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    
+    struct stat info;
+    void *mapping = MAP_FAILED;
+    
+    // Only map regular, non-empty files whose size fits into the address space
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) &&
+        info.st_size > 0 && (u64)info.st_size <= SIZE_MAX) {
+        
+        *len = (usize)info.st_size;
+        mapping = mmap(nullptr, *len, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    
+    return mapping == MAP_FAILED ? nullptr : (u8 *)mapping;
+}
+
 usize
 AnyFile::writeToStream(std::ostream &stream)
 {
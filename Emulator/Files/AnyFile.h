@@ -58,6 +58,11 @@ public:
     // The size of this file in bytes
     usize size = 0;
     
+protected:
+    
+    // Indicates if the data is a memory mapping instead of a heap buffer
+    bool mapped = false;
+    
 
     //
     // Creating
@@ -86,10 +91,10 @@ public:
         return nullptr;
     }
         
+    // Reads from the buffer directly (the data is copied once into the file)
     template <class T> static T *make(const u8 *buf, usize len) throws
     {
-        std::stringstream stream;
-        stream.write((const char *)buf, len);
+        MemoryStream stream(buf, len);
         return make <T> (stream);
     }
     
@@ -101,13 +106,32 @@ public:
         return nullptr;
     }
     
+    /* Takes over a buffer allocated with new[] without copying it. The buffer
+     * is owned by the file afterwards or deleted if no file can be created.
+     */
+    template <class T> static T *adopt(u8 *buf, usize len) throws
+    {
+        MemoryStream stream(buf, len, true);
+        return make <T> (stream);
+    }
+
+    template <class T> static T *adopt(u8 *buf, usize len, ErrorCode *err)
+    {
+        *err = ERROR_OK;
+        try { return adopt <T> (buf, len); }
+        catch (VC64Error &exception) { *err = exception.errorCode; }
+        return nullptr;
+    }
+    
     template <class T> static T *make(const string &path) throws
     {
         if (!T::isCompatibleName(path)) throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
         
         std::ifstream stream(path);
         if (!stream.is_open()) throw VC64Error(ERROR_FILE_NOT_FOUND);
-        return make <T> (stream);
+        T *obj = make <T> (stream);
+        obj->path = path;
+        return obj;
     }
 
     template <class T> static T *make(const string &path, ErrorCode *err)
@@ -118,6 +142,33 @@ public:
         return nullptr;
     }
     
+    /* Maps the file into memory instead of reading it. The mapping is
+     * read-only, i.e., pages are shared with all other mappings of the same
+     * file. Files that need to be repaired are copied into memory first.
+     * Falls back to reading the file if it can't be mapped.
+     */
+    template <class T> static T *map(const string &path) throws
+    {
+        if (!T::isCompatibleName(path)) throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+
+        usize len;
+        u8 *mapping = mapFile(path, &len);
+        if (!mapping) return make <T> (path);
+        
+        MemoryStream stream(mapping, len, true, true);
+        T *obj = make <T> (stream);
+        obj->path = path;
+        return obj;
+    }
+
+    template <class T> static T *map(const string &path, ErrorCode *err)
+    {
+        *err = ERROR_OK;
+        try { return map <T> (path); }
+        catch (VC64Error &exception) { *err = exception.errorCode; }
+        return nullptr;
+    }
+    
     template <class T> static T *make(class Disk &disk) throws
     {
         return T::makeWithDisk(disk);
@@ -171,6 +222,9 @@ public:
     // Returns a fingerprint (hash value) for this file
     u64 fnv() const;
     
+    // Indicates if the file is backed by a memory mapping
+    bool isMapped() const { return mapped; }
+    
     
     //
     // Flashing data
@@ -186,10 +240,24 @@ public:
     
 protected:
 
+    /* Reads the file contents. If the stream is a memory stream owning its
+     * buffer, the buffer (or mapping) is taken over instead of being copied.
+     */
     virtual usize readFromStream(std::istream &stream) throws;
     usize readFromFile(const char *path) throws;
     usize readFromBuffer(const u8 *buf, usize len) throws;
 
+    // Replaces the file contents by a buffer allocated with new[]
+    void replaceData(u8 *buf, usize len);
+
+    // Copies a read-only mapping into memory before the data is modified
+    void makeWritable();
+
+    /* Maps a regular file read-only into memory (returns nullptr if it can't
+     * be mapped)
+     */
+    static u8 *mapFile(const string &path, usize *len);
+
 public:
     
     virtual usize writeToStream(std::ostream &stream) throws;
@@ -101,6 +101,7 @@ CRTFile::repair()
         
     // Some cartridges show a header size of 0x20 which is wrong
     if (headerSize() < 0x40) {
+        makeWritable();
         u32 newSize = 0x40;
         data[0x10] = BYTE3(newSize);
         data[0x11] = BYTE2(newSize);
@@ -118,6 +119,7 @@ CRTFile::repair()
 
             // Replace invalid CRT type $00 by $1C
             msg("Repairing broken Mikro Assembler cartridge\n");
+            makeWritable();
             data[0x17] = 0x1C;
             break;            
     }
@@ -0,0 +1,200 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+#include "CRTValidator.h"
+#include "MediaIndex.h"
+#include <algorithm>
+#include <atomic>
+
+void
+CRTValidator::scan(const string &dir, isize numThreads)
+{
+    if (!isDirectory(dir)) throw VC64Error(ERROR_FILE_NOT_FOUND);
+
+    std::vector<string> paths;
+    MediaIndex::collect(dir, paths);
+    std::sort(paths.begin(), paths.end());
+
+    // Each job grabs the next unprocessed file until all files are done
+    std::vector<Result> result(paths.size());
+    std::vector<u8> checked(paths.size());
+    std::atomic<usize> next(0);
+
+    auto job = [&]() {
+
+        for (usize i = next++; i < paths.size(); i = next++) {
+
+            // Skip all files which are neither named nor shaped like a CRT
+            if (!CRTFile::isCompatibleName(paths[i])) {
+
+                std::ifstream stream(paths[i], std::ios::binary);
+                if (!CRTFile::isCompatibleStream(stream)) continue;
+            }
+            result[i] = analyze(paths[i]);
+            checked[i] = 1;
+        }
+    };
+
+    numThreads = std::max(numThreads, (isize)1);
+    std::unique_ptr<WorkerThread[]> workers(new WorkerThread[numThreads]);
+    for (isize i = 0; i < numThreads; i++) workers[i].run(job);
+    for (isize i = 0; i < numThreads; i++) workers[i].join();
+
+    results.clear();
+    for (usize i = 0; i < paths.size(); i++) {
+        if (checked[i]) results.push_back(std::move(result[i]));
+    }
+}
+
+CRTValidator::Result
+CRTValidator::analyze(const string &path)
+{
+    Result result;
+    result.path = path;
+
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open()) {
+
+        log(result, "Cannot open file");
+        return result;
+    }
+
+    // Read the whole file with a single call
+    std::vector<u8> buf(streamLength(stream));
+    if (!stream.read((char *)buf.data(), buf.size())) {
+
+        log(result, "Cannot read file");
+        return result;
+    }
+
+    validate(result, buf.data(), buf.size());
+    return result;
+}
+
+void
+CRTValidator::validate(Result &result, const u8 *buf, usize len)
+{
+    const u8 magicBytes[] = {
+        'C','6','4',' ','C','A','R','T','R','I','D','G','E',' ',' ',' ' };
+
+    if (len < 0x40 || memcmp(buf, magicBytes, sizeof(magicBytes)) != 0) {
+
+        log(result, "No CRT signature");
+        return;
+    }
+
+    result.type = CartridgeType(LO_HI(buf[0x17], buf[0x16]));
+    result.name = PETName<16>(buf + 0x20, 0x00).str();
+    result.className = Cartridge::className(result.type);
+
+    // Header sizes below 0x40 are repaired when the file is loaded
+    usize offset = std::max(R32BE(buf + 0x10), (u32)0x40);
+    if (offset > len) {
+
+        log(result, "Header size (%lx) exceeds the file size", offset);
+        return;
+    }
+
+    for (isize nr = 0; offset < len; nr++) {
+
+        const u8 *chip = buf + offset;
+
+        if (nr == Cartridge::MAX_PACKETS) {
+
+            log(result, "More than %u chip packets", Cartridge::MAX_PACKETS);
+            return;
+        }
+        if (len - offset < 0x10) {
+
+            log(result, "Chip %ld: Truncated packet header at %lx", nr, offset);
+            return;
+        }
+        if (memcmp("CHIP", chip, 4) != 0) {
+
+            log(result, "Chip %ld: No CHIP signature at %lx", nr, offset);
+            return;
+        }
+
+        u32 length = R32BE(chip + 0x4);
+        u16 type = R16BE(chip + 0x8);
+        u16 start = R16BE(chip + 0xC);
+        u16 size = R16BE(chip + 0xE);
+
+        if (length != (u32)size + 0x10) {
+            log(result, "Chip %ld: Packet length (%x) doesn't match the chip size (%x)", nr, length, size);
+        }
+        if (type == 1) {
+            log(result, "Chip %ld: RAM chips are ignored", nr);
+        } else if (type > 2) {
+            log(result, "Chip %ld: Unknown chip type (%d)", nr, type);
+        }
+        if (start < 0x8000) {
+            log(result, "Chip %ld: Start address too low (%04X)", nr, start);
+        } else if (0x10000 - start < size) {
+            log(result, "Chip %ld: Invalid size (start: %04X size: %04X)", nr, start, size);
+        }
+        if (size > 0x4000) {
+            log(result, "Chip %ld: Chip size exceeds 16 KB (%04X)", nr, size);
+        }
+        if (len - offset - 0x10 < size) {
+
+            log(result, "Chip %ld: Chip data exceeds the end of the file", nr);
+            return;
+        }
+
+        offset += 0x10 + size;
+        result.numChips++;
+    }
+
+    if (result.numChips == 0) log(result, "No chip packets");
+}
+
+void
+CRTValidator::log(Result &result, const char *fmt, ...)
+{
+    char buf[256];
+
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+
+    result.problems.push_back(string(buf));
+}
+
+usize
+CRTValidator::numValid() const
+{
+    return std::count_if(results.begin(), results.end(),
+                         [](const Result &r) { return r.isValid(); });
+}
+
+void
+CRTValidator::writeToFile(const string &path) const
+{
+    std::ofstream out(path);
+    if (!out.is_open()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+
+    for (auto &result : results) {
+
+        out << result.isSupported() << '\t';
+        out << (long)result.type << '\t';
+        out << (result.className ? result.className : "-") << '\t';
+        out << result.numChips << '\t';
+        out << result.name << '\t';
+        out << result.path << '\n';
+
+        for (auto &problem : result.problems) {
+            out << '\t' << problem << '\n';
+        }
+    }
+
+    if (!out.good()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+}
@@ -0,0 +1,112 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Object.h"
+#include "CartridgeTypes.h"
+
+/* Checks large collections of CRT files without creating an emulator
+ * instance. Each file is read once and its header and chip packets are
+ * validated directly in the file buffer. The check reports the cartridge type,
+ * the class emulating this type (see Cartridge::className()), and all
+ * problems that would make the cartridge fail or behave differently when it
+ * is attached. Files are processed in parallel.
+ *
+ * The report is stored as a text file. Each CRT file is described by a line
+ * of tab separated values (supported flag, cartridge type, class name, number
+ * of chip packets, cartridge name, path), followed by one line for each
+ * problem. Problem lines start with a tab character.
+ */
+class CRTValidator : C64Object {
+
+public:
+
+    struct Result {
+
+        // Location of the CRT file
+        string path;
+
+        // Cartridge type and name taken from the CRT header
+        CartridgeType type = CRT_NONE;
+        string name;
+
+        // Class emulating the cartridge (nullptr if the type is unsupported)
+        const char *className = nullptr;
+
+        // Number of chip packets found in the file
+        isize numChips = 0;
+
+        // Problems found in the header or in the chip packets
+        std::vector<string> problems;
+
+        // Checks if the cartridge can be attached without problems
+        bool isSupported() const { return className != nullptr; }
+        bool isValid() const { return isSupported() && problems.empty(); }
+    };
+
+private:
+
+    // All checked files in the order of their paths
+    std::vector<Result> results;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    const char *getDescription() const override { return "CRTValidator"; }
+
+
+    //
+    // Checking
+    //
+
+public:
+
+    /* Checks all CRT files inside a directory and all its subdirectories.
+     * Files are recognized by their name or by the CRT signature.
+     */
+    void scan(const string &dir, isize numThreads) throws;
+
+    // Checks a single CRT file
+    static Result analyze(const string &path);
+
+    // Checks a CRT file that has been read into memory
+    static void validate(Result &result, const u8 *buf, usize len);
+
+private:
+
+    // Adds a problem description to a result
+    static void log(Result &result, const char *fmt, ...);
+
+
+    //
+    // Querying
+    //
+
+public:
+
+    usize count() const { return results.size(); }
+    const Result &operator[](usize nr) const { return results[nr]; }
+
+    // Returns the number of checked files that can be attached without problems
+    usize numValid() const;
+
+
+    //
+    // Saving
+    //
+
+public:
+
+    void writeToFile(const string &path) const throws;
+};
@@ -8,6 +8,7 @@
 // -----------------------------------------------------------------------------
 
 #include "C64.h"
+#include <thread>
 
 bool
 D64File::isCompatibleName(const std::string &name)
@@ -75,6 +76,116 @@ D64File::makeWithFileSystem(FSDevice &volume)
     return d64;
 }
 
+D64File *
+D64File::makeWithDisk(Disk &disk)
+{
+    // Translate the GCR stream into a byte stream (the tracks are decoded in parallel)
+    u8 buffer[D64_802_SECTORS];
+    usize len = disk.decodeDiskParallel(buffer, std::thread::hardware_concurrency());
+    
+    D64File *d64 = nullptr;
+    
+    switch (len) {
+            
+        case D64_683_SECTORS: d64 = new D64File(35, false); break;
+        case D64_768_SECTORS: d64 = new D64File(40, false); break;
+        case D64_802_SECTORS: d64 = new D64File(42, false); break;
+
+        default:
+            throw VC64Error(ERROR_FS_CORRUPTED);
+    }
+    
+    memcpy(d64->data, buffer, len);
+    return d64;
+}
+
+usize
+D64File::writeBack(Disk &disk, const char *path)
+{
+    assert(path);
+    
+    FILE *file = fopen(path, "r+b");
+    if (!file) throw VC64Error(ERROR_FILE_CANT_WRITE);
+    
+    // Determine the number of tracks stored in the file
+    fseek(file, 0, SEEK_END);
+    Track numTracks;
+    
+    switch (ftell(file)) {
+            
+        case D64_683_SECTORS: case D64_683_SECTORS_ECC: numTracks = 35; break;
+        case D64_768_SECTORS: case D64_768_SECTORS_ECC: numTracks = 40; break;
+        case D64_802_SECTORS: case D64_802_SECTORS_ECC: numTracks = 42; break;
+            
+        default:
+            fclose(file);
+            throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+    }
+    
+    // Without a journal for this file, all tracks need to be written
+    if (disk.getSyncPath() != path) disk.markDirty();
+    
+    // Modified tracks beyond the end of the file require a full export
+    for (Track t = numTracks + 1; t <= highestTrack; t++) {
+        
+        if (disk.isDirty(2 * t - 1) && !disk.trackIsEmpty(t)) {
+            fclose(file);
+            throw VC64Error(ERROR_FS_WRONG_CAPACITY);
+        }
+    }
+    
+    // Decode all modified tracks before the file is touched
+    std::vector<u8> image(D64_802_SECTORS);
+    std::vector<Track> tracks;
+    
+    for (Track t = 1; t <= numTracks; t++) {
+        
+        if (!disk.isDirty(2 * t - 1)) continue;
+        
+        for (Sector s = 0; s < Disk::numberOfSectorsInTrack(t); s++) {
+            
+            if (!disk.decodeSector(t, s, image.data() + offset(t, s))) {
+                fclose(file);
+                throw VC64Error(ERROR_FS_CORRUPTED);
+            }
+        }
+        tracks.push_back(t);
+    }
+    
+    // Write all sectors of the modified tracks
+    usize count = 0;
+    
+    for (Track t : tracks) {
+        
+        usize first = offset(t, 0);
+        usize length = Disk::numberOfSectorsInTrack(t) * 256;
+        
+        fseek(file, first, SEEK_SET);
+        if (fwrite(image.data() + first, 1, length, file) != length) {
+            fclose(file);
+            throw VC64Error(ERROR_FILE_CANT_WRITE);
+        }
+        count += length / 256;
+    }
+    
+    if (fclose(file) != 0) throw VC64Error(ERROR_FILE_CANT_WRITE);
+    
+    // A D64 file can't store anything else (e.g., halftracks)
+    disk.markClean(path);
+    disk.setModified(false);
+    
+    return count;
+}
+
+usize
+D64File::writeBack(Disk &disk, const char *path, ErrorCode *err)
+{
+    *err = ERROR_OK;
+    try { return writeBack(disk, path); }
+    catch (VC64Error &exception) { *err = exception.errorCode; }
+    return 0;
+}
+
 PETName<16>
 D64File::getName() const
 {
@@ -169,7 +280,7 @@ D64File::getErrorCode(Block b) const
 }
 
 int
-D64File::offset(Track track, Sector sector) const
+D64File::offset(Track track, Sector sector)
 {
     // secCnt[track] is the number of the first sector on track 'track'
     const unsigned secCnt[43] = {  0 /* pad */,
@@ -30,6 +30,15 @@ public:
     static bool isCompatibleName(const std::string &name);
     static bool isCompatibleStream(std::istream &stream);  
     static D64File *makeWithFileSystem(class FSDevice &volume) throws;
+    static D64File *makeWithDisk(class Disk &disk) throws;
+    
+    /* Writes the modified tracks of a disk back into an existing D64 file.
+     * The sectors of all modified tracks are written in place, the rest of
+     * the file remains untouched. The function returns the number of written
+     * sectors. It fails if the disk layout doesn't match the file.
+     */
+    static usize writeBack(class Disk &disk, const char *path) throws;
+    static usize writeBack(class Disk &disk, const char *path, ErrorCode *err);
 
 
     //
@@ -72,7 +81,7 @@ public:
 private:
     
     // Translates a track and sector number into an offset (-1 if invalid)
-    int offset(Track track, Sector sector) const;
+    static int offset(Track track, Sector sector);
     
     
     //
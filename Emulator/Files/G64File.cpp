@@ -125,6 +125,88 @@ G64File::makeWithDisk(class Disk &disk, ErrorCode *err)
     return nullptr;
 }
 
+usize
+G64File::writeBack(Disk &disk, const char *path)
+{
+    assert(path);
+    
+    FILE *file = fopen(path, "r+b");
+    if (!file) throw VC64Error(ERROR_FILE_CANT_WRITE);
+    
+    // Read the header and the track offset table
+    u8 header[12 + 84 * 4];
+    usize numBytes = fread(header, 1, sizeof(header), file);
+    isize numHalftracks = numBytes >= 12 ? MIN(header[9], 84) : 0;
+    
+    if (numBytes < 12 + 4 * (usize)numHalftracks || memcmp(header, "GCR-1541", 8)) {
+        fclose(file);
+        throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+    }
+    usize slotSize = LO_HI(header[10], header[11]);
+    
+    // Without a journal for this file, all halftracks need to be written
+    if (disk.getSyncPath() != path) disk.markDirty();
+    
+    // Check that all modified halftracks fit before the file is touched
+    u32 offsets[85] = { };
+    
+    for (Halftrack ht = 1; ht <= 84; ht++) {
+        
+        if (!disk.isDirty(ht)) continue;
+        
+        u8 *p = header + 12 + 4 * (ht - 1);
+        u32 offset = ht <= numHalftracks ? LO_LO_HI_HI(p[0], p[1], p[2], p[3]) : 0;
+        
+        // Empty halftracks without a slot stay empty
+        if (offset == 0 && disk.halftrackIsEmpty(ht)) continue;
+        
+        // Halftracks without a matching slot require a full export
+        u16 numDataBytes = disk.lengthOfHalftrack(ht) / 8;
+        if (offset == 0 || numDataBytes > slotSize || slotSize > maxBytesOnTrack) {
+            fclose(file);
+            throw VC64Error(ERROR_FS_WRONG_CAPACITY);
+        }
+        offsets[ht] = offset;
+    }
+    
+    // Write the slots (length, data, padding)
+    usize count = 0;
+    u8 buffer[2 + maxBytesOnTrack];
+    
+    for (Halftrack ht = 1; ht <= 84; ht++) {
+        
+        if (offsets[ht] == 0) continue;
+        
+        u16 numDataBytes = disk.lengthOfHalftrack(ht) / 8;
+        buffer[0] = LO_BYTE(numDataBytes);
+        buffer[1] = HI_BYTE(numDataBytes);
+        memcpy(buffer + 2, disk.data.halftrack[ht], numDataBytes);
+        memset(buffer + 2 + numDataBytes, 0xFF, slotSize - numDataBytes);
+        
+        fseek(file, offsets[ht], SEEK_SET);
+        if (fwrite(buffer, 1, 2 + slotSize, file) != 2 + slotSize) {
+            fclose(file);
+            throw VC64Error(ERROR_FILE_CANT_WRITE);
+        }
+        count++;
+    }
+    
+    if (fclose(file) != 0) throw VC64Error(ERROR_FILE_CANT_WRITE);
+    disk.markClean(path);
+    disk.setModified(false);
+    
+    return count;
+}
+
+usize
+G64File::writeBack(Disk &disk, const char *path, ErrorCode *err)
+{
+    *err = ERROR_OK;
+    try { return writeBack(disk, path); }
+    catch (VC64Error &exception) { *err = exception.errorCode; }
+    return 0;
+}
+
 usize
 G64File::getSizeOfHalftrack(Halftrack ht) const
 {
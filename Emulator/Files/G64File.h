@@ -25,6 +25,14 @@ public:
     
     static G64File *makeWithDisk(Disk &disk) throws;
     static G64File *makeWithDisk(Disk &disk, ErrorCode *err);
+    
+    /* Writes the modified halftracks of a disk back into an existing G64
+     * file. Each halftrack is written in place into its slot, the rest of the
+     * file remains untouched. The function returns the number of written
+     * halftracks. It fails if a modified halftrack has no slot in the file.
+     */
+    static usize writeBack(Disk &disk, const char *path) throws;
+    static usize writeBack(Disk &disk, const char *path, ErrorCode *err);
 
     
     //
@@ -0,0 +1,321 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+#include "MediaIndex.h"
+#include <algorithm>
+#include <atomic>
+
+// File format version
+static const char *mediaIndexMagic = "VC64INDEX 1";
+
+void
+MediaIndex::scan(const string &dir, isize numThreads)
+{
+    if (!isDirectory(dir)) throw VC64Error(ERROR_FILE_NOT_FOUND);
+
+    std::vector<string> paths;
+    collect(dir, paths);
+    std::sort(paths.begin(), paths.end());
+
+    // Each job grabs the next unprocessed file until all files are done
+    std::vector<Entry> result(paths.size());
+    std::atomic<usize> next(0);
+
+    auto job = [&]() {
+
+        for (usize i = next++; i < paths.size(); i = next++) {
+            result[i] = analyze(paths[i]);
+        }
+    };
+
+    numThreads = std::max(numThreads, (isize)1);
+    std::unique_ptr<WorkerThread[]> workers(new WorkerThread[numThreads]);
+    for (isize i = 0; i < numThreads; i++) workers[i].run(job);
+    for (isize i = 0; i < numThreads; i++) workers[i].join();
+
+    entries = std::move(result);
+    rehash();
+}
+
+FileType
+MediaIndex::detect(std::istream &stream, const string &path)
+{
+    if (Snapshot::isCompatibleStream(stream)) return FILETYPE_V64;
+    if (CRTFile::isCompatibleStream(stream)) return FILETYPE_CRT;
+    if (TAPFile::isCompatibleStream(stream)) return FILETYPE_TAP;
+    if (T64File::isCompatibleStream(stream)) return FILETYPE_T64;
+    if (P00File::isCompatibleStream(stream)) return FILETYPE_P00;
+    if (G64File::isCompatibleStream(stream)) return FILETYPE_G64;
+    if (D64File::isCompatibleStream(stream)) return FILETYPE_D64;
+    if (RomFile::isBasicRomStream(stream)) return FILETYPE_BASIC_ROM;
+    if (RomFile::isCharRomStream(stream)) return FILETYPE_CHAR_ROM;
+    if (RomFile::isKernalRomStream(stream)) return FILETYPE_KERNAL_ROM;
+    if (RomFile::isVC1541RomStream(stream)) return FILETYPE_VC1541_ROM;
+
+    // PRG files have no header and are recognized by their name
+    if (PRGFile::isCompatibleName(path) && PRGFile::isCompatibleStream(stream)) {
+        return FILETYPE_PRG;
+    }
+
+    return FILETYPE_UNKNOWN;
+}
+
+MediaIndex::Entry
+MediaIndex::analyze(const string &path)
+{
+    Entry entry;
+    entry.path = path;
+
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open()) return entry;
+
+    // Read the whole file with a single call
+    usize len = streamLength(stream);
+    u8 *buf = new u8[len];
+    if (!stream.read((char *)buf, len)) {
+
+        delete [] buf;
+        return entry;
+    }
+
+    entry.size = len;
+    entry.fnv = fnv_1a_64(buf, len);
+    entry.crc = crc32(buf, len);
+
+    MemoryStream memory(buf, len);
+    entry.type = detect(memory, path);
+
+    describe(entry, buf, len);
+    return entry;
+}
+
+void
+MediaIndex::collect(const string &dir, std::vector<string> &result)
+{
+    DIR *handle = opendir(dir.c_str());
+    if (!handle) return;
+
+    while (struct dirent *item = readdir(handle)) {
+
+        if (item->d_name[0] == '.') continue;
+
+        string path = dir + "/" + item->d_name;
+
+        struct stat info;
+        if (lstat(path.c_str(), &info) != 0) continue;
+
+        if (S_ISDIR(info.st_mode)) {
+            collect(path, result);
+        } else if (S_ISREG(info.st_mode)) {
+            result.push_back(path);
+        }
+    }
+    closedir(handle);
+}
+
+void
+MediaIndex::describe(Entry &entry, u8 *buf, usize len)
+{
+    // Adds the directory items of an archive
+    auto list = [&](AnyCollection &collection) {
+
+        entry.name = collection.collectionName().str();
+        for (unsigned i = 0; i < collection.collectionCount(); i++) {
+            entry.items.push_back(Item { collection.itemName(i).str(), collection.itemSize(i) });
+        }
+    };
+
+    /* Files are created by adopting the buffer. Hence, the contents are
+     * neither copied, nor read again. If a file can't be created, the buffer
+     * is deleted and the entry remains without a name and a listing.
+     */
+    try {
+
+        switch (entry.type) {
+
+            case FILETYPE_D64:
+            {
+                std::unique_ptr<D64File> d64(AnyFile::adopt <D64File> (buf, len));
+                std::unique_ptr<FSDevice> fs(FSDevice::makeWithD64(*d64));
+
+                fs->scanDirectory();
+                entry.name = fs->getName().str();
+                for (usize i = 0; i < fs->numFiles(); i++) {
+                    entry.items.push_back(Item { fs->fileName(i).str(), fs->fileSize(i) });
+                }
+                return;
+            }
+            case FILETYPE_T64:
+            {
+                std::unique_ptr<T64File> t64(AnyFile::adopt <T64File> (buf, len));
+                list(*t64);
+                return;
+            }
+            case FILETYPE_PRG:
+            {
+                std::unique_ptr<PRGFile> prg(AnyFile::adopt <PRGFile> (buf, len));
+                list(*prg);
+                return;
+            }
+            case FILETYPE_P00:
+            {
+                std::unique_ptr<P00File> p00(AnyFile::adopt <P00File> (buf, len));
+                list(*p00);
+                return;
+            }
+            case FILETYPE_CRT:
+            {
+                std::unique_ptr<CRTFile> crt(AnyFile::adopt <CRTFile> (buf, len));
+                entry.name = crt->getName().str();
+                return;
+            }
+            case FILETYPE_TAP:
+            {
+                std::unique_ptr<TAPFile> tap(AnyFile::adopt <TAPFile> (buf, len));
+                entry.name = tap->getName().str();
+                return;
+            }
+            case FILETYPE_BASIC_ROM:
+            case FILETYPE_CHAR_ROM:
+            case FILETYPE_KERNAL_ROM:
+            case FILETYPE_VC1541_ROM:
+
+                entry.name = RomFile::title(RomFile::identifier(entry.fnv));
+                break;
+
+            default:
+                break;
+        }
+
+    } catch (VC64Error &) {
+
+        entry.name.clear();
+        entry.items.clear();
+        return;
+    }
+
+    delete [] buf;
+}
+
+void
+MediaIndex::rehash()
+{
+    byPath.clear();
+    byFnv.clear();
+
+    for (usize i = 0; i < entries.size(); i++) {
+
+        byPath[entries[i].path] = i;
+        byFnv.emplace(entries[i].fnv, i);
+    }
+}
+
+const MediaIndex::Entry *
+MediaIndex::lookup(const string &path) const
+{
+    auto it = byPath.find(path);
+    return it != byPath.end() ? &entries[it->second] : nullptr;
+}
+
+std::vector<const MediaIndex::Entry *>
+MediaIndex::lookup(u64 fnv) const
+{
+    std::vector<const Entry *> result;
+
+    auto range = byFnv.equal_range(fnv);
+    for (auto it = range.first; it != range.second; it++) {
+        result.push_back(&entries[it->second]);
+    }
+    return result;
+}
+
+void
+MediaIndex::writeToFile(const string &path) const
+{
+    std::ofstream out(path);
+    if (!out.is_open()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+
+    out << mediaIndexMagic << '\n' << std::hex;
+
+    for (auto &entry : entries) {
+
+        out << (long)entry.type << '\t';
+        out << entry.fnv << '\t';
+        out << entry.crc << '\t';
+        out << entry.size << '\t';
+        out << entry.name << '\t';
+        out << entry.path << '\n';
+
+        for (auto &item : entry.items) {
+            out << '\t' << item.name << '\t' << item.size << '\n';
+        }
+    }
+
+    if (!out.good()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+}
+
+void
+MediaIndex::readFromFile(const string &path)
+{
+    std::ifstream in(path);
+    if (!in.is_open()) throw VC64Error(ERROR_FILE_NOT_FOUND);
+
+    string line;
+    if (!std::getline(in, line) || line != mediaIndexMagic) {
+        throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+    }
+
+    // Splits a line into tab separated fields
+    auto split = [](const string &line) {
+
+        std::vector<string> result;
+        std::stringstream fields(line);
+        for (string field; std::getline(fields, field, '\t');) result.push_back(field);
+        if (!line.empty() && line.back() == '\t') result.push_back("");
+        return result;
+    };
+    auto number = [](const string &field) {
+
+        try { return (u64)std::stoull(field, nullptr, 16); }
+        catch (...) { throw VC64Error(ERROR_FILE_TYPE_MISMATCH); }
+    };
+
+    std::vector<Entry> result;
+    while (std::getline(in, line)) {
+
+        auto fields = split(line);
+
+        if (line[0] == '\t') {
+
+            // Directory item of the previous entry
+            if (fields.size() != 3 || result.empty()) {
+                throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+            }
+            result.back().items.push_back(Item { fields[1], number(fields[2]) });
+            continue;
+        }
+
+        if (fields.size() != 6) throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+
+        Entry entry;
+        entry.type = (FileType)number(fields[0]);
+        entry.fnv = number(fields[1]);
+        entry.crc = (u32)number(fields[2]);
+        entry.size = number(fields[3]);
+        entry.name = fields[4];
+        entry.path = fields[5];
+
+        if (!FileTypeEnum::isValid(entry.type)) throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+        result.push_back(std::move(entry));
+    }
+
+    entries = std::move(result);
+    rehash();
+}
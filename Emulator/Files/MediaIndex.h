@@ -0,0 +1,130 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Object.h"
+#include "FileTypes.h"
+#include <unordered_map>
+
+/* Indexes large collections of media files. Scanning a directory tree reads
+ * each file exactly once. The file type is detected from the header, the
+ * contents are hashed, and the directory of disks and archives is listed.
+ * Files are processed in parallel. The index can be saved and loaded again,
+ * so that files can be looked up by path or fingerprint without touching the
+ * media files themselves.
+ *
+ * The index is stored as a text file. Each media file is described by a line
+ * of tab separated values (type, FNV-64 fingerprint, CRC-32, size, name,
+ * path), followed by one line for each directory item. Item lines start with
+ * a tab character and contain the item name and size.
+ */
+class MediaIndex : C64Object {
+
+public:
+
+    struct Item {
+
+        string name;
+        u64 size;
+    };
+
+    struct Entry {
+
+        // Location of the media file
+        string path;
+
+        // Detected file type (FILETYPE_UNKNOWN if the type isn't supported)
+        FileType type = FILETYPE_UNKNOWN;
+
+        // File size and checksums
+        u64 size = 0;
+        u64 fnv = 0;
+        u32 crc = 0;
+
+        // Disk name, archive name, cartridge name, tape name, or ROM title
+        string name;
+
+        // Directory listing of disks and archives
+        std::vector<Item> items;
+    };
+
+private:
+
+    // All indexed files in the order of their paths
+    std::vector<Entry> entries;
+
+    // Lookup tables
+    std::unordered_map<string, usize> byPath;
+    std::unordered_multimap<u64, usize> byFnv;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    const char *getDescription() const override { return "MediaIndex"; }
+
+
+    //
+    // Creating
+    //
+
+public:
+
+    /* Indexes all files inside a directory and all its subdirectories. Hidden
+     * files and symbolic links to directories are skipped.
+     */
+    void scan(const string &dir, isize numThreads) throws;
+
+    // Detects the type of a media file from its header
+    static FileType detect(std::istream &stream, const string &path);
+
+    // Creates the index entry for a single file
+    static Entry analyze(const string &path);
+
+    // Collects the paths of all files inside a directory tree
+    static void collect(const string &dir, std::vector<string> &result);
+
+private:
+
+    // Extracts the name and the directory listing of a media file
+    static void describe(Entry &entry, u8 *buf, usize len);
+
+    // Rebuilds the lookup tables
+    void rehash();
+
+
+    //
+    // Querying
+    //
+
+public:
+
+    usize count() const { return entries.size(); }
+    const Entry &operator[](usize nr) const { return entries[nr]; }
+
+    // Looks up a file by its path (returns nullptr if it isn't indexed)
+    const Entry *lookup(const string &path) const;
+
+    // Looks up all files with a certain fingerprint
+    std::vector<const Entry *> lookup(u64 fnv) const;
+
+
+    //
+    // Saving and loading
+    //
+
+public:
+
+    void writeToFile(const string &path) const throws;
+    void readFromFile(const string &path) throws;
+};
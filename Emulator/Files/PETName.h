@@ -81,6 +81,22 @@ public:
         return true;
     }
 
+    /* Checks if the name matches a file pattern as used by CBM DOS. A '?'
+     * matches any character and a '*' matches the rest of the name.
+     */
+    bool matches(const u8 *pattern, usize length) const
+    {
+        assert(pattern);
+        
+        for (usize i = 0; i < length; i++) {
+            
+            if (pattern[i] == '*') return true;
+            if (i >= len || pet[i] == pad) return false;
+            if (pattern[i] != '?' && pattern[i] != pet[i]) return false;
+        }
+        return length >= len || pet[length] == pad;
+    }
+    
     void write(u8 *p, usize length)
     {
         assert(p);
@@ -8,6 +8,57 @@
 // -----------------------------------------------------------------------------
 
 #include "C64.h"
+#include <sys/mman.h>
+
+/* Downscales an image into the thumbnail. The image is sampled at every
+ * second pixel of every second line. The palette is built from the colors
+ * found. Colors beyond the sixteenth are mapped to the closest palette entry.
+ */
+template <typename F> static void
+makeThumbnail(SnapshotHeader *header, isize width, isize height, F pixel)
+{
+    auto &thumb = header->thumbnail;
+    
+    auto distance = [](u32 c1, u32 c2) {
+        isize result = 0;
+        for (isize shift = 0; shift < 24; shift += 8) {
+            isize delta = (isize)((c1 >> shift) & 0xFF) - (isize)((c2 >> shift) & 0xFF);
+            result += delta * delta;
+        }
+        return result;
+    };
+    
+    thumb.width = (u16)MIN(width / 2, THUMB_WIDTH);
+    thumb.height = (u16)MIN(height / 2, THUMB_HEIGHT);
+    memset(thumb.palette, 0, sizeof(thumb.palette));
+    
+    isize colors = 0;
+    u8 *dst = thumb.pixels;
+    
+    for (isize y = 0; y < thumb.height; y++) {
+        for (isize x = 0; x < thumb.width; x++) {
+            
+            u32 color = pixel(2 * x, 2 * y);
+            
+            isize i = 0;
+            while (i < colors && thumb.palette[i] != color) i++;
+            
+            if (i == colors) {
+                
+                if (colors < 16) {
+                    thumb.palette[colors++] = color;
+                } else {
+                    i = 0;
+                    for (isize j = 1; j < 16; j++) {
+                        if (distance(thumb.palette[j], color) <
+                            distance(thumb.palette[i], color)) i = j;
+                    }
+                }
+            }
+            *dst++ = (u8)i;
+        }
+    }
+}
 
 bool
 Snapshot::isCompatibleName(const std::string &name)
@@ -21,7 +72,9 @@ Snapshot::isCompatibleStream(std::istream &stream)
     const u8 magicBytes[] = { 'V', 'C', '6', '4' };
     
     if (streamLength(stream) < 0x15) return false; 
-    return matchingStreamHeader(stream, magicBytes, sizeof(magicBytes));
+    return
+    matchingStreamHeader(stream, magicBytes, sizeof(magicBytes)) ||
+    matchingStreamHeader(stream, compressedMagic, sizeof(compressedMagic));
 }
 
 Snapshot::Snapshot(usize capacity)
@@ -29,7 +82,12 @@ Snapshot::Snapshot(usize capacity)
     size = capacity + sizeof(SnapshotHeader);
     data = new u8[size];
     
-    SnapshotHeader *header = (SnapshotHeader *)data;
+    initHeader((SnapshotHeader *)data);
+}
+
+void
+Snapshot::initHeader(SnapshotHeader *header)
+{
     header->magicBytes[0] = 'V';
     header->magicBytes[1] = 'C';
     header->magicBytes[2] = '6';
@@ -37,12 +95,20 @@ Snapshot::Snapshot(usize capacity)
     header->major = V_MAJOR;
     header->minor = V_MINOR;
     header->subminor = V_SUBMINOR;
+    header->headerVersion = SNAPSHOT_HEADER_VERSION;
     header->timestamp = time(nullptr);
 }
 
+Snapshot::~Snapshot()
+{
+    delete [] image;
+}
+
 Snapshot *
 Snapshot::makeWithC64(C64 *c64)
 {
+    SIGNPOST(SNAPSHOT);
+    
     Snapshot *snapshot;
     
     snapshot = new Snapshot(c64->size());
@@ -55,6 +121,62 @@ Snapshot::makeWithC64(C64 *c64)
     return snapshot;
 }
 
+usize
+Snapshot::readFromStream(std::istream &stream)
+{
+    AnyFile::readFromStream(stream);
+    
+    // Decompress the snapshot
+    if (size >= compressedHeaderSize &&
+        memcmp(data, compressedMagic, sizeof(compressedMagic)) == 0) {
+        
+        usize capacity = R32BE(data + 4);
+        u8 *buffer = new u8[capacity];
+        
+        if (!lz4Decompress(data + compressedHeaderSize, size - compressedHeaderSize,
+                           buffer, capacity)) {
+            delete [] buffer;
+            throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+        }
+        
+        replaceData(buffer, capacity);
+    }
+    
+    if (size < sizeof(SnapshotHeader)) throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+    
+    /* Snapshots with a full-size screenshot exceed the thumbnail width. They
+     * have been written by an older version with an incompatible layout.
+     */
+    if (header()->thumbnail.width > THUMB_WIDTH) throw VC64Error(ERROR_SNP_TOO_OLD);
+    
+    return size;
+}
+
+Snapshot *
+Snapshot::makeWithMappedFile(const string &path)
+{
+    Snapshot *snapshot = AnyFile::map <Snapshot> (path);
+    if (!snapshot->mapped) return snapshot;
+    
+    // The emulator state is read from front to back
+    auto page = (usize)sysconf(_SC_PAGESIZE);
+    usize start = sizeof(SnapshotHeader) / page * page;
+    if (start < snapshot->size) {
+        madvise(snapshot->data + start, snapshot->size - start, MADV_SEQUENTIAL);
+    }
+    
+    return snapshot;
+}
+
+Snapshot *
+Snapshot::makeWithMappedFile(const string &path, ErrorCode *err)
+{
+    *err = ERROR_OK;
+    try { return makeWithMappedFile(path); }
+    catch (VC64Error &exception) { *err = exception.errorCode; }
+    return nullptr;
+}
+
 bool
 Snapshot::isTooOld() const
 {    
@@ -72,21 +194,47 @@ Snapshot::isTooNew() const
 }
 
 void
-Snapshot::takeScreenshot(C64 *c64)
+Snapshot::takeScreenshot(SnapshotHeader *header, C64 *c64)
+{
+    isize width = VISIBLE_PIXELS;
+    isize height = c64->vic.numVisibleRasterlines();
+    isize offset = FIRST_VISIBLE_LINE * TEX_WIDTH + FIRST_VISIBLE_PIXEL;
+    
+    if (const u8 *indices = c64->vic.latestIdxTexture()) {
+        
+        // Translate the sampled color indices only
+        u32 lut[256];
+        c64->vic.getPalette(lut);
+        indices += offset;
+        makeThumbnail(header, width, height,
+                      [&](isize x, isize y) { return lut[indices[y * TEX_WIDTH + x]]; });
+        
+    } else {
+        
+        const u32 *texture = (u32 *)c64->vic.latestEmuTexture() + offset;
+        makeThumbnail(header, width, height,
+                      [&](isize x, isize y) { return texture[y * TEX_WIDTH + x]; });
+    }
+}
+
+u8 *
+Snapshot::imageData()
 {
-    SnapshotHeader *header = (SnapshotHeader *)data;
-    
-    unsigned xStart = FIRST_VISIBLE_PIXEL;
-    unsigned yStart = FIRST_VISIBLE_LINE;
-    header->screenshot.width = VISIBLE_PIXELS;
-    header->screenshot.height = c64->vic.numVisibleRasterlines();
-    
-    u32 *source = (u32 *)c64->vic.stableEmuTexture();
-    u32 *target = header->screenshot.screen;
-    source += xStart + yStart * TEX_WIDTH;
-    for (unsigned i = 0; i < header->screenshot.height; i++) {
-        memcpy(target, source, header->screenshot.width * 4);
-        target += header->screenshot.width;
-        source += TEX_WIDTH;
+    if (image == nullptr) {
+        
+        auto &thumb = header()->thumbnail;
+        isize width = imageWidth();
+        
+        // Scale the thumbnail up by a factor of two in both directions
+        image = new u32[imageWidth() * imageHeight()];
+        for (isize y = 0; y < thumb.height; y++) {
+            for (isize x = 0; x < thumb.width; x++) {
+                
+                u32 color = thumb.palette[thumb.pixels[y * thumb.width + x] & 0xF];
+                u32 *dst = image + 2 * y * width + 2 * x;
+                dst[0] = dst[1] = dst[width] = dst[width + 1] = color;
+            }
+        }
     }
+    return (u8 *)image;
 }
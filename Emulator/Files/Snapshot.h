@@ -11,6 +11,13 @@
 
 #include "AnyFile.h"
 
+// Size of the thumbnail image (a quarter of the visible screen area)
+static const long THUMB_WIDTH  = VISIBLE_PIXELS / 2;
+static const long THUMB_HEIGHT = (TEX_HEIGHT - FIRST_VISIBLE_LINE) / 2;
+
+// Layout of the snapshot header
+static const u8 SNAPSHOT_HEADER_VERSION = 2;
+
 typedef struct {
     
     // Header signature
@@ -21,22 +28,41 @@ typedef struct {
     u8 minor;
     u8 subminor;
     
-    // Thumbnail image
+    // Layout of this header (SNAPSHOT_HEADER_VERSION)
+    u8 headerVersion;
+    
+    // Thumbnail image (color indices into the palette)
     struct {
         u16 width, height;
-        u32 screen[TEX_HEIGHT * TEX_WIDTH];
+        u8 pixels[THUMB_HEIGHT * THUMB_WIDTH];
+        u32 palette[16];
         
-    } screenshot;
+    } thumbnail;
     
     // Creation date
     time_t timestamp;
 }
 SnapshotHeader;
 
+/* Snapshots are either stored as is or in compressed form. A compressed
+ * snapshot consists of a signature, the size of the uncompressed snapshot
+ * (big endian), and the uncompressed snapshot as a single LZ4 block. It is
+ * decompressed when the file is read.
+ *
+ * The header carries a thumbnail at half the width and half the height of
+ * the visible screen area. Each pixel is stored as an index into a palette
+ * of 16 colors. The full-size image is computed on request. Snapshots with
+ * the older header layout, which embeds a full-size RGBA screenshot, are
+ * rejected when the file is read (ERROR_SNP_TOO_OLD).
+ */
 class Snapshot : public AnyFile {
 
 public:
 
+    // Signature and header size of a compressed snapshot
+    static constexpr u8 compressedMagic[4] = { 'V', 'C', '6', 'Z' };
+    static constexpr usize compressedHeaderSize = 8;
+
     //
     // Class methods
     //
@@ -45,6 +71,15 @@ public:
     static bool isCompatibleStream(std::istream &stream);
      
     static Snapshot *makeWithC64(class C64 *c64);
+    
+    /* Creates a snapshot which is backed by a memory mapping of a file (see
+     * AnyFile::map()). The emulator state is deserialized directly from the
+     * mapping. Only the header is validated, so the pages holding the
+     * thumbnail and the emulator state are not read before they are needed.
+     * Compressed snapshots are decompressed into heap buffers as usual.
+     */
+    static Snapshot *makeWithMappedFile(const string &path) throws;
+    static Snapshot *makeWithMappedFile(const string &path, ErrorCode *err);
 
     
     //
@@ -53,6 +88,10 @@ public:
         
     Snapshot() { };
     Snapshot(usize capacity);
+    ~Snapshot();
+    
+    // Initializes the signature, the version number, and the creation date
+    static void initHeader(SnapshotHeader *header);
         
     
     //
@@ -67,6 +106,7 @@ public:
     //
         
     FileType type() const override { return FILETYPE_V64; }
+    usize readFromStream(std::istream &stream) throws override;
     
     
     //
@@ -83,12 +123,22 @@ public:
     
     u8 *getData() { return data + sizeof(SnapshotHeader); }
     
-    // Queries time and screenshot properties
+    // Queries time and thumbnail properties
     time_t timeStamp() const { return header()->timestamp; }
-    u8 *imageData() const { return (u8 *)(header()->screenshot.screen); }
-    usize imageWidth() const { return header()->screenshot.width; }
-    usize imageHeight() const { return header()->screenshot.height; }
+    usize thumbnailWidth() const { return header()->thumbnail.width; }
+    usize thumbnailHeight() const { return header()->thumbnail.height; }
+    
+    // Returns the thumbnail in full size as RGBA values (computed on request)
+    u8 *imageData();
+    usize imageWidth() const { return 2 * thumbnailWidth(); }
+    usize imageHeight() const { return 2 * thumbnailHeight(); }
+    
+    // Records a thumbnail of the latest frame
+    void takeScreenshot(class C64 *c64) { takeScreenshot(header(), c64); }
+    static void takeScreenshot(SnapshotHeader *header, class C64 *c64);
+    
+private:
     
-    // Records a screenshot
-    void takeScreenshot(class C64 *c64);
+    // The full-size image (allocated on request)
+    u32 *image = nullptr;
 };
@@ -255,6 +255,7 @@ T64File::repair()
             warn("T64: Changing number of items from %d to %d.\n",
                   noOfItemsStatedInHeader, noOfItems);
             
+            makeWritable();
             data[0x24] = LO_BYTE(noOfItems);
             data[0x25] = HI_BYTE(noOfItems);
             
@@ -297,6 +298,7 @@ T64File::repair()
             warn("T64: Changing end address of item %d from %04X to %04X.\n",
                  i, endAddrInMemory, fixedEndAddrInMemory);
 
+            makeWritable();
             data[n] = LO_BYTE(fixedEndAddrInMemory);
             data[n+1] = HI_BYTE(fixedEndAddrInMemory);
         }
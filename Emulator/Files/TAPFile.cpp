@@ -32,6 +32,44 @@ TAPFile::getName() const
     return PETName<16>(data + 8);
 }
 
+std::vector<u32>
+TAPFile::decodePulses() const
+{
+    std::vector<u32> result;
+    
+    u8 *p = getData();
+    usize len = getDataSize();
+    result.reserve(len);
+    
+    for (usize i = 0; i < len; i++) {
+        
+        if (p[i] != 0) {
+            
+            // Pulse lengths between 1 * 8 and 255 * 8
+            result.push_back(8 * p[i]);
+
+        } else if (version() == TAP_VERSION_ORIGINAL) {
+            
+            // Pulse lengths greater than 8 * 255 (TAP V0 files)
+            result.push_back(8 * 256);
+            
+        } else if (i + 3 < len) {
+            
+            // Pulse lengths greater than 8 * 255 (TAP V1 files)
+            result.push_back(LO_LO_HI_HI(p[i + 1], p[i + 2], p[i + 3], 0));
+            i += 3;
+            
+        } else {
+            
+            warn("TAP file ended unexpectedly (%zu, %zu)\n", len, i + 3);
+            break;
+        }
+    }
+    
+    result.shrink_to_fit();
+    return result;
+}
+
 void
 TAPFile::repair()
 {
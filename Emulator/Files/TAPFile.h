@@ -10,6 +10,7 @@
 #pragma once
 
 #include "AnyFile.h"
+#include <vector>
 
 class TAPFile : public AnyFile {
  
@@ -51,6 +52,15 @@ public:
     // Returns the size of the data area in bytes
     usize getDataSize() const { return size - 0x14; }
     
+    /* Decodes the data area into a flat array of pulse lengths measured in
+     * CPU cycles. The escape sequences of both TAP formats are resolved. In
+     * format 0, a zero byte stands for a long pulse of 256 * 8 cycles. In
+     * format 1, a zero byte is followed by the precise length in LO_LO_HI
+     * format. A truncated escape sequence at the end of the data area is
+     * ignored.
+     */
+    std::vector<u32> decodePulses() const;
+    
     
     //
     // Repairing
@@ -0,0 +1,95 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "Arena.h"
+#include "Concurrency.h"
+#include <cstring>
+#include <new>
+#include <vector>
+#include <sys/mman.h>
+
+// Released blocks along with their sizes and NUMA nodes
+struct PooledBlock { u8 *block; usize size; isize node; };
+static std::vector<PooledBlock> pool;
+static Mutex poolMutex;
+
+Arena::Arena(usize size) : capacity(size)
+{
+    node = currentNode();
+    block = acquire(capacity, node);
+}
+
+Arena::~Arena()
+{
+    release(block, capacity, node);
+}
+
+void *
+Arena::allocate(usize size)
+{
+    // The object is preceded by a header storing the block size and node
+    isize node = currentNode();
+    usize capacity = sizeOf<u8>(size) + alignment;
+    u8 *block = acquire(capacity, node);
+    
+    // Recycled blocks are cleared to match freshly mapped pages
+    memset(block, 0, capacity);
+    ((usize *)block)[0] = capacity;
+    ((isize *)block)[1] = node;
+    return block + alignment;
+}
+
+void
+Arena::deallocate(void *ptr)
+{
+    if (ptr == nullptr) return;
+    
+    u8 *block = (u8 *)ptr - alignment;
+    release(block, ((usize *)block)[0], ((isize *)block)[1]);
+}
+
+u8 *
+Arena::acquire(usize size, isize node)
+{
+    {   AutoMutex lock(poolMutex);
+        
+        for (auto it = pool.begin(); it != pool.end(); it++) {
+            
+            if (it->size == size && it->node == node) {
+                
+                u8 *result = it->block;
+                pool.erase(it);
+                return result;
+            }
+        }
+    }
+    
+    /* Map fresh pages. Unlike recycled heap memory, they are placed on the
+     * NUMA node of the thread that touches them first.
+     */
+    void *result = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (result == MAP_FAILED) throw std::bad_alloc();
+    return (u8 *)result;
+}
+
+void
+Arena::release(u8 *block, usize size, isize node)
+{
+    {   AutoMutex lock(poolMutex);
+        
+        if (pool.size() < poolSize) {
+            
+            pool.push_back(PooledBlock { block, size, node });
+            return;
+        }
+    }
+    
+    munmap(block, size);
+}
@@ -0,0 +1,76 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "Aliases.h"
+#include <cassert>
+
+/* A memory block for the large buffers of a component. All buffers are
+ * carved out of a single allocation which is made when the arena is created
+ * and released when it is destroyed. Released blocks are kept in a process
+ * wide pool and handed out again. Hence, if emulator instances are created
+ * and destroyed in quick succession, a new instance reuses the memory of a
+ * previous one instead of allocating and faulting in fresh pages. Pooled
+ * blocks are only handed out to threads on the NUMA node they were created on.
+ */
+class Arena
+{
+    // All buffers are aligned to cache line boundaries
+    static const usize alignment = 64;
+
+    // Maximum number of blocks kept in the pool
+    static const usize poolSize = 8;
+
+    u8 *block;
+    usize capacity;
+    usize used = 0;
+    
+    // NUMA node of the creating thread
+    isize node;
+
+public:
+
+    Arena(usize size);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /* Allocates or frees a single object from the pool. The functions are
+     * meant to serve the new and delete operators of large objects.
+     */
+    static void *allocate(usize size);
+    static void deallocate(void *ptr);
+
+    // Returns the number of bytes needed to hold a buffer of a certain size
+    template <class T> static constexpr usize sizeOf(usize count) {
+        return (count * sizeof(T) + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Returns the size of the memory block
+    usize getCapacity() const { return capacity; }
+
+    // Carves out an uninitialized buffer
+    template <class T> T *alloc(usize count) {
+        usize size = sizeOf<T>(count);
+        assert(used + size <= capacity);
+        T *result = (T *)(block + used);
+        used += size;
+        return result;
+    }
+
+private:
+
+    // Takes a block from the pool or allocates a new one
+    static u8 *acquire(usize size, isize node);
+
+    // Returns a block to the pool or frees it if the pool is full
+    static void release(u8 *block, usize size, isize node);
+};
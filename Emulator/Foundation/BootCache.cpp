@@ -0,0 +1,75 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "BootCache.h"
+
+std::mutex BootCache::mutex;
+std::list<std::pair<u64, std::shared_ptr<const BootCache::Entry>>> BootCache::entries;
+usize BootCache::capacity = 8;
+
+usize
+BootCache::getCapacity()
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    return capacity;
+}
+
+void
+BootCache::setCapacity(usize value)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    
+    capacity = value;
+    while (entries.size() > capacity) entries.pop_back();
+}
+
+std::shared_ptr<const BootCache::Entry>
+BootCache::lookup(u64 key)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    
+    for (auto it = entries.begin(); it != entries.end(); it++) {
+        
+        if (it->first != key) continue;
+        
+        // Move the entry to the front
+        entries.splice(entries.begin(), entries, it);
+        return entries.front().second;
+    }
+    return nullptr;
+}
+
+void
+BootCache::insert(u64 key, std::vector<u8> &&state)
+{
+    auto entry = std::make_shared<Entry>();
+    entry->state = std::move(state);
+    
+    std::lock_guard<std::mutex> guard(mutex);
+    
+    if (capacity == 0) return;
+    
+    entries.remove_if([key](auto &item) { return item.first == key; });
+    entries.emplace_front(key, std::move(entry));
+    while (entries.size() > capacity) entries.pop_back();
+}
+
+usize
+BootCache::count()
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    return entries.size();
+}
+
+void
+BootCache::clear()
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    entries.clear();
+}
@@ -0,0 +1,76 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/* Process-wide cache of booted machine states. Each entry is keyed by a
+ * fingerprint of everything the boot sequence depends on (see C64::bootKey()),
+ * i.e., the Roms, the hardware configuration, and the drive setup. Powering
+ * on an emulator instance with the boot cache enabled restores the state
+ * instead of running the Kernal's RAM test and the Basic and DOS
+ * initialization once more.
+ *
+ * Entries are immutable and don't contain any disk data. If the cache is
+ * full, the least recently used entry is dropped.
+ */
+class BootCache {
+
+public:
+
+    struct Entry {
+
+        // The emulator state (see C64::save())
+        std::vector<u8> state;
+    };
+
+private:
+
+    static std::mutex mutex;
+
+    // All entries (most recently used first)
+    static std::list<std::pair<u64, std::shared_ptr<const Entry>>> entries;
+
+    // Maximum number of entries
+    static usize capacity;
+
+
+    //
+    // Configuring
+    //
+
+public:
+
+    static usize getCapacity();
+    static void setCapacity(usize value);
+
+
+    //
+    // Accessing
+    //
+
+public:
+
+    // Returns the entry for a fingerprint (or nullptr if there is none)
+    static std::shared_ptr<const Entry> lookup(u64 key);
+
+    // Adds an entry (the state is moved into the cache)
+    static void insert(u64 key, std::vector<u8> &&state);
+
+    // Returns the number of entries
+    static usize count();
+
+    // Removes all entries
+    static void clear();
+};
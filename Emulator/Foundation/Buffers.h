@@ -10,9 +10,16 @@
 #pragma once
 
 #include "C64PublicTypes.h"
+#include <algorithm>
+#include <atomic>
 
 template <class T, usize capacity> struct RingBuffer
 {
+    /* Indicates if the capacity is a power of two. In this case, indices are
+     * wrapped around by masking instead of a (much slower) modulo operation.
+     */
+    static constexpr bool powerOfTwo = (capacity & (capacity - 1)) == 0;
+    
     // Element storage
     T elements[capacity];
 
@@ -27,7 +34,7 @@ template <class T, usize capacity> struct RingBuffer
     
     void clear() { r = w = 0; }
     void clear(T t) { for (usize i = 0; i < capacity; i++) elements[i] = t; clear(); }
-    void align(int offset) { w = (r + offset) % capacity; }
+    void align(int offset) { w = wrap(r + offset); }
 
     //
     // Serializing
@@ -45,7 +52,7 @@ template <class T, usize capacity> struct RingBuffer
     //
 
     usize cap() const { return capacity; }
-    usize count() const { return (capacity + w - r) % capacity; }
+    usize count() const { return wrap(capacity + w - r); }
     usize free() const { return capacity - count() - 1; }
     double fillLevel() const { return (double)count() / capacity; }
     bool isEmpty() const { return r == w; }
@@ -56,8 +63,10 @@ template <class T, usize capacity> struct RingBuffer
     // Working with indices
     //
 
-    static int next(int i) { return (capacity + i + 1) % capacity; }
-    static int prev(int i) { return (capacity + i - 1) % capacity; }
+    static int wrap(usize i) {
+        return powerOfTwo ? (int)(i & (capacity - 1)) : (int)(i % capacity); }
+    static int next(int i) { return wrap(capacity + i + 1); }
+    static int prev(int i) { return wrap(capacity + i - 1); }
 
     int begin() const { return r; }
     int end() const { return w; }
@@ -74,7 +83,7 @@ template <class T, usize capacity> struct RingBuffer
 
     const T& current(int offset) const
     {
-        return elements[(r + offset) % capacity];
+        return elements[wrap(r + offset)];
     }
     
     const T& read()
@@ -100,4 +109,86 @@ template <class T, usize capacity> struct RingBuffer
         w = next(w);
         elements[oldw] = element;
     }
+    
+    
+    //
+    // Reading and writing blocks of elements
+    //
+    
+    /* Returns the number of elements that can be read or written en bloc,
+     * i.e., without wrapping around the end of the element storage.
+     */
+    usize readSpan() const { return std::min(count(), capacity - r); }
+    usize writeSpan() const { return std::min(free(), capacity - w); }
+    
+    // Returns pointers to the beginning of the read and the write span
+    const T *readPtr() const { return elements + r; }
+    T *writePtr() { return elements + w; }
+    
+    // Moves the read or write pointer after a span has been processed
+    void skip(usize n) { assert(n <= count()); r = wrap(r + n); }
+    void commit(usize n) { assert(n <= free()); w = wrap(w + n); }
+    
+    // Copies n elements into a buffer
+    void read(T *buffer, usize n)
+    {
+        assert(n <= count());
+        
+        usize n1 = std::min(n, capacity - r);
+        std::copy(elements + r, elements + r + n1, buffer);
+        std::copy(elements, elements + (n - n1), buffer + n1);
+        skip(n);
+    }
+    
+    // Copies n elements from a buffer
+    void write(const T *buffer, usize n)
+    {
+        assert(n <= free());
+        
+        usize n1 = std::min(n, capacity - w);
+        std::copy(buffer, buffer + n1, elements + w);
+        std::copy(buffer + n1, buffer + n, elements);
+        commit(n);
+    }
+};
+
+/* Double buffer for handing over inspection results between threads. The
+ * writer fills the back buffer and publishes it by advancing a sequence
+ * counter. Readers copy the front buffer and retry if the writer has started
+ * to overwrite it in the meantime. Neither side ever blocks. At most one
+ * thread must write at a time.
+ */
+template <class T> class InfoRecord
+{
+    T buffer[2] = { };
+    
+    /* Sequence counter. An odd value indicates that the writer is filling the
+     * back buffer. The front buffer is buffer[(seq / 2) % 2].
+     */
+    std::atomic<u32> seq { 0 };
+    
+public:
+    
+    void publish(const T &value)
+    {
+        u32 s = seq.load(std::memory_order_relaxed);
+        
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        buffer[(s / 2 + 1) % 2] = value;
+        seq.store(s + 2, std::memory_order_release);
+    }
+    
+    T read() const
+    {
+        while (true) {
+            
+            u32 s = seq.load(std::memory_order_acquire);
+            T result = buffer[(s / 2) % 2];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            
+            // The front buffer is overwritten after the next publish
+            if (seq.load(std::memory_order_relaxed) - (s & ~1u) <= 2) return result;
+        }
+    }
 };
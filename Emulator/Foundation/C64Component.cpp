@@ -25,6 +25,8 @@ expansionport(ref.expansionport),
 iec(ref.iec),
 drive8(ref.drive8),
 drive9(ref.drive9),
+drive10(ref.drive10),
+drive11(ref.drive11),
 datasette(ref.datasette),
 messageQueue(ref.messageQueue),
 oscillator(ref.oscillator)
@@ -43,6 +45,12 @@ C64Component::resume()
     c64.resume();
 }
 
+bool
+C64Component::canModify()
+{
+    return !isRunning() || c64.isEmulatorThread();
+}
+
 void
 C64Component::prefix() const
 {
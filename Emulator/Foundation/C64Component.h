@@ -73,11 +73,13 @@ protected:
     IEC &iec;
     Drive &drive8;
     Drive &drive9;
+    Drive &drive10;
+    Drive &drive11;
     Datasette &datasette;
     MsgQueue &messageQueue;
     Oscillator &oscillator;
     
-    Drive *drive[2] = { &drive8, &drive9 };
+    Drive *drive[DRIVE_COUNT] = { &drive8, &drive9, &drive10, &drive11 };
 
 public:
 
@@ -86,5 +88,8 @@ public:
     void suspend();
     void resume();
     
+    // Checks if the calling thread may alter the component state
+    bool canModify();
+    
     void prefix() const override;
 };
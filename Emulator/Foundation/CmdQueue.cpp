@@ -0,0 +1,158 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+
+CmdQueue::~CmdQueue()
+{
+    for (auto &cmd : queue) discard(cmd);
+}
+
+bool
+CmdQueue::put(const Cmd &cmd)
+{
+    synchronized {
+        
+        if (!accepting) return false;
+        queue.push_back(cmd);
+    }
+    return true;
+}
+
+void
+CmdQueue::execute()
+{
+    std::vector<Cmd> pending;
+    bool performed = false;
+    
+    /* Take all pending commands with a single lock. Commands issued in the
+     * meantime are picked up, too, because a reset clears the action flag.
+     */
+    while (true) {
+        
+        synchronized { pending.swap(queue); }
+        if (pending.empty()) break;
+        
+        for (auto &cmd : pending) perform(cmd);
+        pending.clear();
+        performed = true;
+    }
+    
+    // Record the altered state in the input log
+    if (performed && c64.inputLog.isRecording()) c64.inputLog.requestSync();
+}
+
+void
+CmdQueue::perform(const Cmd &cmd)
+{
+    trace(RUN_DEBUG, "perform(%s)\n", CmdTypeEnum::key(cmd.type));
+    
+    switch (cmd.type) {
+            
+        case CMD_CONFIG:
+            
+            c64.configure((Option)cmd.option, cmd.value);
+            break;
+            
+        case CMD_CONFIG_ID:
+            
+            c64.configure((Option)cmd.option, cmd.id, cmd.value);
+            break;
+            
+        case CMD_RESET:
+            
+            c64.reset();
+            break;
+            
+        case CMD_ROM_INSTALL:
+            
+            c64.installRom((RomFile *)cmd.data);
+            delete (RomFile *)cmd.data;
+            break;
+            
+        case CMD_DSK_INSERT:
+            
+            if (isDriveID(cmd.id)) {
+                drive[cmd.id - DRIVE8]->insertDisk((Disk *)cmd.data);
+            } else {
+                delete (Disk *)cmd.data;
+            }
+            break;
+            
+        case CMD_DSK_EJECT:
+            
+            if (isDriveID(cmd.id)) drive[cmd.id - DRIVE8]->ejectDisk();
+            break;
+            
+        case CMD_DATASETTE_PLAY:
+            
+            datasette.pressPlay();
+            break;
+            
+        case CMD_DATASETTE_STOP:
+            
+            datasette.pressStop();
+            break;
+            
+        case CMD_DATASETTE_REWIND:
+            
+            datasette.rewind();
+            break;
+            
+        case CMD_DATASETTE_EJECT:
+            
+            datasette.ejectTape();
+            break;
+            
+        case CMD_CRT_BUTTON_PRESS:
+            
+            expansionport.pressButton((unsigned)cmd.value);
+            break;
+            
+        case CMD_CRT_BUTTON_RELEASE:
+            
+            expansionport.releaseButton((unsigned)cmd.value);
+            break;
+            
+        case CMD_CRT_SWITCH:
+            
+            expansionport.setSwitch((u8)cmd.value);
+            break;
+            
+        case CMD_CRT_ATTACH:
+            
+            expansionport.attachCartridge((Cartridge *)cmd.data);
+            if (cmd.value) c64.reset();
+            break;
+            
+        case CMD_CRT_DETACH:
+            
+            expansionport.detachCartridgeAndReset();
+            break;
+            
+        default:
+            
+            warn("Ignoring invalid command %ld\n", (long)cmd.type);
+            break;
+    }
+}
+
+void
+CmdQueue::discard(const Cmd &cmd)
+{
+    switch (cmd.type) {
+            
+        case CMD_ROM_INSTALL:   delete (RomFile *)cmd.data; break;
+        case CMD_DSK_INSERT:    delete (Disk *)cmd.data; break;
+        case CMD_CRT_ATTACH:    delete (Cartridge *)cmd.data; break;
+            
+        default:
+            break;
+    }
+}
@@ -0,0 +1,88 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Component.h"
+
+/* Commands issued by the host to change the emulator state. While the emulator
+ * is running, commands are stored in this queue and executed by the emulator
+ * thread at the end of the current rasterline (see ACTION_FLAG_COMMAND).
+ * Hence, the host can alter the emulator state without suspending the
+ * emulator thread. The queue is open while the emulator thread executes the
+ * run loop. Once it is closed, put() rejects all commands and the caller
+ * executes them directly.
+ *
+ * Pending commands are neither part of a snapshot nor affected by a reset.
+ */
+class CmdQueue : public C64Component {
+
+    // Commands waiting to be executed
+    std::vector<Cmd> queue;
+
+    // Indicates if put() accepts commands
+    bool accepting = false;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    CmdQueue(C64 &ref) : C64Component(ref) { }
+    ~CmdQueue();
+    const char *getDescription() const override { return "CmdQueue"; }
+
+private:
+
+    void _reset() override { }
+
+
+    //
+    // Serializing
+    //
+
+private:
+
+    usize _size() override { return 0; }
+    usize _objectSize() const override { return sizeof(*this); }
+    usize _load(u8 *buffer) override { return 0; }
+    usize _save(u8 *buffer) override { return 0; }
+
+
+    //
+    // Issuing commands (any thread)
+    //
+
+public:
+
+    // Stores a command and returns false if the queue is closed
+    bool put(const Cmd &cmd);
+
+    // Opens or closes the queue
+    void open() { synchronized { accepting = true; } }
+    void close() { synchronized { accepting = false; } }
+
+
+    //
+    // Executing commands
+    //
+
+public:
+
+    // Executes all pending commands (emulator thread)
+    void execute();
+
+    // Executes a single command
+    void perform(const Cmd &cmd);
+
+    // Releases the object attached to a command without executing it
+    static void discard(const Cmd &cmd);
+};
@@ -0,0 +1,66 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+// THIS FILE MUST CONFORM TO ANSI-C TO BE COMPATIBLE WITH SWIFT
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+enum_long(CMD)
+{
+    CMD_NONE = 0,
+    
+    // Emulator
+    CMD_CONFIG,
+    CMD_CONFIG_ID,
+    CMD_RESET,
+    CMD_ROM_INSTALL,
+    
+    // Floppy drives
+    CMD_DSK_INSERT,
+    CMD_DSK_EJECT,
+    
+    // Datasette
+    CMD_DATASETTE_PLAY,
+    CMD_DATASETTE_STOP,
+    CMD_DATASETTE_REWIND,
+    CMD_DATASETTE_EJECT,
+    
+    // Expansion port
+    CMD_CRT_BUTTON_PRESS,
+    CMD_CRT_BUTTON_RELEASE,
+    CMD_CRT_SWITCH,
+    CMD_CRT_ATTACH,
+    CMD_CRT_DETACH,
+    
+    CMD_COUNT
+};
+typedef CMD CmdType;
+
+/* A state change requested by the host. The meaning of the arguments depends
+ * on the command type:
+ *
+ *      CMD_CONFIG             : option, value
+ *      CMD_CONFIG_ID          : option, id, value
+ *      CMD_ROM_INSTALL        : data (RomFile *, deleted after installation)
+ *      CMD_DSK_INSERT         : id (drive), data (Disk *, owned by the drive)
+ *      CMD_DSK_EJECT          : id (drive)
+ *      CMD_CRT_BUTTON_PRESS   : value (button)
+ *      CMD_CRT_BUTTON_RELEASE : value (button)
+ *      CMD_CRT_SWITCH         : value (switch position)
+ *      CMD_CRT_ATTACH         : value (reset), data (Cartridge *, owned by the port)
+ */
+typedef struct
+{
+    CmdType type;
+    long option;
+    long id;
+    long value;
+    void *data;
+}
+Cmd;
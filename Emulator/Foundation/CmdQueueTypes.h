@@ -0,0 +1,56 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "CmdQueuePublicTypes.h"
+#include "Reflection.h"
+
+//
+// Reflection APIs
+//
+
+struct CmdTypeEnum : Reflection<CmdTypeEnum, CmdType> {
+    
+    static bool isValid(long value)
+    {
+        return (unsigned long)value < CMD_COUNT;
+    }
+
+    static const char *prefix() { return "CMD"; }
+    static const char *key(CmdType value)
+    {
+        switch (value) {
+                
+            case CMD_NONE:                return "NONE";
+                
+            case CMD_CONFIG:              return "CONFIG";
+            case CMD_CONFIG_ID:           return "CONFIG_ID";
+            case CMD_RESET:               return "RESET";
+            case CMD_ROM_INSTALL:         return "ROM_INSTALL";
+                
+            case CMD_DSK_INSERT:          return "DSK_INSERT";
+            case CMD_DSK_EJECT:           return "DSK_EJECT";
+                
+            case CMD_DATASETTE_PLAY:      return "DATASETTE_PLAY";
+            case CMD_DATASETTE_STOP:      return "DATASETTE_STOP";
+            case CMD_DATASETTE_REWIND:    return "DATASETTE_REWIND";
+            case CMD_DATASETTE_EJECT:     return "DATASETTE_EJECT";
+                
+            case CMD_CRT_BUTTON_PRESS:    return "CRT_BUTTON_PRESS";
+            case CMD_CRT_BUTTON_RELEASE:  return "CRT_BUTTON_RELEASE";
+            case CMD_CRT_SWITCH:          return "CRT_SWITCH";
+            case CMD_CRT_ATTACH:          return "CRT_ATTACH";
+            case CMD_CRT_DETACH:          return "CRT_DETACH";
+                
+            case CMD_COUNT:               return "???";
+        }
+        return "???";
+    }
+};
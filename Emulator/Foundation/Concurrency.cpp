@@ -8,6 +8,16 @@
 // -----------------------------------------------------------------------------
 
 #include "Concurrency.h"
+#include <sched.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef __APPLE__
+#include <pthread/qos.h>
+#endif
 
 Mutex::Mutex()
 {
@@ -30,3 +40,156 @@ Mutex::unlock()
 {
     return pthread_mutex_unlock(&mutex);
 }
+
+bool
+ThreadPolicy::apply() const
+{
+    bool success = true;
+    
+#ifdef __linux__
+    
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    for (isize i = 0; i < CPU_SETSIZE; i++) {
+        if (affinity == 0 || (i < 64 && (affinity & (1ULL << i)))) CPU_SET(i, &cores);
+    }
+    success &= pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores) == 0;
+    
+#endif
+    
+#ifdef __APPLE__
+    
+    // macOS doesn't support binding threads to cores. The affinity is ignored.
+    if (qos) success &= pthread_set_qos_class_self_np((qos_class_t)qos, 0) == 0;
+    
+#endif
+    
+    struct sched_param param = { };
+    
+    if (priority > 0) {
+        
+        int scheduler = roundRobin ? SCHED_RR : SCHED_FIFO;
+        int max = sched_get_priority_max(scheduler);
+        param.sched_priority = priority < max ? (int)priority : max;
+        success &= pthread_setschedparam(pthread_self(), scheduler, &param) == 0;
+        
+    } else {
+        
+#ifndef __APPLE__
+        // Return to regular time sharing (on macOS, this would drop the QoS class)
+        success &= pthread_setschedparam(pthread_self(), SCHED_OTHER, &param) == 0;
+#endif
+    }
+    
+    return success;
+}
+
+WorkerThread::WorkerThread()
+{
+    pthread_mutex_init(&mutex, nullptr);
+    pthread_cond_init(&cond, nullptr);
+}
+
+WorkerThread::~WorkerThread()
+{
+    if (launched) {
+     
+        pthread_mutex_lock(&mutex);
+        quit = true;
+        pthread_cond_broadcast(&cond);
+        pthread_mutex_unlock(&mutex);
+        pthread_join(thread, nullptr);
+    }
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mutex);
+}
+
+void
+WorkerThread::run(std::function<void()> func)
+{
+    pthread_mutex_lock(&mutex);
+
+    // Wait for the previous job to complete
+    while (pending) pthread_cond_wait(&cond, &mutex);
+    
+    job = func;
+    pending = true;
+    
+    if (!launched) {
+        launched = true;
+        pthread_create(&thread, nullptr, main, (void *)this);
+    }
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&mutex);
+}
+
+void
+WorkerThread::join()
+{
+    pthread_mutex_lock(&mutex);
+    while (pending) pthread_cond_wait(&cond, &mutex);
+    pthread_mutex_unlock(&mutex);
+}
+
+void
+WorkerThread::setPolicy(const ThreadPolicy &value)
+{
+    pthread_mutex_lock(&mutex);
+    policy = value;
+    policyChanged = true;
+    pthread_mutex_unlock(&mutex);
+}
+
+void *
+WorkerThread::main(void *worker)
+{
+    WorkerThread *w = (WorkerThread *)worker;
+    
+    pthread_mutex_lock(&w->mutex);
+    
+    while (!w->quit) {
+        
+        if (w->pending) {
+            
+            if (w->policyChanged) {
+                
+                w->policy.apply();
+                w->policyChanged = false;
+            }
+            pthread_mutex_unlock(&w->mutex);
+            w->job();
+            pthread_mutex_lock(&w->mutex);
+            
+            w->pending = false;
+            pthread_cond_broadcast(&w->cond);
+            continue;
+        }
+        pthread_cond_wait(&w->cond, &w->mutex);
+    }
+    
+    pthread_mutex_unlock(&w->mutex);
+    return nullptr;
+}
+
+void
+runWithPolicy(const ThreadPolicy &policy, std::function<void()> func)
+{
+    WorkerThread worker;
+    
+    worker.setPolicy(policy);
+    worker.run(func);
+    worker.join();
+}
+
+isize
+currentNode()
+{
+#ifdef __linux__
+    
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) return (isize)node;
+    
+#endif
+    
+    return 0;
+}
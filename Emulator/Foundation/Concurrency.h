@@ -9,7 +9,9 @@
 
 #pragma once
 
+#include "Aliases.h"
 #include <pthread.h>
+#include <functional>
 
 class Mutex
 {
@@ -35,3 +37,79 @@ public:
     AutoMutex(Mutex &ref) : mutex(ref) { mutex.lock(); }
     ~AutoMutex() { mutex.unlock(); }
 };
+
+/* Scheduling parameters of a thread. The parameters are applied on a best
+ * effort basis. Settings which are unsupported by the host or which require
+ * privileges the process doesn't have are skipped.
+ */
+struct ThreadPolicy
+{
+    // Bit mask of the cores the thread may run on (0 = all cores)
+    u64 affinity = 0;
+    
+    // Real-time priority (0 = regular time sharing)
+    long priority = 0;
+    
+    // Selects SCHED_RR instead of SCHED_FIFO for real-time priorities
+    bool roundRobin = false;
+    
+    // Quality of service class (macOS only, 0 = unspecified)
+    long qos = 0;
+    
+    /* Applies the policy to the calling thread. The function returns false
+     * if a setting couldn't be applied.
+     */
+    bool apply() const;
+};
+
+/* A helper thread executing jobs on request. The thread is launched when the
+ * first job is submitted and terminated when the object is destroyed. At most
+ * one job can be pending at a time.
+ */
+class WorkerThread
+{
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+
+    // The job to execute
+    std::function<void()> job;
+    
+    // Thread state
+    bool launched = false;
+    bool pending = false;
+    bool quit = false;
+    
+    // Scheduling parameters (applied before the next job is executed)
+    ThreadPolicy policy;
+    bool policyChanged = false;
+    
+public:
+    
+    WorkerThread();
+    ~WorkerThread();
+    
+    // Hands a job over to the worker thread and returns immediately
+    void run(std::function<void()> func);
+    
+    // Waits until the most recently submitted job has been completed
+    void join();
+
+    // Changes the scheduling parameters of the thread
+    void setPolicy(const ThreadPolicy &value);
+
+private:
+    
+    // The thread's main function
+    static void *main(void *worker);
+};
+
+/* Executes a function on a temporary thread with a certain policy and waits
+ * until it returns. On NUMA systems, memory pages are placed on the node of
+ * the thread that touches them first. Hence, objects created inside the
+ * function end up on the node of the cores selected by the policy.
+ */
+void runWithPolicy(const ThreadPolicy &policy, std::function<void()> func);
+
+// Returns the NUMA node of the calling thread (0 if unknown)
+isize currentNode();
@@ -0,0 +1,49 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct Channel { const char *name; int *value; };
+
+std::vector<Channel> &channels()
+{
+    static std::vector<Channel> list;
+    return list;
+}
+
+struct Registration {
+    
+    Registration(const char *name, int *value) { channels().push_back({ name, value }); }
+};
+
+}
+
+// Define and register all channels if they are switchable at runtime
+#define DEBUG_CHANNEL_DEFINITION(name, value) \
+int name = value; static Registration name##Registration(#name, &name)
+
+#include "C64Config.h"
+#include "Debug.h"
+
+bool
+setDebugChannel(const char *name, int value)
+{
+    for (auto &channel : channels()) {
+        
+        if (strcmp(channel.name, name) == 0) {
+            
+            *channel.value = value;
+            return true;
+        }
+    }
+    return false;
+}
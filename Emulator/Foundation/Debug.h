@@ -30,6 +30,12 @@
  * This check can't be performed when using variadic functions are utilized.
  */
 
+/* Changes the value of a debug channel, e.g., setDebugChannel("CPU_DEBUG", 1).
+ * The function returns false if the channel doesn't exist or if the channels
+ * are compile-time constants (see RUNTIME_TRACING in C64Config.h).
+ */
+bool setDebugChannel(const char *name, int value);
+
 #define msg(format, ...) \
 fprintf(stderr, format, ##__VA_ARGS__);
 
@@ -0,0 +1,300 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+
+FrameWriter::FrameWriter()
+{
+    pthread_mutex_init(&mutex, nullptr);
+    pthread_cond_init(&cond, nullptr);
+}
+
+FrameWriter::~FrameWriter()
+{
+    if (launched) {
+
+        // Let the background thread drain the queue and terminate
+        pthread_mutex_lock(&mutex);
+        quit = true;
+        pthread_cond_broadcast(&cond);
+        pthread_mutex_unlock(&mutex);
+        pthread_join(thread, nullptr);
+    }
+
+    assert(pool.size() == buffers);
+    for (usize i = 0; i < pool.size(); i++) delete pool[i];
+
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mutex);
+}
+
+ErrorCode
+FrameWriter::start(const FrameDump &value)
+{
+    if (!FrameFormatEnum::isValid(value.format)) return ERROR_OPT_INV_ARG;
+    if (!value.sink && !value.dir) return ERROR_OPT_INV_ARG;
+
+    stop();
+
+    pthread_mutex_lock(&mutex);
+
+    // The buffers grow to the frame size on first use
+    buffers = value.buffers > 0 ? (usize)value.buffers : defaultBufferCount;
+    while (pool.size() < buffers) pool.push_back(new Job());
+    while (pool.size() > buffers) { delete pool.back(); pool.pop_back(); }
+    queue.assign(buffers, nullptr);
+    head = 0;
+
+    config = value;
+    dir = value.dir ? value.dir : "";
+    config.dir = dir.c_str();
+
+    totalWritten = totalDropped = totalFailed = totalBlocked = 0;
+
+    pthread_mutex_unlock(&mutex);
+
+    return ERROR_OK;
+}
+
+void
+FrameWriter::stop()
+{
+    flush();
+    config.interval = 0;
+}
+
+bool
+FrameWriter::addFrame(u64 frame, const void *texture, const u32 *lut, isize height)
+{
+    Job *job = nullptr;
+
+    pthread_mutex_lock(&mutex);
+
+    if (pool.empty() && config.block) {
+
+        totalBlocked++;
+        while (pool.empty()) pthread_cond_wait(&cond, &mutex);
+    }
+    if (!pool.empty()) {
+
+        job = pool.back();
+        pool.pop_back();
+
+    } else {
+
+        totalDropped++;
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    if (!job) return false;
+
+    // Copy the visible area without holding the lock
+    isize offset = FIRST_VISIBLE_LINE * TEX_WIDTH + FIRST_VISIBLE_PIXEL;
+    isize bpp = lut ? 1 : 4;
+
+    job->frame = frame;
+    job->indexed = lut != nullptr;
+    job->width = VISIBLE_PIXELS;
+    job->height = height;
+    job->data.resize(VISIBLE_PIXELS * height * bpp);
+    if (lut) memcpy(job->lut, lut, sizeof(job->lut));
+
+    for (isize y = 0; y < height; y++) {
+
+        memcpy(job->data.data() + y * VISIBLE_PIXELS * bpp,
+               (const u8 *)texture + (offset + y * TEX_WIDTH) * bpp,
+               VISIBLE_PIXELS * bpp);
+    }
+
+    pthread_mutex_lock(&mutex);
+
+    queue[(head + queued++) % queue.size()] = job;
+    if (!launched) {
+
+        launched = true;
+        pthread_create(&thread, nullptr, main, (void *)this);
+    }
+    pthread_cond_broadcast(&cond);
+
+    pthread_mutex_unlock(&mutex);
+
+    return true;
+}
+
+void
+FrameWriter::flush()
+{
+    pthread_mutex_lock(&mutex);
+    while (queued || busy) pthread_cond_wait(&cond, &mutex);
+    pthread_mutex_unlock(&mutex);
+}
+
+bool
+FrameWriter::write(Job *job, std::vector<u32> &pixels, std::vector<u8> &buffer)
+{
+    isize count = job->width * job->height;
+
+    // Translate color indices
+    const u32 *rgba = (const u32 *)job->data.data();
+    if (job->indexed) {
+
+        pixels.resize(count);
+        for (isize i = 0; i < count; i++) pixels[i] = job->lut[job->data[i]];
+        rgba = pixels.data();
+    }
+
+    // Hand the frame over to the callback if one is installed
+    if (config.sink) {
+
+        config.sink(config.context, job->frame, rgba, (long)job->width, (long)job->height);
+        return true;
+    }
+
+    char name[32];
+    const char *ext = config.format == FRAME_FORMAT_PNG ? "png" : "raw";
+    snprintf(name, sizeof(name), "/frame_%08llu.%s", (unsigned long long)job->frame, ext);
+    string path = dir + name;
+
+    const u8 *data = (const u8 *)rgba;
+    usize size = count * sizeof(u32);
+    if (config.format == FRAME_FORMAT_PNG) {
+
+        encodePNG(rgba, job->width, job->height, buffer);
+        data = buffer.data();
+        size = buffer.size();
+    }
+
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    bool success = fwrite(data, 1, size, file) == size;
+    success &= fclose(file) == 0;
+
+    return success;
+}
+
+void
+FrameWriter::encodePNG(const u32 *pixels, isize width, isize height,
+                       std::vector<u8> &buffer)
+{
+    /* The image data is stored in uncompressed deflate blocks. Compressing
+     * the frames would make the writer thread the bottleneck, and the files
+     * are usually compared by a script anyway.
+     */
+    isize stride = 1 + 3 * width;
+    isize raw = stride * height;
+    isize blocks = (raw + 0xFFFE) / 0xFFFF;
+    isize idat = 2 + raw + 5 * blocks + 4;
+
+    // Create the scanlines (each line starts with filter type 0)
+    std::vector<u8> lines(raw);
+    for (isize y = 0; y < height; y++) {
+
+        u8 *q = lines.data() + y * stride;
+        *q++ = 0;
+        for (isize x = 0; x < width; x++) {
+
+            u32 color = pixels[y * width + x];
+            *q++ = (u8)color;
+            *q++ = (u8)(color >> 8);
+            *q++ = (u8)(color >> 16);
+        }
+    }
+
+    buffer.resize(8 + (12 + 13) + (12 + idat) + 12);
+    u8 *p = buffer.data();
+
+    auto chunk = [&](const char *type, isize length, std::function<void(u8 *)> fill) {
+
+        W32BE(p, (u32)length);
+        memcpy(p + 4, type, 4);
+        fill(p + 8);
+        u32 crc = crc32(p + 4, length + 4);
+        W32BE(p + 8 + length, crc);
+        p += 12 + length;
+    };
+
+    static const u8 signature[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+    memcpy(p, signature, 8);
+    p += 8;
+
+    // Header (8 bit RGB, no interlacing)
+    chunk("IHDR", 13, [&](u8 *q) {
+
+        W32BE(q, (u32)width);
+        W32BE(q + 4, (u32)height);
+        q[8] = 8; q[9] = 2; q[10] = 0; q[11] = 0; q[12] = 0;
+    });
+
+    // Image data (a zlib stream with stored blocks)
+    chunk("IDAT", idat, [&](u8 *q) {
+
+        *q++ = 0x78;
+        *q++ = 0x01;
+
+        for (isize pos = 0; pos < raw; pos += 0xFFFF) {
+
+            isize len = std::min(raw - pos, (isize)0xFFFF);
+
+            *q++ = pos + len == raw ? 1 : 0;
+            *q++ = LO_BYTE(len); *q++ = HI_BYTE(len);
+            *q++ = LO_BYTE(~len); *q++ = HI_BYTE(~len);
+            memcpy(q, lines.data() + pos, len);
+            q += len;
+        }
+
+        u32 a = 1, b = 0;
+        for (isize i = 0; i < raw; i++) {
+
+            a = (a + lines[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        W32BE(q, (b << 16) | a);
+    });
+
+    chunk("IEND", 0, [](u8 *) { });
+}
+
+void *
+FrameWriter::main(void *ptr)
+{
+    FrameWriter *writer = (FrameWriter *)ptr;
+    std::vector<u32> pixels;
+    std::vector<u8> buffer;
+
+    pthread_mutex_lock(&writer->mutex);
+
+    while (true) {
+
+        while (writer->queued == 0 && !writer->quit) {
+            pthread_cond_wait(&writer->cond, &writer->mutex);
+        }
+        if (writer->queued == 0) break;
+
+        Job *job = writer->queue[writer->head];
+        writer->head = (writer->head + 1) % writer->queue.size();
+        writer->queued--;
+        writer->busy = true;
+
+        // Write the frame without holding the lock
+        pthread_mutex_unlock(&writer->mutex);
+        bool success = writer->write(job, pixels, buffer);
+        pthread_mutex_lock(&writer->mutex);
+
+        if (success) writer->totalWritten++; else writer->totalFailed++;
+        writer->busy = false;
+        writer->pool.push_back(job);
+        pthread_cond_broadcast(&writer->cond);
+    }
+
+    pthread_mutex_unlock(&writer->mutex);
+
+    return nullptr;
+}
@@ -0,0 +1,147 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include "Concurrency.h"
+#include <pthread.h>
+#include <vector>
+
+/* Dumps selected frames to disk or hands them over to a callback without
+ * slowing down the emulator. At the end of a dumped frame, the emulator
+ * thread only copies the visible area into a pooled buffer. If the texture
+ * is drawn in indexed mode, the color indices are copied together with the
+ * palette, which is four times less data. A background thread converts the
+ * buffer to RGBA and encodes and writes it.
+ *
+ * The number of buffers is bounded. If all buffers are in use, the emulator
+ * thread either waits for the background thread or drops the frame,
+ * depending on the configured policy.
+ */
+class FrameWriter {
+
+    // Default number of frame buffers
+    static const usize defaultBufferCount = 8;
+
+    struct Job {
+
+        // The visible area, either color indices or RGBA pixels
+        std::vector<u8> data;
+        u32 lut[256];
+        bool indexed;
+        isize width;
+        isize height;
+
+        // The frame number
+        u64 frame;
+    };
+
+    // Frames waiting to be written (in order) and buffers ready for reuse
+    std::vector<Job *> queue;
+    std::vector<Job *> pool;
+    usize buffers = 0;
+    usize head = 0;
+    usize queued = 0;
+
+    // Indicates if the background thread is currently writing a frame
+    bool busy = false;
+
+    // The current configuration (only changed while the emulator is suspended)
+    FrameDump config = { };
+    string dir;
+
+    // Statistics
+    u64 totalWritten = 0;
+    u64 totalDropped = 0;
+    u64 totalFailed = 0;
+    u64 totalBlocked = 0;
+
+    // The background thread
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool launched = false;
+    bool quit = false;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    FrameWriter();
+    ~FrameWriter();
+
+
+    //
+    // Configuring
+    //
+
+public:
+
+    /* Starts or stops dumping frames. Both functions must be called while the
+     * emulator is suspended. Stopping waits until all queued frames have been
+     * written.
+     */
+    ErrorCode start(const FrameDump &config);
+    void stop();
+
+    bool isEnabled() const { return config.interval != 0; }
+
+    // Checks if a frame is dumped
+    bool selects(u64 frame) const {
+        return config.interval && frame >= config.first &&
+        (frame - config.first) % config.interval == 0;
+    }
+
+
+    //
+    // Saving (emulator thread)
+    //
+
+public:
+
+    /* Hands a frame over to the background thread. The texture is either a
+     * color index texture (lut != nullptr) or a RGBA texture. The function
+     * returns false if the frame had to be dropped.
+     */
+    bool addFrame(u64 frame, const void *texture, const u32 *lut, isize height);
+
+    // Waits until all queued frames have been written
+    void flush();
+
+
+    //
+    // Analyzing
+    //
+
+public:
+
+    // Returns the number of written, dropped, or failed frames
+    u64 written() const { return totalWritten; }
+    u64 dropped() const { return totalDropped; }
+    u64 failed() const { return totalFailed; }
+
+    // Returns how often the emulator had to wait for a free buffer
+    u64 blocked() const { return totalBlocked; }
+
+private:
+
+    // Converts a frame and writes it to disk (called by the background thread)
+    bool write(Job *job, std::vector<u32> &pixels, std::vector<u8> &buffer);
+
+    // Encodes RGBA pixels as an uncompressed PNG image
+    static void encodePNG(const u32 *pixels, isize width, isize height,
+                          std::vector<u8> &buffer);
+
+    // The thread's main function
+    static void *main(void *writer);
+};
@@ -0,0 +1,211 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+
+// Maps a hit count to a bit representing the AFL bucket it belongs to
+static const struct Buckets {
+    
+    u8 bit[256];
+    
+    Buckets() {
+        
+        bit[0] = 0; bit[1] = 1; bit[2] = 2; bit[3] = 4;
+        for (isize i = 4; i < 256; i++) {
+            bit[i] = i < 8 ? 8 : i < 16 ? 16 : i < 32 ? 32 : i < 128 ? 64 : 128;
+        }
+    }
+} buckets;
+
+ErrorCode
+Fuzzer::start(C64 &c64, const FuzzConfig &value)
+{
+    assert(!c64.isRunning());
+    
+    if (!FuzzTargetEnum::isValid(value.target)) return ERROR_OPT_INV_ARG;
+    
+    if (value.target == FUZZ_TARGET_DISK) {
+        
+        if (!isDriveID(value.drive) || !value.name) return ERROR_OPT_INV_ARG;
+        
+        Drive &drive = *c64.drives[value.drive - DRIVE8];
+        if (!drive.hasDisk()) return ERROR_FS_UNSUPPORTED;
+        
+        // Check if the disk contains a file system
+        ErrorCode err;
+        delete FSDevice::makeWithDisk(drive.disk, &err);
+        if (err != ERROR_OK) return err;
+    }
+    
+    stop(c64);
+    
+    config = value;
+    name = value.name ? value.name : "";
+    config.name = name.c_str();
+    
+    Disk *target = nullptr;
+    if (config.target == FUZZ_TARGET_DISK) {
+        
+        // Keep the disk of the base state
+        target = &c64.drives[config.drive - DRIVE8]->disk;
+        disk = std::make_unique<Disk>(c64);
+        disk->share(*target);
+    }
+    
+    // Take the base state (the drive lag isn't part of it)
+    usize offset = 0;
+    c64.synchronizeDrives();
+    state.resize(c64.size());
+    c64.prepareSave();
+    for (HardwareComponent *c : c64.components()) {
+        
+        usize size = c->_size();
+        c->saveOwnState(state.data() + offset);
+        
+        // The target disk is replaced in each run
+        if (c != target) slots.push_back(Slot { c, offset, c->stateStamp() });
+        offset += size;
+    }
+    assert(offset == state.size());
+    
+    coverage.assign(mapSize, 0);
+    seen.assign(mapSize, 0);
+    totalEdges = 0;
+    execs = nanos = restoreNanos = 0;
+    
+    c64.cpu.debugger.setCoverageMap(coverage.data());
+    return ERROR_OK;
+}
+
+void
+Fuzzer::stop(C64 &c64)
+{
+    c64.cpu.debugger.setCoverageMap(nullptr);
+    
+    state.clear();
+    slots.clear();
+    disk = nullptr;
+}
+
+FuzzResult
+Fuzzer::run(C64 &c64, const u8 *input, usize length)
+{
+    assert(isActive());
+    assert(!c64.isRunning());
+    
+    FuzzResult result = { };
+    result.exitCode = -1;
+    u64 start = Oscillator::nanos();
+    
+    restore(c64);
+    restoreNanos += Oscillator::nanos() - start;
+    
+    if (!inject(c64, input, length)) {
+        
+        // The input doesn't fit onto the disk
+        result.exit = HEADLESS_EXIT_STOP;
+        return result;
+    }
+    
+    c64.debugPort.clear();
+    memset(coverage.data(), 0, mapSize);
+    c64.cpu.debugger.setCoverageMap(coverage.data());
+    
+    result.exit = c64.runHeadless(config.budget);
+    result.exitCode = c64.debugPort.getExitCode();
+    analyze(result);
+    
+    execs++;
+    nanos += Oscillator::nanos() - start;
+    
+    return result;
+}
+
+FuzzStats
+Fuzzer::getStats() const
+{
+    FuzzStats stats = { };
+    
+    stats.execs = execs;
+    stats.nanos = nanos;
+    stats.execsPerSecond = nanos ? execs * 1000000000.0 / nanos : 0.0;
+    stats.restoreNanos = execs ? restoreNanos / execs : 0;
+    stats.totalEdges = totalEdges;
+    
+    return stats;
+}
+
+void
+Fuzzer::restore(C64 &c64)
+{
+    // Restore all components that have changed since the base state
+    for (Slot &slot : slots) {
+        
+        if (slot.component->stateStamp() == slot.stamp) continue;
+        slot.component->loadOwnState(state.data() + slot.offset);
+        slot.stamp = slot.component->stateStamp();
+    }
+    c64.drivesLag = 0;
+    c64.rescheduleEvents();
+}
+
+bool
+Fuzzer::inject(C64 &c64, const u8 *input, usize length)
+{
+    if (config.target == FUZZ_TARGET_RAM) {
+        
+        length = MIN(length, 0x10000 - config.addr);
+        memcpy(c64.mem.ram + config.addr, input, length);
+        c64.mem.markDirty(config.addr, length);
+        
+        if (config.lengthAddr) {
+            c64.mem.ram[config.lengthAddr] = LO_BYTE(length);
+            c64.mem.ram[(u16)(config.lengthAddr + 1)] = HI_BYTE(length);
+            c64.mem.markDirty(config.lengthAddr, 2);
+        }
+        return true;
+    }
+    
+    // Add the input as a file to the disk of the base state
+    ErrorCode err;
+    std::unique_ptr<FSDevice> fs(FSDevice::makeWithDisk(*disk, &err));
+    if (!fs) return false;
+    if (!fs->makeFile(PETName<16>(name), input, length)) return false;
+    
+    std::unique_ptr<Disk> modified(Disk::makeWithFileSystem(c64, *fs));
+    Drive &drive = *c64.drives[config.drive - DRIVE8];
+    drive.disk.share(*modified);
+    
+    return true;
+}
+
+void
+Fuzzer::analyze(FuzzResult &result)
+{
+    const u64 *map = (const u64 *)coverage.data();
+    
+    for (usize i = 0; i < mapSize / 8; i++) {
+        
+        // Skip eight untouched edges at once
+        if (map[i] == 0) continue;
+        
+        for (usize j = 8 * i; j < 8 * i + 8; j++) {
+            
+            u8 bit = buckets.bit[coverage[j]];
+            if (!bit) continue;
+            
+            result.edges++;
+            if (!seen[j]) { result.newEdges++; totalEdges++; }
+            if (seen[j] & bit) continue;
+            
+            seen[j] |= bit;
+            result.newCoverage = true;
+        }
+    }
+}
@@ -0,0 +1,112 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include <memory>
+#include <vector>
+
+/* Harness for coverage-guided fuzzing of code running inside the emulator.
+ * The current emulator state serves as the base state of all runs. Each run
+ * restores the base state, injects an input into RAM or into the disk of a
+ * drive, and emulates the machine until the budget is exhausted or the guest
+ * terminates via the debug port (see DebugPort).
+ *
+ * While running an input, the CPU records an AFL style edge coverage map.
+ * Each transition between two fetched instructions increments a hit counter
+ * in a 64 KB map. The hit counts are classified into the AFL buckets and
+ * compared with all previous runs to detect new coverage.
+ *
+ * The base state is restored the same way RunAhead does it, i.e., component
+ * by component without allocating memory. Components that haven't changed
+ * since the base state has been taken (see HardwareComponent::stateStamp())
+ * are skipped. In disk mode, the disk of the target drive is replaced in
+ * each run and is never restored.
+ */
+class Fuzzer {
+    
+    struct Slot {
+        
+        // The component and the location of its state inside the buffer
+        class HardwareComponent *component;
+        usize offset;
+        
+        // State stamp of the saved state
+        u64 stamp;
+    };
+    
+    // Size of the coverage map
+    static constexpr usize mapSize = 0x10000;
+    
+    // The current configuration
+    FuzzConfig config = { };
+    string name;
+    
+    // The base state and all components in serialization order
+    std::vector<u8> state;
+    std::vector<Slot> slots;
+    
+    // The disk of the target drive in the base state (disk mode only)
+    std::unique_ptr<class Disk> disk;
+    
+    // Coverage map of the latest run and the buckets hit by all runs
+    std::vector<u8> coverage;
+    std::vector<u8> seen;
+    u64 totalEdges = 0;
+    
+    // Statistics
+    u64 execs = 0;
+    u64 nanos = 0;
+    u64 restoreNanos = 0;
+    
+    
+    //
+    // Configuring
+    //
+    
+public:
+    
+    /* Takes the current emulator state as the base state of all runs. The
+     * emulator must not be running.
+     */
+    ErrorCode start(class C64 &c64, const FuzzConfig &config);
+    
+    // Removes the coverage map from the CPU and releases the base state
+    void stop(class C64 &c64);
+    
+    bool isActive() const { return !slots.empty(); }
+    
+    
+    //
+    // Running
+    //
+    
+public:
+    
+    // Runs the emulator with a single input
+    FuzzResult run(class C64 &c64, const u8 *input, usize length);
+    
+    // Returns the coverage map of the latest run
+    const u8 *getCoverage() const { return coverage.data(); }
+    
+    // Returns the statistics accumulated since start() has been called
+    FuzzStats getStats() const;
+    
+private:
+    
+    // Restores the base state
+    void restore(class C64 &c64);
+    
+    // Injects an input into RAM or into the disk of the target drive
+    bool inject(class C64 &c64, const u8 *input, usize length);
+    
+    // Classifies the coverage map and compares it with all previous runs
+    void analyze(FuzzResult &result);
+};
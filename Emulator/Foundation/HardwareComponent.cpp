@@ -9,6 +9,7 @@
 
 #include "C64.h"
 #include <algorithm>
+#include <atomic>
 
 HardwareComponent::~HardwareComponent()
 {
@@ -25,14 +26,30 @@ HardwareComponent::initialize()
     _initialize();
 }
 
+const vector<HardwareComponent *> &
+HardwareComponent::components()
+{
+    if (flatList.empty()) {
+        
+        for (HardwareComponent *c : subComponents) {
+            
+            auto &list = c->components();
+            flatList.insert(flatList.end(), list.begin(), list.end());
+        }
+        flatList.push_back(this);
+    }
+    return flatList;
+}
+
 void
 HardwareComponent::reset()
 {
-    // Reset all subcomponents
-    for (HardwareComponent *c : subComponents) c->reset();
-
-    // Reset this component
-    _reset();
+    // Reset all subcomponents first and this component last
+    for (HardwareComponent *c : components()) {
+        
+        c->_reset();
+        c->markDirty();
+    }
 }
 
 bool
@@ -48,6 +65,9 @@ HardwareComponent::configure(Option option, long value)
     // Configure this component
     result |= setConfigItem(option, value);
 
+    // The snapshot layout may have changed
+    if (result) { sizeIsCached = false; markDirty(); }
+
     return result;
 }
 
@@ -64,40 +84,119 @@ HardwareComponent::configure(Option option, long id, long value)
     // Configure this component
     result |= setConfigItem(option, id, value);
 
+    // The snapshot layout may have changed
+    if (result) { sizeIsCached = false; markDirty(); }
+
     return result;
 }
 
 usize
 HardwareComponent::size()
 {
+    if (sizeIsCached) return cachedSize;
+    
     usize result = _size();
+    bool fixed = hasFixedSize();
 
     for (HardwareComponent *c : subComponents) {
         result += c->size();
+        fixed &= c->sizeIsCached;
     }
 
+    // Remember the result if the layout is fixed for the entire subtree
+    if (fixed) { cachedSize = result; sizeIsCached = true; }
+    
     return result;
 }
 
+u64
+HardwareComponent::hash()
+{
+    u64 result = fnv_1a_init64();
+    
+    for (HardwareComponent *c : subComponents) {
+        result = fnv_1a_it64(result, c->hash());
+    }
+    return fnv_1a_it64(result, _hash());
+}
+
+void
+HardwareComponent::hash(std::vector<ComponentHash> &result)
+{
+    for (HardwareComponent *c : components()) {
+        result.push_back(ComponentHash { c->getDescription(), c->_hash() });
+    }
+}
+
+u64
+HardwareComponent::_hash()
+{
+    // Serialize the state including the data added by the delegation methods
+    std::vector<u8> buffer(_size());
+    saveOwnState(buffer.data());
+    
+    SerHasher hasher;
+    hasher.copy(buffer.data(), buffer.size());
+    return hasher.hash;
+}
+
+void
+HardwareComponent::memoryUsage(std::vector<MemoryUsage> &result)
+{
+    for (HardwareComponent *c : components()) {
+        
+        MemoryUsage usage = { c->getDescription(), c->_objectSize(), 0, 0 };
+        
+        // Don't count the subcomponents embedded into the object twice
+        const u8 *begin = (const u8 *)c;
+        const u8 *end = begin + c->_objectSize();
+        
+        for (HardwareComponent *sub : c->subComponents) {
+            
+            const u8 *ptr = (const u8 *)sub;
+            if (ptr >= begin && ptr < end) usage.objectBytes -= sub->_objectSize();
+        }
+        
+        c->_memoryUsage(usage);
+        result.push_back(usage);
+    }
+}
+
+u64
+HardwareComponent::stateStamp()
+{
+    static std::atomic<u64> counter {0};
+    
+    if (dirty || !tracksChanges()) {
+        
+        changeStamp = ++counter;
+        dirty = false;
+    }
+    return changeStamp;
+}
+
+isize
+HardwareComponent::diverges(const std::vector<ComponentHash> &hashes1,
+                            const std::vector<ComponentHash> &hashes2)
+{
+    usize count = std::min(hashes1.size(), hashes2.size());
+    
+    for (usize i = 0; i < count; i++) {
+        if (hashes1[i].hash != hashes2[i].hash) return (isize)i;
+    }
+    return hashes1.size() == hashes2.size() ? -1 : (isize)count;
+}
+
 usize
 HardwareComponent::load(u8 *buffer)
 {    
     u8 *ptr = buffer;
 
-    // Call delegation method
-    ptr += willLoadFromBuffer(ptr);
-
-    // Load internal state of all subcomponents
-    for (HardwareComponent *c : subComponents) {
-        ptr += c->load(ptr);
+    // Load the internal state of all subcomponents and this component
+    for (HardwareComponent *c : components()) {
+        ptr += c->loadOwnState(ptr);
     }
 
-    // Load internal state of this component
-    ptr += _load(ptr);
-
-    // Call delegation method
-    ptr += didLoadFromBuffer(ptr);
-
     // Verify that the number of written bytes matches the snapshot size
     trace(SNP_DEBUG, "Loaded %ld bytes (expected %zu)\n", ptr - buffer, size());
     assert(ptr - buffer == (long)size());
@@ -106,23 +205,59 @@ HardwareComponent::load(u8 *buffer)
 }
 
 usize
-HardwareComponent::save(u8 *buffer)
+HardwareComponent::loadOwnState(u8 *buffer)
 {
     u8 *ptr = buffer;
+    
+    ptr += willLoadFromBuffer(ptr);
+    ptr += _load(ptr);
+    ptr += didLoadFromBuffer(ptr);
+    markDirty();
+    
+    assert(ptr - buffer == (long)_size());
+    return ptr - buffer;
+}
 
-    // Call delegation method
+usize
+HardwareComponent::saveOwnState(u8 *buffer)
+{
+    u8 *ptr = buffer;
+    
     ptr += willSaveToBuffer(ptr);
+    ptr += _save(ptr);
+    ptr += didSaveToBuffer(ptr);
+    
+    assert(ptr - buffer == (long)_size());
+    return ptr - buffer;
+}
 
-    // Save internal state of all subcomponents
-    for (HardwareComponent *c : subComponents) {
-        ptr += c->save(ptr);
+void
+HardwareComponent::prepareSave()
+{
+    // Visit each component before its subcomponents
+    auto &list = components();
+    for (auto it = list.rbegin(); it != list.rend(); it++) {
+        
+        // Components saved one by one must not write data in this method
+        usize count = (*it)->willSaveToBuffer(nullptr);
+        assert(count == 0); (void)count;
     }
+}
 
-    // Save internal state of this component
-    ptr += _save(ptr);
+usize
+HardwareComponent::save(u8 *buffer)
+{
+    u8 *ptr = buffer;
 
-    // Call delegation method
-    ptr += didSaveToBuffer(ptr);
+    // Call the first delegation method from the top down
+    prepareSave();
+
+    // Save the internal state of all subcomponents and this component
+    for (HardwareComponent *c : components()) {
+        
+        ptr += c->_save(ptr);
+        ptr += c->didSaveToBuffer(ptr);
+    }
 
     // Verify that the number of written bytes matches the snapshot size
     trace(SNP_DEBUG, "Saved %ld bytes (expected %zu)\n", ptr - buffer, size());
@@ -202,13 +337,8 @@ HardwareComponent::pause()
 void
 HardwareComponent::inspect()
 {
-    // Inspect all subcomponents
-    for (HardwareComponent *c : subComponents) {
-        c->inspect();
-    }
-    
-    // Inspect this component
-    _inspect();
+    // Inspect all subcomponents first and this component last
+    for (HardwareComponent *c : components()) c->_inspect();
 }
 
 void
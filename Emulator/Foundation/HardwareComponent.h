@@ -13,6 +13,13 @@
 #include "Serialization.h"
 #include "Concurrency.h"
 
+// Checksum over the internal state of a single component
+struct ComponentHash {
+    
+    const char *component;
+    u64 hash;
+};
+
 /* This class defines the base functionality of all hardware components. It
  * comprises functions for initializing, configuring, and serializing the
  * emulator, as well as functions for powering up and down, running and pausing.
@@ -24,6 +31,11 @@ public:
     // Sub components
     vector<HardwareComponent *> subComponents;
     
+private:
+    
+    // This component and all of its subcomponents (see components())
+    vector<HardwareComponent *> flatList;
+    
 protected:
     
     /* State model. The virtual hardware components can be in three different
@@ -50,6 +62,21 @@ protected:
      */
     bool debugMode = false;
     
+    /* Cached result of size(). The snapshot layout of most components only
+     * depends on the configuration. Hence, the size is computed once and
+     * reused until the configuration changes. Components with a variable
+     * layout (e.g., depending on attached media) opt out via hasFixedSize().
+     */
+    usize cachedSize = 0;
+    bool sizeIsCached = false;
+    
+    /* Change tracking. Components tracking their changes set this flag in all
+     * functions altering their state (see tracksChanges()). The flag is turned
+     * into a new state stamp by stateStamp().
+     */
+    bool dirty = true;
+    u64 changeStamp = 0;
+    
     
     //
     // Initializing
@@ -68,6 +95,14 @@ public:
     void initialize();
     virtual void _initialize() { };
     
+    /* Returns this component and all of its subcomponents in the order they
+     * are serialized, i.e., each component is preceded by its subcomponents.
+     * The list is computed on the first call. Functions processing an entire
+     * subtree iterate over this list instead of recursing through the
+     * component tree. Hence, subComponents must not change afterwards.
+     */
+    const vector<HardwareComponent *> &components();
+    
     /* Resets the component and its subcomponent. It is mandatory for each
      * component to implement this function.
      */
@@ -130,6 +165,13 @@ public:
         return result;
     }
     
+    // Variant for components publishing their results in an InfoRecord
+    template<class T> T getInfo(InfoRecord<T> &record) {
+        
+        if (!isRunning()) inspect();
+        return record.read();
+    }
+    
     // Dumps debug information about the internal state to the console
     void dump() const;
     virtual void _dump() const { }
@@ -143,6 +185,9 @@ public:
     usize size();
     virtual usize _size() = 0;
     
+    // Indicates if the result of _size() only changes with the configuration
+    virtual bool hasFixedSize() const { return true; }
+    
     // Loads the internal state from a memory buffer
     usize load(u8 *buffer);
     virtual usize _load(u8 *buffer) = 0;
@@ -151,6 +196,16 @@ public:
     usize save(u8 *buffer);
     virtual usize _save(u8 *buffer) = 0;
     
+    // Variants of load() and save() excluding all subcomponents
+    usize loadOwnState(u8 *buffer);
+    usize saveOwnState(u8 *buffer);
+    
+    /* Calls willSaveToBuffer() for all components from the top down. save()
+     * calls this function itself. It must be called before the components are
+     * saved or hashed one by one in bottom-up order.
+     */
+    void prepareSave();
+    
     /* Delegation methods called inside load() or save(). Some components
      * override these methods to add custom behavior if not all elements can be
      * processed by the default implementation.
@@ -160,6 +215,62 @@ public:
     virtual usize willSaveToBuffer(u8 *buffer) {return 0; }
     virtual usize didSaveToBuffer(u8 *buffer) { return 0; }
     
+    /* Computes a checksum over the internal state without creating a
+     * snapshot. The first function covers this component and all of its
+     * subcomponents. The second function appends a separate checksum for
+     * each component in the order the components are serialized, which makes
+     * it possible to tell which component a diverging state stems from.
+     * Call prepareSave() first.
+     */
+    u64 hash();
+    void hash(std::vector<ComponentHash> &result);
+    
+    /* Computes the checksum of this component. Components serialized with
+     * the standard macros override this function with HASH_SNAPSHOT_ITEMS.
+     * The default implementation serializes the state into a scratch buffer.
+     */
+    virtual u64 _hash();
+    
+    // Returns the index of the first diverging checksum (-1 if none)
+    static isize diverges(const std::vector<ComponentHash> &hashes1,
+                          const std::vector<ComponentHash> &hashes2);
+    
+    
+    //
+    // Accounting memory
+    //
+    
+    /* Appends the memory usage of each component in the order the components
+     * are serialized. Memory owned by a component is attributed to it, even
+     * if the component is embedded into another one.
+     */
+    void memoryUsage(std::vector<MemoryUsage> &result);
+    
+    // Returns the size of the component object (overridden by all components)
+    virtual usize _objectSize() const { return sizeof(*this); }
+    
+    // Adds the memory allocated by this component
+    virtual void _memoryUsage(MemoryUsage &usage) { }
+    
+    
+    //
+    // Tracking changes
+    //
+    
+    /* Indicates if the component calls markDirty() whenever its state changes.
+     * Loading, resetting, and configuring a component marks it dirty, too.
+     * Components which don't track their changes are considered to change all
+     * the time.
+     */
+    virtual bool tracksChanges() const { return false; }
+    void markDirty() { dirty = true; }
+    
+    /* Returns a stamp identifying the current state of this component (not
+     * including its subcomponents). Stamps are unique throughout the process.
+     * Two equal stamps refer to the same component in the same state.
+     */
+    virtual u64 stateStamp();
+    
     
     //
     // Controlling
@@ -279,4 +390,10 @@ return writer.ptr - buffer;
 
     // trace(SNP_DEBUG, "Serialized to %d bytes\n", writer.ptr - buffer);
 
+#define HASH_SNAPSHOT_ITEMS \
+SerHasher hasher; \
+applyToPersistentItems(hasher); \
+applyToResetItems(hasher); \
+return hasher.hash;
+
 };
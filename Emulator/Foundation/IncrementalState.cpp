@@ -0,0 +1,230 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+#include <istream>
+#include <ostream>
+
+static void
+put64(std::ostream &stream, u64 value)
+{
+    u8 bytes[8];
+    W32BE(bytes, (u32)(value >> 32));
+    W32BE(bytes + 4, (u32)value);
+    stream.write((const char *)bytes, 8);
+}
+
+static u64
+get64(std::istream &stream)
+{
+    u8 bytes[8];
+    if (!stream.read((char *)bytes, 8)) throw VC64Error(ERROR_FILE_CANT_READ);
+    return (u64)R32BE(bytes) << 32 | R32BE(bytes + 4);
+}
+
+void
+IncrementalState::take(C64 &c64, const IncrementalState *previous, bool compress)
+{
+    auto &components = c64.components();
+
+    // The drive lag isn't part of the state
+    c64.synchronizeDrives();
+    c64.prepareSave();
+
+    bool sameLayout = previous && previous->blobs.size() == components.size();
+    std::vector<u8> buffer;
+
+    blobs.resize(components.size());
+    for (usize i = 0; i < components.size(); i++) {
+
+        HardwareComponent *c = components[i];
+        u64 stamp = c->stateStamp();
+
+        // Share the blob if the component hasn't changed
+        if (sameLayout && previous->blobs[i]->stamp == stamp) {
+
+            blobs[i] = previous->blobs[i];
+            continue;
+        }
+
+        auto blob = std::make_shared<Blob>();
+        blob->stamp = stamp;
+        blob->size = c->_size();
+
+        if (compress) {
+
+            buffer.resize(blob->size);
+            c->saveOwnState(buffer.data());
+            blob->data.resize(lz4Bound(blob->size));
+            blob->data.resize(lz4Compress(buffer.data(), blob->size, blob->data.data()));
+
+            // Keep the blob uncompressed if it doesn't shrink
+            if (blob->data.size() >= blob->size) blob->data = buffer;
+
+        } else {
+
+            blob->data.resize(blob->size);
+            c->saveOwnState(blob->data.data());
+        }
+
+        blob->data.shrink_to_fit();
+        blobs[i] = std::move(blob);
+    }
+}
+
+void
+IncrementalState::restore(C64 &c64) const
+{
+    auto &components = c64.components();
+    if (!matches(c64)) throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+
+    std::vector<u8> buffer;
+
+    for (usize i = 0; i < components.size(); i++) {
+
+        HardwareComponent *c = components[i];
+        const Blob &blob = *blobs[i];
+
+        // Skip the component if it is still in the recorded state
+        if (blob.stamp && c->stateStamp() == blob.stamp) continue;
+
+        buffer.resize(blob.size);
+        decode(blob, buffer.data());
+        c->loadOwnState(buffer.data());
+    }
+}
+
+bool
+IncrementalState::matches(C64 &c64) const
+{
+    auto &components = c64.components();
+    if (components.size() != blobs.size()) return false;
+
+    for (usize i = 0; i < blobs.size(); i++) {
+        if (blobs[i]->size != components[i]->_size()) return false;
+    }
+    return true;
+}
+
+usize
+IncrementalState::size() const
+{
+    usize result = 0;
+    for (auto &blob : blobs) result += blob->size;
+
+    return result;
+}
+
+usize
+IncrementalState::memoryUsage(const IncrementalState *previous) const
+{
+    bool sameLayout = previous && previous->blobs.size() == blobs.size();
+    usize result = 0;
+
+    for (usize i = 0; i < blobs.size(); i++) {
+
+        if (sameLayout && previous->blobs[i] == blobs[i]) continue;
+        result += blobs[i]->data.capacity();
+    }
+    return result;
+}
+
+void
+IncrementalState::flatten(u8 *buffer) const
+{
+    for (auto &blob : blobs) {
+
+        decode(*blob, buffer);
+        buffer += blob->size;
+    }
+}
+
+void
+IncrementalState::writeToStream(std::ostream &stream, const IncrementalState *previous) const
+{
+    bool sameLayout = previous && previous->blobs.size() == blobs.size();
+
+    put64(stream, blobs.size());
+    for (usize i = 0; i < blobs.size(); i++) {
+
+        // Write a reference if the blob is shared with the previous state
+        bool shared = sameLayout && previous->blobs[i] == blobs[i];
+        stream.put(shared);
+        if (shared) continue;
+
+        put64(stream, blobs[i]->size);
+        put64(stream, blobs[i]->data.size());
+        stream.write((const char *)blobs[i]->data.data(), blobs[i]->data.size());
+    }
+}
+
+void
+IncrementalState::readFromStream(std::istream &stream, const IncrementalState *previous,
+                                 C64 &c64)
+{
+    auto &components = c64.components();
+
+    usize count = get64(stream);
+    if (count != components.size()) throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+
+    bool sameLayout = previous && previous->blobs.size() == count;
+
+    std::vector<std::shared_ptr<const Blob>> result;
+    std::vector<u8> buffer;
+
+    for (usize i = 0; i < count; i++) {
+
+        int shared = stream.get();
+        if (shared == EOF) throw VC64Error(ERROR_FILE_CANT_READ);
+
+        if (shared) {
+
+            if (!sameLayout) throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+            result.push_back(previous->blobs[i]);
+            continue;
+        }
+
+        // Loaded blobs never match the state stamp of a component
+        auto blob = std::make_shared<Blob>();
+        blob->stamp = 0;
+        blob->size = get64(stream);
+        if (blob->size != components[i]->_size()) throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+
+        usize length = get64(stream);
+        if (length > lz4Bound(blob->size)) throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+
+        blob->data.resize(length);
+        if (!stream.read((char *)blob->data.data(), length)) {
+            throw VC64Error(ERROR_FILE_CANT_READ);
+        }
+
+        // Reject corrupt blobs before they are restored
+        if (length != blob->size) {
+
+            buffer.resize(blob->size);
+            decode(*blob, buffer.data());
+        }
+        result.push_back(std::move(blob));
+    }
+
+    blobs = std::move(result);
+}
+
+void
+IncrementalState::decode(const Blob &blob, u8 *buffer)
+{
+    if (blob.data.size() == blob.size) {
+
+        memcpy(buffer, blob.data.data(), blob.size);
+
+    } else if (!lz4Decompress(blob.data.data(), blob.data.size(), buffer, blob.size)) {
+
+        throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+    }
+}
@@ -0,0 +1,105 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include <memory>
+#include <vector>
+
+/* An emulator state stored as a separate blob for each component. The blobs
+ * are arranged in the order in which save() serializes the components.
+ *
+ * A state can be taken relative to a previous state. Each component whose
+ * state stamp (see HardwareComponent::stateStamp()) hasn't changed since the
+ * previous state shares the blob of that state instead of being serialized
+ * again. In a series of states, large components that rarely change (e.g.,
+ * disks or the memory of an idle drive) are therefore stored only once.
+ * Restoring a state skips all components which are still in the stored state.
+ */
+class IncrementalState {
+
+    struct Blob {
+
+        // State stamp of the component (0 = unknown)
+        u64 stamp;
+
+        // Size of the serialized state
+        usize size;
+
+        // Serialized state (LZ4 compressed if it differs in size)
+        std::vector<u8> data;
+    };
+
+    std::vector<std::shared_ptr<const Blob>> blobs;
+
+
+    //
+    // Taking and restoring
+    //
+
+public:
+
+    /* Records the current emulator state. Unchanged components share their
+     * blobs with the previous state (if provided). New blobs are compressed
+     * if requested.
+     */
+    void take(class C64 &c64, const IncrementalState *previous, bool compress);
+
+    /* Restores the recorded state (the emulator must not be running). The
+     * state is rejected without loading any component if it doesn't match the
+     * snapshot layout of the emulator.
+     */
+    void restore(class C64 &c64) const throws;
+
+    // Checks if the blobs match the snapshot layout of all components
+    bool matches(class C64 &c64) const;
+
+    // Checks if a state has been recorded
+    bool isEmpty() const { return blobs.empty(); }
+
+
+    //
+    // Analyzing
+    //
+
+public:
+
+    // Returns the size of the state in snapshot format
+    usize size() const;
+
+    /* Returns the amount of memory occupied by all blobs. If a previous state
+     * is provided, only the blobs not shared with this state are counted.
+     */
+    usize memoryUsage(const IncrementalState *previous = nullptr) const;
+
+
+    //
+    // Serializing
+    //
+
+public:
+
+    // Writes the state in the snapshot format created by C64::save()
+    void flatten(u8 *buffer) const;
+
+    /* Writes the state into a stream. Blobs shared with the previous state are
+     * written as references. When reading, each blob is checked against the
+     * snapshot layout of the emulator and compressed blobs are verified to
+     * decompress properly.
+     */
+    void writeToStream(std::ostream &stream, const IncrementalState *previous) const;
+    void readFromStream(std::istream &stream, const IncrementalState *previous,
+                        class C64 &c64) throws;
+
+private:
+
+    // Restores a blob into a buffer
+    static void decode(const Blob &blob, u8 *buffer) throws;
+};
@@ -0,0 +1,359 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+#include <fstream>
+
+// File format version
+static const u8 inputLogVersion = 3;
+
+static void
+putLEB128(std::ostream &out, u64 value)
+{
+    while (value >= 0x80) {
+        out.put((char)(value | 0x80));
+        value >>= 7;
+    }
+    out.put((char)value);
+}
+
+static u64
+getLEB128(std::istream &in)
+{
+    u64 result = 0;
+    for (isize shift = 0; shift < 64; shift += 7) {
+        int byte = in.get();
+        if (byte == EOF) throw VC64Error(ERROR_FILE_CANT_READ);
+        result |= (u64)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return result;
+    }
+    throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+}
+
+// Signed values are stored in zigzag encoding
+static void putSigned(std::ostream &out, i64 value)
+{
+    putLEB128(out, ((u64)value << 1) ^ (u64)(value >> 63));
+}
+
+static i64 getSigned(std::istream &in)
+{
+    u64 value = getLEB128(in);
+    return (i64)(value >> 1) ^ -(i64)(value & 1);
+}
+
+usize
+InputLog::memoryUsage() const
+{
+    usize result = events.capacity() * sizeof(InputEvent);
+    for (usize i = 0; i < states.size(); i++) {
+        result += states[i].image.memoryUsage(i ? &states[i - 1].image : nullptr);
+    }
+
+    return result;
+}
+
+void
+InputLog::startRecording(C64 &c64, isize checkpointInterval)
+{
+    assert(!c64.isRunning());
+    assert(checkpointInterval > 0);
+
+    events.clear();
+    states.clear();
+    this->checkpointInterval = checkpointInterval;
+    syncRequested = false;
+    pendingSync = -1;
+    lastFrame = 0;
+    lastCycle = 0;
+
+    addState(c64, false);
+    mode = Mode::recording;
+}
+
+void
+InputLog::stopRecording(C64 &c64)
+{
+    assert(!c64.isRunning());
+
+    if (!isRecording()) return;
+
+    lastFrame = c64.frame;
+    lastCycle = c64.cpu.cycle;
+    mode = Mode::idle;
+}
+
+void
+InputLog::record(const InputEvent &event, Cycle cycle)
+{
+    assert(events.empty() || events.back().cycle <= cycle);
+
+    events.push_back(event);
+    events.back().cycle = cycle;
+}
+
+void
+InputLog::record(InputEventType type, long data, Cycle cycle)
+{
+    record(InputEvent { cycle, type, PORT_ONE, data, 0, 0 }, cycle);
+}
+
+void
+InputLog::sync(C64 &c64)
+{
+    if (!isRecording()) return;
+
+    // Nothing has been emulated since the last sync point. Replace it.
+    State &last = states.back();
+    if (!last.checkpoint && last.cycle == (Cycle)c64.cpu.cycle) {
+
+        states.pop_back();
+        addState(c64, false);
+        return;
+    }
+
+    record(INPUT_EVENT_SYNC, (long)states.size(), c64.cpu.cycle);
+    addState(c64, false);
+}
+
+void
+InputLog::startReplay(C64 &c64)
+{
+    assert(!c64.isRunning());
+
+    if (states.empty()) return;
+
+    // Auto-typing must not interfere with the recorded key events
+    c64.keyboard.abortAutoTyping();
+
+    if (!restore(c64, states.front())) return;
+    c64.inputs.clear();
+    next = states.front().event;
+    pendingSync = -1;
+    mode = Mode::replaying;
+    c64.rescheduleEvents();
+}
+
+void
+InputLog::seek(C64 &c64, u64 frame)
+{
+    assert(!c64.isRunning());
+
+    if (states.empty()) return;
+
+    // Find the latest state in front of the target frame
+    usize nr = 0;
+    for (usize i = 1; i < states.size() && states[i].frame < frame; i++) nr = i;
+
+    c64.keyboard.abortAutoTyping();
+
+    if (!restore(c64, states[nr])) return;
+    c64.inputs.clear();
+    next = states[nr].event;
+    pendingSync = -1;
+    mode = Mode::replaying;
+    c64.rescheduleEvents();
+
+    // Emulate the remaining frames
+    if (frame > c64.frame) {
+
+        HeadlessBudget budget = { };
+        budget.frames = frame - c64.frame;
+        c64.runHeadless(budget);
+    }
+}
+
+void
+InputLog::scheduleSync(C64 &c64, isize nr)
+{
+    if (!isReplaying() || nr < 0 || nr >= (isize)states.size()) return;
+
+    pendingSync = nr;
+    c64.signalInputSync();
+}
+
+void
+InputLog::performSync(C64 &c64)
+{
+    if (pendingSync < 0) return;
+
+    restore(c64, states[pendingSync]);
+    pendingSync = -1;
+}
+
+void
+InputLog::endFrame(C64 &c64)
+{
+    switch (mode) {
+
+        case Mode::recording:
+
+            if (syncRequested) {
+
+                syncRequested = false;
+                sync(c64);
+            }
+            if ((c64.frame - firstFrame()) % checkpointInterval == 0) {
+                addState(c64, true);
+            }
+            break;
+
+        case Mode::replaying:
+
+            // Stop once all events have been performed
+            if (next == events.size() && c64.frame >= lastFrame) {
+                mode = Mode::idle;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void
+InputLog::addState(C64 &c64, bool checkpoint)
+{
+    State state;
+    state.frame = c64.frame;
+    state.cycle = c64.cpu.cycle;
+    state.event = events.size();
+    state.checkpoint = checkpoint;
+    state.image.take(c64, states.empty() ? nullptr : &states.back().image, true);
+
+    states.push_back(std::move(state));
+}
+
+bool
+InputLog::restore(C64 &c64, const State &state)
+{
+    // Component sizes may have changed by reconfiguring the emulator
+    if (!state.image.matches(c64)) {
+
+        warn("InputLog: Recorded state doesn't match the configuration\n");
+        mode = Mode::idle;
+        return false;
+    }
+
+    /* The state is loaded directly instead of via loadFromSnapshot(), because
+     * the latter releases all keys which would alter the recorded state.
+     */
+    state.image.restore(c64);
+    c64.drivesLag = 0;
+    c64.rescheduleEvents();
+    return true;
+}
+
+void
+InputLog::execute(C64 &c64, Cycle cycle)
+{
+    while (next < events.size() && events[next].cycle <= cycle) {
+        c64.inputs.perform(events[next++]);
+    }
+}
+
+void
+InputLog::writeToFile(const string &path)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+
+    out.write("VC64ILOG", 8);
+    out.put((char)inputLogVersion);
+
+    putLEB128(out, lastFrame);
+    putLEB128(out, (u64)lastCycle);
+    putLEB128(out, (u64)checkpointInterval);
+    putLEB128(out, events.size());
+    putLEB128(out, states.size());
+
+    // Events are stored with the cycle delta to the previous event
+    Cycle cycle = 0;
+    for (auto &event : events) {
+
+        putLEB128(out, (u64)(event.cycle - cycle));
+        putLEB128(out, (u64)event.type);
+        putLEB128(out, (u64)event.port);
+        putSigned(out, event.data);
+        putSigned(out, event.x);
+        putSigned(out, event.y);
+        cycle = event.cycle;
+    }
+
+    for (usize i = 0; i < states.size(); i++) {
+
+        const State &state = states[i];
+        putLEB128(out, state.frame);
+        putLEB128(out, (u64)state.cycle);
+        putLEB128(out, state.event);
+        putLEB128(out, state.checkpoint);
+        state.image.writeToStream(out, i ? &states[i - 1].image : nullptr);
+    }
+
+    if (!out.good()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+}
+
+void
+InputLog::readFromFile(C64 &c64, const string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) throw VC64Error(ERROR_FILE_NOT_FOUND);
+
+    char magic[9] = { };
+    in.read(magic, 8);
+    if (strcmp(magic, "VC64ILOG") != 0) throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+    if (in.get() != inputLogVersion) throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+
+    InputLog log;
+    log.lastFrame = getLEB128(in);
+    log.lastCycle = (Cycle)getLEB128(in);
+    log.checkpointInterval = (isize)getLEB128(in);
+    usize numEvents = getLEB128(in);
+    usize numStates = getLEB128(in);
+
+    if (log.checkpointInterval <= 0 || numStates == 0) {
+        throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+    }
+
+    Cycle cycle = 0;
+    for (usize i = 0; i < numEvents; i++) {
+
+        InputEvent event;
+        Cycle delta = (Cycle)getLEB128(in);
+        event.cycle = cycle += delta;
+        event.type = (InputEventType)getLEB128(in);
+        event.port = (PortId)getLEB128(in);
+        event.data = (long)getSigned(in);
+        event.x = (long)getSigned(in);
+        event.y = (long)getSigned(in);
+
+        // Reject corrupt events before they reach the emulator
+        if (delta < 0 || !InputQueue::isValid(event)) {
+            throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+        }
+        log.events.push_back(event);
+    }
+
+    for (usize i = 0; i < numStates; i++) {
+
+        State state;
+        state.frame = getLEB128(in);
+        state.cycle = (Cycle)getLEB128(in);
+        state.event = getLEB128(in);
+        state.checkpoint = getLEB128(in);
+        state.image.readFromStream(in, i ? &log.states[i - 1].image : nullptr, c64);
+
+        if (state.event > numEvents) throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+        log.states.push_back(std::move(state));
+    }
+
+    if (!in.good()) throw VC64Error(ERROR_FILE_CANT_READ);
+
+    *this = std::move(log);
+}
@@ -0,0 +1,191 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include "IncrementalState.h"
+#include <vector>
+
+/* Records a session as an initial emulator state and a log of all inputs,
+ * which takes much less space than recording snapshots at regular intervals.
+ * Replaying the log reproduces the session cycle by cycle.
+ *
+ * The log contains all events performed by the input queue (see InputQueue),
+ * all keyboard, joystick, and mouse events issued by the host, all keys
+ * pressed and released by auto-typing, and all warp mode changes. While
+ * recording, Keyboard::press(), Joystick::trigger(), and friends hand their
+ * events over to the input queue, which makes them take effect in a well
+ * defined cycle. Warp mode changes are recorded by the emulator thread
+ * directly.
+ *
+ * During replay, the recorded events are performed by the log itself on the
+ * emulator thread. They don't pass the input queue which only takes events
+ * from the host. Host input is dropped while replaying.
+ *
+ * Changes the host applies while the emulator is suspended (inserting disks,
+ * attaching cartridges, pressing cartridge buttons, etc.) can't be expressed
+ * as events. Instead, the emulator state is recorded each time the emulator
+ * starts running again and after each disk change step. These states are
+ * restored by INPUT_EVENT_SYNC events during replay. Headless clients, which
+ * never start the run loop, call sync() themselves after such a change.
+ *
+ * In addition, a checkpoint is recorded at regular frame intervals. Seeking
+ * restores the latest state in front of the target frame and emulates the
+ * remaining frames at full speed. All states are stored compressed and
+ * incrementally (see IncrementalState).
+ */
+class InputLog {
+
+    struct State {
+
+        // Frame and cycle the state was recorded in
+        u64 frame;
+        Cycle cycle;
+
+        // Number of events recorded before this state
+        usize event;
+
+        // Indicates if the state is a checkpoint (and not a sync point)
+        bool checkpoint;
+
+        // The emulator state (sharing unchanged components with its predecessor)
+        IncrementalState image;
+    };
+
+    enum class Mode { idle, recording, replaying };
+    Mode mode = Mode::idle;
+
+    // The recorded events and states (the first state is the initial state)
+    std::vector<InputEvent> events;
+    std::vector<State> states;
+
+    // Number of frames between two checkpoints
+    isize checkpointInterval = 250;
+
+    // Frame and cycle in which the recording ended
+    u64 lastFrame = 0;
+    Cycle lastCycle = 0;
+
+    // Indicates if a state is to be recorded at the end of the frame
+    bool syncRequested = false;
+
+    // Next event to be performed (replay)
+    usize next = 0;
+
+    // State to be restored by the next sync (replay)
+    isize pendingSync = -1;
+
+
+    //
+    // Querying
+    //
+
+public:
+
+    bool isRecording() const { return mode == Mode::recording; }
+    bool isReplaying() const { return mode == Mode::replaying; }
+
+    // Returns the number of recorded events and states
+    usize numEvents() const { return events.size(); }
+    usize numStates() const { return states.size(); }
+
+    // Returns the first and the last frame of the recording
+    u64 firstFrame() const { return states.empty() ? 0 : states.front().frame; }
+    u64 finalFrame() const { return lastFrame; }
+
+    // Returns the amount of memory occupied by the log
+    usize memoryUsage() const;
+
+
+    //
+    // Recording (emulator must not be running)
+    //
+
+public:
+
+    // Starts a recording with the current emulator state
+    void startRecording(class C64 &c64, isize checkpointInterval = 250);
+
+    // Stops the recording
+    void stopRecording(class C64 &c64);
+
+    // Records an event that has taken effect in the specified cycle
+    void record(const InputEvent &event, Cycle cycle);
+    void record(InputEventType type, long data, Cycle cycle);
+
+    // Records the current emulator state as a sync point
+    void sync(class C64 &c64);
+
+    // Requests a sync point at the end of the current frame
+    void requestSync() { syncRequested = true; }
+
+
+    //
+    // Replaying (emulator must not be running)
+    //
+
+public:
+
+    // Starts replaying the log from the initial state
+    void startReplay(class C64 &c64);
+
+    // Stops replaying the log
+    void stopReplay() { mode = Mode::idle; }
+
+    /* Moves the replay to the specified frame. The latest state in front of
+     * the frame is restored and the remaining frames are emulated.
+     */
+    void seek(class C64 &c64, u64 frame);
+
+    // Schedules a sync point to be restored (called by the input queue)
+    void scheduleSync(class C64 &c64, isize nr);
+
+    // Restores the scheduled sync point (called by the run loop)
+    void performSync(class C64 &c64);
+
+
+    //
+    // Running (emulator thread)
+    //
+
+public:
+
+    // Returns the cycle of the next event to be replayed (INT64_MAX if none)
+    Cycle nextCycle() const
+    {
+        return isReplaying() && next < events.size() ? events[next].cycle : INT64_MAX;
+    }
+
+    // Performs all recorded events that are due in the specified cycle
+    void execute(class C64 &c64, Cycle cycle);
+
+    // Records a checkpoint or ends the replay at the end of a frame
+    void endFrame(class C64 &c64);
+
+
+    //
+    // Saving and loading
+    //
+
+public:
+
+    void writeToFile(const string &path) throws;
+
+    // Reads a log which must match the snapshot layout of the emulator
+    void readFromFile(class C64 &c64, const string &path) throws;
+
+private:
+
+    // Records the current emulator state
+    void addState(class C64 &c64, bool checkpoint);
+
+    // Restores a recorded state (ends the replay if the state doesn't fit)
+    bool restore(class C64 &c64, const State &state);
+};
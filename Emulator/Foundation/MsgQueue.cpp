@@ -9,6 +9,17 @@
 
 #include "MsgQueue.h"
 #include "C64Types.h"
+#include <unistd.h>
+
+MsgQueue::MsgQueue()
+{
+    for (usize i = 0; i < capacity; i++) slots[i].seq = i;
+}
+
+MsgQueue::~MsgQueue()
+{
+    stopDispatcher();
+}
 
 void
 MsgQueue::addListener(const void *listener, Callback *func)
@@ -18,6 +29,7 @@ MsgQueue::addListener(const void *listener, Callback *func)
     }
     
     // Distribute all pending messages
+    dispatch();
     Message msg;
     while ((msg = get()).type != MSG_NONE) {
         propagate(msg);
@@ -31,6 +43,9 @@ MsgQueue::removeListener(const void *listener)
 {
     put(MSG_UNREGISTER);
     
+    // Make sure the listener receives all messages issued so far
+    if (delivery != Delivery::sync) dispatch();
+    
     synchronized {
         
         for (auto it = listeners.begin(); it != listeners.end(); it++) {
@@ -58,10 +73,35 @@ MsgQueue::get()
  
 void
 MsgQueue::put(MsgType type, long data)
+{
+    Message msg = { type, data };
+    
+    if (delivery == Delivery::sync) {
+        
+        deliver(msg);
+        
+    } else if (enqueue(msg)) {
+        
+        /* If the mode has been switched to synchronous delivery in the
+         * meantime, setDelivery() may have drained the ring buffer before the
+         * message arrived. Hence, the message is delivered here.
+         */
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (delivery == Delivery::sync) dispatch();
+        
+    } else {
+
+        lost++;
+        debug(QUEUE_DEBUG, "Lost %s\n", MsgTypeEnum::key(type));
+    }
+}
+
+void
+MsgQueue::deliver(const Message &msg)
 {
     synchronized {
                         
-        debug (QUEUE_DEBUG, "%s [%ld]\n", MsgTypeEnum::key(type), data);
+        debug (QUEUE_DEBUG, "%s [%ld]\n", MsgTypeEnum::key(msg.type), msg.data);
         
         // Delete the oldest message if the queue overflows
         if (queue.isFull()) {
@@ -70,7 +110,6 @@ MsgQueue::put(MsgType type, long data)
         }
     
         // Write data
-        Message msg = { type, data };
         queue.write(msg);
         
         // Serve registered callbacks
@@ -78,6 +117,113 @@ MsgQueue::put(MsgType type, long data)
     }
 }
 
+bool
+MsgQueue::enqueue(const Message &msg)
+{
+    usize pos = writePos.load(std::memory_order_relaxed);
+    
+    while (true) {
+        
+        Slot &slot = slots[pos % capacity];
+        usize seq = slot.seq.load(std::memory_order_acquire);
+        
+        // Claim the slot if it is free
+        if (seq == pos) {
+            if (writePos.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+                slot.msg = msg;
+                slot.seq.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+            continue;
+        }
+        
+        // Give up if the slot hasn't been consumed yet
+        if ((isize)(seq - pos) < 0) return false;
+        
+        // Another producer has claimed the slot
+        pos = writePos.load(std::memory_order_relaxed);
+    }
+}
+
+isize
+MsgQueue::dispatch()
+{
+    isize count = 0;
+    
+    // Only a single thread may consume messages at a time
+    AutoMutex lock(dispatchMutex);
+    
+    while (true) {
+        
+        Slot &slot = slots[readPos % capacity];
+        if (slot.seq.load(std::memory_order_acquire) != readPos + 1) break;
+        
+        Message msg = slot.msg;
+        slot.seq.store(readPos + capacity, std::memory_order_release);
+        readPos++;
+        
+        deliver(msg);
+        count++;
+    }
+    
+    return count;
+}
+
+void
+MsgQueue::setDelivery(Delivery mode)
+{
+    if (mode == delivery) return;
+    
+    stopDispatcher();
+    
+    // Publish the mode before draining to let late producers deliver, too
+    delivery = mode;
+    
+    switch (mode) {
+            
+        case Delivery::sync:    dispatch(); break;
+        case Delivery::thread:  startDispatcher(); break;
+        case Delivery::poll:    break;
+    }
+}
+
+void
+MsgQueue::startDispatcher()
+{
+    assert(!dispatching);
+    
+    dispatching = true;
+    pthread_create(&dispatcher, nullptr, dispatcherMain, (void *)this);
+}
+
+void
+MsgQueue::stopDispatcher()
+{
+    if (!dispatching) return;
+    
+    dispatching = false;
+    pthread_join(dispatcher, nullptr);
+}
+
+void *
+MsgQueue::dispatcherMain(void *queue)
+{
+    MsgQueue *q = (MsgQueue *)queue;
+    
+    /* Producers don't signal the dispatcher, because this would require a
+     * lock. Instead, the dispatcher sleeps for a short while if the ring
+     * buffer runs empty.
+     */
+    while (q->dispatching) {
+        if (q->dispatch() == 0) usleep(1000);
+    }
+    
+    // Deliver the remaining messages
+    q->dispatch();
+    return nullptr;
+}
+
 void
 MsgQueue::dump()
 {
@@ -10,15 +10,57 @@
 #pragma once
 
 #include "HardwareComponent.h"
+#include <atomic>
 
+/* By default, put() propagates a message to all listeners right away, i.e.,
+ * listeners are executed by the thread that has issued the message, which is
+ * the emulator thread in most cases. In asynchronous mode, put() only stores
+ * the message in a lock-free ring buffer that can be written by multiple
+ * threads at the same time. The messages are propagated by dispatch(), which
+ * is either called periodically by a dispatcher thread or by the host.
+ */
 class MsgQueue : public HardwareComponent {
         
+public:
+    
+    enum class Delivery {
+        
+        sync,     // Listeners are called inside put()
+        thread,   // Listeners are called by the dispatcher thread
+        poll      // Listeners are called when the host calls dispatch()
+    };
+
+private:
+    
     // Ring buffer storing all pending messages
     RingBuffer<Message, 64> queue;
             
     // List of registered listeners
     std::vector<std::pair <const void *, Callback *> > listeners;
 
+    // The current delivery mode
+    std::atomic<Delivery> delivery { Delivery::sync };
+    
+    /* Messages waiting to be dispatched in asynchronous mode. Each slot
+     * carries a sequence number telling producers and the consumer whether
+     * the slot is free or filled (bounded MPSC queue).
+     */
+    static constexpr usize capacity = 256;
+    struct Slot { std::atomic<usize> seq; Message msg; };
+    Slot slots[capacity];
+    std::atomic<usize> writePos { 0 };
+    usize readPos = 0;
+    
+    // Serializes the consumers of the ring buffer (see dispatch())
+    Mutex dispatchMutex;
+    
+    // Number of messages dropped because the ring buffer was full
+    std::atomic<usize> lost { 0 };
+    
+    // The dispatcher thread
+    pthread_t dispatcher;
+    std::atomic<bool> dispatching { false };
+
     
     //
     // Methods from HardwareComponent
@@ -26,6 +68,8 @@ class MsgQueue : public HardwareComponent {
     
 public:
         
+    MsgQueue();
+    ~MsgQueue();
     const char *getDescription() const override { return "MessageQueue"; }
 
 private:
@@ -33,6 +77,7 @@ private:
     void _reset() override { };
     
     usize _size() override { return 0; }
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buffer) override { return 0; }
     usize _save(u8 *buffer) override { return 0; }
     
@@ -55,6 +100,29 @@ public:
     // Writes a message into the queue and propagates it to all listeners
     void put(MsgType type, long data = 0);
     
+    
+    //
+    // Delivering messages asynchronously
+    //
+    
+public:
+    
+    Delivery getDelivery() const { return delivery; }
+    
+    /* Changes the delivery mode. When switching back to synchronous mode,
+     * all pending messages are delivered before the function returns.
+     * Messages that other threads are posting in the meantime are delivered
+     * by the posting thread.
+     */
+    void setDelivery(Delivery mode);
+    
+    // Propagates all pending messages and returns their number
+    isize dispatch();
+    
+    // Returns the number of messages lost due to a full ring buffer
+    usize getLost() const { return lost; }
+    
+    
     // Dumps the current contents of the message queue to the console
     void dump();
     void dump(const Message &msg);
@@ -63,4 +131,17 @@ private:
     
     // Used by 'put' to propagates a single message to all registered listeners
     void propagate(const Message &msg) const;
+    
+    // Stores a message and propagates it to all listeners
+    void deliver(const Message &msg);
+    
+    // Stores a message in the ring buffer (asynchronous mode)
+    bool enqueue(const Message &msg);
+    
+    // Starts or stops the dispatcher thread
+    void startDispatcher();
+    void stopDispatcher();
+    
+    // The dispatcher thread's main function
+    static void *dispatcherMain(void *queue);
 };
@@ -43,6 +43,7 @@ enum_long(MSG)
     MSG_CPU_JAMMED,
     MSG_BREAKPOINT_REACHED,
     MSG_WATCHPOINT_REACHED,
+    MSG_GUEST_EXIT,
 
     // VIC related messages
     MSG_PAL,
@@ -94,6 +95,9 @@ enum_long(MSG)
     MSG_USER_SNAPSHOT_TAKEN,
     MSG_SNAPSHOT_RESTORED,
     
+    // Performance monitoring
+    MSG_PERF,
+    
     MSG_COUNT
 };
 typedef MSG MsgType;
@@ -54,6 +54,7 @@ struct MsgTypeEnum : Reflection<MsgType, MsgType> {
             case MSG_CPU_JAMMED:           return "CPU_JAMMED";
             case MSG_BREAKPOINT_REACHED:   return "BREAKPOINT_REACHED";
             case MSG_WATCHPOINT_REACHED:   return "WATCHPOINT_REACHED";
+            case MSG_GUEST_EXIT:           return "GUEST_EXIT";
                 
             case MSG_PAL:                  return "PAL";
             case MSG_NTSC:                 return "NTSC";
@@ -98,6 +99,8 @@ struct MsgTypeEnum : Reflection<MsgType, MsgType> {
             case MSG_USER_SNAPSHOT_TAKEN:  return "USER_SNAPSHOT_TAKEN";
             case MSG_SNAPSHOT_RESTORED:    return "SNAPSHOT_RESTORED";
                 
+            case MSG_PERF:                 return "PERF";
+                
             case MSG_COUNT:                return "???";
         }
         return "???";
@@ -0,0 +1,294 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+#include <sys/time.h>
+
+Netplay::Netplay()
+{
+    pthread_mutex_init(&mutex, nullptr);
+    pthread_cond_init(&cond, nullptr);
+}
+
+Netplay::~Netplay()
+{
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mutex);
+}
+
+ErrorCode
+Netplay::start(const NetplayConfig &value)
+{
+    if (!value.sink) return ERROR_OPT_INV_ARG;
+    if (value.player != 0 && value.player != 1) return ERROR_OPT_INV_ARG;
+    if (value.inputDelay < 0 || value.maxRollback < 1 || value.timeout < 0) {
+        return ERROR_OPT_INV_ARG;
+    }
+
+    stop();
+
+    pthread_mutex_lock(&mutex);
+
+    config = value;
+    started = false;
+    checkpoints.assign(value.maxRollback + 1, Checkpoint());
+    stats = { };
+    active = true;
+
+    pthread_mutex_unlock(&mutex);
+
+    return ERROR_OK;
+}
+
+void
+Netplay::stop()
+{
+    pthread_mutex_lock(&mutex);
+
+    active = false;
+    pendingLocal.clear();
+    pendingRemote.clear();
+    inputs[0].clear();
+    inputs[1].clear();
+    checkpoints.clear();
+
+    pthread_mutex_unlock(&mutex);
+}
+
+void
+Netplay::submit(const InputEvent *events, usize count)
+{
+    assert(events || count == 0);
+
+    pthread_mutex_lock(&mutex);
+
+    for (usize i = 0; i < count; i++) {
+
+        if (!InputQueue::isValid(events[i])) {
+            warn("Ignoring invalid input event (%s)\n",
+                 InputEventTypeEnum::key(events[i].type));
+            continue;
+        }
+        pendingLocal.push_back(events[i]);
+    }
+
+    pthread_mutex_unlock(&mutex);
+}
+
+ErrorCode
+Netplay::receive(u64 frame, const InputEvent *events, usize count)
+{
+    assert(events || count == 0);
+
+    Packet packet { frame, std::vector<InputEvent>(events, events + count) };
+
+    for (auto &event : packet.events) {
+
+        switch (event.type) {
+
+            case INPUT_EVENT_PRESS_KEY:
+            case INPUT_EVENT_RELEASE_KEY:
+            case INPUT_EVENT_RELEASE_KEYS:
+            case INPUT_EVENT_JOYSTICK:
+            case INPUT_EVENT_MOUSE:
+            case INPUT_EVENT_MOUSE_MOVE:
+
+                if (InputQueue::isValid(event)) break;
+                [[fallthrough]];
+
+            default:
+
+                pthread_mutex_lock(&mutex);
+                stats.rejectedPackets++;
+                pthread_mutex_unlock(&mutex);
+                return ERROR_OPT_INV_ARG;
+        }
+    }
+
+    pthread_mutex_lock(&mutex);
+
+    pendingRemote.push_back(std::move(packet));
+    pthread_cond_broadcast(&cond);
+
+    pthread_mutex_unlock(&mutex);
+
+    return ERROR_OK;
+}
+
+void
+Netplay::advance(C64 &c64)
+{
+    assert(active && !resimulating);
+
+    u64 frame = c64.frame;
+    u64 target = frame + config.inputDelay;
+    isize local = config.player;
+
+    pthread_mutex_lock(&mutex);
+
+    // The frames preceding the first local input are known on both sides
+    if (!started) {
+
+        started = true;
+        unconfirmed = target;
+    }
+
+    // Schedule the local inputs and stamp them with their target cycle
+    auto &events = inputs[local][target];
+    for (auto &event : pendingLocal) {
+
+        event.cycle = c64.cpu.cycle + config.inputDelay * c64.vic.getCyclesPerFrame();
+        events.push_back(event);
+    }
+    pendingLocal.clear();
+
+    // Pick up the remote inputs and wait for them if they lag behind too far
+    u64 mispredicted = pickUp(frame);
+    if (config.timeout && frame >= unconfirmed + config.maxRollback) {
+
+        stats.stalls++;
+
+        struct timeval now;
+        gettimeofday(&now, nullptr);
+        u64 deadline = (u64)now.tv_sec * 1000000 + now.tv_usec + config.timeout * 1000;
+
+        struct timespec abstime;
+        abstime.tv_sec = deadline / 1000000;
+        abstime.tv_nsec = (deadline % 1000000) * 1000;
+
+        while (frame >= unconfirmed + config.maxRollback) {
+
+            if (pendingRemote.empty() &&
+                pthread_cond_timedwait(&cond, &mutex, &abstime) != 0) break;
+
+            mispredicted = std::min(mispredicted, pickUp(frame));
+        }
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    // Transmit the local inputs (sent even if empty to confirm the frame)
+    config.sink(config.context, target, events.data(), (long)events.size());
+    stats.sentPackets++;
+
+    // Correct the frames emulated with wrongly predicted inputs
+    if (mispredicted < frame) rollback(c64, mispredicted, frame);
+
+    checkpoint(c64);
+    apply(c64);
+
+    // Keep the inputs that may be needed again by a rollback
+    u64 oldest = frame > (u64)config.maxRollback ? frame - config.maxRollback : 0;
+    for (isize i = 0; i < 2; i++) {
+
+        auto &map = inputs[i];
+        map.erase(map.begin(), map.lower_bound(std::min(oldest, unconfirmed)));
+    }
+}
+
+u64
+Netplay::pickUp(u64 frame)
+{
+    u64 result = UINT64_MAX;
+    isize remote = 1 - config.player;
+
+    for (auto &packet : pendingRemote) {
+
+        // Packets must arrive in order without gaps
+        if (packet.frame != unconfirmed) {
+
+            stats.rejectedPackets++;
+            continue;
+        }
+
+        unconfirmed++;
+        stats.receivedPackets++;
+        if (packet.events.empty()) continue;
+
+        // A frame that has already started has been emulated without them
+        if (packet.frame < frame) result = std::min(result, packet.frame);
+        inputs[remote][packet.frame] = std::move(packet.events);
+    }
+    pendingRemote.clear();
+
+    return result;
+}
+
+void
+Netplay::rollback(C64 &c64, u64 from, u64 to)
+{
+    Checkpoint &cp = checkpoints[from % checkpoints.size()];
+
+    // Check if the rollback reaches back far enough
+    if (cp.frame != from || cp.state.isEmpty() || !cp.state.matches(c64)) {
+
+        warn("Netplay: Can't roll back to frame %llu\n", from);
+        stats.desyncs++;
+        return;
+    }
+
+    resimulating = true;
+    resimulatingUntil = to;
+
+    cp.state.restore(c64);
+    c64.drivesLag = 0;
+    c64.rescheduleEvents();
+    assert(c64.frame == from);
+
+    // Emulate the missed frames again
+    while (c64.frame < to) {
+
+        u64 frame = c64.frame;
+
+        if (frame != from) checkpoint(c64);
+        apply(c64);
+        while (c64.frame == frame) c64.executeOneFrame();
+    }
+
+    resimulating = false;
+
+    stats.rollbacks++;
+    stats.resimulatedFrames += to - from;
+    stats.maxDepth = std::max(stats.maxDepth, to - from);
+}
+
+void
+Netplay::checkpoint(C64 &c64)
+{
+    u64 frame = c64.frame;
+    Checkpoint &cp = checkpoints[frame % checkpoints.size()];
+    Checkpoint &prev = checkpoints[(frame - 1) % checkpoints.size()];
+
+    // Share the unchanged components with the checkpoint of the previous frame
+    cp.state.take(c64, prev.frame + 1 == frame ? &prev.state : nullptr, false);
+    cp.frame = frame;
+}
+
+void
+Netplay::apply(C64 &c64)
+{
+    // Both peers apply the inputs in the same order
+    for (isize i = 0; i < 2; i++) {
+
+        auto it = inputs[i].find(c64.frame);
+        if (it == inputs[i].end()) continue;
+
+        for (auto &event : it->second) c64.inputs.perform(event);
+    }
+}
+
+NetplayStats
+Netplay::getStats()
+{
+    pthread_mutex_lock(&mutex);
+    NetplayStats result = stats;
+    pthread_mutex_unlock(&mutex);
+
+    return result;
+}
@@ -0,0 +1,178 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include "IncrementalState.h"
+#include <pthread.h>
+#include <map>
+#include <vector>
+
+/* Runs a two-player session in lockstep with a remote emulator. Both peers
+ * start in the same state and exchange their inputs frame by frame. The
+ * inputs of a frame take effect in the first cycle of that frame. Local inputs
+ * are delayed by a configurable number of frames, which gives them time to
+ * reach the remote peer. They are stamped with the frame and the cycle they
+ * take effect in and handed over to a callback which transmits them.
+ *
+ * Remote inputs that haven't arrived in time are predicted. Since joystick,
+ * keyboard, and mouse events change the input state permanently, the
+ * prediction is that the remote player keeps the current state. If inputs
+ * arrive for a frame that has already been emulated, the emulator restores
+ * the checkpoint taken at the beginning of that frame and emulates the
+ * missed frames again. These frames are neither drawn nor heard and leave
+ * the rewind buffer and the input log untouched, just like frames emulated
+ * ahead of time (see RunAhead). Checkpoints are taken incrementally (see
+ * IncrementalState) and uncompressed.
+ *
+ * The remote peer sends a packet for each frame. If these packets lag behind
+ * further than rollbacks can reach, the emulator waits for them.
+ */
+class Netplay {
+
+    struct Checkpoint {
+
+        // The frame which starts in this state (0 = unused)
+        u64 frame = 0;
+
+        IncrementalState state;
+    };
+
+    // A packet received from the remote peer
+    struct Packet {
+
+        u64 frame;
+        std::vector<InputEvent> events;
+    };
+
+    // The current configuration (only changed while the emulator is suspended)
+    NetplayConfig config = { };
+    bool active = false;
+
+    // Indicates if the first frame of the session has started
+    bool started = false;
+
+    // First frame for which the remote inputs are unknown
+    u64 unconfirmed = 0;
+
+    // Inputs of both players, indexed by frame
+    std::map<u64, std::vector<InputEvent>> inputs[2];
+
+    // Checkpoints of recent frames (indexed by frame modulo size)
+    std::vector<Checkpoint> checkpoints;
+
+    // Indicates if missed frames are currently emulated again and until when
+    bool resimulating = false;
+    u64 resimulatingUntil = 0;
+
+    // Inputs passed in by the host and not picked up yet
+    std::vector<InputEvent> pendingLocal;
+    std::vector<Packet> pendingRemote;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+
+    // Statistics
+    NetplayStats stats = { };
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    Netplay();
+    ~Netplay();
+
+
+    //
+    // Configuring
+    //
+
+public:
+
+    /* Starts or stops a session. Both functions must be called while the
+     * emulator is suspended. The session starts with the next frame.
+     */
+    ErrorCode start(const NetplayConfig &config);
+    void stop();
+
+    bool isActive() const { return active; }
+
+    // Indicates if missed frames are currently emulated again
+    bool isResimulating() const { return resimulating; }
+
+    /* Checks if the frame following the specified frame is displayed. Only
+     * the frame following the last frame emulated again is displayed.
+     */
+    bool displaysNextFrame(u64 frame) const {
+        return !resimulating || frame >= resimulatingUntil;
+    }
+
+
+    //
+    // Exchanging inputs (host thread)
+    //
+
+public:
+
+    /* Submits local input events. The events are applied and transmitted at
+     * the beginning of the next frame. The cycle stamp is ignored.
+     */
+    void submit(const InputEvent *events, usize count);
+
+    /* Passes in the remote inputs of a frame. Packets must be passed in in
+     * the order in which they have been sent. Only key, joystick, and mouse
+     * events are accepted.
+     */
+    ErrorCode receive(u64 frame, const InputEvent *events, usize count);
+
+
+    //
+    // Running (emulator thread)
+    //
+
+public:
+
+    /* Exchanges the inputs with the remote peer, corrects mispredictions, and
+     * applies the inputs of the next frame. The function is called at the
+     * beginning of each frame.
+     */
+    void advance(class C64 &c64);
+
+private:
+
+    /* Picks up the remote packets passed in by the host and returns the
+     * earliest emulated frame whose prediction has been wrong (UINT64_MAX if
+     * there is none). The mutex must be locked.
+     */
+    u64 pickUp(u64 frame);
+
+    // Restores a checkpoint and emulates the frames up to the specified frame
+    void rollback(class C64 &c64, u64 from, u64 to);
+
+    // Takes a checkpoint at the beginning of the current frame
+    void checkpoint(class C64 &c64);
+
+    // Applies the inputs of both players to the current frame
+    void apply(class C64 &c64);
+
+    // Discards the inputs and checkpoints which are no longer needed
+    void trim(u64 frame);
+
+
+    //
+    // Analyzing
+    //
+
+public:
+
+    NetplayStats getStats();
+};
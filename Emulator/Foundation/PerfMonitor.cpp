@@ -0,0 +1,79 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+
+void
+PerfMonitor::configure(C64 &c64, isize interval)
+{
+    assert(interval >= 0);
+
+    this->interval = interval;
+    countdown = interval;
+    previous = read(c64);
+}
+
+PerfMonitor::Raw
+PerfMonitor::read(C64 &c64)
+{
+    Raw raw;
+
+    raw.frame = c64.frame;
+    raw.cycles = c64.cpu.cycle;
+    raw.nanos = Oscillator::nanos();
+    raw.framesDrawn = c64.vic.getDrawnFrames();
+    raw.framesSkipped = c64.vic.getSkippedFrames();
+    raw.sidSamples = c64.sid.producedSamples;
+    raw.driveCycles = 0;
+    raw.driveIdleCycles = 0;
+    for (auto drive : c64.drives) {
+        
+        raw.driveCycles += drive->cpu.cycle;
+        raw.driveIdleCycles += drive->getAsleepCycles();
+    }
+    raw.ciaIdleCycles[0] = c64.cia1.idleTotal() + c64.cia1.idleSince();
+    raw.ciaIdleCycles[1] = c64.cia2.idleTotal() + c64.cia2.idleSince();
+    raw.snapshotBytes = c64.snapshotWriter.bytesWritten();
+
+    return raw;
+}
+
+void
+PerfMonitor::sample(C64 &c64)
+{
+    Raw now = read(c64);
+
+    // Counters may jump backwards on a reset or when a snapshot is restored
+    auto delta = [](u64 now, u64 then) { return now >= then ? now - then : now; };
+
+    PerfCounters info = { };
+    info.sample = ++samples;
+    info.frame = now.frame;
+    info.cycles = delta(now.cycles, previous.cycles);
+    info.nanos = delta(now.nanos, previous.nanos);
+    info.framesDrawn = delta(now.framesDrawn, previous.framesDrawn);
+    info.framesSkipped = delta(now.framesSkipped, previous.framesSkipped);
+    info.sidSamples = delta(now.sidSamples, previous.sidSamples);
+    info.snapshotBytes = delta(now.snapshotBytes, previous.snapshotBytes);
+
+    u64 driveTotal = delta(now.driveCycles, previous.driveCycles);
+    info.driveIdleCycles = delta(now.driveIdleCycles, previous.driveIdleCycles);
+    info.driveCycles = driveTotal > info.driveIdleCycles ? driveTotal - info.driveIdleCycles : 0;
+
+    for (isize i = 0; i < 2; i++) {
+
+        u64 idle = delta(now.ciaIdleCycles[i], previous.ciaIdleCycles[i]);
+        info.ciaSleepRatio[i] = info.cycles ? std::min(1.0, (double)idle / info.cycles) : 0.0;
+    }
+
+    previous = now;
+    counters.publish(info);
+
+    c64.putMessage(MSG_PERF, info.sample);
+}
@@ -0,0 +1,96 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include "Buffers.h"
+
+/* Samples the host-side performance counters in regular intervals. The
+ * counters are maintained by the components themselves and grow
+ * monotonically. At the end of each sampling interval, the monitor computes
+ * the deltas to the previous sample, publishes the result and informs the GUI
+ * with a MSG_PERF message carrying the sequence number of the sample.
+ *
+ * The interval is measured in frames. An interval of 0 disables the monitor.
+ * Frames emulated ahead of time are not sampled.
+ */
+class PerfMonitor {
+
+    // Raw counter values
+    struct Raw {
+
+        u64 frame;
+        u64 cycles;
+        u64 nanos;
+        u64 framesDrawn;
+        u64 framesSkipped;
+        u64 sidSamples;
+        u64 driveCycles;
+        u64 driveIdleCycles;
+        u64 ciaIdleCycles[2];
+        u64 snapshotBytes;
+    };
+
+    // Distance between two samples in frames (0 = monitor is off)
+    isize interval = 0;
+
+    // Number of frames until the next sample is taken
+    isize countdown = 0;
+
+    // Counter values of the previous sample
+    Raw previous = { };
+
+    // Number of samples taken so far
+    u64 samples = 0;
+
+    // The most recent sample
+    InfoRecord<PerfCounters> counters;
+
+
+    //
+    // Configuring
+    //
+
+public:
+
+    // Sets the distance between two samples in frames (0 = off)
+    void configure(class C64 &c64, isize interval);
+    isize getInterval() const { return interval; }
+    bool isEnabled() const { return interval != 0; }
+
+
+    //
+    // Sampling (emulator thread)
+    //
+
+public:
+
+    // Takes a sample if the current interval has elapsed
+    void endFrame(class C64 &c64) {
+        if (interval && --countdown <= 0) { countdown = interval; sample(c64); }
+    }
+
+private:
+
+    void sample(class C64 &c64);
+
+    // Reads the raw counter values
+    static Raw read(class C64 &c64);
+
+
+    //
+    // Analyzing
+    //
+
+public:
+
+    // Returns the most recent sample
+    PerfCounters getCounters() const { return counters.read(); }
+};
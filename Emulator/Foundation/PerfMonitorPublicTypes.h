@@ -0,0 +1,48 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+// THIS FILE MUST CONFORM TO ANSI-C TO BE COMPATIBLE WITH SWIFT
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+//
+// Structures
+//
+
+/* Performance counters of a sampling interval. All values except the sequence
+ * number and the frame refer to the interval since the previous sample.
+ */
+typedef struct
+{
+    // Sequence number of the sample and frame it has been taken in
+    u64 sample;
+    u64 frame;
+
+    // Emulated C64 cycles and elapsed host time (nanoseconds)
+    u64 cycles;
+    u64 nanos;
+
+    // Frames that have been drawn or skipped by the VICII
+    u64 framesDrawn;
+    u64 framesSkipped;
+
+    // Audio samples produced by the SIDs
+    u64 sidSamples;
+
+    // Drive cycles executed with the CPU awake and asleep (both drives)
+    u64 driveCycles;
+    u64 driveIdleCycles;
+
+    // Fraction of the emulated cycles the CIAs have been asleep
+    double ciaSleepRatio[2];
+
+    // Snapshot bytes written to disk in the background
+    u64 snapshotBytes;
+}
+PerfCounters;
@@ -0,0 +1,109 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+#include <iomanip>
+
+void
+Profiler::configure(isize interval)
+{
+    assert(interval >= 0);
+
+    if (interval && !overhead) overhead = calibrate();
+    this->interval = interval;
+    countdown = interval;
+}
+
+void
+Profiler::begin()
+{
+    mark = Oscillator::nanos();
+}
+
+u64
+Profiler::elapsed()
+{
+    u64 now = Oscillator::nanos();
+    u64 result = now - mark;
+    mark = now;
+
+    return result > overhead ? result - overhead : 0;
+}
+
+u64
+Profiler::calibrate()
+{
+    // Take the fastest of a couple of back-to-back measurements
+    u64 result = UINT64_MAX;
+    for (isize i = 0; i < 256; i++) {
+
+        u64 start = Oscillator::nanos();
+        result = std::min(result, Oscillator::nanos() - start);
+    }
+    return result;
+}
+
+void
+Profiler::endFrame()
+{
+    frames++;
+
+    ProfilerStats info = { };
+    info.frames = frames;
+    info.lines = lines;
+    info.sampledLines = sampledLines;
+
+    // Extrapolate the measured rasterlines to all rasterlines
+    double scale = sampledLines ? (double)lines / sampledLines : 0.0;
+    double total = 0.0;
+
+    for (isize i = 0; i < PROFILE_COUNT; i++) {
+
+        double time = lineTime[i] * scale + frameTime[i];
+        info.nanosPerFrame[i] = time / frames;
+        total += time;
+    }
+    for (isize i = 0; i < PROFILE_COUNT; i++) {
+
+        info.share[i] = total > 0 ? 100.0 * info.nanosPerFrame[i] * frames / total : 0;
+    }
+
+    stats.publish(info);
+}
+
+void
+Profiler::clear()
+{
+    for (isize i = 0; i < PROFILE_COUNT; i++) lineTime[i] = frameTime[i] = 0;
+    frames = lines = sampledLines = 0;
+    countdown = interval;
+
+    stats.publish(ProfilerStats { });
+}
+
+void
+Profiler::writeToFile(const string &path) const
+{
+    std::ofstream out(path);
+    if (!out.is_open()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+
+    auto info = getStats();
+
+    out << std::fixed << std::setprecision(1);
+    for (isize i = 0; i < PROFILE_COUNT; i++) {
+
+        out << ProfileSlotEnum::key((ProfileSlot)i) << '\t';
+        out << info.nanosPerFrame[i] << '\t';
+        out << info.share[i] << '\n';
+    }
+    out << "FRAMES\t" << info.frames << '\t';
+    out << info.lines << '\t' << info.sampledLines << '\n';
+
+    if (!out.good()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+}
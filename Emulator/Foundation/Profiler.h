@@ -0,0 +1,120 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include "Buffers.h"
+
+/* Attributes the host time spent in the run loop to the emulated components.
+ * Taking a time stamp after each component in each cycle would slow down the
+ * emulator considerably. Hence, the profiler only measures every n-th
+ * rasterline in detail. Each measured rasterline is emulated by a variant of
+ * the run loop which takes a time stamp after each component and charges the
+ * elapsed time to the component's slot. The measurements are extrapolated to
+ * all rasterlines. Work carried out once per frame (e.g., executing the SIDs
+ * or serving the drives' vsync handlers) is measured in every frame. The
+ * time spent on synchronizing with the host clock is not charged to any slot.
+ *
+ * The statistics are computed at the end of each frame and can be read from
+ * any thread without locking.
+ */
+class Profiler {
+
+    // Distance between two measured rasterlines (0 = profiler is off)
+    isize interval = 0;
+
+    // Number of rasterlines until the next measured rasterline
+    isize countdown = 0;
+
+    // Time stamp of the most recent measurement
+    u64 mark = 0;
+
+    // Cost of taking a single time stamp
+    u64 overhead = 0;
+
+    // Host time spent in the measured rasterlines in nanoseconds
+    u64 lineTime[PROFILE_COUNT] = { };
+
+    // Host time spent in the per-frame work in nanoseconds
+    u64 frameTime[PROFILE_COUNT] = { };
+
+    // Number of emulated frames and rasterlines
+    u64 frames = 0;
+    u64 lines = 0;
+    u64 sampledLines = 0;
+
+    // The most recent statistics
+    InfoRecord<ProfilerStats> stats;
+
+
+    //
+    // Configuring
+    //
+
+public:
+
+    // Sets the distance between two measured rasterlines (0 = off)
+    void configure(isize interval);
+    isize getInterval() const { return interval; }
+    bool isEnabled() const { return interval != 0; }
+
+
+    //
+    // Measuring (emulator thread)
+    //
+
+public:
+
+    // Counts a rasterline and checks if it is to be measured in detail
+    bool sampleLine() {
+        lines++;
+        if (--countdown > 0) return false;
+        countdown = interval;
+        sampledLines++;
+        return true;
+    }
+
+    // Starts a measurement
+    void begin();
+
+    // Charges the time since the last measurement to a component
+    void charge(ProfileSlot slot) { lineTime[slot] += elapsed(); }
+    void chargeFrame(ProfileSlot slot) { frameTime[slot] += elapsed(); }
+
+    // Computes the statistics at the end of a frame
+    void endFrame();
+
+private:
+
+    // Returns the time since the last measurement and starts a new one
+    u64 elapsed();
+
+    // Measures the cost of taking a time stamp
+    static u64 calibrate();
+
+
+    //
+    // Analyzing
+    //
+
+public:
+
+    // Returns the most recent statistics
+    ProfilerStats getStats() const { return stats.read(); }
+
+    // Resets all measurements
+    void clear();
+
+    /* Writes the statistics to a text file. Each component is described by a
+     * line of tab separated values (component, nanoseconds per frame, share
+     * in percent). The last line summarizes the measured frames and lines.
+     */
+    void writeToFile(const string &path) const throws;
+};
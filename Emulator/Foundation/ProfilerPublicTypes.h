@@ -0,0 +1,49 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+// THIS FILE MUST CONFORM TO ANSI-C TO BE COMPATIBLE WITH SWIFT
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+//
+// Enumerations
+//
+
+enum_long(PROFILE)
+{
+    PROFILE_CPU,
+    PROFILE_VICII,
+    PROFILE_CIA,
+    PROFILE_SID,
+    PROFILE_DRIVE,
+    PROFILE_DATASETTE,
+    PROFILE_OTHER,
+    PROFILE_COUNT
+};
+typedef PROFILE ProfileSlot;
+
+
+//
+// Structures
+//
+
+typedef struct
+{
+    // Number of measured frames and rasterlines
+    u64 frames;
+    u64 lines;
+    u64 sampledLines;
+    
+    // Host time spent in each component per frame (nanoseconds)
+    double nanosPerFrame[PROFILE_COUNT];
+    
+    // Share of each component in the total host time (percent)
+    double share[PROFILE_COUNT];
+}
+ProfilerStats;
@@ -0,0 +1,42 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "ProfilerPublicTypes.h"
+#include "Reflection.h"
+
+//
+// Reflection APIs
+//
+
+struct ProfileSlotEnum : Reflection<ProfileSlotEnum, ProfileSlot> {
+    
+    static bool isValid(long value)
+    {
+        return (unsigned long)value < PROFILE_COUNT;
+    }
+    
+    static const char *prefix() { return "PROFILE"; }
+    static const char *key(ProfileSlot value)
+    {
+        switch (value) {
+                
+            case PROFILE_CPU:        return "CPU";
+            case PROFILE_VICII:      return "VICII";
+            case PROFILE_CIA:        return "CIA";
+            case PROFILE_SID:        return "SID";
+            case PROFILE_DRIVE:      return "DRIVE";
+            case PROFILE_DATASETTE:  return "DATASETTE";
+            case PROFILE_OTHER:      return "OTHER";
+            case PROFILE_COUNT:      return "???";
+        }
+        return "???";
+    }
+};
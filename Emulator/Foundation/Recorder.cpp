@@ -0,0 +1,350 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "Recorder.h"
+#include "C64Constants.h"
+#include "Errors.h"
+#include "Utils.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+Recorder::Recorder()
+{
+    pthread_mutex_init(&mutex, nullptr);
+    pthread_cond_init(&cond, nullptr);
+}
+
+Recorder::~Recorder()
+{
+    stop();
+    join();
+
+    for (usize i = 0; i < pooled; i++) delete pool[i];
+
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mutex);
+}
+
+const char *
+Recorder::encoder()
+{
+    static const char *paths[] = {
+        "/usr/local/bin/ffmpeg", "/opt/homebrew/bin/ffmpeg", "/usr/bin/ffmpeg"
+    };
+
+    for (auto path : paths) if (access(path, X_OK) == 0) return path;
+    return nullptr;
+}
+
+pid_t
+Recorder::spawn(const std::vector<string> &args, int in)
+{
+    std::vector<char *> argv;
+    for (auto &arg : args) argv.push_back(const_cast<char *>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (in >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, in, STDIN_FILENO);
+        posix_spawn_file_actions_addclose(&actions, in);
+    }
+
+    pid_t pid;
+    int err = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+
+    return err == 0 ? pid : -1;
+}
+
+void
+Recorder::join()
+{
+    if (running) {
+
+        pthread_join(thread, nullptr);
+        running = false;
+    }
+}
+
+void
+Recorder::start(const char *path, isize h, long fpsNum, long fpsDen, double rate)
+{
+    assert(path);
+    assert(h > 0 && h <= maxHeight);
+
+    stop();
+
+    // Wait until the previous recording has been muxed
+    join();
+
+    const char *ffmpeg = encoder();
+    if (ffmpeg == nullptr) throw VC64Error(ERROR_REC_LAUNCH);
+
+    outputPath = path;
+    videoPath = outputPath + ".video.mp4";
+    audioPath = outputPath + ".audio.raw";
+    height = h;
+    resampler.setRates(rate, sampleRate);
+    resampler.clear();
+
+    if (!(audio = fopen(audioPath.c_str(), "wb"))) {
+        throw VC64Error(ERROR_FILE_CANT_WRITE);
+    }
+
+    // Prefer the hardware encoder of the host
+#ifdef __APPLE__
+    const char *codec = "h264_videotoolbox";
+#else
+    const char *codec = "libx264";
+#endif
+
+    std::vector<string> args = {
+        ffmpeg, "-y", "-loglevel", "error", "-f", "rawvideo",
+        "-pixel_format", "rgba",
+        "-video_size", std::to_string(width) + "x" + std::to_string(height),
+        "-framerate", std::to_string(fpsNum) + "/" + std::to_string(fpsDen),
+        "-i", "-", "-c:v", codec, "-b:v", "8M", "-pix_fmt", "yuv420p", videoPath
+    };
+
+    // Feed the encoder through a pipe which isn't inherited by other processes
+    int fds[2];
+    if (pipe(fds) == 0) {
+
+        fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+        encoderPid = spawn(args, fds[0]);
+        close(fds[0]);
+
+        if (encoderPid < 0 || !(video = fdopen(fds[1], "w"))) {
+
+            close(fds[1]);
+            if (encoderPid >= 0) waitpid(encoderPid, nullptr, 0);
+            encoderPid = -1;
+        }
+    }
+
+    if (!video) {
+
+        fclose(audio);
+        audio = nullptr;
+        remove(audioPath.c_str());
+        throw VC64Error(ERROR_REC_LAUNCH);
+    }
+
+    // Allocate the frames on first use
+    if (pooled == 0) {
+        while (pooled < frameCount) pool[pooled++] = new Frame();
+    }
+    current = pool[--pooled];
+    current->numSamples = 0;
+    current->repeat = 1;
+
+    totalFrames = 0;
+    totalDropped = 0;
+    quit = false;
+    recording = true;
+
+    running = pthread_create(&thread, nullptr, main, (void *)this) == 0;
+    assert(running);
+}
+
+void
+Recorder::stop()
+{
+    if (!isRecording()) return;
+
+    recording = false;
+
+    /* Hand over the last (incomplete) frame for its audio samples and let the
+     * encoder thread drain the queue, finish the file, and terminate
+     */
+    pthread_mutex_lock(&mutex);
+    current->repeat = 0;
+    queue[(head + queued++) % frameCount] = current;
+    current = nullptr;
+    quit = true;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&mutex);
+}
+
+void
+Recorder::finish()
+{
+    bool encoded = false;
+
+    // Close the pipe and wait for the encoder to complete the video
+    if (video) fclose(video);
+    video = nullptr;
+    fclose(audio);
+    audio = nullptr;
+
+    int status;
+    if (waitpid(encoderPid, &status, 0) == encoderPid) {
+        encoded = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    encoderPid = -1;
+
+    // Mux the audio track into the video
+    if (encoded) {
+
+        std::vector<string> args = {
+            encoder(), "-y", "-loglevel", "error", "-i", videoPath,
+            "-f", "f32le", "-ar", std::to_string((long)sampleRate), "-ac", "2",
+            "-i", audioPath, "-c:v", "copy", "-c:a", "aac", "-b:a", "192k",
+            "-shortest", outputPath
+        };
+
+        pid_t pid = spawn(args);
+        if (pid < 0 || waitpid(pid, &status, 0) != pid ||
+            !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            warn("Failed to mux the audio track\n");
+        }
+
+    } else {
+
+        warn("The video encoder has failed\n");
+    }
+
+    remove(videoPath.c_str());
+    remove(audioPath.c_str());
+}
+
+void
+Recorder::addFrame(const void *texture, const u32 *palette)
+{
+    assert(isRecording());
+
+    const isize bpp = palette ? 1 : 4;
+    const u8 *src = (const u8 *)texture + (y1 * TEX_WIDTH + x1) * bpp;
+    u8 *dst = current->data;
+
+    for (isize y = 0; y < height; y++) {
+
+        memcpy(dst, src, width * bpp);
+        src += TEX_WIDTH * bpp;
+        dst += width * bpp;
+    }
+
+    current->indexed = palette != nullptr;
+    if (palette) memcpy(current->palette, palette, sizeof(current->palette));
+
+    pthread_mutex_lock(&mutex);
+
+    if (pooled == 0) {
+
+        /* The encoder thread is behind. Drop the frame and encode the next
+         * one twice. The audio samples are kept.
+         */
+        current->repeat++;
+        totalDropped++;
+        pthread_mutex_unlock(&mutex);
+        return;
+    }
+
+    queue[(head + queued++) % frameCount] = current;
+    current = pool[--pooled];
+    pthread_cond_broadcast(&cond);
+
+    pthread_mutex_unlock(&mutex);
+
+    current->numSamples = 0;
+    current->repeat = 1;
+    totalFrames++;
+}
+
+void
+Recorder::addSamples(const SamplePair *samples, usize n)
+{
+    assert(isRecording());
+
+    for (usize done = 0; done < n; ) {
+
+        // Only convert as many samples as fit into the current frame
+        usize chunk = n - done;
+        while (chunk > 1 && resampler.maxOutput(chunk) > maxSamples - current->numSamples) {
+            chunk /= 2;
+        }
+        if (resampler.maxOutput(chunk) > maxSamples - current->numSamples) return;
+
+        SamplePair *dst = current->samples + current->numSamples;
+        current->numSamples += resampler.process(samples + done, chunk, dst);
+        done += chunk;
+    }
+}
+
+void
+Recorder::encode(Frame *frame, u32 *buffer)
+{
+    const u8 *data = frame->data;
+
+    // Translate color indices into RGBA values
+    if (frame->indexed) {
+
+        for (isize i = 0; i < width * height; i++) {
+            buffer[i] = frame->palette[frame->data[i]];
+        }
+        data = (const u8 *)buffer;
+    }
+
+    for (usize i = 0; video && i < frame->repeat; i++) {
+
+        // Stop feeding the encoder if it has terminated
+        if (fwrite(data, 4, width * height, video) != (usize)(width * height)) {
+
+            fclose(video);
+            video = nullptr;
+        }
+    }
+    fwrite(frame->samples, sizeof(SamplePair), frame->numSamples, audio);
+}
+
+void *
+Recorder::main(void *ptr)
+{
+    Recorder *recorder = (Recorder *)ptr;
+    u32 *buffer = new u32[width * maxHeight];
+
+    // Let writes to a terminated encoder fail instead of raising SIGPIPE
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+
+    pthread_mutex_lock(&recorder->mutex);
+
+    while (true) {
+
+        while (recorder->queued == 0 && !recorder->quit) {
+            pthread_cond_wait(&recorder->cond, &recorder->mutex);
+        }
+        if (recorder->queued == 0) break;
+
+        Frame *frame = recorder->queue[recorder->head];
+        recorder->head = (recorder->head + 1) % frameCount;
+        recorder->queued--;
+
+        // Encode the frame without holding the lock
+        pthread_mutex_unlock(&recorder->mutex);
+        recorder->encode(frame, buffer);
+        pthread_mutex_lock(&recorder->mutex);
+
+        recorder->pool[recorder->pooled++] = frame;
+    }
+
+    pthread_mutex_unlock(&recorder->mutex);
+    delete [] buffer;
+
+    recorder->finish();
+    return nullptr;
+}
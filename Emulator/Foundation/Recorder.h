@@ -0,0 +1,185 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include "SIDStreams.h"
+#include "SIDResampler.h"
+#include "Utils.h"
+#include <pthread.h>
+#include <sys/types.h>
+#include <cstdio>
+#include <vector>
+
+/* Records the emulator output as a video file. VICII hands over each frame
+ * at the end of the frame and SIDBridge hands over the mixed audio samples.
+ * Both are collected in a pool of frame buffers. Completed frames are passed
+ * by pointer to a background thread which feeds the video data into an
+ * external FFmpeg process and writes the audio samples into a temporary
+ * file. When the recording stops, the background thread finishes the video
+ * and muxes the audio track into it. Hence, stopping never blocks the caller.
+ * FFmpeg is launched without a shell, i.e., file names are passed verbatim.
+ *
+ * The audio track is always recorded at 48 kHz, regardless of the sample rate
+ * of the speaker stream. The mixed samples are converted on the fly.
+ *
+ * If the encoder falls behind, the emulator thread never waits. Instead, the
+ * frame is dropped and the next one is encoded twice to keep audio and video
+ * in sync.
+ */
+class Recorder {
+
+public:
+
+    // The recorded area of the emulator texture
+    static const isize x1 = 104;
+    static const isize y1 = 16;
+    static const isize width = 384;
+    static const isize palHeight = 284;
+    static const isize ntscHeight = 234;
+    static const isize maxHeight = palHeight;
+
+private:
+
+    // Number of frame buffers and capacity of the audio buffer of each frame
+    static const usize frameCount = 8;
+    static const usize maxSamples = 4096;
+
+    struct Frame {
+
+        // The frame in RGBA format or as color indices
+        u8 data[width * maxHeight * 4];
+        bool indexed;
+        u32 palette[256];
+
+        // The audio samples that have been produced along with the frame
+        SamplePair samples[maxSamples];
+        usize numSamples;
+
+        // Number of times the frame has to be encoded
+        usize repeat;
+    };
+
+    // Height of the recorded area
+    isize height = maxHeight;
+
+    // The frame that is currently filled by the emulator thread
+    Frame *current = nullptr;
+
+    // Frames waiting to be encoded and frames ready for reuse
+    Frame *queue[frameCount];
+    Frame *pool[frameCount];
+    usize head = 0;
+    usize queued = 0;
+    usize pooled = 0;
+
+    // The encoder process, its input pipe, and the temporary audio file
+    pid_t encoderPid = -1;
+    FILE *video = nullptr;
+    FILE *audio = nullptr;
+
+    // Indicates if a recording is in progress
+    bool recording = false;
+
+    // File names
+    string outputPath;
+    string videoPath;
+    string audioPath;
+
+    // Sample rate of the audio track
+    static constexpr double sampleRate = 48000.0;
+
+    // Converts the mixed samples into the sample rate of the audio track
+    SIDResampler resampler;
+
+    // Statistics
+    u64 totalFrames = 0;
+    u64 totalDropped = 0;
+
+    // The encoder thread
+    pthread_t thread;
+    bool running = false;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool quit = false;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    Recorder();
+    ~Recorder();
+
+
+    //
+    // Controlling
+    //
+
+public:
+
+    /* Starts a recording. The frame rate is specified as a fraction to match
+     * the exact refresh rate of the emulated machine. The sample rate refers
+     * to the samples passed in by addSamples().
+     */
+    void start(const char *path, isize height,
+               long fpsNum, long fpsDen, double sampleRate) throws;
+
+    /* Stops the recording. Audio and video are muxed into the output file in
+     * the background. The function doesn't wait for the mux to complete.
+     */
+    void stop();
+
+    // Returns true if a recording is in progress
+    bool isRecording() const { return recording; }
+
+    // Returns the number of recorded or dropped frames
+    u64 recorded() const { return totalFrames; }
+    u64 lost() const { return totalDropped; }
+
+
+    //
+    // Recording
+    //
+
+public:
+
+    /* Adds a frame. The pointer refers to the emulator texture. If a palette
+     * is provided, the texture consists of color indices.
+     */
+    void addFrame(const void *texture, const u32 *palette);
+
+    // Adds audio samples to the current frame
+    void addSamples(const SamplePair *samples, usize n);
+
+private:
+
+    // Locates the FFmpeg executable
+    static const char *encoder();
+
+    /* Launches a process without a shell and returns its id (-1 on error).
+     * If in is a valid file descriptor, it becomes the standard input.
+     */
+    static pid_t spawn(const std::vector<string> &args, int in = -1);
+
+    // Waits for the encoder thread of the previous recording to terminate
+    void join();
+
+    // Writes a single frame (called by the encoder thread)
+    void encode(Frame *frame, u32 *buffer);
+
+    // Closes the video and muxes in the audio track (called by the encoder thread)
+    void finish();
+
+    // The thread's main function
+    static void *main(void *recorder);
+};
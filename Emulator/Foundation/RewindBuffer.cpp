@@ -0,0 +1,242 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+
+static void
+putLEB128(std::vector<u8> &out, usize value)
+{
+    while (value >= 0x80) {
+        out.push_back((u8)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((u8)value);
+}
+
+static usize
+getLEB128(const u8 *&p)
+{
+    usize result = 0;
+    for (isize shift = 0; ; shift += 7) {
+        u8 byte = *p++;
+        result |= (usize)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return result;
+    }
+}
+
+void
+RewindBuffer::configure(isize interval, usize budget)
+{
+    assert(interval >= 0);
+
+    synchronized {
+
+        this->interval = interval;
+        this->budget = budget;
+
+        if (interval == 0) {
+            _clear();
+        } else {
+            while (usedBytes > budget && usedBytes > groupBytes) dropOldestGroup();
+        }
+    }
+}
+
+void
+RewindBuffer::record(C64 &c64)
+{
+    // Save the current state
+    usize size = c64.size();
+    current.resize(size);
+    c64.save(current.data());
+
+    synchronized {
+
+        // Start a new group if the current one is full or can't be extended
+        bool keyframe =
+        entries.empty() ||
+        last.size() != size ||
+        deltas == keyInterval ||
+        groupBytes > budget / 4;
+
+        if (keyframe) {
+            groupBytes = 0;
+            deltas = 0;
+        } else {
+            deltas++;
+        }
+
+        Entry entry { c64.frame, size, keyframe, { } };
+        encode(keyframe ? nullptr : last.data(), current.data(), size, entry.data);
+        entry.data.shrink_to_fit();
+
+        usedBytes += entry.data.size();
+        groupBytes += entry.data.size();
+        entries.push_back(std::move(entry));
+        std::swap(last, current);
+
+        // Enforce the memory budget (the current group is always kept)
+        while (usedBytes > budget && usedBytes > groupBytes) dropOldestGroup();
+    }
+}
+
+isize
+RewindBuffer::count()
+{
+    isize result;
+    synchronized { result = (isize)entries.size(); }
+    return result;
+}
+
+u64
+RewindBuffer::frameOf(isize nr)
+{
+    u64 result = 0;
+    synchronized {
+        if (nr >= 0 && nr < (isize)entries.size()) result = entries[nr].frame;
+    }
+    return result;
+}
+
+usize
+RewindBuffer::memoryUsage()
+{
+    usize result;
+    synchronized { result = usedBytes; }
+    return result;
+}
+
+bool
+RewindBuffer::restore(C64 &c64, isize nr)
+{
+    Snapshot *snapshot = nullptr;
+
+    synchronized {
+
+        if (nr >= 0 && nr < (isize)entries.size()) {
+
+            // Find the nearest keyframe
+            isize key = nr;
+            while (!entries[key].keyframe) key--;
+
+            // Decode the keyframe and replay all deltas
+            usize size = entries[nr].size;
+            last.assign(size, 0);
+            for (isize i = key; i <= nr; i++) {
+                assert(entries[i].size == size);
+                decode(last.data(), size, entries[i].data);
+            }
+
+            // Discard all newer states
+            while ((isize)entries.size() > nr + 1) {
+                usedBytes -= entries.back().data.size();
+                entries.pop_back();
+            }
+            groupBytes = 0;
+            for (isize i = key; i <= nr; i++) groupBytes += entries[i].data.size();
+            deltas = nr - key;
+
+            snapshot = new Snapshot(size);
+            memcpy(snapshot->getData(), last.data(), size);
+        }
+    }
+
+    if (!snapshot) return false;
+
+    bool result = c64.loadFromSnapshot(snapshot);
+    delete snapshot;
+    return result;
+}
+
+void
+RewindBuffer::clear()
+{
+    synchronized { _clear(); }
+}
+
+void
+RewindBuffer::_clear()
+{
+    entries.clear();
+    usedBytes = groupBytes = 0;
+    deltas = 0;
+
+    // Free the decoding buffers
+    std::vector<u8>().swap(last);
+    std::vector<u8>().swap(current);
+}
+
+void
+RewindBuffer::dropOldestGroup()
+{
+    assert(!entries.empty() && entries.front().keyframe);
+
+    do {
+        usedBytes -= entries.front().data.size();
+        entries.pop_front();
+    } while (!entries.empty() && !entries.front().keyframe);
+}
+
+void
+RewindBuffer::encode(const u8 *base, const u8 *state, usize size,
+                     std::vector<u8> &out)
+{
+    auto baseByte = [&](usize i) { return base ? base[i] : (u8)0; };
+    auto baseWord = [&](usize i) {
+        u64 word = 0; if (base) memcpy(&word, base + i, 8); return word;
+    };
+    auto stateWord = [&](usize i) {
+        u64 word; memcpy(&word, state + i, 8); return word;
+    };
+
+    out.clear();
+
+    usize i = 0;
+    while (i < size) {
+
+        // Skip all unchanged bytes
+        usize start = i;
+        while (i + 8 <= size && baseWord(i) == stateWord(i)) i += 8;
+        while (i < size && baseByte(i) == state[i]) i++;
+        if (i == size) break;
+
+        // Collect all changed bytes (short gaps of unchanged bytes included)
+        usize first = i;
+        while (i < size) {
+
+            if (baseByte(i) != state[i]) { i++; continue; }
+
+            usize j = i;
+            while (j < size && j < i + 4 && baseByte(j) == state[j]) j++;
+            if (j == size || j == i + 4) break;
+            i = j;
+        }
+
+        putLEB128(out, first - start);
+        putLEB128(out, i - first);
+        for (usize k = first; k < i; k++) out.push_back(baseByte(k) ^ state[k]);
+    }
+}
+
+void
+RewindBuffer::decode(u8 *state, usize size, const std::vector<u8> &data)
+{
+    const u8 *p = data.data();
+    const u8 *end = p + data.size();
+
+    usize i = 0;
+    while (p < end) {
+
+        i += getLEB128(p);
+        usize count = getLEB128(p);
+        assert(i + count <= size);
+
+        for (usize k = 0; k < count; k++) state[i++] ^= *p++;
+    }
+}
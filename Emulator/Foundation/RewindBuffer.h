@@ -0,0 +1,150 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include "Concurrency.h"
+#include <deque>
+#include <vector>
+
+/* A history of emulator states for rewinding the emulation. At regular frame
+ * intervals, the emulator state is recorded without a snapshot header or a
+ * thumbnail image. Most entries are stored as deltas which only contain the
+ * bytes that have changed since the previous entry. Every few entries, and
+ * whenever the size of the state changes, a keyframe is stored which does not
+ * depend on any other entry. Both kinds of entries are XOR encoded against
+ * their base (an all-zero state for keyframes) and run-length compressed.
+ *
+ *     Format : { skip (LEB128), count (LEB128), count XOR bytes }*
+ *
+ * A state is restored by decoding the nearest keyframe and applying all
+ * deltas up to the requested entry. Once the memory budget is exceeded, the
+ * oldest keyframe is discarded together with all deltas depending on it.
+ */
+class RewindBuffer {
+
+    struct Entry {
+
+        // Frame the state was recorded in
+        u64 frame;
+
+        // Size of the decoded state in bytes
+        usize size;
+
+        // Indicates if this entry is encoded against an all-zero state
+        bool keyframe;
+
+        // Encoded state
+        std::vector<u8> data;
+    };
+
+    // Recorded states (oldest first)
+    std::deque<Entry> entries;
+
+    // Memory occupied by all encoded states
+    usize usedBytes = 0;
+
+    // Number of frames between two recorded states (0 = off)
+    isize interval = 0;
+
+    // Maximum number of deltas following a keyframe
+    isize keyInterval = 32;
+
+    // Maximum amount of memory occupied by all encoded states
+    usize budget = 0;
+
+    // Encoded size of the most recent keyframe and all following deltas
+    usize groupBytes = 0;
+
+    // Number of deltas following the most recent keyframe
+    isize deltas = 0;
+
+    // Decoded state of the most recent entry and a scratch buffer
+    std::vector<u8> last;
+    std::vector<u8> current;
+
+    // Mutex for implementing the 'synchronized' macro
+    Mutex mutex;
+
+
+    //
+    // Configuring
+    //
+
+public:
+
+    /* Enables recording with the given number of frames between two states
+     * and the given memory budget in bytes. An interval of 0 disables
+     * recording and discards all recorded states.
+     */
+    void configure(isize interval, usize budget);
+
+    isize getInterval() const { return interval; }
+    usize getBudget() const { return budget; }
+
+
+    //
+    // Recording (emulator thread)
+    //
+
+public:
+
+    // Indicates if a state should be recorded at the end of this frame
+    bool isDue(u64 frame) const { return interval && frame % interval == 0; }
+
+    // Records the current emulator state
+    void record(class C64 &c64);
+
+
+    //
+    // Querying
+    //
+
+public:
+
+    // Returns the number of recorded states
+    isize count();
+
+    // Returns the frame the specified state was recorded in
+    u64 frameOf(isize nr);
+
+    // Returns the amount of memory occupied by all recorded states
+    usize memoryUsage();
+
+
+    //
+    // Restoring
+    //
+
+public:
+
+    /* Restores the specified state. All newer states are discarded, because
+     * the emulation will take a different course from here. The function
+     * must not be called on a running emulator.
+     */
+    bool restore(class C64 &c64, isize nr);
+
+    // Discards all recorded states
+    void clear();
+
+private:
+
+    void _clear();
+
+    // Drops the oldest keyframe and all deltas depending on it
+    void dropOldestGroup();
+
+    // XOR encodes a state against a base state (nullptr = all zeroes)
+    static void encode(const u8 *base, const u8 *state, usize size,
+                       std::vector<u8> &out);
+
+    // Applies an encoded state to a base state
+    static void decode(u8 *state, usize size, const std::vector<u8> &data);
+};
@@ -0,0 +1,112 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+
+void
+RunAhead::configure(isize frames)
+{
+    assert(frames >= 0);
+    this->frames = frames;
+}
+
+bool
+RunAhead::isActive(const C64 &c64) const
+{
+    return
+    frames > 0 &&
+    !c64.isHeadless() &&
+    !c64.inWarpMode() &&
+    !c64.inDebugMode() &&
+    !c64.recorder.isRecording() &&
+    !c64.netplay.isActive() &&
+    !c64.inputLog.isRecording() &&
+    !c64.inputLog.isReplaying();
+}
+
+void
+RunAhead::save(C64 &c64)
+{
+    assert(!ahead);
+    u64 start = Oscillator::nanos();
+
+    // Rebuild the slot table if the snapshot layout has changed
+    if (!matches(c64)) {
+
+        usize offset = 0;
+        slots.clear();
+        
+        // Assign a slot inside the state buffer to each component
+        for (HardwareComponent *c : c64.components()) {
+            
+            usize size = c->_size();
+            slots.push_back(Slot { c, offset, size, 0 });
+            offset += size;
+        }
+        state.resize(offset);
+    }
+
+    // Save all components that have changed since the last call
+    c64.synchronizeDrives();
+    c64.prepareSave();
+    for (Slot &slot : slots) {
+
+        u64 stamp = slot.component->stateStamp();
+        if (stamp == slot.stamp) continue;
+
+        slot.component->saveOwnState(state.data() + slot.offset);
+        slot.stamp = stamp;
+    }
+
+    // Keep the events performed from now on
+    c64.inputs.hold();
+
+    base = c64.frame;
+    ahead = true;
+    saveTime = Oscillator::nanos() - start;
+}
+
+void
+RunAhead::restore(C64 &c64)
+{
+    assert(ahead);
+    u64 start = Oscillator::nanos();
+
+    // Restore all components that have changed since the state was saved
+    for (Slot &slot : slots) {
+
+        if (slot.component->stateStamp() == slot.stamp) continue;
+        slot.component->loadOwnState(state.data() + slot.offset);
+    }
+    c64.drivesLag = 0;
+    c64.rescheduleEvents();
+
+    // Perform the events again which have been performed ahead of time
+    c64.inputs.rewind();
+
+    ahead = false;
+    restoreTime = Oscillator::nanos() - start;
+}
+
+bool
+RunAhead::matches(C64 &c64)
+{
+    auto &components = c64.components();
+    if (components.size() != slots.size()) return false;
+
+    /* Comparing the total size is not sufficient. If one component grows
+     * while another one shrinks, the slots would overlap.
+     */
+    for (usize i = 0; i < slots.size(); i++) {
+
+        if (slots[i].component != components[i]) return false;
+        if (slots[i].size != components[i]->_size()) return false;
+    }
+    return true;
+}
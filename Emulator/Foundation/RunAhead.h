@@ -0,0 +1,124 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include <vector>
+
+/* Reduces the input latency by emulating frames ahead of time. After each
+ * frame, the emulator state is saved and the next frames are emulated with
+ * the current input. The last of these frames is handed over to the GUI.
+ * Afterwards, the saved state is restored. Hence, the GUI always displays a
+ * frame which lies the configured number of frames in the future, and each
+ * input shows up on the screen that many frames earlier.
+ *
+ * Emulating frames ahead of time has side effects which are dealt with by
+ * the affected components:
+ *
+ *   - VICII only draws the last frame emulated ahead of time.
+ *   - SIDBridge discards all samples produced ahead of time.
+ *   - The input queue rewinds all events performed ahead of time. The host's
+ *     keyboard, joystick, and mouse events are routed through the queue.
+ *   - Auto-typing, disk changes, the rewind buffer, and the input log only
+ *     advance in regular frames.
+ *
+ * The state is saved and restored component by component in snapshot format
+ * without allocating memory. Components which keep track of their changes
+ * (see HardwareComponent::stateStamp()) are skipped if they haven't changed.
+ * Usually, this applies to the inserted disks which make up the bulk of the
+ * emulator state.
+ */
+class RunAhead {
+
+    struct Slot {
+
+        // The component and the location of its state inside the buffer
+        class HardwareComponent *component;
+        usize offset;
+        usize size;
+
+        // State stamp of the saved state (0 = not saved yet)
+        u64 stamp;
+    };
+
+    // Number of frames to run ahead (0 = off)
+    isize frames = 0;
+
+    // Indicates if frames are emulated ahead of time
+    bool ahead = false;
+
+    // Frame in which the state has been saved
+    u64 base = 0;
+
+    // The saved emulator state and all components in serialization order
+    std::vector<u8> state;
+    std::vector<Slot> slots;
+
+    // Time spent on saving and restoring the most recent state in nanoseconds
+    u64 saveTime = 0;
+    u64 restoreTime = 0;
+
+
+    //
+    // Configuring
+    //
+
+public:
+
+    // Sets the number of frames to run ahead (0 disables the feature)
+    void configure(isize frames);
+    isize getFrames() const { return frames; }
+
+
+    //
+    // Querying
+    //
+
+public:
+
+    /* Checks if frames are emulated ahead of time. Running ahead is suspended
+     * in headless mode, in warp mode, in debug mode, while a video is
+     * recorded, during a netplay session, and while an input log is recorded
+     * or replayed.
+     */
+    bool isActive(const class C64 &c64) const;
+
+    // Indicates if the emulator is currently running ahead of time
+    bool isRunningAhead() const { return ahead; }
+
+    /* Checks if the frame following the specified frame is displayed. Only
+     * the last frame emulated ahead of time is displayed.
+     */
+    bool displaysNextFrame(u64 frame) const {
+        return (ahead ? (isize)(frame - base) + 1 : 1) == frames;
+    }
+
+    // Returns the time spent on saving and restoring in nanoseconds
+    u64 getSaveTime() const { return saveTime; }
+    u64 getRestoreTime() const { return restoreTime; }
+
+
+    //
+    // Running ahead (emulator thread)
+    //
+
+public:
+
+    // Saves the emulator state before the first frame is emulated ahead
+    void save(class C64 &c64);
+
+    // Restores the saved state after the last frame has been emulated ahead
+    void restore(class C64 &c64);
+
+private:
+
+    // Checks if the slot table matches the snapshot layout of all components
+    bool matches(class C64 &c64);
+};
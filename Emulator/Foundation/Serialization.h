@@ -14,9 +14,11 @@
 #include "CPUInstructions.h"
 #include "TimeDelayed.h"
 #include "Volume.h"
+#include "RomImage.h"
 #include "envelope.h"
 
 #include <arpa/inet.h>
+#include <type_traits>
 
 //
 // Basic memory buffer I/O
@@ -99,6 +101,56 @@ inline void writeDouble(u8 *& buf, double value)
 }
 
 
+//
+// Bulk memory buffer I/O
+//
+
+// Converts an integer from or to big-endian byte order
+template <class T> inline T swapBE(T value)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if constexpr (sizeof(T) == 2) return (T)__builtin_bswap16((u16)value);
+    if constexpr (sizeof(T) == 4) return (T)__builtin_bswap32((u32)value);
+    if constexpr (sizeof(T) == 8) return (T)__builtin_bswap64((u64)value);
+#endif
+    return value;
+}
+
+/* Reads or writes an array of integers. The result is the same as reading or
+ * writing each element separately. Byte arrays are copied in one go. The loops
+ * for wider types are simple enough to be vectorized by the compiler.
+ */
+template <class T> inline void readArray(u8 *& buf, T *v, usize n)
+{
+    if constexpr (sizeof(T) == 1) {
+        memcpy((void *)v, buf, n);
+    } else {
+        for (usize i = 0; i < n; i++) {
+            T value; memcpy(&value, buf + i * sizeof(T), sizeof(T));
+            v[i] = swapBE(value);
+        }
+    }
+    buf += n * sizeof(T);
+}
+
+template <class T> inline void writeArray(u8 *& buf, const T *v, usize n)
+{
+    if constexpr (sizeof(T) == 1) {
+        memcpy(buf, (const void *)v, n);
+    } else {
+        for (usize i = 0; i < n; i++) {
+            T value = swapBE(v[i]);
+            memcpy(buf + i * sizeof(T), &value, sizeof(T));
+        }
+    }
+    buf += n * sizeof(T);
+}
+
+// Indicates if an array of type T can be processed with the bulk functions
+template <class T> constexpr bool isBulkType =
+std::is_integral<T>::value && !std::is_same<std::remove_cv_t<T>, bool>::value;
+
+
 //
 // Counter (determines the state size)
 //
@@ -159,13 +211,18 @@ public:
     STRUCT(DiskData)
     STRUCT(DiskLength)
     STRUCT(Volume)
+    STRUCT(RomImage)
     template <class T, int capacity> STRUCT(TimeDelayed<T __ capacity>)
 
     template <class T, usize N>
     SerCounter& operator&(T (&v)[N])
     {
-        for(usize i = 0; i < N; ++i) {
-            *this & v[i];
+        if constexpr (isBulkType<T>) {
+            count += sizeof(v);
+        } else {
+            for(usize i = 0; i < N; ++i) {
+                *this & v[i];
+            }
         }
         return *this;
     }
@@ -232,13 +289,18 @@ public:
     STRUCT(DiskData)
     STRUCT(DiskLength)
     STRUCT(Volume)
+    STRUCT(RomImage)
     template <class T, int capacity> STRUCT(TimeDelayed<T __ capacity>)
 
     template <class T, usize N>
     SerReader& operator&(T (&v)[N])
     {
-        for(usize i = 0; i < N; ++i) {
-            *this & v[i];
+        if constexpr (isBulkType<T>) {
+            readArray(ptr, v, N);
+        } else {
+            for(usize i = 0; i < N; ++i) {
+                *this & v[i];
+            }
         }
         return *this;
     }
@@ -311,13 +373,18 @@ public:
     STRUCT(DiskData)
     STRUCT(DiskLength)
     STRUCT(Volume)
+    STRUCT(RomImage)
     template <class T, int capacity> STRUCT(TimeDelayed<T __ capacity>)
 
     template <class T, usize N>
     SerWriter& operator&(T (&v)[N])
     {
-        for(usize i = 0; i < N; ++i) {
-            *this & v[i];
+        if constexpr (isBulkType<T>) {
+            writeArray(ptr, v, N);
+        } else {
+            for(usize i = 0; i < N; ++i) {
+                *this & v[i];
+            }
         }
         return *this;
     }
@@ -330,6 +397,97 @@ public:
 };
 
 
+//
+// Hasher (computes a FNV-1a checksum without serializing)
+//
+
+#define HASH(type) \
+SerHasher& operator&(type& v) \
+{ \
+hash = fnv_1a_it64(hash, (u64)v); \
+return *this; \
+}
+
+#define HASHF(type,cast) \
+SerHasher& operator&(type& v) \
+{ \
+cast bits; memcpy(&bits, &v, sizeof(bits)); \
+hash = fnv_1a_it64(hash, (u64)bits); \
+return *this; \
+}
+
+class SerHasher
+{
+public:
+
+    u64 hash;
+
+    SerHasher() { hash = fnv_1a_init64(); }
+
+    HASH(const bool)
+    HASH(const char)
+    HASH(const signed char)
+    HASH(const unsigned char)
+    HASH(const short)
+    HASH(const unsigned short)
+    HASH(const int)
+    HASH(const unsigned int)
+    HASH(const long long)
+    HASH(const unsigned long long)
+    HASHF(const float,u32)
+    HASHF(const double,u64)
+
+    HASH(const MemoryType)
+    HASH(const CartridgeType)
+    HASH(const DriveModel)
+    HASH(const InsertionStatus)
+    HASH(const MicroInstruction)
+    HASH(const CIARevision)
+    HASH(const VICRevision)
+    HASH(const SIDRevision)
+    HASH(const SIDEngine)
+    HASH(const SamplingMethod)
+    HASH(const GlueLogic)
+    HASH(const FlashState)
+    HASH(const reSID::EnvelopeGenerator::State)
+
+    STRUCT(VICIIRegisters)
+    STRUCT(SpriteSR)
+    STRUCT(DiskData)
+    STRUCT(DiskLength)
+    STRUCT(Volume)
+    STRUCT(RomImage)
+    template <class T, int capacity> STRUCT(TimeDelayed<T __ capacity>)
+
+    template <class T, usize N>
+    SerHasher& operator&(T (&v)[N])
+    {
+        if constexpr (isBulkType<T>) {
+            copy(v, sizeof(v));
+        } else {
+            for(usize i = 0; i < N; ++i) {
+                *this & v[i];
+            }
+        }
+        return *this;
+    }
+
+    // Hashes a memory block (eight bytes per iteration)
+    void copy(const void *src, usize n)
+    {
+        const u8 *p = (const u8 *)src;
+
+        for (; n >= 8; p += 8, n -= 8) {
+            u64 word; memcpy(&word, p, 8);
+            hash = fnv_1a_it64(hash, word);
+        }
+        for (; n; p++, n--) {
+            hash = fnv_1a_it64(hash, *p);
+        }
+    }
+};
+
+
 //
 // Resetter
 //
@@ -372,13 +530,18 @@ public:
     STRUCT(DiskData)
     STRUCT(DiskLength)
     STRUCT(Volume)
+    STRUCT(RomImage)
     template <class T, int capacity> STRUCT(TimeDelayed<T __ capacity>)
 
     template <class T, usize N>
     SerResetter& operator&(T (&v)[N])
     {
-        for(usize i = 0; i < N; ++i) {
-            *this & v[i];
+        if constexpr (isBulkType<T>) {
+            memset((void *)v, 0, sizeof(v));
+        } else {
+            for(usize i = 0; i < N; ++i) {
+                *this & v[i];
+            }
         }
         return *this;
     }
@@ -0,0 +1,95 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Config.h"
+
+/* Signposts mark the hot phases of the emulator for external profilers. On
+ * macOS, each phase is emitted as an os_signpost interval which shows up in
+ * the "Points of Interest" track of Instruments. On Linux, each phase is
+ * enclosed by two USDT probes (vc64:phase_begin and vc64:phase_end) carrying
+ * the phase number as argument. They can be enabled with
+ *
+ *     perf probe sdt_vc64:phase_begin sdt_vc64:phase_end
+ *
+ * The probes compile to a single nop instruction and the signposts to a
+ * check of a global flag as long as no profiler is attached. Commenting out
+ * SIGNPOSTS in C64Config.h removes them altogether.
+ */
+
+#if defined(SIGNPOSTS) && defined(__APPLE__)
+#include <os/signpost.h>
+#define SIGNPOST_BACKEND_OS
+#elif defined(SIGNPOSTS) && defined(__linux__) && __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define SIGNPOST_BACKEND_SDT
+#endif
+
+namespace signpost {
+
+enum Phase {
+
+    FRAME,          // Emulating a frame
+    SID,            // Synthesizing a batch of audio samples
+    SNAPSHOT,       // Creating a snapshot
+    DRIVE,          // Catching up the drives
+    TEXTURE         // Handing over a texture
+};
+
+#ifdef SIGNPOST_BACKEND_OS
+
+inline os_log_t log()
+{
+    static os_log_t log =
+    os_log_create("de.dirkwhoffmann.VirtualC64", OS_LOG_CATEGORY_POINTS_OF_INTEREST);
+    return log;
+}
+
+// Interval names must be string literals
+#define SIGNPOST_INTERVAL(func, phase) \
+switch (phase) { \
+case FRAME:    func(log(), OS_SIGNPOST_ID_EXCLUSIVE, "Frame"); break; \
+case SID:      func(log(), OS_SIGNPOST_ID_EXCLUSIVE, "SID"); break; \
+case SNAPSHOT: func(log(), OS_SIGNPOST_ID_EXCLUSIVE, "Snapshot"); break; \
+case DRIVE:    func(log(), OS_SIGNPOST_ID_EXCLUSIVE, "Drive"); break; \
+case TEXTURE:  func(log(), OS_SIGNPOST_ID_EXCLUSIVE, "Texture"); break; \
+}
+
+inline void begin(Phase phase) { SIGNPOST_INTERVAL(os_signpost_interval_begin, phase) }
+inline void end(Phase phase) { SIGNPOST_INTERVAL(os_signpost_interval_end, phase) }
+
+#undef SIGNPOST_INTERVAL
+
+#elif defined(SIGNPOST_BACKEND_SDT)
+
+inline void begin(Phase phase) { DTRACE_PROBE1(vc64, phase_begin, (int)phase); }
+inline void end(Phase phase) { DTRACE_PROBE1(vc64, phase_end, (int)phase); }
+
+#else
+
+inline void begin(Phase phase) { }
+inline void end(Phase phase) { }
+
+#endif
+
+// Marks the lifetime of a scope as a phase
+class Scope {
+
+    Phase phase;
+
+public:
+
+    Scope(Phase phase) : phase(phase) { begin(phase); }
+    ~Scope() { end(phase); }
+};
+
+}
+
+#define SIGNPOST(phase) signpost::Scope _signpost(signpost::phase)
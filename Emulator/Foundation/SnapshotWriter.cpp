@@ -0,0 +1,208 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+
+SnapshotWriter::SnapshotWriter()
+{
+    pthread_mutex_init(&mutex, nullptr);
+    pthread_cond_init(&cond, nullptr);
+
+    // The buffers grow to the snapshot size on first use
+    while (pooled < bufferCount) pool[pooled++] = new Job();
+}
+
+SnapshotWriter::~SnapshotWriter()
+{
+    if (launched) {
+
+        // Let the background thread drain the queue and terminate
+        pthread_mutex_lock(&mutex);
+        quit = true;
+        pthread_cond_broadcast(&cond);
+        pthread_mutex_unlock(&mutex);
+        pthread_join(thread, nullptr);
+    }
+
+    assert(pooled == bufferCount);
+    for (usize i = 0; i < pooled; i++) delete pool[i];
+
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mutex);
+}
+
+void
+SnapshotWriter::setPath(const string &path)
+{
+    pthread_mutex_lock(&mutex);
+    this->path = path;
+    pthread_mutex_unlock(&mutex);
+}
+
+void
+SnapshotWriter::setPolicy(const ThreadPolicy &value)
+{
+    pthread_mutex_lock(&mutex);
+    policy = value;
+    policyChanged = true;
+    pthread_mutex_unlock(&mutex);
+}
+
+string
+SnapshotWriter::getPath()
+{
+    pthread_mutex_lock(&mutex);
+    string result = path;
+    pthread_mutex_unlock(&mutex);
+
+    return result;
+}
+
+bool
+SnapshotWriter::save(C64 &c64)
+{
+    u64 start = Oscillator::nanos();
+    Job *job = nullptr;
+
+    pthread_mutex_lock(&mutex);
+
+    if (!path.empty()) {
+
+        if (pooled) {
+
+            job = pool[--pooled];
+
+        } else if (queued) {
+
+            // Replace the most recently queued snapshot
+            job = queue[(head + --queued) % bufferCount];
+            totalReplaced++;
+
+        } else {
+
+            totalDropped++;
+        }
+    }
+    string target = path;
+
+    pthread_mutex_unlock(&mutex);
+
+    if (!job) return false;
+
+    // Copy the emulator state without holding the lock
+    job->data.resize(sizeof(SnapshotHeader) + c64.size());
+    SnapshotHeader *header = (SnapshotHeader *)job->data.data();
+    Snapshot::initHeader(header);
+    Snapshot::takeScreenshot(header, &c64);
+    c64.save(job->data.data() + sizeof(SnapshotHeader));
+    job->path = target;
+
+    pthread_mutex_lock(&mutex);
+
+    queue[(head + queued++) % bufferCount] = job;
+    if (!launched) {
+
+        launched = true;
+        pthread_create(&thread, nullptr, main, (void *)this);
+    }
+    saveTime = Oscillator::nanos() - start;
+    pthread_cond_broadcast(&cond);
+
+    pthread_mutex_unlock(&mutex);
+
+    return true;
+}
+
+void
+SnapshotWriter::flush()
+{
+    pthread_mutex_lock(&mutex);
+    while (queued || busy) pthread_cond_wait(&cond, &mutex);
+    pthread_mutex_unlock(&mutex);
+}
+
+bool
+SnapshotWriter::write(Job *job, std::vector<u8> &buffer)
+{
+    rawSize = job->data.size();
+    compressedSize = writeCompressed(job->data.data(), rawSize, job->path, buffer);
+
+    return compressedSize != 0;
+}
+
+usize
+SnapshotWriter::writeCompressed(const u8 *data, usize size, const string &path,
+                                std::vector<u8> &buffer)
+{
+    usize header = Snapshot::compressedHeaderSize;
+
+    // Compress the snapshot
+    buffer.resize(header + lz4Bound(size));
+    memcpy(buffer.data(), Snapshot::compressedMagic, sizeof(Snapshot::compressedMagic));
+    W32BE(buffer.data() + 4, (u32)size);
+    usize total = header + lz4Compress(data, size, buffer.data() + header);
+
+    // Write into a temporary file to never leave a truncated snapshot behind
+    string tmp = path + ".tmp";
+    FILE *file = fopen(tmp.c_str(), "wb");
+    if (!file) return 0;
+
+    bool success = fwrite(buffer.data(), 1, total, file) == total;
+    success &= fclose(file) == 0;
+    success = success && rename(tmp.c_str(), path.c_str()) == 0;
+
+    if (!success) remove(tmp.c_str());
+    return success ? total : 0;
+}
+
+void *
+SnapshotWriter::main(void *ptr)
+{
+    SnapshotWriter *writer = (SnapshotWriter *)ptr;
+    std::vector<u8> buffer;
+
+    pthread_mutex_lock(&writer->mutex);
+
+    while (true) {
+
+        while (writer->queued == 0 && !writer->quit) {
+            pthread_cond_wait(&writer->cond, &writer->mutex);
+        }
+        if (writer->queued == 0) break;
+
+        Job *job = writer->queue[writer->head];
+        writer->head = (writer->head + 1) % bufferCount;
+        writer->queued--;
+        writer->busy = true;
+
+        if (writer->policyChanged) {
+
+            writer->policy.apply();
+            writer->policyChanged = false;
+        }
+
+        // Write the snapshot without holding the lock
+        pthread_mutex_unlock(&writer->mutex);
+        u64 start = Oscillator::nanos();
+        bool success = writer->write(job, buffer);
+        u64 elapsed = Oscillator::nanos() - start;
+        pthread_mutex_lock(&writer->mutex);
+
+        if (success) writer->totalWritten++; else writer->totalFailed++;
+        if (success) writer->totalBytes += writer->compressedSize;
+        writer->writeTime = elapsed;
+        writer->busy = false;
+        writer->pool[writer->pooled++] = job;
+        pthread_cond_broadcast(&writer->cond);
+    }
+
+    pthread_mutex_unlock(&writer->mutex);
+
+    return nullptr;
+}
@@ -0,0 +1,156 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include "Concurrency.h"
+#include <pthread.h>
+#include <atomic>
+#include <vector>
+
+/* Saves snapshots to disk without stalling the emulator. The emulator thread
+ * only copies the snapshot header and the emulator state into a pooled
+ * buffer. A background thread compresses the buffer (see Snapshot) and writes
+ * it to a temporary file which replaces the target file once it is complete.
+ *
+ * The emulator thread never waits for the background thread. If a snapshot
+ * is requested while all buffers are in use, the queued snapshot which hasn't
+ * been picked up yet is replaced by the new one. If no buffer is queued, the
+ * new snapshot is dropped.
+ */
+class SnapshotWriter {
+
+    // Number of snapshot buffers
+    static const usize bufferCount = 2;
+
+    struct Job {
+
+        // The uncompressed snapshot
+        std::vector<u8> data;
+
+        // The target file
+        string path;
+    };
+
+    // Snapshots waiting to be written and buffers ready for reuse
+    Job *queue[bufferCount];
+    Job *pool[bufferCount];
+    usize head = 0;
+    usize queued = 0;
+    usize pooled = 0;
+
+    // Indicates if the background thread is currently writing a snapshot
+    bool busy = false;
+
+    // The target file (empty = off)
+    string path;
+
+    // Statistics
+    u64 totalWritten = 0;
+    u64 totalReplaced = 0;
+    u64 totalDropped = 0;
+    u64 totalFailed = 0;
+    std::atomic<u64> totalBytes {0};
+    usize rawSize = 0;
+    usize compressedSize = 0;
+    u64 saveTime = 0;
+    u64 writeTime = 0;
+
+    // The background thread
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool launched = false;
+    bool quit = false;
+    
+    // Scheduling parameters (applied before the next snapshot is written)
+    ThreadPolicy policy;
+    bool policyChanged = false;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    SnapshotWriter();
+    ~SnapshotWriter();
+
+
+    //
+    // Configuring
+    //
+
+public:
+
+    // Sets the file the snapshots are written to (empty = off)
+    void setPath(const string &path);
+    string getPath();
+
+    bool isEnabled() { return !getPath().empty(); }
+
+    // Changes the scheduling parameters of the background thread
+    void setPolicy(const ThreadPolicy &value);
+
+
+    //
+    // Saving (emulator thread)
+    //
+
+public:
+
+    /* Hands the current emulator state over to the background thread. The
+     * function returns false if the snapshot had to be dropped.
+     */
+    bool save(class C64 &c64);
+
+    // Waits until all queued snapshots have been written
+    void flush();
+
+    /* Compresses a snapshot and writes it to a file on the calling thread.
+     * The buffer is used as scratch space. The function returns the size of
+     * the written file or 0 if the file couldn't be written.
+     */
+    static usize writeCompressed(const u8 *data, usize size, const string &path,
+                                 std::vector<u8> &buffer);
+
+
+    //
+    // Analyzing
+    //
+
+public:
+
+    // Returns the number of written, replaced, dropped, or failed snapshots
+    u64 written() const { return totalWritten; }
+    u64 replaced() const { return totalReplaced; }
+    u64 dropped() const { return totalDropped; }
+    u64 failed() const { return totalFailed; }
+
+    // Returns the number of bytes written to disk
+    u64 bytesWritten() const { return totalBytes; }
+
+    // Returns the size of the most recent snapshot before and after compression
+    usize lastRawSize() const { return rawSize; }
+    usize lastCompressedSize() const { return compressedSize; }
+
+    // Returns the time spent on the emulator thread and on the background thread
+    u64 lastSaveTime() const { return saveTime; }
+    u64 lastWriteTime() const { return writeTime; }
+
+private:
+
+    // Compresses a snapshot and writes it to disk (called by the background thread)
+    bool write(Job *job, std::vector<u8> &buffer);
+
+    // The thread's main function
+    static void *main(void *writer);
+};
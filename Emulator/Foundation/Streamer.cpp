@@ -0,0 +1,264 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+
+static const i16 stepTable[89] = {
+
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41,
+    45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209,
+    230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876,
+    963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749,
+    3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630,
+    9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623,
+    27086, 29794, 32767
+};
+
+static const i8 indexTable[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+ErrorCode
+Streamer::start(C64 &c64, const StreamConfig &value)
+{
+    if (!value.sink) return ERROR_OPT_INV_ARG;
+    if (value.sampleRate < 0 || value.keyInterval < 0) return ERROR_OPT_INV_ARG;
+
+    stop(c64);
+
+    if (value.sampleRate) {
+
+        output = c64.sid.openOutput((double)value.sampleRate);
+        if (output < 0) return ERROR_OUT_OF_MEMORY;
+    }
+
+    config = value;
+    sentHeight = 0;
+    lutValid = false;
+    framesSinceKey = 0;
+    keyRequested = true;
+    predictor = stepIndex = 0;
+
+    stats = { };
+    inputEvents = rejectedPackets = 0;
+
+    return ERROR_OK;
+}
+
+void
+Streamer::stop(C64 &c64)
+{
+    if (output >= 0) c64.sid.closeOutput(output);
+    output = -1;
+    config.sink = nullptr;
+}
+
+void
+Streamer::addFrame(u64 frame, const u8 *texture, const u32 *lut, isize height)
+{
+    isize offset = FIRST_VISIBLE_LINE * TEX_WIDTH + FIRST_VISIBLE_PIXEL;
+
+    // Send a key frame if requested, due, or if the frame size has changed
+    bool key = keyRequested.exchange(false) || height != sentHeight;
+    if (config.keyInterval && framesSinceKey >= (u64)config.keyInterval) key = true;
+
+    // Send the palette with the first frame and whenever it changes
+    bool palette = !lutValid || memcmp(sentLut, lut, sizeof(sentLut)) != 0;
+
+    sent.resize(VISIBLE_PIXELS * height);
+    packet.resize(headerSize);
+
+    if (palette) {
+
+        for (isize i = 0; i < 256; i++) {
+
+            packet.resize(packet.size() + 4);
+            W32BE(packet.data() + packet.size() - 4, lut[i]);
+        }
+        memcpy(sentLut, lut, sizeof(sentLut));
+        lutValid = true;
+    }
+
+    packet.resize(packet.size() + 4);
+    W16BE(packet.data() + packet.size() - 4, (u16)VISIBLE_PIXELS);
+    W16BE(packet.data() + packet.size() - 2, (u16)height);
+
+    // Encode all lines that differ from the previously sent frame
+    usize lines = 0;
+    for (isize y = 0; y < height; y++) {
+
+        const u8 *src = texture + offset + y * TEX_WIDTH;
+        u8 *prev = sent.data() + y * VISIBLE_PIXELS;
+
+        if (!key && memcmp(src, prev, VISIBLE_PIXELS) == 0) continue;
+        memcpy(prev, src, VISIBLE_PIXELS);
+
+        usize start = packet.size();
+        packet.resize(start + 4);
+        encodeLine(src);
+
+        W16BE(packet.data() + start, (u16)y);
+        W16BE(packet.data() + start + 2, (u16)(packet.size() - start - 4));
+        lines++;
+    }
+
+    sentHeight = height;
+    framesSinceKey = key ? 1 : framesSinceKey + 1;
+
+    stats.frames++;
+    if (key) stats.keyFrames++;
+    stats.videoBytes += packet.size();
+
+    u8 flags = (key ? keyFrameFlag : 0) | (palette ? paletteFlag : 0);
+    send(videoPacket, flags, lines, frame);
+}
+
+void
+Streamer::encodeLine(const u8 *line)
+{
+    for (isize x = 0; x < VISIBLE_PIXELS; ) {
+
+        u8 color = line[x];
+        isize run = 1;
+        while (x + run < VISIBLE_PIXELS && run < 255 && line[x + run] == color) run++;
+
+        packet.push_back((u8)run);
+        packet.push_back(color);
+        x += run;
+    }
+}
+
+void
+Streamer::addAudio(C64 &c64)
+{
+    if (output < 0) return;
+
+    // Collect all samples of the frame (a single packet holds 64K samples max)
+    samples.resize(0xFFFF);
+    usize count = c64.sid.readOutput(output, samples.data(), samples.size());
+    if (count == 0) return;
+
+    packet.resize(headerSize + 4 + (count + 1) / 2);
+    u8 *p = packet.data() + headerSize;
+
+    // Store the initial state of the decoder
+    W16BE(p, (u16)(i16)predictor);
+    p[2] = (u8)stepIndex;
+    p[3] = 0;
+    p += 4;
+
+    for (usize i = 0; i < count; i++) {
+
+        float mono = (samples[i].left + samples[i].right) * 0.5f;
+        i32 sample = (i32)(std::clamp(mono, -1.0f, 1.0f) * 32767.0f);
+        u8 code = encodeSample(sample);
+
+        if (i & 1) *p++ |= (u8)(code << 4); else *p = code;
+    }
+
+    stats.audioBytes += packet.size();
+    send(audioPacket, 0, count, c64.frame);
+}
+
+u8
+Streamer::encodeSample(i32 sample)
+{
+    i32 step = stepTable[stepIndex];
+    i32 diff = sample - predictor;
+    u8 code = 0;
+
+    if (diff < 0) { code = 8; diff = -diff; }
+
+    // Quantize the difference and reconstruct it as the decoder will do
+    i32 delta = step >> 3;
+    if (diff >= step) { code |= 4; diff -= step; delta += step; }
+    step >>= 1;
+    if (diff >= step) { code |= 2; diff -= step; delta += step; }
+    step >>= 1;
+    if (diff >= step) { code |= 1; delta += step; }
+
+    predictor += (code & 8) ? -delta : delta;
+    predictor = std::clamp(predictor, (i32)-32768, (i32)32767);
+    stepIndex = std::clamp(stepIndex + indexTable[code & 7], (i32)0, (i32)88);
+
+    return code;
+}
+
+void
+Streamer::send(u8 type, u8 flags, usize count, u64 frame)
+{
+    u8 *p = packet.data();
+
+    W8BE(p, type);
+    W8BE(p + 1, flags);
+    W16BE(p + 2, (u16)count);
+    W32BE(p + 4, (u32)frame);
+
+    config.sink(config.context, packet.data(), (long)packet.size());
+}
+
+ErrorCode
+Streamer::receive(C64 &c64, const u8 *data, usize size)
+{
+    InputEvent events[64];
+
+    if (size < headerSize || R8BE(data) != inputPacket) {
+
+        rejectedPackets++;
+        return ERROR_FILE_TYPE_MISMATCH;
+    }
+
+    usize count = R16BE(data + 2);
+    if (count > 64 || size != headerSize + count * eventSize) {
+
+        rejectedPackets++;
+        return ERROR_FILE_TYPE_MISMATCH;
+    }
+
+    // Decode and verify all events before submitting any of them
+    for (usize i = 0; i < count; i++) {
+
+        const u8 *p = data + headerSize + i * eventSize;
+        auto type = (InputEventType)R8BE(p);
+
+        switch (type) {
+
+            case INPUT_EVENT_PRESS_KEY:
+            case INPUT_EVENT_RELEASE_KEY:
+            case INPUT_EVENT_RELEASE_KEYS:
+            case INPUT_EVENT_JOYSTICK:
+            case INPUT_EVENT_MOUSE:
+            case INPUT_EVENT_MOUSE_MOVE:
+                break;
+
+            default:
+                rejectedPackets++;
+                return ERROR_FILE_TYPE_MISMATCH;
+        }
+
+        events[i].cycle = 0;
+        events[i].type = type;
+        events[i].port = (PortId)R8BE(p + 1);
+        events[i].data = (long)R16BE(p + 2);
+        events[i].x = (long)(i16)R16BE(p + 4);
+        events[i].y = (long)(i16)R16BE(p + 6);
+    }
+
+    inputEvents += c64.inputs.submit(events, count);
+    return ERROR_OK;
+}
+
+StreamStats
+Streamer::getStats() const
+{
+    StreamStats result = stats;
+
+    result.inputEvents = inputEvents;
+    result.rejectedPackets = rejectedPackets;
+
+    return result;
+}
@@ -0,0 +1,167 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include "SIDStreams.h"
+#include <atomic>
+#include <vector>
+
+/* Encodes the emulator output for remote clients. At the end of each frame,
+ * the streamer compares the color indices of the visible area line by line
+ * with the previously sent frame and emits the changed lines only. The audio
+ * samples of the frame are taken from an additional SID output and are
+ * compressed with IMA ADPCM (4 bits per sample). The packets are handed over
+ * to a callback which is responsible for transmitting them. Input packets
+ * sent by the client are fed into the input queue.
+ *
+ * All packets are encoded in network byte order and start with a header:
+ *
+ *     u8  type    Packet type (see below)
+ *     u8  flags   Packet specific flags
+ *     u16 count   Number of lines, samples, or events
+ *     u32 frame   Frame number (lower 32 bits)
+ *
+ * Video packets (type 1). Flag 0 marks a key frame which contains all lines.
+ * Flag 1 indicates that a palette of 256 RGBA values (u32 each) follows the
+ * header. The palette is sent with the first frame and whenever it changes.
+ * Next comes the size of the visible area (u16 width, u16 height), followed
+ * by count lines. Each line consists of its number (u16), the size of the
+ * payload (u16), and the run-length encoded color indices. Each run is
+ * encoded as a pair of bytes (length, color index).
+ *
+ * Audio packets (type 2). The header is followed by the initial state of the
+ * ADPCM decoder (i16 predictor, u8 step index, u8 unused) and count mono
+ * samples packed into nibbles (low nibble first).
+ *
+ * Input packets (type 3, sent by the client). The header is followed by count
+ * events of 8 bytes each (u8 type, u8 port, u16 data, i16 x, i16 y). Only key,
+ * joystick, and mouse events are accepted. The events take effect as soon as
+ * possible. The frame number of an input packet is ignored.
+ */
+class Streamer {
+
+public:
+
+    // Packet types
+    static const u8 videoPacket = 1;
+    static const u8 audioPacket = 2;
+    static const u8 inputPacket = 3;
+
+    // Packet flags
+    static const u8 keyFrameFlag = 0x01;
+    static const u8 paletteFlag = 0x02;
+
+    // Size of the packet header and of an input event
+    static const usize headerSize = 8;
+    static const usize eventSize = 8;
+
+private:
+
+    // The current configuration
+    StreamConfig config = { };
+
+    // Color indices of the previously sent frame and the number of its lines
+    std::vector<u8> sent;
+    isize sentHeight = 0;
+
+    // The previously sent palette
+    u32 sentLut[256] = { };
+    bool lutValid = false;
+
+    // Frames since the last key frame and pending key frame requests
+    u64 framesSinceKey = 0;
+    std::atomic<bool> keyRequested {false};
+
+    // Additional SID output feeding the audio stream (-1 = none)
+    isize output = -1;
+
+    // State of the ADPCM encoder
+    i32 predictor = 0;
+    i32 stepIndex = 0;
+
+    // Scratch buffers
+    std::vector<u8> packet;
+    std::vector<SamplePair> samples;
+
+    // Statistics
+    StreamStats stats = { };
+    std::atomic<u64> inputEvents {0};
+    std::atomic<u64> rejectedPackets {0};
+
+
+    //
+    // Configuring
+    //
+
+public:
+
+    /* Starts or stops streaming. Both functions must be called while the
+     * emulator is suspended.
+     */
+    ErrorCode start(class C64 &c64, const StreamConfig &config);
+    void stop(class C64 &c64);
+
+    bool isEnabled() const { return config.sink != nullptr; }
+
+    // Requests a key frame, e.g., after a client has (re)connected
+    void requestKeyFrame() { keyRequested = true; }
+
+
+    //
+    // Encoding (emulator thread)
+    //
+
+public:
+
+    /* Encodes the visible area of a completed frame. The texture must consist
+     * of color indices which are translated with the provided lookup table.
+     */
+    void addFrame(u64 frame, const u8 *texture, const u32 *lut, isize height);
+
+    // Reports a frame that couldn't be encoded, because it wasn't indexed
+    void skipFrame() { stats.skippedFrames++; }
+
+    // Encodes all audio samples produced since the previous call
+    void addAudio(class C64 &c64);
+
+private:
+
+    // Appends the run-length encoded color indices of a line to the packet
+    void encodeLine(const u8 *line);
+
+    // Compresses a single sample and returns the 4 bit code
+    u8 encodeSample(i32 sample);
+
+    // Writes the packet header and hands the packet over to the sink
+    void send(u8 type, u8 flags, usize count, u64 frame);
+
+
+    //
+    // Decoding (any thread)
+    //
+
+public:
+
+    /* Processes a packet sent by the client. Input events are submitted to the
+     * input queue of the emulator. Hence, the function must be called on the
+     * thread that submits all other input events.
+     */
+    ErrorCode receive(class C64 &c64, const u8 *data, usize size);
+
+
+    //
+    // Analyzing
+    //
+
+public:
+
+    StreamStats getStats() const;
+};
@@ -9,8 +9,20 @@
 
 #pragma once
 
+#include <cstring>
+#include <type_traits>
+
 template <class T, int capacity> class TimeDelayed {
     
+    /* Indicates if the pipeline fits into a single machine word. In this
+     * case, the pipeline is shifted with a few word operations instead of
+     * an element-wise loop. The pipeline is stored as an array in both cases
+     * to keep the snapshot format unchanged.
+     */
+    static constexpr bool packed =
+    std::is_integral<T>::value && sizeof(T) * capacity <= sizeof(u64) &&
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+    
     /* Value pipeline (history buffer)
      *
      *    pipeline[0] : Value that was written at time timeStamp
@@ -86,7 +98,13 @@ public:
         
         // Shift pipeline
         i64 diff = referenceTime - timeStamp;
-        for (int i = capacity - 1; i >= 0; i--) {
+        if constexpr (packed) {
+            if (diff >= 0) {
+                shiftPacked(diff);
+                diff = 0;
+            }
+        }
+        for (int i = capacity - 1; i >= 0 && diff; i--) {
             assert((i - diff <= 0) || (i - diff <= capacity));
             pipeline[i] = (i - diff > 0) ? pipeline[i - diff] : pipeline[0];
         }
@@ -96,6 +114,42 @@ public:
         pipeline[0] = value;
     }
     
+private:
+    
+    // Shifts a packed pipeline by the specified number of cycles
+    void shiftPacked(i64 diff) {
+        
+        constexpr int bits = 8 * sizeof(T);
+        constexpr u64 mask = bits < 64 ? (1ULL << (bits % 64)) - 1 : ~0ULL;
+
+        // Factor replicating a single element into all pipeline slots
+        constexpr u64 spread = [] {
+            u64 result = 0;
+            for (int i = 0; i < capacity; i++) result |= 1ULL << (i * bits % 64);
+            return result;
+        }();
+        
+        u64 word = 0;
+        memcpy(&word, pipeline, sizeof(pipeline));
+        u64 fill = (word & mask) * spread;
+        
+        if (diff >= capacity - 1) {
+            
+            // All slots receive the most recent value
+            word = fill;
+            
+        } else {
+            
+            // Move all slots up and fill the gap with the most recent value
+            u64 gap = (1ULL << ((diff + 1) * bits)) - 1;
+            word = ((word << (diff * bits)) & ~gap) | (fill & gap);
+        }
+        
+        memcpy(pipeline, &word, sizeof(pipeline));
+    }
+    
+public:
+    
     // Reads the most recent pipeline element
     T current() const { return pipeline[0]; }
     
@@ -0,0 +1,191 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+
+void
+UndoJournal::configure(C64 &c64, isize value)
+{
+    assert(value >= 0 && value <= maxCapacity);
+    capacity = value;
+    
+    if (capacity == 0) {
+        
+        setRecording(c64, false);
+        clear();
+        return;
+    }
+    
+    while ((isize)records.size() > capacity) {
+        
+        writes.erase(writes.begin(), writes.begin() + records.front().writes);
+        records.pop_front();
+    }
+    
+    if (!recording) {
+        
+        setRecording(c64, true);
+        takeKeyframe(c64);
+    }
+}
+
+void
+UndoJournal::clear()
+{
+    records.clear();
+    writes.clear();
+    keyframes.clear();
+}
+
+void
+UndoJournal::recordInstruction(C64 &c64)
+{
+    u64 cycle = c64.cpu.cycle;
+    
+    // Discard the records of a different timeline (e.g., after a restore)
+    if (!records.empty() && records.back().cycle >= cycle) truncate(cycle);
+    
+    Record record;
+    record.reg = c64.cpu.reg;
+    record.reg.pc = record.reg.pc0;
+    record.cycle = cycle;
+    record.writes = 0;
+    record.io = false;
+    records.push_back(record);
+    
+    if ((isize)records.size() > capacity) {
+        
+        writes.erase(writes.begin(), writes.begin() + records.front().writes);
+        records.pop_front();
+    }
+}
+
+void
+UndoJournal::recordKeyframe(C64 &c64)
+{
+    // Changes made outside the CPU at the end of a frame aren't journaled
+    recordIO();
+    takeKeyframe(c64);
+}
+
+void
+UndoJournal::takeKeyframe(C64 &c64)
+{
+    u64 cycle = c64.cpu.cycle;
+    truncate(cycle + 1);
+    
+    Keyframe keyframe;
+    keyframe.cycle = cycle;
+    keyframe.state.take(c64, keyframes.empty() ? nullptr : &keyframes.back().state, false);
+    keyframes.push_back(std::move(keyframe));
+    
+    if ((isize)keyframes.size() > maxKeyframes) keyframes.pop_front();
+}
+
+isize
+UndoJournal::undoableInstructions() const
+{
+    isize count = (isize)records.size();
+    isize first = count;
+    
+    // Instructions without side effects can be undone via the journal
+    while (first > 0 && !records[first - 1].io) first--;
+    
+    // All other instructions require a preceding keyframe
+    if (!keyframes.empty()) {
+        
+        for (isize i = 0; i < first; i++) {
+            if (records[i].cycle > keyframes.front().cycle) { first = i; break; }
+        }
+    }
+    
+    return count - first;
+}
+
+bool
+UndoJournal::stepBack(C64 &c64, isize count)
+{
+    assert(!c64.isRunning());
+    
+    if (count <= 0 || count > (isize)records.size()) return count == 0;
+    
+    usize target = records.size() - count;
+    Record record = records[target];
+    
+    // Check if the instructions can be undone via the journal
+    bool cheap = c64.cpu.inFetchPhase();
+    for (usize i = target; cheap && i < records.size(); i++) cheap = !records[i].io;
+    
+    if (cheap) {
+        
+        // Restore the RAM cells in reverse order
+        while (records.size() > target) {
+            
+            for (u32 n = popRecord(); n > 0; n--) {
+                
+                c64.mem.ram[writes.back().addr] = writes.back().value;
+                c64.mem.markDirty(writes.back().addr, 1);
+                writes.pop_back();
+            }
+        }
+        c64.cpu.reg = record.reg;
+        
+        // Keyframes taken after the target instruction are outdated now
+        while (!keyframes.empty() && keyframes.back().cycle >= record.cycle) {
+            keyframes.pop_back();
+        }
+        takeKeyframe(c64);
+        return true;
+    }
+    
+    // Search the most recent keyframe preceding the target instruction
+    auto keyframe = keyframes.rbegin();
+    while (keyframe != keyframes.rend() && keyframe->cycle >= record.cycle) keyframe++;
+    if (keyframe == keyframes.rend() || !keyframe->state.matches(c64)) return false;
+    
+    // Restore the keyframe and run until the target instruction is fetched
+    setRecording(c64, false);
+    keyframe->state.restore(c64);
+    c64.drivesLag = 0;
+    c64.rescheduleEvents();
+    while (c64.cpu.cycle + 1 < record.cycle) c64.executeOneCycle();
+    setRecording(c64, true);
+    
+    // Breakpoints and watchpoints hit while replaying are ignored
+    c64.clearActionFlags(ACTION_FLAG_BREAKPOINT | ACTION_FLAG_WATCHPOINT);
+    
+    truncate(record.cycle);
+    return true;
+}
+
+void
+UndoJournal::setRecording(C64 &c64, bool value)
+{
+    recording = value;
+    c64.mem.setJournaling(value);
+}
+
+void
+UndoJournal::truncate(u64 cycle)
+{
+    while (!records.empty() && records.back().cycle >= cycle) {
+        writes.erase(writes.end() - popRecord(), writes.end());
+    }
+    while (!keyframes.empty() && keyframes.back().cycle >= cycle) {
+        keyframes.pop_back();
+    }
+}
+
+u32
+UndoJournal::popRecord()
+{
+    u32 result = records.back().writes;
+    records.pop_back();
+    return result;
+}
@@ -0,0 +1,159 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include "CPUPublicTypes.h"
+#include "IncrementalState.h"
+#include <deque>
+
+/* Lets the debugger step backwards. While the journal is enabled, a record
+ * is created for each instruction fetched by the CPU. It stores the register
+ * file before the instruction and the old values of all RAM cells written by
+ * the instruction. In addition, a keyframe of the entire emulator state is
+ * taken at the end of each frame (see IncrementalState).
+ *
+ * Stepping backwards is done in one of two ways:
+ *
+ *   - If none of the undone instructions has accessed the I/O space, the
+ *     processor port, or a cartridge, and no interrupt has been taken, the
+ *     registers and RAM cells are restored from the journal. The other
+ *     components keep their state and the clock keeps running, i.e., the
+ *     CPU re-executes the undone instructions in later cycles.
+ *
+ *   - Otherwise, the nearest keyframe preceding the target instruction is
+ *     restored and the emulator is run cycle by cycle until the target
+ *     instruction is about to be fetched. This restores the I/O state, too.
+ *
+ * Both the number of records and the number of keyframes are bounded. The
+ * oldest entries are discarded first.
+ */
+class UndoJournal {
+    
+    struct Record {
+        
+        // CPU registers before the instruction has been executed
+        Registers reg;
+        
+        // Cycle of the opcode fetch
+        u64 cycle;
+        
+        // Number of RAM cells written by the instruction
+        u32 writes;
+        
+        // Indicates if the instruction has caused side effects outside RAM
+        bool io;
+    };
+    
+    struct Write {
+        
+        // Address and old value of a RAM cell
+        u16 addr;
+        u8 value;
+    };
+    
+    struct Keyframe {
+        
+        // Cycle the state has been taken in
+        u64 cycle;
+        
+        // The emulator state
+        IncrementalState state;
+    };
+    
+    // Maximum number of records (0 = off) and keyframes
+    isize capacity = 0;
+    static constexpr isize maxKeyframes = 16;
+    
+public:
+    
+    // Upper bound for the capacity (a few seconds of emulated time)
+    static constexpr isize maxCapacity = 1024 * 1024;
+    
+private:
+    
+    // Indicates if instructions are recorded
+    bool recording = false;
+    
+    // Recorded instructions, RAM writes, and keyframes (oldest first)
+    std::deque<Record> records;
+    std::deque<Write> writes;
+    std::deque<Keyframe> keyframes;
+    
+    
+    //
+    // Configuring
+    //
+    
+public:
+    
+    // Sets the maximum number of recorded instructions (0 disables the journal)
+    void configure(class C64 &c64, isize capacity);
+    isize getCapacity() const { return capacity; }
+    
+    // Discards all records and keyframes
+    void clear();
+    
+    
+    //
+    // Recording (emulator thread)
+    //
+    
+public:
+    
+    bool isRecording() const { return recording; }
+    
+    // Called by the CPU in the fetch phase
+    void recordInstruction(class C64 &c64);
+    
+    // Called by the memory before a RAM cell is overwritten
+    void recordWrite(u16 addr, u8 value) {
+        if (!records.empty()) {
+            writes.push_back(Write { addr, value });
+            records.back().writes++;
+        }
+    }
+    
+    // Called on accesses with side effects outside RAM and on interrupts
+    void recordIO() { if (!records.empty()) records.back().io = true; }
+    
+    // Called at the end of each frame
+    void recordKeyframe(class C64 &c64);
+    
+    
+    //
+    // Stepping backwards
+    //
+    
+public:
+    
+    // Returns the number of instructions that can be undone
+    isize undoableInstructions() const;
+    
+    /* Undoes the specified number of instructions. The emulator must be
+     * paused. The function returns false if the journal doesn't reach back
+     * far enough.
+     */
+    bool stepBack(class C64 &c64, isize count);
+    
+private:
+    
+    // Enables or disables the hooks in the CPU and the memory
+    void setRecording(class C64 &c64, bool value);
+    
+    // Records the current emulator state
+    void takeKeyframe(class C64 &c64);
+    
+    // Discards all records and keyframes from the specified cycle on
+    void truncate(u64 cycle);
+    
+    // Removes the most recent record and returns the number of its writes
+    u32 popRecord();
+};
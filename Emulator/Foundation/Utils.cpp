@@ -10,6 +10,8 @@
 #include "Utils.h"
 
 #include <ctype.h>
+#include <sys/mman.h>
+#include <vector>
 
 bool
 releaseBuild()
@@ -259,6 +261,72 @@ streamLength(std::istream &stream)
     return (usize)(end - beg);
 }
 
+MemoryBuffer::MemoryBuffer(const u8 *buf, usize len)
+{
+    auto begin = (char *)buf;
+    setg(begin, begin, begin + len);
+}
+
+MemoryBuffer::pos_type
+MemoryBuffer::seekoff(off_type off, std::ios_base::seekdir dir,
+                      std::ios_base::openmode which)
+{
+    if (!(which & std::ios_base::in)) return pos_type(off_type(-1));
+    
+    off_type base =
+    dir == std::ios_base::beg ? 0 :
+    dir == std::ios_base::cur ? gptr() - eback() : egptr() - eback();
+    
+    off_type pos = base + off;
+    if (pos < 0 || pos > egptr() - eback()) return pos_type(off_type(-1));
+    
+    setg(eback(), eback() + pos, egptr());
+    return pos_type(pos);
+}
+
+MemoryBuffer::pos_type
+MemoryBuffer::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+MemoryStream::MemoryStream(const u8 *buf, usize len) :
+MemoryBuffer(buf, len), std::istream(this)
+{
+    buffer = (u8 *)buf;
+    length = len;
+    owner = false;
+    mapped = false;
+}
+
+MemoryStream::MemoryStream(u8 *buf, usize len, bool adopt, bool mapped) :
+MemoryBuffer(buf, len), std::istream(this)
+{
+    buffer = buf;
+    length = len;
+    owner = adopt;
+    this->mapped = mapped;
+}
+
+MemoryStream::~MemoryStream()
+{
+    if (!owner) return;
+    
+    if (mapped) {
+        munmap(buffer, length);
+    } else {
+        delete [] buffer;
+    }
+}
+
+u8 *
+MemoryStream::release()
+{
+    assert(owner);
+    owner = false;
+    return buffer;
+}
+
 u32
 fnv_1a_32(const u8 *addr, usize size)
 {
@@ -312,3 +380,119 @@ crc32forByte(u32 r)
         r = (r & 1? 0: (u32)0xEDB88320L) ^ r >> 1;
     return r ^ (u32)0xFF000000L;
 }
+
+static void
+lz4PutLength(u8 *&out, usize length)
+{
+    for (; length >= 255; length -= 255) *out++ = 255;
+    *out++ = (u8)length;
+}
+
+static bool
+lz4GetLength(const u8 *&in, const u8 *end, usize &length)
+{
+    u8 byte;
+    do {
+        if (in == end) return false;
+        length += (byte = *in++);
+    } while (byte == 255);
+    return true;
+}
+
+usize
+lz4Compress(const u8 *src, usize size, u8 *dst)
+{
+    // Constraints imposed by the block format
+    const usize minMatch = 4, lastLiterals = 5, matchLimit = 12;
+    const isize hashBits = 14;
+
+    auto read32 = [&](usize i) { u32 v; memcpy(&v, src + i, 4); return v; };
+    auto hash = [&](u32 v) { return (v * 2654435761U) >> (32 - hashBits); };
+
+    std::vector<u32> table(1 << hashBits, 0);
+    u8 *out = dst;
+    usize anchor = 0;
+
+    for (usize i = 0; i + matchLimit < size; ) {
+
+        u32 seq = read32(i);
+        u32 ref = table[hash(seq)];
+        table[hash(seq)] = (u32)i;
+
+        if (ref >= i || i - ref > 0xFFFF || read32(ref) != seq) {
+
+            // Speed up the search in incompressible areas
+            i += 1 + ((i - anchor) >> 6);
+            continue;
+        }
+
+        // Extend the match
+        usize length = minMatch;
+        usize maxLength = size - lastLiterals - i;
+        while (length < maxLength && src[ref + length] == src[i + length]) length++;
+
+        // Emit the sequence
+        usize literals = i - anchor;
+        u8 *token = out++;
+        *token = (u8)(MIN(literals, 15) << 4 | MIN(length - minMatch, 15));
+        if (literals >= 15) lz4PutLength(out, literals - 15);
+        memcpy(out, src + anchor, literals);
+        out += literals;
+        *out++ = (u8)(i - ref);
+        *out++ = (u8)((i - ref) >> 8);
+        if (length - minMatch >= 15) lz4PutLength(out, length - minMatch - 15);
+
+        i += length;
+        anchor = i;
+    }
+
+    // Emit the remaining bytes as literals
+    usize literals = size - anchor;
+    *out++ = (u8)(MIN(literals, 15) << 4);
+    if (literals >= 15) lz4PutLength(out, literals - 15);
+    memcpy(out, src + anchor, literals);
+    out += literals;
+
+    return (usize)(out - dst);
+}
+
+bool
+lz4Decompress(const u8 *src, usize size, u8 *dst, usize capacity)
+{
+    const u8 *in = src, *end = src + size;
+    usize pos = 0;
+
+    while (in < end) {
+
+        u8 token = *in++;
+
+        // Copy literals
+        usize literals = token >> 4;
+        if (literals == 15 && !lz4GetLength(in, end, literals)) return false;
+        if (literals > (usize)(end - in) || literals > capacity - pos) return false;
+        memcpy(dst + pos, in, literals);
+        in += literals;
+        pos += literals;
+
+        // The last sequence consists of literals only
+        if (in == end) break;
+
+        // Copy the match
+        if (end - in < 2) return false;
+        usize offset = in[0] | in[1] << 8;
+        in += 2;
+        usize length = token & 15;
+        if (length == 15 && !lz4GetLength(in, end, length)) return false;
+        length += 4;
+        if (offset == 0 || offset > pos || length > capacity - pos) return false;
+
+        if (offset >= length) {
+            memcpy(dst + pos, dst + pos - offset, length);
+        } else {
+            for (usize i = 0; i < length; i++) dst[pos + i] = dst[pos + i - offset];
+        }
+        pos += length;
+    }
+
+    return pos == capacity;
+}
@@ -185,6 +185,68 @@ bool loadFile(const std::string &path, const std::string &name, u8 **bufptr, lon
 
 usize streamLength(std::istream &stream);
 
+// Stream buffer reading from a memory region without copying it
+class MemoryBuffer : public std::streambuf {
+
+public:
+
+    MemoryBuffer(const u8 *buf, usize len);
+
+protected:
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode which) override;
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+};
+
+/* Input stream reading from a memory region without copying it. Optionally,
+ * the stream owns the memory region which must have been allocated with new[]
+ * or mapped with mmap(). A reader can take over the ownership by calling
+ * release().
+ */
+class MemoryStream : private MemoryBuffer, public std::istream {
+
+    u8 *buffer;
+    usize length;
+    bool owner;
+    bool mapped;
+
+public:
+
+    MemoryStream(const u8 *buf, usize len);
+    MemoryStream(u8 *buf, usize len, bool adopt, bool mapped = false);
+    ~MemoryStream();
+
+    const u8 *getBuffer() const { return buffer; }
+    usize getLength() const { return length; }
+
+    // Indicates if the memory region is owned by this stream
+    bool isOwner() const { return owner; }
+
+    // Indicates if the memory region is a memory mapping
+    bool isMapped() const { return mapped; }
+
+    // Hands over the ownership of the memory region to the caller
+    u8 *release();
+};
+
+
+//
+// Generating random numbers
+//
+
+/* Xorshift pseudo random number generator. In contrast to rand(), the state
+ * is owned by the caller. Hence, multiple emulator instances running on
+ * different threads don't interfere with each other.
+ */
+inline u32 xorshift32(u32 &state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
 
 //
 // Computing checksums
@@ -205,3 +267,21 @@ u64 fnv_1a_64(const u8 *addr, usize size);
 // Computes a CRC-32 checksum for a given buffer
 u32 crc32(const u8 *addr, usize size);
 u32 crc32forByte(u32 r);
+
+
+//
+// Compressing data
+//
+
+// Returns the maximum size of a compressed buffer
+inline usize lz4Bound(usize size) { return size + size / 255 + 16; }
+
+/* Compresses a buffer in the LZ4 block format. The target buffer must hold
+ * at least lz4Bound(size) bytes. The function returns the compressed size.
+ */
+usize lz4Compress(const u8 *src, usize size, u8 *dst);
+
+/* Decompresses an LZ4 block. The function returns false if the block is
+ * malformed or doesn't decompress to exactly 'capacity' bytes.
+ */
+bool lz4Decompress(const u8 *src, usize size, u8 *dst, usize capacity);
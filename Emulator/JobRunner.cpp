@@ -0,0 +1,339 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "JobRunner.h"
+#include "C64.h"
+#include "C64Headless.h"
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+
+// Number of frames emulated by powerOn() (taken from the boot cache)
+static const u64 bootFrames = 150;
+
+// Splits a manifest line into its tab separated fields
+static std::vector<string>
+split(const string &line)
+{
+    std::vector<string> result;
+    std::stringstream stream(line);
+    string field;
+
+    while (std::getline(stream, field, '\t')) {
+        if (!field.empty()) result.push_back(field);
+    }
+    return result;
+}
+
+// Converts a path relative to the manifest directory (empty if unused)
+static string
+resolve(const string &dir, const string &path)
+{
+    if (path == "-") return "";
+    if (path[0] == '/' || dir.empty()) return path;
+    return dir + "/" + path;
+}
+
+// Parses a number in the given base
+static bool
+parse(const string &s, int base, u64 &value)
+{
+    if (s.empty()) return false;
+
+    char *end;
+    value = strtoull(s.c_str(), &end, base);
+    return *end == 0;
+}
+
+// Formats a state hash
+static string
+hex(u64 value)
+{
+    std::stringstream stream;
+    stream << std::hex << std::setw(16) << std::setfill('0') << value;
+    return stream.str();
+}
+
+JobRunner::~JobRunner()
+{
+    for (auto rom : roms) delete rom;
+}
+
+void
+JobRunner::loadRom(const string &path)
+{
+    roms.push_back(AnyFile::make <RomFile> (path));
+}
+
+void
+JobRunner::loadManifest(const string &path)
+{
+    std::ifstream in(path);
+    if (!in.is_open()) throw VC64Error(ERROR_FILE_NOT_FOUND);
+
+    auto idx = path.rfind('/');
+    string dir = idx != std::string::npos ? path.substr(0, idx) : "";
+
+    std::vector<Job> result;
+    string line;
+
+    while (std::getline(in, line)) {
+
+        if (line.empty() || line[0] == '#') continue;
+
+        auto fields = split(line);
+        if (fields.empty()) continue;
+
+        Job job;
+
+        if (fields.size() < 5) throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+        if (!parse(fields[4], 10, job.frames) || job.frames == 0) {
+            throw VC64Error(ERROR_FILE_TYPE_MISMATCH);
+        }
+
+        job.name = fields[0];
+        job.media = resolve(dir, fields[1]);
+        job.snapshot = resolve(dir, fields[2]);
+        job.inputLog = resolve(dir, fields[3]);
+        job.assertions.assign(fields.begin() + 5, fields.end());
+
+        result.push_back(job);
+    }
+
+    jobs = std::move(result);
+}
+
+void
+JobRunner::run(isize shard, isize shards, isize numThreads, const string &snapshots)
+{
+    assert(shards > 0 && shard >= 0 && shard < shards);
+
+    // Select the jobs of this shard
+    std::vector<const Job *> selected;
+    for (usize i = shard; i < jobs.size(); i += shards) selected.push_back(&jobs[i]);
+
+    // Each thread grabs the next unprocessed job until all jobs are done
+    std::vector<Result> result(selected.size());
+    std::atomic<usize> next(0);
+
+    auto job = [&]() {
+
+        for (usize i = next++; i < selected.size(); i = next++) {
+            result[i] = run(*selected[i], snapshots);
+        }
+    };
+
+    numThreads = std::max(numThreads, (isize)1);
+    std::unique_ptr<WorkerThread[]> workers(new WorkerThread[numThreads]);
+    for (isize i = 0; i < numThreads; i++) workers[i].run(job);
+    for (isize i = 0; i < numThreads; i++) workers[i].join();
+
+    results = std::move(result);
+}
+
+JobRunner::Result
+JobRunner::run(const Job &job, const string &snapshots)
+{
+    Result result;
+    result.name = job.name;
+
+    std::unique_ptr<C64> c64(vc64_new());
+    for (auto rom : roms) c64->installRom(rom);
+
+    result.problem = setup(*c64, job);
+    if (!result.problem.empty()) return result;
+
+    // Emulate the job
+    HeadlessBudget budget = { };
+    budget.frames = job.frames;
+
+    u64 frame = c64->frame;
+    u64 cycle = c64->cpu.cycle;
+
+    result.exit = vc64_run(c64.get(), &budget);
+    result.frames = c64->frame - frame;
+    result.cycles = c64->cpu.cycle - cycle;
+    result.hash = vc64_state_hash(c64.get());
+
+    // Check the assertions
+    for (auto &assertion : job.assertions) {
+
+        string problem = check(*c64, result, assertion);
+        if (problem.empty()) continue;
+
+        if (!result.problem.empty()) result.problem += "; ";
+        result.problem += problem;
+    }
+    result.status = result.problem.empty() ? Status::pass : Status::fail;
+
+    // Save the final state
+    if (!snapshots.empty()) {
+
+        string problem = save(*c64, snapshots + "/" + job.name + ".vc64");
+        if (!problem.empty()) {
+
+            result.status = Status::error;
+            result.problem = problem;
+        }
+    }
+
+    return result;
+}
+
+string
+JobRunner::setup(C64 &c64, const Job &job)
+{
+    ErrorCode err;
+
+    if (!c64.isReady(&err)) return string("ERROR_") + ErrorCodeEnum::key(err);
+
+    // Let the guest signal the end of the test if its exit code is checked
+    for (auto &assertion : job.assertions) {
+        if (assertion.rfind("exit=", 0) == 0) c64.configure(OPT_DEBUG_PORT, true);
+    }
+
+    string suffix = extractSuffix(job.media);
+    for (auto &c : suffix) c = (char)tolower(c);
+
+    // Cartridges are attached while the machine is powered off
+    if (suffix == "crt") {
+
+        std::unique_ptr<CRTFile> crt(AnyFile::make <CRTFile> (job.media, &err));
+        if (!crt) return "Can't read " + job.media;
+        if (!c64.expansionport.attachCartridge(crt.get(), false)) {
+            return "Can't attach " + job.media;
+        }
+    }
+
+    // Bring the machine into its initial state
+    if (!job.snapshot.empty()) {
+
+        err = vc64_load_snapshot(&c64, job.snapshot.c_str());
+        if (err != ERROR_OK) return string("ERROR_") + ErrorCodeEnum::key(err);
+
+    } else {
+
+        vc64_set_boot_cache(&c64, bootFrames);
+        err = vc64_power_on(&c64);
+        if (err != ERROR_OK) return string("ERROR_") + ErrorCodeEnum::key(err);
+    }
+
+    // Insert the media file
+    err = ERROR_OK;
+    if (suffix == "d64" || suffix == "g64") {
+        err = vc64_insert_disk(&c64, DRIVE8, job.media.c_str());
+    } else if (suffix == "tap") {
+        err = vc64_insert_tape(&c64, job.media.c_str());
+    } else if (suffix == "prg" || suffix == "p00" || suffix == "t64") {
+        err = vc64_flash_file(&c64, job.media.c_str());
+    } else if (!job.media.empty() && suffix != "crt") {
+        err = ERROR_FILE_TYPE_MISMATCH;
+    }
+    if (err != ERROR_OK) return string("ERROR_") + ErrorCodeEnum::key(err);
+
+    // Replay the input log from its initial state
+    if (!job.inputLog.empty()) {
+
+        err = vc64_load_input_log(&c64, job.inputLog.c_str());
+        if (err != ERROR_OK) return string("ERROR_") + ErrorCodeEnum::key(err);
+        vc64_start_input_replay(&c64);
+    }
+
+    return "";
+}
+
+string
+JobRunner::check(C64 &c64, const Result &result, const string &assertion)
+{
+    auto idx = assertion.find('=');
+    if (idx == std::string::npos) return "Invalid assertion " + assertion;
+
+    string key = assertion.substr(0, idx);
+    string value = assertion.substr(idx + 1);
+    u64 expected;
+
+    if (key == "hash") {
+
+        if (!parse(value, 16, expected)) return "Invalid assertion " + assertion;
+        if (result.hash != expected) return "hash is " + hex(result.hash);
+        return "";
+    }
+    if (key.rfind("mem:", 0) == 0) {
+
+        u64 addr;
+        if (!parse(key.substr(4), 16, addr) || addr > 0xFFFF ||
+            !parse(value, 16, expected)) return "Invalid assertion " + assertion;
+
+        u8 actual = c64.mem.ram[addr];
+        if (actual != expected) {
+
+            std::stringstream stream;
+            stream << key << " is " << std::hex << std::setw(2) << std::setfill('0') << (int)actual;
+            return stream.str();
+        }
+        return "";
+    }
+    if (key == "screen") {
+
+        ScreenText text;
+        vc64_screen_text(&c64, &text);
+        if (!strstr(text.text, value.c_str())) return "screen lacks " + value;
+        return "";
+    }
+    if (key == "exit") {
+
+        long code = vc64_debug_exit_code(&c64);
+        if (std::to_string(code) != value) return "exit is " + std::to_string(code);
+        return "";
+    }
+    if (key == "stop") {
+
+        const char *reason = HeadlessExitEnum::key(result.exit);
+        if (value != reason) return string("stop is ") + reason;
+        return "";
+    }
+
+    return "Invalid assertion " + assertion;
+}
+
+string
+JobRunner::save(C64 &c64, const string &path)
+{
+    std::unique_ptr<Snapshot> snapshot(Snapshot::makeWithC64(&c64));
+
+    // Make the file independent of the host clock
+    snapshot->header()->timestamp = 0;
+
+    std::vector<u8> buffer;
+    if (!SnapshotWriter::writeCompressed(snapshot->data, snapshot->size, path, buffer)) {
+        return "Can't write " + path;
+    }
+    return "";
+}
+
+void
+JobRunner::writeToFile(const string &path) const
+{
+    std::ofstream out(path);
+    if (!out.is_open()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+
+    for (auto &result : results) {
+
+        out << result.name << '\t';
+        out << (result.status == Status::pass ? "PASS" :
+                result.status == Status::fail ? "FAIL" : "ERROR") << '\t';
+        out << result.frames << '\t';
+        out << result.cycles << '\t';
+        out << HeadlessExitEnum::key(result.exit) << '\t';
+        out << hex(result.hash) << '\t';
+        out << result.problem << '\n';
+    }
+
+    if (!out.good()) throw VC64Error(ERROR_FILE_CANT_WRITE);
+}
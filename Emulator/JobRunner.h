@@ -0,0 +1,159 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Object.h"
+#include "C64Types.h"
+
+/* Runs a regression suite described by a manifest. Each job runs on a fresh
+ * headless instance and the jobs are distributed over a pool of threads. A
+ * suite can be split into shards which are run on different machines. Shard
+ * k of n runs the jobs whose index modulo n equals k. Since the emulation
+ * doesn't depend on the host, all shards produce the same results as a
+ * single machine running the whole suite. Their reports can be concatenated.
+ *
+ * The manifest is a text file with one job per line. Empty lines and lines
+ * starting with '#' are ignored. Each line consists of tab separated fields:
+ *
+ *     name  media  snapshot  input log  frames  assertion ...
+ *
+ * Unused fields are marked with '-'. Relative paths refer to the directory of
+ * the manifest. The media file is a D64, G64, TAP, CRT, PRG, P00, or T64
+ * file. If a snapshot is given, the job starts in the stored state instead of
+ * powering on the machine. Snapshots may be compressed. If an input log is
+ * given, it is replayed from its initial state. The job emulates the given
+ * number of frames or stops earlier if the guest signals an exit via the
+ * debug port. Afterwards, the assertions are checked:
+ *
+ *     hash=<hex>           The state hash equals the given value
+ *     mem:<addr>=<hex>     The RAM cell at the given address (hex) has the value
+ *     screen=<text>        The text screen contains the given text
+ *     exit=<code>          The guest has exited with the given code
+ *     stop=<reason>        The run has ended for the given reason (HeadlessExit)
+ *
+ * The report is stored as a text file. Each job is described by a line of tab
+ * separated values (name, status, frames, cycles, stop reason, state hash,
+ * problem). The status is PASS, FAIL, or ERROR. The problem lists the failed
+ * assertions or the reason why the job couldn't be set up.
+ *
+ * If a snapshot directory is given, the final state of each job is stored in
+ * compressed form as <name>.vc64. The creation date is cleared, so equal
+ * states result in equal files on all machines.
+ */
+class JobRunner : C64Object {
+
+public:
+
+    struct Job {
+
+        string name;
+
+        // Media file, snapshot, and input log (empty if unused)
+        string media;
+        string snapshot;
+        string inputLog;
+
+        // Number of frames to emulate
+        u64 frames = 0;
+
+        std::vector<string> assertions;
+    };
+
+    enum class Status { pass, fail, error };
+
+    struct Result {
+
+        string name;
+        Status status = Status::error;
+
+        // Emulated frames and cycles
+        u64 frames = 0;
+        u64 cycles = 0;
+
+        // Reason for ending the run and the final state hash
+        HeadlessExit exit = HEADLESS_EXIT_FRAME_LIMIT;
+        u64 hash = 0;
+
+        // Failed assertions or the reason for an error
+        string problem;
+    };
+
+private:
+
+    // Roms installed in each instance
+    std::vector<class RomFile *> roms;
+
+    // Jobs of the manifest
+    std::vector<Job> jobs;
+
+    // Results of the most recent run
+    std::vector<Result> results;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    ~JobRunner();
+    const char *getDescription() const override { return "JobRunner"; }
+
+    // Loads a Rom which is installed in each instance
+    void loadRom(const string &path) throws;
+
+    // Reads the jobs from a manifest file
+    void loadManifest(const string &path) throws;
+
+
+    //
+    // Running
+    //
+
+public:
+
+    /* Runs all jobs of a shard with the specified number of threads. The
+     * final states are saved in the snapshot directory if it isn't empty.
+     */
+    void run(isize shard, isize shards, isize numThreads, const string &snapshots);
+
+    // Runs a single job
+    Result run(const Job &job, const string &snapshots);
+
+private:
+
+    // Prepares an instance and returns a problem description on failure
+    string setup(class C64 &c64, const Job &job);
+
+    // Checks a single assertion and returns a problem description on failure
+    string check(class C64 &c64, const Result &result, const string &assertion);
+
+    // Saves the final state of a job
+    string save(class C64 &c64, const string &path);
+
+
+    //
+    // Querying
+    //
+
+public:
+
+    usize count() const { return results.size(); }
+    const Result &operator[](usize nr) const { return results[nr]; }
+
+
+    //
+    // Saving
+    //
+
+public:
+
+    void writeToFile(const string &path) const throws;
+};
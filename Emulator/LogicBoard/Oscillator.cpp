@@ -8,9 +8,17 @@
 // -----------------------------------------------------------------------------
 
 #include "C64.h"
+#include <errno.h>
+#include <time.h>
 
 Oscillator::Oscillator(C64& ref) : C64Component(ref)
 {
+    config.spinWindow = 500;
+    config.audioLatency = 0;
+    config.speed = 100;
+    config.powerSaving = 0;
+    clearStats();
+    
 #ifdef __MACH__
     mach_timebase_info(&tb);
 #endif
@@ -30,6 +38,163 @@ void
 Oscillator::_reset()
 {
     RESET_SNAPSHOT_ITEMS
+    
+    idleFrames = 0;
+    batchedFrames = 0;
+}
+
+long
+Oscillator::getConfigItem(Option option) const
+{
+    switch (option) {
+            
+        case OPT_SPIN_WINDOW:       return config.spinWindow;
+        case OPT_AUDIO_PACING:      return config.audioLatency;
+        case OPT_EMULATION_SPEED:   return config.speed;
+        case OPT_POWER_SAVING:      return config.powerSaving;
+
+        default:
+            assert(false);
+            return 0;
+    }
+}
+
+bool
+Oscillator::setConfigItem(Option option, long value)
+{
+    switch (option) {
+            
+        case OPT_SPIN_WINDOW:
+            
+            if (value < 0) {
+                warn("Invalid spin window: %ld\n", value);
+                return false;
+            }
+            if (config.spinWindow == value) return false;
+            
+            config.spinWindow = value;
+            return true;
+            
+        case OPT_AUDIO_PACING:
+            
+            // The target fill level plus one frame must fit into the stream
+            if (value < 0 || value > 200) {
+                warn("Invalid audio latency: %ld\n", value);
+                return false;
+            }
+            if (config.audioLatency == value) return false;
+            
+            suspend();
+            config.audioLatency = value;
+            sid.alignWritePtr();
+            restart();
+            resume();
+            return true;
+            
+        case OPT_EMULATION_SPEED:
+            
+            if (value < 25 || value > 800) {
+                warn("Invalid emulation speed: %ld\n", value);
+                return false;
+            }
+            if (config.speed == value) return false;
+            
+            suspend();
+            config.speed = value;
+            sid.setSpeed(value);
+            restart();
+            resume();
+            return true;
+            
+        case OPT_POWER_SAVING:
+            
+            // The batched frames plus the lookahead must fit into the stream
+            if (value < 0 || value > 8) {
+                warn("Invalid power saving policy: %ld\n", value);
+                return false;
+            }
+            if (config.powerSaving == value) return false;
+            
+            config.powerSaving = value;
+            return true;
+            
+        default:
+            return false;
+    }
+}
+
+void
+Oscillator::_dumpConfig() const
+{
+    msg("  Spin window : %ld usec\n", config.spinWindow);
+    msg("Audio latency : %ld msec%s\n", config.audioLatency,
+        isAudioPaced() ? "" : " (host clock pacing)");
+    msg("        Speed : %ld %%\n", config.speed);
+    msg(" Power saving : %ld\n", config.powerSaving);
+}
+
+OscillatorStats
+Oscillator::getStats()
+{
+    OscillatorStats result;
+    synchronized { result = stats; }
+    return result;
+}
+
+PacingStats
+Oscillator::getPacingStats()
+{
+    PacingStats result;
+    synchronized { result = pacing; }
+    return result;
+}
+
+void
+Oscillator::clearStats()
+{
+    synchronized {
+        
+        memset(&stats, 0, sizeof(stats));
+        memset(&pacing, 0, sizeof(pacing));
+    }
+}
+
+isize
+Oscillator::getFrameTimings(FrameTiming *buffer, isize count)
+{
+    isize result = 0;
+    
+    synchronized {
+        
+        u64 available = MIN(pacing.frames, (u64)PACING_RING_SIZE);
+        result = (isize)MIN((u64)MAX(count, (isize)0), available);
+        
+        for (isize i = 0; i < result; i++) {
+            buffer[i] = timings[(pacing.frames - result + i) % PACING_RING_SIZE];
+        }
+    }
+    return result;
+}
+
+void
+Oscillator::_dump() const
+{
+    i64 avgJitter = stats.waits ? stats.totalJitter / (i64)stats.waits : 0;
+    
+    msg("       Waits : %lld\n", stats.waits);
+    msg("    Restarts : %lld\n", stats.restarts);
+    msg("       Drift : %lld nsec\n", stats.drift);
+    msg("      Jitter : %lld nsec\n", stats.jitter);
+    msg("  Avg jitter : %lld nsec\n", avgJitter);
+    msg("  Max jitter : %lld nsec\n", stats.maxJitter);
+    msg("   Spin time : %lld msec\n", stats.spinTime / 1000000);
+    msg("     Latency : %lld usec\n", stats.audioLatency / 1000);
+    msg("      Frames : %lld\n", pacing.frames);
+    msg("  Underflows : %lld\n", pacing.underflows);
+    msg("   Overflows : %lld\n", pacing.overflows);
+    msg("  Max frame  : %lld usec\n", pacing.maxEmulationTime / 1000);
+    msg("      Hidden : %s\n", hidden ? "yes" : "no");
+    msg("        Idle : %s (%ld frames)\n", isIdle() ? "yes" : "no", idleFrames);
 }
 
 u64
@@ -53,17 +218,102 @@ Oscillator::restart()
 {
     clockBase = cpu.cycle;
     timeBase = nanos();
+    frameEnd = timeBase;
 }
 
 void
 Oscillator::synchronize()
 {
-    // Only proceed if we are not running in warp mode
-    if (warpMode) return;
+    u64 start = nanos();
+    u64 restarts = stats.restarts;
+    
+    updateIdleState();
+    
+    // In power saving mode, multiple frames are emulated in a row
+    bool batching = isSavingPower() && ++batchedFrames < config.powerSaving;
+    if (!batching) {
+        
+        batchedFrames = 0;
+        pace();
+    }
+    recordFrame(start, stats.restarts != restarts);
+}
+
+void
+Oscillator::updateIdleState()
+{
+    u16 pc = cpu.getPC0();
+    
+    // Pressed keys (Kernal variable SFDX is 64 if none is down) end idling
+    bool typing = mem.ram[0xCB] != 64 || keyboard.isTyping();
+    
+    // Only the Kernal ROM is examined
+    if (typing || pc < 0xE000 || mem.getPeekSource(pc) != M_KERNAL) {
+        
+        idleFrames = 0;
+        return;
+    }
+    
+    /* The Kernal waits for keyboard input in a loop at $E5CD - $E5D5. Frames
+     * ending somewhere else in the Kernal (e.g., in the interrupt handler)
+     * neither count as idle nor terminate the idle phase.
+     */
+    if (pc >= 0xE5CD && pc <= 0xE5D5) idleFrames++;
+}
+
+void
+Oscillator::recordFrame(u64 start, bool restarted)
+{
+    u64 now = nanos();
+    u64 emulationTime = start > frameEnd ? start - frameEnd : 0;
+    u64 sleepTime = now - start;
+    frameEnd = now;
+    
+    FrameTiming timing;
+    timing.frame = c64.frame;
+    timing.emulationTime = (u32)MIN(emulationTime, (u64)UINT32_MAX);
+    timing.sleepTime = (u32)MIN(sleepTime, (u64)UINT32_MAX);
+    timing.fillLevel = (u16)(sid.bufferedSamples() * 1000 / StereoStream::capacity);
+    timing.events = 0;
+    
+    // Check for audio buffer underflows or overflows since the last frame
+    if (sid.bufferUnderflows != underflows) timing.events |= PACING_UNDERFLOW;
+    if (sid.bufferOverflows != overflows) timing.events |= PACING_OVERFLOW;
+    if (restarted) timing.events |= PACING_RESTART;
+    underflows = sid.bufferUnderflows;
+    overflows = sid.bufferOverflows;
+    
+    auto bucket = [](u64 nanos) {
+        return (usize)MIN(nanos / (PACING_TIME_BUCKET_WIDTH * 1000), (u64)PACING_TIME_BUCKETS - 1);
+    };
+    
+    synchronized {
+        
+        timings[pacing.frames % PACING_RING_SIZE] = timing;
+        pacing.frames++;
+        
+        if (timing.events & PACING_UNDERFLOW) pacing.underflows++;
+        if (timing.events & PACING_OVERFLOW) pacing.overflows++;
+        pacing.maxEmulationTime = MAX(pacing.maxEmulationTime, emulationTime);
+        pacing.maxSleepTime = MAX(pacing.maxSleepTime, sleepTime);
+        pacing.emulationTime[bucket(emulationTime)]++;
+        pacing.sleepTime[bucket(sleepTime)]++;
+        pacing.fillLevel[MIN(timing.fillLevel / 100, PACING_FILL_BUCKETS - 1)]++;
+    }
+}
+
+void
+Oscillator::pace()
+{
+    // Only proceed if we are not running in warp mode or headless
+    if (warpMode || c64.isHeadless()) return;
+    
+    // In audio-paced mode, the audio device acts as the master clock
+    if (isAudioPaced()) { synchronizeWithAudio(); return; }
     
     u64 now          = nanos();
     Cycle clockDelta = cpu.cycle - clockBase;
-    u64 elapsedTime  = (u64)(clockDelta * 1000 * 1000000 /  vic.getFrequency());
+    u64 elapsedTime  = (u64)(clockDelta * 1000000000.0 * 100 / (vic.getFrequency() * config.speed));
     u64 targetTime   = timeBase + elapsedTime;
     
     /*
@@ -74,6 +324,9 @@ Oscillator::synchronize()
     trace(TIM_DEBUG, "\n");
     */
     
+    // Record the deviation from the target time
+    synchronized { stats.drift = (i64)(now - targetTime); }
+    
     // Check if we're running too slow ...
     if (now > targetTime) {
         
@@ -81,6 +334,7 @@ Oscillator::synchronize()
         if (now - targetTime > 200000000) {
             
             // warn("The emulator is way too slow (%lld).\n", now - targetTime);
+            synchronized { stats.restarts++; }
             restart();
             return;
         }
@@ -93,27 +347,89 @@ Oscillator::synchronize()
         if (targetTime - now > 200000000) {
             
             warn("The emulator is way too fast (%lld).\n", targetTime - now);
+            synchronized { stats.restarts++; }
             restart();
             return;
         }
         
         // See you soon...
         waitUntil(targetTime);
-        // mach_wait_until(targetTime);
     }
 }
 
+void
+Oscillator::synchronizeWithAudio()
+{
+    double rate   = sid.getSampleRate();
+    usize target  = (usize)(rate * config.audioLatency / 1000.0);
+    u64 now       = nanos();
+    u64 timeout   = now + 200000000;
+
+    // Wait until the audio device has consumed the surplus of samples
+    for (usize count; (count = sid.bufferedSamples()) > target; now = nanos()) {
+        
+        // Give up if the audio device has stopped consuming samples
+        if (now >= timeout) {
+            
+            synchronized { stats.restarts++; }
+            break;
+        }
+        
+        // Sleep about as long as it takes to play the surplus
+        u64 delay = (u64)((count - target) * 1000000000.0 / rate);
+        sleepUntil(MIN(now + delay, timeout));
+    }
+    
+    synchronized {
+        
+        stats.waits++;
+        stats.audioLatency = (i64)(sid.bufferedSamples() * 1000000000.0 / rate);
+    }
+    restart();
+}
+
 void
 Oscillator::waitUntil(u64 deadline)
 {
+    u64 spinWindow = (u64)config.spinWindow * 1000;
+    
+    // Sleep until the spin window has been reached
+    if (deadline > spinWindow) sleepUntil(deadline - spinWindow);
+    
+    // Busy-wait for the rest of the time
+    u64 spinStart = nanos(), now;
+    while ((now = nanos()) < deadline) { }
+
+    // Update statistics
+    synchronized {
+        
+        i64 jitter = (i64)(now - deadline);
+        
+        stats.waits++;
+        stats.jitter = jitter;
+        stats.maxJitter = MAX(stats.maxJitter, jitter);
+        stats.totalJitter += jitter;
+        stats.spinTime += now - spinStart;
+    }
+}
+
+void
+Oscillator::sleepUntil(u64 deadline)
+{
+    if (nanos() >= deadline) return;
+    
 #ifdef __MACH__
     
     mach_wait_until(nanos_to_abs(deadline));
     
 #else
 
-    assert(false);
-    // TODO: MISSING IMPLEMENTATION
+    struct timespec ts;
+    ts.tv_sec = (time_t)(deadline / 1000000000);
+    ts.tv_nsec = (long)(deadline % 1000000000);
+    
+    // Continue sleeping if the thread is woken up by a signal
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) { }
     
 #endif
 }
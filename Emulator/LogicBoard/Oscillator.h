@@ -17,6 +17,32 @@
 
 class Oscillator : public C64Component {
     
+    // Current configuration
+    OscillatorConfig config;
+    
+    // Timing statistics
+    OscillatorStats stats;
+    
+    // Pacing telemetry (histograms and the timings of the most recent frames)
+    PacingStats pacing;
+    FrameTiming timings[PACING_RING_SIZE];
+    
+    // End of the most recent synchronization phase (nanoseconds)
+    u64 frameEnd = 0;
+    
+    // Audio buffer underflows and overflows recorded so far
+    u64 underflows = 0;
+    u64 overflows = 0;
+    
+    // Indicates if the emulator window is hidden (set by the GUI)
+    std::atomic<bool> hidden = false;
+    
+    // Number of consecutive frames the guest has waited for keyboard input
+    isize idleFrames = 0;
+    
+    // Number of frames emulated since the thread has slept the last time
+    isize batchedFrames = 0;
+    
 #ifdef __MACH__
 
     // Information about the Mach system timer
@@ -81,8 +107,59 @@ private:
     }
 
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
+    
+    
+    //
+    // Configuring
+    //
+    
+public:
+    
+    OscillatorConfig getConfig() const { return config; }
+    
+    // Returns true if the emulation speed is driven by the audio stream
+    bool isAudioPaced() const { return config.audioLatency > 0; }
+    
+    long getConfigItem(Option option) const;
+    bool setConfigItem(Option option, long value) override;
+    
+    // Informs the oscillator about the visibility of the emulator window
+    void setHidden(bool value) { hidden = value; }
+    bool isHidden() const { return hidden; }
+    
+    // Returns true if the guest has been waiting for input for a second
+    bool isIdle() const { return idleFrames >= 50; }
+    
+    // Returns true if the power saving policy is in effect
+    bool isSavingPower() const { return config.powerSaving && (hidden || isIdle()); }
+    
+private:
+    
+    void _dumpConfig() const override;
+    
+    
+    //
+    // Analyzing
+    //
+    
+public:
+    
+    OscillatorStats getStats();
+    PacingStats getPacingStats();
+    void clearStats();
+    
+    /* Copies the timings of the most recent frames into a buffer, the oldest
+     * frame first. Returns the number of copied frames.
+     */
+    isize getFrameTimings(FrameTiming *buffer, isize count);
+    
+private:
+    
+    void _dump() const override;
     
     
     //
@@ -102,11 +179,33 @@ public:
     // Restarts the synchronization timer
     void restart();
 
-    // Puts the emulator thread to rest
+    // Puts the emulator thread to rest and records the frame timing
     void synchronize();
     
 private:
     
-    // Puts the thread to rest until the target time has been reached
+    // Puts the emulator thread to rest
+    void pace();
+    
+    // Records the timing of the frame that has just been completed
+    void recordFrame(u64 start, bool restarted);
+    
+    // Checks if the guest waits for keyboard input in the Kernal
+    void updateIdleState();
+    
+    /* Puts the emulator thread to rest in audio-paced mode. The thread sleeps
+     * until the audio device has drained the stream to the latency target.
+     */
+    void synchronizeWithAudio();
+    
+    /* Puts the thread to rest until the target time has been reached. The
+     * thread sleeps until the spin window in front of the deadline has been
+     * reached and busy-waits afterwards. Spinning is expensive, but hides the
+     * wake-up latency of the host scheduler which is far beyond a millisecond
+     * on some systems.
+     */
     void waitUntil(u64 deadline);
+    
+    // Puts the thread to sleep until the target time has been reached
+    static void sleepUntil(u64 deadline);
 };
@@ -0,0 +1,129 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+//
+// Constants
+//
+
+// Number of recent frames kept in the frame timing ring
+#define PACING_RING_SIZE 256
+
+// Number of buckets in the time histograms and bucket width (microseconds)
+#define PACING_TIME_BUCKETS 64
+#define PACING_TIME_BUCKET_WIDTH 500
+
+// Number of buckets in the fill level histogram (10 percent steps)
+#define PACING_FILL_BUCKETS 10
+
+// Frame timing events
+#define PACING_UNDERFLOW 0x1
+#define PACING_OVERFLOW  0x2
+#define PACING_RESTART   0x4
+
+
+//
+// Structures
+//
+
+typedef struct
+{
+    // Time span (in microseconds) in front of a deadline that is busy-waited
+    long spinWindow;
+    
+    /* Audio latency target (in milliseconds) in audio-paced mode. If this
+     * value is greater than 0, the emulator is paced by the fill level of
+     * the audio stream instead of the host clock.
+     */
+    long audioLatency;
+    
+    /* Emulation speed in percent of real time (outside warp mode). At speeds
+     * other than 100%, the audio stream is time-stretched to keep its pitch.
+     */
+    long speed;
+    
+    /* Power saving policy. If this value is greater than 0, the emulator
+     * stops drawing frames while the window is hidden and draws a few frames
+     * per second while the guest is idle. Values greater than 1 additionally
+     * let the emulator thread run this many frames in a row before it goes to
+     * sleep. The emulated time is not affected, but the audio stream is
+     * filled in larger chunks.
+     */
+    long powerSaving;
+}
+OscillatorConfig;
+
+typedef struct
+{
+    // Number of synchronization points that required the thread to wait
+    u64 waits;
+
+    // Number of times the synchronization timer had to be restarted
+    u64 restarts;
+
+    // Deviation from the target time before waiting (nanoseconds)
+    i64 drift;
+
+    // Deviation from the target time after waiting (nanoseconds)
+    i64 jitter;
+    i64 maxJitter;
+    i64 totalJitter;
+
+    // Accumulated time spent in the busy-waiting phase (nanoseconds)
+    u64 spinTime;
+    
+    // Buffered audio after the last synchronization (nanoseconds)
+    i64 audioLatency;
+}
+OscillatorStats;
+
+typedef struct
+{
+    // Frame number
+    u64 frame;
+    
+    // Time spent on emulating the frame (nanoseconds)
+    u32 emulationTime;
+    
+    // Time spent in the synchronization phase after the frame (nanoseconds)
+    u32 sleepTime;
+    
+    // Fill level of the audio buffer at the end of the frame (per mille)
+    u16 fillLevel;
+    
+    // Events that occurred in this frame (PACING_UNDERFLOW, ...)
+    u16 events;
+}
+FrameTiming;
+
+typedef struct
+{
+    // Number of recorded frames
+    u64 frames;
+    
+    // Number of frames with an audio buffer underflow or overflow
+    u64 underflows;
+    u64 overflows;
+    
+    // Worst emulation and sleep time seen so far (nanoseconds)
+    u64 maxEmulationTime;
+    u64 maxSleepTime;
+    
+    /* Histograms of the emulation and sleep time per frame. Bucket i counts
+     * the frames with a time in [i, i + 1) * PACING_TIME_BUCKET_WIDTH. The
+     * last bucket counts all longer frames.
+     */
+    u64 emulationTime[PACING_TIME_BUCKETS];
+    u64 sleepTime[PACING_TIME_BUCKETS];
+    
+    // Histogram of the audio buffer fill level at the end of each frame
+    u64 fillLevel[PACING_FILL_BUCKETS];
+}
+PacingStats;
@@ -0,0 +1,226 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "MediaLoader.h"
+#include "C64.h"
+
+MediaLoader::MediaLoader(C64 &ref, isize numThreads) : c64(ref)
+{
+    numThreads = std::max(numThreads, (isize)1);
+    workers = std::unique_ptr<WorkerThread[]>(new WorkerThread[numThreads]);
+    busy.assign(numThreads, false);
+}
+
+MediaLoader::~MediaLoader()
+{
+    cancel();
+}
+
+void
+MediaLoader::loadRom(const string &path)
+{
+    submit(Request { Kind::rom, path, 0 });
+}
+
+void
+MediaLoader::insertDisk(const string &path, long drive)
+{
+    assert(isDriveID(drive));
+    submit(Request { Kind::disk, path, drive });
+}
+
+void
+MediaLoader::attachCartridge(const string &path, bool reset)
+{
+    submit(Request { Kind::cartridge, path, reset });
+}
+
+isize
+MediaLoader::wait()
+{
+    std::vector<Cmd> pending;
+    isize result = 0;
+
+    // Workers may start over while the others are joined
+    for (bool done = false; !done; ) {
+
+        for (usize i = 0; i < busy.size(); i++) workers[i].join();
+
+        synchronized {
+
+            done = requests.empty() && std::find(busy.begin(), busy.end(), true) == busy.end();
+            result = (isize)failures.size();
+        }
+    }
+
+    // Execute all commands that haven't been picked up
+    synchronized { pending.swap(deferred); }
+    for (auto &cmd : pending) c64.issue(cmd);
+
+    return result;
+}
+
+void
+MediaLoader::cancel()
+{
+    std::vector<Cmd> pending;
+
+    // Drop all requests that haven't been picked up by a worker
+    synchronized { requests.clear(); }
+    for (usize i = 0; i < busy.size(); i++) workers[i].join();
+
+    // Release the objects the emulator will never receive
+    synchronized { pending.swap(deferred); }
+    for (auto &cmd : pending) CmdQueue::discard(cmd);
+}
+
+std::vector<std::pair<string, ErrorCode>>
+MediaLoader::takeFailures()
+{
+    std::vector<std::pair<string, ErrorCode>> result;
+    synchronized { result.swap(failures); }
+    return result;
+}
+
+void
+MediaLoader::flush()
+{
+    synchronized {
+
+        usize handedOver = 0;
+        while (handedOver < deferred.size() && c64.enqueue(deferred[handedOver])) {
+            handedOver++;
+        }
+        deferred.erase(deferred.begin(), deferred.begin() + handedOver);
+    }
+}
+
+void
+MediaLoader::submit(const Request &request)
+{
+    isize worker = -1;
+
+    synchronized {
+
+        requests.push_back(request);
+
+        // Wake up an idle worker (busy workers pick up the request, too)
+        for (usize i = 0; i < busy.size(); i++) {
+
+            if (!busy[i]) {
+
+                busy[i] = true;
+                worker = (isize)i;
+                break;
+            }
+        }
+    }
+
+    if (worker >= 0) {
+        workers[worker].run([this, worker]() { drain((usize)worker); });
+    }
+}
+
+void
+MediaLoader::drain(usize worker)
+{
+    while (true) {
+
+        Request request;
+
+        synchronized {
+
+            if (requests.empty()) { busy[worker] = false; return; }
+
+            request = requests.front();
+            requests.erase(requests.begin());
+        }
+
+        Cmd cmd;
+        ErrorCode error = ERROR_OK;
+
+        try {
+
+            cmd = process(request);
+
+        } catch (VC64Error &exception) {
+
+            error = exception.errorCode;
+
+        } catch (std::bad_alloc &) {
+
+            error = ERROR_OUT_OF_MEMORY;
+
+        } catch (std::exception &) {
+
+            error = ERROR_FILE_CANT_READ;
+        }
+
+        if (error != ERROR_OK) {
+
+            warn("Can't load %s (%s)\n", request.path.c_str(), ErrorCodeEnum::key(error));
+            synchronized { failures.push_back({ request.path, error }); }
+            continue;
+        }
+
+        // Hand the object over to the emulator thread
+        synchronized { deferred.push_back(cmd); }
+        flush();
+    }
+}
+
+Cmd
+MediaLoader::process(const Request &request)
+{
+    switch (request.kind) {
+
+        case Kind::rom:
+        {
+            RomFile *rom = AnyFile::make <RomFile> (request.path);
+            return Cmd { CMD_ROM_INSTALL, 0, 0, 0, rom };
+        }
+        case Kind::disk:
+        {
+            Disk *disk = makeDisk(request.path);
+            return Cmd { CMD_DSK_INSERT, 0, request.arg, 0, disk };
+        }
+        case Kind::cartridge:
+        {
+            std::unique_ptr<CRTFile> crt(AnyFile::make <CRTFile> (request.path));
+            if (!crt->isSupported()) throw VC64Error(ERROR_CRT_UNSUPPORTED);
+
+            Cartridge *cartridge = Cartridge::makeWithCRTFile(c64, *crt);
+            if (!cartridge) throw VC64Error(ERROR_CRT_UNSUPPORTED);
+
+            return Cmd { CMD_CRT_ATTACH, 0, 0, request.arg, cartridge };
+        }
+    }
+
+    assert(false);
+    return Cmd { CMD_NONE, 0, 0, 0, nullptr };
+}
+
+Disk *
+MediaLoader::makeDisk(const string &path)
+{
+    if (isDirectory(path)) {
+
+        std::unique_ptr<FSDevice> fs(FSDevice::makeWithFolder(path));
+        return Disk::makeWithFileSystem(c64, *fs);
+    }
+
+    if (G64File::isCompatibleName(path)) {
+
+        std::unique_ptr<G64File> g64(AnyFile::map <G64File> (path));
+        return Disk::makeWithG64(c64, g64.get());
+    }
+
+    std::unique_ptr<D64File> d64(AnyFile::map <D64File> (path));
+    return Disk::makeWithD64(c64, *d64);
+}
@@ -0,0 +1,121 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Object.h"
+#include "C64Types.h"
+#include "Concurrency.h"
+
+/* Loads Roms, disks, and cartridges on a pool of background threads. The
+ * calling thread only records the request and returns immediately. A worker
+ * thread reads and parses the file and builds the object the emulator
+ * operates on (RomFile, Disk, or Cartridge). Disks are GCR-encoded at this
+ * point. Directories are converted into a disk via a file system.
+ *
+ * The finished object is handed over to the emulator with a command (see
+ * CmdQueue). While the emulator is running, the emulator thread picks it up at
+ * the end of the current rasterline. Otherwise, the command is kept until the
+ * emulator is started again or wait() is called which executes it on the
+ * calling thread. Hence, Roms can be loaded while the GUI is setting up and
+ * are installed before the emulator is powered on.
+ *
+ * Requests are processed in parallel. Hence, objects of different requests
+ * may be handed over in any order. Each emulator instance owns a loader.
+ */
+class MediaLoader : C64Object {
+
+    enum class Kind { rom, disk, cartridge };
+
+    struct Request {
+
+        Kind kind;
+        string path;
+
+        // Drive (disks) or reset flag (cartridges)
+        long arg;
+    };
+
+    // Emulator receiving the loaded objects
+    class C64 &c64;
+
+    // Worker threads and their states
+    std::unique_ptr<WorkerThread[]> workers;
+    std::vector<bool> busy;
+
+    // Requests waiting for a worker
+    std::vector<Request> requests;
+
+    // Commands which couldn't be handed over because the emulator was halted
+    std::vector<Cmd> deferred;
+
+    // Failed requests
+    std::vector<std::pair<string, ErrorCode>> failures;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    MediaLoader(class C64 &ref, isize numThreads = 2);
+    ~MediaLoader();
+    const char *getDescription() const override { return "MediaLoader"; }
+
+
+    //
+    // Requesting objects (any thread)
+    //
+
+public:
+
+    // Installs a Rom
+    void loadRom(const string &path);
+
+    // Inserts a D64 or G64 file or a directory into a drive
+    void insertDisk(const string &path, long drive);
+
+    // Attaches a CRT file and optionally resets the emulator afterwards
+    void attachCartridge(const string &path, bool reset = true);
+
+    /* Waits until all requests have been processed and executes all commands
+     * that couldn't be handed over to the emulator thread. The function
+     * returns the number of failed requests.
+     */
+    isize wait();
+
+    /* Drops all requests that haven't been started, waits for the running
+     * ones, and releases the objects that haven't been handed over. The
+     * function is called when the emulator shuts down.
+     */
+    void cancel();
+
+    // Returns the failed requests (path and error code) and clears the list
+    std::vector<std::pair<string, ErrorCode>> takeFailures();
+
+    /* Hands over the commands that have been kept while the emulator was
+     * halted. The function is called when the command queue is opened.
+     */
+    void flush();
+
+private:
+
+    // Records a request and assigns it to an idle worker thread
+    void submit(const Request &request);
+
+    // Processes requests until the queue is empty (worker thread)
+    void drain(usize worker);
+
+    // Builds the object of a single request and returns the command
+    Cmd process(const Request &request) throws;
+
+    // Creates a disk from a disk file or a directory
+    class Disk *makeDisk(const string &path) throws;
+};
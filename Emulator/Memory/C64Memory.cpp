@@ -14,10 +14,17 @@ if (checkWatchpoints && cpu.debugger.watchpointMatches(x)) { \
     c64.signalWatchpoint(); \
 }
 
+#define JOURNAL_WRITE(x) \
+if (unlikely(journaling)) c64.journal.recordWrite(x, ram[x]);
+
+#define JOURNAL_IO \
+if (unlikely(journaling)) c64.journal.recordIO();
+
+#define MARK_DIRTY(x) \
+dirtyPages[(x) >> 8] = 1;
+
 C64Memory::C64Memory(C64 &ref) : C64Component(ref)
 {    		
-    memset(rom, 0, sizeof(rom));
-
     config.ramPattern = RAM_PATTERN_C64;
     config.debugcart = false;
 
@@ -96,6 +103,26 @@ C64Memory::C64Memory(C64 &ref) : C64Component(ref)
     for (unsigned i = 0x1; i <= 0xF; i++) {
         peekSrc[i] = pokeTarget[i] = M_RAM;
     }
+    updatePageTables();
+    markAllDirty();
+    
+    /* Initialize the I/O dispatch tables with handlers serving any setup. The
+     * tables are specialized in updateIOTables() which can't be called here,
+     * because the other components haven't been created yet.
+     */
+    for (unsigned i = 0x0; i <= 0xF; i++) {
+        
+        switch (i >> 2) {
+                
+            case 0:  ioReader[i] = &C64Memory::peekVICII; ioWriter[i] = &C64Memory::pokeVICII; break;
+            case 1:  ioReader[i] = &C64Memory::peekMappedSID; ioWriter[i] = &C64Memory::pokeMappedSID; break;
+            case 2:  ioReader[i] = &C64Memory::peekColorRam; ioWriter[i] = &C64Memory::pokeColorRam; break;
+        }
+    }
+    ioReader[0xC] = &C64Memory::peekCIA1; ioWriter[0xC] = &C64Memory::pokeCIA1;
+    ioReader[0xD] = &C64Memory::peekCIA2; ioWriter[0xD] = &C64Memory::pokeCIA2;
+    ioReader[0xE] = &C64Memory::peekIO1; ioWriter[0xE] = &C64Memory::pokeIO1;
+    ioReader[0xF] = &C64Memory::peekDebugPort; ioWriter[0xF] = &C64Memory::pokeDebugPort;
 }
 
 void
@@ -107,10 +134,13 @@ C64Memory::_reset()
     eraseWithPattern(config.ramPattern);
         
     // Initialize color RAM with random numbers
-    srand(1000);
+    colorRamNoise = 1000;
     for (unsigned i = 0; i < sizeof(colorRam); i++) {
-        colorRam[i] = (rand() & 0xFF);
+        colorRam[i] = (xorshift32(colorRamNoise) & 0xFF);
     }
+    
+    markAllDirty();
+    updateIOTables();
 }
 
 long
@@ -146,7 +176,11 @@ C64Memory::setConfigItem(Option option, long value)
                 return false;
             }
             
+            suspend();
             config.debugcart = value;
+            updateIOTables();
+            resume();
+            
             if (value) msg("Debug cart enabled\n");
             return true;
             
@@ -173,6 +207,20 @@ C64Memory::_inspect()
         for (int i = 0; i < 16; i++) info.peekSrc[i] = peekSrc[i];
         for (int i = 0; i < 16; i++) info.vicPeekSrc[i] = vic.memSrc[i];
     }
+    
+    latestInfo.publish(info);
+}
+
+void
+C64Memory::_memoryUsage(MemoryUsage &usage)
+{
+    for (isize i = 0; i < M_COUNT; i++) usage.heapBytes += views[i].capacity();
+    
+    if (romImage.isShared()) {
+        usage.sharedBytes += romImage.getSize();
+    } else {
+        usage.heapBytes += romImage.getSize();
+    }
 }
 
 void 
@@ -224,6 +272,244 @@ C64Memory::updatePeekPokeLookupTables()
     
     // Call the Cartridge's delegation method
     expansionport.updatePeekPokeLookupTables();
+    
+    // Derive the direct access tables
+    updatePageTables();
+}
+
+u8 *
+C64Memory::modifyRom()
+{
+    u8 *result = romImage.modify();
+    
+    rom = result;
+    updatePageTables();
+    return result;
+}
+
+void
+C64Memory::commitRom()
+{
+    romImage.commit();
+    
+    rom = romImage.data();
+    updatePageTables();
+}
+
+void
+C64Memory::updatePageTables()
+{
+    // Watchpoints and the undo journal are served in the slow path, only
+    bool slow = checkWatchpoints || journaling;
+    zeroPage = slow ? nullptr : ram;
+    stackPage = slow ? nullptr : ram + 0x100;
+    
+    for (unsigned page = 0; page < 256; page++) {
+        
+        MemoryType src = peekSrc[page >> 4];
+        MemoryType dst = pokeTarget[page >> 4];
+        
+        // Watchpoints and the undo journal are served in the slow path, only
+        if (slow) src = dst = M_NONE;
+        
+        // The processor port is mapped into the first page
+        if (page == 0) src = dst = M_NONE;
+        
+        switch (src) {
+                
+            case M_RAM:
+            case M_PP:      peekPage[page] = ram + 256 * page; break;
+            case M_BASIC:
+            case M_CHAR:
+            case M_KERNAL:  peekPage[page] = rom + 256 * page; break;
+            case M_CRTLO:
+            case M_CRTHI:   peekPage[page] = expansionport.mappedPage(page); break;
+            default:        peekPage[page] = nullptr;
+        }
+        
+        switch (dst) {
+                
+            case M_RAM:
+            case M_PP:
+            case M_BASIC:
+            case M_CHAR:
+            case M_KERNAL:  pokePage[page] = ram + 256 * page; break;
+            default:        pokePage[page] = nullptr;
+        }
+    }
+    
+    // Writes to $FF00 are reported in the slow path, only
+    if (trapFF00) pokePage[0xFF] = nullptr;
+}
+
+void
+C64Memory::updateIOTables()
+{
+    bool cartridge = expansionport.getCartridgeAttached();
+    bool debugPort = c64.debugPort.isEnabled();
+    
+    for (u16 page = 0; page < 16; page++) {
+        
+        u16 addr = 0xD000 + (page << 8);
+        
+        switch (page) {
+                
+            case 0x0: case 0x1: case 0x2: case 0x3: // VICII
+                
+                ioReader[page] = &C64Memory::peekVICII;
+                ioWriter[page] = &C64Memory::pokeVICII;
+                break;
+                
+            case 0x4: case 0x5: case 0x6: case 0x7: // SID
+                
+                // Pages without a remapped SID skip the address translation
+                if (sid.isSingleSIDPage(addr)) {
+                    ioReader[page] = &C64Memory::peekSID;
+                    ioWriter[page] = &C64Memory::pokeSID;
+                } else {
+                    ioReader[page] = &C64Memory::peekMappedSID;
+                    ioWriter[page] = &C64Memory::pokeMappedSID;
+                }
+                
+                // The exit register of the debug cart is located at $D7FF
+                if (page == 0x7 && config.debugcart) {
+                    ioWriter[page] = &C64Memory::pokeDebugCart;
+                }
+                break;
+                
+            case 0x8: case 0x9: case 0xA: case 0xB: // Color RAM
+                
+                ioReader[page] = &C64Memory::peekColorRam;
+                ioWriter[page] = &C64Memory::pokeColorRam;
+                break;
+                
+            case 0xC: // CIA 1
+                
+                ioReader[page] = &C64Memory::peekCIA1;
+                ioWriter[page] = &C64Memory::pokeCIA1;
+                break;
+                
+            case 0xD: // CIA 2
+                
+                ioReader[page] = &C64Memory::peekCIA2;
+                ioWriter[page] = &C64Memory::pokeCIA2;
+                break;
+                
+            case 0xE: // I/O space 1
+                
+                ioReader[page] = cartridge ? &C64Memory::peekIO1 : &C64Memory::peekOpenBus;
+                ioWriter[page] = cartridge ? &C64Memory::pokeIO1 : &C64Memory::pokeOpenBus;
+                break;
+                
+            case 0xF: // I/O space 2
+                
+                if (debugPort) {
+                    ioReader[page] = &C64Memory::peekDebugPort;
+                    ioWriter[page] = &C64Memory::pokeDebugPort;
+                } else {
+                    ioReader[page] = cartridge ? &C64Memory::peekIO2 : &C64Memory::peekOpenBus;
+                    ioWriter[page] = cartridge ? &C64Memory::pokeIO2 : &C64Memory::pokeOpenBus;
+                }
+                break;
+        }
+    }
+}
+
+void
+C64Memory::setCheckWatchpoints(bool value)
+{
+    checkWatchpoints = value;
+    updatePageTables();
+}
+
+void
+C64Memory::setJournaling(bool value)
+{
+    journaling = value;
+    updatePageTables();
+}
+
+void
+C64Memory::setTrapFF00(bool value)
+{
+    if (trapFF00 != value) {
+        
+        trapFF00 = value;
+        updatePageTables();
+    }
+}
+
+void
+C64Memory::markDirty(u16 addr, usize count)
+{
+    if (count == 0) return;
+    
+    isize last = std::min((isize)addr + (isize)count - 1, (isize)0xFFFF);
+    for (isize page = addr >> 8; page <= last >> 8; page++) dirtyPages[page] = 1;
+}
+
+void
+C64Memory::markAllDirty()
+{
+    memset(dirtyPages, 1, sizeof(dirtyPages));
+}
+
+void
+C64Memory::endFrame()
+{
+    for (isize i = 0; i < 4; i++) {
+        
+        const u8 *p = dirtyPages + 64 * i;
+        u64 bits = 0;
+        for (isize j = 0; j < 64; j++) bits |= (u64)p[j] << j;
+        
+        frameDirty[i] = bits;
+        pendingDirty[i] |= bits;
+    }
+    memset(dirtyPages, 0, sizeof(dirtyPages));
+    
+    if (viewsRequested.load(std::memory_order_relaxed)) takeViews();
+}
+
+void
+C64Memory::getFrameDirtyPages(u64 bitmap[4]) const
+{
+    memcpy(bitmap, frameDirty, sizeof(frameDirty));
+}
+
+void
+C64Memory::takeDirtyPages(u64 bitmap[4])
+{
+    for (isize i = 0; i < 4; i++) {
+        
+        u64 bits = pendingDirty[i];
+        for (isize j = 0; j < 64; j++) bits |= (u64)dirtyPages[64 * i + j] << j;
+        bitmap[i] = bits;
+    }
+    memset(pendingDirty, 0, sizeof(pendingDirty));
+    memset(dirtyPages, 0, sizeof(dirtyPages));
+}
+
+bool
+C64Memory::isPageDirty(u8 page) const
+{
+    return dirtyPages[page] || (pendingDirty[page >> 6] >> (page & 63) & 1);
+}
+
+void
+C64Memory::takeViews()
+{
+    u32 requested = viewsRequested.exchange(0, std::memory_order_relaxed);
+    
+    AutoMutex lock(viewMutex);
+    
+    for (isize i = 0; i < M_COUNT; i++) {
+        
+        if (!GET_BIT(requested, i)) continue;
+        
+        views[i].resize(0x10000);
+        spypeek(views[i].data(), 0, 0x10000, (MemoryType)i);
+    }
 }
 
 u8
@@ -277,7 +563,7 @@ C64Memory::peek(u16 addr, bool gameLine, bool exromLine)
 }
 
 u8
-C64Memory::peekZP(u8 addr)
+C64Memory::_peekZP(u8 addr)
 {
     CHECK_WATCHPOINT(addr)
     
@@ -291,7 +577,7 @@ C64Memory::peekZP(u8 addr)
 }
 
 u8
-C64Memory::peekStack(u8 sp)
+C64Memory::_peekStack(u8 sp)
 {
     CHECK_WATCHPOINT(sp)
     
@@ -302,55 +588,78 @@ u8
 C64Memory::peekIO(u16 addr)
 {
     CHECK_WATCHPOINT(addr)
+    JOURNAL_IO
     
     assert(addr >= 0xD000 && addr <= 0xDFFF);
     
-    switch ((addr >> 8) & 0xF) {
-            
-        case 0x0: // VICII
-        case 0x1: // VICII
-        case 0x2: // VICII
-        case 0x3: // VICII
-            
-            // Only the lower 6 bits are used for adressing the VIC I/O space.
-            // As a result, VICII's I/O memory repeats every 64 bytes.
-            return vic.peek(addr & 0x003F);
+    return (this->*ioReader[(addr >> 8) & 0xF])(addr);
+}
 
-        case 0x4: // SID
-        case 0x5: // SID
-        case 0x6: // SID
-        case 0x7: // SID
-            
-            return sid.peek(addr);
+u8
+C64Memory::peekVICII(u16 addr)
+{
+    // Only the lower 6 bits are used for adressing the VIC I/O space.
+    // As a result, VICII's I/O memory repeats every 64 bytes.
+    return vic.peek(addr & 0x003F);
+}
 
-        case 0x8: // Color RAM
-        case 0x9: // Color RAM
-        case 0xA: // Color RAM
-        case 0xB: // Color RAM
- 
-            return (colorRam[addr - 0xD800] & 0x0F) | (vic.getDataBusPhi1() & 0xF0);
+u8
+C64Memory::peekSID(u16 addr)
+{
+    return sid.peek(0, addr);
+}
 
-        case 0xC: // CIA 1
- 
-            // Only the lower 4 bits are used for adressing the CIA I/O space.
-            // As a result, CIA's I/O memory repeats every 16 bytes.
-            return cia1.peek(addr & 0x000F);
-	
-        case 0xD: // CIA 2
-            
-            return cia2.peek(addr & 0x000F);
-            
-        case 0xE: // I/O space 1
-            
-            return expansionport.peekIO1(addr);
-            
-        case 0xF: // I/O space 2
+u8
+C64Memory::peekMappedSID(u16 addr)
+{
+    return sid.peek(addr);
+}
 
-            return expansionport.peekIO2(addr);
-	}
-    
-	assert(false);
-	return 0;
+u8
+C64Memory::peekColorRam(u16 addr)
+{
+    return (colorRam[addr - 0xD800] & 0x0F) | (vic.getDataBusPhi1() & 0xF0);
+}
+
+u8
+C64Memory::peekCIA1(u16 addr)
+{
+    // Only the lower 4 bits are used for adressing the CIA I/O space.
+    // As a result, CIA's I/O memory repeats every 16 bytes.
+    return cia1.peek(addr & 0x000F);
+}
+
+u8
+C64Memory::peekCIA2(u16 addr)
+{
+    // Port A reflects the IEC bus which is driven by the drives, too
+    if ((addr & 0x000F) == 0x0) c64.observeDrives();
+    return cia2.peek(addr & 0x000F);
+}
+
+u8
+C64Memory::peekIO1(u16 addr)
+{
+    return expansionport.peekIO1(addr);
+}
+
+u8
+C64Memory::peekIO2(u16 addr)
+{
+    return expansionport.peekIO2(addr);
+}
+
+u8
+C64Memory::peekDebugPort(u16 addr)
+{
+    if (c64.debugPort.matches(addr)) return c64.debugPort.peek(addr);
+    return expansionport.peekIO2(addr);
+}
+
+u8
+C64Memory::peekOpenBus(u16 addr)
+{
+    return vic.getDataBusPhi1();
 }
 
 u8
@@ -391,6 +700,70 @@ C64Memory::spypeek(u16 addr, MemoryType source) const
     }
 }
 
+void
+C64Memory::spypeek(u8 *dst, u16 addr, isize count, MemoryType source) const
+{
+    assert(dst);
+    assert(count >= 0 && addr + count <= 0x10000);
+    
+    switch (source) {
+            
+        case M_RAM:
+        case M_NONE:
+            memcpy(dst, ram + addr, count);
+            return;
+            
+        case M_BASIC:
+        case M_CHAR:
+        case M_KERNAL:
+            memcpy(dst, rom + addr, count);
+            return;
+            
+        default:
+            break;
+    }
+    
+    for (isize i = 0; i < count; i++) {
+        
+        u16 a = (u16)(addr + i);
+        
+        switch (source) {
+                
+            case M_IO:
+                dst[i] = (a >> 12) == 0xD ? spypeekIO(a) : ram[a];
+                break;
+                
+            case M_CRTLO:
+            case M_CRTHI:
+                dst[i] =
+                Cartridge::isROMLaddr(a) || Cartridge::isROMHaddr(a) ?
+                expansionport.spypeek(a) : ram[a];
+                break;
+                
+            default:
+                dst[i] = spypeek(a, source);
+        }
+    }
+}
+
+bool
+C64Memory::getView(u8 *dst, u16 addr, isize count, MemoryType source)
+{
+    assert(dst);
+    assert_enum(MemoryType, source);
+    assert(count >= 0 && addr + count <= 0x10000);
+    
+    // Ask for a new copy at the end of the next frame
+    viewsRequested.fetch_or(1 << source, std::memory_order_relaxed);
+    
+    AutoMutex lock(viewMutex);
+    
+    if (views[source].empty()) return false;
+    
+    memcpy(dst, views[source].data() + addr, count);
+    return true;
+}
+
 u8
 C64Memory::spypeekIO(u16 addr) const
 {
@@ -434,6 +807,7 @@ C64Memory::spypeekIO(u16 addr) const
             
         case 0xF: // I/O space 2
             
+            if (c64.debugPort.matches(addr)) return c64.debugPort.peek(addr);
             return expansionport.spypeekIO2(addr);
 
         default:
@@ -460,7 +834,10 @@ C64Memory::poke(u16 addr, u8 value, MemoryType target)
         case M_BASIC:
         case M_CHAR:
         case M_KERNAL:
+            JOURNAL_WRITE(addr)
+            MARK_DIRTY(addr)
             ram[addr] = value;
+            if (unlikely(addr == 0xFF00 && trapFF00)) expansionport.didPokeFF00();
             return;
             
         case M_IO:
@@ -469,15 +846,21 @@ C64Memory::poke(u16 addr, u8 value, MemoryType target)
             
         case M_CRTLO:
         case M_CRTHI:
+            JOURNAL_IO
+            MARK_DIRTY(addr)
             expansionport.poke(addr, value);
             return;
             
         case M_PP:
+            MARK_DIRTY(addr)
             if (likely(addr >= 0x02)) {
+                JOURNAL_WRITE(addr)
                 ram[addr] = value;
             } else if (addr == 0x00) {
+                JOURNAL_IO
                 cpu.pport.writeDirection(value);
             } else {
+                JOURNAL_IO
                 cpu.pport.write(value);
             }
             return;
@@ -502,23 +885,29 @@ C64Memory::poke(u16 addr, u8 value, bool gameLine, bool exromLine)
 }
 
 void
-C64Memory::pokeZP(u8 addr, u8 value)
+C64Memory::_pokeZP(u8 addr, u8 value)
 {
     CHECK_WATCHPOINT(addr)
+    MARK_DIRTY(addr)
     
     if (likely(addr >= 0x02)) {
+        JOURNAL_WRITE(addr)
         ram[addr] = value;
     } else if (addr == 0x00) {
+        JOURNAL_IO
         cpu.pport.writeDirection(value);
     } else {
+        JOURNAL_IO
         cpu.pport.write(value);
     }
 }
 
 void
-C64Memory::pokeStack(u8 sp, u8 value)
+C64Memory::_pokeStack(u8 sp, u8 value)
 {
     CHECK_WATCHPOINT(sp)
+    JOURNAL_WRITE(0x100 + sp)
+    MARK_DIRTY(0x100 + sp)
     
     ram[0x100 + sp] = value;
 }
@@ -527,68 +916,86 @@ void
 C64Memory::pokeIO(u16 addr, u8 value)
 {
     CHECK_WATCHPOINT(addr)
+    JOURNAL_IO
     
     assert(addr >= 0xD000 && addr <= 0xDFFF);
     
-    switch ((addr >> 8) & 0xF) {
-            
-        case 0x0: // VICII
-        case 0x1: // VICII
-        case 0x2: // VICII
-        case 0x3: // VICII
-            
-            // Only the lower 6 bits are used for adressing the VICII I/O space.
-            // As a result, VICII's I/O memory repeats every 64 bytes.
-            vic.poke(addr & 0x003F, value);
-            return;
-            
-        case 0x4: // SID
-        case 0x5: // SID
-        case 0x6: // SID
-        case 0x7: // SID
-            
-            sid.poke(addr, value);
+    (this->*ioWriter[(addr >> 8) & 0xF])(addr, value);
+}
 
-            // Check the exit register (option -debugcart)
-            if (addr == 0xD7FF && config.debugcart) {
-                msg("DEBUGCART: Terminating with exit code %x\n", value);
-                exit(value);
-            }
+void
+C64Memory::pokeVICII(u16 addr, u8 value)
+{
+    // Only the lower 6 bits are used for adressing the VICII I/O space.
+    // As a result, VICII's I/O memory repeats every 64 bytes.
+    vic.poke(addr & 0x003F, value);
+}
 
-            return;
-            
-        case 0x8: // Color RAM
-        case 0x9: // Color RAM
-        case 0xA: // Color RAM
-        case 0xB: // Color RAM
-            
-            colorRam[addr - 0xD800] = (value & 0x0F) | (rand() & 0xF0);
-            return;
-            
-        case 0xC: // CIA 1
-            
-            // Only the lower 4 bits are used for adressing the CIA I/O space.
-            // As a result, CIA's I/O memory repeats every 16 bytes.
-            cia1.poke(addr & 0x000F, value);
-            return;
-            
-        case 0xD: // CIA 2
-            
-            cia2.poke(addr & 0x000F, value);
-            return;
-            
-        case 0xE: // I/O space 1
-            
-            expansionport.pokeIO1(addr, value);
-            return;
-            
-        case 0xF: // I/O space 2
-            
-            expansionport.pokeIO2(addr, value);
-            return;
-    }
+void
+C64Memory::pokeSID(u16 addr, u8 value)
+{
+    sid.poke(0, addr, value);
+}
+
+void
+C64Memory::pokeMappedSID(u16 addr, u8 value)
+{
+    sid.poke(addr, value);
+}
+
+void
+C64Memory::pokeDebugCart(u16 addr, u8 value)
+{
+    sid.poke(addr, value);
     
-    assert(false);
+    // Check the exit register (option -debugcart)
+    if (addr == 0xD7FF) {
+        msg("DEBUGCART: Terminating with exit code %x\n", value);
+        exit(value);
+    }
+}
+
+void
+C64Memory::pokeColorRam(u16 addr, u8 value)
+{
+    colorRam[addr - 0xD800] = (value & 0x0F) | (xorshift32(colorRamNoise) & 0xF0);
+}
+
+void
+C64Memory::pokeCIA1(u16 addr, u8 value)
+{
+    // Only the lower 4 bits are used for adressing the CIA I/O space.
+    // As a result, CIA's I/O memory repeats every 16 bytes.
+    cia1.poke(addr & 0x000F, value);
+}
+
+void
+C64Memory::pokeCIA2(u16 addr, u8 value)
+{
+    cia2.poke(addr & 0x000F, value);
+}
+
+void
+C64Memory::pokeIO1(u16 addr, u8 value)
+{
+    expansionport.pokeIO1(addr, value);
+}
+
+void
+C64Memory::pokeIO2(u16 addr, u8 value)
+{
+    expansionport.pokeIO2(addr, value);
+}
+
+void
+C64Memory::pokeDebugPort(u16 addr, u8 value)
+{
+    // Check the debug port (option OPT_DEBUG_PORT)
+    if (c64.debugPort.matches(addr)) {
+        if (c64.debugPort.poke(addr, value)) c64.signalGuestExit();
+        return;
+    }
+    expansionport.pokeIO2(addr, value);
 }
 
 u16
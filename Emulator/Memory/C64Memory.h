@@ -10,14 +10,18 @@
 #pragma once
 
 #include "C64Memory.h"
+#include "Concurrency.h"
+#include <atomic>
+#include <vector>
 
 class C64Memory : public C64Component {
 
     // Current configuration
     MemConfig config;
     
-    // Result of the latest inspection
+    // Result of the latest inspection (the published copy is read by the GUI)
     MemInfo info;
+    InfoRecord<MemInfo> latestInfo;
     
 public:
     
@@ -40,13 +44,18 @@ public:
      */
     u8 colorRam[1024];
 
+    // State of the random number generator feeding the open color RAM bits
+    u32 colorRamNoise = 1000;
+
     // Read Only Memory
 	/* Only specific memory cells are valid ROM locations. In total, the C64
      * has three ROMs that are located at different addresses. Note, that the
      * ROMs do not span over the whole 64KB range. Therefore, only some
-     * addresses are valid ROM addresses.
+     * addresses are valid ROM addresses. The image is shared with all
+     * emulator instances that have the same ROMs installed.
      */
-    u8 rom[65536];
+    RomImage romImage = RomImage(0x10000);
+    const u8 *rom = romImage.data();
         
     // Peek source lookup table
     MemoryType peekSrc[16];
@@ -54,9 +63,65 @@ public:
     // Poke target lookup table
     MemoryType pokeTarget[16];
     
+    /* Page tables for direct memory access. For each 256 byte page, these
+     * tables point to the memory backing the page (RAM or ROM). Pages that
+     * require special treatment (zero page, I/O, cartridge, open bus) are
+     * marked with nullptr and handled by peek(addr, source) and poke(addr,
+     * value, target). The tables are derived from peekSrc and pokeTarget.
+     */
+    const u8 *peekPage[256];
+    u8 *pokePage[256];
+    
+    /* I/O dispatch tables. For each 256 byte page of the I/O space, these
+     * tables point to the handler serving the page. Hence, peekIO() and
+     * pokeIO() reach the target chip with a single indirect call. The tables
+     * are derived from the SID mapping, the attached cartridge, and the debug
+     * options.
+     */
+    typedef u8 (C64Memory::*IOReader)(u16 addr);
+    typedef void (C64Memory::*IOWriter)(u16 addr, u8 value);
+    IOReader ioReader[16];
+    IOWriter ioWriter[16];
+    
+    /* Dirty page tracking. When a RAM page is written, the corresponding
+     * entry in dirtyPages is set. It is a byte array to keep the fast path
+     * down to a single store. At the end of each frame, the array is
+     * condensed into a bitmap of the pages written during that frame, which
+     * is also accumulated until a consumer takes it. Functions that modify
+     * RAM directly have to call markDirty() on the affected range.
+     */
+    u8 dirtyPages[256];
+    u64 frameDirty[4] = { };
+    u64 pendingDirty[4] = { };
+    
+    /* Memory views (see getView()). Whenever a view has been requested, the
+     * requested memory sources are copied into these buffers at the end of
+     * the next frame. The buffers are protected by a mutex, because they are
+     * read by arbitrary threads.
+     */
+    std::vector<u8> views[M_COUNT];
+    std::atomic<u32> viewsRequested {0};
+    Mutex viewMutex;
+    
+    /* Direct access pointers for the zero page and the stack. They point into
+     * RAM while no watchpoints are set and the undo journal is off. Otherwise,
+     * they are nullptr, which routes all accesses through the checked
+     * functions _peekZP() etc.
+     */
+    u8 *zeroPage = nullptr;
+    u8 *stackPage = nullptr;
+    
     // Indicates if watchpoints should be checked
     bool checkWatchpoints = false;
     
+    // Indicates if all writes are reported to the undo journal
+    bool journaling = false;
+    
+    /* Indicates if writes to $FF00 are reported to the expansion port. A REU
+     * waits for such a write to start an armed DMA transfer.
+     */
+    bool trapFF00 = false;
+    
     
     //
     // Initializing
@@ -90,7 +155,7 @@ public:
     
 public:
     
-    MemInfo getInfo() { return HardwareComponent::getInfo(info); }
+    MemInfo getInfo() { return HardwareComponent::getInfo(latestInfo); }
     
 private:
     
@@ -111,7 +176,7 @@ private:
         
         & ram
         & colorRam
-        & rom
+        & romImage
         & peekSrc
         & pokeTarget;
     }
@@ -122,8 +187,12 @@ private:
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
+    void _memoryUsage(MemoryUsage &usage) override;
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
+    usize didLoadFromBuffer(u8 *buffer) override { commitRom(); markAllDirty(); updateIOTables(); return 0; }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
     
     
     //
@@ -135,10 +204,36 @@ public:
     // Erases the RAM with the provided init pattern
     void eraseWithPattern(RamPattern pattern);
     
+    /* Modifies the ROM contents. modifyRom() returns a private copy of the
+     * ROM image which is shared again when commitRom() is called.
+     */
+    u8 *modifyRom();
+    void commitRom();
+    
     /* Updates the peek and poke lookup tables. The lookup values depend on
      * three processor port bits and the cartridge exrom and game lines.
      */
     void updatePeekPokeLookupTables();
+    
+    /* Updates the direct access page tables. This function needs to be called
+     * whenever peekSrc or pokeTarget have been modified.
+     */
+    void updatePageTables();
+    
+    /* Updates the I/O dispatch tables. This function needs to be called
+     * whenever a SID has been enabled or moved, a cartridge has been attached
+     * or detached, or the debug port or debug cart has been toggled.
+     */
+    void updateIOTables();
+    
+    // Enables or disables watchpoint checking
+    void setCheckWatchpoints(bool value);
+    
+    // Enables or disables reporting writes to the undo journal
+    void setJournaling(bool value);
+    
+    // Enables or disables reporting writes to $FF00
+    void setTrapFF00(bool value);
 
     // Returns the current peek source of the specified memory address
     MemoryType getPeekSource(u16 addr) { return peekSrc[addr >> 12]; }
@@ -149,9 +244,18 @@ public:
     // Reads a value from memory
     u8 peek(u16 addr, MemoryType source);
     u8 peek(u16 addr, bool gameLine, bool exromLine);
-    u8 peek(u16 addr) { return peek(addr, peekSrc[addr >> 12]); }
-    u8 peekZP(u8 addr);
-    u8 peekStack(u8 sp);
+    u8 peek(u16 addr) {
+        const u8 *page = peekPage[addr >> 8];
+        return likely(page != nullptr) ? page[addr & 0xFF] : peek(addr, peekSrc[addr >> 12]);
+    }
+    u8 peekZP(u8 addr) {
+        return likely(zeroPage && addr >= 0x02) ? zeroPage[addr] : _peekZP(addr);
+    }
+    u8 peekStack(u8 sp) {
+        return likely(stackPage != nullptr) ? stackPage[sp] : _peekStack(sp);
+    }
+    u8 _peekZP(u8 addr);
+    u8 _peekStack(u8 sp);
     u8 peekIO(u16 addr);
 
     // Reads a value from memory and discards the result (idle access)
@@ -165,15 +269,81 @@ public:
     u8 spypeek(u16 addr) const { return spypeek(addr, peekSrc[addr >> 12]); }
     u8 spypeekIO(u16 addr) const;
     u8 spypeekColor(u16 addr) const;
+    
+    /* Reads a memory range without side effects. Addresses that are not
+     * served by the specified source (e.g., addresses outside the I/O space
+     * if source equals M_IO) are read from RAM.
+     */
+    void spypeek(u8 *dst, u16 addr, isize count, MemoryType source) const;
+    
+    /* Reads a memory range from a copy that has been taken at the end of a
+     * frame. The function can be called from any thread while the emulator is
+     * running. Each call requests a fresh copy of the specified source for
+     * the end of the next frame. The function returns false if no copy has
+     * been taken since the first request.
+     */
+    bool getView(u8 *dst, u16 addr, isize count, MemoryType source);
 
     // Writing a value into memory
     void poke(u16 addr, u8 value, MemoryType target);
     void poke(u16 addr, u8 value, bool gameLine, bool exromLine);
-    void poke(u16 addr, u8 value) { poke(addr, value, pokeTarget[addr >> 12]); }
-    void pokeZP(u8 addr, u8 value);
-    void pokeStack(u8 sp, u8 value);
+    void poke(u16 addr, u8 value) {
+        u8 *page = pokePage[addr >> 8];
+        if (likely(page != nullptr)) {
+            page[addr & 0xFF] = value;
+            dirtyPages[addr >> 8] = 1;
+        } else {
+            poke(addr, value, pokeTarget[addr >> 12]);
+        }
+    }
+    void pokeZP(u8 addr, u8 value) {
+        if (likely(zeroPage && addr >= 0x02)) {
+            zeroPage[addr] = value;
+            dirtyPages[0] = 1;
+        } else {
+            _pokeZP(addr, value);
+        }
+    }
+    void pokeStack(u8 sp, u8 value) {
+        if (likely(stackPage != nullptr)) {
+            stackPage[sp] = value;
+            dirtyPages[1] = 1;
+        } else {
+            _pokeStack(sp, value);
+        }
+    }
+    void _pokeZP(u8 addr, u8 value);
+    void _pokeStack(u8 sp, u8 value);
     void pokeIO(u16 addr, u8 value);
     
+private:
+    
+    // I/O handlers (see ioReader and ioWriter)
+    u8 peekVICII(u16 addr);
+    u8 peekSID(u16 addr);
+    u8 peekMappedSID(u16 addr);
+    u8 peekColorRam(u16 addr);
+    u8 peekCIA1(u16 addr);
+    u8 peekCIA2(u16 addr);
+    u8 peekIO1(u16 addr);
+    u8 peekIO2(u16 addr);
+    u8 peekDebugPort(u16 addr);
+    u8 peekOpenBus(u16 addr);
+    
+    void pokeVICII(u16 addr, u8 value);
+    void pokeSID(u16 addr, u8 value);
+    void pokeMappedSID(u16 addr, u8 value);
+    void pokeDebugCart(u16 addr, u8 value);
+    void pokeColorRam(u16 addr, u8 value);
+    void pokeCIA1(u16 addr, u8 value);
+    void pokeCIA2(u16 addr, u8 value);
+    void pokeIO1(u16 addr, u8 value);
+    void pokeIO2(u16 addr, u8 value);
+    void pokeDebugPort(u16 addr, u8 value);
+    void pokeOpenBus(u16 addr, u8 value) { }
+    
+public:
+    
     // Reads a vector address from memory
     u16 nmiVector();
     u16 irqVector();
@@ -189,4 +359,36 @@ public:
     char *hexdump(u16 addr, long num) { return hexdump(addr, num, peekSrc[addr >> 12]); }
     char *decdump(u16 addr, long num) { return decdump(addr, num, peekSrc[addr >> 12]); }
     char *txtdump(u16 addr, long num) { return txtdump(addr, num, peekSrc[addr >> 12]); }
+    
+    
+    //
+    // Tracking modified pages
+    //
+    
+public:
+    
+    // Marks the pages overlapping the specified RAM range as modified
+    void markDirty(u16 addr, usize count);
+    void markAllDirty();
+    
+    /* Condenses the pages written during the current frame into a bitmap and
+     * serves pending view requests (called at the end of each frame)
+     */
+    void endFrame();
+    
+    // Returns the bitmap of the pages written during the previous frame
+    void getFrameDirtyPages(u64 bitmap[4]) const;
+    
+    /* Returns the bitmap of the pages written since the last call and clears
+     * it. Pages written during the current frame are included.
+     */
+    void takeDirtyPages(u64 bitmap[4]);
+    
+    // Checks if a page has been written since the last call to takeDirtyPages()
+    bool isPageDirty(u8 page) const;
+    
+private:
+    
+    // Copies all requested memory sources into the view buffers
+    void takeViews();
 };
@@ -11,7 +11,6 @@
 
 DriveMemory::DriveMemory(C64 &ref, Drive &dref) : C64Component(ref), drive(dref)
 {
-    memset(rom, 0, sizeof(rom));
 }
 
 void 
@@ -25,6 +24,16 @@ DriveMemory::_reset()
     }
 }
 
+void
+DriveMemory::_memoryUsage(MemoryUsage &usage)
+{
+    if (romImage.isShared()) {
+        usage.sharedBytes += romImage.getSize();
+    } else {
+        usage.heapBytes += romImage.getSize();
+    }
+}
+
 void 
 DriveMemory::_dump() const
 {
@@ -53,6 +62,10 @@ DriveMemory::peek(u16 addr)
         // 0x0800 - 0x17FF : unmapped
         // 0x1800 - 0x1BFF : VIA 1 (repeats every 16 bytes)
         // 0x1C00 - 0x1FFF : VIA 2 (repeats every 16 bytes)
+        
+        // Bring the read/write logic up to date before VIA 2 is accessed
+        if (addr >= 0x1C00) drive.syncDiskLogic();
+        
         return
         (addr < 0x0800) ? ram[addr] :
         (addr < 0x1800) ? addr >> 8 :
@@ -88,10 +101,12 @@ DriveMemory::poke(u16 addr, u8 value)
     
     if (addr < 0x0800) { // RAM
         ram[addr] = value;
+        markDirty();
         return;
     }
     
     if (addr >= 0x1C00) { // VIA 2
+        drive.syncDiskLogic();
         drive.via2.poke(addr & 0xF, value);
         return;
     }
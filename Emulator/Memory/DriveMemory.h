@@ -20,9 +20,10 @@ private:
     
 public:
     
-    // RAM (2 KB) and ROM (16 KB)
+    // RAM (2 KB) and ROM (16 KB, shared among instances)
     u8 ram[0x0800];
-    u8 rom[0x4000];
+    RomImage romImage = RomImage(0x4000);
+    const u8 *rom = romImage.data();
     
     
     //
@@ -60,7 +61,7 @@ private:
         worker
         
         & ram
-        & rom;
+        & romImage;
     }
     
     template <class T>
@@ -69,8 +70,26 @@ private:
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
+    void _memoryUsage(MemoryUsage &usage) override;
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
+    usize didLoadFromBuffer(u8 *buffer) override { commitRom(); return 0; }
+    
+    // All writes to RAM and ROM call markDirty()
+    bool tracksChanges() const override { return true; }
+    
+    
+    //
+    // Accessing ROM
+    //
+    
+public:
+    
+    // Modifies the ROM contents (see C64Memory::modifyRom())
+    u8 *modifyRom() { markDirty(); u8 *result = romImage.modify(); rom = result; return result; }
+    void commitRom() { romImage.commit(); rom = romImage.data(); }
     
     
     //
@@ -95,6 +114,6 @@ public:
 
     // Writes a value into memory
     void poke(u16 addr, u8 value);
-    void pokeZP(u8 addr, u8 value) { ram[addr] = value; }
-    void pokeStack(u8 sp, u8 value) { ram[0x100 + sp] = value; }
+    void pokeZP(u8 addr, u8 value) { ram[addr] = value; markDirty(); }
+    void pokeStack(u8 sp, u8 value) { ram[0x100 + sp] = value; markDirty(); }
 };
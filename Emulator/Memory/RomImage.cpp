@@ -0,0 +1,83 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "RomImage.h"
+#include "Concurrency.h"
+#include "Utils.h"
+#include <unordered_map>
+
+namespace {
+
+struct Registry {
+
+    Mutex lock;
+    std::unordered_map<u64, std::weak_ptr<u8[]>> images;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+}
+
+RomImage::RomImage(usize size) : size(size)
+{
+    buffer = std::shared_ptr<u8[]>(new u8[size]());
+    isPrivate = true;
+    commit();
+}
+
+u8 *
+RomImage::modify()
+{
+    if (!isPrivate) {
+
+        std::shared_ptr<u8[]> copy(new u8[size]);
+        memcpy(copy.get(), buffer.get(), size);
+        buffer = copy;
+        isPrivate = true;
+    }
+    return buffer.get();
+}
+
+void
+RomImage::commit()
+{
+    if (!isPrivate) return;
+
+    u64 key = fnv_1a_64(buffer.get(), size) ^ size;
+    checksum = key;
+
+    Registry &reg = registry();
+    AutoMutex lock(reg.lock);
+
+    // Drop all images that are no longer in use
+    for (auto it = reg.images.begin(); it != reg.images.end(); ) {
+        if (it->second.expired()) it = reg.images.erase(it); else it++;
+    }
+
+    // Share the image if it is already known
+    auto it = reg.images.find(key);
+    if (it != reg.images.end()) {
+
+        std::shared_ptr<u8[]> image = it->second.lock();
+        if (memcmp(image.get(), buffer.get(), size) == 0) {
+
+            buffer = image;
+            isPrivate = false;
+            return;
+        }
+    }
+
+    // Register the image
+    reg.images[key] = buffer;
+    isPrivate = false;
+}
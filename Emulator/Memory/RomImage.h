@@ -0,0 +1,119 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include <memory>
+#include <type_traits>
+
+class SerCounter;
+class SerReader;
+class SerWriter;
+class SerHasher;
+
+/* A Rom image that is shared among emulator instances. All images with the
+ * same contents refer to a single, immutable buffer which is looked up in a
+ * process-wide registry by its FNV-1a checksum. Buffers are reference counted
+ * and freed together with the last image referring to them.
+ *
+ * To change the contents, modify() hands out a private copy. commit() shares
+ * the copy again by looking it up in the registry.
+ */
+class RomImage {
+
+    // Image size in bytes
+    usize size;
+
+    // Image data
+    std::shared_ptr<u8[]> buffer;
+
+    // Indicates whether the buffer is a private copy (see modify())
+    bool isPrivate = false;
+
+    // Checksum of the shared buffer (computed in commit())
+    u64 checksum = 0;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    // Creates an image filled with zeroes
+    RomImage(usize size);
+
+
+    //
+    // Accessing
+    //
+
+public:
+
+    const u8 *data() const { return buffer.get(); }
+    usize getSize() const { return size; }
+
+    // Indicates if the buffer is shared with other images
+    bool isShared() const { return buffer.use_count() > 1; }
+
+    // Returns a writable copy of the image
+    u8 *modify();
+
+    // Shares the image with all images that have the same contents
+    void commit();
+
+
+    //
+    // Serializing
+    //
+
+public:
+
+    template <class T>
+    void applyToItems(T& worker)
+    {
+        if constexpr (std::is_same<T, SerCounter>::value) {
+
+            worker.count += size;
+
+        } else if constexpr (std::is_same<T, SerWriter>::value) {
+
+            worker.copy(buffer.get(), size);
+
+        } else if constexpr (std::is_same<T, SerHasher>::value) {
+
+            // A shared buffer is represented by its checksum
+            if (isPrivate) {
+                worker.copy(buffer.get(), size);
+            } else {
+                worker.hash = fnv_1a_it64(worker.hash, checksum);
+            }
+
+        } else if constexpr (std::is_same<T, SerReader>::value) {
+
+            // Only copy the image if the snapshot contains different data
+            if (memcmp(worker.ptr, buffer.get(), size) != 0) {
+                memcpy(modify(), worker.ptr, size);
+            }
+            worker.ptr += size;
+            commit();
+
+        } else {
+
+            for (usize i = 0; i < size; i++) {
+
+                u8 byte = buffer[i];
+                worker & byte;
+                if (byte != buffer[i]) modify()[i] = byte;
+            }
+            commit();
+        }
+    }
+};
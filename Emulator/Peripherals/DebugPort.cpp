@@ -0,0 +1,112 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "DebugPort.h"
+
+void
+DebugPort::setEnabled(bool value)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    enabled = value;
+}
+
+u8
+DebugPort::peek(u16 addr) const
+{
+    assert(matches(addr));
+
+    // The other registers are write-only
+    return addr == base ? 0x64 : 0x00;
+}
+
+bool
+DebugPort::poke(u16 addr, u8 value)
+{
+    assert(matches(addr));
+
+    std::lock_guard<std::mutex> guard(mutex);
+
+    switch (addr - base) {
+
+        case 0x0:
+
+            if (output.isFull()) lost++; else output.write(value);
+            return false;
+
+        case 0x1:
+
+            selected = value % numCounters;
+            return false;
+
+        case 0x2:
+
+            counters[selected] += value;
+            return false;
+
+        case 0x3:
+
+            counters[selected] = 0;
+            return false;
+
+        case 0xF:
+
+            exitCode = value;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+isize
+DebugPort::read(u8 *buffer, isize count)
+{
+    assert(buffer);
+
+    std::lock_guard<std::mutex> guard(mutex);
+
+    isize n = std::min(count, (isize)output.count());
+    for (isize i = 0; i < n; i++) buffer[i] = output.read();
+    return n;
+}
+
+u64
+DebugPort::dropped() const
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    return lost;
+}
+
+u64
+DebugPort::counter(isize nr) const
+{
+    assert(nr >= 0 && nr < numCounters);
+
+    std::lock_guard<std::mutex> guard(mutex);
+    return counters[nr];
+}
+
+long
+DebugPort::getExitCode() const
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    return exitCode;
+}
+
+void
+DebugPort::clear()
+{
+    std::lock_guard<std::mutex> guard(mutex);
+
+    output.clear();
+    lost = 0;
+    for (isize i = 0; i < numCounters; i++) counters[i] = 0;
+    selected = 0;
+    exitCode = -1;
+}
@@ -0,0 +1,107 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include "Buffers.h"
+#include <mutex>
+
+/* Register block that lets guest code report results to the host. When
+ * enabled, the block occupies the upper 16 bytes of the I/O 2 area and hides
+ * the attached cartridge in this range:
+ *
+ *     $DFF0 (write)  Appends a byte to the output buffer
+ *     $DFF0 (read)   Returns the identification byte $64 ('d')
+ *     $DFF1 (write)  Selects a counter (0 - 7)
+ *     $DFF2 (write)  Adds the written value to the selected counter
+ *     $DFF3 (write)  Clears the selected counter
+ *     $DFFF (write)  Terminates the run with the written exit code
+ *
+ * The output buffer, the counters, and the exit code live on the host side.
+ * They are not part of the emulator state. Writing the exit code stops a
+ * headless run with HEADLESS_EXIT_GUEST in the same cycle. A threaded
+ * emulator is paused and MSG_GUEST_EXIT is sent.
+ */
+class DebugPort {
+
+public:
+
+    // Number of counters
+    static constexpr isize numCounters = 8;
+
+    // First register address
+    static constexpr u16 base = 0xDFF0;
+
+private:
+
+    // Indicates if the register block is visible to the CPU
+    bool enabled = false;
+
+    // Bytes written by the guest (bytes are dropped if the buffer is full)
+    RingBuffer<u8, 4096> output;
+    u64 lost = 0;
+
+    // Counters
+    u64 counters[numCounters] = { };
+    u8 selected = 0;
+
+    // Exit code (-1 = the guest hasn't terminated)
+    long exitCode = -1;
+
+    // Protects the data read by the host
+    mutable std::mutex mutex;
+
+
+    //
+    // Configuring
+    //
+
+public:
+
+    bool isEnabled() const { return enabled; }
+    void setEnabled(bool value);
+
+    // Checks if an I/O 2 address is served by the register block
+    bool matches(u16 addr) const { return enabled && addr >= base; }
+
+
+    //
+    // Accessing (emulator thread)
+    //
+
+public:
+
+    u8 peek(u16 addr) const;
+
+    // Returns true if the guest has terminated the run
+    bool poke(u16 addr, u8 value);
+
+
+    //
+    // Reading the results (any thread)
+    //
+
+public:
+
+    // Moves up to count bytes of the output buffer into a buffer
+    isize read(u8 *buffer, isize count);
+
+    // Returns the number of bytes dropped because the output buffer was full
+    u64 dropped() const;
+
+    // Returns the value of a counter
+    u64 counter(isize nr) const;
+
+    // Returns the exit code (-1 if the guest hasn't terminated)
+    long getExitCode() const;
+
+    // Clears the output buffer, the counters, and the exit code
+    void clear();
+};
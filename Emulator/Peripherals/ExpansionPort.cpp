@@ -47,9 +47,17 @@ ExpansionPort::_load(u8 *buffer)
     
     // Load cartridge (if any)
     if (crtType != CRT_NONE) {
+        
+        // A file-backed RAM is handed over to the new cartridge
+        std::unique_ptr<Cartridge> old = std::move(cartridge);
         cartridge = std::unique_ptr<Cartridge>(Cartridge::makeWithType(c64, crtType));
+        if (old) cartridge->takeRamFile(*old);
         reader.ptr += cartridge->load(reader.ptr);
     }
+
+    // Refresh the direct access pointers into the cartridge ROM
+    mem.updatePageTables();
+    mem.updateIOTables();
     
     trace(SNP_DEBUG, "Recreated from %ld bytes\n", reader.ptr - buffer);
     return reader.ptr - buffer;
@@ -71,6 +79,39 @@ ExpansionPort::_save(u8 *buffer)
     return writer.ptr - buffer;
 }
 
+u64
+ExpansionPort::_hash()
+{
+    SerHasher hasher;
+    applyToPersistentItems(hasher);
+    applyToResetItems(hasher);
+    
+    // Hash cartridge (if any)
+    if (crtType != CRT_NONE) {
+        hasher.hash = fnv_1a_it64(hasher.hash, cartridge->hash());
+    }
+    
+    return hasher.hash;
+}
+
+u64
+ExpansionPort::stateStamp()
+{
+    if (cartridge) {
+        
+        u64 stamp = cartridge->stateStamp();
+        for (HardwareComponent *c : cartridge->subComponents) {
+            stamp = fnv_1a_it64(stamp, c->stateStamp());
+        }
+        if (stamp != cartridgeStamp) {
+            
+            cartridgeStamp = stamp;
+            markDirty();
+        }
+    }
+    return HardwareComponent::stateStamp();
+}
+
 void
 ExpansionPort::_dump() const
 {
@@ -85,6 +126,13 @@ ExpansionPort::_dump() const
     } else {
         cartridge->dump();
     }
+    
+    msg("\n");
+    msg("Bank switches:  %llu\n", stats.bankSwitches);
+    msg(" IO1 accesses:  %llu reads, %llu writes\n", stats.io1Reads, stats.io1Writes);
+    msg(" IO2 accesses:  %llu reads, %llu writes\n", stats.io2Reads, stats.io2Writes);
+    msg("    ROM reads:  %llu (ROML), %llu (ROMH)\n", stats.romlReads, stats.romhReads);
+    msg("Virtual calls:  %llu (peek), %llu (poke)\n", stats.peeks, stats.pokes);
 }
 
 CartridgeType
@@ -93,10 +141,28 @@ ExpansionPort::getCartridgeType()
     return cartridge ? cartridge->getCartridgeType() : CRT_NONE;
 }
 
+CartridgeStats
+ExpansionPort::getStats()
+{
+    CartridgeStats result;
+    synchronized { result = stats; }
+    return result;
+}
+
+void
+ExpansionPort::clearStats()
+{
+    synchronized { memset(&stats, 0, sizeof(stats)); }
+}
+
 u8
 ExpansionPort::peek(u16 addr)
 {
-    return cartridge ? cartridge->peek(addr) : 0;
+    if (!cartridge) return 0;
+    
+    stats.peeks++;
+    addr < 0xA000 ? stats.romlReads++ : stats.romhReads++;
+    return cartridge->peek(addr);
 }
 
 u8
@@ -105,6 +171,12 @@ ExpansionPort::spypeek(u16 addr) const
     return cartridge ? cartridge->spypeek(addr) : 0;
 }
 
+const u8 *
+ExpansionPort::mappedPage(u8 page) const
+{
+    return cartridge ? cartridge->mappedPage(page) : nullptr;
+}
+
 u8
 ExpansionPort::peekIO1(u16 addr)
 {
@@ -115,7 +187,10 @@ ExpansionPort::peekIO1(u16 addr)
      *  Lesen von offenen Adressen liefert nämlich auf vielen C64 das zuletzt vom
      *  VIC gelesene Byte zurück!)" [C.B.]
      */
-    return cartridge ? cartridge->peekIO1(addr) : vic.getDataBusPhi1();
+    if (!cartridge) return vic.getDataBusPhi1();
+    
+    stats.io1Reads++;
+    return cartridge->peekIO1(addr);
 }
 
 u8
@@ -127,7 +202,10 @@ ExpansionPort::spypeekIO1(u16 addr) const
 u8
 ExpansionPort::peekIO2(u16 addr)
 {
-    return cartridge ? cartridge->peekIO2(addr) : vic.getDataBusPhi1();
+    if (!cartridge) return vic.getDataBusPhi1();
+    
+    stats.io2Reads++;
+    return cartridge->peekIO2(addr);
 }
 
 u8
@@ -140,6 +218,7 @@ void
 ExpansionPort::poke(u16 addr, u8 value)
 {
     if (cartridge) {
+        stats.pokes++;
         cartridge->poke(addr, value);
     } else if (!c64.getUltimax()) {
         mem.ram[addr] = value;
@@ -151,7 +230,10 @@ ExpansionPort::pokeIO1(u16 addr, u8 value)
 {
     assert(addr >= 0xDE00 && addr <= 0xDEFF);
     
-    if (cartridge) cartridge->pokeIO1(addr, value);
+    if (cartridge) {
+        stats.io1Writes++;
+        cartridge->pokeIO1(addr, value);
+    }
 }
 
 void
@@ -159,13 +241,23 @@ ExpansionPort::pokeIO2(u16 addr, u8 value)
 {
     assert(addr >= 0xDF00 && addr <= 0xDFFF);
     
-    if (cartridge) cartridge->pokeIO2(addr, value);
+    if (cartridge) {
+        stats.io2Writes++;
+        cartridge->pokeIO2(addr, value);
+    }
+}
+
+void
+ExpansionPort::didPokeFF00()
+{
+    if (cartridge) cartridge->didPokeFF00();
 }
 
 void
 ExpansionPort::setGameLine(bool value)
 {
     gameLine = value;
+    markDirty();
     vic.setUltimax(!gameLine && exromLine);
     mem.updatePeekPokeLookupTables();
 }
@@ -174,6 +266,7 @@ void
 ExpansionPort::setExromLine(bool value)
 {
     exromLine = value;
+    markDirty();
     vic.setUltimax(!gameLine && exromLine);
     mem.updatePeekPokeLookupTables();
 }
@@ -183,6 +276,7 @@ ExpansionPort::setGameAndExrom(bool game, bool exrom)
 {
     gameLine = game;
     exromLine = exrom;
+    markDirty();
     vic.setUltimax(!gameLine && exromLine);
     mem.updatePeekPokeLookupTables();
 }
@@ -221,6 +315,9 @@ ExpansionPort::attachCartridge(Cartridge *c)
     detachCartridge();
     cartridge = std::unique_ptr<Cartridge>(c);
     crtType = c->getCartridgeType();
+    stats = { };
+    markDirty();
+    mem.updateIOTables();
     
     // Reset cartridge to update exrom and game line on the expansion port
     cartridge->reset();
@@ -244,6 +341,41 @@ ExpansionPort::attachGeoRamCartridge(usize kb)
     attachCartridge(geoRAM);
 }
 
+void
+ExpansionPort::attachGeoRamCartridge(usize kb, const string &path)
+{
+    debug(EXP_DEBUG, "Attaching GeoRAM cartridge (%zu KB, %s)", kb, path.c_str());
+
+    // kb must be a power of two between 64 and 4096
+    if (kb < 64 || kb > 4096 || (kb & (kb - 1))) throw VC64Error(ERROR_OPT_INV_ARG);
+    
+    Cartridge *geoRAM = Cartridge::makeWithType(c64, CRT_GEO_RAM);
+    try { geoRAM->mapRam(path, kb * 1024); }
+    catch (VC64Error &) { delete geoRAM; throw; }
+    attachCartridge(geoRAM);
+}
+
+void
+ExpansionPort::attachGeoRamCartridge(usize kb, const string &path, ErrorCode *err)
+{
+    *err = ERROR_OK;
+    try { attachGeoRamCartridge(kb, path); }
+    catch (VC64Error &exception) { *err = exception.errorCode; }
+}
+
+void
+ExpansionPort::attachReuCartridge(usize kb)
+{
+    debug(EXP_DEBUG, "Attaching REU cartridge (%zu KB)", kb);
+
+    // kb must be a power of two between 128 and 16384
+    if (kb < 128 || kb > 16384 || (kb & (kb - 1))) assert(false);
+    
+    Cartridge *reu = Cartridge::makeWithType(c64, CRT_REU);
+    reu->setRamCapacity(kb * 1024);
+    attachCartridge(reu);
+}
+
 bool
 ExpansionPort::attachCartridge(CRTFile *file, bool reset)
 {
@@ -270,6 +402,30 @@ ExpansionPort::attachCartridge(CRTFile *file, bool reset)
     return true;
 }
 
+isize
+ExpansionPort::writeBack(CRTFile &crt)
+{
+    if (!cartridge) return 0;
+    
+    isize result;
+    
+    suspend();
+    try { result = cartridge->writeBack(crt); }
+    catch (VC64Error &) { resume(); throw; }
+    resume();
+    
+    return result;
+}
+
+isize
+ExpansionPort::writeBack(CRTFile &crt, ErrorCode *err)
+{
+    *err = ERROR_OK;
+    try { return writeBack(crt); }
+    catch (VC64Error &exception) { *err = exception.errorCode; }
+    return 0;
+}
+
 void
 ExpansionPort::attachIsepicCartridge()
 {
@@ -288,6 +444,7 @@ ExpansionPort::detachCartridge()
         
         cartridge = nullptr;
         crtType = CRT_NONE;
+        mem.updateIOTables();
         
         setCartridgeMode(CRTMODE_OFF);
         
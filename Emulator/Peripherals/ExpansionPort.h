@@ -40,6 +40,12 @@ class ExpansionPort : public C64Component {
     bool gameLine = 1;
     bool exromLine = 1;
     
+    // Combined state stamps of the cartridge and its subcomponents
+    u64 cartridgeStamp = 0;
+    
+    // Access statistics of the attached cartridge
+    CartridgeStats stats = { };
+    
     
     //
     // Initializing
@@ -64,6 +70,17 @@ public:
     
     CartridgeType getCartridgeType();
 
+    /* Returns the access statistics of the attached cartridge. The counters
+     * are cleared whenever a cartridge is attached. Reads from ROM pages
+     * which are mapped directly into the memory tables bypass the cartridge
+     * and are not counted (see Cartridge::mappedPage()).
+     */
+    CartridgeStats getStats();
+    void clearStats();
+    
+    // Called by the attached cartridge when a chip is banked in or out
+    void countBankSwitch() { stats.bankSwitches++; }
+
 private:
     
     void _dump() const override;
@@ -91,8 +108,25 @@ private:
     }
     
     usize _size() override;
+    usize _objectSize() const override { return sizeof(*this); }
+    bool hasFixedSize() const override { return false; }
     usize _load(u8 *buffer) override;
     usize _save(u8 *buffer) override;
+    u64 _hash() override;
+
+    
+    //
+    // Tracking changes
+    //
+    
+public:
+    
+    /* The attached cartridge is serialized as part of the expansion port.
+     * Hence, the port changes whenever the cartridge changes. Cartridges
+     * which don't track their changes are considered to change all the time.
+     */
+    bool tracksChanges() const override { return true; }
+    u64 stateStamp() override;
 
  
     //
@@ -103,6 +137,10 @@ public:
     
     u8 peek(u16 addr);
     u8 spypeek(u16 addr) const;
+    
+    // Returns a direct pointer to a ROML or ROMH page (see Cartridge)
+    const u8 *mappedPage(u8 page) const;
+    
     u8 peekIO1(u16 addr);
     u8 spypeekIO1(u16 addr) const;
     u8 peekIO2(u16 addr);
@@ -112,6 +150,9 @@ public:
     void pokeIO1(u16 addr, u8 value);
     void pokeIO2(u16 addr, u8 value);
     
+    // Informs the cartridge about a write to $FF00 (see C64Memory::trapFF00)
+    void didPokeFF00();
+    
     
     //
     // Controlling the Game and Exrom lines
@@ -142,11 +183,25 @@ public:
     bool attachCartridge(CRTFile *c, bool reset = true);
     void attachCartridge(Cartridge *c);
     void attachGeoRamCartridge(usize capacity);
+    
+    /* Attaches a GeoRAM cartridge whose RAM is mapped from a file. The RAM
+     * contents persist across sessions and snapshots only store the pages
+     * that differ from the file.
+     */
+    void attachGeoRamCartridge(usize capacity, const string &path) throws;
+    void attachGeoRamCartridge(usize capacity, const string &path, ErrorCode *err);
+    void attachReuCartridge(usize capacity);
     void attachIsepicCartridge();
 
     // Removes a cartridge from the expansion port (if any)
     void detachCartridge();
     void detachCartridgeAndReset();
+    
+    /* Writes modified cartridge data back into the CRT file the attached
+     * cartridge has been created from (see Cartridge::writeBack())
+     */
+    isize writeBack(CRTFile &crt) throws;
+    isize writeBack(CRTFile &crt, ErrorCode *err);
 
     
     //
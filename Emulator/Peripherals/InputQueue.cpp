@@ -0,0 +1,173 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+
+bool
+InputQueue::isValid(const InputEvent &event)
+{
+    switch (event.type) {
+
+        case INPUT_EVENT_PRESS_KEY:
+        case INPUT_EVENT_RELEASE_KEY:
+
+            return event.data >= 0 && event.data < 66;
+
+        case INPUT_EVENT_RELEASE_KEYS:
+
+            return true;
+
+        case INPUT_EVENT_WARP:
+
+            return event.data == 0 || event.data == 1;
+
+        case INPUT_EVENT_SYNC:
+
+            return event.data >= 0;
+
+        case INPUT_EVENT_JOYSTICK:
+        case INPUT_EVENT_MOUSE:
+
+            if (!GamePadActionEnum::isValid(event.data)) return false;
+            [[fallthrough]];
+
+        case INPUT_EVENT_MOUSE_MOVE:
+
+            return event.port == PORT_ONE || event.port == PORT_TWO;
+
+        default:
+            return false;
+    }
+}
+
+usize
+InputQueue::submit(const InputEvent *events, usize count)
+{
+    assert(events || count == 0);
+
+    usize wi = w.load(std::memory_order_relaxed);
+    usize ri = h.load(std::memory_order_acquire);
+    usize free = (ri - wi - 1) & mask;
+
+    // Take the events in the caller's order as long as the queue has space
+    std::vector<InputEvent> batch;
+    usize i = 0;
+    for (; i < count; i++) {
+
+        if (!isValid(events[i])) {
+            warn("Ignoring invalid input event (%s)\n",
+                 InputEventTypeEnum::key(events[i].type));
+            continue;
+        }
+        if (batch.size() == free) break;
+        batch.push_back(events[i]);
+    }
+
+    // Sort the taken events by cycle
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const InputEvent &a, const InputEvent &b) {
+        return a.cycle < b.cycle;
+    });
+
+    for (InputEvent &event : batch) {
+
+        // Keep the queue in chronological order
+        if (event.cycle < lastCycle) event.cycle = lastCycle;
+        lastCycle = event.cycle;
+
+        queue[wi] = event;
+        wi = (wi + 1) & mask;
+    }
+
+    w.store(wi, std::memory_order_release);
+    return i;
+}
+
+void
+InputQueue::submit(InputEventType type, PortId port, long data, long x, long y)
+{
+    InputEvent event = { (i64)cpu.cycle + 1, type, port, data, x, y };
+    submit(&event, 1);
+}
+
+void
+InputQueue::execute(Cycle cycle)
+{
+    usize ri = r.load(std::memory_order_relaxed);
+    usize wi = w.load(std::memory_order_acquire);
+
+    while (ri != wi && queue[ri].cycle <= cycle) {
+
+        // Record the event with the cycle it takes effect in
+        if (c64.inputLog.isRecording() && queue[ri].type != INPUT_EVENT_SYNC) {
+            c64.inputLog.record(queue[ri], cycle);
+        }
+
+        perform(queue[ri]);
+        ri = (ri + 1) & mask;
+    }
+
+    r.store(ri, std::memory_order_release);
+    if (!held) h.store(ri, std::memory_order_release);
+}
+
+void
+InputQueue::perform(const InputEvent &event)
+{
+    debug(KBD_DEBUG, "%lld: %s %ld\n",
+          event.cycle, InputEventTypeEnum::key(event.type), event.data);
+
+    ControlPort &port = event.port == PORT_ONE ? port1 : port2;
+
+    switch (event.type) {
+
+        case INPUT_EVENT_PRESS_KEY:
+
+            keyboard._press(event.data);
+            break;
+
+        case INPUT_EVENT_RELEASE_KEY:
+
+            keyboard._release(event.data);
+            break;
+
+        case INPUT_EVENT_RELEASE_KEYS:
+
+            keyboard._releaseAll();
+            break;
+
+        case INPUT_EVENT_JOYSTICK:
+
+            port.joystick._trigger((GamePadAction)event.data);
+            break;
+
+        case INPUT_EVENT_MOUSE:
+
+            port.mouse._trigger((GamePadAction)event.data);
+            break;
+
+        case INPUT_EVENT_MOUSE_MOVE:
+
+            port.mouse._setXY(event.x, event.y);
+            break;
+
+        case INPUT_EVENT_WARP:
+
+            c64.setWarpNow(event.data);
+            break;
+
+        case INPUT_EVENT_SYNC:
+
+            c64.inputLog.scheduleSync(c64, event.data);
+            break;
+
+        default:
+            assert(false);
+    }
+}
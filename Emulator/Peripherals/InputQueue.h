@@ -0,0 +1,125 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Component.h"
+#include <atomic>
+
+/* A timeline of keyboard, joystick, and mouse events. Each event carries the
+ * CPU cycle it takes effect in, which makes it possible to replay a recorded
+ * session deterministically at any speed.
+ *
+ * The queue is a lock-free single-producer, single-consumer ring. The host
+ * thread submits events in batches. The emulator thread consumes them in the
+ * run loop. Events are kept in chronological order. Each batch is sorted by
+ * cycle before it is inserted, and events that refer to an earlier cycle than
+ * a previously submitted event are moved to the cycle of that event. Events
+ * whose cycle has already passed take effect in the next cycle.
+ *
+ * Pending events are neither part of a snapshot nor affected by a reset.
+ */
+class InputQueue : public C64Component {
+
+    // Capacity of the event queue (must be a power of two)
+    static constexpr usize capacity = 1 << 12;
+    static constexpr usize mask = capacity - 1;
+
+    // The event queue
+    InputEvent queue[capacity];
+    std::atomic<usize> r {0};
+    std::atomic<usize> w {0};
+
+    /* Oldest slot that must not be overwritten. It is kept behind the read
+     * position while the emulator runs ahead of time (see RunAhead), because
+     * all events performed in the meantime are performed again afterwards.
+     */
+    std::atomic<usize> h {0};
+    bool held = false;
+
+    // Cycle of the most recently submitted event
+    Cycle lastCycle = 0;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    InputQueue(C64 &ref) : C64Component(ref) { }
+    const char *getDescription() const override { return "InputQueue"; }
+
+private:
+
+    void _reset() override { }
+
+
+    //
+    // Serializing
+    //
+
+private:
+
+    usize _size() override { return 0; }
+    usize _objectSize() const override { return sizeof(*this); }
+    usize _load(u8 *buffer) override { return 0; }
+    usize _save(u8 *buffer) override { return 0; }
+
+
+    //
+    // Submitting events (host thread)
+    //
+
+public:
+
+    /* Inserts a batch of events and returns the number of events taken from
+     * the batch. It is less than count if the queue runs full. In this case,
+     * the leading events of the batch (in the caller's order) have been taken
+     * and the remaining ones can be submitted again. Invalid events are
+     * dropped and count as taken.
+     */
+    usize submit(const InputEvent *events, usize count);
+
+    // Submits a single event taking effect in the next cycle
+    void submit(InputEventType type, PortId port, long data, long x = 0, long y = 0);
+
+
+    //
+    // Processing events (emulator thread)
+    //
+
+public:
+
+    // Returns the cycle of the next pending event (INT64_MAX if none)
+    Cycle next() const
+    {
+        usize ri = r.load(std::memory_order_relaxed);
+        if (ri == w.load(std::memory_order_acquire)) return INT64_MAX;
+        return queue[ri].cycle;
+    }
+
+    // Performs all events that are due in the specified cycle
+    void execute(Cycle cycle);
+
+    // Discards all pending events (the host must not submit in the meantime)
+    void clear() { r = w.load(); h = r.load(); held = false; lastCycle = 0; }
+
+    // Keeps all events performed from now on (run-ahead)
+    void hold() { held = true; }
+
+    // Moves the read position back to where hold() has been called
+    void rewind() { r = h.load(); held = false; }
+
+    // Performs a single event (also used by Netplay)
+    void perform(const InputEvent &event);
+
+    // Checks if an event is well-formed
+    static bool isValid(const InputEvent &event);
+};
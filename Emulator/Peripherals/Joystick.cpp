@@ -25,17 +25,6 @@ Joystick::_dump() const
     msg("  bitmask : %02X\n", getControlPort());
 }
 
-usize
-Joystick::didLoadFromBuffer(u8 *buffer)
-{
-    // Discard any active joystick movements
-    button = false;
-    axisX = 0;
-    axisY = 0;
-
-    return 0;
-}
-
 void
 Joystick::setAutofire(bool value)
 {
@@ -79,6 +68,39 @@ Joystick::getControlPort() const
 
 void
 Joystick::trigger(GamePadAction event)
+{
+    if (c64.dropsHostInput()) return;
+    
+    if (c64.queuesHostInput()) {
+        c64.inputs.submit(INPUT_EVENT_JOYSTICK, port.nr, event);
+    } else {
+        _trigger(event);
+    }
+}
+
+void
+Joystick::releaseAll()
+{
+    if (c64.dropsHostInput()) return;
+    
+    if (c64.queuesHostInput()) {
+        c64.inputs.submit(INPUT_EVENT_JOYSTICK, port.nr, RELEASE_XY);
+        c64.inputs.submit(INPUT_EVENT_JOYSTICK, port.nr, RELEASE_FIRE);
+    } else {
+        _releaseAll();
+    }
+}
+
+void
+Joystick::_releaseAll()
+{
+    button = false;
+    axisX = 0;
+    axisY = 0;
+}
+
+void
+Joystick::_trigger(GamePadAction event)
 {
     debug(PORT_DEBUG, "Port %lld: %s\n", port.nr, GamePadActionEnum::key(event));
     
@@ -11,6 +11,9 @@
 
 class Joystick : public C64Component {
     
+    friend class InputQueue;
+    friend class C64;
+
     // Reference to the control port this device belongs to
     ControlPort &port;
   
@@ -80,9 +83,10 @@ private:
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
-    usize didLoadFromBuffer(u8 *buffer) override;
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
     
     
     //
@@ -118,9 +122,24 @@ public:
     // Reads the port bits that show up in the CIA's data port registers
     u8 getControlPort() const;
         
-    // Triggers a gamepad event
+    /* Triggers a gamepad event. The event is handed over to the input queue
+     * if required (see C64::queuesHostInput()).
+     */
     void trigger(GamePadAction event);
 
+    /* Releases the button and the stick. The request is handed over to the
+     * input queue if required (see C64::queuesHostInput()). Internal callers
+     * release the joystick directly via _releaseAll().
+     */
+    void releaseAll();
+
+private:
+
+    void _trigger(GamePadAction event);
+    void _releaseAll();
+
+public:
+
     /* Execution function for this control port. This method needs to be
      * invoked at the end of each frame to make the auto-fire mechanism work.
      */
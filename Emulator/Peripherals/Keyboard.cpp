@@ -44,8 +44,8 @@ Keyboard::_reset()
 {
     RESET_SNAPSHOT_ITEMS
 
-	// Reset the keyboard matrix
-    releaseAll();
+	// Reset the keyboard matrix (bypassing the input queue)
+    synchronized { _releaseAll(); }
 }
 
 void 
@@ -78,45 +78,64 @@ Keyboard::_dump() const
     msg("Shift lock: %s pressed\n", shiftLock ? "" : "not");
 }
 
-u8
-Keyboard::getRowValues(u8 columnMask)
+usize
+Keyboard::didLoadFromBuffer(u8 *buffer)
 {
-	u8 result = 0xff;
-		
-	for (unsigned i = 0; i < 8; i++) {
-		if (GET_BIT(columnMask, i)) {
-			result &= kbMatrixRow[i];
-		}
-	}
-    
-    // Check for shift lock
-    if (shiftLock && GET_BIT(columnMask, 6))
-        CLR_BIT(result, 4);
-	
-	return result;
+    updateScanTables();
+    return 0;
 }
 
-u8
-Keyboard::getColumnValues(u8 rowMask)
+void
+Keyboard::updateScanTables()
 {
-    u8 result = 0xff;
+    u8 rows[8], cols[8];
     
     for (unsigned i = 0; i < 8; i++) {
-        if (GET_BIT(rowMask, i)) {
-            result &= kbMatrixCol[i];
-        }
+        rows[i] = kbMatrixRow[i];
+        cols[i] = kbMatrixCol[i];
     }
     
     // Check for shift lock
-    if (shiftLock && GET_BIT(rowMask, 4))
-        CLR_BIT(result, 6);
+    if (shiftLock) {
+        CLR_BIT(rows[6], 4);
+        CLR_BIT(cols[4], 6);
+    }
     
-    return result;
+    // Each mask combines the mask without its lowest bit with a single line
+    rowValues[0] = columnValues[0] = 0xFF;
+    for (unsigned mask = 1; mask < 256; mask++) {
+        
+        unsigned line = __builtin_ctz(mask);
+        rowValues[mask] = rowValues[mask & (mask - 1)] & rows[line];
+        columnValues[mask] = columnValues[mask & (mask - 1)] & cols[line];
+    }
 }
 
 void
 Keyboard::press(long nr)
 {
+    if (c64.dropsHostInput()) return;
+    
+    if (c64.queuesHostInput()) {
+
+        // Abort auto-typing (the lock is only held for discarding the actions)
+        bool typing = false;
+        synchronized {
+
+            if (!actions.empty()) {
+
+                std::queue<KeyAction> empty;
+                std::swap(actions, empty);
+                typing = true;
+            }
+        }
+
+        // Let the input queue press the key in a well defined cycle
+        if (typing) submit(INPUT_EVENT_RELEASE_KEYS, 0);
+        submit(INPUT_EVENT_PRESS_KEY, nr);
+        return;
+    }
+
     synchronized {
 
         abortAutoTyping();
@@ -147,7 +166,13 @@ Keyboard::pressRestore()
 void
 Keyboard::release(long nr)
 {
-    synchronized { _release(nr); }
+    if (c64.dropsHostInput()) return;
+    
+    if (c64.queuesHostInput()) {
+        submit(INPUT_EVENT_RELEASE_KEY, nr);
+    } else {
+        synchronized { _release(nr); }
+    }
 }
 
 void
@@ -165,7 +190,19 @@ Keyboard::releaseRestore()
 void
 Keyboard::releaseAll()
 {
-    synchronized { _releaseAll(); }
+    if (c64.dropsHostInput()) return;
+    
+    if (c64.queuesHostInput()) {
+        submit(INPUT_EVENT_RELEASE_KEYS, 0);
+    } else {
+        synchronized { _releaseAll(); }
+    }
+}
+
+void
+Keyboard::submit(InputEventType type, long nr)
+{
+    c64.inputs.submit(type, PORT_ONE, nr);
 }
 
 void
@@ -192,6 +229,7 @@ Keyboard::_pressRowCol(u8 row, u8 col)
     
     kbMatrixRow[row] &= ~(1 << col);
     kbMatrixCol[col] &= ~(1 << row);
+    updateScanTables();
 }
 
 void
@@ -229,6 +267,7 @@ Keyboard::_releaseRowCol(u8 row, u8 col)
     
     kbMatrixRow[row] |= (1 << col);
     kbMatrixCol[col] |= (1 << row);
+    updateScanTables();
 }
 
 void
@@ -247,6 +286,7 @@ Keyboard::_releaseAll()
     for (unsigned i = 0; i < 8; i++) {
         kbMatrixRow[i] = kbMatrixCol[i] = 0xFF;
     }
+    updateScanTables();
     _releaseRestore();
 }
 
@@ -344,6 +384,9 @@ Keyboard::addDelay(i64 delay)
 void
 Keyboard::abortAutoTyping()
 {
+    typeText.clear();
+    typePos = 0;
+    
     if (!actions.empty()) {
 
         std::queue<KeyAction> empty;
@@ -353,6 +396,132 @@ Keyboard::abortAutoTyping()
     }
 }
 
+void
+Keyboard::type(const string &petscii, bool matrix)
+{
+    synchronized {
+        
+        typeText.erase(0, typePos);
+        typeText += petscii;
+        typePos = 0;
+        
+        if (matrix) typeViaMatrix();
+    }
+}
+
+bool
+Keyboard::isTyping()
+{
+    bool result;
+    synchronized { result = typePos < typeText.size() || !actions.empty(); }
+    return result;
+}
+
+void
+Keyboard::feedKeyboardBuffer()
+{
+    u8 *ram = mem.ram;
+    
+    // Fall back to the keyboard matrix if the Kernal isn't around
+    if (mem.getPeekSource(0xE000) != M_KERNAL || c64.inputLog.isRecording()) {
+        
+        typeViaMatrix();
+        return;
+    }
+    
+    /* Only refill an empty buffer. The Kernal shifts the buffer when it
+     * takes out a character. Appending characters to a non-empty buffer
+     * could interfere with this. The buffer size is checked, too, because it
+     * is only valid after the Kernal has initialized the screen editor.
+     */
+    isize size = ram[0x289];
+    if (ram[0xC6] || size == 0 || size > 10) return;
+    
+    isize count = std::min((isize)(typeText.size() - typePos), size);
+    memcpy(ram + 0x277, typeText.data() + typePos, count);
+    ram[0xC6] = (u8)count;
+    mem.markDirty(0x0000, 0x300);
+    typePos += count;
+    
+    debug(KBD_DEBUG, "Injected %ld characters\n", count);
+}
+
+void
+Keyboard::typeViaMatrix()
+{
+    for (; typePos < typeText.size(); typePos++) {
+        
+        u8 row, col;
+        bool shift;
+        
+        if (!lookupKey((u8)typeText[typePos], row, col, shift)) {
+            
+            debug(KBD_DEBUG, "Can't type %02X\n", (u8)typeText[typePos]);
+            continue;
+        }
+        
+        // Hold the key long enough for the Kernal's scan routine
+        if (shift) _scheduleKeyAction(KeyAction::Action::press, 1, 7, 1);
+        _scheduleKeyAction(KeyAction::Action::press, row, col, shift ? 0 : 1);
+        _scheduleKeyAction(KeyAction::Action::releaseAll, 0, 2);
+    }
+    
+    typeText.clear();
+    typePos = 0;
+}
+
+bool
+Keyboard::lookupKey(u8 petscii, u8 &row, u8 &col, bool &shift)
+{
+    // Unshifted PETSCII characters in matrix order (row by row)
+    static constexpr u8 keys[64] = {
+        
+        0x14, 0x0D, 0x1D, 0x88, 0x85, 0x86, 0x87, 0x11,
+        0x33, 0x57, 0x41, 0x34, 0x5A, 0x53, 0x45, 0x00,
+        0x35, 0x52, 0x44, 0x36, 0x43, 0x46, 0x54, 0x58,
+        0x37, 0x59, 0x47, 0x38, 0x42, 0x48, 0x55, 0x56,
+        0x39, 0x49, 0x4A, 0x30, 0x4D, 0x4B, 0x4F, 0x4E,
+        0x2B, 0x50, 0x4C, 0x2D, 0x2E, 0x3A, 0x40, 0x2C,
+        0x5C, 0x2A, 0x3B, 0x13, 0x00, 0x3D, 0x5E, 0x2F,
+        0x31, 0x5F, 0x00, 0x32, 0x20, 0x00, 0x51, 0x03
+    };
+    
+    // Shifted characters which are not derived from their key by a fixed offset
+    static constexpr u8 shifted[][2] = {
+        
+        { 0x21, 0x31 }, { 0x22, 0x32 }, { 0x23, 0x33 }, { 0x24, 0x34 },
+        { 0x25, 0x35 }, { 0x26, 0x36 }, { 0x27, 0x37 }, { 0x28, 0x38 },
+        { 0x29, 0x39 }, { 0x5B, 0x3A }, { 0x5D, 0x3B }, { 0x3C, 0x2C },
+        { 0x3E, 0x2E }, { 0x3F, 0x2F }, { 0x94, 0x14 }, { 0x93, 0x13 },
+        { 0x9D, 0x1D }, { 0x91, 0x11 }, { 0x89, 0x85 }, { 0x8A, 0x86 },
+        { 0x8B, 0x87 }, { 0x8C, 0x88 }, { 0x8D, 0x0D }, { 0xA0, 0x20 }
+    };
+    
+    shift = false;
+    
+    // Shifted letters
+    if ((petscii >= 0x61 && petscii <= 0x7A) || (petscii >= 0xC1 && petscii <= 0xDA)) {
+        
+        petscii = (petscii & 0x1F) | 0x40;
+        shift = true;
+    }
+    for (auto &entry : shifted) {
+        
+        if (entry[0] == petscii) { petscii = entry[1]; shift = true; break; }
+    }
+    
+    for (u8 i = 0; i < 64; i++) {
+        
+        if (keys[i] == petscii && petscii) {
+            
+            row = i / 8;
+            col = i % 8;
+            return true;
+        }
+    }
+    return false;
+}
+
 void
 Keyboard::_scheduleKeyAction(KeyAction::Action type, long nr, i64 delay)
 {
@@ -374,9 +543,17 @@ Keyboard::_scheduleKeyAction(KeyAction::Action type, u8 row, u8 col, i64 delay)
 void
 Keyboard::vsyncHandler()
 {
+    // Refill the Kernal's keyboard buffer
+    synchronized { if (typePos < typeText.size()) feedKeyboardBuffer(); }
+    
     // Only proceed if the timer fires
     if (delay--) return;
 
+    // Auto-typed keys are recorded as if the input queue had pressed them
+    auto record = [&](InputEventType type, long nr) {
+        if (c64.inputLog.isRecording()) c64.inputLog.record(type, nr, cpu.cycle + 1);
+    };
+
     // Process all pending auto-typing events
     synchronized {
         
@@ -398,18 +575,21 @@ Keyboard::vsyncHandler()
                     
                     debug(KBD_DEBUG, "Pressing (%d,%d)\n", action.row, action.col);
                     _press(action.nr);
+                    record(INPUT_EVENT_PRESS_KEY, action.nr);
                     break;
                     
                 case KeyAction::Action::release:
 
                     debug(KBD_DEBUG, "Releasing (%d,%d)\n", action.row, action.col);
                     _release(action.nr);
+                    record(INPUT_EVENT_RELEASE_KEY, action.nr);
                     break;
 
                 case KeyAction::Action::releaseAll:
                     
                     debug(KBD_DEBUG, "Releasing all\n");
                     _releaseAll();
+                    record(INPUT_EVENT_RELEASE_KEYS, 0);
                     break;
             }
                     
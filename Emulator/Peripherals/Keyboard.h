@@ -35,6 +35,8 @@ struct KeyAction {
 class Keyboard : public C64Component {
     
     friend struct KeyAction;
+    friend class InputQueue;
+    friend class C64;
     
     // Maping from key numbers to keyboard matrix positions
     static constexpr u8 rowcol[66][2] =
@@ -68,6 +70,12 @@ class Keyboard : public C64Component {
 
     // Indicates if the shift lock is currently pressed
     bool shiftLock = false;
+    
+    /* Precomputed results of getRowValues() and getColumnValues() for all
+     * possible masks. Both tables are rebuilt when the matrix changes.
+     */
+    u8 rowValues[256];
+    u8 columnValues[256];
         
     // Key action list (for auto typing)
     std::queue<KeyAction> actions;
@@ -75,6 +83,13 @@ class Keyboard : public C64Component {
     // Delay counter until the next key action is processed
     i64 delay = 0;
     
+    /* Text typed via the Kernal's keyboard buffer (see type()). Whenever the
+     * buffer has been drained, the next chunk of characters is copied into it
+     * at the end of a frame.
+     */
+    string typeText;
+    usize typePos = 0;
+    
     
     //
     // Initializing
@@ -82,7 +97,7 @@ class Keyboard : public C64Component {
     
 public:
     
-    Keyboard(C64 &ref) : C64Component(ref) { }
+    Keyboard(C64 &ref) : C64Component(ref) { updateScanTables(); }
     const char *getDescription() const override { return "Keyboard"; }
 
 private:
@@ -121,8 +136,11 @@ private:
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
+    usize didLoadFromBuffer(u8 *buffer) override;
     
 
     //
@@ -150,7 +168,7 @@ public:
 	void pressRunstop() { pressRowCol(7,7); }
     void pressLeftShift() { pressRowCol(1,7); }
     void pressRightShift() { pressRowCol(6,4); }
-    void pressShiftLock() { shiftLock = true; }
+    void pressShiftLock() { shiftLock = true; updateScanTables(); }
     void pressRestore();
 
 	// Releases a pressed key
@@ -161,10 +179,13 @@ public:
 	void releaseRunstop() { releaseRowCol(7,7); }
     void releaseLeftShift() { releaseRowCol(1,7); }
     void releaseRightShift() { releaseRowCol(6,4); }
-    void releaseShiftLock() { shiftLock = false; }
+    void releaseShiftLock() { shiftLock = false; updateScanTables(); }
     void releaseRestore();
     
-    // Clears the keyboard matrix
+    /* Clears the keyboard matrix. The request is handed over to the input
+     * queue if required (see C64::queuesHostInput()). Internal callers clear
+     * the matrix directly via _releaseAll().
+     */
     void releaseAll();
     
     // Presses a released key and vice versa
@@ -172,7 +193,7 @@ public:
     void toggle(u8 row, u8 col);
     void toggleLeftShift() { toggle(1,7); }
     void toggleRightShift() { toggle(6,4); }
-    void toggleShiftLock() { shiftLock = !shiftLock; }
+    void toggleShiftLock() { shiftLock = !shiftLock; updateScanTables(); }
     void toggleCommodore() { toggle(7,5); }
     void toggleCtrl() { toggle(7,2); }
     void toggleRunstop() { toggle(7,7); }
@@ -188,6 +209,9 @@ private:
     void _releaseRestore();
 
     void _releaseAll();
+
+    // Hands a key event over to the input queue (see C64::queuesHostInput())
+    void submit(InputEventType type, long nr);
     
     
     //
@@ -197,8 +221,13 @@ private:
 public:
     
 	// Reads a row or a column from the keyboard matrix
-	u8 getRowValues(u8 columnMask);
-    u8 getColumnValues(u8 rowMask);
+	u8 getRowValues(u8 columnMask) const { return rowValues[columnMask]; }
+    u8 getColumnValues(u8 rowMask) const { return columnValues[rowMask]; }
+
+private:
+    
+    // Rebuilds the lookup tables used by getRowValues and getColumnValues
+    void updateScanTables();
     
     
     //
@@ -213,13 +242,34 @@ public:
     void scheduleKeyRelease(u8 row, u8 col, i64 delay);
     void scheduleKeyReleaseAll(i64 delay);
 
+    // Deletes all pending actions and clears the keyboard matrix
+    void abortAutoTyping();
+
+    /* Types a PETSCII string. By default, the characters are written
+     * directly into the Kernal's keyboard buffer ($0277 - $0280, count in
+     * $C6) in chunks whenever the buffer has been drained, which is much
+     * faster than pressing keys. The keyboard matrix is used instead if the
+     * Kernal Rom is banked out, if an input log is being recorded, or if
+     * matrix is set (for programs that scan the keyboard themselves).
+     */
+    void type(const string &petscii, bool matrix = false);
+
+    // Indicates if characters are waiting to be typed (any thread)
+    bool isTyping();
+
 private:
     
+    // Copies the next chunk of characters into the Kernal's keyboard buffer
+    void feedKeyboardBuffer();
+    
+    // Types the remaining characters via the keyboard matrix
+    void typeViaMatrix();
+    
+    // Looks up the key (and the shift state) producing a PETSCII character
+    static bool lookupKey(u8 petscii, u8 &row, u8 &col, bool &shift);
+    
     // Inserts a delay after the last pending action
     void addDelay(i64 delay);
-
-    // Deletes all pending actions and clears the keyboard matrix
-    void abortAutoTyping();
     
     // Workhorses for scheduleKeyPress and scheduleKeyRelease
     void _scheduleKeyAction(KeyAction::Action type, long nr, i64 delay);
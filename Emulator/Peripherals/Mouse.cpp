@@ -24,9 +24,6 @@ Mouse::Mouse(C64 &ref, ControlPort& pref) : C64Component(ref), port(pref)
 void Mouse::_reset()
 {
     RESET_SNAPSHOT_ITEMS
-
-    targetX = 0;
-    targetY = 0;
 }
 
 void
@@ -52,13 +49,78 @@ Mouse::setModel(MouseModel model)
 void
 Mouse::setXY(i64 x, i64 y)
 {
+    if (c64.dropsHostInput()) return;
+    
+    if (c64.queuesHostInput()) {
+        c64.inputs.submit(INPUT_EVENT_MOUSE_MOVE, port.nr, 0, (long)x, (long)y);
+    } else {
+        _setXY(x, y);
+    }
+}
+
+void
+Mouse::setLeftButton(bool value)
+{
+    trigger(value ? PRESS_LEFT : RELEASE_LEFT);
+}
+
+void
+Mouse::setRightButton(bool value)
+{
+    trigger(value ? PRESS_RIGHT : RELEASE_RIGHT);
+}
+
+void
+Mouse::trigger(GamePadAction event)
+{
+    if (c64.dropsHostInput()) return;
+    
+    if (c64.queuesHostInput()) {
+        c64.inputs.submit(INPUT_EVENT_MOUSE, port.nr, event);
+    } else {
+        _trigger(event);
+    }
+}
+
+i64
+Mouse::positionX(Cycle cycle) const
+{
+    if (cycle >= moveStart + moveDuration) return targetX;
+    if (cycle <= moveStart) return sourceX;
+    
+    return sourceX + (targetX - sourceX) * (cycle - moveStart) / moveDuration;
+}
+
+i64
+Mouse::positionY(Cycle cycle) const
+{
+    if (cycle >= moveStart + moveDuration) return targetY;
+    if (cycle <= moveStart) return sourceY;
+    
+    return sourceY + (targetY - sourceY) * (cycle - moveStart) / moveDuration;
+}
+
+void
+Mouse::_setXY(i64 x, i64 y)
+{
+    Cycle cycle = cpu.cycle;
+    
+    // Continue at the current position
+    sourceX = positionX(cycle);
+    sourceY = positionY(cycle);
+    
+    // Spread the movement over the interval between the last two events
+    Cycle maxDuration = vic.getCyclesPerFrame() / 2;
+    moveDuration = MAX(1, MIN(cycle - moveStart, maxDuration));
+    moveStart = cycle;
+    
     targetX = x;
     targetY = y;
     port.device = CPDEVICE_MOUSE;
 }
 
 void
-Mouse::setLeftButton(bool value)
+Mouse::_setLeftButton(bool value)
 {
     debug(PORT_DEBUG, "setLeftButton(%d)\n", value);
     
@@ -75,7 +137,7 @@ Mouse::setLeftButton(bool value)
 }
 
 void
-Mouse::setRightButton(bool value)
+Mouse::_setRightButton(bool value)
 {
     debug(PORT_DEBUG, "setRightButton(%d)\n", value);
 
@@ -92,7 +154,7 @@ Mouse::setRightButton(bool value)
 }
 
 void
-Mouse::trigger(GamePadAction event)
+Mouse::_trigger(GamePadAction event)
 {
     assert_enum(GamePadAction, event);
 
@@ -100,10 +162,10 @@ Mouse::trigger(GamePadAction event)
     
     switch (event) {
 
-        case PRESS_LEFT: setLeftButton(true); break;
-        case RELEASE_LEFT: setLeftButton(false); break;
-        case PRESS_RIGHT: setRightButton(true); break;
-        case RELEASE_RIGHT: setRightButton(false); break;
+        case PRESS_LEFT: _setLeftButton(true); break;
+        case RELEASE_LEFT: _setLeftButton(false); break;
+        case PRESS_RIGHT: _setRightButton(true); break;
+        case RELEASE_RIGHT: _setRightButton(false); break;
             
         default:
             break;
@@ -113,20 +175,20 @@ Mouse::trigger(GamePadAction event)
 void
 Mouse::risingStrobe()
 {
-    mouseNeos.risingStrobe(targetX, targetY);
+    mouseNeos.risingStrobe(positionX(cpu.cycle), positionY(cpu.cycle));
 }
 
 void
 Mouse::fallingStrobe()
 {
-    mouseNeos.fallingStrobe(targetX, targetY);
+    mouseNeos.fallingStrobe(positionX(cpu.cycle), positionY(cpu.cycle));
 }
 
 void
 Mouse::updatePotX()
 {
     if (config.model == MOUSE_C1351) {
-        mouse1351.executeX(targetX);
+        mouse1351.executeX(positionX(cpu.cycle));
     }
 }
 
@@ -134,12 +196,10 @@ void
 Mouse::updatePotY()
 {
     if (config.model == MOUSE_C1351) {
-        mouse1351.executeY(targetY);
+        mouse1351.executeY(positionY(cpu.cycle));
     }
 }
 
-void updatePotY();
-
 u8
 Mouse::readPotX() const
 {
@@ -174,7 +234,7 @@ void
 Mouse::updateControlPort()
 {
     if (config.model == MOUSE_NEOS) {
-        mouseNeos.updateControlPort(targetX, targetY);
+        mouseNeos.updateControlPort(positionX(cpu.cycle), positionY(cpu.cycle));
     }
 }
 
@@ -199,7 +259,7 @@ Mouse::execute()
     switch(config.model) {
             
         case MOUSE_C1350:
-            mouse1350.execute(targetX, targetY);
+            mouse1350.execute(positionX(cpu.cycle), positionY(cpu.cycle));
             break;
         case MOUSE_C1351:
             // Coordinates are updated in readPotX() and readPotY()
@@ -16,6 +16,8 @@
 
 class Mouse : public C64Component {
     
+    friend class InputQueue;
+
     // Reference to the control port this device belongs to
     ControlPort &port;
 
@@ -45,6 +47,18 @@ private:
      */
     i64 targetX;
     i64 targetY;
+    
+    /* Host coordinates arrive at the rate of the host's input devices, which
+     * is unrelated to the rate the C64 samples the mouse. To avoid stepwise
+     * movements, a new target position is approached linearly, starting at
+     * the previous position and spreading the movement over the time that
+     * has elapsed between the last two host events. The mouse models sample
+     * the position in the cycle the C64 reads it (see position()).
+     */
+    i64 sourceX;
+    i64 sourceY;
+    Cycle moveStart;
+    Cycle moveDuration;
   
     
     //
@@ -96,11 +110,21 @@ private:
     template <class T>
     void applyToResetItems(T& worker)
     {
+        worker
+        
+        & targetX
+        & targetY
+        & sourceX
+        & sourceY
+        & moveStart
+        & moveDuration;
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
     
     
     //
@@ -109,6 +133,10 @@ private:
     
 public:
     
+    /* The following functions are called by the host. The events are handed
+     * over to the input queue if required (see C64::queuesHostInput()).
+     */
+    
     // Emulates a mouse movement event
     void setXY(i64 x, i64 y);
 
@@ -119,6 +147,19 @@ public:
     // Triggers a gamepad event
     void trigger(GamePadAction event);
     
+private:
+    
+    // Returns the interpolated mouse position in the specified cycle
+    i64 positionX(Cycle cycle) const;
+    i64 positionY(Cycle cycle) const;
+    
+    void _setXY(i64 x, i64 y);
+    void _setLeftButton(bool value);
+    void _setRightButton(bool value);
+    void _trigger(GamePadAction event);
+    
+public:
+    
     // Triggers a state change (Neos mouse only)
     void risingStrobe();
     void fallingStrobe();
@@ -40,6 +40,20 @@ enum_long(GAME_PAD_ACTION)
 };
 typedef GAME_PAD_ACTION GamePadAction;
 
+enum_long(INPUT_EVENT)
+{
+    INPUT_EVENT_PRESS_KEY,     // Press a key (data = key number)
+    INPUT_EVENT_RELEASE_KEY,   // Release a key (data = key number)
+    INPUT_EVENT_RELEASE_KEYS,  // Release all keys
+    INPUT_EVENT_JOYSTICK,      // Trigger a joystick action (data = action)
+    INPUT_EVENT_MOUSE,         // Trigger a mouse action (data = action)
+    INPUT_EVENT_MOUSE_MOVE,    // Move the mouse (x, y = new position)
+    INPUT_EVENT_WARP,          // Switch warp mode on or off (data = on)
+    INPUT_EVENT_SYNC,          // Restore a state of the input log (data = nr)
+    INPUT_EVENT_COUNT
+};
+typedef INPUT_EVENT InputEventType;
+
 enum_long(CRTMODE)
 {
     CRTMODE_16K,
@@ -49,3 +63,27 @@ enum_long(CRTMODE)
     CRTMODE_COUNT
 };
 typedef CRTMODE CRTMode;
+
+
+//
+// Structures
+//
+
+typedef struct
+{
+    // CPU cycle in which the event takes effect
+    i64 cycle;
+    
+    // Event type
+    InputEventType type;
+    
+    // Control port (joystick and mouse events)
+    PortId port;
+    
+    // Key number or game pad action
+    long data;
+    
+    // Mouse position (mouse move events)
+    long x, y;
+}
+InputEvent;
@@ -67,6 +67,32 @@ struct GamePadActionEnum : Reflection<GamePadActionEnum, GamePadAction> {
     }
 };
 
+struct InputEventTypeEnum : Reflection<InputEventTypeEnum, InputEventType> {
+    
+    static bool isValid(long value)
+    {
+        return (unsigned long)value < INPUT_EVENT_COUNT;
+    }
+    
+    static const char *prefix() { return "INPUT_EVENT"; }
+    static const char *key(InputEventType value)
+    {
+        switch (value) {
+                
+            case INPUT_EVENT_PRESS_KEY:     return "PRESS_KEY";
+            case INPUT_EVENT_RELEASE_KEY:   return "RELEASE_KEY";
+            case INPUT_EVENT_RELEASE_KEYS:  return "RELEASE_KEYS";
+            case INPUT_EVENT_JOYSTICK:      return "JOYSTICK";
+            case INPUT_EVENT_MOUSE:         return "MOUSE";
+            case INPUT_EVENT_MOUSE_MOVE:    return "MOUSE_MOVE";
+            case INPUT_EVENT_WARP:          return "WARP";
+            case INPUT_EVENT_SYNC:          return "SYNC";
+            case INPUT_EVENT_COUNT:         return "???";
+        }
+        return "???";
+    }
+};
+
 struct CRTModeEnum : Reflection<CRTModeEnum, CRTMode> {
     
     static bool isValid(long value)
@@ -40,14 +40,22 @@ ReSID::_reset()
 
     delete sid;
     sid = new reSID::SID();
+    aheadValid = false;
     
     sid->set_chip_model((reSID::chip_model)model);
-    sid->set_sampling_parameters((double)clockFrequency,
-                                 (reSID::sampling_method)samplingMethod,
-                                 (double)sampleRate);
+    updateSamplingParameters();
     sid->enable_filter(emulateFilter);
 }
 
+void
+ReSID::_memoryUsage(MemoryUsage &usage)
+{
+    usage.heapBytes += sizeof(reSID::SID);
+    
+    // The resampling filter is only allocated in resampling mode
+    if (sid->fir) usage.heapBytes += sid->fir_N * sid->fir_RES * sizeof(short);
+}
+
 u32
 ReSID::getClockFrequency() const
 {
@@ -62,9 +70,7 @@ ReSID::setClockFrequency(u32 frequency)
 
     clockFrequency = frequency;
     
-    sid->set_sampling_parameters((double)clockFrequency,
-                                 (reSID::sampling_method)samplingMethod,
-                                 (double)sampleRate);
+    updateSamplingParameters();
     
     assert((u32)sid->clock_frequency == clockFrequency);
 }
@@ -100,12 +106,16 @@ ReSID::_inspect()
             voiceInfo[i].releaseRate = reg[0x06] & 0x0F;
         }
     }
+    
+    latestInfo.publish(info);
+    for (isize i = 0; i < 3; i++) latestVoiceInfo[i].publish(voiceInfo[i]);
 }
 
 usize
 ReSID::didLoadFromBuffer(u8 *buffer)
 {
     sid->write_state(st);
+    aheadValid = false;
     return 0;
 }
  
@@ -116,6 +126,15 @@ ReSID::willSaveToBuffer(u8 *buffer)
     return 0;
 }
 
+u64
+ReSID::_hash()
+{
+    // Fetch the internal state of reSID as willSaveToBuffer() does
+    st = sid->read_state();
+    
+    HASH_SNAPSHOT_ITEMS
+}
+
 SIDRevision
 ReSID::getRevision() const
 {
@@ -126,13 +145,14 @@ ReSID::getRevision() const
 void
 ReSID::setRevision(SIDRevision revision)
 {
-    assert(!isRunning());
+    assert(canModify());
 
     assert(revision == 0 || revision == 1);
     model = revision;
     
     suspend();
     sid->set_chip_model((reSID::chip_model)revision);
+    aheadValid = false;
     resume();
         
     assert((SIDRevision)sid->sid_model == revision);
@@ -146,9 +166,7 @@ ReSID::setSampleRate(double value)
 
     sampleRate = value;
 
-    sid->set_sampling_parameters((double)clockFrequency,
-                                 (reSID::sampling_method)samplingMethod,
-                                 sampleRate);
+    updateSamplingParameters();
     
     trace(SID_DEBUG, "Setting sample rate to %f samples per second\n", sampleRate);
 }
@@ -156,7 +174,7 @@ ReSID::setSampleRate(double value)
 void 
 ReSID::setAudioFilter(bool value)
 {
-    assert(!isRunning());
+    assert(canModify());
 
     emulateFilter = value;
     
@@ -177,7 +195,7 @@ ReSID::getSamplingMethod() const
 void 
 ReSID::setSamplingMethod(SamplingMethod value)
 {
-    assert(!isRunning());
+    assert(canModify());
     
     switch(value) {
         case SAMPLING_FAST:
@@ -200,55 +218,107 @@ ReSID::setSamplingMethod(SamplingMethod value)
     samplingMethod = value;
     
     suspend();
-    sid->set_sampling_parameters((double)clockFrequency,
-                                 (reSID::sampling_method)samplingMethod,
-                                 (double)sampleRate);
+    updateSamplingParameters();
     resume();
     
     assert((SamplingMethod)sid->sampling == samplingMethod);
 }
 
+void
+ReSID::setSamplingParameters(u32 frequency, double rate, SamplingMethod method)
+{
+    assert(canModify());
+    
+    if (method == SAMPLING_RESAMPLE_FASTMEM) method = SAMPLING_INTERPOLATE;
+    
+    clockFrequency = frequency;
+    sampleRate = rate;
+    samplingMethod = method;
+    
+    suspend();
+    updateSamplingParameters();
+    resume();
+    
+    assert((u32)sid->clock_frequency == clockFrequency);
+}
+
 u8
 ReSID::peek(u16 addr)
 {	
     return sid->read(addr);
 }
 
+u8
+ReSID::spypeek(u16 addr) const
+{
+    assert(addr == 0x1B || addr == 0x1C);
+    
+    if (addr == 0x1B) return sid->voice[2].wave.readOSC();
+    return sid->voice[2].envelope.readENV();
+}
+
 void 
 ReSID::poke(u16 addr, u8 value)
 {
     sid->write(addr, value);
+    aheadValid = false;
+}
+
+u8
+ReSID::peekAhead(u16 addr, usize numCycles)
+{
+    assert(addr == 0x1B || addr == 0x1C);
+    
+    // Start over if reSID has moved on or the copy is ahead of the target
+    if (!aheadValid || aheadCycles > numCycles) {
+        
+        aheadWave = sid->voice[2].wave;
+        aheadEnvelope = sid->voice[2].envelope;
+        aheadCycles = 0;
+        aheadValid = true;
+    }
+    
+    // Clock voice 3 in the same order as reSID does
+    for (; aheadCycles < numCycles; aheadCycles++) {
+        
+        aheadEnvelope.clock();
+        aheadWave.clock();
+        aheadWave.set_waveform_output();
+    }
+    
+    return addr == 0x1B ? aheadWave.readOSC() : aheadEnvelope.readENV();
 }
 
 i64
 ReSID::executeCycles(usize numCycles, SampleStream &stream)
 {
-    short buf[2049];
-    usize buflength = 2048;
+    aheadValid = false;
     
     if (numCycles > PAL_CYCLES_PER_SECOND) {
         warn("Number of missing SID cycles is far too large\n");
         numCycles = PAL_CYCLES_PER_SECOND;
     }
     
-    // Let reSID compute sound samples
+    // Let reSID compute sound samples directly into the ringbuffer
     usize samples = 0;
     reSID::cycle_count cycles = (reSID::cycle_count)numCycles;
     while (cycles) {
-        int resid = sid->clock(cycles, buf + samples, int(buflength) - int(samples));
-        assert(resid >= 0); // TODO: REMOVE AFTER A WHILE
+        
+        // Check for a buffer overflow
+        if (unlikely(stream.isFull())) {
+            warn("SID %d: SAMPLE BUFFER OVERFLOW", nr);
+            stream.skip(stream.count() / 2);
+        }
+        
+        // Fill the free space up to the end of the element storage
+        int span = (int)stream.writeSpan();
+        int resid = sid->clock(cycles, stream.writePtr(), span);
+        assert(resid >= 0 && resid <= span);
+        
+        stream.commit((usize)resid);
         samples += (usize)resid;
     }
     
-    // Check for a buffer overflow
-    if (unlikely(samples > stream.free())) {
-        warn("SID %d: SAMPLE BUFFER OVERFLOW", nr);
-        stream.clear();
-    }
-    
-    // Write samples into ringbuffer
-    if (samples) { for (usize i = 0; i < samples; i++) stream.write(buf[i]); }
-    
     return samples;
 }
 
@@ -257,3 +327,108 @@ ReSID::executeCycles(usize numCycles)
 {
     return executeCycles(numCycles, bridge.sidStream[nr]);
 }
+
+SIDProfile
+ReSID::getProfile() const
+{
+    SIDProfile result;
+    
+    result.sampling = samplingMethod;
+    result.passband = passband;
+    result.firOrder = firOrder;
+    result.filter = emulateFilter;
+    
+    return result;
+}
+
+void
+ReSID::setProfile(const SIDProfile &profile)
+{
+    assert(canModify());
+    
+    passband = profile.passband;
+    firOrder = profile.firOrder;
+    
+    if (profile.filter != emulateFilter) setAudioFilter(profile.filter);
+    setSamplingMethod(profile.sampling);
+    
+    trace(SID_DEBUG, "FIR length: %zd\n", getFirLength());
+}
+
+double
+ReSID::passFrequency(const SIDProfile &profile, double sampleRate)
+{
+    double result = profile.passband > 0 ? profile.passband : -1;
+    
+    if (profile.firOrder > 0) {
+        
+        /* reSID designs the filter with a Kaiser window and a stopband
+         * attenuation of 96 dB. Solve its order estimation for the width of
+         * the transition band.
+         */
+        const double A = -20 * log10(1.0 / (1 << 16));
+        double dw = (A - 7.95) / (2.285 * (double)profile.firOrder);
+        result = sampleRate / 2 * (1 - dw / (2 * M_PI));
+    }
+    
+    // Stay within the range accepted by reSID
+    if (result > 0) {
+        result = MAX(result, 0.05 * sampleRate / 2);
+        result = MIN(result, 0.9 * sampleRate / 2);
+    }
+    
+    return result;
+}
+
+void
+ReSID::updateSamplingParameters()
+{
+    SIDProfile profile = getProfile();
+    
+    if (!sid->set_sampling_parameters((double)clockFrequency,
+                                      (reSID::sampling_method)samplingMethod,
+                                      (double)sampleRate,
+                                      passFrequency(profile, sampleRate))) {
+        
+        warn("Unsupported sampling parameters. Using defaults.\n");
+        sid->set_sampling_parameters((double)clockFrequency,
+                                     (reSID::sampling_method)samplingMethod,
+                                     (double)sampleRate);
+    }
+}
+
+double
+ReSID::measureThroughput(const SIDProfile &profile, double sampleRate, usize cycles)
+{
+    reSID::SID sid;
+    
+    sid.set_chip_model(reSID::MOS6581);
+    sid.enable_filter(profile.filter);
+    if (!sid.set_sampling_parameters((double)PAL_CLOCK_FREQUENCY,
+                                     (reSID::sampling_method)profile.sampling,
+                                     sampleRate,
+                                     passFrequency(profile, sampleRate))) {
+        return 0.0;
+    }
+    
+    // Play a chord with all three voices routed through the filter
+    const u8 regs[] = {
+        0x00, 0x11, 0x00, 0x08, 0x41, 0x09, 0xF0,
+        0x00, 0x16, 0x00, 0x00, 0x21, 0x09, 0xF0,
+        0x00, 0x1A, 0x00, 0x00, 0x11, 0x09, 0xF0,
+        0x00, 0x40, 0x27, 0x1F
+    };
+    for (u16 i = 0; i < sizeof(regs); i++) sid.write(i, regs[i]);
+    
+    short buffer[2048];
+    usize samples = 0;
+    reSID::cycle_count remaining = (reSID::cycle_count)cycles;
+    
+    u64 start = Oscillator::nanos();
+    while (remaining) {
+        samples += (usize)sid.clock(remaining, buffer, 2048);
+    }
+    u64 elapsed = Oscillator::nanos() - start;
+    
+    return elapsed ? samples * 1000000000.0 / elapsed : 0.0;
+}
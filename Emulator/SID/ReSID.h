@@ -38,15 +38,26 @@ class ReSID : public C64Component {
     // Entry point to the reSID backend
     reSID::SID *sid;
     
-    // Result of the latest inspection
+    // Result of the latest inspection (the published copy is read by the GUI)
     SIDInfo info;
     VoiceInfo voiceInfo[3];
+    InfoRecord<SIDInfo> latestInfo;
+    InfoRecord<VoiceInfo> latestVoiceInfo[3];
         
 private:
     
     // ReSID state
     reSID::SID::State st;
     
+    /* Copy of voice 3 running ahead of reSID. It serves reads of OSC3 and
+     * ENV3 without running reSID up to the current cycle. The copy is
+     * discarded whenever reSID is executed or written to.
+     */
+    reSID::WaveformGenerator aheadWave;
+    reSID::EnvelopeGenerator aheadEnvelope;
+    usize aheadCycles = 0;
+    bool aheadValid = false;
+    
     // The emulated chip model
     SIDRevision model;
     
@@ -62,6 +73,10 @@ private:
     // Switches filter emulation on or off
     bool emulateFilter;
     
+    // Passband and order of the resampling filter (0 = reSID default)
+    double passband = 0.0;
+    i64 firOrder = 0;
+    
     
     //
     // Initializing
@@ -99,6 +114,31 @@ public:
     SamplingMethod getSamplingMethod() const;
     void setSamplingMethod(SamplingMethod value);
     
+    // Changes the clock frequency, the sample rate, and the sampling method
+    void setSamplingParameters(u32 frequency, double rate, SamplingMethod method);
+    
+    // Applies all quality settings at once
+    SIDProfile getProfile() const;
+    void setProfile(const SIDProfile &profile);
+
+    // Returns the length of the resampling filter (0 = no resampling)
+    isize getFirLength() const { return sid->fir ? sid->fir_N : 0; }
+    
+    /* Measures the throughput of a certain profile. The function runs a
+     * scratch reSID instance playing a test tone for the specified number of
+     * cycles and returns the number of produced samples per second.
+     */
+    static double measureThroughput(const SIDProfile &profile, double sampleRate,
+                                    usize cycles = PAL_CLOCK_FREQUENCY);
+
+private:
+    
+    // Passes the sampling related settings to reSID
+    void updateSamplingParameters();
+    
+    // Translates the passband and FIR order into a reSID passband
+    static double passFrequency(const SIDProfile &profile, double sampleRate);
+    
     
     //
     // Analyzing
@@ -106,8 +146,14 @@ public:
     
 public:
     
-    SIDInfo getInfo() { return HardwareComponent::getInfo(info); }
-    VoiceInfo getVoiceInfo(unsigned nr) { return HardwareComponent::getInfo(voiceInfo[nr]); }
+    SIDInfo getInfo() { return HardwareComponent::getInfo(latestInfo); }
+    VoiceInfo getVoiceInfo(unsigned nr) { return HardwareComponent::getInfo(latestVoiceInfo[nr]); }
+    
+    // Returns the number of cycles emulated on the fast path for silence
+    u64 getSilentCycles() const { return sid->silent_cycles; }
+    
+    // Returns the number of cycles emulated with a resting filter (digis)
+    u64 getSettledCycles() const { return sid->settled_cycles; }
     
 private:
     
@@ -192,7 +238,9 @@ private:
         & model
         & clockFrequency
         & samplingMethod
-        & emulateFilter;
+        & emulateFilter
+        & passband
+        & firOrder;
     }
     
     template <class T>
@@ -201,8 +249,11 @@ private:
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
+    void _memoryUsage(MemoryUsage &usage) override;
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override;
     usize didLoadFromBuffer(u8 *buffer) override;
     usize willSaveToBuffer(u8 *buffer) override;
 
@@ -216,6 +267,20 @@ public:
     // Reads or writes a SID register
 	u8 peek(u16 addr);
 	void poke(u16 addr, u8 value);
+    
+    // Reads OSC3 (0x1B) or ENV3 (0x1C) without affecting the data bus
+    u8 spypeek(u16 addr) const;
+    
+    /* Predicts the value of OSC3 (0x1B) or ENV3 (0x1C) the specified number
+     * of cycles ahead of reSID. Only voice 3 is clocked, cycle by cycle. The
+     * result is exact if voice 3 is neither synchronized with nor ring
+     * modulated by voice 2 and no write to voice 3 is pending. The internal
+     * state of reSID isn't changed.
+     */
+    u8 peekAhead(u16 addr, usize numCycles);
+    
+    // Checks if no pipelined write is in progress (see peekAhead)
+    bool canPeekAhead() const { return sid->write_pipeline == 0; }
 	
     
     //
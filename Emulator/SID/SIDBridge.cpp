@@ -24,6 +24,8 @@ SIDBridge::SIDBridge(C64 &ref) : C64Component(ref)
     };
     
     config.engine = SIDENGINE_RESID;
+    config.parallel = false;
+    config.layout = AUDIO_LAYOUT_INTERLEAVED;
     config.enabled = 1;
     config.address[0] = 0xD400;
     config.address[1] = 0xD420;
@@ -32,8 +34,12 @@ SIDBridge::SIDBridge(C64 &ref) : C64Component(ref)
     
     for (int i = 0; i < 4; i++) {
         resid[i].setClockFrequency(PAL_CLOCK_FREQUENCY);
+        resid[i].setSampleRate(internalRate);
         fastsid[i].setClockFrequency(PAL_CLOCK_FREQUENCY);
-    }    
+        fastsid[i].setSampleRate(internalRate);
+    }
+    resampler.setRates(internalRate, sampleRate);
+    updateSIDMap();
 }
 
 void
@@ -41,7 +47,10 @@ SIDBridge::_reset()
 {
     RESET_SNAPSHOT_ITEMS
     
+    for (usize i = 0; i < 4; i++) numRegWrites[i] = 0;
+    for (usize i = 0; i < 4; i++) voice3Write[i] = 0;
     clearRingbuffer();
+    clearWaveforms();
 }
 
 long
@@ -61,6 +70,12 @@ SIDBridge::getConfigItem(Option option) const
         case OPT_SID_SAMPLING:
             return config.sampling;
             
+        case OPT_SID_PARALLEL:
+            return config.parallel;
+            
+        case OPT_AUDIO_LAYOUT:
+            return config.layout;
+            
         case OPT_AUDVOLL:
             return config.volL;
 
@@ -148,6 +163,7 @@ SIDBridge::setConfigItem(Option option, long value)
 
             suspend();
             config.engine = (SIDEngine)value;
+            syncEngine();
             resume();
             
             return true;
@@ -164,6 +180,26 @@ SIDBridge::setConfigItem(Option option, long value)
             
             return true;
             
+        case OPT_SID_PARALLEL:
+            
+            if (config.parallel == value) return false;
+            
+            config.parallel = value;
+            return true;
+            
+        case OPT_AUDIO_LAYOUT:
+            
+            if (!AudioLayoutEnum::verify(value)) return false;
+            if (config.layout == value) return false;
+            
+            suspend();
+            config.layout = (AudioLayout)value;
+            stream.setLayout((AudioLayout)value);
+            alignWritePtr();
+            resume();
+            
+            return true;
+            
         case OPT_AUDVOLL:
             
             config.volL = MIN(100, MAX(0, value));
@@ -217,6 +253,9 @@ SIDBridge::setConfigItem(Option option, long id, long value)
                 resid[i].reset();
                 fastsid[i].reset();
             }
+            memset(shadowRegs, 0, sizeof(shadowRegs));
+            updateSIDMap();
+            mem.updateIOTables();
             resume();
             return true;
             
@@ -242,6 +281,8 @@ SIDBridge::setConfigItem(Option option, long id, long value)
             suspend();
             config.address[id] = value;
             clearSampleBuffer(id);
+            updateSIDMap();
+            mem.updateIOTables();
             resume();
             return true;
             
@@ -313,9 +354,15 @@ SIDBridge::setClockFrequency(u32 frequency)
 
     cpuFrequency = frequency;
 
+    if (c64.isBatching()) { clockPending = true; return; }
+    
+    updateInternalRate();
+    
     for (int i = 0; i < 4; i++) {
         resid[i].setClockFrequency(frequency);
+        resid[i].setSampleRate(internalRate);
         fastsid[i].setClockFrequency(frequency);
+        fastsid[i].setSampleRate(internalRate);
     }
 }
 
@@ -343,43 +390,46 @@ SIDBridge::setRevision(SIDRevision revision)
     }
 }
 
-double
-SIDBridge::getSampleRate() const
-{
-    double result = resid[0].getSampleRate();
-    
-    for (int i = 0; i < 4; i++) {
-        assert(resid[i].getSampleRate() == result);
-        assert(fastsid[i].getSampleRate() == result);
-    }
-    
-    return result;
-}
-
 void
 SIDBridge::setSampleRate(double rate)
 {
     trace(SID_DEBUG, "Setting sample rate to %f\n", rate);
 
+    // The SIDs keep on running at the internal rate
+    suspend();
     sampleRate = rate;
+    resampler.setRates(internalRate, rate);
+    resume();
+}
+
+void
+SIDBridge::updateInternalRate()
+{
+    internalRate = (double)cpuFrequency / renderDivider;
     
-    for (int i = 0; i < 4; i++) {
-        resid[i].setSampleRate(rate);
-        fastsid[i].setSampleRate(rate);
-    }    
+    trace(SID_DEBUG, "Rendering at %f samples per second\n", internalRate);
+    
+    resampler.setRates(internalRate, sampleRate);
+    
+    // Adjust the resamplers of all additional outputs
+    for (usize i = 0; i < maxOutputs; i++) {
+        if (outputs[i]) {
+            outputs[i]->resampler.setRates(internalRate, outputs[i]->resampler.getOutputRate());
+        }
+    }
+}
+
+void
+SIDBridge::setThreadPolicy(const ThreadPolicy &policy)
+{
+    for (int i = 0; i < 3; i++) workers[i].setPolicy(policy);
 }
 
 bool
 SIDBridge::getAudioFilter() const
 {
-    bool result = resid[0].getAudioFilter();
-    
-    for (int i = 0; i < 4; i++) {
-        assert(resid[i].getAudioFilter() == result);
-        assert(fastsid[i].getAudioFilter() == result);
-    }
-    
-    return result;
+    // Note: Individual SIDs may deviate if they were given their own profile
+    return resid[0].getAudioFilter();
 }
 
 void
@@ -396,14 +446,8 @@ SIDBridge::setAudioFilter(bool enable)
 SamplingMethod
 SIDBridge::getSamplingMethod() const
 {
-    SamplingMethod result = resid[0].getSamplingMethod();
-    
-    for (int i = 0; i < 4; i++) {
-        assert(resid[i].getSamplingMethod() == result);
-        // Note: fastSID has no such option
-    }
-    
-    return result;
+    // Note: Individual SIDs may deviate if they were given their own profile
+    return resid[0].getSamplingMethod();
 }
 
 void
@@ -411,12 +455,75 @@ SIDBridge::setSamplingMethod(SamplingMethod method)
 {
     trace(SID_DEBUG, "Setting sampling method to %s\n",SamplingMethodEnum::key(method));
 
+    if (c64.isBatching()) {
+        
+        samplingPending = true;
+        pendingSampling = method;
+        return;
+    }
+    
     for (int i = 0; i < 4; i++) {
         resid[i].setSamplingMethod(method);
         // Note: fastSID has no such option
     }
 }
 
+void
+SIDBridge::updateSamplingParameters()
+{
+    if (!clockPending && !samplingPending) return;
+    
+    trace(SID_DEBUG, "Updating postponed sampling parameters\n");
+    
+    if (clockPending) updateInternalRate();
+    
+    // Let reSID recompute its resampling tables only once
+    for (int i = 0; i < 4; i++) {
+        
+        SamplingMethod method =
+        samplingPending ? pendingSampling : resid[i].getSamplingMethod();
+        
+        resid[i].setSamplingParameters(cpuFrequency, internalRate, method);
+        if (clockPending) {
+            fastsid[i].setClockFrequency(cpuFrequency);
+            fastsid[i].setSampleRate(internalRate);
+        }
+    }
+    
+    clockPending = false;
+    samplingPending = false;
+}
+
+SIDProfile
+SIDBridge::getProfile(long nr) const
+{
+    assert(nr >= 0 && nr <= 3);
+    return resid[nr].getProfile();
+}
+
+void
+SIDBridge::setProfile(long nr, const SIDProfile &profile)
+{
+    assert(nr >= 0 && nr <= 3);
+    
+    suspend();
+    resid[nr].setProfile(profile);
+    fastsid[nr].setAudioFilter(profile.filter);
+    resume();
+}
+
+void
+SIDBridge::setProfile(const SIDProfile &profile)
+{
+    for (long i = 0; i < 4; i++) setProfile(i, profile);
+}
+
+double
+SIDBridge::measureThroughput(const SIDProfile &profile) const
+{
+    return ReSID::measureThroughput(profile, internalRate);
+}
+
 void
 SIDBridge::_dumpConfig() const
 {
@@ -428,6 +535,7 @@ SIDBridge::_dumpConfig() const
     msg("         Filter : %s\n",   config.filter ? "yes" : "no");
     msg("         Engine : %s\n",   SIDEngineEnum::key(config.engine));
     msg("       Sampling : %s\n",   SamplingMethodEnum::key(config.sampling));
+    msg("       Parallel : %s\n",   config.parallel ? "yes" : "no");
     msg("       Volume 1 : %lld\n", config.vol[0]);
     msg("       Volume 2 : %lld\n", config.vol[1]);
     msg("       Volume 3 : %lld\n", config.vol[2]);
@@ -439,8 +547,21 @@ SIDBridge::_dumpConfig() const
 usize
 SIDBridge::didLoadFromBuffer(u8 *buffer)
 {
-    clearRingbuffer();
+    // The ringbuffer is kept when returning from frames emulated ahead of time
+    if (!c64.runAhead.isRunningAhead() && !c64.netplay.isResimulating()) clearRingbuffer();
     for (usize i = 0; i < 4; i++) sidStream[i].clear(0);
+    for (usize i = 0; i < 4; i++) numRegWrites[i] = 0;
+    lastWrite = cycles;
+    updateSIDMap();
+    mem.updateIOTables();
+    return 0;
+}
+
+usize
+SIDBridge::willSaveToBuffer(u8 *buffer)
+{
+    // Pass all pending register writes to the SIDs
+    flushRegWrites();
     return 0;
 }
 
@@ -453,9 +574,24 @@ SIDBridge::_run()
 void
 SIDBridge::_pause()
 {
+    flushRegWrites();
     clearSampleBuffers();
 }
 
+void
+SIDBridge::_memoryUsage(MemoryUsage &usage)
+{
+    for (usize i = 0; i < maxOutputs; i++) {
+        
+        if (!outputs[i]) continue;
+        
+        usage.heapBytes += sizeof(Output);
+        usage.heapBytes += outputs[i]->resampler.memoryUsage();
+    }
+    usage.heapBytes += resampler.memoryUsage();
+    usage.heapBytes += stretcher.memoryUsage();
+}
+
 void 
 SIDBridge::_dump() const
 {
@@ -476,6 +612,8 @@ SIDBridge::_dump(int nr) const
     msg(" Sampling rate : %f\n", resid[nr].getSampleRate());
     msg(" CPU frequency : %d\n", resid[nr].getClockFrequency());
     msg("Emulate filter : %s\n", resid[nr].getAudioFilter() ? "yes" : "no");
+    msg(" Silent cycles : %llu\n", resid[nr].getSilentCycles());
+    msg("Settled cycles : %llu\n", resid[nr].getSettledCycles());
     msg("\n");
 
     /*
@@ -548,6 +686,7 @@ SIDBridge::_setWarp(bool enable)
     } else {
         
         rampUp();
+        stretcher.clear();
         alignWritePtr();
     }
 }
@@ -618,28 +757,48 @@ SIDBridge::rampDown()
     ignoreNextUnderOrOverflow();
 }
 
-usize
-SIDBridge::mappedSID(u16 addr) const
+void
+SIDBridge::updateSIDMap()
 {
-    addr &= 0xFFE0;
-    
-    if (isEnabled(1) && addr == config.address[1]) return 1;
-    if (isEnabled(2) && addr == config.address[2]) return 2;
-    if (isEnabled(3) && addr == config.address[3]) return 3;
+    for (usize i = 0; i < 32; i++) sidMap[i] = 0;
 
-    return 0;
+    // If two SIDs share an address, the one with the lower number wins
+    for (usize nr = 3; nr >= 1; nr--) {
+        if (isEnabled(nr)) sidMap[(config.address[nr] >> 5) & 0x1F] = (u8)nr;
+    }
+}
+
+bool
+SIDBridge::isSingleSIDPage(u16 addr) const
+{
+    usize first = (addr >> 5) & 0x18;
+    
+    for (usize i = first; i < first + 8; i++) {
+        if (sidMap[i]) return false;
+    }
+    return true;
 }
 
 u8 
-SIDBridge::peek(u16 addr)
+SIDBridge::peek(usize sidNr, u16 addr)
 {
+    assert(sidNr < 4);
+    
+    addr &= 0x1F;
+
+    /* Programs polling OSC3 or ENV3 would run the SIDs in tiny batches. If
+     * possible, the value is predicted instead. The read is recorded to
+     * update the data bus of the SID at the right cycle.
+     */
+    if ((addr == 0x1B || addr == 0x1C) && canPeekAhead(sidNr)) {
+        
+        u8 result = resid[sidNr].peekAhead(addr, (usize)(cpu.cycle - cycles));
+        recordAccess(sidNr, (u8)addr, result);
+        return result;
+    }
+    
     // Get SIDs up to date
     executeUntil(cpu.cycle);
- 
-    // Select the target SID
-    usize sidNr = config.enabled > 1 ? mappedSID(addr) : 0;
-
-    addr &= 0x1F;
 
     if (sidNr == 0) {
         
@@ -671,7 +830,7 @@ u8
 SIDBridge::spypeek(u16 addr) const
 {
     // Select the target SID
-    usize sidNr = config.enabled > 1 ? mappedSID(addr) : 0;
+    usize sidNr = mappedSID(addr);
 
     addr &= 0x1F;
 
@@ -679,12 +838,22 @@ SIDBridge::spypeek(u16 addr) const
         if (addr == 0x19) { return port1.readPotX() & port2.readPotX(); }
         if (addr == 0x1A) { return port1.readPotY() & port2.readPotY(); }
     }
+    if (addr == 0x19 || addr == 0x1A) return 0xFF;
 
-    /* At the moment, only FastSID allows us to peek into the SID registers
-     * without causing side effects. Hence, we get the return value from there,
-     * regardless of the selected SID engine.
+    /* OSC3 and ENV3 are taken from the active SID engine. They reflect the
+     * state of the last SID execution, which may lag behind the CPU.
      */
-    return fastsid[sidNr].spypeek(addr);
+    if (addr == 0x1B || addr == 0x1C) {
+        
+        switch (config.engine) {
+            case SIDENGINE_FASTSID: return fastsid[sidNr].spypeek(addr);
+            case SIDENGINE_RESID:   return resid[sidNr].spypeek(addr);
+            default: assert(false);
+        }
+    }
+
+    // Get all other values from the shadow registers
+    return shadowRegs[sidNr][addr];
 }
 
 u8
@@ -710,30 +879,96 @@ SIDBridge::readPotY() const
 }
 
 void 
-SIDBridge::poke(u16 addr, u8 value)
+SIDBridge::poke(usize sidNr, u16 addr, u8 value)
 {    
-    // Get SID up to date
-    executeUntil(cpu.cycle);
- 
-    // Select the target SID
-    usize sidNr = config.enabled > 1 ? mappedSID(addr) : 0;
+    assert(sidNr < 4);
 
     addr &= 0x1F;
     
-    // Keep both SID implementations up to date
-    resid[sidNr].poke(addr, value);
-    fastsid[sidNr].poke(addr, value);
+    recordAccess(sidNr, (u8)addr, value);
+    if (addr >= 0x0E && addr <= 0x14) voice3Write[sidNr] = lastWrite;
+    
+    // Pass the write to the tracer
+    if (tracer.isTracing()) tracer.record(cpu.cycle, sidNr, (u8)addr, value);
+}
+
+void
+SIDBridge::recordAccess(usize nr, u8 addr, u8 value)
+{
+    // Make room for the new entry if necessary
+    if (numRegWrites[nr] == maxRegWrites) flushRegWrites();
+    
+    /* Record the access. Each access is separated by at least one cycle from
+     * the previous one to make pipelined writes work in reSID. Replaying a
+     * read-only register only updates the data bus of the SID.
+     */
+    assert((Cycle)cpu.cycle >= lastWrite);
+    lastWrite = MAX((Cycle)cpu.cycle, lastWrite + 1);
+    regWrites[nr][numRegWrites[nr]++] = RegWrite { lastWrite, addr, value };
+}
+
+bool
+SIDBridge::canPeekAhead(usize nr) const
+{
+    // Only reSID runs voice 3 cycle-exactly
+    if (config.engine != SIDENGINE_RESID) return false;
+    
+    // The SIDs don't run if only the register writes are of interest
+    if (!synthesize && c64.isHeadless()) return false;
+    
+    // All writes to voice 3 must have been applied
+    if (voice3Write[nr] > cycles) return false;
+    
+    // Voice 3 must not depend on voice 2 (sync and ring modulation bits)
+    if (shadowRegs[nr][0x12] & 0x06) return false;
+    
+    return resid[nr].canPeekAhead();
+}
+
+void
+SIDBridge::flushRegWrites()
+{
+    usize missingCycles = lastWrite - cycles;
+    if (missingCycles) cycles += executeCycles(missingCycles);
+
+    assert(cycles == lastWrite);
+}
+
+void
+SIDBridge::syncEngine()
+{
+    for (usize nr = 0; nr < 4; nr++) {
+        
+        // Skip the read-only registers (0x19 - 0x1C)
+        for (u16 addr = 0; addr <= 0x18; addr++) {
+            
+            u8 value = shadowRegs[nr][addr];
+            switch (config.engine) {
+                case SIDENGINE_FASTSID: fastsid[nr].poke(addr, value); break;
+                case SIDENGINE_RESID:   resid[nr].poke(addr, value); break;
+                default: assert(false);
+            }
+        }
+    }
 }
 
 void
 SIDBridge::executeUntil(Cycle targetCycle)
 {
-    assert(targetCycle >= cycles);
+    assert(targetCycle >= lastWrite);
+    
+    // Run reSID for at least one cycle to make pipelined writes work
+    if (targetCycle == lastWrite) {
+        
+        targetCycle++;
+        debug(SID_EXEC, "Running SIDs for an extra cycle\n");
+    }
     
     usize missingCycles  = targetCycle - cycles;
     usize consumedCycles = executeCycles(missingCycles);
 
     cycles += consumedCycles;
+    lastWrite = cycles;
     
     debug(SID_EXEC,
           "target: %lld missing: %zd consumed: %zd reached: %lld still missing: %lld\n",
@@ -745,143 +980,321 @@ SIDBridge::executeCycles(usize numCycles)
 {
     usize numSamples;
     
-    // Run reSID for at least one cycle to make pipelined writes work
-    if (numCycles == 0) {
-        
-        numCycles = 1;
-        debug(SID_EXEC, "Running SIDs for an extra cycle\n");
-    }
-
     // Check for a buffer underflow
     if (signalUnderflow) {
         signalUnderflow = false;
         handleBufferUnderflow();
     }
 
-    switch (config.engine) {
-            
-        case SIDENGINE_FASTSID:
-
-            // Run the primary SID (which is always enabled)
-            numSamples = fastsid[0].executeCycles(numCycles, sidStream[0]);
-            
-            // Run all other SIDS (if any)
-            if (config.enabled > 1) {
-                for (usize i = 1; i < 4; i++) {
-                    if (isEnabled(i)) {
-                        u64 numSamples2 = fastsid[i].executeCycles(numCycles, sidStream[i]);
-                        numSamples = MIN(numSamples, numSamples2);
-                    }
+    // Skip synthesis if only the register writes are of interest
+    if (!synthesize && c64.isHeadless()) {
+        skipCycles(numCycles);
+        return numCycles;
+    }
+    
+    SIGNPOST(SID);
+    
+    usize produced[4];
+    bool multi = config.enabled > 1;
+    
+    // Only large batches are worth the overhead of waking up the helpers
+    bool parallel = multi && config.parallel && numCycles >= minParallelCycles;
+    
+    // Run all other SIDs (if any), either on helper threads or serially
+    if (multi) {
+        for (usize i = 1; i < 4; i++) {
+            if (isEnabled(i)) {
+                if (parallel) {
+                    workers[i - 1].run([this, i, numCycles, &produced]() {
+                        produced[i] = executeSID(i, numCycles);
+                    });
+                } else {
+                    produced[i] = executeSID(i, numCycles);
                 }
             }
-            break;
+        }
+    }
 
-        case SIDENGINE_RESID:
+    // Run the primary SID (which is always enabled)
+    numSamples = produced[0] = executeSID(0, numCycles);
 
-            // Run the primary SID (which is always enabled)
-            numSamples = resid[0].executeCycles(numCycles, sidStream[0]);
-            
-            // Run all other SIDS (if any)
-            if (config.enabled > 1) {
-                for (usize i = 1; i < 4; i++) {
-                    if (isEnabled(i)) {
-                        u64 numSamples2 = resid[i].executeCycles(numCycles, sidStream[i]);
-                        numSamples = MIN(numSamples, numSamples2);
-                    }
-                }
-            }
-            break;
+    // Discard the register writes of disabled SIDs
+    for (usize i = 1; i < 4; i++) if (!multi || !isEnabled(i)) numRegWrites[i] = 0;
 
-        default:
-            assert(false);
+    // Wait for the helper threads and determine the number of common samples
+    if (multi) {
+        for (usize i = 1; i < 4; i++) {
+            if (isEnabled(i)) {
+                if (parallel) workers[i - 1].join();
+                numSamples = MIN(numSamples, produced[i]);
+            }
+        }
+    }
+    producedSamples += numSamples;
+    
+    // In headless mode, there is no audio device to feed
+    if (c64.isHeadless() && !isTapped()) {
+        for (usize i = 0; i < 4; i++) sidStream[i].clear();
+        return numCycles;
+    }
+    
+    // Samples produced ahead of time or again are never played
+    if (c64.runAhead.isRunningAhead() || c64.netplay.isResimulating()) {
+        for (usize i = 0; i < 4; i++) sidStream[i].clear();
+        return numCycles;
     }
     
     // Produce the final stereo stream
-    (config.enabled > 1) ? mixMultiSID(numSamples) : mixSingleSID(numSamples);
+    mixSIDs(numSamples);
     
     return numCycles;
 }
 
-void
-SIDBridge::mixSingleSID(usize numSamples)
-{    
-    stream.lock();
+usize
+SIDBridge::executeSID(usize nr, usize numCycles)
+{
+    usize samples = 0;
+    Cycle now = cycles, end = cycles + (Cycle)numCycles;
     
-    // Check for buffer overflow
-    if (stream.free() < numSamples) {
-        handleBufferOverflow();
+    // Replay all register writes that take place in the executed range
+    usize i = 0;
+    for (; i < numRegWrites[nr] && regWrites[nr][i].cycle <= end; i++) {
+        
+        RegWrite &w = regWrites[nr][i];
+        samples += runSID(nr, (usize)(w.cycle - now));
+        now = w.cycle;
+        
+        // Only the active SID engine is kept up to date
+        shadowRegs[nr][w.addr] = w.value;
+        switch (config.engine) {
+            case SIDENGINE_FASTSID: fastsid[nr].poke(w.addr, w.value); break;
+            case SIDENGINE_RESID:   resid[nr].poke(w.addr, w.value); break;
+            default: assert(false);
+        }
     }
+    samples += runSID(nr, (usize)(end - now));
     
-    debug(SID_EXEC, "vol0: %f pan0: %f volL: %f volR: %f\n",
-          vol[0], pan[0], volL.current, volR.current);
+    // Keep the remaining writes
+    numRegWrites[nr] -= i;
+    memmove(regWrites[nr], regWrites[nr] + i, numRegWrites[nr] * sizeof(RegWrite));
+    
+    return samples;
+}
 
-    // Convert sound samples to floating point values and write into ringbuffer
-    for (usize i = 0; i < numSamples; i++) {
+void
+SIDBridge::skipCycles(usize numCycles)
+{
+    Cycle end = cycles + (Cycle)numCycles;
+    
+    for (usize nr = 0; nr < 4; nr++) {
         
-        // Read SID sample from ring buffer
-        float ch0 = (float)sidStream[0].read() * vol[0];
+        // Apply all register writes to the shadow registers
+        usize i = 0;
+        for (; i < numRegWrites[nr] && regWrites[nr][i].cycle <= end; i++) {
+            
+            RegWrite &w = regWrites[nr][i];
+            shadowRegs[nr][w.addr] = w.value;
+        }
         
-        // Compute left and right channel output
-        float l = ch0 * (1 - pan[0]);
-        float r = ch0 * pan[0];
+        // Keep the remaining writes
+        numRegWrites[nr] -= i;
+        memmove(regWrites[nr], regWrites[nr] + i, numRegWrites[nr] * sizeof(RegWrite));
+    }
+}
 
-        // Apply master volume
-        l *= volL.current;
-        r *= volR.current;
-        
-        // Apply ear protection
-        assert(abs(l) < 1.0);
-        assert(abs(r) < 1.0);
-        
-        stream.write(SamplePair { l, r } );
+usize
+SIDBridge::runSID(usize nr, usize numCycles)
+{
+    switch (config.engine) {
+            
+        case SIDENGINE_FASTSID:
+            return fastsid[nr].executeCycles(numCycles, sidStream[nr]);
+            
+        case SIDENGINE_RESID:
+            return resid[nr].executeCycles(numCycles, sidStream[nr]);
+            
+        default:
+            assert(false);
+            return 0;
     }
-    stream.unlock();
 }
-        
+
 void
-SIDBridge::mixMultiSID(usize numSamples)
+SIDBridge::mixSIDs(usize numSamples)
 {
-    stream.lock();
+    const usize blockSize = 256;
+    
+    short samples[4][blockSize];
+    const short *in[4];
+    SamplePair mixed[blockSize];
+    float wl[4], wr[4];
+    usize sids[4], channels = 0;
+    
+    // In headless mode, the samples are only needed by additional consumers
+    bool headless = c64.isHeadless();
+    bool recording = c64.recorder.isRecording();
+    bool scoping = c64.getInspectionTarget() == INSPECTION_TARGET_SID;
+    
+    // Determine the number of samples the speaker stream is going to receive
+    usize expected = resampler.maxOutput(numSamples);
+    if (stretcher.isActive()) expected = stretcher.expectedOutput(expected);
     
     // Check for buffer overflow
-    if (stream.free() < numSamples) {
+    if (stream.free() < expected && !headless) {
         handleBufferOverflow();
     }
     
     debug(SID_EXEC, "vol0: %f pan0: %f volL: %f volR: %f\n",
           vol[0], pan[0], volL.current, volR.current);
 
-    // Convert sound samples to floating point values and write into ringbuffer
-    for (usize i = 0; i < numSamples; i++) {
+    // Collect all enabled SIDs
+    for (usize i = 0; i < 4; i++) {
+
+        if (i != 0 && (config.enabled <= 1 || !isEnabled(i))) continue;
+
+        in[channels] = samples[channels];
+        sids[channels++] = i;
+    }
+
+    for (usize done = 0; done < numSamples; ) {
         
-        float ch0, ch1, ch2, ch3, l, r;
+        usize n = MIN(blockSize, numSamples - done);
         
-        ch0 = (float)sidStream[0].read()    * vol[0];
-        ch1 = (float)sidStream[1].read(0.0) * vol[1];
-        ch2 = (float)sidStream[2].read(0.0) * vol[2];
-        ch3 = (float)sidStream[3].read(0.0) * vol[3];
+        /* Premultiply the volume and pan factors. While the master volume is
+         * fading, it is applied to each sample separately.
+         */
+        bool fading = volL.isFading() || volR.isFading();
+        float gl = fading ? 1.0f : volL.current;
+        float gr = fading ? 1.0f : volR.current;
+        
+        for (usize c = 0; c < channels; c++) {
+            
+            wl[c] = vol[sids[c]] * (1 - pan[sids[c]]) * gl;
+            wr[c] = vol[sids[c]] * pan[sids[c]] * gr;
+        }
+        
+        // Read a block of samples from each SID stream
+        for (usize c = 0; c < channels; c++) {
+            
+            SampleStream &s = sidStream[sids[c]];
+            usize available = MIN(n, s.count());
+            
+            s.read(samples[c], available);
+            for (usize i = available; i < n; i++) samples[c][i] = 0;
+            
+            if (scoping) recordWaveform(sids[c], samples[c], n);
+        }
+        
+        mixSamples(in, wl, wr, channels, mixed, n);
+        
+        // Apply the master volume ramp
+        for (usize i = 0; fading && i < n; i++) {
+            
+            mixed[i].left *= volL.current;
+            mixed[i].right *= volR.current;
+            volL.shift();
+            volR.shift();
+        }
+        
+        // Pass the block to the video recorder, all outputs, and the speaker
+        if (recording) c64.recorder.addSamples(mixed, n);
+        if (numOutputs) feedOutputs(mixed, n);
+        if (!headless) writeSpeaker(mixed, n);
+        
+        done += n;
+    }
+}
 
-        // Compute left channel output
-        l =
-        ch0 * (1 - pan[0]) + ch1 * (1 - pan[1]) +
-        ch2 * (1 - pan[2]) + ch3 * (1 - pan[3]);
+void
+SIDBridge::writeSpeaker(const SamplePair *samples, usize n)
+{
+    SamplePair converted[1024];
+    
+    for (usize done = 0; done < n; ) {
+        
+        // Limit the chunk size to make the result fit into the buffer
+        usize chunk = n - done;
+        while (chunk > 1 && resampler.maxOutput(chunk) > 1024) chunk /= 2;
+        
+        usize count = resampler.process(samples + done, chunk, converted);
+        
+        // Samples that don't fit into the stream are dropped
+        if (stretcher.isActive()) {
+            writeStretched(converted, count);
+        } else {
+            stream.write(converted, MIN(count, stream.free()));
+        }
+        done += chunk;
+    }
+}
 
-        // Compute right channel output
-        r =
-        ch0 * pan[0] + ch1 * pan[1] +
-        ch2 * pan[2] + ch3 * pan[3];
+void
+SIDBridge::writeStretched(const SamplePair *samples, usize n)
+{
+    SamplePair stretched[512];
+    
+    stretcher.write(samples, n);
+    for (usize count; (count = stretcher.read(stretched, 512)) > 0; ) {
+        stream.write(stretched, MIN(count, stream.free()));
+    }
+}
 
-        // Apply master volume
-        l *= volL.current;
-        r *= volR.current;
+void
+SIDBridge::recordWaveform(usize nr, const short *samples, usize n)
+{
+    Scope &s = scope[nr];
+    
+    for (usize i = 0; i < n; ) {
+        
+        WaveformBin &bin = s.bins[s.current];
+        usize m = MIN(n - i, scopeBinSize - s.fill);
         
-        // Apply ear protection
-        assert(abs(l) < 1.0);
-        assert(abs(r) < 1.0);
+        // Keep the loop free of branches to let the compiler vectorize it
+        short lo = s.fill ? bin.min : INT16_MAX;
+        short hi = s.fill ? bin.max : INT16_MIN;
+        for (usize j = i; j < i + m; j++) {
+            lo = std::min(lo, samples[j]);
+            hi = std::max(hi, samples[j]);
+        }
+        bin.min = lo;
+        bin.max = hi;
+        
+        i += m;
+        s.fill += m;
         
-        stream.write(SamplePair { l, r } );
+        if (s.fill == scopeBinSize) {
+            
+            s.fill = 0;
+            s.current = (s.current + 1) % scopeBins;
+        }
     }
-    stream.unlock();
+}
+
+void
+SIDBridge::clearWaveforms()
+{
+    for (usize i = 0; i < 4; i++) {
+        
+        for (usize j = 0; j < scopeBins; j++) scope[i].bins[j] = WaveformBin { 0, 0 };
+        scope[i].current = 0;
+        scope[i].fill = 0;
+    }
+}
+
+usize
+SIDBridge::getWaveform(usize nr, WaveformBin *buffer, usize count) const
+{
+    assert(nr < 4);
+    
+    // The bin being filled is not handed out
+    const Scope &s = scope[nr];
+    usize current = s.current;
+    count = MIN(count, scopeBins - 1);
+    
+    for (usize i = 0; i < count; i++) {
+        buffer[i] = s.bins[(current + scopeBins - count + i) % scopeBins];
+    }
+    return count;
 }
 
 void
@@ -905,11 +1318,17 @@ SIDBridge::clearRingbuffer()
 void
 SIDBridge::ringbufferData(usize offset, float *left, float *right)
 {
-    const SamplePair &pair = stream.current((int)offset);
+    SamplePair pair = stream.current(offset);
     *left = pair.left;
     *right = pair.right;
 }
 
+usize
+SIDBridge::bufferedSamples()
+{
+    return stream.count();
+}
+
 void
 SIDBridge::handleBufferUnderflow()
 {
@@ -918,7 +1337,14 @@ SIDBridge::handleBufferUnderflow()
     // (1) The consumer runs slightly faster than the producer.
     // (2) The producer is halted or not startet yet.
     
-    trace(SID_DEBUG, "BUFFER UNDERFLOW (r: %d w: %d)\n", stream.r, stream.w);
+    trace(SID_DEBUG, "BUFFER UNDERFLOW (fill level: %zu)\n", stream.count());
+
+    // In audio-paced mode, the producer catches up on its own
+    if (oscillator.isAudioPaced()) {
+
+        bufferUnderflows++;
+        return;
+    }
 
     // Determine the elapsed seconds since the last pointer adjustment.
     u64 now = Oscillator::nanos();
@@ -947,7 +1373,14 @@ SIDBridge::handleBufferOverflow()
     // (1) The consumer runs slightly slower than the producer
     // (2) The consumer is halted or not startet yet
     
-    trace(SID_DEBUG, "BUFFER OVERFLOW (r: %d w: %d)\n", stream.r, stream.w);
+    trace(SID_DEBUG, "BUFFER OVERFLOW (fill level: %zu)\n", stream.count());
+    
+    // In audio-paced mode, the producer waits for the consumer on its own
+    if (oscillator.isAudioPaced()) {
+        
+        bufferOverflows++;
+        return;
+    }
     
     // Determine the elapsed seconds since the last pointer adjustment
     u64 now = Oscillator::nanos();
@@ -974,44 +1407,184 @@ SIDBridge::ignoreNextUnderOrOverflow()
     lastAlignment = Oscillator::nanos();
 }
 
-void
-SIDBridge::copyMono(float *target, usize n)
+ErrorCode
+SIDBridge::startTrace(const char *path, bool synth)
 {
-    stream.lock();
+    suspend();
     
-    // Check for a buffer underflow
-    if (stream.count() < n) handleBufferUnderflow();
+    ErrorCode result = ERROR_OK;
+    if (tracer.start(path, cpu.cycle, cpuFrequency)) {
+        synthesize = synth;
+    } else {
+        result = ERROR_FILE_CANT_CREATE;
+    }
+    
+    resume();
+    return result;
+}
 
-    // Copy sound samples
-    stream.copyMono(target, n, volL, volR);
+void
+SIDBridge::stopTrace()
+{
+    suspend();
     
-    stream.unlock();
+    tracer.stop();
+    
+    // Bring the SID engines up to date if they haven't been run
+    if (!synthesize) {
+        synthesize = true;
+        syncEngine();
+    }
+    
+    resume();
+}
+
+bool
+SIDBridge::isTapped() const
+{
+    return c64.recorder.isRecording() || numOutputs > 0;
+}
+
+void
+SIDBridge::copyMono(float *target, usize n)
+{
+    // Copy sound samples and report a buffer underflow to the producer
+    finishPull(n, stream.copyMono(target, n), 0);
 }
 
 void
 SIDBridge::copyStereo(float *target1, float *target2, usize n)
 {
-    stream.lock();
+    // Copy sound samples and report a buffer underflow to the producer
+    finishPull(n, stream.copyStereo(target1, target2, n), 0);
+}
+
+void
+SIDBridge::copyInterleaved(float *target, usize n)
+{
+    // Copy sound samples and report a buffer underflow to the producer
+    finishPull(n, stream.copyInterleaved(target, n), 0);
+}
+
+AudioPullResult
+SIDBridge::pullStereo(float *left, float *right, usize n, usize deviceLatency)
+{
+    return finishPull(n, stream.copyStereo(left, right, n), deviceLatency);
+}
+
+AudioPullResult
+SIDBridge::pullInterleaved(float *buffer, usize n, usize deviceLatency)
+{
+    return finishPull(n, stream.copyInterleaved(buffer, n), deviceLatency);
+}
+
+AudioPullResult
+SIDBridge::finishPull(usize n, usize delivered, usize deviceLatency)
+{
+    AudioPullResult result;
     
-    // Check for a buffer underflow
-    if (stream.count() < n) handleBufferUnderflow();
+    // Report a buffer underflow to the producer
+    if (delivered < n) {
+        
+        signalUnderflow = true;
+        underruns++;
+    }
+    
+    result.delivered = (i64)delivered;
+    result.buffered = (i64)stream.count();
+    result.latency = (i64)(n + stream.count() + deviceLatency);
+    result.underruns = (i64)underruns.load();
+    
+    return result;
+}
 
-    // Copy sound samples
-    stream.copyStereo(target1, target2, n, volL, volR);
+void
+SIDBridge::setLookahead(usize samples)
+{
+    suspend();
+    samplesAhead = (u32)MAX(1, MIN(samples, stream.cap() - 1));
+    alignWritePtr();
+    resume();
+}
+
+void
+SIDBridge::setSpeed(long percent)
+{
+    suspend();
+    stretcher.setRatio(percent / 100.0);
+    alignWritePtr();
+    resume();
+}
+
+isize
+SIDBridge::openOutput(double rate)
+{
+    for (usize i = 0; i < maxOutputs; i++) {
+        
+        if (outputs[i]) continue;
+        
+        outputs[i] = std::make_unique<Output>();
+        outputs[i]->resampler.setRates(internalRate, rate);
+        numOutputs++;
+        
+        trace(SID_DEBUG, "Opened output %zu (%f Hz)\n", i, rate);
+        return (isize)i;
+    }
     
-    stream.unlock();
+    warn("No free output available\n");
+    return -1;
 }
 
 void
-SIDBridge::copyInterleaved(float *target, usize n)
+SIDBridge::closeOutput(isize nr)
 {
-    stream.lock();
+    assert(nr >= 0 && nr < (isize)maxOutputs);
     
-    // Check for a buffer underflow
-    if (stream.count() < n) handleBufferUnderflow();
+    if (outputs[nr]) {
+        
+        outputs[nr].reset();
+        numOutputs--;
+    }
+}
 
-    // Read sound samples
-    stream.copyInterleaved(target, n, volL, volR);
+usize
+SIDBridge::readOutput(isize nr, SamplePair *buffer, usize n)
+{
+    assert(nr >= 0 && nr < (isize)maxOutputs);
     
-    stream.unlock();
+    if (!outputs[nr]) return 0;
+    
+    n = MIN(n, outputs[nr]->buffer.count());
+    outputs[nr]->buffer.read(buffer, n);
+    return n;
+}
+
+void
+SIDBridge::feedOutputs(const SamplePair *samples, usize n)
+{
+    const usize chunkSize = 64;
+    SamplePair resampled[1024];
+    
+    for (usize i = 0; i < maxOutputs; i++) {
+        
+        if (!outputs[i]) continue;
+        auto &out = *outputs[i];
+        
+        for (usize done = 0; done < n; ) {
+            
+            // Limit the chunk size to make the result fit into the buffer
+            usize chunk = MIN(chunkSize, n - done);
+            while (out.resampler.maxOutput(chunk) > 1024) chunk /= 2;
+            chunk = MAX(chunk, (usize)1);
+            
+            usize count = out.resampler.process(samples + done, chunk, resampled);
+            
+            // If the consumer falls behind, drop the oldest samples
+            if (count > out.buffer.free()) {
+                out.buffer.skip(MIN(out.buffer.count(), count - out.buffer.free()));
+            }
+            out.buffer.write(resampled, MIN(count, out.buffer.free()));
+            done += chunk;
+        }
+    }
 }
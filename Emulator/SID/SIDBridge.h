@@ -13,6 +13,10 @@
 #include "SIDPublicTypes.h"
 #include "Volume.h"
 #include "SIDStreams.h"
+#include "SIDMixer.h"
+#include "SIDResampler.h"
+#include "SIDStretcher.h"
+#include "SIDTracer.h"
 #include "FastSID.h"
 #include "ReSID.h"
 
@@ -22,29 +26,41 @@
  *           -------------------------------------------------
  *          |   --------  vol                                 |
  *   SID 0 --->| Buffer |----->                               |
- *          |   --------       |                              |
- *          |                  |                              |
- *          |   --------  vol  |             --------------   |
- *   SID 1 --->| Buffer |----->|          ->| StereoStream |-----> Speaker
- *          |   --------       |   pan   |   --------------   |
- *          |                  |-------->|                    |
- *          |   --------  vol  |  l vol  |   --------------
- *   SID 2 --->| Buffer |----->|  r vol   ->| StereoStream |-----> Recorder
- *          |   --------       |             --------------   |
- *          |                  |                              |
+ *          |   --------       |             -----------      |
+ *          |                  |          ->| Resampler |-----> Speaker
+ *          |   --------  vol  |         |   -----------      |
+ *   SID 1 --->| Buffer |----->|         |                    |
+ *          |   --------       |   pan   |                    |
+ *          |                  |-------->|------------------------> Recorder
+ *          |   --------  vol  |  l vol  |                    |
+ *   SID 2 --->| Buffer |----->|  r vol  |   -----------      |
+ *          |   --------       |          ->| Resampler |-----> Outputs
+ *          |                  |             -----------      |
  *          |   --------  vol  |                              |
  *   SID 3 --->| Buffer |----->                               |
  *          |   --------                                      |
  *           -------------------------------------------------
+ *
+ * The SIDs are executed only once at a fixed internal sample rate which is
+ * derived from the clock frequency. The mixed samples are converted into the
+ * rate of each consumer exactly once. Hence, adjusting the speaker rate never
+ * reconfigures the SID engines.
  */
 
 class SIDBridge : public C64Component {
 
     friend C64Memory;
+    friend class CoreBenchmark;
 
     // Current configuration
     SIDConfig config;
     
+    /* Maps each of the 32 register blocks of the SID area ($D400 - $D7FF) to
+     * the SID it selects. The table is derived from the configuration and
+     * rebuilt by updateSIDMap() whenever a SID is enabled or moved.
+     */
+    u8 sidMap[32];
+    
     
     //
     // Sub components
@@ -71,11 +87,61 @@ private:
     // CPU cycle at the last call to executeUntil()
     Cycle cycles = 0;
     
+    /* Register writes that haven't been passed to the SIDs, yet. Instead of
+     * running the SIDs up to the current cycle on each write, writes are
+     * recorded together with the cycle they belong to. They are replayed at
+     * these cycles when the SIDs are executed the next time.
+     */
+    struct RegWrite { Cycle cycle; u8 addr; u8 value; };
+    static const usize maxRegWrites = 1024;
+    RegWrite regWrites[4][maxRegWrites];
+    usize numRegWrites[4] = { 0, 0, 0, 0 };
+    
+    // Cycle of the most recent register write (equals 'cycles' if none)
+    Cycle lastWrite = 0;
+    
+    // Cycle of the most recent write to the voice 3 registers of each SID
+    Cycle voice3Write[4] = { 0, 0, 0, 0 };
+    
+    /* Shadow copy of all SID registers. Register writes are only passed to the
+     * active SID engine. When the engine is switched, the shadow registers are
+     * replayed into the new engine to bring it up to date.
+     */
+    u8 shadowRegs[4][32];
+    
+    // Register write tracer
+    SIDTracer tracer;
+    
+    // Indicates if the SID engines are run while tracing in headless mode
+    bool synthesize = true;
+    
+    // Helper threads for emulating SIDs 2 to 4 in parallel
+    WorkerThread workers[3];
+    
+    // Minimum number of cycles for running SIDs in parallel
+    static const usize minParallelCycles = 1000;
+    
     // Current CPU frequency
     u32 cpuFrequency = PAL_CLOCK_FREQUENCY;
     
-    // Sample rate (44.1 kHz per default)
+    // Ratio between the clock frequency and the internal sample rate
+    static constexpr u32 renderDivider = 16;
+    
+    // Sample rate of the SID engines (about 61.6 kHz on a PAL machine)
+    double internalRate = (double)PAL_CLOCK_FREQUENCY / renderDivider;
+    
+    // Sample rate of the speaker stream (44.1 kHz per default)
     double sampleRate = 44100.0;
+    
+    // Converts the mixed samples into the sample rate of the speaker stream
+    SIDResampler resampler;
+    
+    /* Sampling parameters whose update has been postponed, because a batch of
+     * configuration items is being applied (see C64::configure)
+     */
+    bool clockPending = false;
+    bool samplingPending = false;
+    SamplingMethod pendingSampling = SAMPLING_FAST;
         
     // Time stamp of the last write pointer alignment
     u64 lastAlignment = 0;
@@ -100,8 +166,14 @@ public:
     // TODO: MOVE TO SIDStats
     u64 bufferOverflows;
     
-    // Set to true to signal a buffer exception
-    bool signalUnderflow = false;
+    // Number of samples produced since the bridge has been created
+    u64 producedSamples = 0;
+    
+    // Set to true by the audio thread to signal a buffer underflow
+    std::atomic<bool> signalUnderflow {false};
+    
+    // Number of audio blocks that couldn't be filled completely
+    std::atomic<u64> underruns {0};
 
     
     //
@@ -118,6 +190,41 @@ public:
      */
     StereoStream stream;
     
+    /* Time stretcher for the mixed stream. If the emulator runs at a fixed
+     * speed other than real time, the stream is stretched or compressed to
+     * keep its original pitch.
+     */
+    SIDStretcher stretcher;
+    
+    /* Additional output streams. Each output converts the mixed samples into
+     * a custom sample rate, e.g., for recording or analyzing the audio signal
+     * without running the SIDs a second time.
+     */
+    struct Output {
+        
+        SIDResampler resampler;
+        RingBuffer<SamplePair, 16384> buffer;
+    };
+    static const usize maxOutputs = 4;
+    std::unique_ptr<Output> outputs[maxOutputs];
+    usize numOutputs = 0;
+    
+    /* Waveform envelopes for the visualizer. For each SID, the lowest and the
+     * highest sample value is recorded for each bin of scopeBinSize samples.
+     * The envelopes are only recorded while the SID panel is inspected.
+     */
+    static constexpr usize scopeBins = 1024;
+    static constexpr usize scopeBinSize = 32;
+    struct Scope {
+        
+        WaveformBin bins[scopeBins];
+        
+        // The bin being filled and the number of samples it contains
+        usize current;
+        usize fill;
+    };
+    Scope scope[4];
+    
     
     //
     // Initializing
@@ -149,6 +256,13 @@ public:
 
     bool isEnabled(usize nr) const { return GET_BIT(config.enabled, nr); }
     
+private:
+    
+    // Rebuilds sidMap from the current configuration
+    void updateSIDMap();
+    
+public:
+    
     bool isMuted() const;
 
     u32 getClockFrequency();
@@ -158,9 +272,16 @@ public:
     SIDRevision getRevision() const;
     void setRevision(SIDRevision revision);
     
-    double getSampleRate() const;
+    // Returns the sample rate the SIDs are rendered at
+    double getInternalRate() const { return internalRate; }
+    
+    // Gets or sets the sample rate of the speaker stream
+    double getSampleRate() const { return sampleRate; }
     void setSampleRate(double rate);
     
+    // Changes the scheduling parameters of the worker threads
+    void setThreadPolicy(const ThreadPolicy &policy);
+    
     // DEPRECATED: Use OPT_xxx
     bool getAudioFilter() const;
     void setAudioFilter(bool enable);
@@ -169,6 +290,27 @@ public:
     SamplingMethod getSamplingMethod() const;
     void setSamplingMethod(SamplingMethod method);
 
+    // Passes the postponed clock frequency and sampling method to reSID
+    void updateSamplingParameters();
+    
+private:
+    
+    // Adapts the internal sample rate and all resamplers to a new clock
+    void updateInternalRate();
+    
+public:
+
+    /* Applies a quality profile to a single reSID instance or to all of them.
+     * Different profiles can be used to emulate the primary SID in high
+     * quality and all other SIDs with cheaper settings.
+     */
+    SIDProfile getProfile(long nr) const;
+    void setProfile(long nr, const SIDProfile &profile);
+    void setProfile(const SIDProfile &profile);
+    
+    // Returns the throughput of a profile at the current sample rate
+    double measureThroughput(const SIDProfile &profile) const;
+
 private:
     
     void _dumpConfig() const override;
@@ -225,13 +367,19 @@ private:
     {
         worker
         
-        & cycles;
+        & cycles
+        & lastWrite
+        & shadowRegs;
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
+    void _memoryUsage(MemoryUsage &usage) override;
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
     usize didLoadFromBuffer(u8 *buffer) override;
+    usize willSaveToBuffer(u8 *buffer) override;
     
  
 private:
@@ -284,16 +432,31 @@ public:
     
     // Reads a audio sample pair without moving the read pointer
     void ringbufferData(usize offset, float *left, float *right);
+    
+    /* Copies the most recent bins of the waveform envelope of a SID into
+     * buffer, the oldest bin first. The function returns the number of copied
+     * bins. It may be called while the emulator is running. In this case, a
+     * few bins may be overwritten while being copied.
+     */
+    usize getWaveform(usize nr, WaveformBin *buffer, usize count) const;
+    
+    // Returns the number of sound samples waiting for the audio device
+    usize bufferedSamples();
             
     /* Handles a buffer underflow condition.
      * A buffer underflow occurs when the computer's audio device needs sound
-     * samples than SID hasn't produced, yet.
+     * samples than SID hasn't produced, yet. The condition is detected on the
+     * audio thread, which fills the gap with silence and signals it to the
+     * emulator thread. In audio-paced mode, the write pointer is not
+     * realigned.
      */
     void handleBufferUnderflow();
     
     /* Handles a buffer overflow condition.
      * A buffer overflow occurs when SID is producing more samples than the
-     * computer's audio device is able to consume.
+     * computer's audio device is able to consume. Samples that don't fit into
+     * the stream are dropped. In audio-paced mode, the write pointer is not
+     * realigned.
      */
     void handleBufferOverflow();
     
@@ -301,11 +464,22 @@ public:
     void ignoreNextUnderOrOverflow();
     
     /* Aligns the write pointer.
-     * This function puts the write pointer somewhat ahead of the read pointer.
-     * With a standard sample rate of 44100 Hz, 735 samples is 1/60 sec.
+     * This function discards all pending samples and puts the write pointer
+     * somewhat ahead of the read pointer. With a standard sample rate of
+     * 44100 Hz, 735 samples is 1/60 sec.
      */
-    const u32 samplesAhead = 8 * 735;
-    void alignWritePtr() { stream.clear(SamplePair {0,0} ); stream.align(samplesAhead); }
+    u32 samplesAhead = 8 * 735;
+    void alignWritePtr() { stream.clear(samplesAhead); }
+    
+    /* Sets the number of samples the emulator renders ahead of the audio
+     * device. Hosts with small audio buffers can reduce the latency by
+     * choosing a value of a few buffer sizes.
+     */
+    usize getLookahead() const { return samplesAhead; }
+    void setLookahead(usize samples);
+    
+    // Adapts the time stretcher to the emulation speed (in percent)
+    void setSpeed(long percent);
     
     /* Executes SID until a certain cycle is reached.
      * // The function returns the number of produced sound samples (not yet).
@@ -315,11 +489,50 @@ public:
     // Executes SID for a certain number of CPU cycles
 	usize executeCycles(usize numCycles);
 
+    // Indicates if someone besides the audio device consumes samples
+    bool isTapped() const;
+
 private:
     
-    // Called by executeCycles to produce the final stereo stream
-    void mixSingleSID(usize numSamples);
-    void mixMultiSID(usize numSamples);
+    // Records a register access which is replayed when the SID catches up
+    void recordAccess(usize nr, u8 addr, u8 value);
+    
+    // Runs the SIDs up to the most recent register write
+    void flushRegWrites();
+    
+    /* Checks if OSC3 or ENV3 can be predicted without running the SIDs up to
+     * the current cycle (see ReSID::peekAhead)
+     */
+    bool canPeekAhead(usize nr) const;
+    
+    // Passes the shadow registers to the active SID engine
+    void syncEngine();
+    
+    /* Called by executeCycles to run a single SID. Recorded register writes
+     * are applied when the SID has reached the corresponding cycles.
+     */
+    usize executeSID(usize nr, usize numCycles);
+    usize runSID(usize nr, usize numCycles);
+    
+    // Applies register writes to the shadow registers without running a SID
+    void skipCycles(usize numCycles);
+    
+    /* Called by executeCycles to produce the final stereo stream. The samples
+     * are processed in blocks, which are mixed by a vectorized kernel.
+     */
+    void mixSIDs(usize numSamples);
+    
+    // Converts a block of mixed samples into the speaker stream
+    void writeSpeaker(const SamplePair *samples, usize n);
+    
+    // Passes a block of mixed samples through the time stretcher
+    void writeStretched(const SamplePair *samples, usize n);
+    
+    // Adds a block of samples to the waveform envelope of a SID
+    void recordWaveform(usize nr, const short *samples, usize n);
+    
+    // Clears all waveform envelopes
+    void clearWaveforms();
 
     
     //
@@ -332,6 +545,61 @@ public:
     void copyStereo(float *left, float *right, usize n);
     void copyInterleaved(float *buffer, usize n);
 
+    /* Pulls a block of n samples out of the stream. The block is filled from
+     * the samples rendered ahead. If too few samples are available, the rest
+     * is filled with silence and an underrun is recorded. Argument
+     * deviceLatency is the latency of the host's audio device in samples. It
+     * is only used to compute the end-to-end latency.
+     */
+    AudioPullResult pullStereo(float *left, float *right, usize n, usize deviceLatency = 0);
+    AudioPullResult pullInterleaved(float *buffer, usize n, usize deviceLatency = 0);
+
+private:
+    
+    // Records an underrun (if any) and computes the result of a pull
+    AudioPullResult finishPull(usize n, usize delivered, usize deviceLatency);
+    
+public:
+
+    
+    //
+    // Managing additional outputs
+    //
+    
+public:
+    
+    /* Opens an output with the specified sample rate. The function returns
+     * the output number or -1 if all outputs are in use. Outputs are filled
+     * on the emulator thread. They should be read while the emulator is
+     * paused or, in headless mode, in between two runs.
+     */
+    isize openOutput(double rate);
+    void closeOutput(isize nr);
+    
+    // Reads up to n samples from an output and returns the number of samples
+    usize readOutput(isize nr, SamplePair *buffer, usize n);
+
+private:
+    
+    // Feeds a block of mixed samples into all additional outputs
+    void feedOutputs(const SamplePair *samples, usize n);
+
+    
+    //
+    // Tracing register writes
+    //
+    
+public:
+    
+    /* Starts streaming all SID register writes into a file (see SIDTracer.h
+     * for the file format). If synth is false, the SID engines are not run in
+     * headless mode while the trace is active. Only the shadow registers are
+     * updated. Note that reading OSC3 or ENV3 returns stale values then.
+     */
+    ErrorCode startTrace(const char *path, bool synth = true);
+    void stopTrace();
+    bool isTracing() const { return tracer.isTracing(); }
+
     
      
 	//
@@ -341,10 +609,14 @@ public:
 public:
     
     // Translates a memory address to the mapped SID
-    usize mappedSID(u16 addr) const;
+    usize mappedSID(u16 addr) const { return sidMap[(addr >> 5) & 0x1F]; }
+    
+    // Checks if all addresses of the 256 byte page of addr select SID 0
+    bool isSingleSIDPage(u16 addr) const;
     
 	// Special peek function for the I/O memory range
-	u8 peek(u16 addr);
+	u8 peek(u16 addr) { return peek(mappedSID(addr), addr); }
+    u8 peek(usize nr, u16 addr);
 	
     // Same as peek without side effects
     u8 spypeek(u16 addr) const;
@@ -354,5 +626,6 @@ public:
     u8 readPotY() const;
     
 	// Special poke function for the I/O memory range
-	void poke(u16 addr, u8 value);
+	void poke(u16 addr, u8 value) { poke(mappedSID(addr), addr, value); }
+    void poke(usize nr, u16 addr, u8 value);
 };
@@ -0,0 +1,83 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "SIDMixer.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+void
+mixSamples(const short *const in[], const float wl[], const float wr[],
+           usize channels, SamplePair *out, usize n)
+{
+    static_assert(sizeof(SamplePair) == 2 * sizeof(float), "Unexpected layout");
+    
+    usize i = 0;
+    
+#if defined(__SSE2__)
+    
+    for (; i + 4 <= n; i += 4) {
+        
+        __m128 l = _mm_setzero_ps();
+        __m128 r = _mm_setzero_ps();
+        
+        for (usize c = 0; c < channels; c++) {
+            
+            // Convert four samples to floating point values
+            __m128i s16 = _mm_loadl_epi64((const __m128i *)(in[c] + i));
+            __m128i s32 = _mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16);
+            __m128 s = _mm_cvtepi32_ps(s32);
+            
+            l = _mm_add_ps(l, _mm_mul_ps(s, _mm_set1_ps(wl[c])));
+            r = _mm_add_ps(r, _mm_mul_ps(s, _mm_set1_ps(wr[c])));
+        }
+        
+        // Interleave the left and right channel
+        float *dst = (float *)(out + i);
+        _mm_storeu_ps(dst, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(dst + 4, _mm_unpackhi_ps(l, r));
+    }
+    
+#elif defined(__ARM_NEON)
+    
+    for (; i + 4 <= n; i += 4) {
+        
+        float32x4x2_t lr = { vdupq_n_f32(0), vdupq_n_f32(0) };
+        
+        for (usize c = 0; c < channels; c++) {
+            
+            // Convert four samples to floating point values
+            float32x4_t s = vcvtq_f32_s32(vmovl_s16(vld1_s16(in[c] + i)));
+            
+            lr.val[0] = vmlaq_n_f32(lr.val[0], s, wl[c]);
+            lr.val[1] = vmlaq_n_f32(lr.val[1], s, wr[c]);
+        }
+        
+        // Interleave the left and right channel
+        vst2q_f32((float *)(out + i), lr);
+    }
+    
+#endif
+    
+    // Process the remaining samples one by one
+    for (; i < n; i++) {
+        
+        float l = 0, r = 0;
+        
+        for (usize c = 0; c < channels; c++) {
+            
+            l += (float)in[c][i] * wl[c];
+            r += (float)in[c][i] * wr[c];
+        }
+        out[i] = SamplePair { l, r };
+    }
+}
@@ -0,0 +1,20 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "SIDStreams.h"
+
+/* Mixes a block of SID samples into a block of stereo samples. Argument in
+ * refers to one sample buffer per channel. Each sample is weighted with the
+ * channel's left and right factors before the channels are accumulated. The
+ * function uses SSE2 or NEON vectors if available.
+ */
+void mixSamples(const short *const in[], const float wl[], const float wr[],
+                usize channels, SamplePair *out, usize n);
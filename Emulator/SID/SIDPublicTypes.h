@@ -40,6 +40,16 @@ enum_long(SAMPLING)
 };
 typedef SAMPLING SamplingMethod;
 
+// Sample layout of the audio stream handed over to the host
+enum_long(AUDIO_LAYOUT)
+{
+    AUDIO_LAYOUT_MONO,
+    AUDIO_LAYOUT_STEREO,
+    AUDIO_LAYOUT_INTERLEAVED,
+    AUDIO_LAYOUT_COUNT
+};
+typedef AUDIO_LAYOUT AudioLayout;
+
 //
 // Structures
 //
@@ -56,6 +66,12 @@ typedef struct
     SIDEngine engine;
     SamplingMethod sampling;
     
+    // Indicates if multiple SIDs are emulated on helper threads
+    bool parallel;
+    
+    // Sample layout of the audio stream
+    AudioLayout layout;
+    
     // Master volume (left and right channel)
     i64 volL;
     i64 volR;
@@ -66,6 +82,46 @@ typedef struct
 }
 SIDConfig;
 
+/* Quality settings of a single reSID instance. Lowering the passband of the
+ * resampling filter shortens the FIR filter and speeds up the sampling
+ * methods SAMPLING_RESAMPLE and SAMPLING_RESAMPLE_FASTMEM.
+ */
+typedef struct
+{
+    SamplingMethod sampling;
+    
+    // Upper edge of the passband in Hz (0 = reSID default)
+    double passband;
+    
+    // Requested order of the resampling filter (0 = derived from passband)
+    i64 firOrder;
+    
+    // Emulate the SID filter
+    bool filter;
+}
+SIDProfile;
+
+// Result of pulling a block of samples out of the audio stream
+typedef struct
+{
+    // Number of samples taken from the stream (the rest is silence)
+    i64 delivered;
+    
+    // Number of samples remaining in the stream after the call
+    i64 buffered;
+    
+    /* End-to-end latency in samples. This is the time it takes until the most
+     * recently emulated sample reaches the speaker. It comprises the pulled
+     * block, the samples remaining in the stream, and the latency of the audio
+     * device as reported by the host.
+     */
+    i64 latency;
+    
+    // Total number of underruns, i.e., blocks that couldn't be filled
+    i64 underruns;
+}
+AudioPullResult;
+
 typedef struct
 {
     u8 reg[7];
@@ -96,3 +152,11 @@ typedef struct
     u8 potY;
 }
 SIDInfo;
+
+typedef struct
+{
+    // Lowest and highest sample value in a range of samples
+    i16 min;
+    i16 max;
+}
+WaveformBin;
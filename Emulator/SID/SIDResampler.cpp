@@ -0,0 +1,99 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "SIDResampler.h"
+#include <cmath>
+
+void
+SIDResampler::setRates(double in, double out)
+{
+    assert(in > 0 && out > 0);
+
+    inRate = in;
+    outRate = out;
+    step = in / out;
+
+    // Lower the cutoff frequency if the rate is reduced
+    double cutoff = 0.95 * std::min(1.0, out / in);
+
+    // Widen the kernel accordingly
+    usize oldTaps = taps;
+    taps = std::min(maxTaps, (usize)std::ceil(16.0 / cutoff));
+    taps += taps & 1;
+
+    // Sample the windowed-sinc kernel at all phases
+    coeff.resize((phases + 1) * taps);
+
+    for (usize p = 0; p <= phases; p++) {
+
+        float *c = coeff.data() + p * taps;
+        double sum = 0;
+
+        for (usize j = 0; j < taps; j++) {
+
+            double x = (double)j - (double)(taps / 2 - 1) - (double)p / phases;
+            double t = x / (taps / 2);
+            double sinc = x == 0 ? 1.0 : std::sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+            double window = std::abs(t) >= 1.0 ? 0.0 :
+            0.42 + 0.5 * std::cos(M_PI * t) + 0.08 * std::cos(2 * M_PI * t);
+
+            c[j] = (float)(sinc * window);
+            sum += c[j];
+        }
+
+        // Normalize to unity gain
+        for (usize j = 0; j < taps; j++) c[j] = (float)(c[j] / sum);
+    }
+
+    // Keep the history if the kernel size hasn't changed (e.g., on rate drift)
+    if (taps != oldTaps) clear();
+}
+
+void
+SIDResampler::clear()
+{
+    for (usize i = 0; i < 2 * maxTaps; i++) history[i] = SamplePair { 0, 0 };
+    pos = 0;
+    frac = 0.0;
+}
+
+usize
+SIDResampler::process(const SamplePair *in, usize n, SamplePair *out)
+{
+    assert(taps > 0);
+
+    usize produced = 0;
+
+    for (usize i = 0; i < n; i++) {
+
+        // Append the sample to the history
+        history[pos] = history[pos + taps] = in[i];
+        pos = pos + 1 == taps ? 0 : pos + 1;
+
+        // Compute all output samples located before the next input sample
+        const SamplePair *h = history + pos;
+
+        for (; frac < 1.0; frac += step) {
+
+            const float *c = coeff.data() + (usize)(frac * phases + 0.5) * taps;
+            float l = 0, r = 0;
+
+            for (usize j = 0; j < taps; j++) {
+
+                l += c[j] * h[j].left;
+                r += c[j] * h[j].right;
+            }
+            out[produced++] = SamplePair { l, r };
+        }
+        frac -= 1.0;
+    }
+
+    assert(produced <= maxOutput(n));
+    return produced;
+}
@@ -0,0 +1,88 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "SIDStreams.h"
+#include <vector>
+
+/* Converts a stream of stereo samples from one sample rate into another. The
+ * resampler is a polyphase FIR filter. The windowed-sinc kernel is sampled at
+ * a fixed number of sub-sample positions (phases) when the rates are set up.
+ * Each output sample is computed by the phase that is closest to its position
+ * between two input samples. When the rate is reduced, the cutoff frequency
+ * is lowered and the kernel is widened accordingly to avoid aliasing.
+ */
+class SIDResampler {
+
+    // Number of precomputed kernel positions between two input samples
+    static constexpr usize phases = 256;
+
+    // Maximum number of filter taps
+    static constexpr usize maxTaps = 64;
+
+    // Number of filter taps (always even)
+    usize taps = 0;
+
+    // Filter coefficients (phases x taps)
+    std::vector<float> coeff;
+
+    /* The most recent input samples. Each sample is stored twice to give the
+     * filter a contiguous view of the last 'taps' samples.
+     */
+    SamplePair history[2 * maxTaps];
+    usize pos = 0;
+
+    // Number of input samples per output sample
+    double step = 1.0;
+
+    // Position of the next output sample relative to the filter center
+    double frac = 0.0;
+
+    // Input and output rate
+    double inRate = 0.0;
+    double outRate = 0.0;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    SIDResampler() { clear(); }
+
+    // Sets up the filter for a certain conversion
+    void setRates(double in, double out);
+
+    // Clears the filter history
+    void clear();
+
+    double getInputRate() const { return inRate; }
+    double getOutputRate() const { return outRate; }
+
+    // Returns the size of the coefficient table in bytes
+    usize memoryUsage() const { return coeff.capacity() * sizeof(float); }
+
+    // Returns the maximum number of samples produced for n input samples
+    usize maxOutput(usize n) const { return (usize)(n / step) + 1; }
+
+
+    //
+    // Resampling
+    //
+
+public:
+
+    /* Processes n input samples and writes the produced samples into out.
+     * The function returns the number of produced samples which never
+     * exceeds maxOutput(n).
+     */
+    usize process(const SamplePair *in, usize n, SamplePair *out);
+};
@@ -9,81 +9,146 @@
 
 #include "SIDBridge.h"
 
+StereoStream::StereoStream() : r(0), w(0), keep(0)
+{
+    memset(samples, 0, sizeof(samples));
+}
+
 void
-StereoStream::copyMono(float *buffer, usize n, Volume &volL, Volume &volR)
-{    
-    // The caller has to ensure that no buffer underflows occurs
-    assert(count() >= n);
+StereoStream::setLayout(AudioLayout value)
+{
+    assert_enum(AudioLayout, value);
     
-    if (volL.isFading()) {
-        
-        for (usize i = 0; i < n; i++, volL.shift()) {
-            
-            SamplePair pair = read();
-            *buffer++ = (pair.left + pair.right) * volL.current;
-        }
-
-    } else {
-        
-        for (usize i = 0; i < n; i++) {
-                            
-            SamplePair pair = read();
-            *buffer++ = (pair.left + pair.right) * volL.current;
-        }
-    }
+    layout = value;
+    r.store(0);
+    w.store(0);
+    keep.store(0);
+    memset(samples, 0, sizeof(samples));
 }
 
 void
-StereoStream::copyStereo(float *left, float *right, usize n, Volume &volL, Volume &volR)
+StereoStream::write(const SamplePair *pairs, usize n)
 {
-    // The caller has to ensure that no buffer underflows occurs
-    assert(count() >= n);
+    assert(n <= free());
+    
+    usize wi = w.load(std::memory_order_relaxed);
+    for (usize i = 0; i < n; i++, wi = (wi + 1) & mask) store(wi, pairs[i]);
+    w.store(wi, std::memory_order_release);
+}
 
-    // printf("isFading: %d\n", volume.isFading());
-    // printf("cur: %f target: %f delta: %f\n", volume.current, volume.target[0], volume.delta[0]);
+void
+StereoStream::clear(usize offset)
+{
+    assert(offset > 0 && offset < capacity);
     
-    if (volL.isFading() || volR.isFading()) {
-                
-        for (usize i = 0; i < n; i++, volL.shift(), volR.shift()) {
-            
-            SamplePair pair = read();
-            *left++ = pair.left * volL.current;
-            *right++ = pair.right * volR.current;
-        }
+    // Append silence
+    usize n = MIN(offset, free());
+    usize wi = w.load(std::memory_order_relaxed);
+    for (usize i = 0; i < n; i++, wi = (wi + 1) & mask) store(wi, SamplePair {0,0});
+    w.store(wi, std::memory_order_release);
+    
+    // Ask the consumer to drop everything in front of it
+    keep.store(offset);
+}
 
-    } else {
-        
-        for (usize i = 0; i < n; i++) {
-                                        
-            SamplePair pair = read();
-            *left++ = pair.left * volL.current;
-            *right++ = pair.right * volR.current;
-        }
+void
+StereoStream::handleSkipRequest()
+{
+    usize offset = keep.exchange(0);
+    
+    if (offset && count() > offset) {
+        r.store((w.load(std::memory_order_acquire) - offset) & mask,
+                std::memory_order_release);
     }
 }
 
-void
-StereoStream::copyInterleaved(float *buffer, usize n, Volume &volL, Volume &volR)
+usize
+StereoStream::copyMono(float *buffer, usize n)
+{
+    return copy(AUDIO_LAYOUT_MONO, buffer, nullptr, n);
+}
+
+usize
+StereoStream::copyStereo(float *left, float *right, usize n)
+{
+    return copy(AUDIO_LAYOUT_STEREO, left, right, n);
+}
+
+usize
+StereoStream::copyInterleaved(float *buffer, usize n)
+{
+    return copy(AUDIO_LAYOUT_INTERLEAVED, buffer, nullptr, n);
+}
+
+usize
+StereoStream::copy(AudioLayout format, float *left, float *right, usize n)
 {
-    // The caller has to ensure that no buffer underflows occurs
-    assert(count() >= n);
+    handleSkipRequest();
 
-    if (volL.isFading()) {
-                
-        for (usize i = 0; i < n; i++, volL.shift()) {
+    usize ri = r.load(std::memory_order_relaxed);
+    usize wi = w.load(std::memory_order_acquire);
+    usize cnt = MIN(n, (wi - ri) & mask);
+    
+    if (format == layout) {
+        
+        // Hand out the samples en bloc (at most two spans)
+        for (usize done = 0; done < cnt; ) {
+            
+            usize span = MIN(cnt - done, capacity - ri);
             
-            SamplePair pair = read();
-            *buffer++ = pair.left * volL.current;
-            *buffer++ = pair.right * volR.current;
+            switch (layout) {
+                    
+                case AUDIO_LAYOUT_MONO:
+                    memcpy(left + done, samples + ri, span * sizeof(float));
+                    break;
+                    
+                case AUDIO_LAYOUT_STEREO:
+                    memcpy(left + done, samples + ri, span * sizeof(float));
+                    memcpy(right + done, samples + capacity + ri, span * sizeof(float));
+                    break;
+                    
+                default:
+                    memcpy(left + 2 * done, samples + 2 * ri, 2 * span * sizeof(float));
+            }
+            ri = (ri + span) & mask;
+            done += span;
         }
-
+        
     } else {
         
-        for (usize i = 0; i < n; i++) {
-                                        
-            SamplePair pair = read();
-            *buffer++ = pair.left * volL.current;
-            *buffer++ = pair.right * volR.current;
+        // Convert the samples one by one
+        for (usize i = 0; i < cnt; i++, ri = (ri + 1) & mask) {
+            
+            SamplePair pair = load(ri);
+            
+            switch (format) {
+                    
+                case AUDIO_LAYOUT_MONO:
+                    left[i] = pair.left + pair.right;
+                    break;
+                    
+                case AUDIO_LAYOUT_STEREO:
+                    left[i] = pair.left;
+                    right[i] = pair.right;
+                    break;
+                    
+                default:
+                    left[2 * i] = pair.left;
+                    left[2 * i + 1] = pair.right;
+            }
         }
     }
+    r.store(ri, std::memory_order_release);
+    
+    // Fill the rest with silence
+    if (format == AUDIO_LAYOUT_INTERLEAVED) {
+        for (usize i = 2 * cnt; i < 2 * n; i++) left[i] = 0;
+    } else {
+        for (usize i = cnt; i < n; i++) left[i] = 0;
+    }
+    if (format == AUDIO_LAYOUT_STEREO) {
+        for (usize i = cnt; i < n; i++) right[i] = 0;
+    }
+    
+    return cnt;
 }
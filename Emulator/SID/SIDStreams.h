@@ -10,17 +10,59 @@
 #pragma once
 
 #include "Buffers.h"
-#include "Concurrency.h"
+#include "SIDTypes.h"
+#include <atomic>
+
 
 typedef RingBuffer<short, 2048> SampleStream;
 
 typedef struct { float left; float right; } SamplePair;
 
-class StereoStream : public RingBuffer < SamplePair, 12288 > {
+/* The stereo stream connects the emulator thread (producer) with the audio
+ * thread of the host (consumer). It is a lock-free single-producer,
+ * single-consumer ring buffer. The write pointer is only modified by the
+ * producer and the read pointer is only modified by the consumer. Hence, the
+ * audio callback never blocks on the emulator thread.
+ *
+ * The samples are stored in the format requested by the host. They are
+ * either stored as a single mono plane, as two separate planes for the left
+ * and the right channel, or interleaved. If the host asks for the format the
+ * stream has been configured with, the samples are handed out with memcpy.
+ * The master volume has already been applied by the producer.
+ */
+class StereoStream {
+    
+public:
+    
+    // Number of elements in the ring buffer (must be a power of two)
+    static constexpr usize capacity = 16384;
+    
+private:
     
-    // Mutex for synchronizing read / write accesses
-    Mutex mutex;
+    static constexpr usize mask = capacity - 1;
+    static_assert((capacity & mask) == 0, "Capacity must be a power of two");
 
+    /* Sample storage. In mono layout, only the first plane is used. In stereo
+     * layout, the left plane is followed by the right plane. In interleaved
+     * layout, the buffer holds capacity sample pairs.
+     */
+    float samples[2 * capacity];
+    
+    // The current sample layout
+    AudioLayout layout = AUDIO_LAYOUT_INTERLEAVED;
+    
+    // Read pointer (owned by the consumer)
+    std::atomic<usize> r;
+    
+    // Write pointer (owned by the producer)
+    std::atomic<usize> w;
+    
+    /* Skip request. The producer can't move the read pointer. To reduce the
+     * fill level, it asks the consumer to drop all but the specified number of
+     * elements. A value of 0 means that no request is pending.
+     */
+    std::atomic<usize> keep;
+    
     
     //
     // Initializing
@@ -28,29 +70,109 @@ class StereoStream : public RingBuffer < SamplePair, 12288 > {
     
 public:
         
-    // StereoStream() { }
+    StereoStream();
+    
+    /* Changes the sample layout. The stream is emptied. The function must
+     * not be called while the consumer is reading.
+     */
+    void setLayout(AudioLayout value);
+    AudioLayout getLayout() const { return layout; }
     
     
     //
-    // Synchronizing access
+    // Querying the fill status (producer and consumer)
     //
-
+    
 public:
+    
+    usize cap() const { return capacity - 1; }
+    usize count() const { return (w.load() - r.load()) & mask; }
+    usize free() const { return capacity - count() - 1; }
+    double fillLevel() const { return (double)count() / capacity; }
+    bool isEmpty() const { return count() == 0; }
+    bool isFull() const { return free() == 0; }
 
-    // Locks or unlocks the synchronization mutex
-    void lock() { mutex.lock(); }
-    void unlock() { mutex.unlock(); }
+    // Returns the element at the specified distance from the read pointer
+    SamplePair current(usize offset) const {
+        return load((r.load(std::memory_order_relaxed) + offset) & mask); }
 
+private:
+    
+    // Reads or writes the element at the specified position
+    SamplePair load(usize i) const {
+        switch (layout) {
+            case AUDIO_LAYOUT_MONO:   return { samples[i] * 0.5f, samples[i] * 0.5f };
+            case AUDIO_LAYOUT_STEREO: return { samples[i], samples[capacity + i] };
+            default:                  return { samples[2 * i], samples[2 * i + 1] };
+        }
+    }
+    void store(usize i, SamplePair pair) {
+        switch (layout) {
+            case AUDIO_LAYOUT_MONO:   samples[i] = pair.left + pair.right; break;
+            case AUDIO_LAYOUT_STEREO: samples[i] = pair.left; samples[capacity + i] = pair.right; break;
+            default:                  samples[2 * i] = pair.left; samples[2 * i + 1] = pair.right;
+        }
+    }
+    
     
     //
-    // Copying data
+    // Writing data (producer)
     //
     
+public:
+    
+    /* Appends n elements in the format of the current layout. The caller has
+     * to ensure that the buffer has enough free space.
+     */
+    void write(const SamplePair *pairs, usize n);
+    
+    /* Returns the number of elements that can be written en bloc, i.e.,
+     * without wrapping around the end of the element storage, together with a
+     * pointer to the first element. After the span has been filled, the
+     * elements are handed over to the consumer with commit(). The pointer can
+     * only be used in interleaved layout.
+     */
+    usize writeSpan() const {
+        return std::min(free(), capacity - w.load(std::memory_order_relaxed)); }
+    SamplePair *writePtr() {
+        assert(layout == AUDIO_LAYOUT_INTERLEAVED);
+        return (SamplePair *)samples + w.load(std::memory_order_relaxed); }
+    void commit(usize n) {
+        assert(n <= free());
+        w.store((w.load(std::memory_order_relaxed) + n) & mask, std::memory_order_release);
+    }
+    
+    /* Replaces the contents by the specified number of silent elements. The
+     * producer can't discard elements. Hence, the silence is appended and the
+     * consumer is asked to drop everything in front of it at its next read
+     * access. If the buffer lacks the space, less silence is appended.
+     */
+    void clear(usize offset);
+    
+    
+    //
+    // Copying data (consumer)
+    //
+    
+public:
+    
     /* Copies n audio samples into a memory buffer. These functions mark the
      * final step in the audio pipeline. They are used to copy the generated
-     * sound samples into the buffers of the native sound device.
+     * sound samples into the buffers of the native sound device. If the
+     * stream runs dry, the remaining samples are filled with silence. The
+     * functions return the number of samples taken from the stream.
      */
-    void copyMono(float *buffer, usize n, Volume &volL, Volume &volR);
-    void copyStereo(float *left, float *right, usize n, Volume &volL, Volume &volR);
-    void copyInterleaved(float *buffer, usize n, Volume &volL, Volume &volR);
+    usize copyMono(float *buffer, usize n);
+    usize copyStereo(float *left, float *right, usize n);
+    usize copyInterleaved(float *buffer, usize n);
+    
+private:
+    
+    /* Copies n samples in the specified format. Argument right is only used
+     * in stereo format.
+     */
+    usize copy(AudioLayout format, float *left, float *right, usize n);
+    
+    // Serves a pending skip request
+    void handleSkipRequest();
 };
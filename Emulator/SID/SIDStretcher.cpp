@@ -0,0 +1,79 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "SIDStretcher.h"
+#include <cmath>
+
+SIDStretcher::SIDStretcher()
+{
+    // Periodic Hann window (two windows overlapping by 50% add up to 1)
+    for (usize i = 0; i < grainSize; i++) {
+        window[i] = (float)(0.5 - 0.5 * std::cos(2 * M_PI * i / grainSize));
+    }
+    clear();
+}
+
+void
+SIDStretcher::setRatio(double value)
+{
+    assert(value > 0);
+
+    if (ratio != value) {
+
+        ratio = value;
+        clear();
+    }
+}
+
+void
+SIDStretcher::clear()
+{
+    input.clear();
+    pos = 0.0;
+    for (usize i = 0; i < hop; i++) tail[i] = SamplePair { 0, 0 };
+}
+
+void
+SIDStretcher::write(const SamplePair *in, usize n)
+{
+    input.insert(input.end(), in, in + n);
+}
+
+usize
+SIDStretcher::read(SamplePair *out, usize max)
+{
+    usize produced = 0;
+
+    // Each grain completes hop output samples
+    while (produced + hop <= max && (usize)pos + grainSize <= input.size()) {
+
+        const SamplePair *grain = input.data() + (usize)pos;
+
+        for (usize i = 0; i < hop; i++) {
+
+            // Add the first half of the grain to the tail of the previous one
+            out[produced + i].left = tail[i].left + grain[i].left * window[i];
+            out[produced + i].right = tail[i].right + grain[i].right * window[i];
+
+            // Keep the second half for the next grain
+            tail[i].left = grain[hop + i].left * window[hop + i];
+            tail[i].right = grain[hop + i].right * window[hop + i];
+        }
+
+        produced += hop;
+        pos += hop * ratio;
+    }
+
+    // Discard all samples in front of the next grain
+    usize consumed = std::min((usize)pos, input.size());
+    input.erase(input.begin(), input.begin() + consumed);
+    pos -= consumed;
+
+    return produced;
+}
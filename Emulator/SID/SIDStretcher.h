@@ -0,0 +1,84 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "SIDStreams.h"
+#include <vector>
+
+/* Changes the duration of a stream of stereo samples without changing its
+ * pitch. The stretcher is an overlap-add (OLA) processor. It cuts grains out
+ * of the input stream, applies a Hann window, and adds them up with an
+ * overlap of 50%. The output hop is fixed. The input hop is scaled by the
+ * stretch ratio, i.e., grains are skipped when the emulator runs faster than
+ * real time and repeated partially when it runs slower.
+ */
+class SIDStretcher {
+
+    // Number of samples in a grain
+    static constexpr usize grainSize = 1024;
+
+    // Distance between two output grains
+    static constexpr usize hop = grainSize / 2;
+
+    // Window function
+    float window[grainSize];
+
+    // Input samples that haven't been consumed yet
+    std::vector<SamplePair> input;
+
+    // Position of the next grain in the input buffer
+    double pos = 0.0;
+
+    // Windowed second half of the previous grain
+    SamplePair tail[hop];
+
+    // Number of input samples per output sample
+    double ratio = 1.0;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    SIDStretcher();
+
+    // Sets the number of input samples per output sample
+    void setRatio(double value);
+    double getRatio() const { return ratio; }
+
+    // Returns true if the stretcher alters the stream
+    bool isActive() const { return ratio != 1.0; }
+
+    // Discards all buffered samples
+    void clear();
+
+    // Returns the size of the input buffer in bytes
+    usize memoryUsage() const { return input.capacity() * sizeof(SamplePair); }
+
+    // Returns the number of samples produced for n input samples on average
+    usize expectedOutput(usize n) const { return (usize)(n / ratio); }
+
+
+    //
+    // Stretching
+    //
+
+public:
+
+    // Feeds n input samples into the stretcher
+    void write(const SamplePair *in, usize n);
+
+    /* Writes the samples produced so far into out. The function returns the
+     * number of written samples which never exceeds max.
+     */
+    usize read(SamplePair *out, usize max);
+};
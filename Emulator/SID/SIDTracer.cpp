@@ -0,0 +1,123 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "SIDTracer.h"
+#include <unistd.h>
+
+SIDTracer::~SIDTracer()
+{
+    stop();
+}
+
+bool
+SIDTracer::start(const char *path, u64 cycle, u32 clockFrequency)
+{
+    assert(path);
+
+    stop();
+
+    if (!(file = fopen(path, "wb"))) return false;
+
+    // Write the header
+    u8 header[13] = { 'V', 'C', '6', '4', 'S', 'I', 'D', 'T', 1 };
+    for (isize i = 0; i < 4; i++) header[9 + i] = (u8)(clockFrequency >> (8 * i));
+    fwrite(header, 1, sizeof(header), file);
+
+    r = w = 0;
+    lastCycle = cycle;
+    numRecords = 0;
+    numDropped = 0;
+    quit = false;
+
+    pthread_create(&thread, nullptr, main, (void *)this);
+    return true;
+}
+
+void
+SIDTracer::stop()
+{
+    if (!isTracing()) return;
+
+    // Let the consumer thread drain the queue and terminate
+    quit = true;
+    pthread_join(thread, nullptr);
+
+    fclose(file);
+    file = nullptr;
+}
+
+void
+SIDTracer::record(u64 cycle, usize sidNr, u8 reg, u8 value)
+{
+    assert(isTracing());
+    
+    // The cycle counter restarts on reset
+    if (cycle < lastCycle) lastCycle = cycle;
+
+    usize wi = w.load(std::memory_order_relaxed);
+    usize ri = r.load(std::memory_order_acquire);
+
+    // Drop the record if the consumer falls behind
+    if (capacity - 1 - ((wi - ri) & mask) < maxRecordSize) {
+        numDropped++;
+        return;
+    }
+
+    // Encode the cycle delta as a variable length integer
+    u64 delta = cycle - lastCycle;
+    do {
+        u8 byte = delta & 0x7F;
+        delta >>= 7;
+        queue[wi] = delta ? byte | 0x80 : byte;
+        wi = (wi + 1) & mask;
+    } while (delta);
+
+    queue[wi] = (u8)(sidNr << 5 | (reg & 0x1F));
+    wi = (wi + 1) & mask;
+    queue[wi] = value;
+    wi = (wi + 1) & mask;
+
+    w.store(wi, std::memory_order_release);
+    lastCycle = cycle;
+    numRecords++;
+}
+
+void
+SIDTracer::drain()
+{
+    usize ri = r.load(std::memory_order_relaxed);
+    usize wi = w.load(std::memory_order_acquire);
+
+    // Write the pending bytes (at most two spans)
+    if (wi < ri) {
+        fwrite(queue + ri, 1, capacity - ri, file);
+        ri = 0;
+    }
+    if (wi > ri) {
+        fwrite(queue + ri, 1, wi - ri, file);
+        ri = wi;
+    }
+
+    r.store(ri, std::memory_order_release);
+}
+
+void *
+SIDTracer::main(void *ptr)
+{
+    SIDTracer *tracer = (SIDTracer *)ptr;
+
+    while (!tracer->quit.load()) {
+
+        tracer->drain();
+        usleep(5000);
+    }
+    tracer->drain();
+
+    return nullptr;
+}
@@ -0,0 +1,108 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "C64Types.h"
+#include <atomic>
+#include <pthread.h>
+#include <cstdio>
+
+/* Streams all SID register writes into a file. The emulator thread encodes
+ * each write into a lock-free single-producer, single-consumer byte queue. A
+ * background thread drains the queue into the output file. If the consumer
+ * falls behind, the emulator thread never waits. Instead, the record is
+ * dropped and counted.
+ *
+ * File format:
+ *
+ *     Header  : "VC64SIDT" (8 bytes), version (1 byte), CPU clock (4 bytes LE)
+ *     Records : cycle delta (LEB128), SID number << 5 | register, value
+ *
+ * The cycle delta refers to the previous record or, for the first record, to
+ * the cycle the trace was started in. It is zero after a reset.
+ */
+class SIDTracer {
+
+    // Capacity of the byte queue (must be a power of two)
+    static constexpr usize capacity = 1 << 16;
+    static constexpr usize mask = capacity - 1;
+
+    // Maximum size of an encoded record
+    static constexpr usize maxRecordSize = 12;
+
+    // The byte queue
+    u8 queue[capacity];
+    std::atomic<usize> r {0};
+    std::atomic<usize> w {0};
+
+    // Cycle of the most recent record
+    u64 lastCycle = 0;
+
+    // Statistics
+    u64 numRecords = 0;
+    u64 numDropped = 0;
+
+    // The output file
+    FILE *file = nullptr;
+
+    // The consumer thread
+    pthread_t thread;
+    std::atomic<bool> quit {false};
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    ~SIDTracer();
+
+
+    //
+    // Controlling
+    //
+
+public:
+
+    // Opens the output file and launches the consumer thread
+    bool start(const char *path, u64 cycle, u32 clockFrequency);
+
+    // Drains the queue, terminates the consumer thread, and closes the file
+    void stop();
+
+    bool isTracing() const { return file != nullptr; }
+
+    // Returns the number of recorded or dropped register writes
+    u64 recorded() const { return numRecords; }
+    u64 dropped() const { return numDropped; }
+
+
+    //
+    // Recording (emulator thread)
+    //
+
+public:
+
+    void record(u64 cycle, usize sidNr, u8 reg, u8 value);
+
+
+    //
+    // Draining (consumer thread)
+    //
+
+private:
+
+    // Writes all pending bytes into the output file
+    void drain();
+
+    // The thread's main function
+    static void *main(void *tracer);
+};
@@ -77,3 +77,24 @@ struct SamplingMethodEnum : Reflection<SamplingMethodEnum, SamplingMethod> {
         return "???";
     }
 };
+
+struct AudioLayoutEnum : Reflection<AudioLayoutEnum, AudioLayout> {
+    
+    static bool isValid(long value)
+    {
+        return (unsigned long)value < AUDIO_LAYOUT_COUNT;
+    }
+    
+    static const char *prefix() { return "AUDIO_LAYOUT"; }
+    static const char *key(AudioLayout value)
+    {
+        switch (value) {
+                
+            case AUDIO_LAYOUT_MONO:         return "MONO";
+            case AUDIO_LAYOUT_STEREO:       return "STEREO";
+            case AUDIO_LAYOUT_INTERLEAVED:  return "INTERLEAVED";
+            case AUDIO_LAYOUT_COUNT:        return "???";
+        }
+        return "???";
+    }
+};
@@ -30,6 +30,12 @@
 
 #include "C64.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 FastSID::FastSID(C64 &ref, SIDBridge &bridgeref, int n) : C64Component(ref), bridge(bridgeref), nr(n)
 {    
     subComponents = vector<HardwareComponent *> {
@@ -74,12 +80,34 @@ FastSID::init(int sampleRate, int cycles_per_sec)
     voice[2].updateInternals(false);
 }
 
+std::shared_ptr<const FastSIDFilterTables>
+FastSIDFilterTables::get(u32 sampleRate)
+{
+    static Mutex lock;
+    static map<u32, std::weak_ptr<const FastSIDFilterTables>> cache;
+    
+    AutoMutex guard(lock);
+    
+    // Reuse the tables if another instance runs at the same sample rate
+    if (auto result = cache[sampleRate].lock()) return result;
+    
+    // Forget about tables that are no longer in use
+    for (auto it = cache.begin(); it != cache.end(); ) {
+        if (it->second.expired()) it = cache.erase(it); else it++;
+    }
+    
+    auto result = std::make_shared<FastSIDFilterTables>();
+    result->init(sampleRate);
+    cache[sampleRate] = result;
+    
+    return result;
+}
+
 void
-FastSID::initFilter(int sampleRate)
+FastSIDFilterTables::init(u32 sampleRate)
 {
     u16 uk;
     float rk;
-    long int si;
     
     const float filterRefFreq = 44100.0;
     
@@ -94,7 +122,6 @@ FastSID::initFilter(int sampleRate)
     float filterFs = 400.0;
     float filterFm = 60.0;
     float filterFt = (float)0.05;
-    float filterAmpl = 1.0;
     
     // Low pass lookup table
     for (uk = 0, rk = 0; rk < 0x800; rk++, uk++) {
@@ -126,7 +153,17 @@ FastSID::initFilter(int sampleRate)
     }
     filterResTable[0] = resDyMin;
     filterResTable[15] = resDyMax;
-    filterAmpl = emulateFilter ? 0.7 : 1.0;
+}
+
+void
+FastSID::initFilter(int sampleRate)
+{
+    u16 uk;
+    long int si;
+    
+    filterTables = FastSIDFilterTables::get((u32)sampleRate);
+    
+    float filterAmpl = emulateFilter ? 0.7 : 1.0;
     
     // Amplifier lookup table
     for (uk = 0, si = 0; si < 256; si++, uk++) {
@@ -359,7 +396,7 @@ FastSID::poke(u16 addr, u8 value)
 i64
 FastSID::executeCycles(usize numCycles, SampleStream &stream)
 {
-    usize buflength = stream.cap();
+    usize buflength = stream.cap() - 1;
     
     executedCycles += numCycles;
     
@@ -380,12 +417,18 @@ FastSID::executeCycles(usize numCycles, SampleStream &stream)
     // Check for a buffer overflow
     if (unlikely(samples > stream.free())) {
         warn("SID %d: SAMPLE BUFFER OVERFLOW", nr);
-        stream.clear();
+        stream.skip(MIN(stream.count(), samples - stream.free()));
     }
     
-    // Compute missing samples
-    for (unsigned i = 0; i < samples; i++) {
-        stream.write(calculateSingleSample());
+    // Compute missing samples directly into the ringbuffer (at most two spans)
+    for (usize todo = samples; todo > 0; ) {
+        
+        usize span = MIN(todo, stream.writeSpan());
+        short *ptr = stream.writePtr();
+        
+        renderSamples(ptr, span);
+        stream.commit(span);
+        todo -= span;
     }
     
     return samples;
@@ -409,98 +452,183 @@ FastSID::updateInternals()
         voice[i].setFilterType(type);
         
         if (type == FASTSID_BAND_PASS) {
-            voice[i].filterDy = bandPassParam[cutoff];
+            voice[i].filterDy = filterTables->bandPassParam[cutoff];
         } else {
-            voice[i].filterDy = lowPassParam[cutoff];
+            voice[i].filterDy = filterTables->lowPassParam[cutoff];
         }
-        voice[i].filterResDy = MAX(filterResTable[res] - voice[i].filterDy, 1.0);
+        voice[i].filterResDy = MAX(filterTables->filterResTable[res] - voice[i].filterDy, 1.0);
     }
 }
     
-i16
-FastSID::calculateSingleSample()
+void
+FastSID::renderSamples(short *out, usize n)
 {
-    u32 osc0, osc1, osc2;
-    FastVoice *v0 = &voice[0];
-    FastVoice *v1 = &voice[1];
-    FastVoice *v2 = &voice[2];
-    bool sync0 = false;
-    bool sync1 = false;
-    bool sync2 = false;
-    
-    // Advance wavetable counters
-    v0->waveTableCounter += v0->step;
-    v1->waveTableCounter += v1->step;
-    v2->waveTableCounter += v2->step;
-    
-    // Check for counter overflows (waveform loops)
-    if (v0->waveTableCounter < v0->step) {
-        v0->lsfr = NSHIFT(v0->lsfr, 16);
-        sync1 = v1->syncBit();
-    }
-    if (v1->waveTableCounter < v1->step) {
-        v1->lsfr = NSHIFT(v1->lsfr, 16);
-        sync2 = v2->syncBit();
-    }
-    if (v2->waveTableCounter < v2->step) {
-        v2->lsfr = NSHIFT(v2->lsfr, 16);
-        sync0 = v0->syncBit();
+    FastVoice *v[3] = { &voice[0], &voice[1], &voice[2] };
+    
+    // Values derived from the SID registers stay constant during a block
+    bool noise[3], filter[3];
+    usize prev[3];
+    for (usize k = 0; k < 3; k++) {
+        noise[k] = v[k]->waveform() == FASTSID_NOISE;
+        filter[k] = filterOn((unsigned)k);
+        prev[k] = (usize)(v[k]->prev - voice);
     }
+    bool mute = voiceThreeDisconnected();
+    int volume = sidVolume();
+    
+    /* Wavetable and ADSR counters of all voices, one voice per vector lane.
+     * The fourth lane is unused and set up to never trigger an event.
+     */
+    alignas(16) u32 cnt[4], stp[4], env[4], inc[4], cmp[4];
+    
+    auto load = [&]() {
+        for (usize k = 0; k < 3; k++) {
+            cnt[k] = v[k]->waveTableCounter;
+            stp[k] = v[k]->step;
+            env[k] = v[k]->adsr;
+            inc[k] = (u32)v[k]->adsrInc;
+            cmp[k] = v[k]->adsrCmp;
+        }
+        cnt[3] = stp[3] = env[3] = inc[3] = 0;
+        cmp[3] = 0x80000000;
+    };
+    auto save = [&]() {
+        for (usize k = 0; k < 3; k++) {
+            v[k]->waveTableCounter = cnt[k];
+            v[k]->adsr = env[k];
+        }
+    };
     
-    // Perform hard sync
-    if (sync0) {
-        v0->lsfr = NSHIFT(v0->lsfr, v0->waveTableCounter >> 28);
-        v0->waveTableCounter = 0;
-    }
-    if (sync1) {
-        v1->lsfr = NSHIFT(v1->lsfr, v1->waveTableCounter >> 28);
-        v1->waveTableCounter = 0;
-    }
-    if (sync2) {
-        v2->lsfr = NSHIFT(v2->lsfr, v2->waveTableCounter >> 28);
-        v2->waveTableCounter = 0;
-    }
+    load();
     
-    // Advance ADSR counters
-    v0->adsr += v0->adsrInc;
-    v1->adsr += v1->adsrInc;
-    v2->adsr += v2->adsrInc;
+#if defined(__SSE2__)
     
-    // Check if we need to perform state changes
-    if (v0->adsr + 0x80000000 < v0->adsrCmp + 0x80000000) {
-        v0->trigger_adsr();
-    }
-    if (v1->adsr + 0x80000000 < v1->adsrCmp + 0x80000000) {
-        v1->trigger_adsr();
-    }
-    if (v2->adsr + 0x80000000 < v2->adsrCmp + 0x80000000) {
-        v2->trigger_adsr();
-    }
+    __m128i vcnt, vstp, venv, vinc, vcmp;
+    const __m128i bias = _mm_set1_epi32((int)0x80000000);
     
-    // Oscillators
-    osc0 = (v0->adsr >> 16) * v0->doosc();
-    osc1 = (v1->adsr >> 16) * v1->doosc();
-    osc2 = (v2->adsr >> 16) * v2->doosc();
+    auto reload = [&]() {
+        vcnt = _mm_load_si128((const __m128i *)cnt);
+        vstp = _mm_load_si128((const __m128i *)stp);
+        venv = _mm_load_si128((const __m128i *)env);
+        vinc = _mm_load_si128((const __m128i *)inc);
+        vcmp = _mm_load_si128((const __m128i *)cmp);
+    };
+    reload();
     
-    // Silence voice 3 if it is disconnected from the output
-    if (voiceThreeDisconnected()) {
-        osc2 = 0;
-    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    
+    uint32x4_t vcnt, vstp, venv, vinc;
+    int32x4_t vcmp;
+    
+    auto reload = [&]() {
+        vcnt = vld1q_u32(cnt);
+        vstp = vld1q_u32(stp);
+        venv = vld1q_u32(env);
+        vinc = vld1q_u32(inc);
+        vcmp = vreinterpretq_s32_u32(vld1q_u32(cmp));
+    };
+    reload();
+    
+#else
+    
+    auto reload = [&]() { };
+    
+#endif
     
-    // Apply filter
-    if (emulateFilter) {
-        v0->filterIO = ampMod1x8[(osc0 >> 22)];
-        if (filterOn(0)) v0->applyFilter();
-        osc0 = ((u32)(v0->filterIO) + 0x80) << (7 + 15);
+    for (usize i = 0; i < n; i++) {
+        
+        /* Advance the wavetable and ADSR counters and check for events. An
+         * event is a counter overflow (the waveform loops) or an ADSR counter
+         * passing the comparison value. Comparing two ADSR values with an
+         * offset of 0x80000000 as unsigned numbers is the same as comparing
+         * them as signed numbers without an offset.
+         */
+        bool event;
+        
+#if defined(__SSE2__)
+        
+        vcnt = _mm_add_epi32(vcnt, vstp);
+        venv = _mm_add_epi32(venv, vinc);
+        __m128i ovf = _mm_cmpgt_epi32(_mm_xor_si128(vstp, bias), _mm_xor_si128(vcnt, bias));
+        __m128i trg = _mm_cmplt_epi32(venv, vcmp);
+        _mm_store_si128((__m128i *)cnt, vcnt);
+        _mm_store_si128((__m128i *)env, venv);
+        event = _mm_movemask_epi8(_mm_or_si128(ovf, trg)) != 0;
+        
+#elif defined(__ARM_NEON) && defined(__aarch64__)
         
-        v1->filterIO = ampMod1x8[(osc1 >> 22)];
-        if (filterOn(1)) v1->applyFilter();
-        osc1 = ((u32)(v1->filterIO) + 0x80) << (7 + 15);
+        vcnt = vaddq_u32(vcnt, vstp);
+        venv = vaddq_u32(venv, vinc);
+        uint32x4_t ovf = vcltq_u32(vcnt, vstp);
+        uint32x4_t trg = vcltq_s32(vreinterpretq_s32_u32(venv), vcmp);
+        vst1q_u32(cnt, vcnt);
+        vst1q_u32(env, venv);
+        event = vmaxvq_u32(vorrq_u32(ovf, trg)) != 0;
+        
+#else
+        
+        event = false;
+        for (usize k = 0; k < 3; k++) {
+            cnt[k] += stp[k];
+            env[k] += inc[k];
+            event |= cnt[k] < stp[k] || (i32)env[k] < (i32)cmp[k];
+        }
+        
+#endif
+        
+        // Handle events on the (rarely taken) scalar path
+        if (unlikely(event)) {
+            
+            save();
+            
+            // Check for counter overflows (waveform loops)
+            bool sync[3] = { false, false, false };
+            for (usize k = 0; k < 3; k++) {
+                if (v[k]->waveTableCounter < v[k]->step) {
+                    v[k]->lsfr = NSHIFT(v[k]->lsfr, 16);
+                    sync[(k + 1) % 3] = v[(k + 1) % 3]->syncBit();
+                }
+            }
+            
+            // Perform hard sync
+            for (usize k = 0; k < 3; k++) {
+                if (sync[k]) {
+                    v[k]->lsfr = NSHIFT(v[k]->lsfr, v[k]->waveTableCounter >> 28);
+                    v[k]->waveTableCounter = 0;
+                }
+            }
+            
+            // Check if we need to perform state changes
+            for (usize k = 0; k < 3; k++) {
+                if (v[k]->adsr + 0x80000000 < v[k]->adsrCmp + 0x80000000) {
+                    v[k]->trigger_adsr();
+                }
+            }
+            
+            load();
+            reload();
+        }
+        
+        // Oscillators
+        u32 osc[3];
+        for (usize k = 0; k < 3; k++) {
+            osc[k] = (env[k] >> 16) * v[k]->doosc(cnt[k], cnt[prev[k]], noise[k]);
+        }
+        
+        // Silence voice 3 if it is disconnected from the output
+        if (mute) osc[2] = 0;
+        
+        // Apply filter
+        if (emulateFilter) {
+            for (usize k = 0; k < 3; k++) {
+                v[k]->filterIO = ampMod1x8[(osc[k] >> 22)];
+                if (filter[k]) v[k]->applyFilter();
+                osc[k] = ((u32)(v[k]->filterIO) + 0x80) << (7 + 15);
+            }
+        }
         
-        v2->filterIO = ampMod1x8[(osc2 >> 22)];
-        if (filterOn(2)) v2->applyFilter();
-        osc2 = ((u32)(v2->filterIO) + 0x80) << (7 + 15);
+        out[i] = (i16)(((i32)((osc[0] + osc[1] + osc[2]) >> 20) - 0x600) * volume * 0.5);
     }
     
-    return (i16)(((i32)((osc0 + osc1 + osc2) >> 20) - 0x600) * sidVolume() * 0.5);
+    save();
 }
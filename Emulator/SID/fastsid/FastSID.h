@@ -32,6 +32,23 @@
 #include "FastVoice.h"
 #include "SIDStreams.h"
 
+/* Filter lookup tables. The tables only depend on the sample rate. They are
+ * computed once per sample rate and shared by all FastSID instances.
+ */
+struct FastSIDFilterTables {
+    
+    float lowPassParam[0x800];
+    float bandPassParam[0x800];
+    float filterResTable[16];
+    
+    // Returns the tables for a certain sample rate
+    static std::shared_ptr<const FastSIDFilterTables> get(u32 sampleRate);
+    
+private:
+    
+    void init(u32 sampleRate);
+};
+
 class FastSID : public C64Component {
         
     // Reference to the SID bridge
@@ -92,10 +109,8 @@ public:
     
 private:
     
-    // Filter lookup table
-    float lowPassParam[0x800];
-    float bandPassParam[0x800];
-    float filterResTable[16];
+    // Filter lookup tables (shared with other instances)
+    std::shared_ptr<const FastSIDFilterTables> filterTables;
     
     // Amplifier lookup table
     signed char ampMod1x8[256];
@@ -180,8 +195,10 @@ private:
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
     
     
     //
@@ -211,8 +228,12 @@ public:
     
 private:
     
-    // Computes a single sound sample
-    i16 calculateSingleSample();
+    /* Computes a block of sound samples. The wavetable and ADSR counters of
+     * the three voices are advanced in parallel in SIMD lanes. Waveform loops,
+     * hard syncs, and ADSR state changes are handled on a scalar path, which
+     * makes the output identical to computing each sample in isolation.
+     */
+    void renderSamples(short *out, usize n);
     
      
     //
@@ -30,6 +30,7 @@
 
 #include "FastSID.h"
 #include "waves.h"
+#include <mutex>
 
 u16 FastVoice::wavetable10[2][4096];
 u16 FastVoice::wavetable20[2][4096];
@@ -60,6 +61,14 @@ FastVoice::_reset()
 
 void
 FastVoice::initWaveTables()
+{
+    // The tables are shared by all instances and computed only once
+    static std::once_flag once;
+    std::call_once(once, computeWaveTables);
+}
+
+void
+FastVoice::computeWaveTables()
 {
     // Most tables are the same for SID6581 and SID8580, so let's initialize both.
     for (unsigned m = 0; m < 2; m++) {
@@ -342,21 +351,7 @@ FastVoice::trigger_adsr()
 u32
 FastVoice::doosc()
 {
-    if (waveform() == FASTSID_NOISE) {
-        return ((u32)NVALUE(NSHIFT(lsfr, waveTableCounter >> 28))) << 7;
-    }
-    
-    if (wavetable) {
-        u32 index = (waveTableCounter + waveTableOffset) >> 20; /* 12 bit value */
-        if (ringmod) {
-            if ((prev->waveTableCounter >> 31) == 1) {
-                return wavetable[index] ^ 0x7FFF;
-            }
-        }
-        return wavetable[index];
-    }
-    
-    return 0;
+    return doosc(waveTableCounter, prev->waveTableCounter, waveform() == FASTSID_NOISE);
 }
 
 void
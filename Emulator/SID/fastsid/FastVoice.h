@@ -173,11 +173,14 @@ public:
     FastVoice() { };
     const char *getDescription() const override { return "FastVoice"; }
 
+    // Initializes the wave and noise tables (only once per process)
     static void initWaveTables();
+    
     void init(FastSID *owner, unsigned voiceNr, FastVoice *prevVoice);
     
 private:
     
+    static void computeWaveTables();
     void _reset() override;
     
     
@@ -225,8 +228,10 @@ private:
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
     usize didLoadFromBuffer(u8 *buffer) override;
     
  
@@ -255,6 +260,18 @@ public:
     // 15-bit oscillator value
     u32 doosc();
     
+    /* Variant of doosc() used by the block renderer of FastSID, which keeps
+     * the wavetable counters of all voices in vector registers.
+     */
+    u32 doosc(u32 counter, u32 prevCounter, bool noise) const {
+        
+        if (noise) return ((u32)NVALUE(NSHIFT(lsfr, counter >> 28))) << 7;
+        if (!wavetable) return 0;
+        
+        u16 value = wavetable[(counter + waveTableOffset) >> 20];
+        return ringmod && (prevCounter >> 31) == 1 ? value ^ 0x7FFF : value;
+    }
+    
     // Apply filter effect
     void applyFilter();
     
@@ -25,6 +25,8 @@
 #endif
 
 #include "sid.h"
+#include <mutex>
+#include <vector>
 #include <math.h>
 
 #ifndef round
@@ -54,6 +56,7 @@ SID::SID()
   // Initialize pointers.
   sample = 0;
   fir = 0;
+  fir_sum = 0;
   fir_N = 0;
   fir_RES = 0;
   fir_beta = 0;
@@ -72,6 +75,11 @@ SID::SID()
   write_pipeline = 0;
 
   databus_ttl = 0;
+  silent_cycles = 0;
+
+  filter_settled = false;
+  filter_out = 0;
+  settled_cycles = 0;
 }
 
 
@@ -81,7 +89,6 @@ SID::SID()
 SID::~SID()
 {
   delete[] sample;
-  delete[] fir;
 }
 
 
@@ -361,6 +368,10 @@ SID::State SID::read_state()
   state.sid_register[j++] = (filter.res << 4) | filter.filt;
   state.sid_register[j++] = filter.mode | filter.vol;
 
+  // Reading the registers below updates the bus value. Keep the old one.
+  reg8 old_bus_value = bus_value;
+  cycle_count old_bus_value_ttl = bus_value_ttl;
+
   // These registers are superfluous, but are included for completeness.
   for (; j < 0x1d; j++) {
     state.sid_register[j] = read(j);
@@ -369,6 +380,9 @@ SID::State SID::read_state()
     state.sid_register[j] = 0;
   }
 
+  bus_value = old_bus_value;
+  bus_value_ttl = old_bus_value_ttl;
+
   state.bus_value = bus_value;
   state.bus_value_ttl = bus_value_ttl;
   state.write_pipeline = write_pipeline;
@@ -500,6 +514,108 @@ double SID::I0(double x)
 }
 
 
+// ----------------------------------------------------------------------------
+// Shared FIR tables.
+// The tables only depend on the sampling parameters. All SID instances using
+// the same parameters share a single copy, which is released when the last
+// instance stops using it.
+// ----------------------------------------------------------------------------
+struct SID::FIRTable
+{
+  int N;
+  int RES;
+  double beta;
+  double f_cycles_per_sample;
+  double filter_scale;
+  short* fir;
+  int* fir_sum;
+
+  FIRTable(int n, int res, double b, double f_cycles_per_sample,
+           double f_samples_per_cycle, double scale);
+  ~FIRTable() { delete[] fir; delete[] fir_sum; }
+
+  static std::shared_ptr<FIRTable> get(int n, int res, double b,
+                                       double f_cycles_per_sample,
+                                       double f_samples_per_cycle,
+                                       double scale);
+};
+
+SID::FIRTable::FIRTable(int n, int res, double b, double f_cycles,
+                        double f_samples_per_cycle, double scale)
+  : N(n), RES(res), beta(b), f_cycles_per_sample(f_cycles), filter_scale(scale)
+{
+  const double pi = 3.1415926535897932385;
+  const double I0beta = I0(beta);
+
+  // The cutoff frequency is midway through the transition band (nyquist)
+  const double wc = pi;
+
+  // Allocate memory for FIR tables.
+  fir = new short[N*RES];
+
+  // Calculate RES FIR tables for linear interpolation.
+  for (int i = 0; i < RES; i++) {
+    int fir_offset = i*N + N/2;
+    double j_offset = double(i)/RES;
+    // Calculate FIR table. This is the sinc function, weighted by the
+    // Kaiser window.
+    for (int j = -N/2; j <= N/2; j++) {
+      double jx = j - j_offset;
+      double wt = wc*jx/f_cycles_per_sample;
+      double temp = jx/(N/2);
+      double Kaiser = fabs(temp) <= 1 ? I0(beta*sqrt(1 - temp*temp))/I0beta : 0;
+      double sincwt = fabs(wt) >= 1e-6 ? sin(wt)/wt : 1;
+      double val = (1 << FIR_SHIFT)*filter_scale*f_samples_per_cycle*wc/pi*sincwt*Kaiser;
+      fir[fir_offset + j] = (short)round(val);
+    }
+  }
+
+  // Sum up each FIR table. Convolving a constant signal with a table
+  // reduces to a single multiplication with its sum.
+  fir_sum = new int[RES];
+  for (int i = 0; i < RES; i++) {
+    fir_sum[i] = 0;
+    for (int j = 0; j < N; j++) {
+      fir_sum[i] += fir[i*N + j];
+    }
+  }
+}
+
+std::shared_ptr<SID::FIRTable> SID::FIRTable::get(int n, int res, double b,
+                                                  double f_cycles_per_sample,
+                                                  double f_samples_per_cycle,
+                                                  double scale)
+{
+  static std::mutex lock;
+  static std::vector< std::weak_ptr<FIRTable> > cache;
+
+  std::lock_guard<std::mutex> guard(lock);
+
+  // Reuse an existing table and forget about tables no longer in use.
+  std::shared_ptr<FIRTable> result;
+  for (size_t i = 0; i < cache.size(); ) {
+    std::shared_ptr<FIRTable> t = cache[i].lock();
+    if (!t) {
+      cache.erase(cache.begin() + i);
+      continue;
+    }
+    if (t->N == n && t->RES == res && t->beta == b &&
+        t->f_cycles_per_sample == f_cycles_per_sample &&
+        t->filter_scale == scale) {
+      result = t;
+    }
+    i++;
+  }
+
+  if (!result) {
+    result = std::make_shared<FIRTable>(n, res, b, f_cycles_per_sample,
+                                        f_samples_per_cycle, scale);
+    cache.push_back(result);
+  }
+  return result;
+}
+
+
 // ----------------------------------------------------------------------------
 // Setting of SID sampling parameters.
 //
@@ -567,9 +683,10 @@ bool SID::set_sampling_parameters(double clock_freq, sampling_method method,
   if (method != SAMPLE_RESAMPLE && method != SAMPLE_RESAMPLE_FASTMEM)
   {
     delete[] sample;
-    delete[] fir;
     sample = 0;
+    fir_table.reset();
     fir = 0;
+    fir_sum = 0;
     return true;
   }
 
@@ -596,7 +713,6 @@ bool SID::set_sampling_parameters(double clock_freq, sampling_method method,
   // function in the MATLAB Signal Processing Toolbox:
   // http://www.mathworks.com/access/helpdesk/help/toolbox/signal/kaiserord.html
   const double beta = 0.1102*(A - 8.7);
-  const double I0beta = I0(beta);
 
   // The filter order will maximally be 124 with the current constraints.
   // N >= (96.33 - 7.95)/(2.285*0.1*pi) -> N >= 123
@@ -632,26 +748,10 @@ bool SID::set_sampling_parameters(double clock_freq, sampling_method method,
   fir_f_cycles_per_sample = f_cycles_per_sample;
   fir_filter_scale = filter_scale;
 
-  // Allocate memory for FIR tables.
-  delete[] fir;
-  fir = new short[fir_N*fir_RES];
-
-  // Calculate fir_RES FIR tables for linear interpolation.
-  for (int i = 0; i < fir_RES; i++) {
-    int fir_offset = i*fir_N + fir_N/2;
-    double j_offset = double(i)/fir_RES;
-    // Calculate FIR table. This is the sinc function, weighted by the
-    // Kaiser window.
-    for (int j = -fir_N/2; j <= fir_N/2; j++) {
-      double jx = j - j_offset;
-      double wt = wc*jx/f_cycles_per_sample;
-      double temp = jx/(fir_N/2);
-      double Kaiser = fabs(temp) <= 1 ? I0(beta*sqrt(1 - temp*temp))/I0beta : 0;
-      double sincwt = fabs(wt) >= 1e-6 ? sin(wt)/wt : 1;
-      double val = (1 << FIR_SHIFT)*filter_scale*f_samples_per_cycle*wc/pi*sincwt*Kaiser;
-      fir[fir_offset + j] = (short)round(val);
-    }
-  }
+  fir_table = FIRTable::get(fir_N, fir_RES, fir_beta, f_cycles_per_sample,
+                            f_samples_per_cycle, fir_filter_scale);
+  fir = fir_table->fir;
+  fir_sum = fir_table->fir_sum;
 
   return true;
 }
@@ -785,17 +885,42 @@ void SID::clock(cycle_count delta_t)
 // ----------------------------------------------------------------------------
 int SID::clock(cycle_count& delta_t, short* buf, int n, int interleave)
 {
+  // Take the fast path if the output is known to stay constant.
+  // SAMPLE_FAST is cheap anyway and clocks the chip in larger steps.
+  if (sampling != SAMPLE_FAST && is_silent()) {
+    return clock_silent(delta_t, buf, n, interleave);
+  }
+
+  // Skip the filter if only the mixer changes, e.g., if digis are played via
+  // the volume register while all voices are silent (VirtualC64).
+  cycle_count start = delta_t;
+  filter_settled = sampling != SAMPLE_FAST && is_settled();
+  if (filter_settled) {
+    filter_out = filter.output();
+  }
+
+  int s;
   switch (sampling) {
   default:
   case SAMPLE_FAST:
-    return clock_fast(delta_t, buf, n, interleave);
+    s = clock_fast(delta_t, buf, n, interleave);
+    break;
   case SAMPLE_INTERPOLATE:
-    return clock_interpolate(delta_t, buf, n, interleave);
+    s = clock_interpolate(delta_t, buf, n, interleave);
+    break;
   case SAMPLE_RESAMPLE:
-    return clock_resample(delta_t, buf, n, interleave);
+    s = clock_resample(delta_t, buf, n, interleave);
+    break;
   case SAMPLE_RESAMPLE_FASTMEM:
-    return clock_resample_fastmem(delta_t, buf, n, interleave);
+    s = clock_resample_fastmem(delta_t, buf, n, interleave);
+    break;
+  }
+
+  if (filter_settled) {
+    settled_cycles += start - delta_t;
+    filter_settled = false;
   }
+  return s;
 }
 
 
@@ -1019,4 +1144,173 @@ int SID::clock_resample_fastmem(cycle_count& delta_t, short* buf, int n, int int
   return s;
 }
 
+
+// ----------------------------------------------------------------------------
+// Silence detection (VirtualC64).
+//
+// The SID output is constant if all envelopes are locked at zero and the
+// filters have settled. Both conditions hold until a register is written,
+// because the voice outputs are zero and the filter state is a fixed point
+// of the filter equations then. The check is carried out in front of each
+// call to clock(delta_t, buf, n), in between two register writes.
+//
+// If only the internal filter has settled, the output still changes, e.g.,
+// when the volume register is written to play digis. Since the volume and
+// the filter mode only affect the mixer, the filter state still remains at
+// its fixed point and the filter output stays constant between two writes.
+// ----------------------------------------------------------------------------
+bool SID::is_settled()
+{
+  // Pending writes may unlock the envelopes.
+  if (write_pipeline) {
+    return false;
+  }
+
+  // All envelopes must be locked at zero.
+  for (int i = 0; i < 3; i++) {
+    EnvelopeGenerator& envelope = voice[i].envelope;
+
+    if (!envelope.hold_zero || envelope.envelope_counter || envelope.state_pipeline) {
+      return false;
+    }
+    if (voice[i].output()) {
+      return false;
+    }
+  }
+
+  // The filter state must not change anymore.
+  Filter f = filter;
+  f.clock(0, 0, 0);
+  if (f.Vhp != filter.Vhp || f.Vbp != filter.Vbp || f.Vlp != filter.Vlp ||
+      f.Vbp_x != filter.Vbp_x || f.Vbp_vc != filter.Vbp_vc ||
+      f.Vlp_x != filter.Vlp_x || f.Vlp_vc != filter.Vlp_vc ||
+      f.v1 != filter.v1 || f.v2 != filter.v2 || f.v3 != filter.v3) {
+    return false;
+  }
+
+  return true;
+}
+
+bool SID::is_silent()
+{
+  if (!is_settled()) {
+    return false;
+  }
+
+  // The external filter must not change anymore.
+  ExternalFilter e = extfilt;
+  e.clock(filter.output());
+  if (e.Vlp != extfilt.Vlp || e.Vhp != extfilt.Vhp) {
+    return false;
+  }
+
+  // The resampling buffers must be filled with the constant output.
+  short c = output();
+
+  switch (sampling) {
+  case SAMPLE_INTERPOLATE:
+    return sample_prev == c && sample_now == c;
+  case SAMPLE_RESAMPLE:
+    for (int j = 1; j <= fir_N + 1; j++) {
+      if (sample[sample_index - j + RINGSIZE] != clip(c)) return false;
+    }
+    return true;
+  case SAMPLE_RESAMPLE_FASTMEM:
+    for (int j = 1; j <= fir_N; j++) {
+      if (sample[sample_index - j + RINGSIZE] != c) return false;
+    }
+    return true;
+  default:
+    return false;
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+// SID clocking with audio sampling - constant output (VirtualC64).
+//
+// Produces the same samples as the cycle based sampling methods. The voices
+// are clocked as usual to keep the oscillators and envelopes in sync,
+// whereas clocking the filters and convolving the sample buffer is skipped.
+// ----------------------------------------------------------------------------
+int SID::clock_silent(cycle_count& delta_t, short* buf, int n, int interleave)
+{
+  const short c = output();
+  const short ring = sampling == SAMPLE_RESAMPLE ? clip(c) : c;
+  const bool resample =
+    sampling == SAMPLE_RESAMPLE || sampling == SAMPLE_RESAMPLE_FASTMEM;
+  int s;
+
+  for (s = 0; s < n; s++) {
+    cycle_count next_sample_offset = sample_offset + cycles_per_sample;
+    cycle_count delta_t_sample = next_sample_offset >> FIXP_SHIFT;
+
+    if (delta_t_sample > delta_t) {
+      delta_t_sample = delta_t;
+    }
+
+    for (int i = 0; i < delta_t_sample; i++) {
+      int j;
+
+      for (j = 0; j < 3; j++) {
+        voice[j].envelope.clock();
+      }
+      for (j = 0; j < 3; j++) {
+        voice[j].wave.clock();
+      }
+      for (j = 0; j < 3; j++) {
+        voice[j].wave.synchronize();
+      }
+      for (j = 0; j < 3; j++) {
+        voice[j].wave.set_waveform_output();
+      }
+
+      if (unlikely(!--bus_value_ttl)) {
+        bus_value = 0;
+      }
+
+      if (resample) {
+        sample[sample_index] = sample[sample_index + RINGSIZE] = ring;
+        ++sample_index &= RINGMASK;
+      }
+    }
+    silent_cycles += delta_t_sample;
+
+    if ((delta_t -= delta_t_sample) == 0) {
+      sample_offset -= delta_t_sample << FIXP_SHIFT;
+      break;
+    }
+
+    sample_offset = next_sample_offset & FIXP_MASK;
+
+    if (sampling == SAMPLE_RESAMPLE) {
+
+      int fir_offset = sample_offset*fir_RES >> FIXP_SHIFT;
+      int fir_offset_rmd = sample_offset*fir_RES & FIXP_MASK;
+
+      int v1 = ring*fir_sum[fir_offset];
+      if (unlikely(++fir_offset == fir_RES)) {
+        fir_offset = 0;
+      }
+      int v2 = ring*fir_sum[fir_offset];
+
+      int v = v1 + int((unsigned(fir_offset_rmd)*unsigned(v2 - v1)) >> FIXP_SHIFT);
+      v >>= FIR_SHIFT;
+      buf[s*interleave] = clip(v);
+    }
+    else if (sampling == SAMPLE_RESAMPLE_FASTMEM) {
+
+      int fir_offset = sample_offset*fir_RES >> FIXP_SHIFT;
+      int v = ring*fir_sum[fir_offset];
+      v >>= FIR_SHIFT;
+      buf[s*interleave] = clip(v);
+    }
+    else {
+      buf[s*interleave] = c;
+    }
+  }
+
+  return s;
+}
+
 } // namespace reSID
@@ -31,6 +31,7 @@
 #endif
 #include "extfilt.h"
 #include "pot.h"
+#include <memory>
 
 namespace reSID
 {
@@ -107,6 +108,9 @@ public:
   int clock_interpolate(cycle_count& delta_t, short* buf, int n, int interleave);
   int clock_resample(cycle_count& delta_t, short* buf, int n, int interleave);
   int clock_resample_fastmem(cycle_count& delta_t, short* buf, int n, int interleave);
+  int clock_silent(cycle_count& delta_t, short* buf, int n, int interleave);
+  bool is_silent();
+  bool is_settled();
   void write();
 
   chip_model sid_model;
@@ -166,6 +170,24 @@ public:
 
   // FIR_RES filter tables (FIR_N*FIR_RES).
   short* fir;
+
+  // Sums of the FIR_RES filter tables.
+  int* fir_sum;
+
+  // Owner of the FIR tables, which are shared by all instances with the
+  // same sampling parameters.
+  struct FIRTable;
+  std::shared_ptr<FIRTable> fir_table;
+
+  // Number of cycles spent on the fast path for constant output.
+  unsigned long long silent_cycles;
+
+  // Indicates that the filter rests and holds the cached output (VirtualC64).
+  bool filter_settled;
+  short filter_out;
+
+  // Number of cycles spent with a resting filter.
+  unsigned long long settled_cycles;
 };
 
 
@@ -215,11 +237,15 @@ void SID::clock()
     voice[i].wave.set_waveform_output();
   }
 
-  // Clock filter.
-  filter.clock(voice[0].output(), voice[1].output(), voice[2].output());
-
-  // Clock external filter.
-  extfilt.clock(filter.output());
+  // Clock filter and external filter. The filter is skipped while it rests
+  // (VirtualC64).
+  if (likely(!filter_settled)) {
+    filter.clock(voice[0].output(), voice[1].output(), voice[2].output());
+    extfilt.clock(filter.output());
+  }
+  else {
+    extfilt.clock(filter_out);
+  }
 
   // Pipelined writes on the MOS8580.
   if (unlikely(write_pipeline)) {
@@ -8,6 +8,8 @@
 // -----------------------------------------------------------------------------
 
 #include "C64.h"
+#include <sched.h>
+#include <unistd.h>
 
 #define SPR0 0x01
 #define SPR1 0x02
@@ -22,10 +24,20 @@ VICII::VICII(C64 &ref) : C64Component(ref)
 {    
     config.grayDotBug = true;
     config.palette = PALETTE_COLOR;
+    config.palBlending = false;
     config.cutLayers = 0xFF;
     config.cutOpacity = 0xFF;
     config.dmaOpacity = 0x80;
     config.dmaDebug = false;
+    config.indexedTexture = false;
+    config.frameSkip = 0;
+    config.renderPipeline = false;
+    
+    // Mark all lines as dirty when the first frame is acquired
+    for (isize i = 0; i < TEX_HEIGHT; i++) {
+        stableHashes[i] = ~0ULL;
+        dirtyLines[i] = true;
+    }
     config.dmaChannel[MEMACCESS_R] = true;
     config.dmaChannel[MEMACCESS_I] = true;
     config.dmaChannel[MEMACCESS_C] = true;
@@ -44,13 +56,12 @@ VICII::VICII(C64 &ref) : C64Component(ref)
     // Assign reference clock to all time delayed variables
     baLine.setClock(&cpu.cycle);
     gAccessResult.setClock(&cpu.cycle);
-    
-    // Create random background noise pattern
-    const usize noiseSize = 2 * 512 * 512;
-    noise = new u32[noiseSize];
-    for (usize i = 0; i < noiseSize; i++) {
-        noise[i] = rand() % 2 ? 0xFF000000 : 0xFFFFFFFF;
-    }
+}
+
+VICII::~VICII()
+{
+    // Release the helper thread if the emulator has stopped inside a frame
+    drainPipeline();
 }
 
 void
@@ -68,6 +79,9 @@ VICII::_reset()
 {
     RESET_SNAPSHOT_ITEMS
     
+    // Wait for the render pipeline to release the working buffer
+    drainPipeline();
+    
     // Reset counters
     yCounter = (u32)getRasterlinesPerFrame();
         
@@ -92,49 +106,89 @@ VICII::_reset()
     upperComparisonVal = upperComparisonValue();
     lowerComparisonVal = lowerComparisonValue();
         
-    // Reset the screen buffer pointers
-    emuTexture = emuTexturePtr = emuTexture1;
-    dmaTexture = dmaTexturePtr = dmaTexture1;
+    // Reset the screen buffers
+    workingBuffer = 0;
+    completedBuffer = 1;
+    latestBuffer = 1;
+    stableBuffer = 2;
+    for (isize i = 0; i < 3; i++) idxTextureValid[i] = false;
+    for (isize i = 0; i < 3; i++) dmaOverlayPending[i] = false;
+    convertedBuffer = -1;
+    emuTexture = emuTexturePtr = emuTextures[workingBuffer];
+    dmaCode = dmaCodePtr = dmaCodes[workingBuffer];
+    idxTexture = idxTexturePtr = idxTextures[workingBuffer];
+    droppedFrames = 0;
+    duplicatedFrames = 0;
+    indexed = false;
+    updateTextureFormat();
+    skippedFrames = 0;
+    updateRenderMode();
+    if (pipelined && rendering) launchPipeline();
+}
+
+usize
+VICII::didLoadFromBuffer(u8 *buffer)
+{
+    // The page lookup table is not part of the snapshot
+    updateBankPages();
+    
+    // The cycle functions depend on the restored chip model
+    c64.updateVicFunctionTable();
+    
+    // Frames emulated again after a rollback are not drawn (see Netplay)
+    if (c64.netplay.isResimulating()) rendering = false;
+    return 0;
 }
 
 void
-VICII::resetEmuTexture(int nr)
+VICII::resetEmuTexture(isize nr)
 {
-    assert(nr == 1 || nr == 2);
-    int *p = nr == 1 ? emuTexture1 : emuTexture2;
+    assert(nr >= 0 && nr < 3);
+    renderer.join();
+    
+    int *p = emuTextures[nr];
+    u8 *q = idxTextures[nr];
+    
+    // The reset buffer has no valid fingerprints
+    for (isize i = 0; i < TEX_HEIGHT; i++) lineHashes[nr][i] = 0;
 
     // Determine the HBLANK / VBLANK area
     long width = isPAL() ? PAL_PIXELS : NTSC_PIXELS;
     long height = getRasterlinesPerFrame();
     
+    /* Draw a checkerboard pattern inside the used texture area and black
+     * pixels outside. The pattern is made of two alternating line types.
+     * They are computed once and copied into the texture line by line.
+     */
+    int emuLines[3][TEX_WIDTH];
+    u8 idxLines[3][TEX_WIDTH];
+    
+    for (int x = 0; x < TEX_WIDTH; x++) {
+        
+        bool inside = x < width;
+        bool odd = (x / 8) % 2;
+        
+        emuLines[0][x] = !inside ? 0xFF000000 : odd ? 0xFF444444 : 0xFF222222;
+        emuLines[1][x] = !inside ? 0xFF000000 : odd ? 0xFF222222 : 0xFF444444;
+        emuLines[2][x] = 0xFF000000;
+        idxLines[0][x] = !inside ? 18 : odd ? 17 : 16;
+        idxLines[1][x] = !inside ? 18 : odd ? 16 : 17;
+        idxLines[2][x] = 18;
+    }
+    
     for (int y = 0; y < TEX_HEIGHT; y++) {
-        for (int x = 0; x < TEX_WIDTH; x++) {
-
-            int pos = y * TEX_WIDTH + x;
-
-            if (y < height && x < width) {
-                
-                // Draw a checkerboard pattern inside the used texture area
-                p[pos] = (y / 4) % 2 == (x / 8) % 2 ? 0xFF222222 : 0xFF444444;
-
-            } else {
-                
-                // Draw black pixels outside the used texture area
-                p[pos] = 0xFF000000;
-            }
-        }
+        
+        isize type = y < height ? (y / 4) % 2 : 2;
+        memcpy(p + y * TEX_WIDTH, emuLines[type], sizeof(emuLines[type]));
+        memcpy(q + y * TEX_WIDTH, idxLines[type], sizeof(idxLines[type]));
     }
 }
 
 void
-VICII::resetDmaTexture(int nr)
+VICII::resetDmaCodes(isize nr)
 {
-    assert(nr == 1 || nr == 2);
-    int *p = nr == 1 ? dmaTexture1 : dmaTexture2;
-
-    for (int i = 0; i < TEX_HEIGHT * TEX_WIDTH; i++) {
-        p[i] = 0xFF000000;
-    }
+    assert(nr >= 0 && nr < 3);
+    if (dmaCodes[nr]) memset(dmaCodes[nr], 0, TEX_HEIGHT * dmaCodesPerLine * sizeof(u16));
 }
 
 long
@@ -144,6 +198,7 @@ VICII::getConfigItem(Option option) const
             
         case OPT_VIC_REVISION:     return config.revision;
         case OPT_PALETTE:          return config.palette;
+        case OPT_PAL_BLENDING:     return config.palBlending;
         case OPT_GRAY_DOT_BUG:     return config.grayDotBug;
         case OPT_GLUE_LOGIC:       return config.glueLogic;
         case OPT_DMA_DEBUG:        return config.dmaDebug;
@@ -166,6 +221,9 @@ VICII::getConfigItem(Option option) const
         case OPT_CUT_OPACITY:      return config.cutOpacity;
         case OPT_SS_COLLISIONS:    return config.checkSSCollisions;
         case OPT_SB_COLLISIONS:    return config.checkSBCollisions;
+        case OPT_INDEXED_TEXTURE:  return config.indexedTexture;
+        case OPT_FRAME_SKIP:       return config.frameSkip;
+        case OPT_RENDER_PIPELINE:  return config.renderPipeline;
 
         default:
             assert(false);
@@ -200,6 +258,11 @@ VICII::setConfigItem(Option option, long value)
             resume();
             return true;
             
+        case OPT_PAL_BLENDING:
+            
+            config.palBlending = value;
+            return true;
+            
         case OPT_GRAY_DOT_BUG:
             
             config.grayDotBug = value;
@@ -217,7 +280,16 @@ VICII::setConfigItem(Option option, long value)
             }
             suspend();
             config.dmaDebug = value;
-            resetDmaTextures();
+            
+            // Allocate the access code buffers on first use
+            if (value && !dmaCodes[0]) {
+                for (isize i = 0; i < 3; i++) {
+                    dmaCodes[i] = new u16[TEX_HEIGHT * dmaCodesPerLine];
+                }
+                dmaCode = dmaCodes[workingBuffer];
+                dmaCodePtr = dmaCode + (c64.rasterLine * dmaCodesPerLine);
+            }
+            resetDmaCodes();
             c64.updateVicFunctionTable();
             resume();
             return true;
@@ -313,6 +385,23 @@ VICII::setConfigItem(Option option, long value)
             config.checkSBCollisions = value;
             return true;
 
+        case OPT_INDEXED_TEXTURE:
+            
+            config.indexedTexture = value;
+            return true;
+
+        case OPT_FRAME_SKIP:
+            
+            if (value < FRAME_SKIP_ON_DEMAND) return false;
+            
+            config.frameSkip = value;
+            return true;
+
+        case OPT_RENDER_PIPELINE:
+            
+            config.renderPipeline = value;
+            return true;
+
         case OPT_GLUE_LOGIC:
             
             if (!GlueLogicEnum::verify(value)) return false;
@@ -337,7 +426,7 @@ VICII::setRevision(VICRevision revision)
     
     updatePalette();
     resetEmuTextures();
-    resetDmaTextures();
+    resetDmaCodes();
     c64.updateVicFunctionTable();
     
     c64.putMessage(isPAL() ? MSG_PAL : MSG_NTSC);
@@ -428,6 +517,91 @@ VICII::_inspect()
             spriteInfo[i].sbCollision = GET_BIT(spriteBackgroundColllision, i);
         }
     }
+    
+    latestInfo.publish(info);
+    for (isize i = 0; i < 8; i++) latestSpriteInfo[i].publish(spriteInfo[i]);
+}
+
+void
+VICII::getScreenText(ScreenText &result)
+{
+    auto toAscii = [](u16 glyph) {
+        
+        bool lowercase = glyph & 0x100;
+        u8 code = glyph & 0x7F;
+        
+        if (code == 0) return '@';
+        if (code < 27) return (char)((lowercase ? 'a' : 'A') + code - 1);
+        if (code < 32) return "[#]^_"[code - 27];
+        if (code < 64) return (char)code;
+        if (lowercase && code >= 65 && code < 91) return (char)('A' + code - 65);
+        if (code == 96) return ' ';
+        return '.';
+    };
+    
+    u8 ctrl1 = reg.current.ctrl1;
+    u8 ctrl2 = reg.current.ctrl2;
+    u16 vm = VM13VM12VM11VM10() << 6;
+    u16 cb = (CB13CB12CB11() << 10) % 0x4000;
+    
+    result.displayMode = (DisplayMode)((ctrl1 & 0x60) | (ctrl2 & 0x10));
+    result.screenMemoryAddr = bankAddr | vm;
+    result.charMemoryAddr = bankAddr | cb;
+    
+    for (isize i = 0; i < 1000; i++) {
+        
+        result.codes[i] = memSpyAccess((u16)(vm + i));
+        result.colors[i] = mem.colorRam[i] & 0x0F;
+    }
+    
+    // Bitmap modes don't display any text
+    if (ctrl1 & 0x20) { result.text[0] = 0; return; }
+    
+    // Rebuild the glyph table if the Character Rom has changed
+    const u8 *charRom = mem.rom + 0xD000;
+    if (romGlyphSource.size() != 0x1000 || memcmp(romGlyphSource.data(), charRom, 0x1000)) {
+        
+        romGlyphSource.assign(charRom, charRom + 0x1000);
+        romGlyphs.clear();
+        for (u16 i = 0; i < 512; i++) {
+            
+            u64 glyph = 0;
+            for (isize j = 0; j < 8; j++) glyph = glyph << 8 | charRom[8 * i + j];
+            romGlyphs.push_back(std::make_pair(glyph, i));
+        }
+        std::sort(romGlyphs.begin(), romGlyphs.end());
+    }
+    
+    // Identify all glyphs the characters are drawn with
+    bool fromRom = isCharRomAddr(cb);
+    isize count = (ctrl1 & 0x40) ? 64 : 256;
+    u16 glyphs[256];
+    
+    for (isize c = 0; c < count; c++) {
+        
+        // Use the Rom layout if a glyph can't be found
+        glyphs[c] = (u16)(((bankAddr | cb) & 0x0800 ? 0x100 : 0) | c);
+        if (fromRom) continue;
+        
+        u64 glyph = 0;
+        for (isize j = 0; j < 8; j++) {
+            glyph = glyph << 8 | memSpyAccess((u16)(cb + 8 * c + j));
+        }
+        auto it = std::lower_bound(romGlyphs.begin(), romGlyphs.end(),
+                                   std::make_pair(glyph, (u16)0));
+        if (it != romGlyphs.end() && it->first == glyph) glyphs[c] = it->second;
+    }
+    
+    // Translate the screen codes
+    char *p = result.text;
+    for (isize row = 0; row < 25; row++) {
+        
+        for (isize col = 0; col < 40; col++) {
+            *p++ = toAscii(glyphs[result.codes[40 * row + col] & (count - 1)]);
+        }
+        *p++ = '\n';
+    }
+    *p = 0;
 }
 
 void
@@ -441,6 +615,18 @@ VICII::_dumpConfig() const
     msg("    Glue logic : %lld (%s)\n", config.glueLogic, GlueLogicEnum::key(config.glueLogic));
 }
 
+void
+VICII::_memoryUsage(MemoryUsage &usage)
+{
+    usage.heapBytes += frameBuffers.getCapacity();
+    usage.heapBytes += preview.capacity() * sizeof(u32);
+    usage.heapBytes += romGlyphs.capacity() * sizeof(romGlyphs[0]);
+    usage.heapBytes += romGlyphSource.capacity();
+    
+    // The access code buffers are allocated when DMA debugging is enabled
+    if (dmaCodes[0]) usage.heapBytes += 3 * TEX_HEIGHT * dmaCodesPerLine * sizeof(u16);
+}
+
 void 
 VICII::_dump() const
 {
@@ -481,9 +667,7 @@ VICII::_dump() const
 SpriteInfo
 VICII::getSpriteInfo(int nr)
 {
-    SpriteInfo result;
-    synchronized { result = spriteInfo[nr]; }
-    return result;
+    return latestSpriteInfo[nr].read();
 }
 
 void
@@ -610,21 +794,507 @@ VICII::isVBlankLine(unsigned rasterline) const
     }
 }
 
+bool
+VICII::acquireTexture()
+{
+    // Check if a new frame is available
+    if (!(latestBuffer & newFrame)) {
+        
+        duplicatedFrames++;
+        updateDirtyLines(false);
+        return false;
+    }
+    
+    // Hand over the stable buffer in exchange for the latest frame
+    stableBuffer = latestBuffer.exchange(stableBuffer) & ~newFrame;
+    convertedBuffer = -1;
+    updateDirtyLines(true);
+    
+    // Superimpose the DMA debugger output
+    if (dmaOverlayPending[stableBuffer]) {
+        
+        computeOverlay(stableBuffer);
+        dmaOverlayPending[stableBuffer] = false;
+    }
+    return true;
+}
+
+void
+VICII::setTextureBuffers(int *emu[3], u8 *idx[3])
+{
+    suspend();
+    renderer.join();
+    
+    isize emuOffset = emuTexturePtr - emuTexture;
+    isize idxOffset = idxTexturePtr - idxTexture;
+    
+    for (isize i = 0; i < 3; i++) {
+        
+        int *newEmu = emu && emu[i] ? emu[i] : ownEmuTextures[i];
+        u8 *newIdx = idx && idx[i] ? idx[i] : ownIdxTextures[i];
+        
+        if (newEmu != emuTextures[i]) {
+            memcpy(newEmu, emuTextures[i], texSize * sizeof(int));
+            emuTextures[i] = newEmu;
+        }
+        if (newIdx != idxTextures[i]) {
+            memcpy(newIdx, idxTextures[i], texSize);
+            idxTextures[i] = newIdx;
+        }
+    }
+    
+    emuTexture = emuTextures[workingBuffer];
+    idxTexture = idxTextures[workingBuffer];
+    emuTexturePtr = emuTexture + emuOffset;
+    idxTexturePtr = idxTexture + idxOffset;
+    
+    resume();
+}
+
 void *
-VICII::stableEmuTexture() const
+VICII::stableEmuTexture()
 {
-    return emuTexture == emuTexture1 ? emuTexture2 : emuTexture1;
+    SIGNPOST(TEXTURE);
+    
+    // Translate color indices into RGBA values
+    if (idxTextureValid[stableBuffer]) convertStableTexture();
+    
+    return emuTextures[stableBuffer];
+}
+
+const u8 *
+VICII::stableIdxTexture()
+{
+    return idxTextureValid[stableBuffer] ? idxTextures[stableBuffer] : nullptr;
+}
+
+const void *
+VICII::stableTexture(bool &indexed)
+{
+    indexed = idxTextureValid[stableBuffer];
+    
+    // PAL blending is done here, because it depends on the line above
+    if (indexed && config.palBlending) {
+        
+        indexed = false;
+        convertStableTexture();
+    }
+    
+    if (indexed) return idxTextures[stableBuffer];
+    return emuTextures[stableBuffer];
 }
 
 void *
-VICII::stableDmaTexture() const
+VICII::latestEmuTexture()
+{
+    // Translate color indices into a separate buffer owned by the emulator
+    if (idxTextureValid[completedBuffer]) {
+        
+        convertIndexedTexture(idxTextures[completedBuffer], (u32 *)latestTexture);
+        return latestTexture;
+    }
+    
+    return emuTextures[completedBuffer];
+}
+
+void
+VICII::swapTextures()
+{
+    SIGNPOST(TEXTURE);
+    
+    idxTextureValid[workingBuffer] = indexed && !converting;
+    completedBuffer = workingBuffer;
+    
+    if (config.dmaDebug) {
+        
+        // The DMA overlay is superimposed after the lines have been hashed
+        for (isize i = 0; i < TEX_HEIGHT; i++) lineHashes[completedBuffer][i] = c64.frame;
+        dmaOverlayPending[completedBuffer] = true;
+    }
+    
+    // Publish the completed frame and take over the previous one
+    isize previous = latestBuffer.exchange(workingBuffer | newFrame);
+    if (previous & newFrame) droppedFrames++;
+    workingBuffer = previous & ~newFrame;
+    
+    emuTexture = emuTexturePtr = emuTextures[workingBuffer];
+    dmaCode = dmaCodePtr = dmaCodes[workingBuffer];
+    idxTexture = idxTexturePtr = idxTextures[workingBuffer];
+    
+    if (config.dmaDebug) {
+        
+        resetEmuTexture(workingBuffer);
+        resetDmaCodes(workingBuffer);
+    }
+    dmaOverlayPending[workingBuffer] = false;
+}
+
+void
+VICII::takePreview()
+{
+    isize height = numVisibleRasterlines();
+    u32 lut[256];
+    if (indexed) getPalette(lut);
+    
+    AutoMutex lock(previewMutex);
+    
+    preview.resize(VISIBLE_PIXELS * height);
+    previewHeight = height;
+    
+    for (isize y = 0; y < height; y++) {
+        
+        isize offset = (FIRST_VISIBLE_LINE + y) * TEX_WIDTH + FIRST_VISIBLE_PIXEL;
+        u32 *dst = preview.data() + y * VISIBLE_PIXELS;
+        
+        if (indexed) {
+            
+            const u8 *src = idxTexture + offset;
+            for (isize x = 0; x < VISIBLE_PIXELS; x++) dst[x] = lut[src[x]];
+            
+        } else {
+            
+            memcpy(dst, emuTexture + offset, VISIBLE_PIXELS * sizeof(u32));
+        }
+    }
+    
+    previewRequested.store(false, std::memory_order_relaxed);
+}
+
+bool
+VICII::getPreview(u32 *dst, isize width, isize height)
+{
+    isize h;
+    { AutoMutex lock(previewMutex); h = previewHeight; }
+    
+    return getPreview(dst, width, height, 0, 0, VISIBLE_PIXELS, h ? h : 1);
+}
+
+bool
+VICII::getPreview(u32 *dst, isize width, isize height,
+                  isize x, isize y, isize w, isize h)
+{
+    assert(dst);
+    
+    // Ask for the next frame
+    previewRequested.store(true, std::memory_order_relaxed);
+    
+    AutoMutex lock(previewMutex);
+    
+    if (previewHeight == 0) return false;
+    if (width <= 0 || height <= 0 || w <= 0 || h <= 0) return false;
+    if (x < 0 || y < 0 || x + w > VISIBLE_PIXELS || y + h > previewHeight) return false;
+    
+    // Per-column channel sums of the source lines covered by a target line
+    std::vector<u32> sums(w * 4);
+    
+    for (isize j = 0; j < height; j++) {
+        
+        isize y0 = y + j * h / height;
+        isize y1 = MAX(y0 + 1, y + (j + 1) * h / height);
+        
+        std::fill(sums.begin(), sums.end(), 0);
+        for (isize yy = y0; yy < y1; yy++) {
+            
+            const u8 *src = (const u8 *)(preview.data() + yy * VISIBLE_PIXELS + x);
+            for (isize k = 0; k < 4 * w; k++) sums[k] += src[k];
+        }
+        
+        for (isize i = 0; i < width; i++) {
+            
+            isize x0 = i * w / width;
+            isize x1 = MAX(x0 + 1, (i + 1) * w / width);
+            u32 count = (u32)((x1 - x0) * (y1 - y0));
+            u32 acc[4] = { };
+            
+            for (isize xx = x0; xx < x1; xx++) {
+                for (isize c = 0; c < 4; c++) acc[c] += sums[4 * xx + c];
+            }
+            
+            u8 *pixel = (u8 *)(dst + j * width + i);
+            for (isize c = 0; c < 4; c++) pixel[c] = (u8)(acc[c] / count);
+        }
+    }
+    
+    return true;
+}
+
+void
+VICII::hashTextureLine()
+{
+    isize line = (emuTexturePtr - emuTexture) / TEX_WIDTH;
+    assert(line >= 0 && line < TEX_HEIGHT);
+    
+    lineHashes[workingBuffer][line] = computeLineHash(workingBuffer, line, indexed);
+}
+
+u64
+VICII::computeLineHash(isize nr, isize line, bool indexed) const
+{
+    u64 hash = fnv_1a_init64();
+    
+    // Hash the line in units of 64 bits
+    if (indexed) {
+        
+        const u64 *p = (const u64 *)(idxTextures[nr] + line * TEX_WIDTH);
+        hash = fnv_1a_it64(hash, 1);
+        for (isize i = 0; i < TEX_WIDTH / 8; i++) hash = fnv_1a_it64(hash, p[i]);
+        
+    } else {
+        
+        const u64 *p = (const u64 *)(emuTextures[nr] + line * TEX_WIDTH);
+        for (isize i = 0; i < TEX_WIDTH / 2; i++) hash = fnv_1a_it64(hash, p[i]);
+    }
+    
+    return hash;
+}
+
+void
+VICII::launchPipeline()
+{
+    assert(!pipelineActive);
+    
+    completedLines = 0;
+    lastLine = 0;
+    pipelineActive = true;
+    
+    isize nr = workingBuffer;
+    renderer.run([this, nr]() { renderLines(nr); });
+}
+
+void
+VICII::drainPipeline()
+{
+    if (!pipelineActive) return;
+    
+    completedLines.store((lastLine + 1) | drained, std::memory_order_release);
+    renderer.join();
+    pipelineActive = false;
+}
+
+void
+VICII::renderLines(isize nr)
+{
+    SIGNPOST(TEXTURE);
+    
+    isize line = 0, idle = 0;
+    
+    while (true) {
+        
+        isize completed = completedLines.load(std::memory_order_acquire);
+        isize end = completed & ~drained;
+        
+        for (; line < end; line++) {
+            
+            if (converting) {
+                
+                convertIndexedLine(idxTextures[nr], (u32 *)emuTextures[nr], line, rendererLut);
+            }
+            lineHashes[nr][line] = computeLineHash(nr, line, !converting);
+            idle = 0;
+        }
+        if (completed & drained) break;
+        
+        // The core needs a couple of microseconds per line. Back off if it
+        // has stopped in the middle of a frame.
+        if (++idle < 4096) sched_yield(); else usleep(100);
+    }
+}
+
+void
+VICII::updateDirtyLines(bool acquired)
+{
+    const u64 *hashes = lineHashes[stableBuffer];
+    bool all = false;
+    
+    // In indexed mode, a palette change affects all lines
+    if (acquired && idxTextureValid[stableBuffer]) {
+        
+        all = memcmp(stableColors, rgbaTable, sizeof(stableColors)) != 0;
+        all |= stableBlending != config.palBlending;
+        memcpy(stableColors, rgbaTable, sizeof(stableColors));
+        stableBlending = config.palBlending;
+    }
+    
+    // With PAL blending, a line also changes if the line above has changed
+    bool blending = idxTextureValid[stableBuffer] && config.palBlending;
+    bool above = false;
+    
+    numDirtyLines = 0;
+    for (isize i = 0; i < TEX_HEIGHT; i++) {
+        
+        bool changed = hashes[i] != stableHashes[i];
+        dirtyLines[i] = acquired && (all || changed || (blending && above));
+        stableHashes[i] = hashes[i];
+        numDirtyLines += dirtyLines[i];
+        above = changed;
+    }
+}
+
+void
+VICII::convertStableTexture()
 {
-    return dmaTexture == dmaTexture1 ? dmaTexture2 : dmaTexture1;
+    if (convertedBuffer == stableBuffer &&
+        convertedBlending == config.palBlending &&
+        memcmp(convertedColors, rgbaTable, sizeof(convertedColors)) == 0) return;
+    
+    convertIndexedTexture(idxTextures[stableBuffer], (u32 *)emuTextures[stableBuffer]);
+    
+    convertedBuffer = stableBuffer;
+    convertedBlending = config.palBlending;
+    memcpy(convertedColors, rgbaTable, sizeof(convertedColors));
+}
+
+void
+VICII::getPalette(u32 *lut) const
+{
+    /* Besides the 16 C64 colors, the lookup table contains the colors of the
+     * checkerboard pattern (16, 17) and the area outside the used texture
+     * area (18) which is drawn by resetEmuTexture().
+     */
+    for (unsigned i = 0; i < 256; i++) lut[i] = 0xFF000000;
+    for (unsigned i = 0; i < 16; i++) lut[i] = rgbaTable[i];
+    lut[16] = 0xFF222222;
+    lut[17] = 0xFF444444;
+}
+
+void
+VICII::convertIndexedTexture(const u8 *src, u32 *dst) const
+{
+    u32 lut[256];
+    getPalette(lut);
+    
+    for (isize line = 0; line < TEX_HEIGHT; line++) {
+        convertIndexedLine(src, dst, line, lut);
+    }
+}
+
+void
+VICII::convertIndexedLine(const u8 *src, u32 *dst, isize line, const u32 *lut) const
+{
+    const u8 *p = src + line * TEX_WIDTH;
+    u32 *q = dst + line * TEX_WIDTH;
+    
+    if (!config.palBlending || line == 0) {
+        
+        for (isize i = 0; i < TEX_WIDTH; i++) q[i] = lut[p[i]];
+        return;
+    }
+    
+    // Only the 16 C64 colors are blended (not the checkerboard pattern)
+    const u8 *above = p - TEX_WIDTH;
+    for (isize i = 0; i < TEX_WIDTH; i++) {
+        q[i] = (p[i] | above[i]) < 16 ? mixTable[p[i]][above[i]] : lut[p[i]];
+    }
+}
+
+void
+VICII::updateTextureFormat()
+{
+    // Debugging features post-process RGBA values
+    bool debugging = config.dmaDebug || (config.cutLayers & 0xF00);
+    
+    // PAL blending is applied when color indices are translated
+    indexed = (config.indexedTexture || config.palBlending) && !debugging;
+    
+    // The streamer transmits color indices
+    if (c64.streamer.isEnabled() && !debugging) indexed = true;
+    
+    // The render pipeline is utilized in warp mode, only
+    pipelined = config.renderPipeline && c64.inWarpMode() && !debugging;
+    converting = pipelined && !indexed;
+    
+    // In pipelined mode, the core always draws color indices
+    if (pipelined) {
+        
+        indexed = true;
+        getPalette(rendererLut);
+    }
+}
+
+void
+VICII::updateRenderMode()
+{
+    if (!c64.netplay.displaysNextFrame(c64.frame)) {
+        
+        // Frames emulated again after a rollback are never displayed
+        rendering = false;
+        
+    } else if (c64.recorder.isRecording()) {
+        
+        // The video recorder needs every frame
+        rendering = true;
+        
+    } else if (c64.frameWriter.selects(c64.frame)) {
+        
+        // The next frame is going to be dumped
+        rendering = true;
+        
+    } else if (previewRequested.load(std::memory_order_relaxed)) {
+        
+        // A preview has been requested (possibly by an external thread)
+        rendering = true;
+        
+    } else if (c64.streamer.isEnabled()) {
+        
+        // The streamer needs every frame
+        rendering = true;
+        
+    } else if (c64.isHeadless()) {
+        
+        // In headless mode, nobody is going to pick up the texture
+        rendering = false;
+        
+    } else if (c64.oscillator.isSavingPower()) {
+        
+        // Hidden windows are not drawn, idle guests at five frames per second
+        rendering = !c64.oscillator.isHidden() && skippedFrames >= 9;
+        
+    } else if (c64.runAhead.isActive(c64)) {
+        
+        // Only the last frame emulated ahead of time is displayed
+        rendering = c64.runAhead.displaysNextFrame(c64.frame);
+        
+    } else if (frameRequested.exchange(false) || config.dmaDebug) {
+        
+        // The DMA debugger superimposes the emulator texture
+        rendering = true;
+        
+    } else if (c64.datasette.inTurboMode() || c64.iec.inTurboMode()) {
+        
+        // While loading in turbo mode, one frame per second is drawn
+        rendering = skippedFrames >= 49;
+        
+    } else if (config.frameSkip == FRAME_SKIP_ON_DEMAND) {
+
+        rendering = false;
+
+    } else {
+        
+        rendering = skippedFrames >= config.frameSkip;
+    }
+    
+    skippedFrames = rendering ? 0 : skippedFrames + 1;
+}
+
+const u16 *
+VICII::stableDmaCodes() const
+{
+    return dmaCodes[stableBuffer];
 }
 
 u32 *
 VICII::getNoise() const
 {
+    // Create the noise pattern on first use (shared by all instances)
+    static u32 *noise = [] {
+        const usize noiseSize = 2 * 512 * 512;
+        u32 *result = new u32[noiseSize];
+        for (usize i = 0; i < noiseSize; i++) {
+            result[i] = rand() % 2 ? 0xFF000000 : 0xFFFFFFFF;
+        }
+        return result;
+    }();
+    
     int offset = rand() % (512 * 512);
     return noise + offset;
 }
@@ -985,27 +1655,77 @@ VICII::beginFrame()
 void
 VICII::endFrame()
 {
-    // Run the DMA debugger (if enabled)
-    if (config.dmaDebug) {
-        computeOverlay();
-    }
-
-    // Switch texture buffers
-    if (emuTexture == emuTexture1) {
+    if (rendering) drawnFrames++; else totalSkippedFrames++;
+    
+    // Wait until all lines have been post-processed
+    drainPipeline();
+    
+    if (rendering) {
         
-        assert(dmaTexture == dmaTexture1);
-        emuTexture = emuTexturePtr = emuTexture2;
-        dmaTexture = dmaTexturePtr = dmaTexture2;
-        if (config.dmaDebug) { resetEmuTexture(2); resetDmaTexture(2); }
-
-    } else {
+        // Pass the frame to the video recorder (before the GUI can touch it)
+        if (c64.recorder.isRecording()) {
+            
+            u32 lut[256];
+            if (indexed && config.palBlending) {
+                
+                // Blend the frame before it is recorded
+                convertIndexedTexture(idxTexture, (u32 *)latestTexture);
+                c64.recorder.addFrame(latestTexture, nullptr);
+                
+            } else {
+                
+                if (indexed) getPalette(lut);
+                c64.recorder.addFrame(indexed ? (void *)idxTexture : (void *)emuTexture,
+                                      indexed ? lut : nullptr);
+            }
+        }
+        
+        // Pass the frame to the frame writer if it has been selected
+        if (c64.frameWriter.selects(c64.frame - 1)) {
+            
+            u32 lut[256];
+            if (indexed && config.palBlending) {
+                
+                convertIndexedTexture(idxTexture, (u32 *)latestTexture);
+                c64.frameWriter.addFrame(c64.frame - 1, latestTexture, nullptr,
+                                         numVisibleRasterlines());
+                
+            } else {
+                
+                if (indexed) getPalette(lut);
+                c64.frameWriter.addFrame(c64.frame - 1,
+                                         indexed ? (void *)idxTexture : (void *)emuTexture,
+                                         indexed ? lut : nullptr,
+                                         numVisibleRasterlines());
+            }
+        }
         
-        assert(emuTexture == emuTexture2);
-        assert(dmaTexture == dmaTexture2);
-        emuTexture = emuTexturePtr = emuTexture1;
-        dmaTexture = dmaTexturePtr = dmaTexture1;
-        if (config.dmaDebug) { resetEmuTexture(1); resetDmaTexture(1); }
+        // Pass the frame to the streamer (frames emulated ahead are not sent)
+        if (c64.streamer.isEnabled() && !c64.runAhead.isRunningAhead()) {
+            
+            if (indexed) {
+                
+                u32 lut[256];
+                getPalette(lut);
+                c64.streamer.addFrame(c64.frame - 1, idxTexture, lut,
+                                      numVisibleRasterlines());
+            } else {
+                
+                c64.streamer.skipFrame();
+            }
+        }
+        
+        // Hand over a copy to the preview buffer if requested
+        if (previewRequested.load(std::memory_order_relaxed)) takePreview();
+        
+        // Hand over the texture (only frames that have been drawn)
+        if (!c64.isHeadless()) swapTextures();
     }
+    
+    // Decide about the next frame
+    updateTextureFormat();
+    updateRenderMode();
+    if (pipelined && rendering) launchPipeline();
 }
 
 void
@@ -1079,13 +1799,38 @@ VICII::endRasterline()
         setVerticalFrameFF(true);
     }
     
-    // Cut out layers if requested
-    if (config.cutLayers) cutLayers();
+    // Cut out layers if requested (the lower bits only select sprites)
+    if ((config.cutLayers & 0xF00) && rendering && !vblank) cutLayers();
 
-    // Prepare buffers ready for the next line
-    for (unsigned i = 0; i < TEX_WIDTH; i++) { zBuffer[i] = pixelSource[i] = 0; }
+    // Fingerprint the completed line or hand it over to the render pipeline
+    if (rendering) {
+        
+        if (vblank && !pipelineActive) {
+            
+            // Lines in the VBLANK area are never drawn
+            lineHashes[workingBuffer][(emuTexturePtr - emuTexture) / TEX_WIDTH] = 0;
+            
+        } else if (pipelineActive) {
+            
+            /* The next rasterline might write into the same texture line.
+             * Hence, only the lines above are handed over.
+             */
+            lastLine = (emuTexturePtr - emuTexture) / TEX_WIDTH;
+            completedLines.store(lastLine, std::memory_order_release);
+            
+        } else {
+            
+            hashTextureLine();
+        }
+    }
+    
+    // Prepare buffers ready for the next line (the VBLANK area leaves the
+    // z buffer untouched)
+    if (!vblank) memset(zBuffer, 0, sizeof(zBuffer));
+    memset(pixelSource, 0, sizeof(pixelSource));
         
     // Advance texture pointers
     emuTexturePtr = emuTexture + (c64.rasterLine * TEX_WIDTH);
-    dmaTexturePtr = dmaTexture + (c64.rasterLine * TEX_WIDTH);
+    if (dmaCode) dmaCodePtr = dmaCode + (c64.rasterLine * dmaCodesPerLine);
+    idxTexturePtr = idxTexture + (c64.rasterLine * TEX_WIDTH);
 }
@@ -11,6 +11,10 @@
 
 #include "C64Component.h"
 #include "TimeDelayed.h"
+#include "Arena.h"
+#include "Concurrency.h"
+#include <atomic>
+#include <vector>
 
 class VICII : public C64Component {
 
@@ -19,9 +23,11 @@ class VICII : public C64Component {
     // Current configuration
     VICConfig config;
     
-    // Result of the latest inspection
+    // Result of the latest inspection (the published copy is read by the GUI)
     VICIIInfo info;
     SpriteInfo spriteInfo[8];
+    InfoRecord<VICIIInfo> latestInfo;
+    InfoRecord<SpriteInfo> latestSpriteInfo[8];
     
 
     //
@@ -384,6 +390,13 @@ private:
      * access to ROMH and some portions of RAM.
      */
     MemoryType memSrc[16];
+
+    /* Page lookup table for the selected bank. The i-th entry points to the
+     * memory VICII sees in the i-th 4 KB page of its 16 KB window. Pages
+     * mapped to the expansion port are marked by a nullptr. The table is
+     * rebuilt whenever the bank or the Ultimax flag changes.
+     */
+    const u8 *bankPages[4];
     
     /* Indicates whether VICII is running in ultimax mode. Ultimax mode can be
      * enabled by external cartridges by pulling the game line low and keeping
@@ -476,42 +489,203 @@ private:
     // C64 colors in RGBA format (updated in updatePalette())
     u32 rgbaTable[16];
     
-    // Buffer storing background noise (random black and white pixels)
-    u32 *noise;
+    /* Colors as seen through the PAL delay line (updated in updatePalette()).
+     * mixTable[c][p] is the RGBA value of color c if the pixel above has
+     * color p. In NTSC mode, the table maps each pair to color c.
+     */
+    u32 mixTable[16][16];
+    
+    // Number of pixels in a texture
+    static const usize texSize = TEX_HEIGHT * TEX_WIDTH;
+    
+    /* All frame buffers are taken from a single memory block. The block is
+     * recycled when the instance is destroyed.
+     */
+    Arena frameBuffers { 4 * Arena::sizeOf<int>(texSize) + 3 * Arena::sizeOf<u8>(texSize) };
 
     /* Texture buffers. VICII outputs the generated texture into these buffers.
-     * At any time, one buffer is the working buffer and the other one is the
-     * stable buffer. While VICII always writes into the working buffer, the
-     * GUI accesses the stable buffer at a constant frame rate and copies it
-     * into the texture RAM of the graphics card.
+     * The buffers are organized as a triple buffer. At any time, one buffer
+     * is the working buffer, one buffer holds the latest completed frame, and
+     * one buffer is the stable buffer which is owned by the GUI. VICII always
+     * writes into the working buffer. After a frame has been completed, the
+     * working buffer is swapped with the latest frame buffer. When the GUI
+     * requests a texture, it swaps the stable buffer with the latest frame
+     * buffer if a new frame is available. Both swaps are single atomic
+     * operations. Hence, neither thread ever waits for the other one and the
+     * GUI never reads a buffer that is being written to.
      *
      * The emuTexture buffers contain the emulator texture. It is the texture
-     * that is usually drawn by the GUI. The dmaTexture buffers contain the
-     * texture generated by the DMA debugger. If DMA debugging is enabled, this
-     * texture is superimposed on the emulator texture.
+     * that is usually drawn by the GUI. The buffers either point into the
+     * frame buffer block or to buffers provided by the GUI (see
+     * setTextureBuffers()).
+     */
+    int *ownEmuTextures[3] = {
+        frameBuffers.alloc<int>(texSize),
+        frameBuffers.alloc<int>(texSize),
+        frameBuffers.alloc<int>(texSize) };
+    int *emuTextures[3] = { ownEmuTextures[0], ownEmuTextures[1], ownEmuTextures[2] };
+    
+    /* DMA access codes. If DMA debugging is enabled, VICII records a code for
+     * each memory access instead of drawing it. A code covers four pixels and
+     * combines the access type plus one (upper byte) with the fetched value
+     * (lower byte). Zero means that no access has taken place. The buffers
+     * are allocated when DMA debugging is switched on for the first time.
+     * The overlay is superimposed when the GUI picks up the texture.
+     */
+    static const isize dmaCodesPerLine = TEX_WIDTH / 4;
+    u16 *dmaCodes[3] = { };
+    
+    // Indicates which buffers still need to be superimposed with the overlay
+    bool dmaOverlayPending[3] = { };
+    
+    /* Color index buffers. If indexed textures are enabled, VICII writes a
+     * color index instead of an RGBA value for each pixel which cuts the
+     * memory traffic by a factor of four. The indices are translated when
+     * the GUI requests the stable texture. Hence, palette changes apply to
+     * already rendered frames, too.
+     */
+    u8 *ownIdxTextures[3] = {
+        frameBuffers.alloc<u8>(texSize),
+        frameBuffers.alloc<u8>(texSize),
+        frameBuffers.alloc<u8>(texSize) };
+    u8 *idxTextures[3] = { ownIdxTextures[0], ownIdxTextures[1], ownIdxTextures[2] };
+    
+    // Indicates which buffers contain color indices
+    bool idxTextureValid[3] = { };
+    
+    /* The stable buffer whose color indices have been translated into RGBA
+     * values, together with the palette that was used. The translation is
+     * only repeated if a new frame has been acquired or the palette changed.
+     */
+    isize convertedBuffer = -1;
+    u32 convertedColors[16] = { };
+    bool convertedBlending = false;
+    
+    // Buffer used to translate the latest frame (see latestEmuTexture)
+    int *latestTexture = frameBuffers.alloc<int>(texSize);
+
+    // Indicates if the working texture contains color indices
+    bool indexed = false;
+    
+    /* Render pipeline. In warp mode, VICII can hand over the post-processing
+     * of completed lines to a helper thread. In this mode, the core always
+     * draws color indices. The helper follows the core line by line, i.e.,
+     * it translates the color indices into RGBA values (if the GUI expects
+     * an RGBA texture) and computes the line fingerprints while the core
+     * emulates the next line. At the end of the frame, the pipeline is
+     * drained before the working buffer is handed over.
+     */
+    WorkerThread renderer;
+
+    // Indicates if the current frame is post-processed by the helper thread
+    bool pipelined = false;
+    
+    // Indicates if the helper translates the color indices into RGBA values
+    bool converting = false;
+    
+    // Indicates if the helper is processing the working buffer
+    bool pipelineActive = false;
+    
+    /* Number of texture lines the core won't touch again in this frame. The
+     * drained bit is set when the frame is complete.
+     */
+    static const isize drained = 0x10000;
+    std::atomic<isize> completedLines {0};
+    
+    // Texture line written to in the most recent rasterline
+    isize lastLine = 0;
+    
+    // Color lookup table used by the helper (fixed throughout a frame)
+    u32 rendererLut[256];
+    
+    /* Buffer indices. The working buffer is owned by the emulator thread and
+     * the stable buffer by the GUI. The third index is exchanged between both
+     * threads. It is combined with the newFrame bit which is set if the buffer
+     * has been completed after the GUI has picked up the previous frame.
+     */
+    static const isize newFrame = 0x4;
+    isize workingBuffer;
+    isize stableBuffer;
+    std::atomic<isize> latestBuffer;
+    
+    // Index of the most recently completed buffer (owned by the emulator)
+    isize completedBuffer;
+    
+    /* Fingerprints of all texture lines. While a frame is drawn, VICII
+     * computes a hash value for each completed line of the working buffer.
+     */
+    u64 lineHashes[3][TEX_HEIGHT] = { };
+    
+    /* Dirty line information. When the GUI picks up a frame, the hash values
+     * of the new stable buffer are compared with the ones of the previously
+     * acquired frame. Consumers can utilize this information to update only
+     * the lines that have changed.
      */
-    int *emuTexture1 = new int[TEX_HEIGHT * TEX_WIDTH];
-    int *emuTexture2 = new int[TEX_HEIGHT * TEX_WIDTH];
-    int *dmaTexture1 = new int[TEX_HEIGHT * TEX_WIDTH];
-    int *dmaTexture2 = new int[TEX_HEIGHT * TEX_WIDTH];
-    /*
+    u64 stableHashes[TEX_HEIGHT];
+    u32 stableColors[16] = { };
+    bool stableBlending = false;
+    bool dirtyLines[TEX_HEIGHT];
+    isize numDirtyLines = TEX_HEIGHT;
+    
+    /* Glyphs of the Character Rom (see getScreenText()). Each entry combines
+     * the eight bytes of a glyph with its number (0 - 511). The table is
+     * sorted by glyph and rebuilt whenever the Rom contents have changed.
+     */
+    std::vector<std::pair<u64, u16>> romGlyphs;
+    std::vector<u8> romGlyphSource;
+    
+    /* Frame statistics. A frame is dropped if it is superseded before the
+     * GUI has picked it up. A frame is duplicated if the GUI requests a
+     * texture and no new frame has been completed in the meantime.
+     */
+    std::atomic<u64> droppedFrames {0};
+    std::atomic<u64> duplicatedFrames {0};
+    
+    // Number of drawn and skipped frames since the VICII has been created
+    u64 drawnFrames = 0;
+    u64 totalSkippedFrames = 0;
+
+    /* Indicates if the current frame is drawn. If a frame is skipped, VICII
+     * runs all timing, DMA, and collision logic as usual, but leaves the
+     * working texture and the depth buffer untouched. Skipped frames are not
+     * handed over to the GUI which keeps displaying the last drawn frame.
      */
+    bool rendering = true;
+    
+    // Number of frames skipped since the last drawn frame
+    isize skippedFrames = 0;
+    
+    // Set by the GUI to have the next frame drawn in on-demand mode
+    std::atomic<bool> frameRequested {false};
+    
+    /* Preview buffer (see getPreview()). The visible area of a drawn frame is
+     * copied into this buffer in RGBA format whenever a preview has been
+     * requested. The buffer is protected by a mutex, because it is read by
+     * arbitrary threads.
+     */
+    std::vector<u32> preview;
+    isize previewHeight = 0;
+    std::atomic<bool> previewRequested {false};
+    Mutex previewMutex;
      
-    /* Pointer to the current working texture. This variable points either to
-     * the first or the second texture buffer. After a frame has been finished,
-     * the pointer is redirected to the other buffer.
+    /* Pointer to the current working texture. This variable points to one of
+     * the texture buffers. After a frame has been finished, the pointer is
+     * redirected to a buffer that is neither stable nor holding the latest
+     * frame.
      */
     int *emuTexture;
-    int *dmaTexture;
+    u16 *dmaCode;
+    u8 *idxTexture;
 
     /* Pointer to the beginning of the current rasterline inside the current
      * working textures. These pointers are used by all rendering methods to
-     * write pixels. It always points to the beginning of a rasterline, either
-     * the first or the second texture buffer. They are reset at the beginning
-     * of each frame and incremented at the beginning of each rasterline.
+     * write pixels. It always points to the beginning of a rasterline inside
+     * the working buffer. They are reset at the beginning of each frame and
+     * incremented at the beginning of each rasterline.
      */
     int *emuTexturePtr;
-    int *dmaTexturePtr;
+    u16 *dmaCodePtr;
+    u8 *idxTexturePtr;
 
     /* VICII utilizes a depth buffer to determine pixel priority. The render
      * routines only write a color value, if it is closer to the view point.
@@ -563,6 +737,7 @@ private:
 public:
 	
     VICII(C64 &ref);
+    ~VICII();
     const char *getDescription() const override { return "VICII"; }
 
 private:
@@ -570,10 +745,10 @@ private:
     void _initialize() override;
     void _reset() override;
 
-    void resetEmuTexture(int nr);
-    void resetEmuTextures() { resetEmuTexture(1); resetEmuTexture(2); }
-    void resetDmaTexture(int nr);
-    void resetDmaTextures() { resetDmaTexture(1); resetDmaTexture(2); }
+    void resetEmuTexture(isize nr);
+    void resetEmuTextures() { for (isize i = 0; i < 3; i++) resetEmuTexture(i); }
+    void resetDmaCodes(isize nr);
+    void resetDmaCodes() { for (isize i = 0; i < 3; i++) resetDmaCodes(i); }
 
     
     //
@@ -604,9 +779,16 @@ private:
     
 public:
     
-    VICIIInfo getInfo() { return HardwareComponent::getInfo(info); }
+    VICIIInfo getInfo() { return HardwareComponent::getInfo(latestInfo); }
     SpriteInfo getSpriteInfo(int nr);
 
+    /* Reads the text screen directly from the video matrix, the character
+     * set, and color RAM without rendering anything. Characters are
+     * identified by their glyphs. Hence, text drawn with a copy of the
+     * Character Rom placed in RAM is recognized, too.
+     */
+    void getScreenText(ScreenText &result);
+
 private:
     
     void _inspect() override;
@@ -703,8 +885,12 @@ private:
     }
     
     usize _size() override { COMPUTE_SNAPSHOT_SIZE }
+    usize _objectSize() const override { return sizeof(*this); }
+    void _memoryUsage(MemoryUsage &usage) override;
     usize _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     usize _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    u64 _hash() override { HASH_SNAPSHOT_ITEMS }
+    usize didLoadFromBuffer(u8 *buffer) override;
 
 private:
     
@@ -780,17 +966,135 @@ public:
     // Accessing the screen buffer and display properties
     //
     
-    // Returns the currently stable textures
-    void *stableEmuTexture() const;
-    void *stableDmaTexture() const;
+    /* Picks up the latest completed frame. The function is called by the GUI
+     * thread once per displayed frame, before the stable texture is accessed.
+     * It returns false if no new frame has been completed since the previous
+     * call. In this case, the stable buffer remains unchanged and the frame
+     * is counted as duplicated.
+     */
+    bool acquireTexture();
+    
+    /* Lets VICII draw directly into buffers provided by the GUI. This allows
+     * the GUI to hand the buffers over to the GPU without copying them on the
+     * CPU. emu must point to three buffers holding texSize RGBA values, idx
+     * to three buffers holding texSize color indices. Passing nullptr
+     * switches back to the internal buffers. The contents of the current
+     * buffers are carried over. The GUI must unregister the buffers before
+     * releasing them.
+     */
+    void setTextureBuffers(int *emu[3], u8 *idx[3]);
+    
+    // Returns the stable textures (see acquireTexture())
+    void *stableEmuTexture();
+    const u8 *stableIdxTexture();
     
-    // Returns a pointer to randon noise
+    /* Returns the stable texture in the format it has been drawn in. If the
+     * frame consists of color indices, they are handed out untranslated and
+     * 'indexed' is set to true. This allows the GUI to translate them on the
+     * GPU with a lookup table obtained by getPalette().
+     */
+    const void *stableTexture(bool &indexed);
+    
+    // Fills a lookup table translating color indices into RGBA values
+    void getPalette(u32 *lut) const;
+    
+    // Returns the DMA access codes belonging to the stable texture
+    const u16 *stableDmaCodes() const;
+    
+    /* Returns the latest completed frame to the emulator thread. In contrast
+     * to stableEmuTexture(), this function leaves the buffers untouched.
+     */
+    void *latestEmuTexture();
+    
+    // Returns the latest completed frame if it consists of color indices
+    const u8 *latestIdxTexture() const {
+        return idxTextureValid[completedBuffer] ? idxTextures[completedBuffer] : nullptr;
+    }
+    
+    /* Checks if a line of the stable texture differs from the same line of
+     * the previously acquired frame.
+     */
+    bool isDirty(isize line) const { return dirtyLines[line]; }
+    isize dirtyLineCount() const { return numDirtyLines; }
+    
+    /* Produces a scaled copy of the visible screen area or a section of it.
+     * The section is given in coordinates of the visible area and scaled to
+     * the size of the destination buffer with a box filter. This function can
+     * be called from any thread while the emulator is running. Each call
+     * requests the next frame to be drawn and handed over (see takePreview).
+     * The function returns false if no frame has been handed over so far.
+     */
+    bool getPreview(u32 *dst, isize width, isize height);
+    bool getPreview(u32 *dst, isize width, isize height,
+                    isize x, isize y, isize w, isize h);
+    
+    // Returns frame statistics
+    u64 getDroppedFrames() const { return droppedFrames; }
+    u64 getDuplicatedFrames() const { return duplicatedFrames; }
+    u64 getDrawnFrames() const { return drawnFrames; }
+    u64 getSkippedFrames() const { return totalSkippedFrames; }
+    
+private:
+    
+    // Completes the working buffer and selects a new one
+    void swapTextures();
+    
+    // Copies the visible area of the working buffer into the preview buffer
+    void takePreview();
+    
+    // Computes the hash value of the most recently drawn texture line
+    void hashTextureLine();
+    u64 computeLineHash(isize nr, isize line, bool indexed) const;
+    
+    // Starts the post-processing of the working buffer
+    void launchPipeline();
+    
+    // Waits until the render pipeline has processed all lines
+    void drainPipeline();
+    
+    // Post-processes the lines of a buffer (executed by the helper thread)
+    void renderLines(isize nr);
+    
+    // Compares the hash values of the stable buffer with the previous ones
+    void updateDirtyLines(bool acquired);
+    
+    // Translates an indexed texture into RGBA values
+    void convertIndexedTexture(const u8 *src, u32 *dst) const;
+    
+    // Translates the stable texture unless it is already up to date
+    void convertStableTexture();
+    
+    /* Translates a single line of an indexed texture into RGBA values. If
+     * PAL blending is enabled, the line above is taken into account.
+     */
+    void convertIndexedLine(const u8 *src, u32 *dst, isize line, const u32 *lut) const;
+    
+    // Determines whether the next frame is drawn in indexed format
+    void updateTextureFormat();
+    
+    // Determines whether the next frame is drawn or skipped
+    void updateRenderMode();
+    
+public:
+    
+    // Requests the next frame to be drawn (ignores the frame skip setting)
+    void requestFrame() { frameRequested = true; }
+    
+    // Changes the scheduling parameters of the render pipeline
+    void setThreadPolicy(const ThreadPolicy &policy) { renderer.setPolicy(policy); }
+    
+    /* Returns a pointer to random noise. The noise pattern is created on
+     * first use and shared by all instances. It must not be modified.
+     */
     u32 *getNoise() const;
     
     // Returns a C64 color in 32 bit big endian RGBA format
     u32 getColor(unsigned nr) const { return rgbaTable[nr]; }
     u32 getColor(unsigned nr, Palette palette);
     
+    // Returns a C64 color as seen through the PAL delay line (see mixTable)
+    u32 getMixedColor(unsigned nr, unsigned above) const { return mixTable[nr][above]; }
+    
     // Gets or sets a monitor parameter
     double getBrightness() const { return brightness; }
     void setBrightness(double value);
@@ -805,6 +1109,12 @@ private:
      * determined by the selected VICII model.
      */
     void updatePalette();
+    
+    // Computes the YUV values of a C64 color
+    void getYUV(unsigned nr, Palette palette, double &y, double &u, double &v);
+    
+    // Converts a YUV value into RGBA format (including gamma correction)
+    u32 yuvToRgba(double y, double u, double v) const;
 
     
     //
@@ -828,6 +1138,9 @@ public:
     // Returns the latest value of the VICII's data bus during phi2
     u8 getDataBusPhi2() const { return dataBusPhi2; }
 
+    // Returns the start address of the memory bank seen by the VICII
+    u16 getBankAddr() const { return bankAddr; }
+
     /* Schedules the VICII bank to to switched. This method is called if the
      * bank switch is triggered by a change of CIA2::PA or CIA2::DDRA.
      */
@@ -838,12 +1151,15 @@ private:
     /* Updates the VICII bank address. The new address is computed from the
      * provided bank number.
      */
-    void updateBankAddr(u8 bank) { assert(bank < 4); bankAddr = bank << 14; }
+    void updateBankAddr(u8 bank);
 
     /* Updates the VICII bank address. The new address is computed from the
      * bits in CIA2::PA.
      */
     void updateBankAddr();
+
+    // Rebuilds the page lookup table (bankPages)
+    void updateBankPages();
     
     // Reads a value from a VICII register
 	u8 peek(u16 addr);
@@ -1008,6 +1324,11 @@ private:
     // Interacting with the CPU
     //
     
+public:
+    
+    // Indicates if the BA line is pulled down (halts DMA on the expansion port)
+    bool BApulledDown() const { return baLine.current() != 0; }
+    
 private:
     
     // Sets the value of the BA line which is connected to the CPU's RDY pin.
@@ -1204,13 +1525,16 @@ public:
     void cycle64ntsc();
     void cycle65ntsc();
 	
-    #define DRAW_SPRITES if (spriteDisplay || isSecondDMAcycle) drawSprites();
-    #define DRAW_SPRITES59 if (spriteDisplayDelayed || spriteDisplay || isSecondDMAcycle) drawSprites();
+    // The drawing routines only depend on the chip generation
+    #define DRAW_TYPE (VICIIMode)(mode & VIC856X_CYCLE)
 
-    #define DRAW if (!vblank) draw(); DRAW_SPRITES;
-    #define DRAW17 if (!vblank) draw17(); DRAW_SPRITES;
-    #define DRAW55 if (!vblank) draw55(); DRAW_SPRITES;
-    #define DRAW59 if (!vblank) draw(); DRAW_SPRITES59;
+    #define DRAW_SPRITES if (spriteDisplay || isSecondDMAcycle) drawSprites<DRAW_TYPE>();
+    #define DRAW_SPRITES59 if (spriteDisplayDelayed || spriteDisplay || isSecondDMAcycle) drawSprites<DRAW_TYPE>();
+
+    #define DRAW if (!vblank) draw<DRAW_TYPE>(); DRAW_SPRITES;
+    #define DRAW17 if (!vblank) draw17<DRAW_TYPE>(); DRAW_SPRITES;
+    #define DRAW55 if (!vblank) draw55<DRAW_TYPE>(); DRAW_SPRITES;
+    #define DRAW59 if (!vblank) draw<DRAW_TYPE>(); DRAW_SPRITES59;
     #define DRAW_IDLE DRAW_SPRITES;
         
     #define END_CYCLE \
@@ -1235,13 +1559,13 @@ private:
      * invoked in each drawing cycle. An exception are cycle 17 and cycle 55
      * which are handled seperately for speedup reasons.
      */
-    void draw();
+    template <VICIIMode type> void draw();
     
     // Special draw routine for cycle 17
-    void draw17();
+    template <VICIIMode type> void draw17();
     
     // Special draw routine for cycle 55
-    void draw55();
+    template <VICIIMode type> void draw55();
         
     
     //
@@ -1257,8 +1581,32 @@ private:
     // Draws the border pixels in cycle 55 (see draw55())
     void drawBorder55();
     
+    /* Indicates if the border covers all 8 pixels of the current chunk with
+     * a single color. In this case, the sequencer outputs the background
+     * color which is entirely hidden by the border.
+     */
+    bool borderCoversChunk() const {
+        return
+        flipflops.delayed.vertical &&
+        flipflops.delayed.main && flipflops.current.main &&
+        reg.delayed.colors[COLREG_BORDER] == reg.current.colors[COLREG_BORDER];
+    }
+    
+    /* Draws 8 border pixels in one go. This function is called instead of
+     * drawCanvas() and drawBorder() if borderCoversChunk() returns true.
+     */
+    void drawBorderChunk();
+    
     // Draws 8 canvas pixels (see draw())
-    void drawCanvas();
+    template <VICIIMode type> void drawCanvas();
+    
+    /* Draws 8 canvas pixels in one go. This function is called by drawCanvas()
+     * if the shift register is loaded at the first pixel and no register
+     * change shows up inside the chunk.
+     *
+     *          mode : display mode (ECM/BMM/MCM bits)
+     */
+    void drawCanvasChunk(u8 mode);
     
     /* Draws a single canvas pixel
      *
@@ -1275,7 +1623,7 @@ private:
                          bool updateColors);
     
     // Draws 8 sprite pixels (see draw())
-    void drawSprites();
+    template <VICIIMode type> void drawSprites();
     
     /* Draws a single sprite pixel for all sprites
      *
@@ -1303,29 +1651,34 @@ private:
     // Writes a single color value into the screenbuffer
     #define COLORIZE(index,color) \
         assert(index < TEX_WIDTH); \
-        emuTexturePtr[index] = rgbaTable[color];
+        if (indexed) idxTexturePtr[index] = color; \
+        else emuTexturePtr[index] = rgbaTable[color];
     
     /* Sets a single frame pixel. The upper bit in pixelSource is cleared to
-     * prevent sprite/foreground collision detection in border area.
+     * prevent sprite/foreground collision detection in border area. If the
+     * frame is skipped, only pixelSource is updated.
      */
     #define SET_FRAME_PIXEL(pixel,color) { \
         int index = bufferoffset + pixel; \
-        COLORIZE(index, color); \
-        zBuffer[index] = BORDER_LAYER_DEPTH; \
+        if (rendering) { \
+            COLORIZE(index, color); \
+            zBuffer[index] = BORDER_LAYER_DEPTH; } \
         pixelSource[index] &= (~0x100); }
     
     // Sets a single foreground pixel
     #define SET_FOREGROUND_PIXEL(pixel,color) { \
         int index = bufferoffset + pixel; \
-        COLORIZE(index,color) \
-        zBuffer[index] = FOREGROUND_LAYER_DEPTH; \
+        if (rendering) { \
+            COLORIZE(index,color) \
+            zBuffer[index] = FOREGROUND_LAYER_DEPTH; } \
         pixelSource[index] = 0x100; }
 
     // Sets a single background pixel
     #define SET_BACKGROUND_PIXEL(pixel,color) { \
         int index = bufferoffset + pixel; \
-        COLORIZE(index,color) \
-        zBuffer[index] = BACKGROUD_LAYER_DEPTH; \
+        if (rendering) { \
+            COLORIZE(index,color) \
+            zBuffer[index] = BACKGROUD_LAYER_DEPTH; } \
         pixelSource[index] = 0x00; }
     
     // Draw a single sprite pixel
@@ -1351,9 +1704,9 @@ public:
     // Initializes the DMA debugger textures
     void clearDmaDebuggerTexture();
     
-    // Visualizes a memory access by drawing into the DMA debuger texture
+    // Records a memory access in the DMA access code buffer
     void visualizeDma(u8 offset, u8 data, MemAccess type);
     
-    // Superimposes the debug output onto the current rasterline
-    void computeOverlay();
+    // Superimposes the recorded memory accesses onto a texture buffer
+    void computeOverlay(isize nr);
 };
@@ -88,6 +88,9 @@ enum_long(DMA_DISPLAY_MODE)
 };
 typedef DMA_DISPLAY_MODE DmaDisplayMode;
 
+// Frame skip setting for drawing on-demand only (see VICII::requestFrame)
+#define FRAME_SKIP_ON_DEMAND -1
+
 //
 // Structures
 //
@@ -98,6 +101,7 @@ typedef struct
     bool grayDotBug;
     GlueLogic glueLogic;
     Palette palette;
+    bool palBlending;
     
     // Debugging
     bool hideSprites;
@@ -109,6 +113,11 @@ typedef struct
     u16 cutLayers;
     u8 cutOpacity;
     
+    // Performance
+    bool indexedTexture;
+    isize frameSkip;
+    bool renderPipeline;
+    
     // Cheating
     bool checkSSCollisions;
     bool checkSBCollisions;
@@ -191,4 +200,25 @@ typedef struct
     u8 extraColor2;
 }
 SpriteInfo;
+
+typedef struct
+{
+    /* Display mode and memory layout the screen has been read with. Both
+     * addresses refer to the C64 address space (the VICII bank is included).
+     */
+    DisplayMode displayMode;
+    u16 screenMemoryAddr;
+    u16 charMemoryAddr;
+    
+    // Screen codes and colors (lower nibble of color RAM) of all 1000 cells
+    u8 codes[1000];
+    u8 colors[1000];
+    
+    /* Screen contents as plain text with one line per row. Characters without
+     * an ASCII counterpart are shown as '.'. In bitmap modes, the string is
+     * empty.
+     */
+    char text[25 * 41 + 1];
+}
+ScreenText;
     
@@ -240,12 +240,21 @@ struct DmaDisplayModeEnum : Reflection<DmaDisplayModeEnum, DmaDisplayMode> {
 // Private types
 //
 
+/* Template parameter of the cycle functions. Bit 0 indicates whether the DMA
+ * debugger is active, bit 1 selects NTSC timing, and bit 2 selects the newer
+ * 856x chip generation. By compiling a separate set of cycle functions for
+ * each combination, the cycle functions don't check the VICII model at
+ * runtime.
+ */
 enum VICIIMode
 {
     PAL_CYCLE         = 0x0,
     PAL_DEBUG_CYCLE   = 0x1,
     NTSC_CYCLE        = 0x2,
-    NTSC_DEBUG_CYCLE  = 0x3
+    NTSC_DEBUG_CYCLE  = 0x3,
+    
+    DEBUG_CYCLE       = 0x1,
+    VIC856X_CYCLE     = 0x4
 };
 
 enum VICIIColors
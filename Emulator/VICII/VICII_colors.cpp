@@ -40,6 +40,13 @@ VICII::getColor(unsigned nr, Palette palette)
 {
     double y, u, v;
     
+    getYUV(nr, palette, y, u, v);
+    return yuvToRgba(y, u, v);
+}
+
+void
+VICII::getYUV(unsigned nr, Palette palette, double &y, double &u, double &v)
+{
     // LUMA levels (varies between VICII models)
     #define LUMA_VICE(x,y,z) ((double)(x - y) * 256)/((double)(z - y))
     #define LUMA_COLORES(x) (x * 7.96875)
@@ -209,7 +216,11 @@ VICII::getColor(unsigned nr, Palette palette)
         default:
         assert(palette == PALETTE_COLOR);
     }
-    
+}
+
+u32
+VICII::yuvToRgba(double y, double u, double v) const
+{
     // Convert YUV value to RGB
     double r = y             + 1.140 * v;
     double g = y - 0.396 * u - 0.581 * v;
@@ -441,8 +452,23 @@ VICII::updatePalette()
     }
 #endif
     
+    double y[16], u[16], v[16];
+    
     for (unsigned i = 0; i < 16; i++) {
-        rgbaTable[i] = getColor(i, config.palette);
+        
+        getYUV(i, config.palette, y[i], u[i], v[i]);
+        rgbaTable[i] = yuvToRgba(y[i], u[i], v[i]);
+    }
+    
+    /* The PAL delay line averages the chroma of two adjacent lines while the
+     * luma is taken from the current line. NTSC displays the colors as is.
+     */
+    for (unsigned i = 0; i < 16; i++) {
+        for (unsigned j = 0; j < 16; j++) {
+            
+            mixTable[i][j] = isPAL() ?
+            yuvToRgba(y[i], (u[i] + u[j]) / 2, (v[i] + v[j]) / 2) : rgbaTable[i];
+        }
     }
 }
 
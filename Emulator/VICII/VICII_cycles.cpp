@@ -23,8 +23,8 @@
  *                   |  Phi2.4 BA logic
  */
 
-#define PAL if (mode == PAL_CYCLE || mode == PAL_DEBUG_CYCLE)
-#define NTSC if (mode == NTSC_CYCLE || mode == NTSC_DEBUG_CYCLE)
+#define PAL if (!(mode & NTSC_CYCLE))
+#define NTSC if (mode & NTSC_CYCLE)
 
 template <VICIIMode mode> void
 VICII::cycle1()
@@ -806,7 +806,7 @@ VICII::sAccess1()
             
             dataBusPhi2 = memAccess(spritePtr[sprite] | mc[sprite]);
             
-            if (type == PAL_DEBUG_CYCLE || type == NTSC_DEBUG_CYCLE) {
+            if (type & DEBUG_CYCLE) {
                 visualizeDma(4, dataBusPhi2, MEMACCESS_S);
             }
         }
@@ -831,7 +831,7 @@ VICII::sAccess2()
         dataBusPhi1 = memAccess(spritePtr[sprite] | mc[sprite]);
         mc[sprite] = (mc[sprite] + 1) & 0x3F;
         
-        if (type == PAL_DEBUG_CYCLE || type == NTSC_DEBUG_CYCLE) {
+        if (type & DEBUG_CYCLE) {
             visualizeDma(0, dataBusPhi1, MEMACCESS_S);
         }
 
@@ -855,7 +855,7 @@ VICII::sAccess3()
         dataBusPhi2 = memAccess(spritePtr[sprite] | mc[sprite]);
         mc[sprite] = (mc[sprite] + 1) & 0x3F;
 
-        if (type == PAL_DEBUG_CYCLE || type == NTSC_DEBUG_CYCLE) {
+        if (type & DEBUG_CYCLE) {
             visualizeDma(4, dataBusPhi2, MEMACCESS_S);
         }
     }
@@ -868,7 +868,7 @@ VICII::rAccess()
 {
     dataBusPhi1 = memAccess(0x3F00 | refreshCounter--);
     
-    if (type == PAL_DEBUG_CYCLE || type == NTSC_DEBUG_CYCLE) {
+    if (type & DEBUG_CYCLE) {
         visualizeDma(0, dataBusPhi1, MEMACCESS_R);
     }
 }
@@ -878,7 +878,7 @@ VICII::iAccess()
 {
     dataBusPhi1 = memAccess(0x3FFF);
     
-    if (type == PAL_DEBUG_CYCLE || type == NTSC_DEBUG_CYCLE) {
+    if (type & DEBUG_CYCLE) {
         visualizeDma(0, dataBusPhi1, MEMACCESS_I);
     }
 }
@@ -896,7 +896,7 @@ VICII::cAccess()
         videoMatrix[vmli] = dataBusPhi2;
         colorLine[vmli] = mem.colorRam[vc] & 0x0F;
         
-        if (type == PAL_DEBUG_CYCLE || type == NTSC_DEBUG_CYCLE) {
+        if (type & DEBUG_CYCLE) {
             visualizeDma(4, dataBusPhi2, MEMACCESS_C);
         }
     }
@@ -945,7 +945,7 @@ VICII::gAccess()
          */
  
         // Get address
-        addr = is856x() ? gAccessAddr85x() : gAccessAddr65x();
+        addr = (type & VIC856X_CYCLE) ? gAccessAddr85x() : gAccessAddr65x();
         
         // Fetch
         dataBusPhi1 = memAccess(addr);
@@ -964,7 +964,7 @@ VICII::gAccess()
         
         // Get address. In idle state, g-accesses read from $39FF or $3FFF,
         // depending on the ECM bit.
-        if (is856x()) {
+        if (type & VIC856X_CYCLE) {
             addr = GET_BIT(reg.delayed.ctrl1, 6) ? 0x39FF : 0x3FFF;
         } else {
             addr = GET_BIT(reg.current.ctrl1, 6) ? 0x39FF : 0x3FFF;
@@ -977,7 +977,7 @@ VICII::gAccess()
         gAccessResult.write(dataBusPhi1);
     }
     
-    if (type == PAL_DEBUG_CYCLE || type == NTSC_DEBUG_CYCLE) {
+    if (type & DEBUG_CYCLE) {
         visualizeDma(0, dataBusPhi1, MEMACCESS_G);
     }
 }
@@ -1052,7 +1052,7 @@ VICII::pAccess(unsigned sprite)
     dataBusPhi1 = memAccess((VM13VM12VM11VM10() << 6) | 0x03F8 | sprite);
     spritePtr[sprite] = dataBusPhi1 << 6;
     
-    if (type == PAL_DEBUG_CYCLE || type == NTSC_DEBUG_CYCLE) {
+    if (type & DEBUG_CYCLE) {
         visualizeDma(0, dataBusPhi1, MEMACCESS_P);
     }
 }
@@ -1067,126 +1067,43 @@ void VICII::sFinalize(unsigned sprite)
 // Instantiate template functions
 //
 
-template void VICII::cycle1<PAL_CYCLE>();
-template void VICII::cycle2<PAL_CYCLE>();
-template void VICII::cycle3<PAL_CYCLE>();
-template void VICII::cycle4<PAL_CYCLE>();
-template void VICII::cycle5<PAL_CYCLE>();
-template void VICII::cycle6<PAL_CYCLE>();
-template void VICII::cycle7<PAL_CYCLE>();
-template void VICII::cycle8<PAL_CYCLE>();
-template void VICII::cycle9<PAL_CYCLE>();
-template void VICII::cycle10<PAL_CYCLE>();
-template void VICII::cycle11<PAL_CYCLE>();
-template void VICII::cycle12<PAL_CYCLE>();
-template void VICII::cycle13<PAL_CYCLE>();
-template void VICII::cycle14<PAL_CYCLE>();
-template void VICII::cycle15<PAL_CYCLE>();
-template void VICII::cycle16<PAL_CYCLE>();
-template void VICII::cycle17<PAL_CYCLE>();
-template void VICII::cycle18<PAL_CYCLE>();
-template void VICII::cycle19to54<PAL_CYCLE>();
-template void VICII::cycle55<PAL_CYCLE>();
-template void VICII::cycle56<PAL_CYCLE>();
-template void VICII::cycle57<PAL_CYCLE>();
-template void VICII::cycle58<PAL_CYCLE>();
-template void VICII::cycle59<PAL_CYCLE>();
-template void VICII::cycle60<PAL_CYCLE>();
-template void VICII::cycle61<PAL_CYCLE>();
-template void VICII::cycle62<PAL_CYCLE>();
-template void VICII::cycle63<PAL_CYCLE>();
-template void VICII::cycle64<PAL_CYCLE>();
-template void VICII::cycle65<PAL_CYCLE>();
-
-template void VICII::cycle1<PAL_DEBUG_CYCLE>();
-template void VICII::cycle2<PAL_DEBUG_CYCLE>();
-template void VICII::cycle3<PAL_DEBUG_CYCLE>();
-template void VICII::cycle4<PAL_DEBUG_CYCLE>();
-template void VICII::cycle5<PAL_DEBUG_CYCLE>();
-template void VICII::cycle6<PAL_DEBUG_CYCLE>();
-template void VICII::cycle7<PAL_DEBUG_CYCLE>();
-template void VICII::cycle8<PAL_DEBUG_CYCLE>();
-template void VICII::cycle9<PAL_DEBUG_CYCLE>();
-template void VICII::cycle10<PAL_DEBUG_CYCLE>();
-template void VICII::cycle11<PAL_DEBUG_CYCLE>();
-template void VICII::cycle12<PAL_DEBUG_CYCLE>();
-template void VICII::cycle13<PAL_DEBUG_CYCLE>();
-template void VICII::cycle14<PAL_DEBUG_CYCLE>();
-template void VICII::cycle15<PAL_DEBUG_CYCLE>();
-template void VICII::cycle16<PAL_DEBUG_CYCLE>();
-template void VICII::cycle17<PAL_DEBUG_CYCLE>();
-template void VICII::cycle18<PAL_DEBUG_CYCLE>();
-template void VICII::cycle19to54<PAL_DEBUG_CYCLE>();
-template void VICII::cycle55<PAL_DEBUG_CYCLE>();
-template void VICII::cycle56<PAL_DEBUG_CYCLE>();
-template void VICII::cycle57<PAL_DEBUG_CYCLE>();
-template void VICII::cycle58<PAL_DEBUG_CYCLE>();
-template void VICII::cycle59<PAL_DEBUG_CYCLE>();
-template void VICII::cycle60<PAL_DEBUG_CYCLE>();
-template void VICII::cycle61<PAL_DEBUG_CYCLE>();
-template void VICII::cycle62<PAL_DEBUG_CYCLE>();
-template void VICII::cycle63<PAL_DEBUG_CYCLE>();
-template void VICII::cycle64<PAL_DEBUG_CYCLE>();
-template void VICII::cycle65<PAL_DEBUG_CYCLE>();
-
-template void VICII::cycle1<NTSC_CYCLE>();
-template void VICII::cycle2<NTSC_CYCLE>();
-template void VICII::cycle3<NTSC_CYCLE>();
-template void VICII::cycle4<NTSC_CYCLE>();
-template void VICII::cycle5<NTSC_CYCLE>();
-template void VICII::cycle6<NTSC_CYCLE>();
-template void VICII::cycle7<NTSC_CYCLE>();
-template void VICII::cycle8<NTSC_CYCLE>();
-template void VICII::cycle9<NTSC_CYCLE>();
-template void VICII::cycle10<NTSC_CYCLE>();
-template void VICII::cycle11<NTSC_CYCLE>();
-template void VICII::cycle12<NTSC_CYCLE>();
-template void VICII::cycle13<NTSC_CYCLE>();
-template void VICII::cycle14<NTSC_CYCLE>();
-template void VICII::cycle15<NTSC_CYCLE>();
-template void VICII::cycle16<NTSC_CYCLE>();
-template void VICII::cycle17<NTSC_CYCLE>();
-template void VICII::cycle18<NTSC_CYCLE>();
-template void VICII::cycle19to54<NTSC_CYCLE>();
-template void VICII::cycle55<NTSC_CYCLE>();
-template void VICII::cycle56<NTSC_CYCLE>();
-template void VICII::cycle57<NTSC_CYCLE>();
-template void VICII::cycle58<NTSC_CYCLE>();
-template void VICII::cycle59<NTSC_CYCLE>();
-template void VICII::cycle60<NTSC_CYCLE>();
-template void VICII::cycle61<NTSC_CYCLE>();
-template void VICII::cycle62<NTSC_CYCLE>();
-template void VICII::cycle63<NTSC_CYCLE>();
-template void VICII::cycle64<NTSC_CYCLE>();
-template void VICII::cycle65<NTSC_CYCLE>();
-
-template void VICII::cycle1<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle2<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle3<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle4<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle5<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle6<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle7<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle8<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle9<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle10<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle11<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle12<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle13<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle14<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle15<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle16<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle17<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle18<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle19to54<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle55<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle56<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle57<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle58<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle59<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle60<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle61<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle62<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle63<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle64<NTSC_DEBUG_CYCLE>();
-template void VICII::cycle65<NTSC_DEBUG_CYCLE>();
+#define INSTANTIATE_CYCLES(mode) \
+template void VICII::cycle1<mode>(); \
+template void VICII::cycle2<mode>(); \
+template void VICII::cycle3<mode>(); \
+template void VICII::cycle4<mode>(); \
+template void VICII::cycle5<mode>(); \
+template void VICII::cycle6<mode>(); \
+template void VICII::cycle7<mode>(); \
+template void VICII::cycle8<mode>(); \
+template void VICII::cycle9<mode>(); \
+template void VICII::cycle10<mode>(); \
+template void VICII::cycle11<mode>(); \
+template void VICII::cycle12<mode>(); \
+template void VICII::cycle13<mode>(); \
+template void VICII::cycle14<mode>(); \
+template void VICII::cycle15<mode>(); \
+template void VICII::cycle16<mode>(); \
+template void VICII::cycle17<mode>(); \
+template void VICII::cycle18<mode>(); \
+template void VICII::cycle19to54<mode>(); \
+template void VICII::cycle55<mode>(); \
+template void VICII::cycle56<mode>(); \
+template void VICII::cycle57<mode>(); \
+template void VICII::cycle58<mode>(); \
+template void VICII::cycle59<mode>(); \
+template void VICII::cycle60<mode>(); \
+template void VICII::cycle61<mode>(); \
+template void VICII::cycle62<mode>(); \
+template void VICII::cycle63<mode>(); \
+template void VICII::cycle64<mode>(); \
+template void VICII::cycle65<mode>();
+
+INSTANTIATE_CYCLES(PAL_CYCLE)
+INSTANTIATE_CYCLES(PAL_DEBUG_CYCLE)
+INSTANTIATE_CYCLES(NTSC_CYCLE)
+INSTANTIATE_CYCLES(NTSC_DEBUG_CYCLE)
+INSTANTIATE_CYCLES((VICIIMode)(PAL_CYCLE | VIC856X_CYCLE))
+INSTANTIATE_CYCLES((VICIIMode)(PAL_DEBUG_CYCLE | VIC856X_CYCLE))
+INSTANTIATE_CYCLES((VICIIMode)(NTSC_CYCLE | VIC856X_CYCLE))
+INSTANTIATE_CYCLES((VICIIMode)(NTSC_DEBUG_CYCLE | VIC856X_CYCLE))
@@ -26,47 +26,59 @@ VICII::getScreenGeometry(void) const
 void
 VICII::visualizeDma(u8 offset, u8 data, MemAccess type)
 {
-    int *p = dmaTexturePtr + bufferoffset + offset;
-    
-    p[3] = debugColor[type][data & 0b11]; data >>= 2;
-    p[2] = debugColor[type][data & 0b11]; data >>= 2;
-    p[1] = debugColor[type][data & 0b11]; data >>= 2;
-    p[0] = debugColor[type][data & 0b11];
+    assert((bufferoffset + offset) % 4 == 0);
+    dmaCodePtr[(bufferoffset + offset) / 4] = (u16)((type + 1) << 8 | data);
 }
 
 void
-VICII::computeOverlay()
+VICII::computeOverlay(isize nr)
 {
+    assert(nr >= 0 && nr < 3);
+    assert(dmaCodes[nr]);
+    
     // double bgWeight, fgWeight;
     double weight = config.dmaOpacity / 255.0;
+    int dma[TEX_WIDTH];
 
-    switch (config.dmaDisplayMode) {
-
-        case DMA_DISPLAY_MODE_FG_LAYER:
+    for (int y = 0; y < TEX_HEIGHT; y++) {
+        
+        int *emu = emuTextures[nr] + (y * TEX_WIDTH);
+        const u16 *codes = dmaCodes[nr] + (y * dmaCodesPerLine);
+        
+        // Translate the access codes of this line into colors
+        for (int i = 0; i < dmaCodesPerLine; i++) {
             
-            for (int y = 0; y < TEX_HEIGHT; y++) {
+            int *p = dma + 4 * i;
+            u16 code = codes[i];
+            
+            if (code == 0) {
+                p[0] = p[1] = p[2] = p[3] = 0xFF000000;
+                continue;
+            }
+            
+            u32 *color = debugColor[(code >> 8) - 1];
+            p[3] = color[code & 0b11]; code >>= 2;
+            p[2] = color[code & 0b11]; code >>= 2;
+            p[1] = color[code & 0b11]; code >>= 2;
+            p[0] = color[code & 0b11];
+        }
+        
+        switch (config.dmaDisplayMode) {
                 
-                int *emu = emuTexture + (y * TEX_WIDTH);
-                int *dma = dmaTexture + (y * TEX_WIDTH);
+            case DMA_DISPLAY_MODE_FG_LAYER:
                 
                 for (int x = 0; x < TEX_WIDTH; x++) {
                     
                     if ((dma[x] & 0xFFFFFF) == 0) continue;
-
+                    
                     GpuColor emuColor = emu[x];
                     GpuColor dmaColor = dma[x];
                     GpuColor mixColor = emuColor.mix(dmaColor, weight);
                     emu[x] = mixColor.rawValue;
                 }
-            }
-            break;
-
-        case DMA_DISPLAY_MODE_BG_LAYER:
-            
-            for (int y = 0; y < TEX_HEIGHT; y++) {
+                break;
                 
-                int *emu = emuTexture + (y * TEX_WIDTH);
-                int *dma = dmaTexture + (y * TEX_WIDTH);
+            case DMA_DISPLAY_MODE_BG_LAYER:
                 
                 for (int x = 0; x < TEX_WIDTH; x++) {
                     
@@ -78,15 +90,9 @@ VICII::computeOverlay()
                         emu[x] = mixColor.rawValue;
                     }
                 }
-            }
-            break;
-
-        case DMA_DISPLAY_MODE_ODD_EVEN_LAYERS:
-            
-            for (int y = 0; y < TEX_HEIGHT; y++) {
+                break;
                 
-                int *emu = emuTexture + (y * TEX_WIDTH);
-                int *dma = dmaTexture + (y * TEX_WIDTH);
+            case DMA_DISPLAY_MODE_ODD_EVEN_LAYERS:
                 
                 for (int x = 0; x < TEX_WIDTH; x++) {
                     
@@ -95,10 +101,9 @@ VICII::computeOverlay()
                     GpuColor mixColor = dmaColor.mix(emuColor, weight);
                     emu[x] = mixColor.rawValue;
                 }
-            }
-            break;
-            
-        default: assert(false);
-            
+                break;
+                
+            default: assert(false);
+        }
     }
 }
@@ -9,24 +9,30 @@
 
 #include "C64.h"
 
-void
+template <VICIIMode type> void
 VICII::draw()
 {
-    drawCanvas();
+    if (borderCoversChunk()) { drawBorderChunk(); return; }
+    
+    drawCanvas<type>();
     drawBorder();
 }
 
-void
+template <VICIIMode type> void
 VICII::draw17()
 {
-    drawCanvas();
+    if (borderCoversChunk()) { drawBorderChunk(); return; }
+    
+    drawCanvas<type>();
     drawBorder17();
 }
 
-void
+template <VICIIMode type> void
 VICII::draw55()
 {
-    drawCanvas();
+    if (borderCoversChunk()) { drawBorderChunk(); return; }
+    
+    drawCanvas<type>();
     drawBorder55();
 }
 
@@ -76,6 +82,33 @@ VICII::drawBorder55()
 }
 
 void
+VICII::drawBorderChunk()
+{
+    u8 color = reg.current.colors[COLREG_BORDER];
+    
+    // Neither the canvas nor the border produce foreground pixels
+    u16 *source = pixelSource + bufferoffset;
+    for (unsigned i = 0; i < 8; i++) source[i] = 0;
+    
+    if (rendering) {
+        
+        assert(bufferoffset + 8 <= TEX_WIDTH);
+        memset(zBuffer + bufferoffset, BORDER_LAYER_DEPTH, 8);
+        
+        if (indexed) {
+            
+            memset(idxTexturePtr + bufferoffset, color, 8);
+            
+        } else {
+            
+            int rgba = rgbaTable[color];
+            int *dst = emuTexturePtr + bufferoffset;
+            for (unsigned i = 0; i < 8; i++) dst[i] = rgba;
+        }
+    }
+}
+
+template <VICIIMode type> void
 VICII::drawCanvas()
 {
     u8 d011, d016, newD016, mode, oldMode, xscroll;
@@ -109,6 +142,19 @@ VICII::drawCanvas()
     xscroll = d016 & 0x07;
     mode = (d011 & 0x60) | (d016 & 0x10); // -xxx ----
 
+    // Take the fast path if all pixels are drawn with the same settings
+    if (xscroll == 0 && sr.canLoad &&
+        !((d011 ^ reg.current.ctrl1) & 0x60) &&
+        !((d016 ^ reg.current.ctrl2) & 0x10) &&
+        reg.delayed.colors[COLREG_BG0] == reg.current.colors[COLREG_BG0] &&
+        reg.delayed.colors[COLREG_BG1] == reg.current.colors[COLREG_BG1] &&
+        reg.delayed.colors[COLREG_BG2] == reg.current.colors[COLREG_BG2] &&
+        reg.delayed.colors[COLREG_BG3] == reg.current.colors[COLREG_BG3]) {
+        
+        drawCanvasChunk(mode);
+        return;
+    }
+    
     drawCanvasPixel(0, mode, d016, xscroll == 0, true);
     
     // After the first pixel, color register changes show up
@@ -125,7 +171,7 @@ VICII::drawCanvas()
     newD016 = reg.current.ctrl2;
 
     // In older VICIIs, the one bits of D011 show up, too.
-    if (is656x()) {
+    if (!(type & VIC856X_CYCLE)) {
         d011 |= reg.current.ctrl1;
     }
     oldMode = mode;
@@ -135,7 +181,7 @@ VICII::drawCanvas()
     drawCanvasPixel(5, mode, d016, xscroll == 5, false);
     
     // In older VICIIs, the zero bits of D011 show up here.
-    if (is656x()) {
+    if (!(type & VIC856X_CYCLE)) {
         d011 = reg.current.ctrl1;
         oldMode = mode;
         mode = (d011 & 0x60) | (newD016 & 0x10);
@@ -154,6 +200,64 @@ VICII::drawCanvas()
     drawCanvasPixel(7, mode, d016, xscroll == 7, false);
 }
 
+void
+VICII::drawCanvasChunk(u8 mode)
+{
+    // Load shift register
+    u32 result = gAccessResult.delayed();
+    sr.data = BYTE0(result);
+    sr.latchedCharacter = BYTE2(result);
+    sr.latchedColor = BYTE1(result);
+    loadColors(mode);
+    
+    bool multicolor =
+    (mode & 0x10) && ((mode & 0x20) || (sr.latchedColor & 0x8));
+    
+    // Expand the shift register into eight color bit pairs
+    u8 bits[8];
+    if (multicolor) {
+        for (unsigned i = 0; i < 8; i++) bits[i] = (sr.data >> (6 - (i & 6))) & 0x03;
+    } else {
+        for (unsigned i = 0; i < 8; i++) bits[i] = (sr.data >> (7 - i)) & 0x01;
+    }
+    
+    // Single-color pixels with bit 0 set and multi-color pixels with bit 1
+    // set belong to the foreground
+    u8 fgMask = multicolor ? 0x02 : 0x01;
+    
+    u16 *source = pixelSource + bufferoffset;
+    for (unsigned i = 0; i < 8; i++) source[i] = (bits[i] & fgMask) ? 0x100 : 0x00;
+    
+    if (rendering) {
+        
+        u8 *depth = zBuffer + bufferoffset;
+        for (unsigned i = 0; i < 8; i++) {
+            depth[i] = (bits[i] & fgMask) ? FOREGROUND_LAYER_DEPTH : BACKGROUD_LAYER_DEPTH;
+        }
+        
+        assert(bufferoffset + 8 <= TEX_WIDTH);
+        if (indexed) {
+            
+            u8 *dst = idxTexturePtr + bufferoffset;
+            for (unsigned i = 0; i < 8; i++) dst[i] = col[bits[i]];
+            
+        } else {
+            
+            int *dst = emuTexturePtr + bufferoffset;
+            for (unsigned i = 0; i < 8; i++) dst[i] = rgbaTable[col[bits[i]]];
+        }
+    }
+    
+    // Update the sequencer state as the pixel-wise code would do
+    reg.delayed.colors[COLREG_BG0] = reg.current.colors[COLREG_BG0];
+    reg.delayed.colors[COLREG_BG1] = reg.current.colors[COLREG_BG1];
+    reg.delayed.colors[COLREG_BG2] = reg.current.colors[COLREG_BG2];
+    reg.delayed.colors[COLREG_BG3] = reg.current.colors[COLREG_BG3];
+    sr.colorbits = bits[7];
+    sr.data = 0;
+    sr.mcFlop = true;
+    sr.remainingBits = 0;
+}
 
 void
 VICII::drawCanvasPixel(u8 pixel,
@@ -242,7 +346,7 @@ VICII::drawCanvasPixel(u8 pixel,
     sr.remainingBits -= 1;
 }
 
-void
+template <VICIIMode type> void
 VICII::drawSprites()
 {
     u8 firstDMA = isFirstDMAcycle;
@@ -280,7 +384,7 @@ VICII::drawSprites()
 
     // Update multicolor bits if a new VICII is emulated
     u8 toggle = reg.delayed.sprMC ^ reg.current.sprMC;
-    if (toggle && is856x()) {
+    if (toggle && (type & VIC856X_CYCLE)) {
         
         // VICE:
         // BYTE next_mc_bits = vicii.regs[0x1c];
@@ -299,7 +403,7 @@ VICII::drawSprites()
     drawSpritePixel(6, spriteDisplay, firstDMA | secondDMA);
     
     // Update multicolor bits if an old VICII is emulated
-    if (toggle && is656x()) {
+    if (toggle && !(type & VIC856X_CYCLE)) {
         
         reg.delayed.sprMC = reg.current.sprMC;
         for (unsigned i = 0; i < 8; i++) {
@@ -312,33 +416,37 @@ VICII::drawSprites()
     drawSpritePixel(7, spriteDisplay, firstDMA);
     
     // Check for collisions
+    u8 ssMask = 0, sbMask = 0;
+    u16 *source = pixelSource + bufferoffset;
     for (unsigned i = 0; i < 8; i++) {
         
-        int index = bufferoffset + i;
+        u8 sprites = source[i] & 0xFF;
         
-        // Check if two or more bits are set in pixelSource
-        if (pixelSource[index] & (pixelSource[index] - 1)) {
-            
-            // Is it a sprite/sprite collision?
-            if ((pixelSource[index] & 0xFF) & ((pixelSource[index] & 0xFF) - 1)) {
-                
-                // Trigger an IRQ if this is the first detected collision
-                if (!spriteSpriteCollision) {
-                    triggerIrq(4);
-                }
-                spriteSpriteCollision |= (pixelSource[index] & 0xFF);
-            }
-            
-            // Is it a sprite/background collision?
-            if ((pixelSource[index] & 0x100) && config.checkSBCollisions) {
-                
-                // Trigger an IRQ if this is the first detected collision
-                if (!spriteBackgroundColllision) {
-                    triggerIrq(2);
-                }
-                spriteBackgroundColllision |= (pixelSource[index] & 0xFF);
-            }
+        // Collect all sprites sharing a pixel with another sprite
+        ssMask |= (sprites & (sprites - 1)) ? sprites : 0;
+        
+        // Collect all sprites sharing a pixel with the foreground
+        sbMask |= (source[i] & 0x100) ? sprites : 0;
+    }
+    
+    // Is there a sprite/sprite collision?
+    if (ssMask) {
+        
+        // Trigger an IRQ if this is the first detected collision
+        if (!spriteSpriteCollision) {
+            triggerIrq(4);
+        }
+        spriteSpriteCollision |= ssMask;
+    }
+    
+    // Is there a sprite/background collision?
+    if (sbMask && config.checkSBCollisions) {
+        
+        // Trigger an IRQ if this is the first detected collision
+        if (!spriteBackgroundColllision) {
+            triggerIrq(2);
         }
+        spriteBackgroundColllision |= sbMask;
     }
 }
 
@@ -352,9 +460,10 @@ VICII::drawSpritePixel(unsigned pixel,
         return;
     }
     
-    // Iterate over all sprites
-    for (unsigned sprite = 0; sprite < 8; sprite++) {
+    // Iterate over all sprites that are enabled or still shifting out data
+    for (u8 mask = enableBits | spriteSrActive; mask; mask &= mask - 1) {
         
+        unsigned sprite = __builtin_ctz(mask);
         bool enable = GET_BIT(enableBits, sprite);
         bool freeze = GET_BIT(freezeBits, sprite);
         bool mCol = GET_BIT(reg.delayed.sprMC, sprite);
@@ -509,7 +618,8 @@ VICII::setSpritePixel(unsigned sprite, unsigned pixel, u8 color)
     u8 source = (1 << sprite);
     int index = bufferoffset + pixel;
     
-    if (depth <= zBuffer[index]) {
+    // Sprite pixels in the VBLANK area only matter for collision detection
+    if (rendering && !vblank && depth <= zBuffer[index]) {
         
         /* "the interesting case is when eg sprite 1 and sprite 0 overlap, and
          *  sprite 0 has the priority bit set (and sprite 1 has not). in this
@@ -567,3 +677,18 @@ VICII::cutLayers()
         }
     }
 }
+
+
+//
+// Instantiate template functions
+//
+
+template void VICII::draw<PAL_CYCLE>();
+template void VICII::draw17<PAL_CYCLE>();
+template void VICII::draw55<PAL_CYCLE>();
+template void VICII::drawSprites<PAL_CYCLE>();
+
+template void VICII::draw<VIC856X_CYCLE>();
+template void VICII::draw17<VIC856X_CYCLE>();
+template void VICII::draw55<VIC856X_CYCLE>();
+template void VICII::drawSprites<VIC856X_CYCLE>();
@@ -55,6 +55,8 @@ VICII::setUltimax(bool value) {
         memSrc[0xE] = M_RAM;
         memSrc[0xF] = M_RAM;
     }
+    
+    updateBankPages();
 }
 
 void
@@ -108,11 +110,43 @@ VICII::switchBank(u16 addr) {
     delay |= VICUpdateBankAddr;
 }
 
+void
+VICII::updateBankAddr(u8 bank)
+{
+    assert(bank < 4);
+    
+    bankAddr = bank << 14;
+    updateBankPages();
+}
+
 void
 VICII::updateBankAddr()
 {
     updateBankAddr(~cia2.getPA() & 0x03);
 }
+
+void
+VICII::updateBankPages()
+{
+    for (isize i = 0; i < 4; i++) {
+        
+        u16 addr = (u16)(bankAddr | i << 12);
+        
+        switch (memSrc[addr >> 12]) {
+                
+            case M_CHAR:
+                bankPages[i] = mem.rom + 0xC000 + (i << 12);
+                break;
+                
+            case M_CRTHI:
+                bankPages[i] = nullptr;
+                break;
+                
+            default:
+                bankPages[i] = mem.ram + addr;
+        }
+    }
+}
     
 u8
 VICII::peek(u16 addr)
@@ -624,20 +658,11 @@ VICII::memAccess(u16 addr)
     assert((bankAddr & 0x3FFF) == 0); // multiple of 16 KB
     
     addrBus = bankAddr | addr;
-    switch (memSrc[addrBus >> 12]) {
-            
-        case M_RAM:
-            return mem.ram[addrBus];
-            
-        case M_CHAR:
-            return mem.rom[0xC000 + addr];
-
-        case M_CRTHI:
-            return expansionport.peek(addrBus | 0xF000);
-            
-        default:
-            return mem.ram[addrBus];
-    }
+    
+    // Pages mapped to RAM or the Character Rom are read directly
+    if (const u8 *page = bankPages[addr >> 12]) return page[addr & 0xFFF];
+    
+    return expansionport.peek(addrBus | 0xF000);
 }
 
 u8
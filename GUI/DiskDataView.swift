@@ -63,14 +63,14 @@ class DiskDataView: NSScrollView {
                     if inspector.rawGcr || sector == nil {
                         
                         // Show the raw GCR stream
-                        gcr = String(cString: disk.trackBitsAsString())
+                        gcr = trackBits()
                         
                     } else {
                         
                         // Show the decoded GCR data of the currently selected sector
-                        gcr = String(cString: disk.sectorHeaderBytes(asString: sector!, hex: hex))
+                        gcr = sectorBytes(sector!, header: true)
                         gcr.append("\n\n")
-                        gcr.append(String(cString: disk.sectorDataBytes(asString: sector!, hex: hex)))
+                        gcr.append(sectorBytes(sector!, header: false))
                     }
                 }
                 
@@ -95,6 +95,32 @@ class DiskDataView: NSScrollView {
         }
     }
     
+    // Converts the raw GCR stream of the analyzed track into a bit string
+    func trackBits() -> String {
+        
+        let length = disk.trackLength()
+        var bytes = [UInt8](repeating: 0, count: (length + 7) / 8)
+        disk.trackBytes(&bytes, offset: 0, count: bytes.count)
+        
+        var bits = [UInt8](repeating: 0, count: length)
+        for i in 0 ..< length {
+            bits[i] = (bytes[i / 8] & (0x80 >> (i % 8))) != 0 ? 0x31 : 0x30
+        }
+        return String(decoding: bits, as: UTF8.self)
+    }
+    
+    // Formats the decoded header or data block of a sector
+    func sectorBytes(_ nr: Sector, header: Bool) -> String {
+        
+        var bytes = [UInt8](repeating: 0, count: 256)
+        let count = header ?
+            disk.sectorHeaderBytes(nr, buffer: &bytes) :
+            disk.sectorDataBytes(nr, buffer: &bytes)
+        
+        let format = hex ? "%02X" : "%03d"
+        return bytes[0 ..< count].map { String(format: format, $0) }.joined(separator: " ")
+    }
+    
     func markHead() {
         
         unmarkHead()
@@ -65,6 +65,12 @@ class VC64Error: Error {
             return "The file system has cyclic references."
         case .FS_CANT_IMPORT:
             return "Failed to import the file system."
+        case .GUARD_SYNTAX:
+            return "The condition is not a valid expression."
+        case .REC_LAUNCH:
+            return "Failed to launch FFmpeg. Please make sure it is installed."
+        case .OPT_INV_ARG:
+            return "Invalid configuration value."
         case .FS_EXPECTED_VAL,
              .FS_EXPECTED_MIN,
              .FS_EXPECTED_MAX:
@@ -67,6 +67,10 @@ public class MacAudio: NSObject {
         // Inform SID about the sample rate
         sid.setSampleRate(sampleRate)
         
+        // Let the mixer produce the samples in the format of the render callback
+        let layout = stereo ? AudioLayout.STEREO : AudioLayout.MONO
+        controller.c64.configure(.AUDIO_LAYOUT, value: layout.rawValue)
+        
         // Register render callback
         if stereo {
             audiounit.outputProvider = { ( // AURenderPullInputBlock
@@ -103,6 +103,29 @@ class Renderer: NSObject, MTKViewDelegate {
      */
     var emulatorTexture: MTLTexture! = nil
 
+    /* Color index texture and palette. If the emulator delivers a frame in
+     * indexed format, the raw color indices are uploaded into the index
+     * texture. They are translated into the emulator texture on the GPU by
+     * looking them up in the palette texture (256 x 1 RGBA values).
+     */
+    var indexTexture: MTLTexture! = nil
+    var paletteTexture: MTLTexture! = nil
+    var palette = [UInt32](repeating: 0, count: 256)
+    
+    // Indicates that the emulator texture needs to be computed on the GPU
+    var colorize = false
+    
+    /* Texture buffers shared with the emulator. VICII draws directly into
+     * these buffers. If a frame is handed out in one of them, the GPU copies
+     * the changed lines into the emulator texture or the index texture. This
+     * saves the copy on the CPU.
+     */
+    var emuBuffers: [MTLBuffer] = []
+    var idxBuffers: [MTLBuffer] = []
+    
+    // Lines to be copied out of a shared buffer in the next frame
+    var upload: (buffer: MTLBuffer, texture: MTLTexture, first: Int, count: Int)?
+
     /* Bloom textures. To emulate a bloom effect, the emulator texture is first
      * split into it's R, G, and B parts. Each texture is then run through a
      * Gaussian blur filter with a large radius. These blurred textures are
@@ -142,6 +165,9 @@ class Renderer: NSObject, MTKViewDelegate {
     // Array holding all available scanline filters
     var scanlineFilterGallery = [ComputeKernel?](repeating: nil, count: 3)
 
+    // Kernel translating the index texture into the emulator texture
+    var colorizer: ComputeKernel!
+
     // Array holding dotmask preview images
     var dotmaskImages = [NSImage?](repeating: nil, count: 5)
 
@@ -217,22 +243,55 @@ class Renderer: NSObject, MTKViewDelegate {
     
     func updateTexture() {
         
-        let buf = parent.c64.vic.stableEmuTexture()
+        let vic = parent.c64.vic!
+        var indexed = ObjCBool(false)
+        
+        // Pick up the latest frame (once per drawn frame)
+        vic.acquireTexture()
+        let buf = vic.stableTexture(&indexed)
         precondition(buf != nil)
         
-        let pixelSize = 4
+        // Only upload the lines that have changed since the last frame
+        if vic.dirtyLineCount() == 0 { return }
+        
+        var first = 0, last = TEX_HEIGHT - 1
+        while !vic.isDirty(first) { first += 1 }
+        while !vic.isDirty(last) { last -= 1 }
+        
+        let pixelSize = indexed.boolValue ? 1 : 4
         // let width = Int(NTSC_WIDTH)
         // let height = Int(PAL_HEIGHT)
         let rowBytes = TEX_WIDTH * pixelSize
-        let imageBytes = rowBytes * TEX_HEIGHT
-        let region = MTLRegionMake2D(0, 0, TEX_WIDTH, TEX_HEIGHT)
-        
-        emulatorTexture.replace(region: region,
-                                mipmapLevel: 0,
-                                slice: 0,
-                                withBytes: buf!,
-                                bytesPerRow: rowBytes,
-                                bytesPerImage: imageBytes)
+        let imageBytes = rowBytes * (last - first + 1)
+        let region = MTLRegionMake2D(0, first, TEX_WIDTH, last - first + 1)
+        let texture: MTLTexture = indexed.boolValue ? indexTexture : emulatorTexture
+        
+        if indexed.boolValue {
+            
+            // Upload the color indices and let the GPU translate them
+            vic.palette(&palette)
+            paletteTexture.replace(region: MTLRegionMake1D(0, 256),
+                                   mipmapLevel: 0,
+                                   withBytes: palette,
+                                   bytesPerRow: 256 * 4)
+            colorize = true
+        }
+        
+        // Check if the frame has been drawn into a shared buffer
+        let buffers = indexed.boolValue ? idxBuffers : emuBuffers
+        if let buffer = buffers.first(where: { UnsafeRawPointer($0.contents()) == buf! }) {
+            
+            upload = (buffer, texture, first, last - first + 1)
+            
+        } else {
+            
+            texture.replace(region: region,
+                            mipmapLevel: 0,
+                            slice: 0,
+                            withBytes: buf! + first * rowBytes,
+                            bytesPerRow: rowBytes,
+                            bytesPerImage: imageBytes)
+        }
     }
     
     var maxTextureRect: CGRect {
@@ -378,6 +437,31 @@ class Renderer: NSObject, MTKViewDelegate {
         fragmentUniforms.dotMaskWidth = Int32(dotMaskTexture.width)
         fragmentUniforms.scanlineDistance = Int32(size.height / 256)
        
+        // Copy the changed lines out of the shared buffer
+        if let upload = upload {
+            
+            let rowBytes = upload.buffer.length / TEX_HEIGHT
+            let blit = commandBuffer.makeBlitCommandEncoder()!
+            blit.copy(from: upload.buffer,
+                      sourceOffset: upload.first * rowBytes,
+                      sourceBytesPerRow: rowBytes,
+                      sourceBytesPerImage: upload.count * rowBytes,
+                      sourceSize: MTLSizeMake(TEX_WIDTH, upload.count, 1),
+                      to: upload.texture,
+                      destinationSlice: 0,
+                      destinationLevel: 0,
+                      destinationOrigin: MTLOriginMake(0, upload.first, 0))
+            blit.endEncoding()
+            self.upload = nil
+        }
+        
+        // Translate color indices into RGBA values
+        if colorize {
+            colorizer.apply(commandBuffer: commandBuffer,
+                            textures: [indexTexture, paletteTexture, emulatorTexture])
+            colorize = false
+        }
+        
         // Compute the bloom textures
         if shaderOptions.bloom != 0 {
             let bloomFilter = currentBloomFilter()
@@ -574,6 +658,9 @@ class Renderer: NSObject, MTKViewDelegate {
     public func cleanup() {
     
         track()
+        
+        // Let the emulator draw into its own buffers again
+        parent.c64.vic.setTextureBuffers(nil, idx: nil)
     }
 
     //
@@ -75,9 +75,32 @@ extension Renderer {
         assert(bgFullscreenTexture != nil, "Failed to create bgFullscreenTexture")
 
         // Emulator texture (long frames)
-        emulatorTexture = device.makeTexture(size: TextureSize.original, usage: r)
+        emulatorTexture = device.makeTexture(size: TextureSize.original, usage: rwt)
         assert(emulatorTexture != nil, "Failed to create emulatorTexture")
         
+        // Color index texture and palette (indexed frames)
+        let idxDescriptor = MTLTextureDescriptor.texture2DDescriptor(
+            pixelFormat: MTLPixelFormat.r8Uint,
+            width: TextureSize.original.width,
+            height: TextureSize.original.height,
+            mipmapped: false)
+        idxDescriptor.usage = r
+        indexTexture = device.makeTexture(descriptor: idxDescriptor)
+        assert(indexTexture != nil, "Failed to create indexTexture")
+        
+        paletteTexture = device.makeTexture(w: 256, h: 1, usage: r)
+        assert(paletteTexture != nil, "Failed to create paletteTexture")
+        
+        // Texture buffers shared with the emulator
+        let texels = TEX_WIDTH * TEX_HEIGHT
+        for _ in 0 ..< 3 {
+            emuBuffers.append(device.makeBuffer(length: 4 * texels, options: .storageModeShared)!)
+            idxBuffers.append(device.makeBuffer(length: texels, options: .storageModeShared)!)
+        }
+        var emu = emuBuffers.map { Optional($0.contents().assumingMemoryBound(to: Int32.self)) }
+        var idx = idxBuffers.map { Optional($0.contents().assumingMemoryBound(to: UInt8.self)) }
+        parent.c64.vic.setTextureBuffers(&emu, idx: &idx)
+        
         // Build bloom textures
         bloomTextureR = device.makeTexture(size: TextureSize.original, usage: rwt)
         bloomTextureG = device.makeTexture(size: TextureSize.original, usage: rwt)
@@ -142,9 +165,12 @@ extension Renderer {
             disalignmentV: config.disalignmentV
         )
         
-        // let oc = (TextureSize.original.width, TextureSize.original.height)
+        let oc = (TextureSize.original.width, TextureSize.original.height)
         let uc = (TextureSize.upscaled.width, TextureSize.upscaled.width)
 
+        // Build the color index translator
+        colorizer = Colorizer.init(device: device, library: library, cutout: oc)
+
         // Build upscalers
         upscalerGallery[0] = BypassUpscaler.init(device: device, library: library, cutout: uc)
         upscalerGallery[1] = EPXUpscaler.init(device: device, library: library, cutout: uc)
@@ -189,6 +189,20 @@ fragment half4 fragment_main(ProjectedVertex vert [[ stage_in ]],
 }
 
 
+//
+// Color index translator
+//
+
+kernel void colorize(texture2d<uint, access::read>  indices     [[ texture(0) ]],
+                     texture2d<half, access::read>  palette     [[ texture(1) ]],
+                     texture2d<half, access::write> outTexture  [[ texture(2) ]],
+                     uint2                          gid         [[ thread_position_in_grid ]])
+{
+    uint index = indices.read(gid).r;
+    outTexture.write(palette.read(uint2(index, 0)), gid);
+}
+
+
 //
 // Texture upscalers
 //
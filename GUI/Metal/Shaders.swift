@@ -217,6 +217,18 @@ class BypassFilter: ComputeKernel {
     }
 }
 
+//
+// Color index translator
+//
+
+class Colorizer: ComputeKernel {
+    
+    convenience init?(device: MTLDevice, library: MTLLibrary, cutout: (Int, Int)) {
+        self.init(name: "colorize",
+                  device: device, library: library, cutout: cutout)
+    }
+}
+
 //
 // Upscalers
 //
@@ -481,9 +481,12 @@ extension MyController {
         // Animate the inspector
         if inspector?.window?.isVisible == true { inspector!.continuousRefresh() }
         
+        // Get the status information published by the emulator thread
+        let status = c64.status()
+        
         // Update the cartridge LED
-        if c64.expansionport.hasLed() {
-            let led = c64.expansionport.led() ? 1 : 0
+        if status.hasCartridgeLED {
+            let led = status.cartridgeLED ? 1 : 0
             if crtIcon.tag != led {
                 crtIcon.tag = led
                 crtIcon.image = NSImage(named: led == 1 ? "crtLedOnTemplate" : "crtTemplate")
@@ -498,7 +501,7 @@ extension MyController {
              * not switched on or off by push notification (message), because
              * some games continously switch the datasette motor on and off.
              */
-            if c64.datasette.motor && c64.datasette.playKey {
+            if status.tapeMotor && status.playKey {
                 tapeProgress.startAnimation(self)
             } else {
                 tapeProgress.stopAnimation(self)
@@ -508,7 +511,7 @@ extension MyController {
         // Do even less frequently...
         if (animationCounter % 4) == 0 {
             
-            updateSpeedometer()
+            updateSpeedometer(cycle: Int64(status.cycle))
             
             // Let the cursor disappear in fullscreen mode
             if renderer.fullscreen &&
@@ -521,9 +524,9 @@ extension MyController {
         timerLock.unlock()
     }
     
-    func updateSpeedometer() {
+    func updateSpeedometer(cycle: Int64) {
         
-        speedometer.updateWith(cycle: c64.cpu.cycle(), frame: renderer.frames)
+        speedometer.updateWith(cycle: cycle, frame: renderer.frames)
         let mhz = speedometer.mhz
         let fps = speedometer.fps
         clockSpeed.stringValue = String(format: "%.2f MHz %.0f fps", mhz, fps)
@@ -631,7 +634,8 @@ extension MyController {
             inspector?.fullRefresh()
             inspector?.scrollToPC()
             
-        case .CPU_JAMMED:
+        case .CPU_JAMMED,
+             .GUEST_EXIT:
             
             refreshStatusBar()
             
@@ -774,7 +778,12 @@ extension MyController {
             renderer.updateTextureRect()
             hideOrShowDriveMenus()
             refreshStatusBar()
-            
+
+        case .PERF:
+
+            // Performance counters are picked up by monitoring tools
+            break
+
         default:
             
             track("Unknown message: \(msg)")
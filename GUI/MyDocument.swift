@@ -352,6 +352,11 @@ class MyDocument: NSDocument {
 
         track("disk: \(disk) to: \(url)")
         
+        // Only write the modified tracks if the image already exists
+        if FileManager.default.fileExists(atPath: url.path) && writeBack(disk: disk, to: url) {
+            return
+        }
+        
         if url.c64FileType == .G64 {
          
             let g64 = try Proxy.make(disk: disk) as G64FileProxy
@@ -364,6 +369,26 @@ class MyDocument: NSDocument {
         }
     }
     
+    func writeBack(disk: DiskProxy, to url: URL) -> Bool {
+        
+        var err = ErrorCode.OK
+        
+        switch url.c64FileType {
+        
+        case .D64:
+            _ = D64FileProxy.writeBack(disk, path: url.path, error: &err)
+            
+        case .G64:
+            _ = G64FileProxy.writeBack(disk, path: url.path, error: &err)
+            
+        default:
+            return false
+        }
+        
+        track("Write-back to \(url): \(err)")
+        return err == .OK
+    }
+    
     func export(fs: FSDeviceProxy, to url: URL) throws {
 
         func showMultipleFilesAlert(format: String) {
@@ -12,6 +12,7 @@ class WaveformView: NSView {
     @IBOutlet weak var inspector: Inspector!
     
     var sid: SIDProxy { return inspector.c64.sid }
+    var selectedSID: Int { return inspector.sidSelector.indexOfSelectedItem }
     var running: Bool { return inspector.c64.running }
     
     // Remembers the highest amplitude (used for auto scaling)
@@ -20,6 +21,9 @@ class WaveformView: NSView {
     // Modulo counter to trigger image rendering
     var delayCounter = 0
     
+    // Waveform envelope (one bin per pixel column)
+    var bins: [WaveformBin] = []
+    
     required init?(coder decoder: NSCoder) {
         super.init(coder: decoder)
     }
@@ -51,26 +55,26 @@ class WaveformView: NSView {
         let normalizer = highestAmplitude
         highestAmplitude = 0.001
 
-        var l = Float(0)
-        var r = Float(0)
+        // Get the envelope recorded by the emulator
+        if bins.count != w { bins = Array(repeating: WaveformBin(min: 0, max: 0), count: w) }
+        let count = sid.getWaveform(selectedSID, bins: &bins, count: w)
         
-        for x in 0...w {
+        for x in 0..<count {
             
-            sid.ringbufferData(40 * x, left: &l, right: &r)
+            let lo = Float(bins[x].min), hi = Float(bins[x].max)
             
             // Scale samples and determine the highest amplitude
-            let absl = abs(l), absr = abs(r)
-            var scaledl = absl / normalizer * baseline
-            var scaledr = absr / normalizer * baseline
-            highestAmplitude = max(highestAmplitude, max(absl, absr))
+            var scaledHi = hi / normalizer * baseline
+            var scaledLo = lo / normalizer * baseline
+            highestAmplitude = max(highestAmplitude, max(abs(lo), abs(hi)))
 
             // Apply some eye candy (artifical noise)
-            if scaledl == 0 { scaledl = (running && drand48() > 0.5) ? 1.0 : 0.0 }
-            if scaledr == 0 { scaledr = (running && drand48() > 0.5) ? 1.0 : 0.0 }
+            if scaledHi == 0 { scaledHi = (running && drand48() > 0.5) ? 1.0 : 0.0 }
+            if scaledLo == 0 { scaledLo = (running && drand48() > 0.5) ? -1.0 : 0.0 }
 
             // Draw bars
-            let from = CGPoint(x: x, y: Int(baseline + scaledl + 1))
-            let to = CGPoint(x: x, y: Int(baseline - scaledr))
+            let from = CGPoint(x: x, y: Int(baseline + scaledHi + 1))
+            let to = CGPoint(x: x, y: Int(baseline + scaledLo))
             context?.move(to: from)
             context?.addLine(to: to)
         }
@@ -40,6 +40,14 @@ extension MyController: NSWindowDelegate {
         }
     }
     
+    public func windowDidChangeOcclusionState(_ notification: Notification) {
+        
+        guard let window = notification.object as? NSWindow else { return }
+        
+        // Let the emulator save power while the window can't be seen
+        if c64 != nil { c64.hidden = !window.occlusionState.contains(.visible) }
+    }
+    
     public func windowWillClose(_ notification: Notification) {
         
         track()
@@ -82,6 +82,8 @@
     DatasetteProxy *datasette;
     DriveProxy *drive8;
     DriveProxy *drive9;
+    DriveProxy *drive10;
+    DriveProxy *drive11;
     ExpansionPortProxy *expansionport;
     GuardsProxy *breakpoints;
     GuardsProxy *watchpoints;
@@ -101,6 +103,8 @@
 @property (readonly, strong) DatasetteProxy *datasette;
 @property (readonly, strong) DriveProxy *drive8;
 @property (readonly, strong) DriveProxy *drive9;
+@property (readonly, strong) DriveProxy *drive10;
+@property (readonly, strong) DriveProxy *drive11;
 @property (readonly, strong) ExpansionPortProxy *expansionport;
 @property (readonly, strong) GuardsProxy *breakpoints;
 @property (readonly, strong) GuardsProxy *watchpoints;
@@ -119,12 +123,14 @@
 @property BOOL warp;
 @property BOOL debugMode;
 @property InspectionTarget inspectionTarget;
+@property BOOL hidden;
 
 - (BOOL)isReady:(ErrorCode *)ec;
 - (BOOL)isReady;
 - (void)powerOn;
 - (void)powerOff;
 - (void)inspect;
+- (C64Status)status;
 - (void)reset;
 
 @property (readonly) BOOL poweredOn;
@@ -137,6 +143,11 @@
 - (void)suspend;
 - (void)resume;
 
+- (HeadlessExit)runHeadless:(HeadlessBudget)budget;
+- (HeadlessExit)runFrames:(NSInteger)frames;
+- (HeadlessExit)runUntilCycle:(NSInteger)cycle;
+- (HeadlessExit)runUntilPC:(NSInteger)pc frames:(NSInteger)frames;
+
 - (void)requestAutoSnapshot;
 - (void)requestUserSnapshot;
 @property (readonly) SnapshotProxy *latestAutoSnapshot;
@@ -144,6 +155,14 @@
 - (void)loadFromSnapshot:(SnapshotProxy *)proxy;
 
 @property (readonly) C64Configuration config;
+@property (readonly) OscillatorStats oscillatorStats;
+@property (readonly) PacingStats pacingStats;
+- (NSInteger)frameTimings:(FrameTiming *)buffer count:(NSInteger)count;
+- (void)clearOscillatorStats;
+@property (readonly) ProfilerStats profilerStats;
+- (void)clearProfilerStats;
+- (BOOL)saveProfile:(NSString *)path error:(ErrorCode *)err;
+@property (readonly) PerfCounters perfCounters;
 - (NSInteger)getConfig:(Option)opt;
 - (NSInteger)getConfig:(Option)opt id:(NSInteger)id;
 - (NSInteger)getConfig:(Option)opt drive:(DriveID)id;
@@ -154,14 +173,18 @@
 - (BOOL)configure:(Option)opt drive:(DriveID)id value:(NSInteger)val;
 - (BOOL)configure:(Option)opt drive:(DriveID)id enable:(BOOL)val;
 - (void)configure:(C64Model)value;
+- (ErrorCode)configure:(const ConfigItem *)items count:(NSInteger)count;
 
 - (Message)message;
 - (void)addListener:(const void *)sender function:(Callback *)func;
 - (void)removeListener:(const void *)sender;
+- (void)setAsyncMessages:(BOOL)enable;
+- (void)issue:(Cmd)cmd;
 
 - (void)stopAndGo;
 - (void)stepInto;
 - (void)stepOver;
+- (BOOL)stepBack:(NSInteger)count;
 
 - (BOOL) hasRom:(RomType)type;
 - (BOOL) hasMega65Rom:(RomType)type;
@@ -169,9 +192,17 @@
 - (BOOL) isRom:(RomType)type url:(NSURL *)url;
 
 - (void) loadRom:(RomFileProxy *)proxy;
+- (void) loadRomAsync:(NSURL *)url;
+- (void) insertDiskAsync:(NSURL *)url drive:(DriveID)id;
+- (void) attachCartridgeAsync:(NSURL *)url reset:(BOOL)reset;
+- (NSInteger) waitForMedia;
 - (void) saveRom:(RomType)type url:(NSURL *)url error:(ErrorCode *)ec;
 - (void) deleteRom:(RomType)type;
 
+@property (readonly) BOOL recording;
+- (void) startRecording:(NSURL *)url error:(ErrorCode *)ec;
+- (void) stopRecording;
+
 - (RomIdentifier) romIdentifier:(RomType)type;
 - (BOOL)isCommodoreRom:(RomIdentifier)rev;
 - (BOOL)isPatchedRom:(RomIdentifier)rev;
@@ -200,6 +231,8 @@
 - (void)disable:(NSInteger)nr;
 - (void)remove:(NSInteger)nr;
 - (void)replace:(NSInteger)nr addr:(NSInteger)addr;
+- (NSString *)condition:(NSInteger)nr;
+- (void)setCondition:(NSInteger)nr expression:(NSString *)expr error:(ErrorCode *)err;
 
 - (BOOL)isSetAt:(NSInteger)addr;
 - (BOOL)isSetAndEnabledAt:(NSInteger)addr;
@@ -225,6 +258,18 @@
 - (void)clearLog;
 - (bool)isJammed;
 
+- (void)startTrace:(NSString *)path error:(ErrorCode *)err;
+- (void)stopTrace;
+- (BOOL)isTracing;
+
+- (void)startProfiling;
+- (void)stopProfiling;
+- (void)clearProfile;
+- (BOOL)isProfiling;
+- (NSInteger)profiledCycles:(NSInteger)addr;
+- (NSInteger)profiledOpcodeCycles:(NSInteger)opcode;
+- (NSInteger)profiledOpcodeCount:(NSInteger)opcode;
+
 - (void)setHex;
 - (void)setDec;
 
@@ -257,6 +302,8 @@
 - (u8)spypeek:(u16)addr;
 - (u8)spypeekIO:(u16)addr;
 - (u8)spypeekColor:(u16)addr;
+- (void)spypeek:(u8 *)buffer addr:(u16)addr count:(NSInteger)count source:(MemoryType)source;
+- (BOOL)view:(u8 *)buffer addr:(u16)addr count:(NSInteger)count source:(MemoryType)source;
 
 - (NSString *)memdump:(NSInteger)addr num:(NSInteger)num hex:(BOOL)hex src:(MemoryType)src;
 - (NSString *)txtdump:(NSInteger)addr num:(NSInteger)num src:(MemoryType)src;
@@ -283,7 +330,16 @@
 @interface VICProxy : HardwareComponentProxy { }
 
 - (BOOL)isPAL;
+- (BOOL)acquireTexture;
 - (void *)stableEmuTexture;
+- (const void *)stableTexture:(BOOL *)indexed;
+- (void)setTextureBuffers:(int **)emu idx:(u8 **)idx;
+- (void)palette:(u32 *)lut;
+- (void)requestFrame;
+- (BOOL)isDirty:(NSInteger)line;
+- (NSInteger)dirtyLineCount;
+- (NSInteger)droppedFrames;
+- (NSInteger)duplicatedFrames;
 - (NSColor *)color:(NSInteger)nr;
 - (UInt32)rgbaColor:(NSInteger)nr palette:(Palette)palette;
 - (double)brightness;
@@ -295,6 +351,8 @@
 
 - (VICIIInfo)getInfo;
 - (SpriteInfo)getSpriteInfo:(NSInteger)sprite;
+- (void)screenText:(ScreenText *)text;
+- (BOOL)preview:(u32 *)buffer width:(NSInteger)width height:(NSInteger)height;
 
 - (u32 *)noise;
 
@@ -315,6 +373,7 @@
 
 - (NSInteger)ringbufferSize;
 - (void)ringbufferData:(NSInteger)offset left:(float *)l right:(float *)r;
+- (NSInteger)getWaveform:(NSInteger)nr bins:(WaveformBin *)bins count:(NSInteger)count;
 - (double)fillLevel;
 - (NSInteger)bufferUnderflows;
 - (NSInteger)bufferOverflows;
@@ -362,6 +421,7 @@
 - (void)scheduleKeyRelease:(NSInteger)nr delay:(NSInteger)delay;
 - (void)scheduleKeyReleaseAtRow:(NSInteger)row col:(NSInteger)col delay:(NSInteger)delay;
 - (void)scheduleKeyReleaseAll:(NSInteger)delay;
+- (void)type:(NSString *)text;
 
 @end
 
@@ -389,8 +449,13 @@
 
 - (BOOL)cartridgeAttached;
 - (CartridgeType)cartridgeType;
+@property (readonly) CartridgeStats stats;
+- (void)clearStats;
 - (BOOL)attachCartridge:(CRTFileProxy *)c reset:(BOOL)reset;
+- (NSInteger)writeBack:(CRTFileProxy *)c error:(ErrorCode *)err;
 - (void)attachGeoRamCartridge:(NSInteger)capacity;
+- (void)attachGeoRamCartridge:(NSInteger)capacity url:(NSURL *)url error:(ErrorCode *)err;
+- (void)attachReuCartridge:(NSInteger)capacity;
 - (void)attachIsepicCartridge;
 - (void)detachCartridgeAndReset;
 
@@ -507,6 +572,11 @@
 - (NSInteger)firstErroneousBit:(NSInteger)nr;
 - (NSInteger)lastErroneousBit:(NSInteger)nr;
 - (SectorInfo)sectorInfo:(Sector)s;
+- (NSInteger)trackLength;
+- (NSInteger)trackBytes:(u8 *)buffer offset:(NSInteger)offset count:(NSInteger)count;
+- (void)annotateTrack:(u8 *)buffer offset:(NSInteger)offset count:(NSInteger)count;
+- (NSInteger)sectorHeaderBytes:(Sector)nr buffer:(u8 *)buffer;
+- (NSInteger)sectorDataBytes:(Sector)nr buffer:(u8 *)buffer;
 - (const char *)diskNameAsString;
 - (const char *)trackBitsAsString;
 - (const char *)sectorHeaderBytesAsString:(Sector)nr hex:(BOOL)hex;
@@ -720,11 +790,15 @@ AnyCollectionProxy <MakeWithFile, MakeWithBuffer, MakeWithFileSystem> { }
 //
 
 @interface D64FileProxy :
-AnyFileProxy <MakeWithFile, MakeWithBuffer, MakeWithFileSystem> { }
+AnyFileProxy <MakeWithFile, MakeWithBuffer, MakeWithFileSystem, MakeWithDisk> { }
 
 + (instancetype)makeWithFile:(NSString *)path error:(ErrorCode *)err;
 + (instancetype)makeWithBuffer:(const void *)buf length:(NSInteger)len error:(ErrorCode *)err;
 + (instancetype)makeWithFileSystem:(FSDeviceProxy *)proxy error:(ErrorCode *)err;
++ (instancetype)makeWithDisk:(DiskProxy *)proxy error:(ErrorCode *)err;
+
+// Writes the modified tracks of a disk into an existing D64 file
++ (NSInteger)writeBack:(DiskProxy *)proxy path:(NSString *)path error:(ErrorCode *)err;
 
 @end
 
@@ -739,6 +813,9 @@ AnyFileProxy <MakeWithFile, MakeWithBuffer, MakeWithDisk> { }
 + (instancetype) makeWithBuffer:(const void *)buf length:(NSInteger)len error:(ErrorCode *)err;
 + (instancetype) makeWithDisk:(DiskProxy *)diskProxy error:(ErrorCode *)err;
 
+// Writes the modified halftracks of a disk into an existing G64 file
++ (NSInteger) writeBack:(DiskProxy *)diskProxy path:(NSString *)path error:(ErrorCode *)err;
+
 @end
 
 //
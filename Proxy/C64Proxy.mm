@@ -104,6 +104,16 @@
     [self guards]->replace(nr, (u32)addr);
 }
 
+- (NSString *)condition:(NSInteger)nr
+{
+    return @([self guards]->condition(nr).c_str());
+}
+
+- (void)setCondition:(NSInteger)nr expression:(NSString *)expr error:(ErrorCode *)err
+{
+    [self guards]->setCondition(nr, [expr UTF8String], err);
+}
+
 - (BOOL)isSetAt:(NSInteger)addr
 {
     return [self guards]->isSetAt((u32)addr);
@@ -187,6 +197,56 @@
     return [self cpu]->isJammed();
 }
 
+- (void)startTrace:(NSString *)path error:(ErrorCode *)err
+{
+    [self cpu]->debugger.startTrace([path fileSystemRepresentation], err);
+}
+
+- (void)stopTrace
+{
+    [self cpu]->debugger.stopTrace();
+}
+
+- (BOOL)isTracing
+{
+    return [self cpu]->debugger.isTracing();
+}
+
+- (void)startProfiling
+{
+    [self cpu]->debugger.startProfiling();
+}
+
+- (void)stopProfiling
+{
+    [self cpu]->debugger.stopProfiling();
+}
+
+- (void)clearProfile
+{
+    [self cpu]->debugger.clearProfile();
+}
+
+- (BOOL)isProfiling
+{
+    return [self cpu]->debugger.isProfiling();
+}
+
+- (NSInteger)profiledCycles:(NSInteger)addr
+{
+    return (NSInteger)[self cpu]->debugger.profiledCycles((u16)addr);
+}
+
+- (NSInteger)profiledOpcodeCycles:(NSInteger)opcode
+{
+    return (NSInteger)[self cpu]->debugger.profiledOpcodeCycles((u8)opcode);
+}
+
+- (NSInteger)profiledOpcodeCount:(NSInteger)opcode
+{
+    return (NSInteger)[self cpu]->debugger.profiledOpcodeCount((u8)opcode);
+}
+
 - (void)setHex
 {
     [self cpu]->debugger.hex = true;
@@ -298,6 +358,18 @@
     return [self mem]->spypeekColor(addr);
 }
 
+- (void)spypeek:(u8 *)buffer addr:(u16)addr count:(NSInteger)count source:(MemoryType)source
+{
+    [self mem]->suspend();
+    [self mem]->spypeek(buffer, addr, count, source);
+    [self mem]->resume();
+}
+
+- (BOOL)view:(u8 *)buffer addr:(u16)addr count:(NSInteger)count source:(MemoryType)source
+{
+    return [self mem]->getView(buffer, addr, count, source);
+}
+
 /*
 - (void)poke:(u16)addr value:(u8)value target:(MemoryType)target
 {
@@ -377,11 +449,71 @@
     return [self vicii]->getSpriteInfo((unsigned)sprite);
 }
 
+- (void)screenText:(ScreenText *)text
+{
+    [self vicii]->suspend();
+    [self vicii]->getScreenText(*text);
+    [self vicii]->resume();
+}
+
+- (BOOL)preview:(u32 *)buffer width:(NSInteger)width height:(NSInteger)height
+{
+    return [self vicii]->getPreview(buffer, width, height);
+}
+
+- (BOOL)acquireTexture
+{
+    return [self vicii]->acquireTexture();
+}
+
 - (void *)stableEmuTexture
 {
     return [self vicii]->stableEmuTexture();
 }
 
+- (const void *)stableTexture:(BOOL *)indexed
+{
+    bool result;
+    const void *texture = [self vicii]->stableTexture(result);
+    *indexed = result;
+    return texture;
+}
+
+- (void)setTextureBuffers:(int **)emu idx:(u8 **)idx
+{
+    [self vicii]->setTextureBuffers(emu, idx);
+}
+
+- (void)palette:(u32 *)lut
+{
+    [self vicii]->getPalette(lut);
+}
+
+- (void)requestFrame
+{
+    [self vicii]->requestFrame();
+}
+
+- (BOOL)isDirty:(NSInteger)line
+{
+    return [self vicii]->isDirty(line);
+}
+
+- (NSInteger)dirtyLineCount
+{
+    return [self vicii]->dirtyLineCount();
+}
+
+- (NSInteger)droppedFrames
+{
+    return [self vicii]->getDroppedFrames();
+}
+
+- (NSInteger)duplicatedFrames
+{
+    return [self vicii]->getDuplicatedFrames();
+}
+
 - (NSColor *)color:(NSInteger)nr
 {
     assert (0 <= nr && nr < 16);
@@ -475,6 +607,11 @@
     [self bridge]->ringbufferData(offset, l, r);
 }
 
+- (NSInteger)getWaveform:(NSInteger)nr bins:(WaveformBin *)bins count:(NSInteger)count
+{
+    return [self bridge]->getWaveform((usize)nr, bins, (usize)count);
+}
+
 - (double)fillLevel
 {
     return [self bridge]->stream.fillLevel();
@@ -661,6 +798,11 @@
     [self kb]->scheduleKeyReleaseAll(delay);
 }
 
+- (void)type:(NSString *)text
+{
+    [self kb]->type(string([text UTF8String]));
+}
+
 @end
 
 //
@@ -712,16 +854,41 @@
     return [self eport]->getCartridgeAttached();
 }
 
+- (CartridgeStats)stats
+{
+    return [self eport]->getStats();
+}
+
+- (void)clearStats
+{
+    [self eport]->clearStats();
+}
+
 - (BOOL)attachCartridge:(CRTFileProxy *)c reset:(BOOL)reset
 {
     return [self eport]->attachCartridge((CRTFile *)c->obj, reset);
 }
 
+- (NSInteger)writeBack:(CRTFileProxy *)c error:(ErrorCode *)err
+{
+    return [self eport]->writeBack(*(CRTFile *)c->obj, err);
+}
+
 - (void)attachGeoRamCartridge:(NSInteger)capacity
 {
     [self eport]->attachGeoRamCartridge(capacity);
 }
 
+- (void)attachGeoRamCartridge:(NSInteger)capacity url:(NSURL *)url error:(ErrorCode *)err
+{
+    [self eport]->attachGeoRamCartridge(capacity, [url fileSystemRepresentation], err);
+}
+
+- (void)attachReuCartridge:(NSInteger)capacity
+{
+    [self eport]->attachReuCartridge(capacity);
+}
+
 - (void)attachIsepicCartridge
 {
     [self eport]->attachIsepicCartridge();
@@ -899,6 +1066,31 @@
     return [self disk]->sectorLayout(s);
 }
 
+- (NSInteger)trackLength
+{
+    return [self disk]->trackLength();
+}
+
+- (NSInteger)trackBytes:(u8 *)buffer offset:(NSInteger)offset count:(NSInteger)count
+{
+    return [self disk]->trackBytes(buffer, offset, count);
+}
+
+- (void)annotateTrack:(u8 *)buffer offset:(NSInteger)offset count:(NSInteger)count
+{
+    [self disk]->annotateTrack(buffer, offset, count);
+}
+
+- (NSInteger)sectorHeaderBytes:(Sector)nr buffer:(u8 *)buffer
+{
+    return [self disk]->sectorHeaderBytes(nr, buffer);
+}
+
+- (NSInteger)sectorDataBytes:(Sector)nr buffer:(u8 *)buffer
+{
+    return [self disk]->sectorDataBytes(nr, buffer);
+}
+
 - (const char *)trackBitsAsString
 {
     return [self disk]->trackBitsAsString();
@@ -1619,7 +1811,7 @@
 
 + (instancetype)makeWithFile:(NSString *)path error:(ErrorCode *)err
 {
-    return [self make: AnyFile::make <CRTFile> ([path fileSystemRepresentation], err)];
+    return [self make: AnyFile::map <CRTFile> ([path fileSystemRepresentation], err)];
 }
 
 + (instancetype)makeWithBuffer:(const void *)buf length:(NSInteger)len error:(ErrorCode *)err
@@ -1808,7 +2000,7 @@
 
 + (instancetype)makeWithFile:(NSString *)path error:(ErrorCode *)err
 {
-    return [self make: AnyFile::make <D64File> ([path fileSystemRepresentation], err)];
+    return [self make: AnyFile::map <D64File> ([path fileSystemRepresentation], err)];
 }
 
 + (instancetype)makeWithBuffer:(const void *)buf length:(NSInteger)len error:(ErrorCode *)err
@@ -1821,6 +2013,16 @@
     return [self make: AnyFile::make <D64File> (*(FSDevice *)proxy->obj, err)];
 }
 
++ (instancetype)makeWithDisk:(DiskProxy *)proxy error:(ErrorCode *)err
+{
+    return [self make: AnyFile::make <D64File> (*(Disk *)proxy->obj, err)];
+}
+
++ (NSInteger)writeBack:(DiskProxy *)proxy path:(NSString *)path error:(ErrorCode *)err
+{
+    return (NSInteger)D64File::writeBack(*(Disk *)proxy->obj, [path fileSystemRepresentation], err);
+}
+
 @end
 
 //
@@ -1836,7 +2038,7 @@
 
 + (instancetype)makeWithFile:(NSString *)path error:(ErrorCode *)err
 {
-    return [self make: AnyFile::make <G64File> ([path fileSystemRepresentation], err)];
+    return [self make: AnyFile::map <G64File> ([path fileSystemRepresentation], err)];
 }
 
 + (instancetype)makeWithBuffer:(const void *)buf length:(NSInteger)len error:(ErrorCode *)err
@@ -1850,6 +2052,11 @@
     return [self make: AnyFile::make <G64File> (*(Disk *)proxy->obj, err)];
 }
 
++ (NSInteger)writeBack:(DiskProxy *)proxy path:(NSString *)path error:(ErrorCode *)err
+{
+    return (NSInteger)G64File::writeBack(*(Disk *)proxy->obj, [path fileSystemRepresentation], err);
+}
+
 @end
 
 //
@@ -1889,7 +2096,7 @@
 
 @synthesize mem, cpu, breakpoints, watchpoints, vic, cia1, cia2, sid;
 @synthesize keyboard, port1, port2, iec;
-@synthesize expansionport, drive8, drive9, datasette;
+@synthesize expansionport, drive8, drive9, drive10, drive11, datasette;
 
 - (instancetype) init
 {
@@ -1915,6 +2122,8 @@
     expansionport = [[ExpansionPortProxy alloc] initWith:&c64->expansionport];
     drive8 = [[DriveProxy alloc] initWithVC1541:&c64->drive8];
     drive9 = [[DriveProxy alloc] initWithVC1541:&c64->drive9];
+    drive10 = [[DriveProxy alloc] initWithVC1541:&c64->drive10];
+    drive11 = [[DriveProxy alloc] initWithVC1541:&c64->drive11];
     datasette = [[DatasetteProxy alloc] initWith:&c64->datasette];
 
     return self;
@@ -1930,6 +2139,8 @@
     switch (id) {
         case DRIVE8:  return drive8;
         case DRIVE9:  return drive9;
+        case DRIVE10: return drive10;
+        case DRIVE11: return drive11;
         default:      return NULL;
     }
 }
@@ -1983,6 +2194,16 @@
     [self c64]->setInspectionTarget(target);
 }
 
+- (BOOL)hidden
+{
+    return [self c64]->oscillator.isHidden();
+}
+
+- (void)setHidden:(BOOL)value
+{
+    [self c64]->oscillator.setHidden(value);
+}
+
 - (BOOL)isReady:(ErrorCode *)err
 {
     return [self c64]->isReady(err);
@@ -2008,6 +2229,11 @@
     [self c64]->inspect();
 }
 
+- (C64Status)status
+{
+    return [self c64]->getStatus();
+}
+
 - (void)reset
 {
     [self c64]->reset();
@@ -2043,6 +2269,37 @@
     [self c64]->pause();
 }
 
+- (HeadlessExit)runHeadless:(HeadlessBudget)budget
+{
+    // Batch runs are executed on the calling thread
+    if ([self c64]->isRunning()) [self c64]->pause();
+    return [self c64]->runHeadless(budget);
+}
+
+- (HeadlessExit)runFrames:(NSInteger)frames
+{
+    HeadlessBudget budget = { };
+    budget.frames = frames;
+    return [self runHeadless:budget];
+}
+
+- (HeadlessExit)runUntilCycle:(NSInteger)cycle
+{
+    HeadlessBudget budget = { };
+    u64 now = [self c64]->cpu.cycle;
+    budget.cycles = (u64)cycle > now ? (u64)cycle - now : 1;
+    return [self runHeadless:budget];
+}
+
+- (HeadlessExit)runUntilPC:(NSInteger)pc frames:(NSInteger)frames
+{
+    HeadlessBudget budget = { };
+    budget.frames = frames;
+    budget.exitAtPC = true;
+    budget.pc = (u16)pc;
+    return [self runHeadless:budget];
+}
+
 - (void)suspend
 {
     [self c64]->suspend();
@@ -2085,6 +2342,55 @@
     return [self c64]->getConfig();
 }
 
+- (OscillatorStats)oscillatorStats
+{
+    return [self c64]->oscillator.getStats();
+}
+
+- (PacingStats)pacingStats
+{
+    return [self c64]->oscillator.getPacingStats();
+}
+
+- (NSInteger)frameTimings:(FrameTiming *)buffer count:(NSInteger)count
+{
+    return [self c64]->oscillator.getFrameTimings(buffer, count);
+}
+
+- (void)clearOscillatorStats
+{
+    [self c64]->oscillator.clearStats();
+}
+
+- (ProfilerStats)profilerStats
+{
+    return [self c64]->profiler.getStats();
+}
+
+- (void)clearProfilerStats
+{
+    [self c64]->suspend();
+    [self c64]->profiler.clear();
+    [self c64]->resume();
+}
+
+- (BOOL)saveProfile:(NSString *)path error:(ErrorCode *)err
+{
+    try {
+        [self c64]->profiler.writeToFile([path fileSystemRepresentation]);
+        *err = ERROR_OK;
+        return YES;
+    } catch (VC64Error &exception) {
+        *err = exception.errorCode;
+        return NO;
+    }
+}
+
+- (PerfCounters)perfCounters
+{
+    return [self c64]->perfMonitor.getCounters();
+}
+
 - (NSInteger)getConfig:(Option)opt
 {
     return [self c64]->getConfigItem(opt);
@@ -2135,6 +2441,11 @@
     [self c64]->configure(model);
 }
 
+- (ErrorCode)configure:(const ConfigItem *)items count:(NSInteger)count
+{
+    return [self c64]->configure(items, (usize)count);
+}
+
 - (Message)message
 {
     return [self c64]->getMessage();
@@ -2150,6 +2461,16 @@
     [self c64]->removeListener(sender);
 }
 
+- (void)setAsyncMessages:(BOOL)enable
+{
+    [self c64]->setMessageDelivery(enable ? MsgQueue::Delivery::thread : MsgQueue::Delivery::sync);
+}
+
+- (void)issue:(Cmd)cmd
+{
+    [self c64]->issue(cmd);
+}
+
 - (void)stopAndGo
 {
     [self c64]->stopAndGo();
@@ -2165,6 +2486,11 @@
     [self c64]->stepOver();
 }
 
+- (BOOL)stepBack:(NSInteger)count
+{
+    return [self c64]->stepBack(count);
+}
+
 - (BOOL) hasRom:(RomType)type
 {
     return [self c64]->hasRom(type);
@@ -2185,6 +2511,26 @@
     [self c64]->installRom((RomFile *)proxy->obj);
 }
 
+- (void) loadRomAsync:(NSURL *)url
+{
+    [self c64]->loader.loadRom([[url path] UTF8String]);
+}
+
+- (void) insertDiskAsync:(NSURL *)url drive:(DriveID)id
+{
+    [self c64]->loader.insertDisk([[url path] UTF8String], id);
+}
+
+- (void) attachCartridgeAsync:(NSURL *)url reset:(BOOL)reset
+{
+    [self c64]->loader.attachCartridge([[url path] UTF8String], reset);
+}
+
+- (NSInteger) waitForMedia
+{
+    return [self c64]->loader.wait();
+}
+
 - (void) saveRom:(RomType)type url:(NSURL *)url error:(ErrorCode *)err
 {
     [self c64]->saveRom(type, [[url path] UTF8String], err);
@@ -2195,6 +2541,21 @@
     [self c64]->deleteRom(type);
 }
 
+- (BOOL) recording
+{
+    return [self c64]->recorder.isRecording();
+}
+
+- (void) startRecording:(NSURL *)url error:(ErrorCode *)err
+{
+    [self c64]->startRecording([[url path] UTF8String], err);
+}
+
+- (void) stopRecording
+{
+    [self c64]->stopRecording();
+}
+
 - (RomIdentifier) romIdentifier:(RomType)type
 {
     return [self c64]->romIdentifier(type);
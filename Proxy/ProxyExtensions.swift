@@ -77,6 +77,23 @@ extension C64Proxy {
         saveRom(type, url: url, error: &err)
         if err != .OK { throw VC64Error(err) }        
     }
+    
+    func startRecording(url: URL) throws {
+        
+        var err = ErrorCode.OK
+        startRecording(url, error: &err)
+        if err != .OK { throw VC64Error(err) }
+    }
+}
+
+extension GuardsProxy {
+    
+    func setCondition(_ nr: Int, expression: String) throws {
+        
+        var err = ErrorCode.OK
+        setCondition(nr, expression: expression, error: &err)
+        if err != .OK { throw VC64Error(err) }
+    }
 }
 
 extension AnyFileProxy {